@@ -497,8 +497,12 @@ LOCAL_SRC_FILES := \
   src/ndn-cpp/src/encrypt/algo/rsa-algorithm.cpp \
   src/ndn-cpp/src/impl/delayed-call-table.cpp \
   src/ndn-cpp/src/impl/interest-filter-table.cpp \
+  src/ndn-cpp/src/impl/mapped-content-store.cpp \
   src/ndn-cpp/src/impl/pending-interest-table.cpp \
   src/ndn-cpp/src/impl/registered-prefix-table.cpp \
+  src/ndn-cpp/src/impl/rtt-estimator-table.cpp \
+  src/ndn-cpp/src/in-memory-storage/in-memory-storage-bounded.cpp \
+  src/ndn-cpp/src/in-memory-storage/in-memory-storage-lfu.cpp \
   src/ndn-cpp/src/in-memory-storage/in-memory-storage-retaining.cpp \
   src/ndn-cpp/src/lite/control-parameters-lite.cpp \
   src/ndn-cpp/src/lite/control-response-lite.cpp \
@@ -611,10 +615,14 @@ LOCAL_SRC_FILES := \
   src/ndn-cpp/src/util/command-interest-generator.cpp \
   src/ndn-cpp/src/util/config-file.cpp \
   src/ndn-cpp/src/util/dynamic-uint8-vector.cpp \
+  src/ndn-cpp/src/util/eviction-policy.cpp \
   src/ndn-cpp/src/util/exponential-re-express.cpp \
   src/ndn-cpp/src/util/logging.cpp \
   src/ndn-cpp/src/util/memory-content-cache.cpp \
+  src/ndn-cpp/src/util/persistent-content-cache.cpp \
+  src/ndn-cpp/src/util/rtt-estimator.cpp \
   src/ndn-cpp/src/util/segment-fetcher.cpp \
+  src/ndn-cpp/src/util/segmenter.cpp \
   src/ndn-cpp/src/util/sqlite3-statement.cpp \
   src/ndn-cpp/src/util/regex/ndn-regex-backref-manager.cpp \
   src/ndn-cpp/src/util/regex/ndn-regex-backref-matcher.cpp \
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+/**
+ * This measures the DigestTree used by ChronoSync2013 as the number of
+ * participants grows. For each participant count it times adding the
+ * participants, then times sequence number updates of random participants,
+ * where each update recomputes the root digest. The DigestTree is an internal
+ * class, so this includes its header from the source tree.
+ */
+
+#include <iostream>
+#include <vector>
+#include <sstream>
+#include <sys/time.h>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "../src/sync/digest-tree.hpp"
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Time adding nParticipants to a DigestTree and updating their sequence
+ * numbers.
+ * @param nParticipants The number of participants.
+ * @param rootDigestMode The DigestTree::RootDigestMode.
+ */
+static void
+benchmark(int nParticipants, DigestTree::RootDigestMode rootDigestMode)
+{
+  vector<string> dataPrefixes;
+  for (int i = 0; i < nParticipants; ++i) {
+    ostringstream dataPrefix;
+    dataPrefix << "/ndn/edu/ucla/remap/ndnchat/user" << i;
+    dataPrefixes.push_back(dataPrefix.str());
+  }
+
+  DigestTree digestTree;
+  digestTree.setRootDigestMode(rootDigestMode);
+
+  double start = getNowSeconds();
+  for (int i = 0; i < nParticipants; ++i)
+    digestTree.update(dataPrefixes[i], 1, 0);
+  double addSeconds = getNowSeconds() - start;
+
+  // Each participant publishes several times in a random order.
+  vector<int> sequenceNos(nParticipants, 0);
+  int nUpdates = 20000;
+  vector<int> participants(nUpdates);
+  for (int i = 0; i < nUpdates; ++i) {
+    float random1;
+    CryptoLite::generateRandomFloat(random1);
+    participants[i] = (int)(random1 * nParticipants) % nParticipants;
+  }
+
+  start = getNowSeconds();
+  for (int i = 0; i < nUpdates; ++i) {
+    int participant = participants[i];
+    digestTree.update
+      (dataPrefixes[participant], 1, ++sequenceNos[participant]);
+  }
+  double updateSeconds = getNowSeconds() - start;
+
+  cout << "Participants " << nParticipants << (rootDigestMode ==
+    DigestTree::ROOT_DIGEST_MERKLE ? " (Merkle)" : " (ChronoSync)") <<
+    ": add/sec " << (nParticipants / addSeconds) << ", update/sec " <<
+    (nUpdates / updateSeconds) << endl;
+}
+
+int
+main(int argc, char** argv)
+{
+  int participantCounts[] = { 10, 100, 1000, 2000, 10000 };
+  for (size_t i = 0; i < sizeof(participantCounts) / sizeof(participantCounts[0]);
+       ++i) {
+    benchmark(participantCounts[i], DigestTree::ROOT_DIGEST_CHRONOSYNC);
+    benchmark(participantCounts[i], DigestTree::ROOT_DIGEST_MERKLE);
+  }
+
+  return 0;
+}
@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures the round-trip latency of expressInterest through a Face
+ * connected to an in-process stand-in forwarder which immediately answers each
+ * Interest with a Data packet. It compares the usual event loop of
+ * processEvents() plus sleep with the blocking processEvents(maxWaitMilliseconds).
+ * It also measures how quickly Transport::wakeUp from another thread interrupts
+ * a blocked processEvents(maxWaitMilliseconds).
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <ndn-cpp/face.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/transport/unix-transport.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Read the TLV type and length at the front of buffer.
+ * @param buffer The received bytes.
+ * @param elementLength Set this to the length of the whole TLV element.
+ * @return True if the header is complete, false if more bytes are needed.
+ */
+static bool
+getElementLength(const vector<uint8_t>& buffer, size_t& elementLength)
+{
+  // Assume a one-byte type, which is true for Interest packets.
+  if (buffer.size() < 2)
+    return false;
+
+  size_t length;
+  size_t headerLength;
+  if (buffer[1] < 253) {
+    length = buffer[1];
+    headerLength = 2;
+  }
+  else if (buffer[1] == 253) {
+    if (buffer.size() < 4)
+      return false;
+    length = ((size_t)buffer[2] << 8) + buffer[3];
+    headerLength = 4;
+  }
+  else {
+    if (buffer.size() < 6)
+      return false;
+    length = ((size_t)buffer[2] << 24) + ((size_t)buffer[3] << 16) +
+      ((size_t)buffer[4] << 8) + buffer[5];
+    headerLength = 6;
+  }
+
+  elementLength = headerLength + length;
+  return true;
+}
+
+/**
+ * Accept one connection on the listen socket and answer each received Interest
+ * with a Data packet of the same name, until the connection is closed.
+ * @param listenSocketPointer A pointer to the int listen socket.
+ */
+static void*
+runForwarder(void* listenSocketPointer)
+{
+  int socketDescriptor = accept(*(int*)listenSocketPointer, 0, 0);
+  if (socketDescriptor < 0)
+    return 0;
+
+  vector<uint8_t> buffer;
+  uint8_t receiveBuffer[Face::getMaxNdnPacketSize()];
+  const char* content = "Hello";
+  while (true) {
+    ssize_t nBytes = recv(socketDescriptor, receiveBuffer, sizeof(receiveBuffer), 0);
+    if (nBytes <= 0)
+      break;
+    buffer.insert(buffer.end(), receiveBuffer, receiveBuffer + nBytes);
+
+    size_t elementLength;
+    while (getElementLength(buffer, elementLength) &&
+           buffer.size() >= elementLength) {
+      // 5 is the TLV type code for Interest.
+      if (buffer[0] == 5) {
+        Interest interest;
+        interest.wireDecode(&buffer[0], elementLength);
+
+        Data data(interest.getName());
+        data.setContent((const uint8_t*)content, strlen(content));
+        data.setSignature(DigestSha256Signature());
+        Blob encoding = data.wireEncode();
+        if (send(socketDescriptor, encoding.buf(), encoding.size(), 0) < 0)
+          break;
+      }
+
+      buffer.erase(buffer.begin(), buffer.begin() + elementLength);
+    }
+  }
+
+  close(socketDescriptor);
+  return 0;
+}
+
+static void
+onData
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<Data>& data, int* callbackCount)
+{
+  ++(*callbackCount);
+}
+
+static void
+onTimeout(const ptr_lib::shared_ptr<const Interest>& interest, int* callbackCount)
+{
+  ++(*callbackCount);
+  cout << "Time out for interest " << interest->getName().toUri() << endl;
+}
+
+/**
+ * Loop to express an Interest and wait for the Data, nRoundTrips times.
+ * @param face The Face connected to the stand-in forwarder.
+ * @param nRoundTrips The number of round trips.
+ * @param maxWaitMilliseconds If negative, use processEvents() and sleep 10
+ * milliseconds. Otherwise use processEvents(maxWaitMilliseconds).
+ * @return The number of seconds for all round trips.
+ */
+static double
+benchmarkRoundTripSeconds
+  (Face& face, int nRoundTrips, Milliseconds maxWaitMilliseconds)
+{
+  double start = getNowSeconds();
+  for (int i = 0; i < nRoundTrips; ++i) {
+    int callbackCount = 0;
+    face.expressInterest
+      (Name("/test/latency").appendSequenceNumber(i),
+       bind(&onData, _1, _2, &callbackCount),
+       bind(&onTimeout, _1, &callbackCount));
+
+    while (callbackCount < 1) {
+      if (maxWaitMilliseconds < 0) {
+        face.processEvents();
+        // We need to sleep for a few milliseconds so we don't use 100% of the CPU.
+        usleep(10000);
+      }
+      else
+        face.processEvents(maxWaitMilliseconds);
+    }
+  }
+  double finish = getNowSeconds();
+
+  return finish - start;
+}
+
+class WakeUpInfo {
+public:
+  WakeUpInfo(const ptr_lib::shared_ptr<Transport>& transport)
+  : transport_(transport), wakeUpTime_(0)
+  {
+  }
+
+  ptr_lib::shared_ptr<Transport> transport_;
+  double wakeUpTime_;
+};
+
+/**
+ * Wait for the main thread to block in processEvents, then call wakeUp on the
+ * transport.
+ * @param infoPointer A pointer to the WakeUpInfo.
+ */
+static void*
+runWakeUp(void* infoPointer)
+{
+  WakeUpInfo* info = (WakeUpInfo*)infoPointer;
+  usleep(5000);
+  info->wakeUpTime_ = getNowSeconds();
+  info->transport_->wakeUp();
+  return 0;
+}
+
+/**
+ * Block in processEvents with a long maximum wait while another thread calls
+ * wakeUp on the transport, nIterations times.
+ * @param face The Face.
+ * @param transport The Face's transport.
+ * @param nIterations The number of iterations.
+ * @return The average seconds from the call to wakeUp until processEvents
+ * returns.
+ */
+static double
+benchmarkWakeUpSeconds
+  (Face& face, const ptr_lib::shared_ptr<Transport>& transport, int nIterations)
+{
+  double totalSeconds = 0;
+  for (int i = 0; i < nIterations; ++i) {
+    WakeUpInfo info(transport);
+    pthread_t thread;
+    pthread_create(&thread, 0, &runWakeUp, &info);
+    face.processEvents(10000);
+    double returnTime = getNowSeconds();
+    pthread_join(thread, 0);
+
+    totalSeconds += returnTime - info.wakeUpTime_;
+  }
+
+  return totalSeconds / nIterations;
+}
+
+int
+main(int argc, char** argv)
+{
+  char socketFilePath[100];
+  sprintf(socketFilePath, "/tmp/test-face-latency-benchmark-%d.sock", (int)getpid());
+  unlink(socketFilePath);
+
+  int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socketFilePath);
+  if (listenSocket < 0 ||
+      bind(listenSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(listenSocket, 1) != 0) {
+    cout << "Error creating the stand-in forwarder socket " << socketFilePath << endl;
+    return 1;
+  }
+
+  pthread_t forwarderThread;
+  pthread_create(&forwarderThread, 0, &runForwarder, &listenSocket);
+
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    ptr_lib::shared_ptr<Transport> transport(new UnixTransport());
+    Face face
+      (transport,
+       ptr_lib::make_shared<UnixTransport::ConnectionInfo>(socketFilePath));
+
+    {
+      int nRoundTrips = 200;
+      double duration = benchmarkRoundTripSeconds(face, nRoundTrips, -1);
+      cout << "Round trip, processEvents() and sleep 10 ms: Duration sec, Hz, average ms: "
+           << duration << ", " << (nRoundTrips / duration) << ", "
+           << (1000.0 * duration / nRoundTrips) << endl;
+    }
+    {
+      int nRoundTrips = 20000;
+      double duration = benchmarkRoundTripSeconds(face, nRoundTrips, 1000);
+      cout << "Round trip, processEvents(1000):             Duration sec, Hz, average ms: "
+           << duration << ", " << (nRoundTrips / duration) << ", "
+           << (1000.0 * duration / nRoundTrips) << endl;
+    }
+    {
+      double seconds = benchmarkWakeUpSeconds(face, transport, 100);
+      cout << "wakeUp from another thread to processEvents return, average ms: "
+           << (1000.0 * seconds) << endl;
+    }
+
+    face.shutdown();
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  pthread_join(forwarderThread, 0);
+  close(listenSocket);
+  unlink(socketFilePath);
+  return 0;
+}
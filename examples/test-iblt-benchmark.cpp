@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+/**
+ * This measures the InvertibleBloomLookupTable used by FullPSync2017 as the
+ * number of entries grows from 1k to 1M. For each size it times inserting the
+ * entries, taking the difference of two tables, and listing the entries of a
+ * difference where half of the table capacity differs. It also compares the
+ * zlib and sparse encodings of a full table and of a table with 1% of its
+ * capacity used. The IBLT is an internal
+ * class, so this includes its header from the source tree.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_LIBZ 1.
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_LIBZ
+
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "../src/sync/detail/invertible-bloom-lookup-table.hpp"
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Get the hash of the key, the same as the hash of a name in FullPSync2017.
+ */
+static uint32_t
+getKey(uint32_t i)
+{
+  return CryptoLite::murmurHash3(InvertibleBloomLookupTable::N_HASHCHECK, i);
+}
+
+/**
+ * Time encode and encodeSparse of the IBLT, and a cached encode.
+ * @param label The label to print.
+ * @param iblt The IBLT to encode, which must not have a cached encoding.
+ */
+static void
+benchmarkEncode(const char* label, const InvertibleBloomLookupTable& iblt)
+{
+  double start = getNowSeconds();
+  size_t zlibSize = iblt.encode().size();
+  double zlibSeconds = getNowSeconds() - start;
+
+  start = getNowSeconds();
+  size_t sparseSize = iblt.encodeSparse().size();
+  double sparseSeconds = getNowSeconds() - start;
+
+  start = getNowSeconds();
+  iblt.encode();
+  double cachedSeconds = getNowSeconds() - start;
+
+  cout << label << "encode: zlib ms " << (zlibSeconds * 1000) << " (" <<
+    zlibSize << " bytes), sparse ms " << (sparseSeconds * 1000) << " (" <<
+    sparseSize << " bytes), cached ms " << (cachedSeconds * 1000) << endl;
+}
+
+/**
+ * Time insert, difference and listEntries for tables with capacity nEntries.
+ * @param nEntries The expected number of entries.
+ */
+static void
+benchmark(size_t nEntries)
+{
+  // The own table has all the entries. The received table is missing the
+  // first quarter and has a quarter of other entries, so the difference has
+  // nEntries / 2 entries to list.
+  InvertibleBloomLookupTable ownIblt(nEntries);
+  InvertibleBloomLookupTable receivedIblt(nEntries);
+  size_t nDifferent = nEntries / 4;
+
+  double start = getNowSeconds();
+  for (size_t i = 0; i < nEntries; ++i)
+    ownIblt.insert(getKey(i));
+  double insertSeconds = getNowSeconds() - start;
+
+  for (size_t i = nDifferent; i < nEntries + nDifferent; ++i)
+    receivedIblt.insert(getKey(i));
+
+  int nDifferenceIterations = nEntries >= 100000 ? 10 : 100;
+  ptr_lib::shared_ptr<InvertibleBloomLookupTable> difference;
+  start = getNowSeconds();
+  for (int i = 0; i < nDifferenceIterations; ++i)
+    difference = ownIblt.difference(receivedIblt);
+  double differenceSeconds = (getNowSeconds() - start) / nDifferenceIterations;
+
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
+  start = getNowSeconds();
+  bool success = difference->listEntries(positive, negative);
+  double listSeconds = getNowSeconds() - start;
+
+  cout << "Entries " << nEntries << ": insert/sec " <<
+    (nEntries / insertSeconds) << ", difference ms " <<
+    (differenceSeconds * 1000) << ", listEntries ms " << (listSeconds * 1000) <<
+    " (" << positive.size() << " positive, " << negative.size() <<
+    " negative" << (success ? "" : ", failed") << ")" << endl;
+
+  InvertibleBloomLookupTable sparseIblt(nEntries);
+  for (size_t i = 0; i < nEntries / 100; ++i)
+    sparseIblt.insert(getKey(i));
+
+  benchmarkEncode("  full table  ", ownIblt);
+  benchmarkEncode("  1% of table ", sparseIblt);
+}
+
+int
+main(int argc, char** argv)
+{
+  for (size_t nEntries = 1000; nEntries <= 1000000; nEntries *= 10)
+    benchmark(nEntries);
+
+  return 0;
+}
+
+#else // NDN_CPP_HAVE_LIBZ
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  cout <<
+    "This program uses zlib but it is not installed. Install it and ./configure again." << endl;
+}
+
+#endif // NDN_CPP_HAVE_LIBZ
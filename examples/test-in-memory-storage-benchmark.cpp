@@ -0,0 +1,188 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This compares the memory and lookup time of InMemoryStorageRetaining with
+ * the bounded InMemoryStorageFifo, InMemoryStorageLru and InMemoryStorageLfu.
+ * For each storage, it inserts twice as many Data packets as the limit of the
+ * bounded storages, then times Interests for an exact name and Interests for a
+ * prefix with CanBePrefix and MustBeFresh. The memory in use is from the glibc
+ * malloc statistics, so it is not available on other platforms.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/time.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-retaining.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-fifo.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-lru.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-lfu.hpp>
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Get the number of bytes allocated by malloc which are in use.
+ * @return The number of bytes, or -1 if not available.
+ */
+static long
+getAllocatedBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return (long)mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+  return (long)mallinfo().uordblks;
+#else
+  return -1;
+#endif
+}
+
+static Name
+makeName(int i)
+{
+  // Use a few streams so that a prefix has many children.
+  const int nStreams = 10;
+  return Name("/test/video").appendSequenceNumber(i % nStreams)
+    .appendSegment(i / nStreams);
+}
+
+/**
+ * Insert the Data packets, then find the Interests and print the results.
+ * @param label The label to print for the storage.
+ * @param storage The storage, which should be empty.
+ * @param nPackets The number of packets to insert.
+ * @param exactInterests The Interests without CanBePrefix to find.
+ * @param prefixInterests The Interests with CanBePrefix and MustBeFresh to find.
+ */
+static void
+benchmarkStorage
+  (const char* label, InMemoryStorage* storage, int nPackets,
+   const vector<Interest>& exactInterests,
+   const vector<Interest>& prefixInterests)
+{
+  const char* content = "0123456789012345678901234567890123456789";
+
+  long allocatedBefore = getAllocatedBytes();
+  double start = getNowSeconds();
+  for (int i = 0; i < nPackets; ++i) {
+    Data data(makeName(i));
+    data.setContent((const uint8_t*)content, strlen(content));
+    data.getMetaInfo().setFreshnessPeriod(60000);
+    data.setSignature(DigestSha256Signature());
+    storage->insert(data);
+  }
+  double insertSeconds = getNowSeconds() - start;
+  long allocatedBytes = getAllocatedBytes() - allocatedBefore;
+
+  int nFound = 0;
+  start = getNowSeconds();
+  for (size_t i = 0; i < exactInterests.size(); ++i) {
+    if (storage->find(exactInterests[i]))
+      ++nFound;
+  }
+  double exactSeconds = getNowSeconds() - start;
+
+  start = getNowSeconds();
+  for (size_t i = 0; i < prefixInterests.size(); ++i) {
+    if (storage->find(prefixInterests[i]))
+      ++nFound;
+  }
+  double prefixSeconds = getNowSeconds() - start;
+
+  cout << label << " packets " << storage->size() << ", found " << nFound
+       << ", insert us " << (insertSeconds * 1e6 / nPackets)
+       << ", KB in use " << (allocatedBytes / 1024)
+       << ", exact find us " << (exactSeconds * 1e6 / exactInterests.size())
+       << ", prefix find us " << (prefixSeconds * 1e6 / prefixInterests.size())
+       << endl;
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    const int nInterests = 1000;
+    int limits[] = { 1000, 10000, 100000 };
+    for (size_t iLimit = 0; iLimit < sizeof(limits) / sizeof(limits[0]);
+         ++iLimit) {
+      int limit = limits[iLimit];
+      int nPackets = 2 * limit;
+
+      // Ask for the packets which the bounded storages can still have.
+      vector<Interest> exactInterests;
+      vector<Interest> prefixInterests;
+      for (int i = 0; i < nInterests; ++i) {
+        Interest exactInterest(makeName(nPackets - 1 - rand() % limit));
+        exactInterest.setCanBePrefix(false);
+        exactInterests.push_back(exactInterest);
+
+        Interest prefixInterest(makeName(nPackets - 1 - rand() % limit));
+        prefixInterest.setName(prefixInterest.getName().getPrefix(-1));
+        prefixInterest.setCanBePrefix(true);
+        prefixInterest.setMustBeFresh(true);
+        prefixInterests.push_back(prefixInterest);
+      }
+
+      cout << "Limit " << limit << ", inserting " << nPackets << " packets:"
+           << endl;
+      {
+        InMemoryStorageRetaining storage;
+        benchmarkStorage
+          ("  Retaining:", &storage, nPackets, exactInterests, prefixInterests);
+      }
+      {
+        InMemoryStorageFifo storage(limit);
+        benchmarkStorage
+          ("  FIFO:     ", &storage, nPackets, exactInterests, prefixInterests);
+      }
+      {
+        InMemoryStorageLru storage(limit);
+        benchmarkStorage
+          ("  LRU:      ", &storage, nPackets, exactInterests, prefixInterests);
+      }
+      {
+        InMemoryStorageLfu storage(limit);
+        benchmarkStorage
+          ("  LFU:      ", &storage, nPackets, exactInterests, prefixInterests);
+      }
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures how MemoryContentCache scales with the number of Data packets
+ * in the cache. For each cache size, it times Interests for an exact name and
+ * Interests for a prefix with the rightmost ChildSelector. Then it compares
+ * the hit ratio of the eviction policies with a byte limit and a skewed
+ * workload, and times adding Data packets which satisfy pending interests, as
+ * for a live stream. The face does not connect. It only captures the onInterest
+ * callback and counts the replies.
+ */
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <sys/time.h>
+#include <ndn-cpp/face.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/util/memory-content-cache.hpp>
+#include <ndn-cpp/util/eviction-policy.hpp>
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * BenchmarkFace extends Face to capture the onInterest callback from
+ * setInterestFilter and to count the packets sent instead of sending them.
+ */
+class BenchmarkFace : public Face {
+public:
+  BenchmarkFace()
+  : Face("localhost"), nSent_(0)
+  {
+  }
+
+  virtual uint64_t
+  setInterestFilter(const Name& prefix, const OnInterestCallback& onInterest)
+  {
+    prefix_ = ptr_lib::make_shared<Name>(prefix);
+    onInterest_ = onInterest;
+    return 0;
+  }
+
+  virtual void
+  send(const uint8_t *encoding, size_t encodingLength)
+  {
+    ++nSent_;
+  }
+
+  /**
+   * Call the captured onInterest callback as if the Interest was received.
+   */
+  void
+  receive(const ptr_lib::shared_ptr<const Interest>& interest)
+  {
+    onInterest_
+      (prefix_, interest, *this, 0, ptr_lib::shared_ptr<const InterestFilter>());
+  }
+
+  int nSent_;
+
+private:
+  ptr_lib::shared_ptr<const Name> prefix_;
+  OnInterestCallback onInterest_;
+};
+
+/**
+ * Receive the Interests and return the number of seconds.
+ */
+static double
+benchmarkReceiveSeconds
+  (BenchmarkFace& face,
+   const vector<ptr_lib::shared_ptr<const Interest> >& interests)
+{
+  double start = getNowSeconds();
+  for (size_t i = 0; i < interests.size(); ++i)
+    face.receive(interests[i]);
+  double finish = getNowSeconds();
+
+  return finish - start;
+}
+
+static Data
+makeData(int i)
+{
+  const char* content = "0123456789012345678901234567890123456789";
+  Data data(Name("/test/video").appendSegment(i));
+  data.setContent((const uint8_t*)content, strlen(content));
+  data.setSignature(DigestSha256Signature());
+  return data;
+}
+
+/**
+ * Express Interests for names chosen with a Zipf distribution. On a cache
+ * miss, add the Data packet as a producer would.
+ * @param evictionPolicy The eviction policy for the cache.
+ * @param nNames The number of different names.
+ * @param maxPackets Set the byte limit of the cache to hold this many packets.
+ * @param nInterests The number of Interests.
+ * @return The hit ratio.
+ */
+static double
+benchmarkHitRatio
+  (const ptr_lib::shared_ptr<MemoryContentCache::EvictionPolicy>& evictionPolicy,
+   int nNames, int maxPackets, int nInterests)
+{
+  // Make the cumulative Zipf distribution with exponent 0.9 .
+  vector<double> cumulative(nNames);
+  double sum = 0;
+  for (int i = 0; i < nNames; ++i) {
+    sum += 1.0 / pow(i + 1.0, 0.9);
+    cumulative[i] = sum;
+  }
+
+  BenchmarkFace face;
+  MemoryContentCache cache(&face);
+  cache.setInterestFilter(Name("/test/video"));
+  cache.setEvictionPolicy(evictionPolicy);
+  cache.setMaxCacheBytes(maxPackets * makeData(0).wireEncode().size());
+
+  srand(1);
+  for (int i = 0; i < nInterests; ++i) {
+    double x = sum * rand() / RAND_MAX;
+    int iName = (int)(lower_bound(cumulative.begin(), cumulative.end(), x) -
+                      cumulative.begin());
+    if (iName >= nNames)
+      iName = nNames - 1;
+
+    int nSent = face.nSent_;
+    face.receive(ptr_lib::make_shared<Interest>
+      (Name("/test/video").appendSegment(iName)));
+    if (face.nSent_ == nSent)
+      cache.add(makeData(iName));
+  }
+
+  return (double)cache.getHitCount() /
+    (cache.getHitCount() + cache.getMissCount());
+}
+
+/**
+ * Store nPending pending interests for the next segments of a live stream,
+ * then add the Data packet for each.
+ * @param nPending The number of pending interests.
+ * @return The number of seconds to add the Data packets.
+ */
+static double
+benchmarkPendingInterestsSeconds(int nPending)
+{
+  BenchmarkFace face;
+  MemoryContentCache cache(&face);
+  cache.setInterestFilter(Name("/test/video"));
+
+  for (int i = 0; i < nPending; ++i) {
+    ptr_lib::shared_ptr<Interest> interest
+      (new Interest(makeData(i).getName()));
+    interest->setInterestLifetimeMilliseconds(60000);
+    cache.storePendingInterest(interest, face);
+  }
+
+  vector<Data> dataList;
+  for (int i = 0; i < nPending; ++i)
+    dataList.push_back(makeData(i));
+
+  double start = getNowSeconds();
+  for (int i = 0; i < nPending; ++i)
+    cache.add(dataList[i]);
+  double finish = getNowSeconds();
+
+  if (face.nSent_ != nPending)
+    cout << "ERROR: Not all pending interests were satisfied" << endl;
+  return finish - start;
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    const int nExactInterests = 1000;
+    const int nRightmostInterests = 100;
+    const char* content = "0123456789012345678901234567890123456789";
+    int cacheSizes[] = { 1000, 10000, 100000, 500000 };
+    for (size_t iSize = 0; iSize < sizeof(cacheSizes) / sizeof(cacheSizes[0]);
+         ++iSize) {
+      int cacheSize = cacheSizes[iSize];
+      BenchmarkFace face;
+      MemoryContentCache cache(&face);
+      Name prefix("/test/video");
+      cache.setInterestFilter(prefix);
+
+      // Use a few streams so that a prefix has many children.
+      const int nStreams = 10;
+      for (int i = 0; i < cacheSize; ++i) {
+        Data data(Name(prefix).appendSequenceNumber(i % nStreams)
+                  .appendSegment(i / nStreams));
+        data.setContent((const uint8_t*)content, strlen(content));
+        data.setSignature(DigestSha256Signature());
+        cache.add(data);
+      }
+
+      vector<ptr_lib::shared_ptr<const Interest> > exactInterests;
+      for (int i = 0; i < nExactInterests; ++i) {
+        int iData = rand() % cacheSize;
+        exactInterests.push_back(ptr_lib::make_shared<Interest>
+          (Name(prefix).appendSequenceNumber(iData % nStreams)
+           .appendSegment(iData / nStreams)));
+      }
+      vector<ptr_lib::shared_ptr<const Interest> > rightmostInterests;
+      for (int i = 0; i < nRightmostInterests; ++i) {
+        ptr_lib::shared_ptr<Interest> interest(new Interest
+          (Name(prefix).appendSequenceNumber(i % nStreams)));
+        interest->setChildSelector(1);
+        rightmostInterests.push_back(interest);
+      }
+
+      double exactDuration = benchmarkReceiveSeconds(face, exactInterests);
+      double rightmostDuration = benchmarkReceiveSeconds(face, rightmostInterests);
+      if (face.nSent_ != nExactInterests + nRightmostInterests)
+        cout << "ERROR: Not all Interests were answered" << endl;
+
+      cout << "Cache size " << cacheSize << ": Exact name microseconds per Interest: "
+           << (1000000.0 * exactDuration / nExactInterests) << endl;
+      cout << "Cache size " << cacheSize << ": Rightmost child microseconds per Interest: "
+           << (1000000.0 * rightmostDuration / nRightmostInterests) << endl;
+    }
+
+    const int nNames = 100000;
+    const int maxPackets = 5000;
+    const int nInterests = 1000000;
+    cout << "Hit ratio for " << nNames << " names, Zipf 0.9, cache of "
+         << maxPackets << " packets:" << endl;
+    cout << "  FIFO:      " << benchmarkHitRatio
+      (ptr_lib::make_shared<FifoEvictionPolicy>(), nNames, maxPackets, nInterests)
+      << endl;
+    cout << "  LRU:       " << benchmarkHitRatio
+      (ptr_lib::make_shared<LruEvictionPolicy>(), nNames, maxPackets, nInterests)
+      << endl;
+    cout << "  LFU:       " << benchmarkHitRatio
+      (ptr_lib::make_shared<LfuEvictionPolicy>(), nNames, maxPackets, nInterests)
+      << endl;
+    cout << "  W-TinyLFU: " << benchmarkHitRatio
+      (ptr_lib::make_shared<WTinyLfuEvictionPolicy>(), nNames, maxPackets, nInterests)
+      << endl;
+
+    int pendingCounts[] = { 1000, 10000, 100000 };
+    for (size_t i = 0; i < sizeof(pendingCounts) / sizeof(pendingCounts[0]);
+         ++i) {
+      int nPending = pendingCounts[i];
+      double duration = benchmarkPendingInterestsSeconds(nPending);
+      cout << "Pending interests " << nPending <<
+        ": Add microseconds per Data packet: " <<
+        (1000000.0 * duration / nPending) << endl;
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  return 0;
+}
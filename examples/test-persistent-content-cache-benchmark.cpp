@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This compares PersistentContentCache with MemoryContentCache for a producer
+ * which restarts. For each number of Data packets, it times the startup, which
+ * for MemoryContentCache is adding all the packets again and for
+ * PersistentContentCache is opening the files which were written before the
+ * restart. Then it times Interests for an exact name and Interests for a
+ * prefix with the rightmost ChildSelector. The face does not connect. It only
+ * captures the onInterest callback and counts the replies.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_UNISTD_H.
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <ndn-cpp/face.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/util/memory-content-cache.hpp>
+#include <ndn-cpp/util/persistent-content-cache.hpp>
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * BenchmarkFace extends Face to capture the onInterest callback from
+ * setInterestFilter and to count the packets sent instead of sending them.
+ */
+class BenchmarkFace : public Face {
+public:
+  BenchmarkFace()
+  : Face("localhost"), nSent_(0)
+  {
+  }
+
+  virtual uint64_t
+  setInterestFilter(const Name& prefix, const OnInterestCallback& onInterest)
+  {
+    prefix_ = ptr_lib::make_shared<Name>(prefix);
+    onInterest_ = onInterest;
+    return 0;
+  }
+
+  virtual void
+  send(const uint8_t *encoding, size_t encodingLength)
+  {
+    ++nSent_;
+  }
+
+  /**
+   * Call the captured onInterest callback as if the Interest was received.
+   */
+  void
+  receive(const ptr_lib::shared_ptr<const Interest>& interest)
+  {
+    onInterest_
+      (prefix_, interest, *this, 0, ptr_lib::shared_ptr<const InterestFilter>());
+  }
+
+  int nSent_;
+
+private:
+  ptr_lib::shared_ptr<const Name> prefix_;
+  OnInterestCallback onInterest_;
+};
+
+/**
+ * Receive the Interests and return the number of seconds.
+ */
+static double
+benchmarkReceiveSeconds
+  (BenchmarkFace& face,
+   const vector<ptr_lib::shared_ptr<const Interest> >& interests)
+{
+  double start = getNowSeconds();
+  for (size_t i = 0; i < interests.size(); ++i)
+    face.receive(interests[i]);
+  double finish = getNowSeconds();
+
+  return finish - start;
+}
+
+// Use a few streams so that a prefix has many children.
+static const int nStreams = 10;
+
+static Data
+makeData(int i)
+{
+  const char* content = "0123456789012345678901234567890123456789";
+  Data data(Name("/test/video").appendSequenceNumber(i % nStreams)
+            .appendSegment(i / nStreams));
+  data.setContent((const uint8_t*)content, strlen(content));
+  data.setSignature(DigestSha256Signature());
+  return data;
+}
+
+/**
+ * Remove the files in the directory and the directory.
+ */
+static void
+removeDirectory(const string& directoryPath)
+{
+  DIR* directory = opendir(directoryPath.c_str());
+  if (directory) {
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != 0) {
+      string fileName = entry->d_name;
+      if (fileName != "." && fileName != "..")
+        remove((directoryPath + "/" + fileName).c_str());
+    }
+    closedir(directory);
+  }
+  rmdir(directoryPath.c_str());
+}
+
+/**
+ * Time the Interests for exact names and for prefixes with the rightmost
+ * ChildSelector, and print the results.
+ */
+static void
+printThroughput(const char* label, BenchmarkFace& face, int cacheSize)
+{
+  const int nExactInterests = 100000;
+  const int nRightmostInterests = 1000;
+
+  vector<ptr_lib::shared_ptr<const Interest> > exactInterests;
+  srand(1);
+  for (int i = 0; i < nExactInterests; ++i)
+    exactInterests.push_back(ptr_lib::make_shared<Interest>
+      (makeData(rand() % cacheSize).getName()));
+  vector<ptr_lib::shared_ptr<const Interest> > rightmostInterests;
+  for (int i = 0; i < nRightmostInterests; ++i) {
+    ptr_lib::shared_ptr<Interest> interest(new Interest
+      (Name("/test/video").appendSequenceNumber(i % nStreams)));
+    interest->setChildSelector(1);
+    rightmostInterests.push_back(interest);
+  }
+
+  face.nSent_ = 0;
+  double exactDuration = benchmarkReceiveSeconds(face, exactInterests);
+  double rightmostDuration = benchmarkReceiveSeconds(face, rightmostInterests);
+  if (face.nSent_ != nExactInterests + nRightmostInterests)
+    cout << "ERROR: " << label << " did not answer every Interest" << endl;
+  cout << label << " exact Hz: " << (nExactInterests / exactDuration) <<
+    ", rightmost child Hz: " << (nRightmostInterests / rightmostDuration) <<
+    endl;
+}
+
+int
+main(int argc, char** argv)
+{
+  char directoryPath[] = "/tmp/test-persistent-content-cache-benchmark-XXXXXX";
+  if (!mkdtemp(directoryPath)) {
+    cout << "Error creating the temporary directory" << endl;
+    return 1;
+  }
+
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    int cacheSizes[] = { 10000, 100000, 500000 };
+    for (size_t iSize = 0; iSize < sizeof(cacheSizes) / sizeof(cacheSizes[0]);
+         ++iSize) {
+      int cacheSize = cacheSizes[iSize];
+      cout << "Data packets: " << cacheSize << endl;
+
+      {
+        BenchmarkFace face;
+        double start = getNowSeconds();
+        MemoryContentCache cache(&face);
+        cache.setInterestFilter(Name("/test/video"));
+        for (int i = 0; i < cacheSize; ++i)
+          cache.add(makeData(i));
+        double startupDuration = getNowSeconds() - start;
+
+        cout << "  MemoryContentCache     startup sec: " << startupDuration <<
+          endl;
+        printThroughput("  MemoryContentCache    ", face, cacheSize);
+      }
+
+      string directory = string(directoryPath) + "/store";
+      removeDirectory(directory);
+      mkdir(directory.c_str(), 0755);
+      {
+        // Add the packets before the restart.
+        BenchmarkFace face;
+        PersistentContentCache cache(&face, directory);
+        for (int i = 0; i < cacheSize; ++i)
+          cache.add(makeData(i));
+      }
+
+      {
+        BenchmarkFace face;
+        double start = getNowSeconds();
+        PersistentContentCache cache(&face, directory);
+        cache.setInterestFilter(Name("/test/video"));
+        double startupDuration = getNowSeconds() - start;
+
+        cout << "  PersistentContentCache startup sec: " << startupDuration <<
+          endl;
+        printThroughput("  PersistentContentCache", face, cacheSize);
+      }
+      removeDirectory(directory);
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  removeDirectory(directoryPath);
+  return 0;
+}
+
+#else // NDN_CPP_HAVE_UNISTD_H
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  cout <<
+    "This program uses memory-mapped files but they are not supported on this platform." << endl;
+}
+
+#endif // NDN_CPP_HAVE_UNISTD_H
@@ -0,0 +1,187 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+/**
+ * This measures the throughput of publishName in FullPSync2017 and
+ * FullPSync2017WithUsers with each PSyncProducerBase::NameHashMode. The Face
+ * uses a transport which discards the sent packets, so this does not need a
+ * running NFD.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_LIBZ 1.
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_LIBZ
+
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+#include <ndn-cpp/security/key-chain.hpp>
+#include <ndn-cpp/sync/full-psync2017.hpp>
+#include <ndn-cpp/sync/full-psync2017-with-users.hpp>
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * A NullTransport discards the sent packets and never receives any.
+ */
+class NullTransport : public Transport {
+public:
+  virtual bool
+  isLocal(const Transport::ConnectionInfo& connectionInfo) { return true; }
+
+  virtual bool
+  isAsync() { return false; }
+
+  virtual void
+  connect
+    (const Transport::ConnectionInfo& connectionInfo,
+     ElementListener& elementListener, const OnConnected& onConnected)
+  {
+    if (onConnected)
+      onConnected();
+  }
+
+  virtual void
+  send(const uint8_t *data, size_t dataLength) {}
+
+  virtual void
+  processEvents() {}
+
+  virtual bool
+  getIsConnected() { return true; }
+
+  virtual void
+  close() {}
+};
+
+static void
+onNamesUpdate(const ptr_lib::shared_ptr<vector<Name>>& updates) {}
+
+static void
+onUpdate
+  (const ptr_lib::shared_ptr<vector<ptr_lib::shared_ptr<PSyncMissingDataInfo>>>&
+   updates) {}
+
+/**
+ * Publish nNames different names with FullPSync2017.
+ * @return The number of names published per second.
+ */
+static double
+benchmarkFullPSync
+  (Face& face, KeyChain& keyChain, PSyncProducerBase::NameHashMode nameHashMode,
+   int nNames)
+{
+  FullPSync2017 fullPSync
+    (nNames, face, Name("/sync"), &onNamesUpdate, keyChain);
+  fullPSync.setNameHashMode(nameHashMode);
+
+  // Make the names first so that only publishName is timed.
+  vector<Name> names;
+  for (int i = 0; i < nNames; ++i)
+    names.push_back(Name("/test/user").appendNumber(i % 100).append("data")
+                    .appendSequenceNumber(i));
+
+  double start = getNowSeconds();
+  for (int i = 0; i < nNames; ++i)
+    fullPSync.publishName(names[i]);
+  return nNames / (getNowSeconds() - start);
+}
+
+/**
+ * Add nUsers user prefixes to FullPSync2017WithUsers and publish the next
+ * sequence number of each in turn nPublications times.
+ * @return The number of publications per second.
+ */
+static double
+benchmarkFullPSyncWithUsers
+  (Face& face, KeyChain& keyChain, PSyncProducerBase::NameHashMode nameHashMode,
+   int nUsers, int nPublications)
+{
+  FullPSync2017WithUsers fullPSync
+    (nUsers, face, Name("/sync"), Name("/test/user"), &onUpdate, keyChain);
+  fullPSync.setNameHashMode(nameHashMode);
+
+  vector<Name> prefixes;
+  for (int i = 0; i < nUsers; ++i) {
+    prefixes.push_back(Name("/test/user").appendNumber(i));
+    fullPSync.addUserNode(prefixes.back());
+  }
+
+  double start = getNowSeconds();
+  for (int i = 0; i < nPublications; ++i)
+    fullPSync.publishName(prefixes[i % nUsers]);
+  return nPublications / (getNowSeconds() - start);
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    KeyChain keyChain("pib-memory:", "tpm-memory:");
+    keyChain.createIdentityV2(Name("/test"), EcKeyParams());
+
+    ptr_lib::shared_ptr<Transport> transport(new NullTransport());
+    Face face(transport, ptr_lib::make_shared<Transport::ConnectionInfo>());
+    face.setCommandSigningInfo(keyChain, keyChain.getDefaultCertificateName());
+
+    const char* modeNames[] = { "NAME_HASH_URI", "NAME_HASH_TLV" };
+    PSyncProducerBase::NameHashMode modes[] =
+      { PSyncProducerBase::NAME_HASH_URI, PSyncProducerBase::NAME_HASH_TLV };
+    for (int i = 0; i < 2; ++i) {
+      double fullHz = benchmarkFullPSync(face, keyChain, modes[i], 100000);
+      double withUsersHz = benchmarkFullPSyncWithUsers
+        (face, keyChain, modes[i], 1000, 100000);
+      cout << modeNames[i] << ": FullPSync2017 publishName/sec " << fullHz <<
+        ", FullPSync2017WithUsers publishName/sec " << withUsersHz << endl;
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  return 0;
+}
+
+#else // NDN_CPP_HAVE_LIBZ
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  cout <<
+    "This program uses zlib but it is not installed. Install it and ./configure again." << endl;
+}
+
+#endif // NDN_CPP_HAVE_LIBZ
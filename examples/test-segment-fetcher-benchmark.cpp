@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures the time for SegmentFetcher to fetch content over a simulated
+ * link with a round-trip delay and a bottleneck queue which drops Interests
+ * when it is full. It compares a constant window of one Interest, which is
+ * the same as stop-and-wait, with the default AIMD congestion window. Then it
+ * compares the time to the first byte when concatenating the content for
+ * OnComplete and when streaming the segments with OnSegment.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <unistd.h>
+#include <sys/time.h>
+#include <ndn-cpp/face.hpp>
+#include <ndn-cpp/util/segment-fetcher.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+static double
+getNowMilliseconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec * 1000.0 + t.tv_usec / 1000.0;
+}
+
+/**
+ * LinkFace extends Face to reply to each Interest for a segment after the
+ * round-trip delay plus the time waiting in the bottleneck queue. If the queue
+ * already holds maxQueueLength packets, the Interest is dropped.
+ */
+class LinkFace : public Face {
+public:
+  LinkFace
+    (const Name& versionedPrefix, int nSegments, double delayMilliseconds,
+     double serviceMilliseconds, int maxQueueLength)
+  : Face("localhost"), nInterests_(0), nDropped_(0),
+    delayMilliseconds_(delayMilliseconds),
+    serviceMilliseconds_(serviceMilliseconds), maxQueueLength_(maxQueueLength),
+    lastDepartureTime_(0), lastPendingInterestId_(0)
+  {
+    string content(1000, 'a');
+    for (int i = 0; i < nSegments; ++i) {
+      ptr_lib::shared_ptr<Data> data(new Data
+        (Name(versionedPrefix).appendSegment(i)));
+      data->setContent(Blob::fromRawStr(content));
+      data->getMetaInfo().setFinalBlockId
+        (Name::Component::fromSegment(nSegments - 1));
+      segments_.push_back(data);
+    }
+  }
+
+  virtual uint64_t
+  expressInterest
+    (const Interest& interest, const OnData& onData,
+     const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat())
+  {
+    uint64_t pendingInterestId = ++lastPendingInterestId_;
+    ++nInterests_;
+
+    double now = getNowMilliseconds();
+    double departureTime = max(now, lastDepartureTime_) + serviceMilliseconds_;
+    if ((departureTime - now) / serviceMilliseconds_ > maxQueueLength_) {
+      ++nDropped_;
+      callLater
+        (interest.getInterestLifetimeMilliseconds(),
+         bind(&LinkFace::timeOut, this, pendingInterestId,
+              ptr_lib::make_shared<Interest>(interest), onTimeout));
+      return pendingInterestId;
+    }
+    lastDepartureTime_ = departureTime;
+
+    uint64_t segment = 0;
+    if (interest.getChildSelector() != 1)
+      segment = interest.getName().get(-1).toSegment();
+    callLater
+      (departureTime - now + delayMilliseconds_,
+       bind(&LinkFace::reply, this, pendingInterestId,
+            ptr_lib::make_shared<Interest>(interest), segments_[segment],
+            onData));
+    return pendingInterestId;
+  }
+
+  virtual void
+  removePendingInterest(uint64_t pendingInterestId)
+  {
+    removed_.insert(pendingInterestId);
+  }
+
+  virtual void
+  callLater(Milliseconds delayMilliseconds, const Face::Callback& callback)
+  {
+    events_.insert(multimap<double, Face::Callback>::value_type
+      (getNowMilliseconds() + delayMilliseconds, callback));
+  }
+
+  virtual void
+  processEvents()
+  {
+    double now = getNowMilliseconds();
+    while (!events_.empty() && events_.begin()->first <= now) {
+      Face::Callback callback = events_.begin()->second;
+      events_.erase(events_.begin());
+      callback();
+    }
+  }
+
+  int nInterests_;
+  int nDropped_;
+
+private:
+  void
+  reply
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<Data>& data, const OnData& onData)
+  {
+    if (removed_.count(pendingInterestId) == 0)
+      onData(interest, data);
+  }
+
+  void
+  timeOut
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interest,
+     const OnTimeout& onTimeout)
+  {
+    if (removed_.count(pendingInterestId) == 0)
+      onTimeout(interest);
+  }
+
+  vector<ptr_lib::shared_ptr<Data> > segments_;
+  double delayMilliseconds_;
+  double serviceMilliseconds_;
+  int maxQueueLength_;
+  double lastDepartureTime_;
+  uint64_t lastPendingInterestId_;
+  multimap<double, Face::Callback> events_;
+  set<uint64_t> removed_;
+};
+
+static void
+onComplete(const Blob& content, bool* isFinished)
+{
+  *isFinished = true;
+}
+
+static void
+onError
+  (SegmentFetcher::ErrorCode errorCode, const string& message, bool* isFinished)
+{
+  cout << "Error " << errorCode << ": " << message << endl;
+  *isFinished = true;
+}
+
+static void
+onSegment(uint64_t segment, const Blob& content, double* firstSegmentTime)
+{
+  if (*firstSegmentTime == 0)
+    *firstSegmentTime = getNowMilliseconds();
+}
+
+/**
+ * Fetch nSegments over a LinkFace.
+ * @return The number of milliseconds to fetch all the segments.
+ */
+static double
+benchmarkFetch
+  (int nSegments, double delayMilliseconds,
+   const SegmentFetcher::Options& options, int& nInterests, int& nDropped)
+{
+  Name versionedPrefix = Name("/test/content").appendVersion(1);
+  // The bottleneck sends one packet per 0.2 ms and queues up to 50 packets.
+  LinkFace face(versionedPrefix, nSegments, delayMilliseconds, 0.2, 50);
+  Interest interest(Name("/test/content"));
+  interest.setInterestLifetimeMilliseconds(4000);
+
+  bool isFinished = false;
+  double start = getNowMilliseconds();
+  SegmentFetcher::fetch
+    (face, interest, SegmentFetcher::DontVerifySegment,
+     bind(&onComplete, _1, &isFinished), bind(&onError, _1, _2, &isFinished),
+     options);
+  while (!isFinished) {
+    face.processEvents();
+    usleep(100);
+  }
+  double finish = getNowMilliseconds();
+
+  nInterests = face.nInterests_;
+  nDropped = face.nDropped_;
+  return finish - start;
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    int nSegments = 200;
+    double delays[] = { 5, 20, 50 };
+    for (size_t i = 0; i < sizeof(delays) / sizeof(delays[0]); ++i) {
+      int nInterests, nDropped;
+      double duration = benchmarkFetch
+        (nSegments, delays[i], SegmentFetcher::Options()
+         .setInitialWindowSize(1).setMaxWindowSize(1), nInterests, nDropped);
+      cout << "RTT " << delays[i] << " ms, window 1: Duration ms " << duration <<
+        ", segments/sec " << (nSegments / (duration / 1000)) <<
+        ", Interests " << nInterests << ", dropped " << nDropped << endl;
+
+      duration = benchmarkFetch
+        (nSegments, delays[i], SegmentFetcher::Options(), nInterests, nDropped);
+      cout << "RTT " << delays[i] << " ms, AIMD:     Duration ms " << duration <<
+        ", segments/sec " << (nSegments / (duration / 1000)) <<
+        ", Interests " << nInterests << ", dropped " << nDropped << endl;
+    }
+
+    {
+      // With OnComplete, the first byte arrives with the last segment.
+      int nInterests, nDropped;
+      double duration = benchmarkFetch
+        (nSegments, 20, SegmentFetcher::Options(), nInterests, nDropped);
+      cout << "RTT 20 ms, OnComplete: First byte ms " << duration << endl;
+
+      double firstSegmentTime = 0;
+      double start = getNowMilliseconds();
+      duration = benchmarkFetch
+        (nSegments, 20, SegmentFetcher::Options().setOnSegment
+         (bind(&onSegment, _1, _2, &firstSegmentTime)), nInterests, nDropped);
+      cout << "RTT 20 ms, OnSegment:  First byte ms " <<
+        (firstSegmentTime - start) << ", duration ms " << duration << endl;
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures the number of segments per second that Segmenter makes and
+ * signs for a large object, with an increasing number of signing threads, for
+ * RSA and EC keys, compared with a loop which calls KeyChain::sign for each
+ * segment. The KeyChain uses an in-memory PIB and TPM.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include <sys/time.h>
+#include <ndn-cpp/security/key-params.hpp>
+#include <ndn-cpp/util/segmenter.hpp>
+
+using namespace std;
+using namespace ndn;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Segment and sign the content with the number of threads.
+ * @return The number of seconds.
+ */
+static double
+benchmarkSegmentSeconds
+  (KeyChain& keyChain, const SigningInfo& signingInfo, size_t nThreads,
+   const Blob& content, size_t maxSegmentSize)
+{
+  Segmenter segmenter(keyChain, signingInfo, nThreads);
+  vector<ptr_lib::shared_ptr<Data> > segments;
+
+  double start = getNowSeconds();
+  segmenter.segment
+    (content, Name("/test/content").appendVersion(1), maxSegmentSize, 10000,
+     segments);
+  double finish = getNowSeconds();
+
+  return finish - start;
+}
+
+/**
+ * Make each segment and call KeyChain::sign in a loop.
+ * @return The number of seconds.
+ */
+static double
+benchmarkLoopSeconds
+  (KeyChain& keyChain, const SigningInfo& signingInfo, const Blob& content,
+   size_t maxSegmentSize)
+{
+  Name versionedPrefix = Name("/test/content").appendVersion(1);
+  size_t nSegments = content.size() / maxSegmentSize;
+  vector<ptr_lib::shared_ptr<Data> > segments;
+
+  double start = getNowSeconds();
+  for (size_t i = 0; i < nSegments; ++i) {
+    ptr_lib::shared_ptr<Data> data(new Data
+      (Name(versionedPrefix).appendSegment(i)));
+    data->setContent(Blob(content.buf() + i * maxSegmentSize, maxSegmentSize));
+    data->getMetaInfo().setFinalBlockId
+      (Name::Component::fromSegment(nSegments - 1));
+    data->getMetaInfo().setFreshnessPeriod(10000);
+    keyChain.sign(*data, signingInfo);
+    segments.push_back(data);
+  }
+  double finish = getNowSeconds();
+
+  return finish - start;
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    KeyChain keyChain("pib-memory:", "tpm-memory:");
+    ptr_lib::shared_ptr<PibIdentity> rsaIdentity = keyChain.createIdentityV2
+      (Name("/test/rsa"), RsaKeyParams());
+    ptr_lib::shared_ptr<PibIdentity> ecIdentity = keyChain.createIdentityV2
+      (Name("/test/ec"), EcKeyParams());
+
+    size_t maxSegmentSize = 4000;
+    size_t nSegments = 1000;
+    ptr_lib::shared_ptr<vector<uint8_t> > contentBytes
+      (new vector<uint8_t>(nSegments * maxSegmentSize));
+    for (size_t i = 0; i < contentBytes->size(); ++i)
+      (*contentBytes)[i] = (uint8_t)rand();
+    Blob content(contentBytes, false);
+
+    cout << "Number of processors: " << sysconf(_SC_NPROCESSORS_ONLN) << endl;
+    cout << "Segments: " << nSegments << " of " << maxSegmentSize << " bytes" <<
+      endl;
+    {
+      double duration = benchmarkLoopSeconds
+        (keyChain, SigningInfo(rsaIdentity), content, maxSegmentSize);
+      cout << "RSA, KeyChain::sign loop: Duration sec, segments/sec: " <<
+        duration << ", " << (nSegments / duration) << endl;
+    }
+    for (size_t nThreads = 1; nThreads <= 8; nThreads *= 2) {
+      double duration = benchmarkSegmentSeconds
+        (keyChain, SigningInfo(rsaIdentity), nThreads, content, maxSegmentSize);
+      cout << "RSA, " << nThreads << " threads: Duration sec, segments/sec: " <<
+        duration << ", " << (nSegments / duration) << endl;
+    }
+    {
+      double duration = benchmarkLoopSeconds
+        (keyChain, SigningInfo(ecIdentity), content, maxSegmentSize);
+      cout << "EC,  KeyChain::sign loop: Duration sec, segments/sec: " <<
+        duration << ", " << (nSegments / duration) << endl;
+    }
+    for (size_t nThreads = 1; nThreads <= 8; nThreads *= 2) {
+      double duration = benchmarkSegmentSeconds
+        (keyChain, SigningInfo(ecIdentity), nThreads, content, maxSegmentSize);
+      cout << "EC,  " << nThreads << " threads: Duration sec, segments/sec: " <<
+        duration << ", " << (nSegments / duration) << endl;
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,348 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures the Interest/Data throughput of ThreadsafeFace and of
+ * ShardedThreadsafeFace with an increasing number of shards. The face is
+ * connected to an in-process stand-in forwarder which waits until it has
+ * received all the Interests, then answers each with a Data packet, so that
+ * the pending interest table is full when the Data packets arrive. To run it,
+ * you must install Boost with asio.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include <ndn-cpp/ndn-cpp-config.h>
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <boost/asio.hpp>
+#include <ndn-cpp/sharded-threadsafe-face.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/transport/async-unix-transport.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Read the TLV type and length at the front of buffer.
+ * @param buffer The received bytes.
+ * @param elementLength Set this to the length of the whole TLV element.
+ * @return True if the header is complete, false if more bytes are needed.
+ */
+static bool
+getElementLength(const vector<uint8_t>& buffer, size_t& elementLength)
+{
+  // Assume a one-byte type, which is true for Interest packets.
+  if (buffer.size() < 2)
+    return false;
+
+  size_t length;
+  size_t headerLength;
+  if (buffer[1] < 253) {
+    length = buffer[1];
+    headerLength = 2;
+  }
+  else if (buffer[1] == 253) {
+    if (buffer.size() < 4)
+      return false;
+    length = ((size_t)buffer[2] << 8) + buffer[3];
+    headerLength = 4;
+  }
+  else {
+    if (buffer.size() < 6)
+      return false;
+    length = ((size_t)buffer[2] << 24) + ((size_t)buffer[3] << 16) +
+      ((size_t)buffer[4] << 8) + buffer[5];
+    headerLength = 6;
+  }
+
+  elementLength = headerLength + length;
+  return true;
+}
+
+class ForwarderInfo {
+public:
+  ForwarderInfo(int listenSocket, int nInterests)
+  : listenSocket_(listenSocket), nInterests_(nInterests)
+  {
+  }
+
+  int listenSocket_;
+  int nInterests_;
+};
+
+/**
+ * Accept one connection on the listen socket. When nInterests Interests have
+ * been received, answer each with a Data packet of the same name. Continue
+ * until the connection is closed.
+ * @param infoPointer A pointer to the ForwarderInfo.
+ */
+static void*
+runForwarder(void* infoPointer)
+{
+  ForwarderInfo* info = (ForwarderInfo*)infoPointer;
+  int socketDescriptor = accept(info->listenSocket_, 0, 0);
+  if (socketDescriptor < 0)
+    return 0;
+
+  vector<uint8_t> buffer;
+  vector<Blob> dataEncodings;
+  uint8_t receiveBuffer[Face::getMaxNdnPacketSize()];
+  const char* content = "Hello";
+  while (true) {
+    ssize_t nBytes = recv(socketDescriptor, receiveBuffer, sizeof(receiveBuffer), 0);
+    if (nBytes <= 0)
+      break;
+    buffer.insert(buffer.end(), receiveBuffer, receiveBuffer + nBytes);
+
+    size_t elementLength;
+    while (getElementLength(buffer, elementLength) &&
+           buffer.size() >= elementLength) {
+      // 5 is the TLV type code for Interest.
+      if (buffer[0] == 5) {
+        Interest interest;
+        interest.wireDecode(&buffer[0], elementLength);
+
+        Data data(interest.getName());
+        data.setContent((const uint8_t*)content, strlen(content));
+        data.setSignature(DigestSha256Signature());
+        dataEncodings.push_back(data.wireEncode());
+      }
+
+      buffer.erase(buffer.begin(), buffer.begin() + elementLength);
+    }
+
+    if ((int)dataEncodings.size() >= info->nInterests_) {
+      for (size_t i = 0; i < dataEncodings.size(); ++i) {
+        if (send(socketDescriptor, dataEncodings[i].buf(),
+                 dataEncodings[i].size(), 0) < 0)
+          break;
+      }
+      dataEncodings.clear();
+    }
+  }
+
+  close(socketDescriptor);
+  return 0;
+}
+
+class Counter {
+public:
+  Counter(int maxCount)
+  : count_(0), maxCount_(maxCount)
+  {
+    pthread_mutex_init(&mutex_, 0);
+    pthread_cond_init(&condition_, 0);
+  }
+
+  ~Counter()
+  {
+    pthread_cond_destroy(&condition_);
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  void
+  increment()
+  {
+    pthread_mutex_lock(&mutex_);
+    ++count_;
+    if (count_ >= maxCount_)
+      pthread_cond_signal(&condition_);
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  void
+  waitForMaxCount()
+  {
+    pthread_mutex_lock(&mutex_);
+    while (count_ < maxCount_)
+      pthread_cond_wait(&condition_, &mutex_);
+    pthread_mutex_unlock(&mutex_);
+  }
+
+private:
+  int count_;
+  int maxCount_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t condition_;
+};
+
+// The callbacks for a ShardedThreadsafeFace are called on the shard threads,
+// and Counter is thread safe.
+static void
+onData
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<Data>& data, Counter* counter)
+{
+  counter->increment();
+}
+
+static void
+onTimeout(const ptr_lib::shared_ptr<const Interest>& interest, Counter* counter)
+{
+  cout << "Time out for interest " << interest->getName().toUri() << endl;
+  counter->increment();
+}
+
+static void*
+runIoService(void* ioService)
+{
+  ((boost::asio::io_service*)ioService)->run();
+  return 0;
+}
+
+/**
+ * Express nInterests Interests with different names and wait for all the Data
+ * packets.
+ * @param socketFilePath The Unix socket file path of the stand-in forwarder.
+ * @param listenSocket The listen socket of the stand-in forwarder.
+ * @param nShards If 0, use ThreadsafeFace. Otherwise use ShardedThreadsafeFace
+ * with nShards.
+ * @param nInterests The number of Interests.
+ * @return The number of seconds from the first expressInterest until the last
+ * Data packet is received.
+ */
+static double
+benchmarkThroughputSeconds
+  (const char* socketFilePath, int listenSocket, size_t nShards, int nInterests)
+{
+  ForwarderInfo forwarderInfo(listenSocket, nInterests);
+  pthread_t forwarderThread;
+  pthread_create(&forwarderThread, 0, &runForwarder, &forwarderInfo);
+
+  boost::asio::io_service ioService;
+  boost::asio::io_service::work* work = new boost::asio::io_service::work(ioService);
+  pthread_t ioServiceThread;
+  pthread_create(&ioServiceThread, 0, &runIoService, &ioService);
+
+  ptr_lib::shared_ptr<Transport> transport
+    (new AsyncUnixTransport(ioService));
+  ptr_lib::shared_ptr<Transport::ConnectionInfo> connectionInfo
+    (new AsyncUnixTransport::ConnectionInfo(socketFilePath));
+  ThreadsafeFace* face;
+  if (nShards == 0)
+    face = new ThreadsafeFace(ioService, transport, connectionInfo);
+  else
+    face = new ShardedThreadsafeFace
+      (ioService, transport, connectionInfo, nShards);
+
+  // Use a long lifetime so that the Interests don't time out while the
+  // forwarder waits for all of them.
+  Interest interestTemplate;
+  interestTemplate.setInterestLifetimeMilliseconds(60000);
+  Counter counter(nInterests);
+
+  double start = getNowSeconds();
+  for (int i = 0; i < nInterests; ++i)
+    face->expressInterest
+      (Name("/test").appendSequenceNumber(i), &interestTemplate,
+       bind(&onData, _1, _2, &counter), bind(&onTimeout, _1, &counter),
+       OnNetworkNack());
+  counter.waitForMaxCount();
+  double finish = getNowSeconds();
+
+  face->shutdown();
+  pthread_join(forwarderThread, 0);
+  delete work;
+  ioService.stop();
+  pthread_join(ioServiceThread, 0);
+  delete face;
+
+  return finish - start;
+}
+
+int
+main(int argc, char** argv)
+{
+  char socketFilePath[100];
+  sprintf(socketFilePath, "/tmp/test-sharded-face-benchmark-%d.sock", (int)getpid());
+  unlink(socketFilePath);
+
+  int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socketFilePath);
+  if (listenSocket < 0 ||
+      bind(listenSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(listenSocket, 1) != 0) {
+    cout << "Error creating the stand-in forwarder socket " << socketFilePath << endl;
+    return 1;
+  }
+
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    int nInterests = 5000;
+    cout << "Number of processors: " << sysconf(_SC_NPROCESSORS_ONLN) << endl;
+    {
+      double duration = benchmarkThroughputSeconds
+        (socketFilePath, listenSocket, 0, nInterests);
+      cout << "ThreadsafeFace:                  Duration sec, Hz: "
+           << duration << ", " << (nInterests / duration) << endl;
+    }
+    for (size_t nShards = 1; nShards <= 8; nShards *= 2) {
+      double duration = benchmarkThroughputSeconds
+        (socketFilePath, listenSocket, nShards, nInterests);
+      cout << "ShardedThreadsafeFace, " << nShards << " shards: Duration sec, Hz: "
+           << duration << ", " << (nInterests / duration) << endl;
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  close(listenSocket);
+  unlink(socketFilePath);
+  return 0;
+}
+
+#else // NDN_CPP_HAVE_BOOST_ASIO
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  cout <<
+    "This program uses Boost asio but it is not installed. Install Boost and ./configure again." << endl;
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures the throughput of ThreadsafeFace.putData when called from
+ * 1 to 32 application threads at the same time, which contend to submit the
+ * Data packets to the thread of the io_service. The face is connected to an
+ * in-process stand-in forwarder which counts the received Data packets. To run
+ * it, you must install Boost with asio.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include <ndn-cpp/ndn-cpp-config.h>
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <boost/asio.hpp>
+#include <ndn-cpp/threadsafe-face.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/transport/async-unix-transport.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Read the TLV type and length at the front of buffer.
+ * @param buffer The received bytes.
+ * @param bufferLength The number of bytes in buffer.
+ * @param elementLength Set this to the length of the whole TLV element.
+ * @return True if the header is complete, false if more bytes are needed.
+ */
+static bool
+getElementLength
+  (const uint8_t* buffer, size_t bufferLength, size_t& elementLength)
+{
+  // Assume a one-byte type, which is true for Interest and Data packets.
+  if (bufferLength < 2)
+    return false;
+
+  size_t length;
+  size_t headerLength;
+  if (buffer[1] < 253) {
+    length = buffer[1];
+    headerLength = 2;
+  }
+  else if (buffer[1] == 253) {
+    if (bufferLength < 4)
+      return false;
+    length = ((size_t)buffer[2] << 8) + buffer[3];
+    headerLength = 4;
+  }
+  else {
+    if (bufferLength < 6)
+      return false;
+    length = ((size_t)buffer[2] << 24) + ((size_t)buffer[3] << 16) +
+      ((size_t)buffer[4] << 8) + buffer[5];
+    headerLength = 6;
+  }
+
+  elementLength = headerLength + length;
+  return true;
+}
+
+class ForwarderInfo {
+public:
+  ForwarderInfo(int listenSocket, int nDataPackets)
+  : listenSocket_(listenSocket), nDataPackets_(nDataPackets), finishTime_(0)
+  {
+  }
+
+  int listenSocket_;
+  int nDataPackets_;
+  volatile double finishTime_;
+};
+
+/**
+ * Accept one connection on the listen socket. Answer the first Interest with a
+ * Data packet so that the application knows that it is connected. Then count
+ * the received Data packets until there are nDataPackets, and set finishTime_.
+ * Continue until the connection is closed.
+ * @param infoPointer A pointer to the ForwarderInfo.
+ */
+static void*
+runForwarder(void* infoPointer)
+{
+  ForwarderInfo* info = (ForwarderInfo*)infoPointer;
+  int socketDescriptor = accept(info->listenSocket_, 0, 0);
+  if (socketDescriptor < 0)
+    return 0;
+
+  vector<uint8_t> buffer;
+  uint8_t receiveBuffer[Face::getMaxNdnPacketSize()];
+  int nDataPackets = 0;
+  while (nDataPackets < info->nDataPackets_) {
+    ssize_t nBytes = recv(socketDescriptor, receiveBuffer, sizeof(receiveBuffer), 0);
+    if (nBytes <= 0)
+      break;
+    buffer.insert(buffer.end(), receiveBuffer, receiveBuffer + nBytes);
+
+    size_t elementLength;
+    size_t offset = 0;
+    while (getElementLength
+           (&buffer[0] + offset, buffer.size() - offset, elementLength) &&
+           buffer.size() - offset >= elementLength) {
+      const uint8_t* element = &buffer[0] + offset;
+      // 5 is the TLV type code for Interest. 6 is for Data.
+      if (element[0] == 5) {
+        Interest interest;
+        interest.wireDecode(element, elementLength);
+
+        Data data(interest.getName());
+        data.setSignature(DigestSha256Signature());
+        Blob encoding = data.wireEncode();
+        if (send(socketDescriptor, encoding.buf(), encoding.size(), 0) < 0)
+          break;
+      }
+      else if (element[0] == 6)
+        ++nDataPackets;
+
+      offset += elementLength;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + offset);
+  }
+
+  info->finishTime_ = getNowSeconds();
+  // Wait for the application to close the connection.
+  while (recv(socketDescriptor, receiveBuffer, sizeof(receiveBuffer), 0) > 0);
+  close(socketDescriptor);
+  return 0;
+}
+
+class ProducerInfo {
+public:
+  ProducerInfo(ThreadsafeFace& face, int iProducer, int nDataPackets)
+  : face_(face), iProducer_(iProducer), nDataPackets_(nDataPackets)
+  {
+  }
+
+  ThreadsafeFace& face_;
+  int iProducer_;
+  int nDataPackets_;
+};
+
+/**
+ * Call putData nDataPackets times.
+ * @param infoPointer A pointer to the ProducerInfo.
+ */
+static void*
+runProducer(void* infoPointer)
+{
+  ProducerInfo* info = (ProducerInfo*)infoPointer;
+
+  // Each thread uses its own Data object, which caches its wire encoding.
+  Data data(Name("/test/producer").appendSequenceNumber(info->iProducer_));
+  const char* content = "Hello";
+  data.setContent((const uint8_t*)content, strlen(content));
+  data.setSignature(DigestSha256Signature());
+  data.wireEncode();
+
+  for (int i = 0; i < info->nDataPackets_; ++i)
+    info->face_.putData(data);
+
+  return 0;
+}
+
+static void
+onData
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<Data>& data, bool* isConnected)
+{
+  *isConnected = true;
+}
+
+static void*
+runIoService(void* ioService)
+{
+  ((boost::asio::io_service*)ioService)->run();
+  return 0;
+}
+
+/**
+ * Start nProducers threads which each call putData, and wait for the stand-in
+ * forwarder to receive all the Data packets.
+ * @param socketFilePath The Unix socket file path of the stand-in forwarder.
+ * @param listenSocket The listen socket of the stand-in forwarder.
+ * @param nProducers The number of producer threads.
+ * @param nDataPackets The total number of Data packets to put.
+ * @return The number of seconds from starting the producers until the
+ * forwarder receives the last Data packet.
+ */
+static double
+benchmarkPutDataSeconds
+  (const char* socketFilePath, int listenSocket, int nProducers,
+   int nDataPackets)
+{
+  int nDataPacketsPerProducer = nDataPackets / nProducers;
+  ForwarderInfo forwarderInfo
+    (listenSocket, nDataPacketsPerProducer * nProducers);
+  pthread_t forwarderThread;
+  pthread_create(&forwarderThread, 0, &runForwarder, &forwarderInfo);
+
+  boost::asio::io_service ioService;
+  boost::asio::io_service::work* work = new boost::asio::io_service::work(ioService);
+  pthread_t ioServiceThread;
+  pthread_create(&ioServiceThread, 0, &runIoService, &ioService);
+
+  ThreadsafeFace face
+    (ioService, ptr_lib::make_shared<AsyncUnixTransport>(ioService),
+     ptr_lib::make_shared<AsyncUnixTransport::ConnectionInfo>(socketFilePath));
+
+  // Express an Interest to connect, and wait for the Data.
+  bool isConnected = false;
+  face.expressInterest
+    (Name("/test/connect"), 0, bind(&onData, _1, _2, &isConnected),
+     OnTimeout(), OnNetworkNack());
+  while (!isConnected)
+    usleep(1000);
+
+  vector<ProducerInfo> producerInfos;
+  for (int i = 0; i < nProducers; ++i)
+    producerInfos.push_back(ProducerInfo(face, i, nDataPacketsPerProducer));
+  vector<pthread_t> producerThreads(nProducers);
+
+  double start = getNowSeconds();
+  for (int i = 0; i < nProducers; ++i)
+    pthread_create(&producerThreads[i], 0, &runProducer, &producerInfos[i]);
+  for (int i = 0; i < nProducers; ++i)
+    pthread_join(producerThreads[i], 0);
+  while (forwarderInfo.finishTime_ == 0)
+    usleep(1000);
+
+  face.shutdown();
+  pthread_join(forwarderThread, 0);
+  delete work;
+  pthread_join(ioServiceThread, 0);
+
+  return forwarderInfo.finishTime_ - start;
+}
+
+int
+main(int argc, char** argv)
+{
+  char socketFilePath[100];
+  sprintf(socketFilePath, "/tmp/test-threadsafe-face-contention-benchmark-%d.sock", (int)getpid());
+  unlink(socketFilePath);
+
+  int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socketFilePath);
+  if (listenSocket < 0 ||
+      bind(listenSocket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+      listen(listenSocket, 1) != 0) {
+    cout << "Error creating the stand-in forwarder socket " << socketFilePath << endl;
+    return 1;
+  }
+
+  try {
+    // Silence the warning from Interest wire encode.
+    Interest::setDefaultCanBePrefix(true);
+
+    int nDataPackets = 320000;
+    cout << "Number of processors: " << sysconf(_SC_NPROCESSORS_ONLN) << endl;
+    for (int nProducers = 1; nProducers <= 32; nProducers *= 2) {
+      double duration = benchmarkPutDataSeconds
+        (socketFilePath, listenSocket, nProducers, nDataPackets);
+      cout << "putData, " << nProducers << " producer threads: Duration sec, Hz: "
+           << duration << ", " << (nDataPackets / duration) << endl;
+    }
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  close(listenSocket);
+  unlink(socketFilePath);
+  return 0;
+}
+
+#else // NDN_CPP_HAVE_BOOST_ASIO
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  cout <<
+    "This program uses Boost asio but it is not installed. Install Boost and ./configure again." << endl;
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+/**
+ * This measures the cost of ThreadsafeFace.callLater, which expressInterest
+ * uses for each Interest timeout. On the thread of the io_service, it calls
+ * callLater many times as if for that many outstanding Interests, and reports
+ * the time per call, the increase in resident memory, and how late the last
+ * callback is. To run it, you must install Boost with asio.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include <ndn-cpp/ndn-cpp-config.h>
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <unistd.h>
+#include <sys/time.h>
+#include <boost/asio.hpp>
+#include <ndn-cpp/threadsafe-face.hpp>
+#include <ndn-cpp/transport/async-tcp-transport.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+static double
+getNowSeconds()
+{
+  struct timeval t;
+  gettimeofday(&t, 0);
+  return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Get the resident memory of this process from /proc/self/statm .
+ * @return The resident memory in kilobytes, or -1 if not available.
+ */
+static long
+getResidentKilobytes()
+{
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (!file)
+    return -1;
+
+  long size, resident;
+  int nValues = fscanf(file, "%ld %ld", &size, &resident);
+  fclose(file);
+  if (nValues != 2)
+    return -1;
+
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+class TimerInfo {
+public:
+  TimerInfo(ThreadsafeFace& face, int nCalls, Milliseconds delayMilliseconds)
+  : face_(face), nCalls_(nCalls), delayMilliseconds_(delayMilliseconds),
+    nCallbacks_(0), callLaterSeconds_(0), dueTime_(0), lastCallbackTime_(0),
+    residentIncreaseKilobytes_(0)
+  {
+  }
+
+  ThreadsafeFace& face_;
+  int nCalls_;
+  Milliseconds delayMilliseconds_;
+  int nCallbacks_;
+  double callLaterSeconds_;
+  double dueTime_;
+  double lastCallbackTime_;
+  long residentIncreaseKilobytes_;
+};
+
+static void
+onCallLater(TimerInfo* info)
+{
+  ++info->nCallbacks_;
+  if (info->nCallbacks_ == info->nCalls_) {
+    info->lastCallbackTime_ = getNowSeconds();
+    info->face_.getIoService().stop();
+  }
+}
+
+/**
+ * Call callLater nCalls times. This is called on the thread of the io_service,
+ * the same as Node.expressInterest.
+ */
+static void
+callLaterMany(TimerInfo* info)
+{
+  long residentBefore = getResidentKilobytes();
+  double start = getNowSeconds();
+  for (int i = 0; i < info->nCalls_; ++i)
+    info->face_.callLater
+      (info->delayMilliseconds_, bind(&onCallLater, info));
+  double finish = getNowSeconds();
+
+  info->callLaterSeconds_ = finish - start;
+  // The last call is due at this time.
+  info->dueTime_ = finish + info->delayMilliseconds_ / 1000.0;
+  info->residentIncreaseKilobytes_ = getResidentKilobytes() - residentBefore;
+}
+
+int
+main(int argc, char** argv)
+{
+  try {
+    int nCalls = 100000;
+    if (argc > 1)
+      nCalls = atoi(argv[1]);
+
+    boost::asio::io_service ioService;
+    // The face is not connected since callLater doesn't use the transport.
+    ThreadsafeFace face
+      (ioService, ptr_lib::make_shared<AsyncTcpTransport>(ioService),
+       ptr_lib::make_shared<AsyncTcpTransport::ConnectionInfo>("localhost"));
+
+    TimerInfo info(face, nCalls, 2000);
+    ioService.post(bind(&callLaterMany, &info));
+    ioService.run();
+
+    cout << "callLater " << nCalls << " times: Duration sec, microseconds per call: "
+         << info.callLaterSeconds_ << ", "
+         << (1000000.0 * info.callLaterSeconds_ / nCalls) << endl;
+    cout << "Resident memory increase KB, bytes per call: "
+         << info.residentIncreaseKilobytes_ << ", "
+         << (1024.0 * info.residentIncreaseKilobytes_ / nCalls) << endl;
+    cout << "Last callback after its due time, ms: "
+         << (1000.0 * (info.lastCallbackTime_ - info.dueTime_)) << endl;
+  } catch (std::exception& e) {
+    cout << "exception: " << e.what() << endl;
+  }
+
+  return 0;
+}
+
+#else // NDN_CPP_HAVE_BOOST_ASIO
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+  cout <<
+    "This program uses Boost asio but it is not installed. Install Boost and ./configure again." << endl;
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
@@ -29,6 +29,9 @@ extern "C" {
 
 struct ndn_SocketTransport {
   int socketDescriptor; /**< -1 if not connected */
+  int isDatagram; /**< 1 if the socket is SOCKET_UDP */
+  int wakeUpDescriptors[2]; /**< The read and write ends of the pipe for
+                             * ndn_SocketTransport_wakeUp, or -1 if not open. */
   struct ndn_ElementReader elementReader;
 };
 
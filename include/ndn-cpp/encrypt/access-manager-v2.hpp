@@ -62,11 +62,18 @@ public:
    * @param keyChain The KeyChain used to sign Data packets.
    * @param face The Face for calling registerPrefix that will be used to
    * publish the KEK and KDK Data packets.
+   * @param storage (optional) The InMemoryStorage for the KEK and KDK Data
+   * packets, for example an InMemoryStorageLru to bound the memory used for
+   * many members. (An evicted packet can't be fetched until it is published
+   * again.) If omitted or null, use an InMemoryStorageRetaining which keeps
+   * every packet.
    */
   AccessManagerV2
     (const ptr_lib::shared_ptr<PibIdentity>& identity, const Name& dataset,
-     KeyChain* keyChain, Face* face)
-  : impl_(new Impl(identity, keyChain, face))
+     KeyChain* keyChain, Face* face,
+     const ptr_lib::shared_ptr<InMemoryStorage>& storage =
+       ptr_lib::shared_ptr<InMemoryStorage>())
+  : impl_(new Impl(identity, keyChain, face, storage))
   {
     impl_->initialize(dataset);
   }
@@ -112,8 +119,9 @@ private:
      */
     Impl
       (const ptr_lib::shared_ptr<PibIdentity>& identity, KeyChain* keyChain,
-       Face* face)
-      : identity_(identity), keyChain_(keyChain), face_(face)
+       Face* face, const ptr_lib::shared_ptr<InMemoryStorage>& storage)
+      : identity_(identity), keyChain_(keyChain), face_(face),
+        applicationStorage_(storage)
       {}
 
     /**
@@ -130,19 +138,30 @@ private:
     addMember(const CertificateV2& memberCertificate);
 
     size_t
-    size() { return storage_.size(); }
+    size() { return getStorage().size(); }
 
   private:
     // Give friend access to the tests.
     friend class ::TestAccessManagerV2_EnumerateDataFromInMemoryStorage_Test;
 
+    /**
+     * Get the storage for the KEK and KDKs, which is the storage given to the
+     * constructor, or storage_ if it was null.
+     */
+    InMemoryStorage&
+    getStorage()
+    {
+      return applicationStorage_ ? *applicationStorage_ : storage_;
+    }
+
     ptr_lib::shared_ptr<PibIdentity> identity_;
     ptr_lib::shared_ptr<PibKey> nacKey_;
     KeyChain* keyChain_;
     Face* face_;
 
-    // storage_ is for the KEK and KDKs.
+    // storage_ is for the KEK and KDKs if the application didn't supply one.
     InMemoryStorageRetaining storage_;
+    ptr_lib::shared_ptr<InMemoryStorage> applicationStorage_;
     uint64_t kekRegisteredPrefixId_;
     uint64_t kdkRegisteredPrefixId_;
 
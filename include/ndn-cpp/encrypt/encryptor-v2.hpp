@@ -64,14 +64,20 @@ public:
    * @param validator The validation policy to ensure correctness of the KEK.
    * @param keyChain The KeyChain used to sign Data packets.
    * @param face The Face that will be used to fetch the KEK and publish CK data.
+   * @param storage (optional) The InMemoryStorage for the CK Data packets, for
+   * example an InMemoryStorageLru to bound the memory used by old CKs. (A
+   * consumer can't decrypt content whose CK was evicted.) If omitted or null,
+   * use an InMemoryStorageRetaining which keeps every CK.
    */
   EncryptorV2
     (const Name& accessPrefix, const Name& ckPrefix,
      const SigningInfo& ckDataSigningInfo, const EncryptError::OnError& onError,
-     Validator* validator, KeyChain* keyChain, Face* face)
+     Validator* validator, KeyChain* keyChain, Face* face,
+     const ptr_lib::shared_ptr<InMemoryStorage>& storage =
+       ptr_lib::shared_ptr<InMemoryStorage>())
   : impl_(new Impl
           (accessPrefix, ckPrefix, ckDataSigningInfo, onError, validator, 
-           keyChain, face))
+           keyChain, face, storage))
   {
     impl_->initialize();
   }
@@ -195,11 +201,12 @@ private:
     Impl
       (const Name& accessPrefix, const Name& ckPrefix,
        const SigningInfo& ckDataSigningInfo, const EncryptError::OnError& onError,
-       Validator* validator, KeyChain* keyChain, Face* face)
+       Validator* validator, KeyChain* keyChain, Face* face,
+       const ptr_lib::shared_ptr<InMemoryStorage>& storage)
     : accessPrefix_(accessPrefix), ckPrefix_(ckPrefix),
       ckDataSigningInfo_(ckDataSigningInfo), isKekRetrievalInProgress_(false),
-      onError_(onError), keyChain_(keyChain), face_(face),
-      kekPendingInterestId_(0)
+      onError_(onError), applicationStorage_(storage), keyChain_(keyChain),
+      face_(face), kekPendingInterestId_(0)
     {}
 
     /**
@@ -223,13 +230,23 @@ private:
     regenerateCk();
 
     size_t
-    size() { return storage_.size(); }
+    size() { return getStorage().size(); }
 
   private:
     // Give friend access to the tests.
     friend class ::TestEncryptorV2_EncryptAndPublishCk_Test;
     friend class ::TestEncryptorV2_EnumerateDataFromInMemoryStorage_Test;
 
+    /**
+     * Get the storage for encrypted CKs, which is the storage given to the
+     * constructor, or storage_ if it was null.
+     */
+    InMemoryStorage&
+    getStorage()
+    {
+      return applicationStorage_ ? *applicationStorage_ : storage_;
+    }
+
     void
     retryFetchingKek();
 
@@ -250,7 +267,7 @@ private:
 
     /**
      * Make a CK Data packet for ckName_ encrypted by the KEK in kekData_ and
-     * insert it in the storage_.
+     * insert it in the storage.
      * @param onError On failure, this calls onError(errorCode, message) where
      * errorCode is from the EncryptError::ErrorCode enum, and message is an
      * error string.
@@ -269,8 +286,9 @@ private:
     ptr_lib::shared_ptr<Data> kekData_;
     EncryptError::OnError onError_;
 
-    // Storage for encrypted CKs.
+    // Storage for encrypted CKs if the application didn't supply one.
     InMemoryStorageRetaining storage_;
+    ptr_lib::shared_ptr<InMemoryStorage> applicationStorage_;
     uint64_t ckRegisteredPrefixId_;
     uint64_t kekPendingInterestId_;
 
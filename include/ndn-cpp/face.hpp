@@ -22,6 +22,7 @@
 #ifndef NDN_FACE_HPP
 #define NDN_FACE_HPP
 
+#include <map>
 #include "interest.hpp"
 #include "data.hpp"
 #include "network-nack.hpp"
@@ -29,6 +30,7 @@
 #include "encoding/wire-format.hpp"
 #include "interest-filter.hpp"
 #include "transport/transport.hpp"
+#include "util/rtt-estimator.hpp"
 
 namespace ndn {
 
@@ -124,6 +126,96 @@ public:
   void
   setInterestLoopbackEnabled(bool interestLoopbackEnabled);
 
+  /**
+   * Enable or disable RTT estimation. If enabled, when a Data packet satisfies
+   * a pending Interest from expressInterest, the time since the Interest was
+   * sent is added to an RttEstimator for the Interest name without its final
+   * component (usually the segment or sequence number). An Interest whose
+   * lifetime was set by the application is not sampled, since it may be a
+   * long-lived Interest (such as a sync Interest) which is answered only when
+   * the producer has new data. Use getRttEstimate or getRttEstimates to monitor
+   * the estimates. The number of prefixes is bounded, and the least recently
+   * updated prefix is removed first. RTT estimation is disabled by default.
+   * @param rttEstimationEnabled If true, enable RTT estimation, otherwise
+   * disable it.
+   */
+  void
+  setRttEstimationEnabled(bool rttEstimationEnabled);
+
+  /**
+   * Enable or disable the adaptive Interest lifetime, which also enables RTT
+   * estimation (see setRttEstimationEnabled). If enabled and the Interest to
+   * expressInterest does not have a lifetime, then set its lifetime to the
+   * retransmission timeout of the estimator with the longest matching prefix,
+   * so that onTimeout is called after about one RTO instead of the default
+   * 4000 milliseconds. If there is no estimate yet, use the default. When such
+   * an Interest times out, the prefix's retransmission timeout is doubled as in
+   * RFC 6298. To retransmit, use ExponentialReExpress as the onTimeout. The
+   * adaptive Interest lifetime is disabled by default.
+   * @param adaptiveInterestLifetimeEnabled If true, enable the adaptive
+   * Interest lifetime, otherwise disable it.
+   */
+  void
+  setAdaptiveInterestLifetimeEnabled(bool adaptiveInterestLifetimeEnabled);
+
+  /**
+   * Enable or disable Interest aggregation. If enabled, when expressInterest
+   * is called with an Interest which is the same as an outstanding Interest
+   * from expressInterest except for the nonce (the same name, selectors and
+   * lifetime), then do not send it again. Instead, the Data or network Nack
+   * for the outstanding Interest is given to the callbacks of both. The
+   * aggregated call times out when the lifetime of the outstanding Interest
+   * ends (even if the outstanding call was removed with
+   * removePendingInterest), not a full lifetime after it was called, since
+   * nothing else is on the wire for it. This is useful when separate parts of an application
+   * fetch the same packet at the same time. Use getAggregatedInterestCount to
+   * monitor aggregation. Interest aggregation is disabled by default.
+   * @param interestAggregationEnabled If true, enable Interest aggregation,
+   * otherwise disable it.
+   */
+  void
+  setInterestAggregationEnabled(bool interestAggregationEnabled);
+
+  /**
+   * Get the number of calls to expressInterest which were added to the pending
+   * interest table, whether sent or aggregated.
+   * @return The number of expressed Interests.
+   */
+  uint64_t
+  getExpressedInterestCount() const;
+
+  /**
+   * Get the number of calls to expressInterest which were aggregated with an
+   * outstanding Interest instead of being sent. (See
+   * setInterestAggregationEnabled.)
+   * @return The number of aggregated Interests.
+   */
+  uint64_t
+  getAggregatedInterestCount() const;
+
+  /**
+   * Get a copy of the RttEstimator with the longest prefix of interestName,
+   * as maintained when setRttEstimationEnabled(true). This may be called from
+   * any thread, including to monitor a ThreadsafeFace.
+   * @param interestName The Interest name, for example the name of the next
+   * segment to fetch.
+   * @param estimate Set this to a copy of the estimator.
+   * @return True if an estimator was found, false if not (and estimate is
+   * unchanged).
+   */
+  bool
+  getRttEstimate(const Name& interestName, RttEstimator& estimate) const;
+
+  /**
+   * Get a copy of all the RTT estimators, as maintained when
+   * setRttEstimationEnabled(true). This may be called from any thread,
+   * including to monitor a ThreadsafeFace.
+   * @param estimates Set this to the map of name prefix to RttEstimator. This
+   * first clears the map.
+   */
+  void
+  getRttEstimates(std::map<Name, RttEstimator>& estimates) const;
+
   /**
    * Send the Interest through the transport, read the entire response and call
    * onData, onTimeout or onNetworkNack as described below.
@@ -657,6 +749,28 @@ public:
   virtual void
   processEvents();
 
+  /**
+   * Block until there are packets to receive, until the next callLater
+   * callback (including an Interest timeout) is due, or until
+   * maxWaitMilliseconds has elapsed, whichever comes first. Then process events
+   * the same as processEvents(). Use this in an event loop instead of calling
+   * processEvents() and sleeping, to avoid both the added latency and busy
+   * waiting. callLater and expressInterest may be called from another thread:
+   * the call is queued for the processEvents thread and interrupts the wait so
+   * that the Interest is sent or the new delay is used right away. (Other
+   * methods such as removePendingInterest must still be called on the
+   * processEvents thread.) To interrupt the wait for another reason (for
+   * example to shut down), call wakeUp() on the Transport, which is
+   * thread-safe. If the transport can't wait (for example an async transport),
+   * this returns immediately after processing.
+   * @param maxWaitMilliseconds The maximum time to wait in milliseconds.
+   * @throws This may throw an exception for reading data or in the callback for
+   * processing the data.  If you call this from an main event loop, you may
+   * want to catch and log/disregard all exceptions.
+   */
+  virtual void
+  processEvents(Milliseconds maxWaitMilliseconds);
+
   /**
    * Check if the face is local based on the current connection through the
    * Transport; some Transport may cause network I/O (e.g. an IP host name lookup).
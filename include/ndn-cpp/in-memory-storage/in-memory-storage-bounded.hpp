@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_IN_MEMORY_STORAGE_BOUNDED_HPP
+#define NDN_IN_MEMORY_STORAGE_BOUNDED_HPP
+
+#include <map>
+#include <list>
+#include "in-memory-storage.hpp"
+
+namespace ndn {
+
+/**
+ * InMemoryStorageBounded is the base class for an in-memory storage with a
+ * limit on the number of packets and/or the total bytes of their wire
+ * encodings. When an insert goes over the limit, the eviction policy of the
+ * subclass (InMemoryStorageFifo, InMemoryStorageLru or InMemoryStorageLfu)
+ * chooses the entries to evict in constant time. The entries are kept in name
+ * order so that find(interest) only visits the entries under the Interest
+ * name, and honors CanBePrefix, MustBeFresh and ChildSelector.
+ */
+class InMemoryStorageBounded : public InMemoryStorage {
+public:
+  /**
+   * Create an InMemoryStorageBounded with the given limits.
+   * @param limit The maximum number of packets. If 0, there is no limit on
+   * the number of packets.
+   * @param byteLimit (optional) The maximum total size of the packet wire
+   * encodings. If omitted or 0, there is no limit on the bytes.
+   */
+  InMemoryStorageBounded(size_t limit, size_t byteLimit = 0)
+  : limit_(limit), byteLimit_(byteLimit), nBytes_(0), evictionCount_(0)
+  {
+  }
+
+  /**
+   * Insert a Data packet. If a Data packet with the same name, including the
+   * implicit digest, already exists, replace it. If this goes over the
+   * limit, evict entries chosen by the eviction policy. The MetaInfo
+   * freshness period of the Data is used to answer Interests with MustBeFresh.
+   * @param data The packet to insert, which is copied.
+   */
+  virtual void
+  insert(const Data& data);
+
+  /**
+   * Find the first Data in name order whose name has the given prefix. This
+   * counts as an access for the eviction policy.
+   * @param name The Name prefix of the Data packet to find.
+   * @return The matching Data if any, otherwise null. You should not modify the
+   * returned object. If you need to modify it then you must make a copy.
+   */
+  virtual ptr_lib::shared_ptr<Data>
+  find(const Name& name);
+
+  /**
+   * Find the best match Data for the Interest, honoring its CanBePrefix,
+   * MustBeFresh and ChildSelector. If the Interest name ends with an implicit
+   * digest, it only matches the Data with that full name. This counts as an
+   * access for the eviction policy.
+   * @param interest The Interest with the Name of the Data packet to find.
+   * @return The best match if any, otherwise null. You should not modify the
+   * returned object. If you need to modify it then you must make a copy.
+   */
+  virtual ptr_lib::shared_ptr<Data>
+  find(const Interest& interest);
+
+  /**
+   * Remove matching entries by prefix.
+   * @param prefix The prefix Name of the entries to remove.
+   */
+  virtual void
+  remove(const Name& prefix);
+
+  /**
+   * Get the number of packets stored in the in-memory storage.
+   * @return The number of packets.
+   */
+  virtual size_t
+  size() { return cache_.size(); }
+
+  /**
+   * Get the maximum number of packets.
+   * @return The packet limit, or 0 if there is no limit on the packets.
+   */
+  size_t
+  getLimit() const { return limit_; }
+
+  /**
+   * Get the maximum total bytes of the packet wire encodings.
+   * @return The byte limit, or 0 if there is no limit on the bytes.
+   */
+  size_t
+  getByteLimit() const { return byteLimit_; }
+
+  /**
+   * Get the total bytes of the wire encodings of the stored packets.
+   * @return The number of bytes.
+   */
+  size_t
+  getByteCount() const { return nBytes_; }
+
+  /**
+   * Get the number of entries evicted because of the limit, not counting
+   * entries removed by remove() or replaced by insert().
+   * @return The number of evictions.
+   */
+  uint64_t
+  getEvictionCount() const { return evictionCount_; }
+
+protected:
+  class Entry;
+  typedef std::list<Entry*> EntryList;
+
+  /**
+   * An Entry holds a stored Data packet and the fields which the eviction
+   * policy of the subclass uses to find the entry in its lists in constant
+   * time.
+   */
+  class Entry {
+  public:
+    Entry()
+    : useCount_(0), fullName_(0), encodingSize_(0), staleTime_(0)
+    {
+    }
+
+    /**
+     * Set the Data packet of this entry and compute its stale time.
+     * @param data The Data packet, which is not copied.
+     * @param encodingSize The size of the wire encoding of data.
+     * @param nowMilliseconds The current time in milliseconds from
+     * ndn_getNowMilliseconds.
+     */
+    void
+    setData
+      (const ptr_lib::shared_ptr<Data>& data, size_t encodingSize,
+       MillisecondsSince1970 nowMilliseconds);
+
+    const ptr_lib::shared_ptr<Data>&
+    getData() const { return data_; }
+
+    size_t
+    getEncodingSize() const { return encodingSize_; }
+
+    /**
+     * Check if this entry is still fresh according to the Data freshness
+     * period when it was inserted.
+     * @param nowMilliseconds The current time in milliseconds from
+     * ndn_getNowMilliseconds.
+     * @return True if fresh, false if stale.
+     */
+    bool
+    isFresh(MillisecondsSince1970 nowMilliseconds) const
+    {
+      return staleTime_ > nowMilliseconds;
+    }
+
+    // The position in the list of the eviction policy.
+    EntryList::iterator position_;
+    // The bucket in the InMemoryStorageLfu frequency list.
+    std::list<EntryList>::iterator bucket_;
+    uint64_t useCount_;
+
+  private:
+    friend class InMemoryStorageBounded;
+
+    // The key of this entry in cache_.
+    const Name* fullName_;
+    ptr_lib::shared_ptr<Data> data_;
+    size_t encodingSize_;
+    MillisecondsSince1970 staleTime_;
+  };
+
+  /**
+   * This is called after the entry is inserted. The subclass should add it to
+   * its eviction list.
+   */
+  virtual void
+  afterInsert(Entry* entry) = 0;
+
+  /**
+   * This is called after a find returns the entry.
+   */
+  virtual void
+  afterAccess(Entry* entry) = 0;
+
+  /**
+   * This is called before the entry is erased. The subclass should remove it
+   * from its eviction list.
+   */
+  virtual void
+  beforeErase(Entry* entry) = 0;
+
+  /**
+   * Choose the entry to evict.
+   * @return The entry to evict, or null if there are no entries.
+   */
+  virtual Entry*
+  selectVictim() = 0;
+
+private:
+  typedef std::map<Name, Entry> Cache;
+
+  /**
+   * Call beforeErase and erase the cache entry.
+   */
+  void
+  erase(Cache::iterator entry);
+
+  /**
+   * Check if the Interest selects the entry.
+   */
+  static bool
+  matches
+    (const Interest& interest, const Entry& entry,
+     MillisecondsSince1970 nowMilliseconds)
+  {
+    return interest.matchesName(entry.getData()->getName()) &&
+      (!interest.getMustBeFresh() || entry.isFresh(nowMilliseconds));
+  }
+
+  /**
+   * Call afterAccess and return the entry Data.
+   */
+  const ptr_lib::shared_ptr<Data>&
+  access(Entry& entry)
+  {
+    afterAccess(&entry);
+    return entry.getData();
+  }
+
+  // The key is the full name of the Data, including the implicit digest.
+  Cache cache_;
+  size_t limit_;
+  size_t byteLimit_;
+  size_t nBytes_;
+  uint64_t evictionCount_;
+};
+
+}
+
+#endif
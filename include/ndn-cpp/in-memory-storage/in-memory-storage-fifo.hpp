@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_IN_MEMORY_STORAGE_FIFO_HPP
+#define NDN_IN_MEMORY_STORAGE_FIFO_HPP
+
+#include "in-memory-storage-bounded.hpp"
+
+namespace ndn {
+
+/**
+ * InMemoryStorageFifo is an InMemoryStorageBounded which evicts the entry that
+ * was inserted first.
+ */
+class InMemoryStorageFifo : public InMemoryStorageBounded {
+public:
+  /**
+   * Create an InMemoryStorageFifo with the given limits.
+   * @param limit The maximum number of packets. If 0, there is no limit on
+   * the number of packets.
+   * @param byteLimit (optional) The maximum total size of the packet wire
+   * encodings. If omitted or 0, there is no limit on the bytes.
+   */
+  InMemoryStorageFifo(size_t limit, size_t byteLimit = 0)
+  : InMemoryStorageBounded(limit, byteLimit)
+  {
+  }
+
+protected:
+  virtual void
+  afterInsert(Entry* entry)
+  {
+    entry->position_ = queue_.insert(queue_.end(), entry);
+  }
+
+  virtual void
+  afterAccess(Entry* entry) {}
+
+  virtual void
+  beforeErase(Entry* entry) { queue_.erase(entry->position_); }
+
+  virtual Entry*
+  selectVictim() { return queue_.empty() ? 0 : queue_.front(); }
+
+  // The front is the next to evict.
+  EntryList queue_;
+};
+
+}
+
+#endif
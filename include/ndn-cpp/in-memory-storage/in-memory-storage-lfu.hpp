@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_IN_MEMORY_STORAGE_LFU_HPP
+#define NDN_IN_MEMORY_STORAGE_LFU_HPP
+
+#include "in-memory-storage-bounded.hpp"
+
+namespace ndn {
+
+/**
+ * InMemoryStorageLfu is an InMemoryStorageBounded which evicts the least
+ * frequently used entry, where insert and find count as a use. Among entries
+ * with the same use count, it evicts the one which reached the count first.
+ * The entries are kept in a list of buckets with increasing use count so that
+ * insert, access and eviction are constant time.
+ */
+class InMemoryStorageLfu : public InMemoryStorageBounded {
+public:
+  /**
+   * Create an InMemoryStorageLfu with the given limits.
+   * @param limit The maximum number of packets. If 0, there is no limit on
+   * the number of packets.
+   * @param byteLimit (optional) The maximum total size of the packet wire
+   * encodings. If omitted or 0, there is no limit on the bytes.
+   */
+  InMemoryStorageLfu(size_t limit, size_t byteLimit = 0)
+  : InMemoryStorageBounded(limit, byteLimit)
+  {
+  }
+
+protected:
+  virtual void
+  afterInsert(Entry* entry);
+
+  virtual void
+  afterAccess(Entry* entry);
+
+  virtual void
+  beforeErase(Entry* entry);
+
+  virtual Entry*
+  selectVictim()
+  {
+    return buckets_.empty() ? 0 : buckets_.front().front();
+  }
+
+private:
+  // Each bucket is the non-empty list of entries with the same useCount_, in
+  // increasing order of the use count.
+  std::list<EntryList> buckets_;
+};
+
+}
+
+#endif
@@ -24,8 +24,7 @@
 #define NDN_IN_MEMORY_STORAGE_RETAINING_HPP
 
 #include <map>
-#include "../interest.hpp"
-#include "../data.hpp"
+#include "in-memory-storage.hpp"
 
 // Give friend access to the tests.
 class TestEncryptorV2_EnumerateDataFromInMemoryStorage_Test;
@@ -40,14 +39,14 @@ namespace ndn {
  * Note: In ndn-cxx, this class is called InMemoryStoragePersistent, but
  * "persistent" misleadingly sounds like persistent on-disk storage.
  */
-class InMemoryStorageRetaining {
+class InMemoryStorageRetaining : public InMemoryStorage {
 public:
   /**
    * Insert a Data packet. If a Data packet with the same name, including the
    * implicit digest, already exists, replace it.
    * @param data The packet to insert, which is copied.
    */
-  void
+  virtual void
   insert(const Data& data)
   {
     cache_[*data.getFullName()] = ptr_lib::make_shared<Data>(data);
@@ -59,7 +58,7 @@ public:
    * @return The best match if any, otherwise null. You should not modify the
    * returned object. If you need to modify it then you must make a copy.
    */
-  ptr_lib::shared_ptr<Data>
+  virtual ptr_lib::shared_ptr<Data>
   find(const Name& name);
 
   /**
@@ -68,7 +67,7 @@ public:
    * @return The best match if any, otherwise null. You should not modify the
    * returned object. If you need to modify it then you must make a copy.
    */
-  ptr_lib::shared_ptr<Data>
+  virtual ptr_lib::shared_ptr<Data>
   find(const Interest& interest)
   {
     // Debug: Check selectors, especially CanBePrefix.
@@ -79,14 +78,14 @@ public:
    * Remove matching entries by prefix.
    * @param prefix The prefix Name of the entries to remove.
    */
-  void
+  virtual void
   remove(const Name& prefix);
 
   /**
    * Get the number of packets stored in the in-memory storage.
    * @return The number of packets.
    */
-  size_t
+  virtual size_t
   size() { return cache_.size(); }
 
   /**
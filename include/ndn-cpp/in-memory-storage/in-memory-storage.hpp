@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_IN_MEMORY_STORAGE_HPP
+#define NDN_IN_MEMORY_STORAGE_HPP
+
+#include "../interest.hpp"
+#include "../data.hpp"
+
+namespace ndn {
+
+/**
+ * InMemoryStorage is the abstract base class for an application cache of Data
+ * packets in memory. It is implemented by InMemoryStorageRetaining which never
+ * evicts, and by the bounded InMemoryStorageFifo, InMemoryStorageLru and
+ * InMemoryStorageLfu, so that a class like EncryptorV2 can use any of them.
+ */
+class InMemoryStorage {
+public:
+  virtual
+  ~InMemoryStorage() {}
+
+  /**
+   * Insert a Data packet. If a Data packet with the same name, including the
+   * implicit digest, already exists, replace it.
+   * @param data The packet to insert, which is copied.
+   */
+  virtual void
+  insert(const Data& data) = 0;
+
+  /**
+   * Find the best match Data for a Name.
+   * @param name The Name of the Data packet to find.
+   * @return The best match if any, otherwise null. You should not modify the
+   * returned object. If you need to modify it then you must make a copy.
+   */
+  virtual ptr_lib::shared_ptr<Data>
+  find(const Name& name) = 0;
+
+  /**
+   * Find the best match Data for an Interest.
+   * @param interest The Interest with the Name of the Data packet to find.
+   * @return The best match if any, otherwise null. You should not modify the
+   * returned object. If you need to modify it then you must make a copy.
+   */
+  virtual ptr_lib::shared_ptr<Data>
+  find(const Interest& interest) = 0;
+
+  /**
+   * Remove matching entries by prefix.
+   * @param prefix The prefix Name of the entries to remove.
+   */
+  virtual void
+  remove(const Name& prefix) = 0;
+
+  /**
+   * Get the number of packets stored in the in-memory storage.
+   * @return The number of packets.
+   */
+  virtual size_t
+  size() = 0;
+};
+
+}
+
+#endif
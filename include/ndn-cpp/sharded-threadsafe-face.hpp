@@ -0,0 +1,238 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_SHARDED_THREADSAFE_FACE_HPP
+#define NDN_SHARDED_THREADSAFE_FACE_HPP
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include "ndn-cpp-config.h"
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <vector>
+#include "threadsafe-face.hpp"
+
+namespace ndn {
+
+/**
+ * A ShardedThreadsafeFace extends ThreadsafeFace to spread the pending interest
+ * table over several shards, where each shard has its own asio io_service
+ * running in its own thread. expressInterest sends the Interest to a shard
+ * chosen by the hash of the first nShardKeyComponents name components, so that
+ * adding the pending interest, matching a received Data packet and processing
+ * the Interest timeout for different names run in parallel on multiple cores.
+ * There is still one transport, and the ioService given to the constructor
+ * receives each packet and routes a Data packet or network Nack to the shard
+ * which holds the matching pending interests. Interests with fewer than
+ * nShardKeyComponents name components (not counting an implicit digest) are
+ * kept by the ioService, which also does registerPrefix, setInterestFilter,
+ * putData, etc. the same as ThreadsafeFace.
+ *
+ * As with ThreadsafeFace, the onData, onTimeout and onNetworkNack callbacks are
+ * called on the thread which runs the ioService: a shard posts them to the
+ * ioService. To save that hop, you can set callOnShardThreads in the
+ * constructor so that a shard calls the callbacks on its own thread, in which
+ * case the callbacks must be thread safe. (They may call methods of this face,
+ * which are thread safe.)
+ *
+ * IMPORTANT: The application must run the ioService on one thread. This face
+ * keeps the pending interests for short names on the ioService, and
+ * removePendingInterest relies on the ioService calling handlers in the order
+ * they are posted. Destroy this face only after the ioService has stopped. The
+ * destructor stops the shard threads.
+ */
+class ShardedThreadsafeFace : public ThreadsafeFace {
+public:
+  /**
+   * Create a new ShardedThreadsafeFace for communication with an NDN hub with
+   * the given Transport object and connectionInfo.
+   * @param ioService The asio io_service which receives from the transport. It
+   * is the responsibility of the application to start and stop the service.
+   * @param transport A shared_ptr to a Transport object used for communication.
+   * This should be an async transport like AsyncTcpTransport which uses the
+   * same ioService.
+   * @param connectionInfo A shared_ptr to a Transport::ConnectionInfo to be
+   * used to connect to the transport.
+   * @param nShards (optional) The number of shards, each with its own thread.
+   * If omitted or 0, use the number of online processors.
+   * @param nShardKeyComponents (optional) The number of leading name components
+   * to hash to choose the shard for an Interest. If omitted, use 2.
+   * @param callOnShardThreads (optional) If true, call the onData, onTimeout
+   * and onNetworkNack callbacks on the shard threads, which requires the
+   * callbacks to be thread safe. If omitted or false, post the callbacks to the
+   * ioService the same as ThreadsafeFace.
+   */
+  ShardedThreadsafeFace
+    (boost::asio::io_service& ioService,
+     const ptr_lib::shared_ptr<Transport>& transport,
+     const ptr_lib::shared_ptr<const Transport::ConnectionInfo>& connectionInfo,
+     size_t nShards = 0, size_t nShardKeyComponents = 2,
+     bool callOnShardThreads = false);
+
+  /**
+   * Create a new ShardedThreadsafeFace for communication with an NDN hub using
+   * a default connection the same as ThreadsafeFace(ioService).
+   * @param ioService The asio io_service which receives from the transport. It
+   * is the responsibility of the application to start and stop the service.
+   * @param nShards (optional) The number of shards, each with its own thread.
+   * If omitted or 0, use the number of online processors.
+   * @param nShardKeyComponents (optional) The number of leading name components
+   * to hash to choose the shard for an Interest. If omitted, use 2.
+   * @param callOnShardThreads (optional) If true, call the onData, onTimeout
+   * and onNetworkNack callbacks on the shard threads. See the other constructor.
+   */
+  ShardedThreadsafeFace
+    (boost::asio::io_service& ioService, size_t nShards = 0,
+     size_t nShardKeyComponents = 2, bool callOnShardThreads = false);
+
+  virtual
+  ~ShardedThreadsafeFace();
+
+  /**
+   * Get the number of shards, not counting the pending interests kept by the
+   * ioService given to the constructor.
+   * @return The number of shards.
+   */
+  size_t
+  getShardCount() const { return shards_.size(); }
+
+  /**
+   * Override to dispatch expressInterest to the io_service of the shard for
+   * the Interest name. See Face.expressInterest for calling details.
+   */
+  virtual uint64_t
+  expressInterest
+    (const Interest& interest, const OnData& onData,
+     const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat());
+
+  /**
+   * Override to dispatch expressInterest to the io_service of the shard for
+   * the Interest name. See Face.expressInterest for calling details.
+   */
+  virtual uint64_t
+  expressInterest
+    (const Name& name, const Interest *interestTemplate, const OnData& onData,
+     const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat());
+
+  uint64_t
+  expressInterest
+    (const Name& name, const OnData& onData, const OnTimeout& onTimeout = OnTimeout(),
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat())
+  {
+    // This is needed, otherwise C++ will use the signature with
+    // const Interest& by automatically converting the Name to an Interest
+    // using the constructor Interest(const Name& name). Just call the Face
+    // method with the same signature as this.
+    return Face::expressInterest(name, onData, onTimeout, wireFormat);
+  }
+
+  /**
+   * Override to dispatch removePendingInterest to the shard which has the
+   * pending interest, as recorded in the pendingInterestId. This requires the
+   * application to run the ioService on one thread (see the class
+   * documentation), so that the shard adds the pending interest before it
+   * removes it. See Face.removePendingInterest for
+   * calling details.
+   */
+  virtual void
+  removePendingInterest(uint64_t pendingInterestId);
+
+private:
+  class Shard;
+
+  void
+  construct(size_t nShards, bool callOnShardThreads);
+
+  /**
+   * Add the nonce (if needed) to the copied interest and dispatch to its shard.
+   */
+  uint64_t
+  expressInterestCopy
+    (const ptr_lib::shared_ptr<const Interest>& interestCopy,
+     const OnData& onData,
+     const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+     WireFormat& wireFormat);
+
+  /**
+   * Get the index of the shard which keeps the pending interests for the name.
+   * @param name The name of the Interest or Data.
+   * @param nComponents The number of components of the name, not counting an
+   * implicit digest component of an Interest name.
+   * @return The index in shards_, or shards_.size() for shortNameShard_ if
+   * nComponents is less than nShardKeyComponents_.
+   */
+  size_t
+  getShardIndex(const Name& name, size_t nComponents);
+
+  /**
+   * Get the shard at the index from getShardIndex.
+   * @param shardIndex The index in shards_, or shards_.size() for
+   * shortNameShard_.
+   * @return The shard.
+   */
+  Shard&
+  getShard(size_t shardIndex)
+  {
+    return shardIndex < shards_.size() ? *shards_[shardIndex] : *shortNameShard_;
+  }
+
+  /**
+   * Get the shard which keeps the pending interests for the name.
+   * @param name The name of the Interest or Data.
+   * @param nComponents The number of components of the name, not counting an
+   * implicit digest component of an Interest name.
+   * @return The shard, or shortNameShard_ if nComponents is less than
+   * nShardKeyComponents_.
+   */
+  Shard&
+  getShard(const Name& name, size_t nComponents)
+  {
+    return getShard(getShardIndex(name, nComponents));
+  }
+
+  /**
+   * This is called on the thread of the ioService for each Data packet
+   * received by the Node, to route it to the shards.
+   */
+  void
+  onReceivedData(const ptr_lib::shared_ptr<Data>& data);
+
+  /**
+   * This is called on the thread of the ioService for each network Nack
+   * received by the Node, to route it to the shards.
+   */
+  void
+  onReceivedNetworkNack
+    (const ptr_lib::shared_ptr<Interest>& interest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack);
+
+  std::vector<ptr_lib::shared_ptr<Shard> > shards_;
+  // The pending interests for short names, which uses the ioService.
+  ptr_lib::shared_ptr<Shard> shortNameShard_;
+  size_t nShardKeyComponents_;
+};
+
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
+
+#endif
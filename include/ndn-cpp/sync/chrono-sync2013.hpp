@@ -24,14 +24,12 @@
 #define NDN_CHRONO_SYNC2013_HPP
 
 #include <vector>
+#include <deque>
+#include <unordered_map>
 #include "../face.hpp"
 #include "../security/key-chain.hpp"
 #include "../util/memory-content-cache.hpp"
 
-namespace google { namespace protobuf { template <typename Element> class RepeatedPtrField; } }
-namespace Sync { class SyncStateMsg; }
-namespace Sync { class SyncState; }
-
 namespace ndn {
 
 class DigestTree;
@@ -53,6 +51,33 @@ public:
 
   typedef func_lib::function<void()> OnInitialized;
 
+  /**
+   * A RootDigestMode specifies how the root digest of the digest tree is
+   * computed. ROOT_DIGEST_CHRONOSYNC is the SHA-256 of all the participant
+   * digests, which is the original ChronoSync method used by other libraries.
+   * ROOT_DIGEST_MERKLE combines the participant digests in a binary Merkle
+   * tree, so that a new sequence number only re-hashes the path to the root
+   * instead of all participants. All members of a sync group must use the same
+   * RootDigestMode.
+   */
+  enum RootDigestMode {
+    ROOT_DIGEST_CHRONOSYNC = 0,
+    ROOT_DIGEST_MERKLE = 1
+  };
+
+  /**
+   * A SyncStateEncoding specifies the encoding of the sync state messages in
+   * the content of a sync Data packet. SYNC_STATE_ENCODING_PROTOBUF is the
+   * SyncStateMsg used by other ChronoSync libraries. SYNC_STATE_ENCODING_TLV
+   * is a more compact NDN-TLV encoding. A receiver detects the encoding, so
+   * members of a sync group which can decode both can use different encodings
+   * for sending.
+   */
+  enum SyncStateEncoding {
+    SYNC_STATE_ENCODING_PROTOBUF = 0,
+    SYNC_STATE_ENCODING_TLV = 1
+  };
+
   /**
    * Create a new ChronoSync2013 to communicate using the given face. Initialize
    * the digest log with a digest of "00" and and empty content. Register the
@@ -124,9 +149,10 @@ public:
   /**
    * A SyncState holds the values of a sync state message which is passed to the
    * onReceivedSyncState callback which was given to the ChronoSyn2013
-   * constructor. Note: this has the same info as the Protobuf class
-   * Sync::SyncState, but we make a separate class so that we don't need the
-   * Protobuf definition in the ChronoSync API.
+   * constructor. This is also the flat entry which ChronoSync2013 stores in
+   * its digest log. Note: this has the same info as the Protobuf class
+   * Sync::SyncState with type UPDATE, but we make a separate class so that we
+   * don't need the Protobuf definition in the ChronoSync API.
    */
   class SyncState {
   public:
@@ -268,6 +294,104 @@ public:
     return impl_->getSequenceNo();
   }
 
+  /**
+   * Set the RootDigestMode. Since this changes the root digest, you should
+   * call this right after the constructor, before calling processEvents.
+   * @param rootDigestMode The RootDigestMode. The default is
+   * ROOT_DIGEST_CHRONOSYNC.
+   */
+  void
+  setRootDigestMode(RootDigestMode rootDigestMode)
+  {
+    impl_->setRootDigestMode(rootDigestMode);
+  }
+
+  /**
+   * Get the RootDigestMode.
+   * @return The RootDigestMode.
+   */
+  RootDigestMode
+  getRootDigestMode() const { return impl_->getRootDigestMode(); }
+
+  /**
+   * Set the SyncStateEncoding for the sync state messages which this sends.
+   * This always decodes received messages in either encoding, so an
+   * application can change to SYNC_STATE_ENCODING_TLV once all the members of
+   * the group use a version of this library which decodes it.
+   * @param syncStateEncoding The SyncStateEncoding. The default is
+   * SYNC_STATE_ENCODING_PROTOBUF.
+   */
+  void
+  setSyncStateEncoding(SyncStateEncoding syncStateEncoding)
+  {
+    impl_->setSyncStateEncoding(syncStateEncoding);
+  }
+
+  /**
+   * Get the SyncStateEncoding for the sync state messages which this sends.
+   * @return The SyncStateEncoding.
+   */
+  SyncStateEncoding
+  getSyncStateEncoding() const { return impl_->getSyncStateEncoding(); }
+
+  /**
+   * Set the maximum number of entries in the digest log. When a new entry
+   * makes the log larger, remove the oldest entries. The oldest remaining entry
+   * is kept as a snapshot base without its sync states. A sync Interest for
+   * the digest of a removed entry is handled like an unknown digest, and a
+   * recovery Interest for it is answered with the full state.
+   * @param maxDigestLogEntries The maximum number of entries. If 0, there is
+   * no limit. The default is 0.
+   */
+  void
+  setMaxDigestLogEntries(size_t maxDigestLogEntries)
+  {
+    impl_->setMaxDigestLogEntries(maxDigestLogEntries);
+  }
+
+  /**
+   * Get the maximum number of entries in the digest log.
+   * @return The maximum number of entries, or 0 for no limit.
+   */
+  size_t
+  getMaxDigestLogEntries() const { return impl_->getMaxDigestLogEntries(); }
+
+  /**
+   * Set the maximum memory used by the digest log, as returned by
+   * getDigestLogMemoryUsage(). When a new entry makes it larger, remove the
+   * oldest entries as described in setMaxDigestLogEntries. The newest entry is
+   * always kept, even if it alone exceeds the maximum.
+   * @param maxDigestLogBytes The maximum number of bytes. If 0, there is no
+   * limit. The default is 0.
+   */
+  void
+  setMaxDigestLogBytes(size_t maxDigestLogBytes)
+  {
+    impl_->setMaxDigestLogBytes(maxDigestLogBytes);
+  }
+
+  /**
+   * Get the maximum memory used by the digest log.
+   * @return The maximum number of bytes, or 0 for no limit.
+   */
+  size_t
+  getMaxDigestLogBytes() const { return impl_->getMaxDigestLogBytes(); }
+
+  /**
+   * Get the number of entries in the digest log.
+   * @return The number of entries.
+   */
+  size_t
+  getDigestLogSize() const { return impl_->getDigestLogSize(); }
+
+  /**
+   * Get the approximate memory used by the digest log and its index, for
+   * monitoring.
+   * @return The number of bytes.
+   */
+  size_t
+  getDigestLogMemoryUsage() const { return impl_->getDigestLogMemoryUsage(); }
+
   /**
    * Unregister callbacks so that this does not respond to interests anymore.
    * If you will delete this ChronoSync2013 object while your application is
@@ -288,18 +412,33 @@ private:
   class DigestLogEntry {
   public:
     DigestLogEntry
-      (const std::string& digest,
-       const google::protobuf::RepeatedPtrField<Sync::SyncState>& data);
+      (const std::string& digest, const std::vector<SyncState>& data)
+    : digest_(digest), data_(data)
+    {
+    }
 
     const std::string&
     getDigest() const { return digest_; }
 
-    const google::protobuf::RepeatedPtrField<Sync::SyncState>&
-    getData() const { return *data_; }
+    const std::vector<SyncState>&
+    getData() const { return data_; }
+
+    /**
+     * Remove the sync states, for an entry which is only kept for its digest.
+     */
+    void
+    clearData() { std::vector<SyncState>().swap(data_); }
+
+    /**
+     * Get the approximate memory used by this entry.
+     * @return The number of bytes.
+     */
+    size_t
+    getMemoryUsage() const;
 
   private:
     std::string digest_;
-    ptr_lib::shared_ptr<google::protobuf::RepeatedPtrField<Sync::SyncState> > data_;
+    std::vector<SyncState> data_;
   };
 
   /**
@@ -357,6 +496,69 @@ private:
     int
     getSequenceNo() const { return sequenceNo_; }
 
+    /**
+     * See ChronoSync2013::setRootDigestMode.
+     */
+    void
+    setRootDigestMode(RootDigestMode rootDigestMode);
+
+    /**
+     * See ChronoSync2013::getRootDigestMode.
+     */
+    RootDigestMode
+    getRootDigestMode() const;
+
+    /**
+     * See ChronoSync2013::setSyncStateEncoding.
+     */
+    void
+    setSyncStateEncoding(SyncStateEncoding syncStateEncoding)
+    {
+      syncStateEncoding_ = syncStateEncoding;
+    }
+
+    /**
+     * See ChronoSync2013::getSyncStateEncoding.
+     */
+    SyncStateEncoding
+    getSyncStateEncoding() const { return syncStateEncoding_; }
+
+    /**
+     * See ChronoSync2013::setMaxDigestLogEntries.
+     */
+    void
+    setMaxDigestLogEntries(size_t maxDigestLogEntries);
+
+    /**
+     * See ChronoSync2013::getMaxDigestLogEntries.
+     */
+    size_t
+    getMaxDigestLogEntries() const { return maxDigestLogEntries_; }
+
+    /**
+     * See ChronoSync2013::setMaxDigestLogBytes.
+     */
+    void
+    setMaxDigestLogBytes(size_t maxDigestLogBytes);
+
+    /**
+     * See ChronoSync2013::getMaxDigestLogBytes.
+     */
+    size_t
+    getMaxDigestLogBytes() const { return maxDigestLogBytes_; }
+
+    /**
+     * See ChronoSync2013::getDigestLogSize.
+     */
+    size_t
+    getDigestLogSize() const { return digestLog_.size(); }
+
+    /**
+     * See ChronoSync2013::getDigestLogMemoryUsage.
+     */
+    size_t
+    getDigestLogMemoryUsage() const { return digestLogBytes_; }
+
     /**
      * See ChronoSync2013::shutdown.
      */
@@ -369,15 +571,24 @@ private:
 
   private:
     /**
-     * Make a data packet with the syncMessage and with name
+     * Make a data packet with the encoded syncStates and with name
      * applicationBroadcastPrefix_ + digest. Sign and send.
      * @param digest The root digest as a hex string for the data packet name.
-     * @param syncMessage The SyncStateMsg which updates the digest tree state
+     * @param syncStates The sync states which update the digest tree state
      * with the given digest.
      */
     void
     broadcastSyncState
-      (const std::string& digest, const Sync::SyncStateMsg& syncMessage);
+      (const std::string& digest, const std::vector<SyncState>& syncStates);
+
+    /**
+     * Encode the sync states for the content of a sync Data packet, using
+     * syncStateEncoding_.
+     * @param syncStates The sync states to encode.
+     * @return The encoding.
+     */
+    Blob
+    encodeSyncStates(const std::vector<SyncState>& syncStates) const;
 
     /**
      * Update the digest tree with the messages in content. If the digest tree
@@ -387,12 +598,40 @@ private:
      * tree root was not in the log), false if didn't add a log entry.
      */
     bool
-    update(const google::protobuf::RepeatedPtrField<Sync::SyncState >& content);
+    update(const std::vector<SyncState>& content);
 
-    // Search the digest log by digest.
+    /**
+     * Search the digest log by digest.
+     * @param digest The digest as a hex string.
+     * @return The index in digestLog_, or -1 if not found.
+     */
     int
     logFind(const std::string& digest) const;
 
+    /**
+     * Add the entry to digestLog_ and digestLogIndex_, then call pruneLog().
+     * @param entry The new entry, whose digest must not already be in the log.
+     */
+    void
+    addLogEntry(const ptr_lib::shared_ptr<DigestLogEntry>& entry);
+
+    /**
+     * While the digest log has more than maxDigestLogEntries_ entries or
+     * maxDigestLogBytes_ bytes, remove the oldest entry, keeping at least the
+     * newest.
+     * If an entry is removed, clear the sync states of the new oldest entry
+     * since processSyncInterest only uses the entries after the matched one.
+     */
+    void
+    pruneLog();
+
+    /**
+     * Get the approximate memory used by the entry and its digestLogIndex_
+     * entry.
+     */
+    static size_t
+    getLogEntryMemoryUsage(const DigestLogEntry& entry);
+
     /**
      * Process the sync interest from the applicationBroadcastPrefix. If we can't
      * satisfy the interest, add it to the pending interest table in the
@@ -448,7 +687,7 @@ private:
 
     // Process initial data which usually includes all other publisher's info, and send back the new comer's own info.
     void
-    initialOndata(const google::protobuf::RepeatedPtrField<Sync::SyncState >& content);
+    initialOndata(const std::vector<SyncState>& content);
 
     /**
      * This is a do-nothing onData for using expressInterest for timeouts.
@@ -465,7 +704,14 @@ private:
     Milliseconds syncLifetime_;
     OnReceivedSyncState onReceivedSyncState_;
     OnInitialized onInitialized_;
-    std::vector<ptr_lib::shared_ptr<DigestLogEntry> > digestLog_;
+    std::deque<ptr_lib::shared_ptr<DigestLogEntry> > digestLog_;
+    // The key is the digest. The value is the index in digestLog_ plus
+    // nPrunedLogEntries_, so that removing the oldest entry doesn't change it.
+    std::unordered_map<std::string, size_t> digestLogIndex_;
+    size_t nPrunedLogEntries_;
+    size_t digestLogBytes_;
+    size_t maxDigestLogEntries_;
+    size_t maxDigestLogBytes_;
     ptr_lib::shared_ptr<DigestTree> digestTree_;
     std::string applicationDataPrefixUri_;
     const Name applicationBroadcastPrefix_;
@@ -473,6 +719,7 @@ private:
     int initialPreviousSequenceNo_;
     int sequenceNo_;
     MemoryContentCache contentCache_;
+    SyncStateEncoding syncStateEncoding_;
     bool enabled_;
   };
 
@@ -136,6 +136,87 @@ public:
     impl_->publishName(prefix, sequenceNo);
   }
 
+  /**
+   * Increment the sequence number of each prefix Name and publish them with
+   * one update of the pending sync Interests for the whole list, instead of one
+   * for each prefix as with publishName. (addUserNode needs to be called before
+   * this to add each prefix.) A prefix which is not added is skipped.
+   * @param prefixes The list of prefix Names to be updated. If a prefix appears
+   * more than once, its sequence number is incremented for each.
+   * @return The number of distinct prefixes which were published.
+   */
+  size_t
+  publishNames(const std::vector<Name>& prefixes)
+  {
+    return impl_->publishNames(prefixes);
+  }
+
+  /**
+   * Set the delay after a publication before answering the pending sync
+   * Interests, so that a burst of publishName calls is coalesced. See
+   * FullPSync2017::setPublishDelay.
+   * @param publishDelay The delay in milliseconds. If 0 (the default), answer
+   * the pending sync Interests immediately.
+   */
+  void
+  setPublishDelay(Milliseconds publishDelay)
+  {
+    impl_->setPublishDelay(publishDelay);
+  }
+
+  /**
+   * Get the delay after a publication before answering the pending sync
+   * Interests.
+   * @return The delay in milliseconds.
+   */
+  Milliseconds
+  getPublishDelay() const { return impl_->getPublishDelay(); }
+
+  /**
+   * Get the number of published prefixes which did not need their own update
+   * of the pending sync Interests. See
+   * FullPSync2017::getNCoalescedPublications.
+   * @return The number of coalesced publications since this was created.
+   */
+  uint64_t
+  getNCoalescedPublications() const
+  {
+    return impl_->getNCoalescedPublications();
+  }
+
+  /**
+   * Set the codec for the IBLT in the sync Interests. See
+   * FullPSync2017::setIbltCodec.
+   * @param ibltCodec The FullPSync2017::IbltCodec.
+   */
+  void
+  setIbltCodec(FullPSync2017::IbltCodec ibltCodec)
+  {
+    impl_->setIbltCodec(ibltCodec);
+  }
+
+  /**
+   * Set the codec for the Names in the sync Data. See
+   * FullPSync2017::setStateCodec.
+   * @param stateCodec The FullPSync2017::StateCodec.
+   */
+  void
+  setStateCodec(FullPSync2017::StateCodec stateCodec)
+  {
+    impl_->setStateCodec(stateCodec);
+  }
+
+  /**
+   * Set how a published Name is hashed to the key in the IBLT. See
+   * FullPSync2017::setNameHashMode.
+   * @param nameHashMode The PSyncProducerBase::NameHashMode.
+   */
+  void
+  setNameHashMode(PSyncProducerBase::NameHashMode nameHashMode)
+  {
+    impl_->setNameHashMode(nameHashMode);
+  }
+
 private:
   /**
    * FullPSync2017WithUsers::Impl does the work of FullPSync2017WithUsers. It is a
@@ -174,6 +255,42 @@ private:
     void
     publishName(const Name& prefix, int sequenceNo);
 
+    size_t
+    publishNames(const std::vector<Name>& prefixes);
+
+    void
+    setPublishDelay(Milliseconds publishDelay)
+    {
+      fullPSync_->setPublishDelay(publishDelay);
+    }
+
+    Milliseconds
+    getPublishDelay() const { return fullPSync_->getPublishDelay(); }
+
+    uint64_t
+    getNCoalescedPublications() const
+    {
+      return fullPSync_->getNCoalescedPublications() + nRepeatedPrefixes_;
+    }
+
+    void
+    setIbltCodec(FullPSync2017::IbltCodec ibltCodec)
+    {
+      fullPSync_->setIbltCodec(ibltCodec);
+    }
+
+    void
+    setStateCodec(FullPSync2017::StateCodec stateCodec)
+    {
+      fullPSync_->setStateCodec(stateCodec);
+    }
+
+    void
+    setNameHashMode(PSyncProducerBase::NameHashMode nameHashMode)
+    {
+      fullPSync_->setNameHashMode(nameHashMode);
+    }
+
   private:
     /**
      * This is called when new names are received to check if the name can be
@@ -219,6 +336,9 @@ private:
     OnUpdate onUpdate_;
     ptr_lib::shared_ptr<FullPSync2017> fullPSync_;
     ptr_lib::shared_ptr<PSyncUserPrefixes> prefixes_;
+    // The number of times publishNames got a prefix which was already in the
+    // same list, so that only its last sequence number is published.
+    uint64_t nRepeatedPrefixes_;
   };
 
   ptr_lib::shared_ptr<Impl> impl_;
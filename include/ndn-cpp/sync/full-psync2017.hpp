@@ -23,6 +23,9 @@
 #ifndef NDN_FULL_PSYNC2017_HPP
 #define NDN_FULL_PSYNC2017_HPP
 
+#include <map>
+#include <set>
+#include <queue>
 #include "../face.hpp"
 #include "../util/segment-fetcher.hpp"
 #include "../security/key-chain.hpp"
@@ -31,6 +34,7 @@
 namespace ndn {
 
 class PSyncSegmentPublisher;
+class PSyncState;
 
 /**
  * FullPSync2017 implements the full sync logic of PSync to synchronize with
@@ -52,6 +56,31 @@ public:
     (const Name& name, const std::set<uint32_t>& negative)> CanAddToSyncData;
   typedef func_lib::function<bool(const Name& name)> CanAddReceivedName;
 
+  /**
+   * An IbltCodec specifies how the IBLT is encoded in the sync Interest name.
+   * IBLT_CODEC_ZLIB is the zlib-compressed array of all the buckets, which is
+   * the original PSync format. IBLT_CODEC_SPARSE encodes only the non-empty
+   * buckets, which is much faster and usually smaller. A sparse sync Interest
+   * has an extra name component before the IBLT so that the receiver knows how
+   * to decode it.
+   */
+  enum IbltCodec {
+    IBLT_CODEC_ZLIB = 0,
+    IBLT_CODEC_SPARSE = 1
+  };
+
+  /**
+   * A StateCodec specifies how the Names are encoded in the sync Data content.
+   * STATE_CODEC_NAMES is the list of full Names, which is the original PSync
+   * format. STATE_CODEC_DELTA sorts the Names and encodes each with only the
+   * components after the prefix it shares with the previous Name, which is
+   * much smaller when many Names have the same prefix.
+   */
+  enum StateCodec {
+    STATE_CODEC_NAMES = 0,
+    STATE_CODEC_DELTA = 1
+  };
+
   /**
    * Create a FullPSync2017.
    * @param expectedNEntries The expected number of entries in the IBLT.
@@ -112,6 +141,19 @@ public:
     impl_->publishName(name);
   }
 
+  /**
+   * Publish all the Names to inform the others, with one update of the
+   * pending sync Interests for the whole list instead of one for each Name.
+   * A Name which has already been published is skipped.
+   * @param names The list of Names to publish.
+   * @return The number of Names which were published.
+   */
+  size_t
+  publishNames(const std::vector<Name>& names)
+  {
+    return impl_->publishNames(names);
+  }
+
   /**
    * Remove the Name from the IBLT so that it won't be announced to other users.
    * @param name The Name to remove.
@@ -122,6 +164,97 @@ public:
     impl_->removeName(name);
   }
 
+  /**
+   * Set the delay after a publication before answering the pending sync
+   * Interests. The IBLT is updated immediately, but Names published during the
+   * delay are coalesced so that each pending sync Interest gets one reply for
+   * the whole burst.
+   * @param publishDelay The delay in milliseconds. If 0 (the default), answer
+   * the pending sync Interests immediately in publishName or publishNames.
+   */
+  void
+  setPublishDelay(Milliseconds publishDelay)
+  {
+    impl_->setPublishDelay(publishDelay);
+  }
+
+  /**
+   * Get the delay after a publication before answering the pending sync
+   * Interests.
+   * @return The delay in milliseconds.
+   */
+  Milliseconds
+  getPublishDelay() const { return impl_->getPublishDelay(); }
+
+  /**
+   * Get the number of published Names which did not need their own update of
+   * the pending sync Interests because they were coalesced with another Name,
+   * either by publishNames or by the publish delay.
+   * @return The number of coalesced publications since this was created.
+   */
+  uint64_t
+  getNCoalescedPublications() const
+  {
+    return impl_->getNCoalescedPublications();
+  }
+
+  /**
+   * Set the codec for the IBLT in the sync Interests that this sends, starting
+   * with the next sync Interest. Received sync Interests are always accepted
+   * in either codec. Because other PSync implementations only understand
+   * IBLT_CODEC_ZLIB, you should only set IBLT_CODEC_SPARSE if all members of
+   * the sync group use this library.
+   * @param ibltCodec The IbltCodec. The default is IBLT_CODEC_ZLIB.
+   */
+  void
+  setIbltCodec(IbltCodec ibltCodec) { impl_->setIbltCodec(ibltCodec); }
+
+  /**
+   * Get the codec for the IBLT in the sync Interests that this sends.
+   * @return The IbltCodec.
+   */
+  IbltCodec
+  getIbltCodec() const { return impl_->getIbltCodec(); }
+
+  /**
+   * Set the codec for the Names in the sync Data that this sends. Received
+   * sync Data is always accepted in either codec. Because other PSync
+   * implementations only understand STATE_CODEC_NAMES, you should only set
+   * STATE_CODEC_DELTA if all members of the sync group use this library.
+   * @param stateCodec The StateCodec. The default is STATE_CODEC_NAMES.
+   */
+  void
+  setStateCodec(StateCodec stateCodec) { impl_->setStateCodec(stateCodec); }
+
+  /**
+   * Get the codec for the Names in the sync Data that this sends.
+   * @return The StateCodec.
+   */
+  StateCodec
+  getStateCodec() const { return impl_->getStateCodec(); }
+
+  /**
+   * Set how a published Name is hashed to the key in the IBLT. If it is
+   * different, this re-hashes the names which are already published. All
+   * members of the sync group must use the same NameHashMode. Because other
+   * PSync implementations only use NAME_HASH_URI, you should only set
+   * NAME_HASH_TLV if all members of the sync group use this library.
+   * @param nameHashMode The PSyncProducerBase::NameHashMode. The default is
+   * PSyncProducerBase::NAME_HASH_URI.
+   */
+  void
+  setNameHashMode(PSyncProducerBase::NameHashMode nameHashMode)
+  {
+    impl_->setNameHashMode(nameHashMode);
+  }
+
+  /**
+   * Get how a published Name is hashed to the key in the IBLT.
+   * @return The PSyncProducerBase::NameHashMode.
+   */
+  PSyncProducerBase::NameHashMode
+  getNameHashMode() const { return impl_->getNameHashMode(); }
+
   static const int DEFAULT_SYNC_INTEREST_LIFETIME = 1000;
   static const int DEFAULT_SYNC_REPLY_FRESHNESS_PERIOD = 1000;
 
@@ -155,29 +288,232 @@ private:
     void
     publishName(const Name& name);
 
+    size_t
+    publishNames(const std::vector<Name>& names);
+
+    void
+    removeName(const Name& name);
+
+    void
+    setPublishDelay(Milliseconds publishDelay) { publishDelay_ = publishDelay; }
+
+    Milliseconds
+    getPublishDelay() const { return publishDelay_; }
+
+    uint64_t
+    getNCoalescedPublications() const { return nCoalescedPublications_; }
+
+    void
+    setIbltCodec(IbltCodec ibltCodec) { ibltCodec_ = ibltCodec; }
+
+    IbltCodec
+    getIbltCodec() const { return ibltCodec_; }
+
+    /**
+     * Set stateCodec_, and then invalidate the cached full state segments and
+     * the cached reply of each PendingDifference since they use the previous
+     * codec.
+     */
+    void
+    setStateCodec(StateCodec stateCodec);
+
+    StateCodec
+    getStateCodec() const { return stateCodec_; }
+
+    /**
+     * Call PSyncProducerBase::setNameHashMode, and then invalidate the cached
+     * differences since all the hashes in our IBLT may have changed.
+     */
     void
-    removeName(const Name& name) { removeFromIblt(name); }
+    setNameHashMode(PSyncProducerBase::NameHashMode nameHashMode);
 
   private:
+    /**
+     * A PendingDifference has the IBLT received in one or more pending sync
+     * Interests and caches the difference of it from our IBLT, so that the
+     * difference is computed once for each distinct IBLT. When our IBLT
+     * changes, the difference is updated from ibltChanges_ instead of
+     * subtracting the IBLTs again.
+     */
+    class PendingDifference {
+    public:
+      PendingDifference
+        (const ptr_lib::shared_ptr<InvertibleBloomLookupTable>& iblt)
+      : iblt_(iblt), isComplete_(false), ibltVersion_(0), nEntries_(0),
+        segmentsVersion_(NO_SEGMENTS_VERSION)
+      {}
+
+      // A segmentsVersion_ which never equals the ibltVersion_ of our IBLT, so
+      // that the reply is made again.
+      static const uint64_t NO_SEGMENTS_VERSION = (uint64_t)-1;
+
+      ptr_lib::shared_ptr<InvertibleBloomLookupTable> iblt_;
+      // The hashes in our IBLT but not in iblt_.
+      std::set<uint32_t> positive_;
+      // The hashes in iblt_ but not in our IBLT.
+      std::set<uint32_t> negative_;
+      // False if listEntries could not decode the whole difference, so that it
+      // must be computed again.
+      bool isComplete_;
+      // The ibltVersion_ of our IBLT when positive_ and negative_ were updated.
+      uint64_t ibltVersion_;
+      // The number of entries in pendingEntries_ which have this difference.
+      size_t nEntries_;
+      // The reply for positive_, made at segmentsVersion_ of our IBLT.
+      std::vector<Blob> segments_;
+      uint64_t segmentsVersion_;
+    };
+
     class PendingEntryInfoFull {
     public:
       PendingEntryInfoFull
-        (const ptr_lib::shared_ptr<InvertibleBloomLookupTable> iblt)
-      : iblt_(iblt), isRemoved_(false)
+        (const Name& name,
+         const ptr_lib::shared_ptr<PendingDifference>& difference,
+         MillisecondsSince1970 expirationTime)
+      : name_(name), difference_(difference), expirationTime_(expirationTime)
       {}
 
-      ptr_lib::shared_ptr<InvertibleBloomLookupTable> iblt_;
-      bool isRemoved_;
+      Name name_;
+      ptr_lib::shared_ptr<PendingDifference> difference_;
+      MillisecondsSince1970 expirationTime_;
+    };
+
+    /**
+     * ExpiresLater is the comparison for pendingExpirations_ so that the top of
+     * the heap is the entry which expires first.
+     */
+    class ExpiresLater {
+    public:
+      bool
+      operator()
+        (const ptr_lib::shared_ptr<PendingEntryInfoFull>& entry1,
+         const ptr_lib::shared_ptr<PendingEntryInfoFull>& entry2) const
+      {
+        return entry1->expirationTime_ > entry2->expirationTime_;
+      }
     };
 
+    typedef std::map<Name, ptr_lib::shared_ptr<PendingEntryInfoFull> >
+      PendingEntryMap;
+
+    /**
+     * This is called after nPublished Names are inserted into the IBLT. If
+     * publishDelay_ is zero, call satisfyPendingInterests now. Otherwise, if it
+     * is not already scheduled, schedule onPublishDelay. Update
+     * nCoalescedPublications_.
+     * @param nPublished The number of Names which were inserted.
+     */
+    void
+    onPublished(size_t nPublished);
+
+    /**
+     * This is called by face_.callLater after publishDelay_ to answer the
+     * pending sync Interests for the Names published in the meantime.
+     */
+    void
+    onPublishDelay();
+
+    /**
+     * Call insertIntoIblt and record the change in ibltChanges_.
+     * @param name The Name to insert.
+     */
+    void
+    insertName(const Name& name);
+
+    /**
+     * Increment ibltVersion_ and, if there are pending differences to update,
+     * append the change to ibltChanges_.
+     * @param hash The hash which was inserted into or erased from our IBLT.
+     * @param isInsert True if the hash was inserted, false if erased.
+     */
+    void
+    onIbltChanged(uint32_t hash, bool isInsert);
+
+    /**
+     * Update the cached difference to our current IBLT, by applying
+     * ibltChanges_ if possible, or else by computing the difference of the
+     * IBLTs.
+     * @param difference The PendingDifference to update.
+     * @return False if the difference is not decodable and the pending entries
+     * for it should be erased, otherwise true.
+     */
+    bool
+    updateDifference(PendingDifference& difference);
+
+    /**
+     * Add a pending entry for the sync Interest. If there is already a
+     * PendingDifference with an equal IBLT, use it. Otherwise make a new one
+     * with the difference which onSyncInterest already decoded.
+     * @param interestName The pending sync Interest name /<prefix>/IBLT.
+     * @param iblt The received IBLT.
+     * @param isComplete The result of listEntries for the difference.
+     * @param positive The positive entries from listEntries.
+     * @param negative The negative entries from listEntries.
+     * @param interestLifetime The lifetime of the sync Interest in milliseconds.
+     */
+    void
+    addPendingEntry
+      (const Name& interestName,
+       const ptr_lib::shared_ptr<InvertibleBloomLookupTable>& iblt,
+       bool isComplete, const std::vector<uint32_t>& positive,
+       const std::vector<uint32_t>& negative, Milliseconds interestLifetime);
+
+    /**
+     * Erase the entry from pendingEntries_, and erase its PendingDifference
+     * from pendingDifferences_ if no other entry has it.
+     * @param entry The iterator in pendingEntries_. This is invalidated.
+     */
+    void
+    erasePendingEntry(PendingEntryMap::iterator entry);
+
+    /**
+     * If the first entry in pendingExpirations_ expires before the currently
+     * scheduled timer, schedule onPendingExpirationTimer.
+     */
+    void
+    schedulePendingExpiration();
+
+    /**
+     * This is called by face_.callLater to erase the pending entries which have
+     * expired, and schedule the timer for the next one.
+     * @param scheduledTime The value of scheduledExpirationTime_ when this was
+     * scheduled.
+     */
+    void
+    onPendingExpirationTimer(MillisecondsSince1970 scheduledTime);
+
+    /**
+     * Get the name component which is put before the IBLT in a sync Interest
+     * name to show that it uses IBLT_CODEC_SPARSE.
+     */
+    static const Name::Component&
+    getSparseIbltMarker();
+
     /**
      * Send the sync interest for full synchronization. This forms the interest
-     * name: /<sync-prefix>/<own-IBLT>. This cancels any pending sync interest
+     * name: /<sync-prefix>/<own-IBLT>, or /<sync-prefix>/<marker>/<own-IBLT>
+     * if ibltCodec_ is IBLT_CODEC_SPARSE. This cancels any pending sync interest
      * we sent earlier on the face.
      */
     void
     sendSyncInterest();
 
+    /**
+     * Get the encoding of our IBLT using ibltCodec_. The IBLT caches the
+     * encoding until it changes.
+     * @return The encoding.
+     */
+    Blob
+    encodeIblt() const;
+
+    /**
+     * Encode the state using stateCodec_ as the content of segments.
+     * @param state The PSyncState to encode.
+     * @param segments Append the segment contents to this list.
+     */
+    void
+    encodeState(const PSyncState& state, std::vector<Blob>& segments) const;
+
     /**
      * Process a sync interest received from another party.
      * This gets the difference between our IBLT and the IBLT in the other sync
@@ -205,10 +541,11 @@ private:
      * Interest. If it does, then remove it and then renew the sync interest.
      * Otherwise, just send the Data.
      * @param name The basis to use for the Data name.
-     * @param content The content of the Data.
+     * @param segments The content of each segment of the Data, from
+     * encodeState.
      */
     void
-    sendSyncData(const Name& name, Blob content);
+    sendSyncData(const Name& name, const std::vector<Blob>& segments);
 
     /**
      * Process the sync data after the content is assembled by the
@@ -227,10 +564,11 @@ private:
     onSyncData(Blob encodedContent, ptr_lib::shared_ptr<Interest>& interest);
 
     /**
-     * Satisfy pending sync Interests. For a pending sync interests, if the
-     * IBLT of the sync Interest has any difference from our own IBLT, then
-     * send a Data back. If we can't decode the difference from the stored IBLT,
-     * then delete it.
+     * Satisfy pending sync Interests. First update the difference of each
+     * distinct pending IBLT from our own IBLT. Then for each pending sync
+     * Interest, if its difference has any names which we have, then send a
+     * Data back. If we can't decode the difference from the stored IBLT, then
+     * delete it.
      */
     void
     satisfyPendingInterests();
@@ -241,31 +579,44 @@ private:
     void
     deletePendingInterests(const Name& interestName);
 
-    /**
-     * Remove the entry from pendingEntries_ which has the name. However, if
-     * entry->isRemoved_ is true, do nothing. Therefore, if an entry is
-     * directly removed from pendingEntries_, it should set isRemoved_.
-     * @param name The key in the pendingEntries_ map for the entry to remove.
-     * @param entry A (possibly earlier and removed) entry from when it was
-     * inserted into the pendingEntries_ map.
-     * @param nonce This is only used for the log message.
-     */
-    void
-    delayedRemovePendingEntry
-      (const Name& name, const ptr_lib::shared_ptr<PendingEntryInfoFull>& entry,
-       const Blob& nonce);
-
     Face& face_;
     KeyChain& keyChain_;
     SigningInfo signingInfo_;
     ptr_lib::shared_ptr<PSyncSegmentPublisher> segmentPublisher_;
-    std::map<Name, ptr_lib::shared_ptr<PendingEntryInfoFull> > pendingEntries_;
+    PendingEntryMap pendingEntries_;
+    // The key is the PendingDifference iblt_->hash(). Equal IBLTs share a
+    // PendingDifference.
+    std::unordered_multimap<uint32_t, ptr_lib::shared_ptr<PendingDifference> >
+      pendingDifferences_;
+    // The pending entries by expiration time. An entry which was already
+    // erased from pendingEntries_ is ignored when it expires.
+    std::priority_queue
+      <ptr_lib::shared_ptr<PendingEntryInfoFull>,
+       std::vector<ptr_lib::shared_ptr<PendingEntryInfoFull> >, ExpiresLater>
+      pendingExpirations_;
+    // The time of the onPendingExpirationTimer call, or 0 if none.
+    MillisecondsSince1970 scheduledExpirationTime_;
+    // This is incremented on each change to our IBLT.
+    uint64_t ibltVersion_;
+    // The changes to our IBLT since version ibltChangesVersion_, as the hash
+    // and true for insert or false for erase.
+    std::vector<std::pair<uint32_t, bool> > ibltChanges_;
+    uint64_t ibltChangesVersion_;
     Milliseconds syncInterestLifetime_;
     OnNamesUpdate onNamesUpdate_;
     CanAddToSyncData canAddToSyncData_;
     CanAddReceivedName canAddReceivedName_;
     Name outstandingInterestName_;
     uint64_t registeredPrefix_;
+    IbltCodec ibltCodec_;
+    StateCodec stateCodec_;
+    // The segments of the full state for a sync Interest whose difference
+    // can't be decoded, and the encoding of our IBLT when they were made.
+    std::vector<Blob> fullStateSegments_;
+    Blob fullStateIbltEncoding_;
+    Milliseconds publishDelay_;
+    bool isPublishScheduled_;
+    uint64_t nCoalescedPublications_;
   };
 
   ptr_lib::shared_ptr<Impl> impl_;
@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ * @author: From the PSync library https://github.com/named-data/PSync/blob/master/PSync/consumer.hpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_PARTIAL_PSYNC2017_CONSUMER_HPP
+#define NDN_PARTIAL_PSYNC2017_CONSUMER_HPP
+
+#include <map>
+#include <vector>
+#include "../face.hpp"
+#include "../util/segment-fetcher.hpp"
+#include "psync-missing-data-info.hpp"
+
+namespace ndn {
+
+class BloomFilter;
+
+/**
+ * PartialPSync2017Consumer implements the consumer side of the partial sync
+ * logic of PSync. It sends a hello Interest to a PartialPSync2017Producer to
+ * get all the user prefixes with their latest sequence numbers and the
+ * producer's IBLT. The application adds subscriptions for some of the prefixes
+ * and calls sendSyncInterest. This sends a sync Interest with a Bloom filter of
+ * the subscribed prefixes and the latest IBLT from the producer, and calls
+ * onUpdate when the producer replies with new sequence numbers for subscribed
+ * prefixes. Fetching the data (named by the user prefix plus the sequence
+ * number) needs to be handled by the application. The Partial PSync protocol
+ * is described in Section IV "Partial-Data Synchronization" of:
+ * https://named-data.net/wp-content/uploads/2017/05/scalable_name-based_data_synchronization.pdf
+ * (Note: In the PSync library, this class is called Consumer.)
+ */
+class PartialPSync2017Consumer {
+public:
+  typedef func_lib::function<void
+    (const std::map<Name, int>& availableSubscriptions)> OnReceiveHelloData;
+
+  typedef func_lib::function<void
+    (const ptr_lib::shared_ptr<std::vector<ptr_lib::shared_ptr<PSyncMissingDataInfo>>>& updates)> OnUpdate;
+
+  /**
+   * Create a PartialPSync2017Consumer. This does not send any Interest. Call
+   * sendHelloInterest to start.
+   * @param syncPrefix The prefix Name of the sync group, which is copied.
+   * @param face The application's Face.
+   * @param onReceiveHelloData When the hello Data is received, this calls
+   * onReceiveHelloData(availableSubscriptions) where availableSubscriptions is
+   * the map of each user prefix and its latest sequence number. The
+   * application would normally call addSubscription for the prefixes it wants,
+   * then call sendSyncInterest.
+   * NOTE: The library will log any exceptions thrown by this callback, but for
+   * better error handling the callback should catch and properly handle any
+   * exceptions.
+   * @param onUpdate When there are new sequence numbers for subscribed
+   * prefixes, this calls onUpdate(updates) where updates is the list of
+   * PSyncMissingDataInfo.
+   * NOTE: The library will log any exceptions thrown by this callback, but for
+   * better error handling the callback should catch and properly handle any
+   * exceptions.
+   * @param bloomFilterCount The expected number of subscriptions in the Bloom
+   * filter.
+   * @param bloomFilterFalsePositiveProbability The false positive probability
+   * of the Bloom filter, such as 0.001.
+   * @param helloInterestLifetime (optional) The lifetime of the hello
+   * Interest, in milliseconds. If omitted, use DEFAULT_HELLO_INTEREST_LIFETIME.
+   * @param syncInterestLifetime (optional) The lifetime of the sync Interest,
+   * in milliseconds. If omitted, use DEFAULT_SYNC_INTEREST_LIFETIME.
+   */
+  PartialPSync2017Consumer
+    (const Name& syncPrefix, Face& face,
+     const OnReceiveHelloData& onReceiveHelloData, const OnUpdate& onUpdate,
+     size_t bloomFilterCount, double bloomFilterFalsePositiveProbability,
+     Milliseconds helloInterestLifetime = DEFAULT_HELLO_INTEREST_LIFETIME,
+     Milliseconds syncInterestLifetime = DEFAULT_SYNC_INTEREST_LIFETIME)
+  : impl_(new Impl
+          (syncPrefix, face, onReceiveHelloData, onUpdate, bloomFilterCount,
+           bloomFilterFalsePositiveProbability, helloInterestLifetime,
+           syncInterestLifetime))
+  {
+  }
+
+  /**
+   * Send the hello Interest /<sync-prefix>/hello to get the available
+   * subscriptions and the producer's IBLT.
+   */
+  void
+  sendHelloInterest() { impl_->sendHelloInterest(); }
+
+  /**
+   * Send the sync Interest /<sync-prefix>/sync/<BF>/<producers-IBLT> for the
+   * subscriptions. When the reply is received, this calls onUpdate and sends
+   * the next sync Interest.
+   * @throws runtime_error if the hello Data has not yet been received.
+   */
+  void
+  sendSyncInterest() { impl_->sendSyncInterest(); }
+
+  /**
+   * Add the prefix to the subscriptions and to the Bloom filter. This takes
+   * effect with the next sync Interest. If the prefix is already subscribed,
+   * do nothing.
+   * @param prefix The user prefix to subscribe to.
+   * @param sequenceNo (optional) The latest sequence number that the
+   * application already has for the prefix, such as from the
+   * availableSubscriptions given to onReceiveHelloData. If omitted, use 0.
+   * @return True if the prefix was added, false if it is already subscribed.
+   */
+  bool
+  addSubscription(const Name& prefix, int sequenceNo = 0)
+  {
+    return impl_->addSubscription(prefix, sequenceNo);
+  }
+
+  /**
+   * Remove the prefix from the subscriptions and rebuild the Bloom filter.
+   * This takes effect with the next sync Interest. If the prefix is not
+   * subscribed, do nothing.
+   * @param prefix The user prefix to unsubscribe.
+   * @return True if the prefix was removed, false if it is not subscribed.
+   */
+  bool
+  removeSubscription(const Name& prefix)
+  {
+    return impl_->removeSubscription(prefix);
+  }
+
+  /**
+   * Check if the prefix is in the subscriptions.
+   * @param prefix The user prefix to check.
+   * @return True if the prefix is subscribed.
+   */
+  bool
+  isSubscribed(const Name& prefix) const { return impl_->isSubscribed(prefix); }
+
+  /**
+   * Get the latest sequence number of the subscribed prefix.
+   * @param prefix The user prefix.
+   * @return The sequence number, or -1 if the prefix is not subscribed.
+   */
+  int
+  getSequenceNo(const Name& prefix) const
+  {
+    return impl_->getSequenceNo(prefix);
+  }
+
+  static const int DEFAULT_HELLO_INTEREST_LIFETIME = 1000;
+  static const int DEFAULT_SYNC_INTEREST_LIFETIME = 1000;
+
+private:
+  /**
+   * PartialPSync2017Consumer::Impl does the work of PartialPSync2017Consumer.
+   * It is a separate class so that PartialPSync2017Consumer can create an
+   * instance in a shared_ptr to use in callbacks.
+   */
+  class Impl : public ptr_lib::enable_shared_from_this<Impl> {
+  public:
+    /**
+     * Create a new Impl, which should belong to a shared_ptr. See the
+     * PartialPSync2017Consumer constructor for parameter documentation.
+     */
+    Impl
+      (const Name& syncPrefix, Face& face,
+       const OnReceiveHelloData& onReceiveHelloData, const OnUpdate& onUpdate,
+       size_t bloomFilterCount, double bloomFilterFalsePositiveProbability,
+       Milliseconds helloInterestLifetime, Milliseconds syncInterestLifetime);
+
+    void
+    sendHelloInterest();
+
+    void
+    sendSyncInterest();
+
+    bool
+    addSubscription(const Name& prefix, int sequenceNo);
+
+    bool
+    removeSubscription(const Name& prefix);
+
+    bool
+    isSubscribed(const Name& prefix) const
+    {
+      return subscriptions_.find(prefix) != subscriptions_.end();
+    }
+
+    int
+    getSequenceNo(const Name& prefix) const;
+
+  private:
+    /**
+     * This is called by SegmentFetcher for each segment to save the Data name
+     * without the version and segment. The segments are not verified.
+     * @param data The segment Data packet.
+     * @param dataName Set this to the Data name without the version and
+     * segment.
+     * @return True.
+     */
+    static bool
+    saveDataName
+      (const ptr_lib::shared_ptr<Data>& data,
+       const ptr_lib::shared_ptr<Name>& dataName);
+
+    /**
+     * Process the hello Data by saving the producer's IBLT from the last
+     * component of the Data name and calling onReceiveHelloData_.
+     * @param encodedContent The encoded PSyncState.
+     * @param dataName The hello Data name without the version and segment.
+     */
+    void
+    onHelloData
+      (const Blob& encodedContent, const ptr_lib::shared_ptr<Name>& dataName);
+
+    /**
+     * Process the sync Data by saving the producer's IBLT, calling onUpdate_
+     * for the new sequence numbers of subscribed prefixes, and sending the
+     * next sync Interest.
+     * @param encodedContent The encoded PSyncState.
+     * @param dataName The sync Data name without the version and segment.
+     * @param generation The syncGeneration_ when the sync Interest was sent.
+     */
+    void
+    onSyncData
+      (const Blob& encodedContent, const ptr_lib::shared_ptr<Name>& dataName,
+       uint64_t generation);
+
+    void
+    onHelloError
+      (SegmentFetcher::ErrorCode errorCode, const std::string& message);
+
+    /**
+     * Log the error, and if this is for the latest sync Interest, send another
+     * after a random delay.
+     */
+    void
+    onSyncError
+      (SegmentFetcher::ErrorCode errorCode, const std::string& message,
+       uint64_t generation);
+
+    /**
+     * Call sendSyncInterest if generation is still the latest.
+     */
+    void
+    sendSyncInterestIfCurrent(uint64_t generation);
+
+    Name syncPrefix_;
+    Face& face_;
+    OnReceiveHelloData onReceiveHelloData_;
+    OnUpdate onUpdate_;
+    Milliseconds helloInterestLifetime_;
+    Milliseconds syncInterestLifetime_;
+    ptr_lib::shared_ptr<BloomFilter> bloomFilter_;
+    // The last name component from the producer's hello or sync Data.
+    Name::Component iblt_;
+    bool haveIblt_;
+    // The key is the prefix. The value is the latest sequence number.
+    std::map<Name, int> subscriptions_;
+    // syncGeneration_ is incremented for each sync Interest so that a reply or
+    // error for an older one doesn't send an extra sync Interest.
+    uint64_t syncGeneration_;
+  };
+
+  ptr_lib::shared_ptr<Impl> impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ * @author: From the PSync library https://github.com/named-data/PSync/blob/master/PSync/partial-producer.hpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_PARTIAL_PSYNC2017_PRODUCER_HPP
+#define NDN_PARTIAL_PSYNC2017_PRODUCER_HPP
+
+#include <map>
+#include "../face.hpp"
+#include "../security/key-chain.hpp"
+#include "psync-producer-base.hpp"
+
+namespace ndn {
+
+class PSyncSegmentPublisher;
+class PSyncUserPrefixes;
+class BloomFilter;
+
+/**
+ * PartialPSync2017Producer implements the producer side of the partial sync
+ * logic of PSync, where a consumer only wants the updates of the user prefixes
+ * that it subscribes to. A PartialPSync2017Consumer sends a hello Interest to
+ * get all the user prefixes and their latest sequence numbers, then sends sync
+ * Interests with a Bloom filter of its subscriptions and the IBLT from the last
+ * reply. This answers a sync Interest with the new sequence numbers of the
+ * subscribed prefixes, or holds it until publishName updates one of them. The
+ * application should call publishName whenever it wants to let consumers know
+ * that new data with a new sequence number is available for the user prefix.
+ * Multiple user prefixes can be added by using addUserNode. Fetching and
+ * publishing the data (named by the user prefix plus the sequence number)
+ * needs to be handled by the application. The Partial PSync protocol is
+ * described in Section IV "Partial-Data Synchronization" of:
+ * https://named-data.net/wp-content/uploads/2017/05/scalable_name-based_data_synchronization.pdf
+ * (Note: In the PSync library, this class is called PartialProducer.)
+ */
+class PartialPSync2017Producer {
+public:
+  /**
+   * Create a PartialPSync2017Producer.
+   * @param expectedNEntries The expected number of entries in the IBLT.
+   * @param face The application's Face.
+   * @param syncPrefix The prefix Name of the sync group, which is copied.
+   * @param userPrefix The prefix Name of the first user in the group, which is
+   * copied. However, if this Name is empty, it is not added and you must call
+   * addUserNode.
+   * @param keyChain The KeyChain for signing Data packets.
+   * @param helloReplyFreshnessPeriod (optional) The freshness period of the
+   * hello Data packet, in milliseconds. If omitted, use
+   * DEFAULT_HELLO_REPLY_FRESHNESS_PERIOD.
+   * @param syncReplyFreshnessPeriod (optional) The freshness period of the sync
+   * Data packet, in milliseconds. If omitted, use
+   * DEFAULT_SYNC_REPLY_FRESHNESS_PERIOD.
+   * @param signingInfo (optional) The SigningInfo for signing Data packets,
+   * which is copied. If omitted, use the default SigningInfo().
+   */
+  PartialPSync2017Producer
+    (size_t expectedNEntries, Face& face, const Name& syncPrefix,
+     const Name& userPrefix, KeyChain& keyChain,
+     Milliseconds helloReplyFreshnessPeriod = DEFAULT_HELLO_REPLY_FRESHNESS_PERIOD,
+     Milliseconds syncReplyFreshnessPeriod = DEFAULT_SYNC_REPLY_FRESHNESS_PERIOD,
+     const SigningInfo& signingInfo = SigningInfo())
+  : impl_(new Impl
+          (expectedNEntries, face, syncPrefix, keyChain,
+           helloReplyFreshnessPeriod, syncReplyFreshnessPeriod, signingInfo))
+  {
+    impl_->initialize(userPrefix);
+  }
+
+  /**
+   * Return the current sequence number of the given prefix.
+   * @param prefix The prefix for the sequence number.
+   * @return The sequence number for the prefix, or -1 if not found.
+   */
+  int
+  getSequenceNo(const Name& prefix) const
+  {
+    return impl_->getSequenceNo(prefix);
+  }
+
+  /**
+   * Add a user node for synchronization based on the prefix Name, and
+   * initialize the sequence number to zero. However, if the prefix Name already
+   * exists, then do nothing and return false.
+   * @param prefix The prefix Name of the user node to be added.
+   * @return True if the user node with the prefix Name was added, false if the
+   * prefix Name already exists.
+   */
+  bool
+  addUserNode(const Name& prefix) { return impl_->addUserNode(prefix); }
+
+  /**
+   * Remove the user node from the synchronization. This erases the prefix from
+   * the IBLT and other tables.
+   * @param prefix The prefix Name of the user node to be removed. If there is
+   * no user node with this prefix, do nothing.
+   */
+  void
+  removeUserNode(const Name& prefix) { impl_->removeUserNode(prefix); }
+
+  /**
+   * Publish the sequence number for the prefix Name to inform the consumers
+   * which subscribe to it. (addUserNode needs to be called before this to add
+   * the prefix, if it was not already added via the constructor.)
+   * @param prefix the prefix Name to be updated.
+   * @param sequenceNo (optional) The sequence number of the user prefix to be
+   * set in the IBLT. However, if sequenceNo is omitted or -1, then the existing
+   * sequence number is incremented by 1.
+   */
+  void
+  publishName(const Name& prefix, int sequenceNo = -1)
+  {
+    impl_->publishName(prefix, sequenceNo);
+  }
+
+  /**
+   * Get the name component "hello" which follows the sync prefix in a hello
+   * Interest.
+   * @return The name component.
+   */
+  static const Name::Component&
+  getHelloComponent();
+
+  /**
+   * Get the name component "sync" which follows the sync prefix in a sync
+   * Interest.
+   * @return The name component.
+   */
+  static const Name::Component&
+  getSyncComponent();
+
+  static const int DEFAULT_HELLO_REPLY_FRESHNESS_PERIOD = 1000;
+  static const int DEFAULT_SYNC_REPLY_FRESHNESS_PERIOD = 1000;
+
+private:
+  /**
+   * PartialPSync2017Producer::Impl does the work of PartialPSync2017Producer.
+   * It is a separate class so that PartialPSync2017Producer can create an
+   * instance in a shared_ptr to use in callbacks.
+   */
+  class Impl : public PSyncProducerBase {
+  public:
+    /**
+     * Create a new Impl, which should belong to a shared_ptr. Then you must
+     * call initialize(). See the PartialPSync2017Producer constructor for
+     * parameter documentation.
+     */
+    Impl
+      (size_t expectedNEntries, Face& face, const Name& syncPrefix,
+       KeyChain& keyChain, Milliseconds helloReplyFreshnessPeriod,
+       Milliseconds syncReplyFreshnessPeriod, const SigningInfo& signingInfo);
+
+    /**
+     * Complete the work of the constructor. This is needed because we can't
+     * call shared_from_this() in the constructor.
+     * @param userPrefix The prefix Name of the first user, or an empty Name.
+     */
+    void
+    initialize(const Name& userPrefix);
+
+    int
+    getSequenceNo(const Name& prefix) const;
+
+    bool
+    addUserNode(const Name& prefix);
+
+    void
+    removeUserNode(const Name& prefix);
+
+    void
+    publishName(const Name& prefix, int sequenceNo);
+
+  private:
+    class PendingEntryInfo {
+    public:
+      PendingEntryInfo
+        (const ptr_lib::shared_ptr<BloomFilter>& bloomFilter,
+         const ptr_lib::shared_ptr<InvertibleBloomLookupTable>& iblt)
+      : bloomFilter_(bloomFilter), iblt_(iblt), isRemoved_(false)
+      {}
+
+      ptr_lib::shared_ptr<BloomFilter> bloomFilter_;
+      ptr_lib::shared_ptr<InvertibleBloomLookupTable> iblt_;
+      bool isRemoved_;
+    };
+
+    /**
+     * This is called when an Interest is received for the sync prefix. Reply
+     * from the segment store if possible, else call onHelloInterest or
+     * onSyncInterest.
+     */
+    void
+    onInterest
+      (const ptr_lib::shared_ptr<const Name>& prefixName,
+       const ptr_lib::shared_ptr<const Interest>& interest, Face& face,
+       uint64_t interestFilterId,
+       const ptr_lib::shared_ptr<const InterestFilter>& filter);
+
+    /**
+     * Process a hello Interest /<sync-prefix>/hello by replying with the
+     * latest sequence number of all user prefixes. The Data name is
+     * /<sync-prefix>/hello/<own-IBLT>/<version>/<segment>.
+     * @param interest The received Interest.
+     * @param syncPrefixSize The number of components in the sync prefix.
+     */
+    void
+    onHelloInterest(const Interest& interest, size_t syncPrefixSize);
+
+    /**
+     * Process a sync Interest /<sync-prefix>/sync/<BF>/<old-IBLT> where <BF>
+     * is the three components from BloomFilter::appendToName. If our IBLT has
+     * names which are not in the old IBLT and whose prefix is in the Bloom
+     * filter, then reply with them. If we cannot get the difference, reply
+     * with all the names whose prefix is in the Bloom filter. Otherwise add the
+     * Interest to pendingEntries_. The Data name is
+     * /<sync-prefix>/sync/<BF>/<old-IBLT>/<own-IBLT>/<version>/<segment>.
+     * @param interest The received Interest.
+     * @param syncPrefixSize The number of components in the sync prefix.
+     */
+    void
+    onSyncInterest(const Interest& interest, size_t syncPrefixSize);
+
+    /**
+     * Publish the sync Data with our IBLT appended to the Interest name.
+     * @param interestName The sync Interest name.
+     * @param content The encoded PSyncState with the content names.
+     */
+    void
+    sendSyncData(const Name& interestName, Blob content);
+
+    /**
+     * Satisfy the pending sync Interests whose Bloom filter has the prefix,
+     * or where the difference is too large so that the consumer should get
+     * our latest IBLT.
+     * @param prefix The prefix which was just updated.
+     */
+    void
+    satisfyPendingSyncInterests(const Name& prefix);
+
+    /**
+     * Remove the entry from pendingEntries_ which has the name. However, if
+     * entry->isRemoved_ is true, do nothing. Therefore, if an entry is
+     * directly removed from pendingEntries_, it should set isRemoved_.
+     * @param name The key in the pendingEntries_ map for the entry to remove.
+     * @param entry A (possibly earlier and removed) entry from when it was
+     * inserted into the pendingEntries_ map.
+     */
+    void
+    delayedRemovePendingEntry
+      (const Name& name, const ptr_lib::shared_ptr<PendingEntryInfo>& entry);
+
+    Face& face_;
+    KeyChain& keyChain_;
+    SigningInfo signingInfo_;
+    Milliseconds helloReplyFreshnessPeriod_;
+    ptr_lib::shared_ptr<PSyncSegmentPublisher> segmentPublisher_;
+    ptr_lib::shared_ptr<PSyncUserPrefixes> prefixes_;
+    std::map<Name, ptr_lib::shared_ptr<PendingEntryInfo> > pendingEntries_;
+    uint64_t registeredPrefix_;
+  };
+
+  ptr_lib::shared_ptr<Impl> impl_;
+};
+
+}
+
+#endif
@@ -23,7 +23,7 @@
 #ifndef NDN_PSYNC_PRODUCER_BASE_HPP
 #define NDN_PSYNC_PRODUCER_BASE_HPP
 
-#include <map>
+#include <unordered_map>
 #include "../name.hpp"
 
 namespace ndn {
@@ -35,6 +35,43 @@ class InvertibleBloomLookupTable;
  * FullPSync2017::Impl.
  */
 class PSyncProducerBase : public ptr_lib::enable_shared_from_this<PSyncProducerBase> {
+public:
+  /**
+   * A NameHashMode specifies how a Name is hashed to the key in the IBLT.
+   * NAME_HASH_URI hashes name.toUri(), which is the original PSync method.
+   * NAME_HASH_TLV hashes the TLV wire encoding of the Name, which is much
+   * faster because it doesn't escape each component into a string. All members
+   * of a sync group must use the same NameHashMode.
+   */
+  enum NameHashMode {
+    NAME_HASH_URI = 0,
+    NAME_HASH_TLV = 1
+  };
+
+  /**
+   * Get the hash of the Name to use as the key in the IBLT.
+   * @param name The Name to hash.
+   * @param nameHashMode The NameHashMode.
+   * @return The hash.
+   */
+  static uint32_t
+  hashName(const Name& name, NameHashMode nameHashMode);
+
+  /**
+   * Set the NameHashMode. If it is different, this re-hashes the names which
+   * are already in the IBLT.
+   * @param nameHashMode The NameHashMode. The default is NAME_HASH_URI.
+   */
+  void
+  setNameHashMode(NameHashMode nameHashMode);
+
+  /**
+   * Get the NameHashMode.
+   * @return The NameHashMode.
+   */
+  NameHashMode
+  getNameHashMode() const { return nameHashMode_; }
+
 protected:
   /**
    * Create a PSyncProducerBase.
@@ -48,7 +85,16 @@ protected:
      Milliseconds syncReplyFreshnessPeriod);
 
   /**
-   * Insert the URI of the name into the iblt_, and update nameToHash_ and
+   * A NameHash is the hash function for nameToHash_.
+   */
+  class NameHash {
+  public:
+    size_t
+    operator() (const Name& name) const { return name.hash(); }
+  };
+
+  /**
+   * Insert the hash of the name into the iblt_, and update nameToHash_ and
    * hashToName_.
    * @param name The Name to insert.
    */
@@ -79,13 +125,14 @@ protected:
   // nameToHash_ and hashToName_ are just for looking up the hash more quickly
   // (instead of calculating it again).
   // The key is the Name. The value is the hash.
-  std::map<Name, uint32_t> nameToHash_;
+  std::unordered_map<Name, uint32_t, NameHash> nameToHash_;
   // The key is the hash. The value is the Name.
-  std::map<uint32_t, Name> hashToName_;
+  std::unordered_map<uint32_t, Name> hashToName_;
 
   Name syncPrefix_;
 
   Milliseconds syncReplyFreshnessPeriod_;
+  NameHashMode nameHashMode_;
 };
 
 }
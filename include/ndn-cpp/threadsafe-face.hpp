@@ -32,6 +32,9 @@
 
 namespace ndn {
 
+class SubmissionQueue;
+class AsioDelayedCallTable;
+
 /**
  * A ThreadsafeFace extends Face to use a Boost asio io_service to process events
  * and schedule communication calls. You must start the service on the thread in
@@ -92,6 +95,9 @@ public:
    */
   ThreadsafeFace();
 
+  virtual
+  ~ThreadsafeFace();
+
   /**
    * Get the asio io_service that was given to the constructor.
    * @return THe asio io_service.
@@ -100,9 +106,10 @@ public:
   getIoService() { return ioService_; }
 
   /**
-   * Override to use the ioService given to the constructor to dispatch
-   * expressInterest to be called in a thread-safe manner. See
-   * Face.expressInterest for calling details.
+   * Override to submit expressInterest to be called on the thread of the
+   * ioService given to the constructor, in a thread-safe manner. See
+   * Face.expressInterest for calling details. (Calls from other threads are
+   * pushed on a lock-free queue which the ioService processes in a batch.)
    */
   virtual uint64_t
   expressInterest
@@ -111,8 +118,8 @@ public:
      WireFormat& wireFormat = *WireFormat::getDefaultWireFormat());
 
   /**
-   * Override to use the ioService given to the constructor to dispatch
-   * expressInterest to be called in a thread-safe manner. See
+   * Override to submit expressInterest to be called on the thread of the
+   * ioService given to the constructor, in a thread-safe manner. See
    * Face.expressInterest for calling details.
    */
   virtual uint64_t
@@ -213,8 +220,9 @@ public:
   unsetInterestFilter(uint64_t interestFilterId);
 
   /**
-   * Override to use the ioService given to the constructor to dispatch putData
-   * to be called in a thread-safe manner. See Face.putData for calling details.
+   * Override to submit putData to be called on the thread of the ioService given
+   * to the constructor, in a thread-safe manner. See Face.putData for calling
+   * details.
    */
   virtual void
   putData
@@ -222,15 +230,17 @@ public:
      WireFormat& wireFormat = *WireFormat::getDefaultWireFormat());
 
   /**
-   * Override to use the ioService given to the constructor to dispatch putNack
-   * to be called in a thread-safe manner. See Face.putNack for calling details.
+   * Override to submit putNack to be called on the thread of the ioService given
+   * to the constructor, in a thread-safe manner. See Face.putNack for calling
+   * details.
    */
   virtual void
   putNack(const Interest& interest, const NetworkNack& networkNack);
 
   /**
-   * Override to use the ioService given to the constructor to dispatch send to
-   * be called in a thread-safe manner. See Face.send for calling details.
+   * Override to submit send to be called on the thread of the ioService given
+   * to the constructor, in a thread-safe manner. This copies the encoding. See
+   * Face.send for calling details.
    */
   virtual void
   send(const uint8_t *encoding, size_t encodingLength);
@@ -243,9 +253,10 @@ public:
   shutdown();
 
   /**
-   * Override to call callback() after the given delay, using a
-   * basic_deadline_timer with the ioService given to the constructor. Even
-   * though this is public, it is not part of the public API of Face.
+   * Override to call callback() after the given delay on the thread of the
+   * ioService given to the constructor. All the delayed calls share one
+   * basic_deadline_timer which is set for the earliest call time. Even though
+   * this is public, it is not part of the public API of Face.
    * @param delayMilliseconds The delay in milliseconds.
    * @param callback This calls callback.callback() after the delay.
    */
@@ -253,6 +264,37 @@ public:
   callLater(Milliseconds delayMilliseconds, const Callback& callback);
 
 private:
+  class Submission;
+  class ExpressInterestSubmission;
+  class CallLaterSubmission;
+  class SendSubmission;
+
+  void
+  construct();
+
+  /**
+   * If called on the thread of the ioService, process the submission now.
+   * Otherwise push it on submissionQueue_ and, if the queue was empty, post
+   * processSubmissions to the ioService. (If Boost atomic is not available,
+   * dispatch the submission by itself.)
+   * @param submission The new Submission. This takes ownership.
+   */
+  void
+  submit(Submission* submission);
+
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+  /**
+   * Process all the submissions in submissionQueue_. This is called on the
+   * thread of the ioService. This logs and ignores an exception from a
+   * submission so that the rest of the batch is processed.
+   */
+  void
+  processSubmissions();
+#else
+  void
+  processSubmission(const ptr_lib::shared_ptr<Submission>& submission);
+#endif
+
   static ptr_lib::shared_ptr<Transport>
   getDefaultTransport(boost::asio::io_service& ioService);
 
@@ -262,6 +304,11 @@ private:
   // This is only used if the io_service is not supplied to the constructor.
   boost::movelib::unique_ptr<boost::asio::io_service> internalIoService_;
   boost::asio::io_service& ioService_;
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+  boost::movelib::unique_ptr<SubmissionQueue> submissionQueue_;
+#endif
+  // This is only used on the thread of the ioService.
+  boost::movelib::unique_ptr<AsioDelayedCallTable> delayedCallTable_;
 };
 
 }
@@ -78,6 +78,9 @@ public:
 
   TcpTransport();
 
+  virtual
+  ~TcpTransport();
+
   /**
    * Determine whether this transport connecting according to connectionInfo is
    * to a node on the current machine; results are cached. According to
@@ -134,6 +137,21 @@ public:
   virtual void
   processEvents();
 
+  /**
+   * Block until there is data on the socket to receive, until wakeUp() is
+   * called from another thread, or until maxWaitMilliseconds has elapsed.
+   * @param maxWaitMilliseconds The maximum time to wait in milliseconds.
+   */
+  virtual void
+  waitForReceive(Milliseconds maxWaitMilliseconds);
+
+  /**
+   * Make a call to waitForReceive which is blocked in another thread return
+   * immediately. This is thread-safe.
+   */
+  virtual void
+  wakeUp();
+
   virtual bool
   getIsConnected();
 
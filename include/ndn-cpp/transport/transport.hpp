@@ -106,6 +106,26 @@ public:
   virtual void
   processEvents() = 0;
 
+  /**
+   * Block until there may be data for processEvents() to receive, until
+   * wakeUp() is called from another thread, or until maxWaitMilliseconds has
+   * elapsed. This base class implementation returns immediately, which is
+   * correct (but doesn't save CPU) for a transport which can't wait. You should
+   * normally not call this directly since it is called by
+   * Face.processEvents(maxWaitMilliseconds).
+   * @param maxWaitMilliseconds The maximum time to wait in milliseconds.
+   */
+  virtual void
+  waitForReceive(Milliseconds maxWaitMilliseconds);
+
+  /**
+   * Make a call to waitForReceive which is blocked in another thread return
+   * immediately. This is thread-safe. This base class implementation does
+   * nothing.
+   */
+  virtual void
+  wakeUp();
+
   virtual bool
   getIsConnected();
 
@@ -117,6 +137,17 @@ public:
   close();
 
   virtual ~Transport();
+
+protected:
+  /**
+   * Convert maxWaitMilliseconds to a timeout for poll. This rounds up so that
+   * the wait doesn't return just before a deadline, and limits the result to
+   * the range of int.
+   * @param maxWaitMilliseconds The maximum time to wait in milliseconds.
+   * @return The non-negative timeout in milliseconds.
+   */
+  static int
+  getPollTimeoutMilliseconds(Milliseconds maxWaitMilliseconds);
 };
 
 }
@@ -78,6 +78,9 @@ public:
 
   UdpTransport();
 
+  virtual
+  ~UdpTransport();
+
   /**
    * Determine whether this transport connecting according to connectionInfo is
    * to a node on the current machine. UDP transports are always non-local.
@@ -128,6 +131,21 @@ public:
   virtual void
   processEvents();
 
+  /**
+   * Block until there is data on the socket to receive, until wakeUp() is
+   * called from another thread, or until maxWaitMilliseconds has elapsed.
+   * @param maxWaitMilliseconds The maximum time to wait in milliseconds.
+   */
+  virtual void
+  waitForReceive(Milliseconds maxWaitMilliseconds);
+
+  /**
+   * Make a call to waitForReceive which is blocked in another thread return
+   * immediately. This is thread-safe.
+   */
+  virtual void
+  wakeUp();
+
   virtual bool
   getIsConnected();
 
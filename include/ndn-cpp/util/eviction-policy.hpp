@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_EVICTION_POLICY_HPP
+#define NDN_EVICTION_POLICY_HPP
+
+#include <list>
+#include <vector>
+#include "memory-content-cache.hpp"
+
+namespace ndn {
+
+/**
+ * FifoEvictionPolicy extends MemoryContentCache::EvictionPolicy to evict the
+ * content which was added first.
+ */
+class FifoEvictionPolicy : public MemoryContentCache::EvictionPolicy {
+public:
+  virtual void
+  afterInsert(const MemoryContentCache::Content* content);
+
+  virtual void
+  afterAccess(const MemoryContentCache::Content* content) {}
+
+  virtual void
+  beforeRemove(const MemoryContentCache::Content* content);
+
+  virtual const MemoryContentCache::Content*
+  selectVictim();
+
+protected:
+  typedef std::list<const MemoryContentCache::Content*> ContentQueue;
+
+  // The front is the next content to evict.
+  ContentQueue queue_;
+  std::map<const MemoryContentCache::Content*, ContentQueue::iterator> positions_;
+};
+
+/**
+ * LruEvictionPolicy extends FifoEvictionPolicy to evict the content which was
+ * least recently added or used to answer an Interest.
+ */
+class LruEvictionPolicy : public FifoEvictionPolicy {
+public:
+  virtual void
+  afterAccess(const MemoryContentCache::Content* content);
+};
+
+/**
+ * LfuEvictionPolicy extends MemoryContentCache::EvictionPolicy to evict the
+ * content which was least frequently used to answer an Interest. Among content
+ * with the same count, evict the least recently added or used.
+ */
+class LfuEvictionPolicy : public MemoryContentCache::EvictionPolicy {
+public:
+  LfuEvictionPolicy()
+  : lastSequenceNo_(0)
+  {
+  }
+
+  virtual void
+  afterInsert(const MemoryContentCache::Content* content);
+
+  virtual void
+  afterAccess(const MemoryContentCache::Content* content);
+
+  virtual void
+  beforeRemove(const MemoryContentCache::Content* content);
+
+  virtual const MemoryContentCache::Content*
+  selectVictim();
+
+private:
+  class Key {
+  public:
+    Key(uint64_t useCount, uint64_t sequenceNo,
+        const MemoryContentCache::Content* content)
+    : useCount_(useCount), sequenceNo_(sequenceNo), content_(content)
+    {
+    }
+
+    bool
+    operator < (const Key& other) const
+    {
+      if (useCount_ != other.useCount_)
+        return useCount_ < other.useCount_;
+      return sequenceNo_ < other.sequenceNo_;
+    }
+
+    uint64_t useCount_;
+    uint64_t sequenceNo_;
+    const MemoryContentCache::Content* content_;
+  };
+
+  // The first key is the next content to evict.
+  std::set<Key> keys_;
+  std::map<const MemoryContentCache::Content*, std::set<Key>::iterator> positions_;
+  uint64_t lastSequenceNo_;
+};
+
+/**
+ * WTinyLfuEvictionPolicy extends MemoryContentCache::EvictionPolicy to use an
+ * admission window in front of a segmented LRU, where a TinyLFU frequency
+ * sketch decides whether content leaving the window replaces the main victim.
+ * New content goes in the window, which is a small fraction of the cache
+ * bytes. The main part has a probation segment and a protected segment for
+ * content used again while in probation. The sketch counts the adds and uses
+ * of each name with 4-bit counters which are halved periodically, so it
+ * remembers the popularity of a name even after its content is evicted.
+ */
+class WTinyLfuEvictionPolicy : public MemoryContentCache::EvictionPolicy {
+public:
+  /**
+   * Create a WTinyLfuEvictionPolicy.
+   * @param windowFraction (optional) The fraction of the cache bytes for the
+   * admission window. If omitted, use 0.01.
+   * @param protectedFraction (optional) The fraction of the main bytes for the
+   * protected segment. If omitted, use 0.8.
+   */
+  WTinyLfuEvictionPolicy
+    (double windowFraction = 0.01, double protectedFraction = 0.8);
+
+  virtual void
+  afterInsert(const MemoryContentCache::Content* content);
+
+  virtual void
+  afterAccess(const MemoryContentCache::Content* content);
+
+  virtual void
+  beforeRemove(const MemoryContentCache::Content* content);
+
+  virtual const MemoryContentCache::Content*
+  selectVictim();
+
+private:
+  enum Segment { WINDOW, PROBATION, PROTECTED };
+
+  typedef std::list<const MemoryContentCache::Content*> ContentQueue;
+
+  class Position {
+  public:
+    Position(Segment segment, ContentQueue::iterator iterator)
+    : segment_(segment), iterator_(iterator)
+    {
+    }
+
+    Segment segment_;
+    ContentQueue::iterator iterator_;
+  };
+
+  /**
+   * Move the content to the back of the segment and update the byte counts.
+   */
+  void
+  moveTo(Position& position, Segment segment);
+
+  /**
+   * Demote content from the front of the protected segment to probation until
+   * it is within its share of the main bytes.
+   */
+  void
+  balanceProtected();
+
+  /**
+   * Increment the sketch counters for the name of the content. If the sketch
+   * has had enough increments, halve all counters. If the cache has grown,
+   * enlarge the sketch.
+   */
+  void
+  incrementFrequency(const MemoryContentCache::Content* content);
+
+  /**
+   * Get the estimated frequency of the name of the content from the sketch.
+   */
+  int
+  getFrequency(const MemoryContentCache::Content* content) const;
+
+  /**
+   * Get the sketch counter index for the name hash in the given row.
+   */
+  size_t
+  getCounterIndex(size_t nameHash, int row) const;
+
+  double windowFraction_;
+  double protectedFraction_;
+  // The front of each queue is the least recently used.
+  ContentQueue queues_[3];
+  size_t bytes_[3];
+  std::map<const MemoryContentCache::Content*, Position> positions_;
+  // The count-min sketch, with two 4-bit counters in each byte.
+  std::vector<uint8_t> sketch_;
+  size_t nIncrements_;
+};
+
+}
+
+#endif
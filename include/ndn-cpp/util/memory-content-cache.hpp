@@ -23,7 +23,8 @@
 #define NDN_MEMORY_CONTENT_CACHE_HPP
 
 #include <map>
-#include <deque>
+#include <set>
+#include <queue>
 #include "../face.hpp"
 
 namespace ndn {
@@ -32,6 +33,8 @@ namespace ndn {
  * A MemoryContentCache holds a set of Data packets and answers an Interest to
  * return the correct Data packet. The cache is periodically cleaned up to
  * remove each stale Data packet based on its FreshnessPeriod (if it has one).
+ * If setMaxCacheBytes() sets a limit, an EvictionPolicy also removes content to
+ * keep the cache within the limit.
  * @note This class is an experimental feature.  See the API docs for more detail at
  * http://named-data.net/doc/ndn-ccl-api/memory-content-cache.html .
  */
@@ -106,6 +109,14 @@ public:
       return nowMilliseconds >= timeoutTimeMilliseconds_;
     }
 
+    /**
+     * Return the time when this interest times out.
+     * @return The timeout time in milliseconds since 1/1/1970, as returned by
+     * ndn_getNowMilliseconds.
+     */
+    MillisecondsSince1970
+    getTimeoutTime() const { return timeoutTimeMilliseconds_; }
+
   private:
     ptr_lib::shared_ptr<const Interest> interest_;
     Face& face_;
@@ -158,6 +169,49 @@ public:
   typedef func_lib::function<void
     (const ptr_lib::shared_ptr<ContentList>& contentList)> OnContentRemoved;
 
+  /**
+   * An EvictionPolicy chooses the content to evict when the cache exceeds the
+   * limit from setMaxCacheBytes(). The cache calls afterInsert, afterAccess and
+   * beforeRemove so that the policy can keep its own order of the content.
+   * See eviction-policy.hpp for FifoEvictionPolicy, LruEvictionPolicy,
+   * LfuEvictionPolicy and WTinyLfuEvictionPolicy.
+   */
+  class EvictionPolicy {
+  public:
+    virtual
+    ~EvictionPolicy() {}
+
+    /**
+     * This is called after the content is added to the cache.
+     * @param content The new content.
+     */
+    virtual void
+    afterInsert(const Content* content) = 0;
+
+    /**
+     * This is called after the content is used to answer an Interest.
+     * @param content The content which was sent.
+     */
+    virtual void
+    afterAccess(const Content* content) = 0;
+
+    /**
+     * This is called before the content is removed from the cache, either
+     * because it is stale or because selectVictim() chose it.
+     * @param content The content to remove.
+     */
+    virtual void
+    beforeRemove(const Content* content) = 0;
+
+    /**
+     * Choose the content to evict. This does not remove it. The cache calls
+     * beforeRemove before removing it.
+     * @return The content to evict, or null if this has no content.
+     */
+    virtual const Content*
+    selectVictim() = 0;
+  };
+
   /**
    * Call registerPrefix on the Face given to the constructor so that this
    * MemoryContentCache will answer interests whose name has the prefix.
@@ -319,7 +373,8 @@ public:
    * removing stale content, remove timed-out pending interests from
    * storePendingInterest(), then if the added Data packet satisfies any
    * interest, send it through the transport and remove the interest from the
-   * pending interest table.
+   * pending interest table. The pending interests are indexed by name, so this
+   * only checks the interests whose name is a prefix of the Data name.
    * Because this modifies the internal tables, you should call this on the same
    * thread as processEvents, which can also modify the tables.
    * @param data The Data packet object to put in the cache. This copies the
@@ -414,6 +469,70 @@ public:
     impl_->setOnContentRemoved(onContentRemoved);
   }
 
+  /**
+   * Set the limit on the total size of the Data packet encodings in the cache.
+   * When add() makes the cache exceed the limit, this uses the eviction policy
+   * to remove content (which may be the added content) until it is within the
+   * limit, and calls the OnContentRemoved callback for the evicted content.
+   * @param maxCacheBytes The maximum total bytes of the encodings, or 0 for no
+   * limit. If this is less than getCacheBytes(), this evicts content now. If
+   * setEvictionPolicy() was not called, this uses an LruEvictionPolicy.
+   */
+  void
+  setMaxCacheBytes(size_t maxCacheBytes)
+  {
+    impl_->setMaxCacheBytes(maxCacheBytes);
+  }
+
+  /**
+   * Get the limit on the total size of the Data packet encodings in the cache.
+   * @return The maximum total bytes, or 0 for no limit.
+   */
+  size_t
+  getMaxCacheBytes() const { return impl_->getMaxCacheBytes(); }
+
+  /**
+   * Set the policy which chooses the content to evict when the cache exceeds
+   * the limit from setMaxCacheBytes(). This calls evictionPolicy.afterInsert
+   * for the content already in the cache.
+   * @param evictionPolicy The new EvictionPolicy, such as an LruEvictionPolicy.
+   * It should not be used by another MemoryContentCache.
+   */
+  void
+  setEvictionPolicy(const ptr_lib::shared_ptr<EvictionPolicy>& evictionPolicy)
+  {
+    impl_->setEvictionPolicy(evictionPolicy);
+  }
+
+  /**
+   * Get the total size of the Data packet encodings in the cache.
+   * @return The total bytes.
+   */
+  size_t
+  getCacheBytes() const { return impl_->getCacheBytes(); }
+
+  /**
+   * Get the number of Interests which were answered from the cache.
+   * @return The number of cache hits.
+   */
+  uint64_t
+  getHitCount() const { return impl_->getHitCount(); }
+
+  /**
+   * Get the number of Interests which did not match content in the cache.
+   * @return The number of cache misses.
+   */
+  uint64_t
+  getMissCount() const { return impl_->getMissCount(); }
+
+  /**
+   * Get the number of content entries removed by the eviction policy, not
+   * counting stale content removed during cleanup.
+   * @return The number of evictions.
+   */
+  uint64_t
+  getEvictionCount() const { return impl_->getEvictionCount(); }
+
   /**
    * Get the minimum lifetime before removing stale content from the cache.
    * @return The minimum cache lifetime in milliseconds.
@@ -510,6 +629,27 @@ private:
       minimumCacheLifetime_ = minimumCacheLifetime;
     }
 
+    void
+    setMaxCacheBytes(size_t maxCacheBytes);
+
+    size_t
+    getMaxCacheBytes() const { return maxCacheBytes_; }
+
+    void
+    setEvictionPolicy(const ptr_lib::shared_ptr<EvictionPolicy>& evictionPolicy);
+
+    size_t
+    getCacheBytes() const { return cacheBytes_; }
+
+    uint64_t
+    getHitCount() const { return hitCount_; }
+
+    uint64_t
+    getMissCount() const { return missCount_; }
+
+    uint64_t
+    getEvictionCount() const { return evictionCount_; }
+
     /**
      * This is the OnInterestCallback which is called when the library receives
      * an interest whose name has the prefix given to registerPrefix. First
@@ -517,7 +657,10 @@ private:
      * stale content from the cache. Then search the cache for the Data packet,
      * matching any interest selectors including ChildSelector, and send the
      * Data packet to the transport. If no matching Data packet is in the cache,
-     * call the callback in onDataNotFoundForPrefix_ (if defined).
+     * call the callback in onDataNotFoundForPrefix_ (if defined). The search
+     * uses contentIndex_, so it only checks the content whose name has the
+     * interest name as a prefix, in name order. Without a ChildSelector, this
+     * sends the leftmost match.
      */
     void
     onInterest
@@ -596,6 +739,114 @@ private:
         remove from the cache) in milliseconds according to ndn_getNowMilliseconds */
     };
 
+    /**
+     * An IndexEntry is the value in contentIndex_ for each content in the
+     * cache.
+     */
+    class IndexEntry {
+    public:
+      /**
+       * Create an IndexEntry for the content.
+       * @param content The content, which is also in staleTimeCache_ if
+       * staleTimeContent is not null.
+       * @param staleTimeContent If the content will go stale, this is the same
+       * object as content. Otherwise null.
+       */
+      IndexEntry
+        (const ptr_lib::shared_ptr<const Content>& content,
+         const StaleTimeContent* staleTimeContent)
+      : content_(content), staleTimeContent_(staleTimeContent)
+      {}
+
+      const ptr_lib::shared_ptr<const Content>&
+      getContent() const { return content_; }
+
+      /**
+       * Get the content as a StaleTimeContent.
+       * @return The StaleTimeContent, or null if the content does not go stale.
+       */
+      const StaleTimeContent*
+      getStaleTimeContent() const { return staleTimeContent_; }
+
+      /**
+       * Check if the content is still fresh.
+       * @param nowMilliseconds The current time in milliseconds from
+       * ndn_getNowMilliseconds.
+       * @return True if the content is still fresh or does not go stale,
+       * otherwise false.
+       */
+      bool
+      isFresh(MillisecondsSince1970 nowMilliseconds) const
+      {
+        return !staleTimeContent_ || staleTimeContent_->isFresh(nowMilliseconds);
+      }
+
+    private:
+      ptr_lib::shared_ptr<const Content> content_;
+      const StaleTimeContent* staleTimeContent_;
+    };
+
+    typedef std::multimap<Name, IndexEntry> ContentIndex;
+    typedef std::multiset<ptr_lib::shared_ptr<const StaleTimeContent>,
+                          StaleTimeContent::Compare> StaleTimeCache;
+    typedef std::multimap<Name, ptr_lib::shared_ptr<const PendingInterest> >
+      PendingInterestIndex;
+
+    /**
+     * Compare shared_ptrs to PendingInterest so that the pending interest which
+     * times out first is at the top of a priority_queue.
+     */
+    class PendingInterestTimeoutCompare {
+    public:
+      bool
+      operator()
+        (const ptr_lib::shared_ptr<const PendingInterest>& x,
+         const ptr_lib::shared_ptr<const PendingInterest>& y) const
+      {
+        return x->getTimeoutTime() > y->getTimeoutTime();
+      }
+    };
+
+    typedef std::priority_queue<ptr_lib::shared_ptr<const PendingInterest>,
+                                std::vector<ptr_lib::shared_ptr<const PendingInterest> >,
+                                PendingInterestTimeoutCompare> PendingInterestTimeouts;
+
+    /**
+     * Find the content in contentIndex_ which best matches the interest, using
+     * the ChildSelector and the freshness of the content.
+     * @param interest The interest to match.
+     * @param nowMilliseconds The current time in milliseconds from
+     * ndn_getNowMilliseconds.
+     * @return The matching content, or null if not found.
+     */
+    const Content*
+    findMatchingContent
+      (const Interest& interest, MillisecondsSince1970 nowMilliseconds) const;
+
+    /**
+     * Find the content in contentIndex_.
+     * @param content The content to find, which is matched by pointer.
+     * @return The entry in contentIndex_, or contentIndex_.end() if not found.
+     */
+    ContentIndex::iterator
+    findInIndex(const Content* content);
+
+    /**
+     * Remove the entry from contentIndex_, update cacheBytes_ and call the
+     * eviction policy beforeRemove. This does not remove from staleTimeCache_.
+     * @param entry The entry in contentIndex_.
+     */
+    void
+    removeFromIndex(ContentIndex::iterator entry);
+
+    /**
+     * While cacheBytes_ exceeds maxCacheBytes_, remove the content chosen by
+     * evictionPolicy_. If onContentRemoved_ is defined, call it for the evicted
+     * content.
+     */
+    void
+    evict();
+
     /**
      * Check if now is greater than nextCleanupTime_ and, if so, remove stale
      * content from staleTimeCache_ and reset nextCleanupTime_ based on
@@ -609,6 +860,17 @@ private:
     void
     doCleanup(MillisecondsSince1970 nowMilliseconds);
 
+    /**
+     * Pop the timed-out pending interests from pendingInterestTimeouts_ and
+     * remove them from pendingInterestIndex_ if they are still there. (An
+     * interest which was satisfied is already removed from the index, and is
+     * dropped from the heap when it times out.)
+     * @param nowMilliseconds The current time in milliseconds from
+     * ndn_getNowMilliseconds.
+     */
+    void
+    removeTimedOutPendingInterests(MillisecondsSince1970 nowMilliseconds);
+
     /**
      * This is a private method to return for setting storePendingInterestCallback_.
      * We need a separate method because the arguments are different from the main
@@ -630,16 +892,29 @@ private:
     std::map<std::string, OnInterestCallback> onDataNotFoundForPrefix_; /**< The map key is the prefix.toUri() */
     std::vector<uint64_t> interestFilterIdList_;
     std::vector<uint64_t> registeredPrefixIdList_;
-    std::vector<ptr_lib::shared_ptr<const Content> > noStaleTimeCache_;
-    // Use a deque so we can efficiently remove from the front.
-    std::deque<ptr_lib::shared_ptr<const StaleTimeContent> > staleTimeCache_;
-    StaleTimeContent::Compare contentCompare_;
-    Name::Component emptyComponent_;
-    std::vector<ptr_lib::shared_ptr<const PendingInterest> > pendingInterestTable_;
+    // All the content in the cache, sorted by name so that the content with a
+    // given prefix is in one range.
+    ContentIndex contentIndex_;
+    // The content which goes stale, also in contentIndex_, sorted on the
+    // removal time. Use a multiset so we can efficiently remove from the front,
+    // or remove an evicted entry.
+    StaleTimeCache staleTimeCache_;
+    // The pending interests, sorted by the interest name so that the interests
+    // which a Data name can satisfy are in the ranges for each of its prefixes.
+    PendingInterestIndex pendingInterestIndex_;
+    // The pending interests with the earliest timeout at the top. This can also
+    // have interests which were already removed from pendingInterestIndex_.
+    PendingInterestTimeouts pendingInterestTimeouts_;
     OnInterestCallback storePendingInterestCallback_;
     OnContentRemoved onContentRemoved_;
     bool isDoingCleanup_;
     Milliseconds minimumCacheLifetime_;
+    ptr_lib::shared_ptr<EvictionPolicy> evictionPolicy_;
+    size_t maxCacheBytes_;
+    size_t cacheBytes_;
+    uint64_t hitCount_;
+    uint64_t missCount_;
+    uint64_t evictionCount_;
   };
 
   ptr_lib::shared_ptr<Impl> impl_;
@@ -0,0 +1,318 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_PERSISTENT_CONTENT_CACHE_HPP
+#define NDN_PERSISTENT_CONTENT_CACHE_HPP
+
+#include <map>
+#include <string>
+#include "../face.hpp"
+
+namespace ndn {
+
+class MappedContentStore;
+
+/**
+ * A PersistentContentCache answers Interests with Data packets like
+ * MemoryContentCache, but keeps the signed Data encodings in files in a
+ * directory so that a producer which restarts doesn't have to sign and add
+ * them again. The encodings are appended to a log of segment files and the
+ * name index is kept in memory-mapped files, so opening the cache only maps
+ * the files, and a reply is sent with Face::send directly from the mapped
+ * segment. Content is not removed when it goes stale, but an Interest with
+ * MustBeFresh only matches content whose FreshnessPeriod has not passed since
+ * it was added. If a Data packet with the same name is added again, the cache
+ * replies with the one added last.
+ * The same as MemoryContentCache, an Interest which can match more than one
+ * name gets the leftmost match, or the rightmost if its ChildSelector is 1.
+ * The files only grow as Data packets are added. Call compact() to free the
+ * space of Data packets which were replaced by a Data packet with the same
+ * name, and optionally to drop the oldest Data packets beyond a size limit.
+ * The files are consistent if the process stops in the middle of add or
+ * compact, and flush() syncs them to disk. The destructor also calls flush().
+ * @note This class is an experimental feature. It needs memory-mapped files
+ * and throws an exception on a platform without them.
+ */
+class PersistentContentCache {
+public:
+  /**
+   * Create a new PersistentContentCache to use the given Face, and open the
+   * files in the directory, creating them if needed.
+   * @param face The Face to use to call registerPrefix and setInterestFilter,
+   * and which will call this object's OnInterest callback.
+   * @param directory The directory for the files, which must already exist.
+   * Only one PersistentContentCache at a time may use the directory.
+   * @param segmentSize (optional) The size in bytes of each segment file of
+   * the log, which is only used when creating the files. If omitted, use
+   * DEFAULT_SEGMENT_SIZE.
+   * @throws runtime_error if the files can't be opened or mapped.
+   */
+  PersistentContentCache
+    (Face* face, const std::string& directory,
+     size_t segmentSize = DEFAULT_SEGMENT_SIZE)
+  : impl_(new Impl(face, directory, segmentSize))
+  {
+  }
+
+  /**
+   * Call registerPrefix on the Face given to the constructor so that this
+   * PersistentContentCache will answer interests whose name has the prefix.
+   * See MemoryContentCache::registerPrefix for details.
+   * @param prefix The Name for the prefix to register. This copies the Name.
+   * @param onRegisterFailed A function object to call if failed to retrieve the
+   * connected hub’s ID or failed to register the prefix.
+   * @param onDataNotFound (optional) If a data packet for an interest is not
+   * found in the cache, this forwards the interest by calling
+   * onDataNotFound(prefix, interest, face, interestFilterId, filter).
+   * If onDataNotFound is an empty OnInterestCallback(), this does not use it.
+   * @param registrationOptions (optional) See Face::registerPrefix.
+   * @param wireFormat (optional) See Face::registerPrefix.
+   */
+  void
+  registerPrefix
+    (const Name& prefix, const OnRegisterFailed& onRegisterFailed,
+     const OnInterestCallback& onDataNotFound = OnInterestCallback(),
+     const RegistrationOptions& registrationOptions = RegistrationOptions(),
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat())
+  {
+    registerPrefix
+      (prefix, onRegisterFailed, OnRegisterSuccess(), onDataNotFound,
+       registrationOptions, wireFormat);
+  }
+
+  /**
+   * Call registerPrefix on the Face given to the constructor so that this
+   * PersistentContentCache will answer interests whose name has the prefix.
+   * See MemoryContentCache::registerPrefix for details.
+   * @param prefix The Name for the prefix to register. This copies the Name.
+   * @param onRegisterFailed A function object to call if failed to retrieve the
+   * connected hub’s ID or failed to register the prefix.
+   * @param onRegisterSuccess A function object to call registerPrefix
+   * receives a success message from the forwarder. If onRegisterSuccess is an
+   * empty OnRegisterSuccess(), this does not use it.
+   * @param onDataNotFound (optional) If a data packet for an interest is not
+   * found in the cache, this forwards the interest by calling
+   * onDataNotFound(prefix, interest, face, interestFilterId, filter).
+   * If onDataNotFound is an empty OnInterestCallback(), this does not use it.
+   * @param registrationOptions (optional) See Face::registerPrefix.
+   * @param wireFormat (optional) See Face::registerPrefix.
+   */
+  void
+  registerPrefix
+    (const Name& prefix, const OnRegisterFailed& onRegisterFailed,
+     const OnRegisterSuccess& onRegisterSuccess,
+     const OnInterestCallback& onDataNotFound = OnInterestCallback(),
+     const RegistrationOptions& registrationOptions = RegistrationOptions(),
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat())
+  {
+    impl_->registerPrefix
+      (prefix, onRegisterFailed, onRegisterSuccess, onDataNotFound,
+       registrationOptions, wireFormat);
+  }
+
+  /**
+   * Call setInterestFilter on the Face given to the constructor so that this
+   * PersistentContentCache will answer interests whose name matches the filter.
+   * @param filter The InterestFilter with a prefix and optional regex filter
+   * used to match the name of an incoming Interest. This makes a copy of filter.
+   * @param onDataNotFound (optional) If a data packet for an interest is not
+   * found in the cache, this forwards the interest by calling
+   * onDataNotFound(prefix, interest, face, interestFilterId, filter).
+   * If onDataNotFound is an empty OnInterestCallback(), this does not use it.
+   */
+  void
+  setInterestFilter
+    (const InterestFilter& filter,
+     const OnInterestCallback& onDataNotFound = OnInterestCallback())
+  {
+    impl_->setInterestFilter(filter, onDataNotFound);
+  }
+
+  /**
+   * Call setInterestFilter on the Face given to the constructor so that this
+   * PersistentContentCache will answer interests whose name has the prefix.
+   * @param prefix The Name prefix used to match the name of an incoming
+   * Interest. This copies the Name.
+   * @param onDataNotFound (optional) If a data packet for an interest is not
+   * found in the cache, this forwards the interest by calling
+   * onDataNotFound(prefix, interest, face, interestFilterId, filter).
+   * If onDataNotFound is an empty OnInterestCallback(), this does not use it.
+   */
+  void
+  setInterestFilter
+    (const Name& prefix,
+     const OnInterestCallback& onDataNotFound = OnInterestCallback())
+  {
+    impl_->setInterestFilter(prefix, onDataNotFound);
+  }
+
+  /**
+   * Call Face.unsetInterestFilter and Face.removeRegisteredPrefix for all the
+   * prefixes given to the setInterestFilter and registerPrefix method on this
+   * PersistentContentCache object so that it will not receive interests any
+   * more. This does not change the files.
+   */
+  void
+  unregisterAll() { impl_->unregisterAll(); }
+
+  /**
+   * Append the Data packet to the files so that it is available to answer
+   * interests, now and after the cache is opened again. The Data packet
+   * should already be signed.
+   * @param data The Data packet. This uses data.wireEncode().
+   * @throws runtime_error if a file can't be extended or mapped.
+   */
+  void
+  add(const Data& data) { impl_->add(data); }
+
+  /**
+   * Sync the files to disk, so that the added Data packets survive a system
+   * crash.
+   * @throws runtime_error if a sync fails.
+   */
+  void
+  flush() { impl_->flush(); }
+
+  /**
+   * Rewrite the files without the Data packets which were replaced by a newer
+   * Data packet with the same name, and without the oldest Data packets beyond
+   * maxContentBytes, to free their disk space. This copies the kept Data
+   * packets, so call it occasionally, for example when getContentBytes() has
+   * grown well beyond the expected size.
+   * @param maxContentBytes (optional) The maximum total bytes of the Data
+   * encodings to keep, dropping the oldest. If omitted or 0, don't limit the
+   * size.
+   * @throws runtime_error if a file can't be written.
+   */
+  void
+  compact(uint64_t maxContentBytes = 0) { impl_->compact(maxContentBytes); }
+
+  /**
+   * Get the number of Data packets in the cache.
+   * @return The number of Data packets.
+   */
+  size_t
+  size() const { return impl_->size(); }
+
+  /**
+   * Get the total bytes of the Data encodings in the cache.
+   * @return The number of bytes.
+   */
+  uint64_t
+  getContentBytes() const { return impl_->getContentBytes(); }
+
+  /**
+   * Get the number of Interests which the cache answered.
+   * @return The number of hits.
+   */
+  uint64_t
+  getHitCount() const { return impl_->getHitCount(); }
+
+  /**
+   * Get the number of Interests which the cache could not answer.
+   * @return The number of misses.
+   */
+  uint64_t
+  getMissCount() const { return impl_->getMissCount(); }
+
+  static const size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+private:
+  /**
+   * PersistentContentCache::Impl does the work of PersistentContentCache. It
+   * is a separate class so that PersistentContentCache can create an instance
+   * in a shared_ptr to use in callbacks.
+   */
+  class Impl : public ptr_lib::enable_shared_from_this<Impl> {
+  public:
+    /**
+     * Create a new Impl, which should belong to a shared_ptr. See the
+     * PersistentContentCache constructor for parameter documentation.
+     */
+    Impl(Face* face, const std::string& directory, size_t segmentSize);
+
+    void
+    registerPrefix
+      (const Name& prefix, const OnRegisterFailed& onRegisterFailed,
+       const OnRegisterSuccess& onRegisterSuccess,
+       const OnInterestCallback& onDataNotFound,
+       const RegistrationOptions& registrationOptions, WireFormat& wireFormat);
+
+    void
+    setInterestFilter
+      (const InterestFilter& filter, const OnInterestCallback& onDataNotFound);
+
+    void
+    setInterestFilter
+      (const Name& prefix, const OnInterestCallback& onDataNotFound);
+
+    void
+    unregisterAll();
+
+    void
+    add(const Data& data);
+
+    void
+    flush();
+
+    void
+    compact(uint64_t maxContentBytes);
+
+    size_t
+    size() const;
+
+    uint64_t
+    getContentBytes() const;
+
+    uint64_t
+    getHitCount() const { return hitCount_; }
+
+    uint64_t
+    getMissCount() const { return missCount_; }
+
+  private:
+    /**
+     * This is the OnInterestCallback for registerPrefix and setInterestFilter.
+     * Find the Data in the store and send it from the mapped segment, or call
+     * the onDataNotFound callback for the prefix.
+     */
+    void
+    onInterest
+      (const ptr_lib::shared_ptr<const Name>& prefix,
+       const ptr_lib::shared_ptr<const Interest>& interest, Face& face,
+       uint64_t interestFilterId,
+       const ptr_lib::shared_ptr<const InterestFilter>& filter);
+
+    Face* face_;
+    ptr_lib::shared_ptr<MappedContentStore> store_;
+    std::map<std::string, OnInterestCallback> onDataNotFoundForPrefix_; /**< The map key is the prefix.toUri() */
+    std::vector<uint64_t> interestFilterIdList_;
+    std::vector<uint64_t> registeredPrefixIdList_;
+    uint64_t hitCount_;
+    uint64_t missCount_;
+  };
+
+  ptr_lib::shared_ptr<Impl> impl_;
+};
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_RTT_ESTIMATOR_HPP
+#define NDN_RTT_ESTIMATOR_HPP
+
+#include "../common.hpp"
+
+namespace ndn {
+
+/**
+ * An RttEstimator keeps the smoothed round-trip time and its variation from RTT
+ * samples, and computes the retransmission timeout as in RFC 6298. It is used
+ * by SegmentFetcher, and Face keeps one for each name prefix when RTT
+ * estimation is enabled. (See Face::setRttEstimationEnabled.)
+ */
+class RttEstimator {
+public:
+  /**
+   * Create an RttEstimator with no samples.
+   * @param initialRto The retransmission timeout in milliseconds before the
+   * first sample.
+   * @param minRto The minimum retransmission timeout in milliseconds.
+   * @param maxRto The maximum retransmission timeout in milliseconds, also
+   * used as the limit for backoffRto.
+   */
+  RttEstimator
+    (Milliseconds initialRto = 1000.0, Milliseconds minRto = 200.0,
+     Milliseconds maxRto = 60000.0)
+  : smoothedRtt_(-1.0), rttVariation_(-1.0), rto_(initialRto),
+    minRto_(minRto), maxRto_(maxRto), nSamples_(0)
+  {
+  }
+
+  /**
+   * Update the smoothed RTT and its variation with the sample and compute the
+   * retransmission timeout. Following Karn's algorithm, the caller should not
+   * give a sample for a retransmitted Interest.
+   * @param rtt The measured round-trip time in milliseconds.
+   */
+  void
+  addMeasurement(Milliseconds rtt);
+
+  /**
+   * Double the retransmission timeout, up to the maximum, after a timeout.
+   */
+  void
+  backoffRto();
+
+  /**
+   * Get the retransmission timeout.
+   * @return The retransmission timeout in milliseconds.
+   */
+  Milliseconds
+  getRto() const { return rto_; }
+
+  /**
+   * Get the smoothed round-trip time.
+   * @return The smoothed RTT in milliseconds, or -1 if there are no samples.
+   */
+  Milliseconds
+  getSmoothedRtt() const { return smoothedRtt_; }
+
+  /**
+   * Get the round-trip time variation.
+   * @return The RTT variation in milliseconds, or -1 if there are no samples.
+   */
+  Milliseconds
+  getRttVariation() const { return rttVariation_; }
+
+  /**
+   * Get the number of samples given to addMeasurement.
+   * @return The number of samples.
+   */
+  uint64_t
+  getSampleCount() const { return nSamples_; }
+
+private:
+  Milliseconds smoothedRtt_;
+  Milliseconds rttVariation_;
+  Milliseconds rto_;
+  Milliseconds minRto_;
+  Milliseconds maxRto_;
+  uint64_t nSamples_;
+};
+
+}
+
+#endif
@@ -23,11 +23,14 @@
 #ifndef NDN_SEGMENT_FETCHER_HPP
 #define NDN_SEGMENT_FETCHER_HPP
 
+#include <map>
 #include "../face.hpp"
 #include "../security/key-chain.hpp"
 
 namespace ndn {
 
+class RttEstimator;
+
 /**
  * SegmentFetcher is a utility class to the fetch latest version of segmented data.
  *
@@ -52,22 +55,45 @@ namespace ndn {
  *
  *    >> Interest: /<prefix>/<version>/<segment=0>
  *
- * 5. Keep sending Interests for the next segment while the retrieved Data does
- *    not have a FinalBlockId or the FinalBlockId != Data.getName().get(-1).
+ * 5. Keep a window of Interests for the following segments outstanding until
+ *    all the segments up to the FinalBlockId are received. The segments may
+ *    arrive out of order.
  *
  *    >> Interest: /<prefix>/<version>/<segment=(N+1))>
  *
  * 6. Call the OnComplete callback with a blob that concatenates the content
  *    from all the segmented objects.
  *
+ * To stream the content instead, set an OnSegment callback in
+ * SegmentFetcher::Options. Each segment's content is passed to OnSegment in
+ * order of segment number as soon as the segments before it are received, and
+ * is not kept. Segments which arrive out of order wait in a reorder buffer
+ * which counts toward the window, so that the memory use is bounded by the
+ * maximum window size instead of the content size. When all the segments are
+ * delivered, OnComplete is called with an isNull Blob. To write the content to
+ * a file descriptor, use makeFileDescriptorSink.
+ *
+ * The size of the window is controlled with additive increase and
+ * multiplicative decrease (AIMD). It starts with slow start and grows for each
+ * received segment. It shrinks when a segment is lost, which is when the
+ * retransmission timeout (RTO) from the RTT estimate expires or the Interest
+ * times out, when a Nack has the reason Congestion, or when a Data packet has
+ * a CongestionMark. A lost segment is fetched again, up to the maximum number
+ * of retries. The parameters are in SegmentFetcher::Options.
+ *
  * If an error occurs during the fetching process, the OnError callback is called
  * with a proper error code.  The following errors are possible:
  *
- * - `INTEREST_TIMEOUT`: if any of the Interests times out
+ * - `INTEREST_TIMEOUT`: if the first Interest times out, or an Interest for a
+ *   segment still times out after the maximum number of retries
  * - `DATA_HAS_NO_SEGMENT`: if any of the retrieved Data packets don't have a segment
  *   as the last component of the name (not counting the implicit digest)
  * - `SEGMENT_VERIFICATION_FAILED`: if any retrieved segment fails
  *   the user-provided VerifySegment callback or KeyChain verifyData.
+ * - `NACK_ERROR`: if a Nack is received for the first Interest, or a Nack for a
+ *   segment has a reason other than Congestion or Duplicate
+ * - `ON_SEGMENT_ERROR`: if the OnSegment callback throws an exception, for
+ *   example if writing to the file descriptor fails
  *
  * In order to validate individual segments, a KeyChain needs to be supplied.
  * If verifyData fails, the fetching process is aborted with
@@ -89,7 +115,206 @@ public:
   enum ErrorCode {
     INTEREST_TIMEOUT = 1,
     DATA_HAS_NO_SEGMENT = 2,
-    SEGMENT_VERIFICATION_FAILED = 3
+    SEGMENT_VERIFICATION_FAILED = 3,
+    NACK_ERROR = 4,
+    ON_SEGMENT_ERROR = 5
+  };
+
+  typedef func_lib::function<void
+    (uint64_t segment, const Blob& content)> OnSegment;
+
+  /**
+   * An Options holds the parameters of the window and retransmission for
+   * fetch. The default values are the same as in ndn-cxx pipeline-interests.
+   */
+  class Options {
+  public:
+    /**
+     * Create an Options with the default values.
+     */
+    Options()
+    : initialWindowSize_(1.0), maxWindowSize_(1.0e9),
+      initialSlowStartThreshold_(1.0e9), additiveIncreaseStep_(1.0),
+      multiplicativeDecreaseFactor_(0.5), maxRetries_(15),
+      ignoreCongestionMarks_(false)
+    {
+    }
+
+    /**
+     * Get the OnSegment callback for streaming.
+     * @return The OnSegment callback, or a null callback if the content is
+     * concatenated for OnComplete.
+     */
+    const OnSegment&
+    getOnSegment() const { return onSegment_; }
+
+    /**
+     * Get the initial window size.
+     * @return The number of Interests.
+     */
+    double
+    getInitialWindowSize() const { return initialWindowSize_; }
+
+    /**
+     * Get the maximum window size.
+     * @return The number of Interests.
+     */
+    double
+    getMaxWindowSize() const { return maxWindowSize_; }
+
+    /**
+     * Get the initial slow start threshold. While the window is smaller than
+     * the threshold, it grows by one for each received segment.
+     * @return The number of Interests.
+     */
+    double
+    getInitialSlowStartThreshold() const { return initialSlowStartThreshold_; }
+
+    /**
+     * Get the additive increase step. In congestion avoidance, the window grows
+     * by this amount for each window of received segments.
+     * @return The number of Interests.
+     */
+    double
+    getAdditiveIncreaseStep() const { return additiveIncreaseStep_; }
+
+    /**
+     * Get the multiplicative decrease factor. When a segment is lost, the
+     * window and slow start threshold become the window times this factor.
+     * @return The factor.
+     */
+    double
+    getMultiplicativeDecreaseFactor() const
+    {
+      return multiplicativeDecreaseFactor_;
+    }
+
+    /**
+     * Get the maximum number of times to retry an Interest for a segment
+     * before calling onError with INTEREST_TIMEOUT.
+     * @return The maximum number of retries.
+     */
+    int
+    getMaxRetries() const { return maxRetries_; }
+
+    /**
+     * Get the flag for whether to ignore the CongestionMark in Data packets.
+     * @return True to ignore the CongestionMark.
+     */
+    bool
+    getIgnoreCongestionMarks() const { return ignoreCongestionMarks_; }
+
+    /**
+     * Set the initial window size.
+     * @param initialWindowSize The number of Interests.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setInitialWindowSize(double initialWindowSize)
+    {
+      initialWindowSize_ = initialWindowSize;
+      return *this;
+    }
+
+    /**
+     * Set the maximum window size. To use a constant window, set the initial
+     * and maximum window size to the same value.
+     * @param maxWindowSize The number of Interests.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setMaxWindowSize(double maxWindowSize)
+    {
+      maxWindowSize_ = maxWindowSize;
+      return *this;
+    }
+
+    /**
+     * Set the initial slow start threshold.
+     * @param initialSlowStartThreshold The number of Interests.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setInitialSlowStartThreshold(double initialSlowStartThreshold)
+    {
+      initialSlowStartThreshold_ = initialSlowStartThreshold;
+      return *this;
+    }
+
+    /**
+     * Set the additive increase step.
+     * @param additiveIncreaseStep The number of Interests.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setAdditiveIncreaseStep(double additiveIncreaseStep)
+    {
+      additiveIncreaseStep_ = additiveIncreaseStep;
+      return *this;
+    }
+
+    /**
+     * Set the multiplicative decrease factor.
+     * @param multiplicativeDecreaseFactor The factor, from 0 to 1.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setMultiplicativeDecreaseFactor(double multiplicativeDecreaseFactor)
+    {
+      multiplicativeDecreaseFactor_ = multiplicativeDecreaseFactor;
+      return *this;
+    }
+
+    /**
+     * Set the maximum number of times to retry an Interest for a segment.
+     * @param maxRetries The maximum number of retries.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setMaxRetries(int maxRetries)
+    {
+      maxRetries_ = maxRetries;
+      return *this;
+    }
+
+    /**
+     * Set the flag for whether to ignore the CongestionMark in Data packets.
+     * @param ignoreCongestionMarks True to ignore the CongestionMark.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setIgnoreCongestionMarks(bool ignoreCongestionMarks)
+    {
+      ignoreCongestionMarks_ = ignoreCongestionMarks;
+      return *this;
+    }
+
+    /**
+     * Set the OnSegment callback to stream the content. For details, see the
+     * documentation for the SegmentFetcher class.
+     * @param onSegment The callback which receives the segment number and the
+     * content of each segment in order. If onSegment throws an exception,
+     * fetching is aborted with ON_SEGMENT_ERROR. A copy of this function object
+     * is made. If this is a null callback, concatenate the content for
+     * OnComplete.
+     * @return This Options so that you can chain calls to update values.
+     */
+    Options&
+    setOnSegment(const OnSegment& onSegment)
+    {
+      onSegment_ = onSegment;
+      return *this;
+    }
+
+  private:
+    OnSegment onSegment_;
+    double initialWindowSize_;
+    double maxWindowSize_;
+    double initialSlowStartThreshold_;
+    double additiveIncreaseStep_;
+    double multiplicativeDecreaseFactor_;
+    int maxRetries_;
+    bool ignoreCongestionMarks_;
   };
 
   typedef func_lib::function<bool(const ptr_lib::shared_ptr<Data>& data)> VerifySegment;
@@ -105,6 +330,17 @@ public:
   static bool
   DontVerifySegment(const ptr_lib::shared_ptr<Data>& data);
 
+  /**
+   * Make an OnSegment callback which writes the content of each segment to the
+   * file descriptor, to use in Options.setOnSegment.
+   * @param fileDescriptor The open file descriptor, such as a file or a pipe.
+   * The caller must close it after fetching is finished.
+   * @return The OnSegment callback, which throws a runtime_error if the write
+   * fails.
+   */
+  static OnSegment
+  makeFileDescriptorSink(int fileDescriptor);
+
   /**
    * Initiate segment fetching. For more details, see the documentation for
    * the class.
@@ -133,11 +369,14 @@ public:
    * NOTE: The library will log any exceptions thrown by this callback, but for
    * better error handling the callback should catch and properly handle any
    * exceptions.
+   * @param options (optional) The parameters of the window and retransmission.
+   * If omitted, use the default Options().
    */
   static void
   fetch
     (Face& face, const Interest &baseInterest, const VerifySegment& verifySegment,
-     const OnComplete& onComplete, const OnError& onError);
+     const OnComplete& onComplete, const OnError& onError,
+     const Options& options = Options());
 
   /**
    * Initiate segment fetching. For more details, see the documentation for
@@ -165,13 +404,34 @@ public:
    * NOTE: The library will log any exceptions thrown by this callback, but for
    * better error handling the callback should catch and properly handle any
    * exceptions.
+   * @param options (optional) The parameters of the window and retransmission.
+   * If omitted, use the default Options().
    */
   static void
   fetch
     (Face& face, const Interest &baseInterest, KeyChain* validatorKeyChain,
-     const OnComplete& onComplete, const OnError& onError);
+     const OnComplete& onComplete, const OnError& onError,
+     const Options& options = Options());
 
 private:
+  /**
+   * A SegmentState is the state of the outstanding Interest for a segment.
+   */
+  class SegmentState {
+  public:
+    SegmentState()
+    : pendingInterestId_(0), transmission_(0), nRetries_(0), sendTime_(0)
+    {
+    }
+
+    uint64_t pendingInterestId_;
+    // The value of transmissionCount_ when the Interest was sent, to ignore a
+    // callback for a previous transmission.
+    uint64_t transmission_;
+    int nRetries_;
+    MillisecondsSince1970 sendTime_;
+  };
+
   /**
    * Create a new SegmentFetcher to use the Face. See the static fetch method
    * for details. If validatorKeyChain is not null, use it and ignore
@@ -179,35 +439,130 @@ private:
    */
   SegmentFetcher
     (Face& face, KeyChain* validatorKeyChain, const VerifySegment& verifySegment,
-     const OnComplete& onComplete, const OnError& onError)
-  : face_(face), validatorKeyChain_(validatorKeyChain), verifySegment_(verifySegment),
-    onComplete_(onComplete), onError_(onError)
-  {
-  }
+     const OnComplete& onComplete, const OnError& onError,
+     const Options& options);
 
   void
   fetchFirstSegment(const Interest& baseInterest);
 
+  /**
+   * Send Interests for the segments to retransmit and then the next segments
+   * while there is room in the window.
+   */
+  void
+  sendInterests();
+
+  /**
+   * Express the Interest for the segment and start its retransmission timer.
+   * @param segment The segment number.
+   * @param nRetries The number of times the segment was already retried.
+   */
   void
-  fetchNextSegment
-    (const Interest& originalInterest, const Name& dataName, uint64_t segment);
+  sendInterest(uint64_t segment, int nRetries);
 
+  /**
+   * This is the OnData callback for each Interest. Update the window and RTT
+   * estimate, then verify the Data packet.
+   * @param segment The requested segment number, or 0 for the first Interest.
+   * @param transmission The value of transmissionCount_ when the Interest was
+   * sent.
+   */
   void
   onSegmentReceived
-    (const ptr_lib::shared_ptr<const Interest>& originalInterest,
-     const ptr_lib::shared_ptr<Data>& data);
+    (const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<Data>& data, uint64_t segment,
+     uint64_t transmission);
 
+  /**
+   * Save the content of the verified segment, and finish or send more
+   * Interests.
+   */
   void
-  onVerified
-    (const ptr_lib::shared_ptr<Data>& data,
-     const ptr_lib::shared_ptr<const Interest>& originalInterest);
+  onVerified(const ptr_lib::shared_ptr<Data>& data);
 
   void
   onValidationFailed
     (const ptr_lib::shared_ptr<Data>& data, const std::string& reason);
 
   void
-  onTimeout(const ptr_lib::shared_ptr<const Interest>& interest);
+  onTimeout
+    (const ptr_lib::shared_ptr<const Interest>& interest, uint64_t segment,
+     uint64_t transmission);
+
+  void
+  onNetworkNack
+    (const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack, uint64_t segment,
+     uint64_t transmission);
+
+  /**
+   * This is called by callLater when the retransmission timeout for the
+   * segment expires. If the Interest is still outstanding, treat the segment
+   * as lost.
+   */
+  void
+  onRetransmissionTimeout(uint64_t segment, uint64_t transmission);
+
+  /**
+   * Find the outstanding segment for the Interest transmission.
+   * @return The entry in outstanding_, or outstanding_.end() if the
+   * transmission is not outstanding.
+   */
+  std::map<uint64_t, SegmentState>::iterator
+  findOutstanding(uint64_t segment, uint64_t transmission);
+
+  /**
+   * Remove the outstanding segment and schedule it to retry, or call onError
+   * if there are no more retries.
+   * @param segment The entry in outstanding_.
+   * @param isCongestion True if this is a sign of congestion, to shrink the
+   * window.
+   * @param errorCode The error code if there are no more retries.
+   * @param message The error message if there are no more retries.
+   */
+  void
+  onSegmentLost
+    (std::map<uint64_t, SegmentState>::iterator segment, bool isCongestion,
+     ErrorCode errorCode, const std::string& message);
+
+  /**
+   * If the segment is at or after the recovery point, shrink the window and
+   * set the recovery point to the next segment to send, so that the window
+   * shrinks at most once for the segments lost in one window.
+   */
+  void
+  decreaseWindow(uint64_t segment);
+
+  /**
+   * Grow the window for a received segment.
+   */
+  void
+  increaseWindow();
+
+  /**
+   * Remove the outstanding Interests, mark this as finished and call onError.
+   */
+  void
+  finishWithError(ErrorCode errorCode, const std::string& message);
+
+  /**
+   * Concatenate the received segments and call onComplete. If streaming, call
+   * onComplete with an isNull Blob.
+   */
+  void
+  finishWithContent();
+
+  /**
+   * Call the OnSegment callback for each received segment in order starting
+   * from nextDeliverSegment_, and remove it from contentParts_.
+   * @return False if OnSegment threw an exception and this called
+   * finishWithError, otherwise true.
+   */
+  bool
+  deliverSegments();
+
+  static void
+  writeToFileDescriptor(int fileDescriptor, uint64_t segment, const Blob& content);
 
   /**
    * Check if the last component in the name is a segment number.
@@ -220,12 +575,35 @@ private:
     return name.size() >= 1 && name.get(-1).isSegment();
   }
 
-  std::vector<Blob> contentParts_;
   Face& face_;
   KeyChain* validatorKeyChain_;
   VerifySegment verifySegment_;
   OnComplete onComplete_;
   OnError onError_;
+  Options options_;
+  ptr_lib::shared_ptr<RttEstimator> rttEstimator_;
+  Interest baseInterest_;
+  // The name with the version, from the first received Data packet.
+  Name versionedPrefix_;
+  bool isFinished_;
+  bool isSendingInterests_;
+  // The state of the first Interest which discovers the version.
+  SegmentState firstInterest_;
+  uint64_t transmissionCount_;
+  double windowSize_;
+  double slowStartThreshold_;
+  // The window only shrinks for a segment at or after the recovery point.
+  uint64_t recoveryPoint_;
+  uint64_t nextSegment_;
+  bool hasFinalSegment_;
+  uint64_t finalSegment_;
+  std::map<uint64_t, SegmentState> outstanding_;
+  // The segments to retry, with the number of times already retried.
+  std::map<uint64_t, int> retryQueue_;
+  // The received content. If streaming, this is the reorder buffer of the
+  // segments after nextDeliverSegment_.
+  std::map<uint64_t, Blob> contentParts_;
+  uint64_t nextDeliverSegment_;
 };
 
 }
@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_SEGMENTER_HPP
+#define NDN_SEGMENTER_HPP
+
+#include <string>
+#include <vector>
+#include "../face.hpp"
+#include "../security/key-chain.hpp"
+#include "memory-content-cache.hpp"
+
+namespace ndn {
+
+/**
+ * A Segmenter makes the signed Data packets for the segments of a large
+ * object, to be fetched with SegmentFetcher. Each segment is named
+ * /<versionedPrefix>/<segment> and has the FinalBlockId of the last segment.
+ * The segments are signed in parallel by the number of threads given to the
+ * constructor. The first segment is signed on the calling thread, which loads
+ * the signing key, and the remaining segments are split among the calling
+ * thread and a pool of worker threads, which only use the Tpm. The worker
+ * threads are started by the constructor and stopped by the destructor, so
+ * they are reused by each call to segment. The application must not change
+ * the KeyChain from another thread during a call to segment.
+ *
+ * The segments can be returned, added to a MemoryContentCache, or made and
+ * signed lazily when an Interest is received by setInterestFilter.
+ */
+class Segmenter {
+public:
+  /**
+   * Create a Segmenter to sign with the given KeyChain.
+   * @param keyChain The KeyChain for signing. This does not make a copy, so
+   * the KeyChain must remain valid for the life of this object.
+   * @param signingInfo (optional) The SigningInfo for KeyChain.sign. If
+   * omitted, use the default SigningInfo.
+   * @param nThreads (optional) The number of threads to sign with, including
+   * the calling thread, so that this starts nThreads - 1 worker threads. If
+   * omitted, use 1 which signs on the calling thread.
+   */
+  Segmenter
+    (KeyChain& keyChain, const SigningInfo& signingInfo = SigningInfo(),
+     size_t nThreads = 1);
+
+  /**
+   * Stop and join the worker threads.
+   */
+  ~Segmenter();
+
+  /**
+   * Split the content into segments and sign each Data packet.
+   * @param content The content to split.
+   * @param versionedPrefix The name prefix of the segments, which normally
+   * ends in a version component.
+   * @param maxSegmentSize The maximum number of content bytes in a segment.
+   * @param freshnessPeriod The freshness period of each Data packet in
+   * milliseconds. If negative, don't set it.
+   * @param segments Append the Data packets for the segments to this vector,
+   * in order of segment number. There is at least one segment, even if the
+   * content is empty.
+   * @throws runtime_error If maxSegmentSize is 0 or signing fails.
+   */
+  void
+  segment
+    (const Blob& content, const Name& versionedPrefix, size_t maxSegmentSize,
+     Milliseconds freshnessPeriod,
+     std::vector<ptr_lib::shared_ptr<Data> >& segments);
+
+  /**
+   * Split the content of the file into segments and sign each Data packet.
+   * Where supported, the file is memory-mapped so that the content of each
+   * segment is copied directly from the file pages without reading the whole
+   * file into a buffer.
+   * @param filePath The path of the file to split.
+   * @param versionedPrefix The name prefix of the segments.
+   * @param maxSegmentSize The maximum number of content bytes in a segment.
+   * @param freshnessPeriod The freshness period of each Data packet in
+   * milliseconds. If negative, don't set it.
+   * @param segments Append the Data packets for the segments to this vector.
+   * @throws runtime_error If the file can't be read, maxSegmentSize is 0 or
+   * signing fails.
+   */
+  void
+  segmentFile
+    (const std::string& filePath, const Name& versionedPrefix,
+     size_t maxSegmentSize, Milliseconds freshnessPeriod,
+     std::vector<ptr_lib::shared_ptr<Data> >& segments);
+
+  /**
+   * Split the content into segments, sign them and add each to the
+   * MemoryContentCache, which satisfies any pending interests.
+   * @param content The content to split.
+   * @param versionedPrefix The name prefix of the segments.
+   * @param maxSegmentSize The maximum number of content bytes in a segment.
+   * @param freshnessPeriod The freshness period of each Data packet in
+   * milliseconds. If negative, don't set it.
+   * @param memoryContentCache The MemoryContentCache to add the segments to.
+   * @return The number of segments.
+   */
+  size_t
+  addToCache
+    (const Blob& content, const Name& versionedPrefix, size_t maxSegmentSize,
+     Milliseconds freshnessPeriod, MemoryContentCache& memoryContentCache);
+
+  /**
+   * Call face.setInterestFilter to answer Interests for the segments of the
+   * content by making and signing the requested segment when the Interest is
+   * received, instead of signing all the segments in advance. An Interest for
+   * /<versionedPrefix>/<segment> gets that segment. An Interest whose name is
+   * a prefix of versionedPrefix, such as the first Interest from
+   * SegmentFetcher, gets segment 0. This does not register the prefix with the
+   * forwarder.
+   * @param face The Face for setInterestFilter and to send the Data packets.
+   * @param content The content to split. This keeps a pointer to the Blob's
+   * bytes, which are not copied.
+   * @param versionedPrefix The name prefix of the segments. If the last
+   * component is a version, the Interest filter is for the name without the
+   * version so that it gets the first Interest from SegmentFetcher.
+   * @param maxSegmentSize The maximum number of content bytes in a segment.
+   * @param freshnessPeriod The freshness period of each Data packet in
+   * milliseconds. If negative, don't set it.
+   * @return The interest filter ID from face.setInterestFilter, which can be
+   * used in face.unsetInterestFilter.
+   * @throws runtime_error If maxSegmentSize is 0.
+   */
+  uint64_t
+  setInterestFilter
+    (Face& face, const Blob& content, const Name& versionedPrefix,
+     size_t maxSegmentSize, Milliseconds freshnessPeriod);
+
+  /**
+   * Get the number of segments for content of the given size.
+   * @param contentSize The number of bytes in the content.
+   * @param maxSegmentSize The maximum number of content bytes in a segment.
+   * @return The number of segments, which is at least 1.
+   */
+  static uint64_t
+  getSegmentCount(size_t contentSize, size_t maxSegmentSize)
+  {
+    if (contentSize == 0)
+      return 1;
+    return (contentSize + maxSegmentSize - 1) / maxSegmentSize;
+  }
+
+private:
+  class SignTask;
+  class WorkerPool;
+  class Server;
+
+  /**
+   * Make and sign the segments of the content in the buffer, using the
+   * threads.
+   */
+  void
+  segment
+    (const uint8_t* buffer, size_t bufferLength, const Name& versionedPrefix,
+     size_t maxSegmentSize, Milliseconds freshnessPeriod,
+     std::vector<ptr_lib::shared_ptr<Data> >& segments);
+
+  /**
+   * Make the unsigned Data packet for the segment.
+   */
+  static ptr_lib::shared_ptr<Data>
+  makeSegment
+    (const uint8_t* buffer, size_t bufferLength, const Name& versionedPrefix,
+     size_t maxSegmentSize, Milliseconds freshnessPeriod, uint64_t segment);
+
+  /**
+   * Sign the data with the key from the Signature of the first segment. This
+   * only uses the Tpm, so it can be called from multiple threads.
+   * @param data The Data packet to sign.
+   * @param signatureTemplate The Signature of the first segment.
+   * @param keyName The key name of the first segment, or the DigestSha256
+   * identity.
+   */
+  void
+  signLikeFirstSegment
+    (Data& data, const Signature& signatureTemplate, const Name& keyName);
+
+  // Disable the copy constructor and assignment operator.
+  Segmenter(const Segmenter& other);
+  Segmenter& operator=(const Segmenter& other);
+
+  KeyChain& keyChain_;
+  SigningInfo signingInfo_;
+  size_t nThreads_;
+  ptr_lib::shared_ptr<WorkerPool> workerPool_;
+};
+
+}
+
+#endif
@@ -107,7 +107,18 @@ ndn_Error ndn_ElementReader_onReceivedData
       }
 
       if (!self->gotPartialDataError) {
-        if (self->partialDataLength + dataLength > MAX_NDN_PACKET_SIZE) {
+        size_t neededLength = self->partialDataLength + dataLength;
+        if (self->tlvStructureDecoder.state ==
+            ndn_TlvStructureDecoder_READ_VALUE_BYTES) {
+          // We know the length of the whole element, so check it now and
+          // allocate partialData once instead of growing it on each call.
+          if (self->tlvStructureDecoder.nBytesToRead > MAX_NDN_PACKET_SIZE)
+            neededLength = MAX_NDN_PACKET_SIZE + 1;
+          else
+            neededLength += self->tlvStructureDecoder.nBytesToRead;
+        }
+
+        if (neededLength > MAX_NDN_PACKET_SIZE) {
           // Reset to read a new element on the next call.
           self->usePartialData = 0;
           ndn_TlvStructureDecoder_initialize(&self->tlvStructureDecoder);
@@ -115,7 +126,9 @@ ndn_Error ndn_ElementReader_onReceivedData
           return NDN_ERROR_ElementReader_The_incoming_packet_exceeds_the_maximum_limit_getMaxNdnPacketSize;
         }
 
-        if ((error = ndn_DynamicUInt8Array_copy
+        if ((error = ndn_DynamicUInt8Array_ensureLength
+             (self->partialData, neededLength)) ||
+            (error = ndn_DynamicUInt8Array_copy
              (self->partialData, data, dataLength, self->partialDataLength))) {
           // Set gotPartialDataError so we won't call onReceivedElement with invalid data.
           self->gotPartialDataError = 1;
@@ -128,3 +141,65 @@ ndn_Error ndn_ElementReader_onReceivedData
     }
   }
 }
+
+void ndn_ElementReader_getReceiveBuffer
+  (struct ndn_ElementReader *self, uint8_t **buffer, size_t *bufferLength)
+{
+  size_t nBytesToRead = self->tlvStructureDecoder.nBytesToRead;
+
+  *buffer = 0;
+  *bufferLength = 0;
+  if (!self->usePartialData || self->gotPartialDataError ||
+      self->tlvStructureDecoder.gotElementEnd ||
+      self->tlvStructureDecoder.state != ndn_TlvStructureDecoder_READ_VALUE_BYTES ||
+      nBytesToRead == 0)
+    // The caller should use ndn_ElementReader_onReceivedData.
+    return;
+
+  // onReceivedData already allocated partialData for the whole element, so
+  // this normally doesn't reallocate.
+  if (ndn_DynamicUInt8Array_ensureLength
+      (self->partialData, self->partialDataLength + nBytesToRead))
+    // Let ndn_ElementReader_onReceivedData report the error.
+    return;
+
+  *buffer = self->partialData->array + self->partialDataLength;
+  *bufferLength = nBytesToRead;
+}
+
+ndn_Error ndn_ElementReader_onReceivedInPlace
+  (struct ndn_ElementReader *self, size_t nBytes)
+{
+  ndn_Error error;
+
+  // The received bytes are already in partialData. Just continue scanning them.
+  ndn_TlvStructureDecoder_seek(&self->tlvStructureDecoder, 0);
+  error = ndn_TlvStructureDecoder_findElementEnd
+    (&self->tlvStructureDecoder,
+     self->partialData->array + self->partialDataLength, nBytes);
+  if (error) {
+    // Reset to read a new element on the next call.
+    self->usePartialData = 0;
+    ndn_TlvStructureDecoder_initialize(&self->tlvStructureDecoder);
+
+    return error;
+  }
+  self->partialDataLength += nBytes;
+
+  if (!self->tlvStructureDecoder.gotElementEnd)
+    // Wait for more data.
+    return NDN_ERROR_success;
+
+  if (!self->elementListener)
+    return NDN_ERROR_ElementReader_ElementListener_is_not_specified;
+
+  // Reset to read a new object. Do this before calling onReceivedElement
+  // in case it throws an exception.
+  self->usePartialData = 0;
+  ndn_TlvStructureDecoder_initialize(&self->tlvStructureDecoder);
+
+  (*self->elementListener->onReceivedElement)
+    (self->elementListener, self->partialData->array, self->partialDataLength);
+
+  return NDN_ERROR_success;
+}
@@ -79,6 +79,40 @@ static __inline void ndn_ElementReader_reset
 ndn_Error ndn_ElementReader_onReceivedData
   (struct ndn_ElementReader *self, const uint8_t *data, size_t dataLength);
 
+/**
+ * If this ElementReader is in the middle of reading the value bytes of an
+ * element which is saved in partialData, return a pointer into partialData
+ * where the remaining bytes of the element can be received directly, without
+ * first receiving into a separate buffer and copying. The returned buffer
+ * length is exactly the number of bytes remaining in the element, so that
+ * receiving into it never reads past the end of the element. After receiving,
+ * you must call ndn_ElementReader_onReceivedInPlace. If this ElementReader is
+ * not in the middle of an element's value, then set buffer to 0 and the
+ * caller should receive into its own buffer and call
+ * ndn_ElementReader_onReceivedData as usual.
+ * @param self pointer to the ndn_ElementReader struct
+ * @param buffer Set buffer to the pointer into partialData, or 0 if the caller
+ * should use ndn_ElementReader_onReceivedData. The buffer is only valid until
+ * the next call to a function on this ElementReader.
+ * @param bufferLength Set bufferLength to the number of bytes which can be
+ * received into buffer, or 0 if buffer is 0.
+ */
+void ndn_ElementReader_getReceiveBuffer
+  (struct ndn_ElementReader *self, uint8_t **buffer, size_t *bufferLength);
+
+/**
+ * Update the state after receiving nBytes into the buffer returned by
+ * ndn_ElementReader_getReceiveBuffer. If this completes the element, then call
+ * (*elementListener->onReceivedElement)(element, elementLength) with the
+ * element in partialData.
+ * @param self pointer to the ndn_ElementReader struct
+ * @param nBytes The number of bytes received into the buffer. This must not be
+ * greater than the bufferLength from ndn_ElementReader_getReceiveBuffer.
+ * @return 0 for success, else an error code
+ */
+ndn_Error ndn_ElementReader_onReceivedInPlace
+  (struct ndn_ElementReader *self, size_t nBytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,7 @@
 #include <sys/un.h>
 #include <arpa/inet.h>
 #include <poll.h>
+#include <fcntl.h>
 #include "../util/ndn_memory.h"
 #include "socket-transport.h"
 #include <errno.h>
@@ -111,6 +112,8 @@ ndn_Error ndn_SocketTransport_connect
   }
 
   self->socketDescriptor = socketDescriptor;
+  self->isDatagram = (socketType == SOCKET_UDP);
+
   return NDN_ERROR_success;
 }
 
@@ -161,6 +164,84 @@ ndn_Error ndn_SocketTransport_receiveIsReady(struct ndn_SocketTransport *self, i
   return NDN_ERROR_success;
 }
 
+ndn_Error ndn_SocketTransport_waitForReceive
+  (struct ndn_SocketTransport *self, int timeoutMilliseconds)
+{
+  struct pollfd pollInfo[2];
+  int pollResult;
+
+  if (self->socketDescriptor < 0)
+    // The socket is not open.  Just silently return.
+    return NDN_ERROR_success;
+
+  pollInfo[0].fd = self->socketDescriptor;
+  pollInfo[0].events = POLLIN;
+  // poll ignores a negative descriptor if the wake up pipe is not open.
+  pollInfo[1].fd = self->wakeUpDescriptors[0];
+  pollInfo[1].events = POLLIN;
+  pollInfo[1].revents = 0;
+
+  pollResult = poll(pollInfo, 2, timeoutMilliseconds);
+  if (pollResult < 0) {
+    if (errno == EINTR)
+      // Interrupted by a signal. Let the caller process events and wait again.
+      return NDN_ERROR_success;
+    return NDN_ERROR_SocketTransport_error_in_poll;
+  }
+
+  if (pollInfo[1].revents & POLLIN) {
+    // Drain the wake up pipe so that the next wait blocks.
+    uint8_t drainBuffer[64];
+    while (read(self->wakeUpDescriptors[0], drainBuffer, sizeof(drainBuffer)) > 0) {}
+  }
+
+  return NDN_ERROR_success;
+}
+
+void ndn_SocketTransport_openWakeUp(struct ndn_SocketTransport *self)
+{
+  if (self->wakeUpDescriptors[0] >= 0)
+    // Already open.
+    return;
+
+  // Use non-blocking so that wakeUp doesn't block if the pipe is full and
+  // waitForReceive can drain it.
+  if (pipe(self->wakeUpDescriptors) != 0) {
+    // We can still receive, but waitForReceive can't be interrupted.
+    self->wakeUpDescriptors[0] = -1;
+    self->wakeUpDescriptors[1] = -1;
+    return;
+  }
+  fcntl(self->wakeUpDescriptors[0], F_SETFL,
+        fcntl(self->wakeUpDescriptors[0], F_GETFL) | O_NONBLOCK);
+  fcntl(self->wakeUpDescriptors[1], F_SETFL,
+        fcntl(self->wakeUpDescriptors[1], F_GETFL) | O_NONBLOCK);
+}
+
+void ndn_SocketTransport_closeWakeUp(struct ndn_SocketTransport *self)
+{
+  if (self->wakeUpDescriptors[0] < 0)
+    return;
+
+  close(self->wakeUpDescriptors[0]);
+  close(self->wakeUpDescriptors[1]);
+  self->wakeUpDescriptors[0] = -1;
+  self->wakeUpDescriptors[1] = -1;
+}
+
+void ndn_SocketTransport_wakeUp(struct ndn_SocketTransport *self)
+{
+  uint8_t value = 0;
+  ssize_t ignoreResult;
+
+  if (self->wakeUpDescriptors[1] < 0)
+    return;
+
+  // Ignore errors. If the pipe is full, then a wake up is already pending.
+  ignoreResult = write(self->wakeUpDescriptors[1], &value, 1);
+  (void)ignoreResult;
+}
+
 ndn_Error ndn_SocketTransport_receive
   (struct ndn_SocketTransport *self, uint8_t *buffer, size_t bufferLength, size_t *nBytesOut)
 {
@@ -185,12 +266,36 @@ ndn_SocketTransport_processEvents
     int receiveIsReady;
     ndn_Error error;
     size_t nBytes;
+    uint8_t *elementBuffer;
+    size_t elementBufferLength;
     if ((error = ndn_SocketTransport_receiveIsReady
          (self, &receiveIsReady)))
       return error;
     if (!receiveIsReady)
       return NDN_ERROR_success;
 
+    if (self->isDatagram)
+      // A datagram is truncated if the receive buffer is smaller, so always
+      // use the full buffer.
+      elementBuffer = 0;
+    else
+      ndn_ElementReader_getReceiveBuffer
+        (&self->elementReader, &elementBuffer, &elementBufferLength);
+    if (elementBuffer) {
+      // We are in the middle of a large element. Receive the rest of it
+      // directly into the ElementReader's buffer instead of copying.
+      if ((error = ndn_SocketTransport_receive
+           (self, elementBuffer, elementBufferLength, &nBytes)))
+        return error;
+      if (nBytes == 0)
+        return NDN_ERROR_success;
+
+      if ((error = ndn_ElementReader_onReceivedInPlace
+           (&self->elementReader, nBytes)))
+        return error;
+      continue;
+    }
+
     if ((error = ndn_SocketTransport_receive
          (self, buffer, bufferLength, &nBytes)))
       return error;
@@ -213,6 +318,8 @@ ndn_Error ndn_SocketTransport_close(struct ndn_SocketTransport *self)
     return NDN_ERROR_SocketTransport_error_in_close;
 
   self->socketDescriptor = -1;
+  // Leave the wake up pipe open since another thread may be calling
+  // ndn_SocketTransport_wakeUp. ndn_SocketTransport_closeWakeUp closes it.
 
   return NDN_ERROR_success;
 }
@@ -51,6 +51,9 @@ static __inline void ndn_SocketTransport_initialize
   (struct ndn_SocketTransport *self, struct ndn_DynamicUInt8Array *buffer)
 {
   self->socketDescriptor = -1;
+  self->isDatagram = 0;
+  self->wakeUpDescriptors[0] = -1;
+  self->wakeUpDescriptors[1] = -1;
   ndn_ElementReader_initialize(&self->elementReader, 0, buffer);
 }
 
@@ -89,6 +92,46 @@ ndn_Error ndn_SocketTransport_send(struct ndn_SocketTransport *self, const uint8
  */
 ndn_Error ndn_SocketTransport_receiveIsReady(struct ndn_SocketTransport *self, int *receiveIsReady);
 
+/**
+ * Block until there is data ready on the socket to be received, until
+ * ndn_SocketTransport_wakeUp is called (possibly from another thread), or until
+ * the timeout, whichever comes first.
+ * @param self A pointer to the ndn_SocketTransport struct.
+ * @param timeoutMilliseconds The maximum time to wait in milliseconds. If this
+ * is 0, just check and return immediately.
+ * @return 0 for success, else an error code.
+ */
+ndn_Error ndn_SocketTransport_waitForReceive
+  (struct ndn_SocketTransport *self, int timeoutMilliseconds);
+
+/**
+ * Open the pipe used by ndn_SocketTransport_wakeUp. This is separate from
+ * ndn_SocketTransport_connect so that the pipe stays open across close and
+ * reconnect while another thread may call ndn_SocketTransport_wakeUp. If the
+ * pipe is already open, this does nothing. If the pipe can't be opened,
+ * ndn_SocketTransport_waitForReceive still works but can't be woken up.
+ * @param self A pointer to the ndn_SocketTransport struct.
+ */
+void ndn_SocketTransport_openWakeUp(struct ndn_SocketTransport *self);
+
+/**
+ * Close the pipe opened by ndn_SocketTransport_openWakeUp. Only call this when
+ * no other thread can call ndn_SocketTransport_wakeUp, such as when destroying
+ * the transport.
+ * @param self A pointer to the ndn_SocketTransport struct.
+ */
+void ndn_SocketTransport_closeWakeUp(struct ndn_SocketTransport *self);
+
+/**
+ * Make a call to ndn_SocketTransport_waitForReceive which is blocked in another
+ * thread return immediately. If nobody is waiting, then the next call to
+ * ndn_SocketTransport_waitForReceive returns immediately. This is thread-safe,
+ * including with ndn_SocketTransport_close. If the wake up pipe is not open
+ * (see ndn_SocketTransport_openWakeUp), this does nothing.
+ * @param self A pointer to the ndn_SocketTransport struct.
+ */
+void ndn_SocketTransport_wakeUp(struct ndn_SocketTransport *self);
+
 /**
  * Receive data from the socket.  NOTE: This is a blocking call.  You should first call ndn_SocketTransport_receiveIsReady
  * to make sure there is data ready to receive.
@@ -121,7 +164,8 @@ ndn_SocketTransport_processEvents
   (struct ndn_SocketTransport *self, uint8_t *buffer, size_t bufferLength);
 
 /**
- * Close the socket.
+ * Close the socket. This leaves the wake up pipe open (see
+ * ndn_SocketTransport_closeWakeUp).
  * @param self A pointer to the ndn_SocketTransport struct.
  * @return 0 for success, else an error code.
  */
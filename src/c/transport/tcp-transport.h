@@ -112,6 +112,52 @@ ndn_TcpTransport_processEvents
   return ndn_SocketTransport_processEvents(&self->base, buffer, bufferLength);
 }
 
+/**
+ * Block until there is data ready on the socket to be received, until
+ * ndn_TcpTransport_wakeUp is called, or until the timeout.
+ * @param self A pointer to the ndn_TcpTransport struct.
+ * @param timeoutMilliseconds The maximum time to wait in milliseconds.
+ * @return 0 for success, else an error code.
+ */
+static __inline ndn_Error
+ndn_TcpTransport_waitForReceive
+  (struct ndn_TcpTransport *self, int timeoutMilliseconds)
+{
+  return ndn_SocketTransport_waitForReceive(&self->base, timeoutMilliseconds);
+}
+
+/**
+ * Open the pipe used by ndn_TcpTransport_wakeUp.
+ * @param self A pointer to the ndn_TcpTransport struct.
+ */
+static __inline void
+ndn_TcpTransport_openWakeUp(struct ndn_TcpTransport *self)
+{
+  ndn_SocketTransport_openWakeUp(&self->base);
+}
+
+/**
+ * Close the pipe opened by ndn_TcpTransport_openWakeUp. Only call this when
+ * no other thread can call ndn_TcpTransport_wakeUp.
+ * @param self A pointer to the ndn_TcpTransport struct.
+ */
+static __inline void
+ndn_TcpTransport_closeWakeUp(struct ndn_TcpTransport *self)
+{
+  ndn_SocketTransport_closeWakeUp(&self->base);
+}
+
+/**
+ * Make a call to ndn_TcpTransport_waitForReceive which is blocked in another
+ * thread return immediately. This is thread-safe.
+ * @param self A pointer to the ndn_TcpTransport struct.
+ */
+static __inline void
+ndn_TcpTransport_wakeUp(struct ndn_TcpTransport *self)
+{
+  ndn_SocketTransport_wakeUp(&self->base);
+}
+
 /**
  * Close the socket.
  * @param self A pointer to the ndn_TcpTransport struct.
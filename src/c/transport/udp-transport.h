@@ -105,6 +105,52 @@ ndn_UdpTransport_processEvents
   return ndn_SocketTransport_processEvents(&self->base, buffer, bufferLength);
 }
 
+/**
+ * Block until there is data ready on the socket to be received, until
+ * ndn_UdpTransport_wakeUp is called, or until the timeout.
+ * @param self A pointer to the ndn_UdpTransport struct.
+ * @param timeoutMilliseconds The maximum time to wait in milliseconds.
+ * @return 0 for success, else an error code.
+ */
+static __inline ndn_Error
+ndn_UdpTransport_waitForReceive
+  (struct ndn_UdpTransport *self, int timeoutMilliseconds)
+{
+  return ndn_SocketTransport_waitForReceive(&self->base, timeoutMilliseconds);
+}
+
+/**
+ * Open the pipe used by ndn_UdpTransport_wakeUp.
+ * @param self A pointer to the ndn_UdpTransport struct.
+ */
+static __inline void
+ndn_UdpTransport_openWakeUp(struct ndn_UdpTransport *self)
+{
+  ndn_SocketTransport_openWakeUp(&self->base);
+}
+
+/**
+ * Close the pipe opened by ndn_UdpTransport_openWakeUp. Only call this when
+ * no other thread can call ndn_UdpTransport_wakeUp.
+ * @param self A pointer to the ndn_UdpTransport struct.
+ */
+static __inline void
+ndn_UdpTransport_closeWakeUp(struct ndn_UdpTransport *self)
+{
+  ndn_SocketTransport_closeWakeUp(&self->base);
+}
+
+/**
+ * Make a call to ndn_UdpTransport_waitForReceive which is blocked in another
+ * thread return immediately. This is thread-safe.
+ * @param self A pointer to the ndn_UdpTransport struct.
+ */
+static __inline void
+ndn_UdpTransport_wakeUp(struct ndn_UdpTransport *self)
+{
+  ndn_SocketTransport_wakeUp(&self->base);
+}
+
 /**
  * Close the socket.
  * @param self A pointer to the ndn_UdpTransport struct.
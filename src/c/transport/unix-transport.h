@@ -104,6 +104,52 @@ ndn_UnixTransport_processEvents
   return ndn_SocketTransport_processEvents(&self->base, buffer, bufferLength);
 }
 
+/**
+ * Block until there is data ready on the socket to be received, until
+ * ndn_UnixTransport_wakeUp is called, or until the timeout.
+ * @param self A pointer to the ndn_UnixTransport struct.
+ * @param timeoutMilliseconds The maximum time to wait in milliseconds.
+ * @return 0 for success, else an error code.
+ */
+static __inline ndn_Error
+ndn_UnixTransport_waitForReceive
+  (struct ndn_UnixTransport *self, int timeoutMilliseconds)
+{
+  return ndn_SocketTransport_waitForReceive(&self->base, timeoutMilliseconds);
+}
+
+/**
+ * Open the pipe used by ndn_UnixTransport_wakeUp.
+ * @param self A pointer to the ndn_UnixTransport struct.
+ */
+static __inline void
+ndn_UnixTransport_openWakeUp(struct ndn_UnixTransport *self)
+{
+  ndn_SocketTransport_openWakeUp(&self->base);
+}
+
+/**
+ * Close the pipe opened by ndn_UnixTransport_openWakeUp. Only call this when
+ * no other thread can call ndn_UnixTransport_wakeUp.
+ * @param self A pointer to the ndn_UnixTransport struct.
+ */
+static __inline void
+ndn_UnixTransport_closeWakeUp(struct ndn_UnixTransport *self)
+{
+  ndn_SocketTransport_closeWakeUp(&self->base);
+}
+
+/**
+ * Make a call to ndn_UnixTransport_waitForReceive which is blocked in another
+ * thread return immediately. This is thread-safe.
+ * @param self A pointer to the ndn_UnixTransport struct.
+ */
+static __inline void
+ndn_UnixTransport_wakeUp(struct ndn_UnixTransport *self)
+{
+  ndn_SocketTransport_wakeUp(&self->base);
+}
+
 /**
  * Close the socket.
  * @param self A pointer to the ndn_UnixTransport struct.
@@ -58,7 +58,7 @@ AccessManagerV2::Impl::initialize(const Name& dataset)
   kekData.getMetaInfo().setFreshnessPeriod(DEFAULT_KEK_FRESHNESS_PERIOD_MS);
   keyChain_->sign(kekData, SigningInfo(identity_));
   // A KEK looks like a certificate, but doesn't have a ValidityPeriod.
-  storage_.insert(kekData);
+  getStorage().insert(kekData);
 
   // Prepare the callbacks.
   class Callbacks {
@@ -74,7 +74,7 @@ AccessManagerV2::Impl::initialize(const Name& dataset)
        uint64_t interestFilterId,
        const ptr_lib::shared_ptr<const InterestFilter>& filter)
     {
-      ptr_lib::shared_ptr<Data> data = parent_->storage_.find(*interest);
+      ptr_lib::shared_ptr<Data> data = parent_->getStorage().find(*interest);
       if (data) {
         _LOG_TRACE("Serving " << data->getName() << " from InMemoryStorage");
         try {
@@ -173,7 +173,7 @@ AccessManagerV2::Impl::addMember(const CertificateV2& memberCertificate)
   kdkData->getMetaInfo().setFreshnessPeriod(DEFAULT_KDK_FRESHNESS_PERIOD_MS);
   keyChain_->sign(*kdkData, SigningInfo(identity_));
 
-  storage_.insert(*kdkData);
+  getStorage().insert(*kdkData);
 
   return kdkData;
 }
@@ -55,7 +55,7 @@ EncryptorV2::Impl::initialize()
        uint64_t interestFilterId,
        const ptr_lib::shared_ptr<const InterestFilter>& filter)
     {
-      ptr_lib::shared_ptr<Data> data = parent_->storage_.find(*interest);
+      ptr_lib::shared_ptr<Data> data = parent_->getStorage().find(*interest);
       if (data) {
         _LOG_TRACE("Serving " << data->getName() << " from InMemoryStorage");
         try {
@@ -322,7 +322,7 @@ EncryptorV2::Impl::makeAndPublishCkData(const EncryptError::OnError& onError)
     // FreshnessPeriod can serve as a soft access control for revoking access.
     ckData.getMetaInfo().setFreshnessPeriod(DEFAULT_CK_FRESHNESS_PERIOD_MS);
     keyChain_->sign(ckData, ckDataSigningInfo_);
-    storage_.insert(ckData);
+    getStorage().insert(ckData);
 
     _LOG_TRACE("Publishing CK data: " << ckData.getName());
     return true;
@@ -100,6 +100,48 @@ Face::setInterestLoopbackEnabled(bool interestLoopbackEnabled)
   node_->setInterestLoopbackEnabled(interestLoopbackEnabled);
 }
 
+void
+Face::setRttEstimationEnabled(bool rttEstimationEnabled)
+{
+  node_->setRttEstimationEnabled(rttEstimationEnabled);
+}
+
+void
+Face::setAdaptiveInterestLifetimeEnabled(bool adaptiveInterestLifetimeEnabled)
+{
+  node_->setAdaptiveInterestLifetimeEnabled(adaptiveInterestLifetimeEnabled);
+}
+
+void
+Face::setInterestAggregationEnabled(bool interestAggregationEnabled)
+{
+  node_->setInterestAggregationEnabled(interestAggregationEnabled);
+}
+
+uint64_t
+Face::getExpressedInterestCount() const
+{
+  return node_->getExpressedInterestCount();
+}
+
+uint64_t
+Face::getAggregatedInterestCount() const
+{
+  return node_->getAggregatedInterestCount();
+}
+
+bool
+Face::getRttEstimate(const Name& interestName, RttEstimator& estimate) const
+{
+  return node_->getRttEstimate(interestName, estimate);
+}
+
+void
+Face::getRttEstimates(map<Name, RttEstimator>& estimates) const
+{
+  node_->getRttEstimates(estimates);
+}
+
 uint64_t
 Face::expressInterest
   (const Interest& interest, const OnData& onData, const OnTimeout& onTimeout,
@@ -229,6 +271,13 @@ Face::processEvents()
   node_->processEvents();
 }
 
+void
+Face::processEvents(Milliseconds maxWaitMilliseconds)
+{
+  // Just call Node's processEvents.
+  node_->processEvents(maxWaitMilliseconds);
+}
+
 bool
 Face::isLocal()
 {
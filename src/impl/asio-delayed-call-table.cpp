@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include <ndn-cpp/ndn-cpp-config.h>
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <math.h>
+#include <boost/bind.hpp>
+#include "../c/util/time.h"
+#include "asio-delayed-call-table.hpp"
+
+using namespace std;
+
+namespace ndn {
+
+AsioDelayedCallTable::AsioDelayedCallTable(boost::asio::io_service& ioService)
+: timer_(ioService), timerCallTime_(-1)
+{
+}
+
+void
+AsioDelayedCallTable::callLater
+  (Milliseconds delayMilliseconds, const Face::Callback& callback)
+{
+  table_.callLater(delayMilliseconds, callback);
+
+  MillisecondsSince1970 callTime = ndn_getNowMilliseconds() + delayMilliseconds;
+  if (timerCallTime_ < 0 || callTime < timerCallTime_)
+    setTimer();
+}
+
+void
+AsioDelayedCallTable::setTimer()
+{
+  Milliseconds delayMilliseconds = table_.getNextDelayMilliseconds();
+  if (delayMilliseconds < 0) {
+    timerCallTime_ = -1;
+    return;
+  }
+
+  timerCallTime_ = ndn_getNowMilliseconds() + delayMilliseconds;
+  // This cancels a wait which is already set, which calls onTimer with
+  // operation_aborted. Round up so that the entry is timed out when the timer
+  // fires.
+  timer_.expires_from_now(boost::posix_time::microseconds
+    ((int64_t)ceil(delayMilliseconds * 1000.0)));
+  timer_.async_wait(boost::bind(&AsioDelayedCallTable::onTimer, this, _1));
+}
+
+void
+AsioDelayedCallTable::onTimer(const boost::system::error_code& errorCode)
+{
+  if (errorCode == boost::asio::error::operation_aborted)
+    // setTimer reset the timer, or this object was destroyed, so don't access
+    // any members.
+    return;
+
+  // Set timerCallTime_ earlier than any new call time so that a callback which
+  // calls callLater doesn't set the timer, since we set it below.
+  timerCallTime_ = 0;
+  try {
+    table_.callTimedOut();
+  } catch (...) {
+    // Keep the timer going for the remaining entries.
+    setTimer();
+    throw;
+  }
+  setTimer();
+}
+
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
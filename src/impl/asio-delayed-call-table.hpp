@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_ASIO_DELAYED_CALL_TABLE_HPP
+#define NDN_ASIO_DELAYED_CALL_TABLE_HPP
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include <ndn-cpp/ndn-cpp-config.h>
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <boost/asio.hpp>
+#include "delayed-call-table.hpp"
+
+namespace ndn {
+
+/**
+ * An AsioDelayedCallTable is an internal class which keeps the callbacks from
+ * callLater in a DelayedCallTable and uses one asio deadline_timer, set for the
+ * earliest call time, to call them. This is used instead of a deadline_timer
+ * for each call, which is allocated for each Interest timeout.
+ */
+class AsioDelayedCallTable {
+public:
+  /**
+   * Create an AsioDelayedCallTable whose timer uses the given io_service.
+   * @param ioService The io_service which calls the callbacks.
+   */
+  AsioDelayedCallTable(boost::asio::io_service& ioService);
+
+  /**
+   * Call callback() after the given delay. If the call time is earlier than
+   * the time for which the timer is set, then reset the timer. This must be
+   * called on the thread of the io_service.
+   * @param delayMilliseconds The delay in milliseconds.
+   * @param callback This calls callback() after the delay.
+   */
+  void
+  callLater(Milliseconds delayMilliseconds, const Face::Callback& callback);
+
+private:
+  /**
+   * Set the timer for the earliest entry in table_, or clear timerCallTime_ if
+   * table_ is empty.
+   */
+  void
+  setTimer();
+
+  /**
+   * This is called by the timer to call the timed-out callbacks and set the
+   * timer for the next entry.
+   */
+  void
+  onTimer(const boost::system::error_code& errorCode);
+
+  // Disable the copy constructor and assignment operator.
+  AsioDelayedCallTable(const AsioDelayedCallTable& other);
+  AsioDelayedCallTable& operator=(const AsioDelayedCallTable& other);
+
+  DelayedCallTable table_;
+  boost::asio::deadline_timer timer_;
+  // The call time for which timer_ is set, or -1 if it is not set.
+  MillisecondsSince1970 timerCallTime_;
+};
+
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
+
+#endif
@@ -31,10 +31,16 @@ void
 DelayedCallTable::callLater
   (Milliseconds delayMilliseconds, const Face::Callback& callback)
 {
-  ptr_lib::shared_ptr<Entry> entry(new Entry(delayMilliseconds, callback));
-  // Insert into table_, sorted on getCallTime().
-  table_.insert
-    (lower_bound(table_.begin(), table_.end(), entry, entryCompare_), entry);
+  ptr_lib::shared_ptr<Entry> entry =
+    ptr_lib::make_shared<Entry>(delayMilliseconds, callback);
+  // Insert into table_, sorted on getCallTime(). Usually the new entry has
+  // the latest call time, so append it. Otherwise use upper_bound so that
+  // entries with the same call time are called in the order they were added.
+  if (table_.size() == 0 || !entryCompare_(entry, table_.back()))
+    table_.push_back(entry);
+  else
+    table_.insert
+      (upper_bound(table_.begin(), table_.end(), entry, entryCompare_), entry);
 }
 
 void
@@ -51,6 +57,17 @@ DelayedCallTable::callTimedOut()
   }
 }
 
+Milliseconds
+DelayedCallTable::getNextDelayMilliseconds() const
+{
+  if (table_.size() == 0)
+    return -1;
+
+  // nowOffsetMilliseconds_ is only used for testing.
+  ndn_MillisecondsSince1970 now = ndn_getNowMilliseconds() + nowOffsetMilliseconds_;
+  return max(table_.front()->getCallTime() - now, 0.0);
+}
+
 DelayedCallTable::Entry::Entry
   (ndn_Milliseconds delayMilliseconds, const Face::Callback& callback)
   : callback_(callback),
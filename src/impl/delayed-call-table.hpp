@@ -50,6 +50,15 @@ public:
   void
   callTimedOut();
 
+  /**
+   * Get the time from now until the earliest entry should be called. This is
+   * quick since the table is sorted.
+   * @return The delay in milliseconds, which is 0 if the earliest entry is
+   * already timed out, or -1 if the table is empty.
+   */
+  Milliseconds
+  getNextDelayMilliseconds() const;
+
   /**
    * Set the offset when insert() and refresh() get the current time, which
    * should only be used for testing.
@@ -0,0 +1,882 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include <ndn-cpp/ndn-cpp-config.h>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+#include <map>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "../c/util/crypto.h"
+#include "../encoding/tlv-decoder.hpp"
+#include "mapped-content-store.hpp"
+
+using namespace std;
+
+namespace ndn {
+
+static const char MAGIC[8] = { 'N', 'D', 'N', 'C', 'S', '0', '0', '1' };
+static const size_t HEADER_FILE_SIZE = 4096;
+static const size_t INITIAL_RECORD_CAPACITY = 1024;
+static const size_t INITIAL_LINK_CAPACITY = 8192;
+static const uint64_t INITIAL_BUCKET_COUNT = 4096;
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+// nIndexedLinks while the hash table is being changed.
+static const uint64_t INDEX_CHANGING = (uint64_t)-1;
+// compact writes the new store in this subdirectory, then creates the
+// COMPACTED_FILE in it with the number of segments before moving the files.
+static const char COMPACTING_DIRECTORY[] = "/compacting";
+static const char COMPACTED_FILE[] = "/compacted";
+static const char* INDEX_FILES[] =
+  { "/index-header", "/index-records", "/index-links", "/index-buckets" };
+
+struct MappedContentStore::Header {
+  char magic[8];
+  uint64_t segmentSize;
+  // The number of committed records.
+  uint64_t nRecords;
+  // The number of records which flush synced to disk.
+  uint64_t nDurableRecords;
+  // A power of 2.
+  uint64_t nBuckets;
+  // The number of links in the hash table. If this is not the number of links
+  // of the committed records, open must rebuild the hash table.
+  uint64_t nIndexedLinks;
+  // The total length of the Data encodings of the committed records.
+  uint64_t nContentBytes;
+};
+
+struct MappedContentStore::Record {
+  uint32_t segment;
+  // The offset of the Data encoding in the segment.
+  uint32_t offset;
+  uint32_t length;
+  // The checksum of the encoding and staleTime.
+  uint32_t checksum;
+  // The offset of the Name TLV in the Data encoding.
+  uint32_t nameOffset;
+  uint32_t nameHeaderLength;
+  uint32_t nameValueLength;
+  uint32_t nComponents;
+  // The index of the link for the first name component. The record has a link
+  // for each prefix of its name.
+  uint64_t firstLink;
+  MillisecondsSince1970 staleTime;
+};
+
+struct MappedContentStore::Link {
+  // The hash of the encoding of the name prefix components.
+  uint64_t hash;
+  uint32_t record;
+  // 1 + the index of the next link in the hash table chain, or 0 for the end.
+  uint32_t next;
+};
+
+static uint64_t
+updateHash(uint64_t hash, const uint8_t* bytes, size_t length)
+{
+  // FNV-1a.
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+static uint32_t
+computeChecksum
+  (const uint8_t* encoding, size_t encodingLength,
+   MillisecondsSince1970 staleTime)
+{
+  uint64_t hash = updateHash(FNV_OFFSET_BASIS, encoding, encodingLength);
+  return (uint32_t)updateHash(hash, (const uint8_t*)&staleTime, sizeof(staleTime));
+}
+
+/**
+ * Find the Name in the Data encoding and compute the hash of each prefix.
+ * @param encoding The Data encoding.
+ * @param encodingLength The length of encoding.
+ * @param nameOffset Set this to the offset of the Name TLV.
+ * @param nameHeaderLength Set this to the length of the Name TLV type and
+ * length.
+ * @param nameValueLength Set this to the length of the Name TLV value.
+ * @param prefixHashes Set this to the hash of each prefix of the name, where
+ * prefixHashes[i] is for the prefix with i + 1 components.
+ * @throws runtime_error for an invalid encoding.
+ */
+static void
+parseName
+  (const uint8_t* encoding, size_t encodingLength, size_t& nameOffset,
+   size_t& nameHeaderLength, size_t& nameValueLength,
+   vector<uint64_t>& prefixHashes)
+{
+  TlvDecoder decoder(encoding, encodingLength);
+  decoder.readNestedTlvsStart(ndn_Tlv_Data);
+  nameOffset = decoder.offset;
+  size_t nameEndOffset = decoder.readNestedTlvsStart(ndn_Tlv_Name);
+  nameHeaderLength = decoder.offset - nameOffset;
+  nameValueLength = nameEndOffset - decoder.offset;
+
+  prefixHashes.clear();
+  uint64_t hash = FNV_OFFSET_BASIS;
+  while (decoder.offset < nameEndOffset) {
+    size_t componentOffset = decoder.offset;
+    decoder.readVarNumber();
+    uint64_t componentLength = decoder.readVarNumber();
+    if (componentLength > nameEndOffset - decoder.offset)
+      throw runtime_error("MappedContentStore: Invalid name component length");
+    decoder.seek(decoder.offset + (size_t)componentLength);
+
+    hash = updateHash
+      (hash, encoding + componentOffset, decoder.offset - componentOffset);
+    prefixHashes.push_back(hash);
+  }
+}
+
+/**
+ * Compare the name TLV values in the NDN canonical order.
+ * @return -1 if a comes before b, 1 if a comes after b, or 0 if equal.
+ */
+static int
+compareNameValues
+  (const uint8_t* a, size_t aLength, const uint8_t* b, size_t bLength)
+{
+  TlvDecoder aDecoder(a, aLength);
+  TlvDecoder bDecoder(b, bLength);
+  while (true) {
+    // A prefix comes before a longer name.
+    if (aDecoder.offset >= aLength)
+      return bDecoder.offset >= bLength ? 0 : -1;
+    if (bDecoder.offset >= bLength)
+      return 1;
+
+    uint64_t aType = aDecoder.readVarNumber();
+    uint64_t bType = bDecoder.readVarNumber();
+    if (aType != bType)
+      return aType < bType ? -1 : 1;
+
+    uint64_t aComponentLength = aDecoder.readVarNumber();
+    uint64_t bComponentLength = bDecoder.readVarNumber();
+    if (aComponentLength != bComponentLength)
+      return aComponentLength < bComponentLength ? -1 : 1;
+
+    int result = memcmp
+      (a + aDecoder.offset, b + bDecoder.offset, (size_t)aComponentLength);
+    if (result != 0)
+      return result < 0 ? -1 : 1;
+
+    aDecoder.seek(aDecoder.offset + (size_t)aComponentLength);
+    bDecoder.seek(bDecoder.offset + (size_t)bComponentLength);
+  }
+}
+
+#if NDN_CPP_HAVE_UNISTD_H
+
+MappedContentStore::MappedFile::~MappedFile()
+{
+  close();
+}
+
+void
+MappedContentStore::MappedFile::close()
+{
+  if (address_) {
+    munmap(address_, size_);
+    address_ = 0;
+  }
+  if (fileDescriptor_ >= 0) {
+    ::close(fileDescriptor_);
+    fileDescriptor_ = -1;
+  }
+  size_ = 0;
+}
+
+void
+MappedContentStore::MappedFile::open(const string& filePath, size_t minimumSize)
+{
+  filePath_ = filePath;
+  fileDescriptor_ = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fileDescriptor_ < 0)
+    throw runtime_error("MappedContentStore: Cannot open " + filePath);
+
+  struct stat fileStat;
+  if (fstat(fileDescriptor_, &fileStat) != 0)
+    throw runtime_error("MappedContentStore: Cannot stat " + filePath);
+  size_ = (size_t)fileStat.st_size;
+
+  if (size_ < minimumSize)
+    resize(minimumSize);
+  else
+    map();
+}
+
+void
+MappedContentStore::MappedFile::resize(size_t newSize)
+{
+  if (address_ && newSize <= size_)
+    return;
+
+  if (address_) {
+    munmap(address_, size_);
+    address_ = 0;
+  }
+
+  if (newSize > size_) {
+    // The new bytes are zero.
+    if (ftruncate(fileDescriptor_, (off_t)newSize) != 0)
+      throw runtime_error("MappedContentStore: Cannot extend " + filePath_);
+    size_ = newSize;
+  }
+  map();
+}
+
+void
+MappedContentStore::MappedFile::map()
+{
+  void* address = mmap
+    (0, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor_, 0);
+  if (address == MAP_FAILED)
+    throw runtime_error("MappedContentStore: Cannot map " + filePath_);
+  address_ = (uint8_t*)address;
+}
+
+void
+MappedContentStore::MappedFile::sync()
+{
+  if (msync(address_, size_, MS_SYNC) != 0)
+    throw runtime_error("MappedContentStore: Cannot sync " + filePath_);
+}
+
+/**
+ * Get the path of the segment file in the directory.
+ */
+static string
+getSegmentFilePath(const string& directory, size_t segmentNumber)
+{
+  char fileName[32];
+  sprintf(fileName, "/log-%06u", (unsigned int)segmentNumber);
+  return directory + fileName;
+}
+
+/**
+ * Sync the directory entries, such as after renaming files in it.
+ */
+static void
+syncDirectory(const string& directory)
+{
+  int fileDescriptor = ::open(directory.c_str(), O_RDONLY);
+  if (fileDescriptor >= 0) {
+    fsync(fileDescriptor);
+    ::close(fileDescriptor);
+  }
+}
+
+MappedContentStore::MappedContentStore
+  (const string& directory, size_t segmentSize)
+: directory_(directory), recoveredDropCount_(0), recoveredRebuildCount_(0)
+{
+  finishCompaction(directory_);
+  open(segmentSize);
+}
+
+void
+MappedContentStore::open(size_t segmentSize)
+{
+  headerFile_.open(directory_ + INDEX_FILES[0], HEADER_FILE_SIZE);
+  Header& header = this->header();
+  if (header.magic[0] == 0) {
+    // A new store.
+    if (segmentSize == 0 || segmentSize > 0xffffffff)
+      throw runtime_error("MappedContentStore: Invalid segment size");
+    header.segmentSize = segmentSize;
+    header.nBuckets = INITIAL_BUCKET_COUNT;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  }
+  else if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    throw runtime_error
+      ("MappedContentStore: Not a content store in " + directory_);
+
+  recordsFile_.open
+    (directory_ + INDEX_FILES[1], INITIAL_RECORD_CAPACITY * sizeof(Record));
+  linksFile_.open
+    (directory_ + INDEX_FILES[2], INITIAL_LINK_CAPACITY * sizeof(Link));
+  bucketsFile_.open
+    (directory_ + INDEX_FILES[3], header.nBuckets * sizeof(uint32_t));
+  if (header.nRecords * sizeof(Record) > recordsFile_.getSize())
+    throw runtime_error("MappedContentStore: The records file is too short");
+
+  if (header.nDurableRecords > header.nRecords)
+    header.nDurableRecords = header.nRecords;
+  // Only map the segments of the durable records. checkUndurableRecords
+  // validates each other record before it maps its segment.
+  if (header.nDurableRecords > 0)
+    mapSegments(records()[header.nDurableRecords - 1].segment);
+  checkUndurableRecords();
+
+  uint64_t nLinks = 0;
+  if (header.nRecords > 0) {
+    const Record& last = records()[header.nRecords - 1];
+    nLinks = last.firstLink + last.nComponents;
+  }
+  if (header.nIndexedLinks != nLinks) {
+    // An add or rebuild was interrupted.
+    rebuildBuckets(header.nBuckets);
+    ++recoveredRebuildCount_;
+
+    header.nContentBytes = 0;
+    for (uint64_t i = 0; i < header.nRecords; ++i)
+      header.nContentBytes += records()[i].length;
+  }
+}
+
+void
+MappedContentStore::close()
+{
+  segments_.clear();
+  bucketsFile_.close();
+  linksFile_.close();
+  recordsFile_.close();
+  headerFile_.close();
+}
+
+MappedContentStore::~MappedContentStore()
+{
+  try {
+    flush();
+  } catch (const std::exception&) {
+    // The next open will check the records which are not durable.
+  }
+}
+
+void
+MappedContentStore::mapSegments(size_t segmentNumber)
+{
+  while (segments_.size() <= segmentNumber) {
+    ptr_lib::shared_ptr<MappedFile> segment(new MappedFile());
+    segment->open
+      (getSegmentFilePath(directory_, segments_.size()),
+       (size_t)header().segmentSize);
+    segments_.push_back(segment);
+  }
+}
+
+const uint8_t*
+MappedContentStore::getEncoding(const Record& record) const
+{
+  return segments_[record.segment]->getAddress() + record.offset;
+}
+
+void
+MappedContentStore::checkUndurableRecords()
+{
+  Header& header = this->header();
+  vector<uint64_t> prefixHashes;
+  uint64_t expectedFirstLink = 0;
+  if (header.nDurableRecords > 0) {
+    const Record& last = records()[header.nDurableRecords - 1];
+    expectedFirstLink = last.firstLink + last.nComponents;
+  }
+
+  for (uint64_t i = header.nDurableRecords; i < header.nRecords; ++i) {
+    Record& record = records()[i];
+    bool isValid = false;
+    if (record.firstLink == expectedFirstLink &&
+        record.length <= header.segmentSize &&
+        record.offset <= header.segmentSize - record.length &&
+        record.segment <= segments_.size()) {
+      mapSegments(record.segment);
+      const uint8_t* encoding = getEncoding(record);
+      if (computeChecksum(encoding, record.length, record.staleTime) ==
+          record.checksum) {
+        // The links may not have been written, so make them again.
+        try {
+          size_t nameOffset, nameHeaderLength, nameValueLength;
+          parseName
+            (encoding, record.length, nameOffset, nameHeaderLength,
+             nameValueLength, prefixHashes);
+          if (prefixHashes.size() == record.nComponents &&
+              (record.firstLink + record.nComponents) * sizeof(Link) <=
+                linksFile_.getSize()) {
+            for (size_t j = 0; j < prefixHashes.size(); ++j) {
+              Link& link = links()[record.firstLink + j];
+              link.hash = prefixHashes[j];
+              link.record = (uint32_t)i;
+            }
+            isValid = true;
+          }
+        } catch (const runtime_error&) {
+        }
+      }
+    }
+
+    if (!isValid) {
+      recoveredDropCount_ = (size_t)(header.nRecords - i);
+      header.nRecords = i;
+      break;
+    }
+    expectedFirstLink = record.firstLink + record.nComponents;
+  }
+
+  if (header.nRecords > header.nDurableRecords || recoveredDropCount_ > 0)
+    // The hash table may not have been written, so rebuild it.
+    header.nIndexedLinks = INDEX_CHANGING;
+}
+
+void
+MappedContentStore::rebuildBuckets(uint64_t nBuckets)
+{
+  Header& header = this->header();
+  header.nIndexedLinks = INDEX_CHANGING;
+  bucketsFile_.resize(nBuckets * sizeof(uint32_t));
+  header.nBuckets = nBuckets;
+  memset(buckets(), 0, nBuckets * sizeof(uint32_t));
+
+  uint64_t nLinks = 0;
+  if (header.nRecords > 0) {
+    const Record& last = records()[header.nRecords - 1];
+    nLinks = last.firstLink + last.nComponents;
+  }
+  Link* links = this->links();
+  uint32_t* buckets = this->buckets();
+  uint64_t mask = nBuckets - 1;
+  for (uint64_t i = 0; i < nLinks; ++i) {
+    uint32_t& bucket = buckets[links[i].hash & mask];
+    links[i].next = bucket;
+    bucket = (uint32_t)(i + 1);
+  }
+
+  header.nIndexedLinks = nLinks;
+}
+
+void
+MappedContentStore::add(const Data& data, MillisecondsSince1970 nowMilliseconds)
+{
+  SignedBlob encoding = data.wireEncode();
+  Milliseconds freshnessPeriod = data.getMetaInfo().getFreshnessPeriod();
+  addEncoding
+    (encoding.buf(), encoding.size(),
+     nowMilliseconds + (freshnessPeriod >= 0 ? freshnessPeriod : 0));
+}
+
+void
+MappedContentStore::addEncoding
+  (const uint8_t* encoding, size_t encodingLength,
+   MillisecondsSince1970 staleTime)
+{
+  Header& header = this->header();
+  if (encodingLength > header.segmentSize)
+    throw runtime_error
+      ("MappedContentStore: The Data encoding is larger than the segment size");
+
+  size_t nameOffset, nameHeaderLength, nameValueLength;
+  vector<uint64_t> prefixHashes;
+  parseName
+    (encoding, encodingLength, nameOffset, nameHeaderLength, nameValueLength,
+     prefixHashes);
+
+  // Find the end of the log.
+  uint64_t segment = 0;
+  uint64_t offset = 0;
+  uint64_t firstLink = 0;
+  if (header.nRecords > 0) {
+    const Record& last = records()[header.nRecords - 1];
+    segment = last.segment;
+    offset = last.offset + last.length;
+    firstLink = last.firstLink + last.nComponents;
+  }
+  if (offset + encodingLength > header.segmentSize) {
+    ++segment;
+    offset = 0;
+  }
+  mapSegments((size_t)segment);
+
+  // Make room in the index files.
+  while ((header.nRecords + 1) * sizeof(Record) > recordsFile_.getSize())
+    recordsFile_.resize(2 * recordsFile_.getSize());
+  while ((firstLink + prefixHashes.size()) * sizeof(Link) > linksFile_.getSize())
+    linksFile_.resize(2 * linksFile_.getSize());
+
+  // Write the encoding and the record after the committed records.
+  memcpy(segments_[segment]->getAddress() + offset, encoding, encodingLength);
+  Record& record = records()[header.nRecords];
+  record.segment = (uint32_t)segment;
+  record.offset = (uint32_t)offset;
+  record.length = (uint32_t)encodingLength;
+  record.nameOffset = (uint32_t)nameOffset;
+  record.nameHeaderLength = (uint32_t)nameHeaderLength;
+  record.nameValueLength = (uint32_t)nameValueLength;
+  record.nComponents = (uint32_t)prefixHashes.size();
+  record.firstLink = firstLink;
+  record.staleTime = staleTime;
+  record.checksum = computeChecksum(encoding, encodingLength, staleTime);
+
+  // Mark the hash table as changing while we add the links.
+  header.nIndexedLinks = INDEX_CHANGING;
+  Link* links = this->links();
+  uint32_t* buckets = this->buckets();
+  uint64_t mask = header.nBuckets - 1;
+  for (size_t i = 0; i < prefixHashes.size(); ++i) {
+    uint64_t iLink = firstLink + i;
+    Link& link = links[iLink];
+    link.hash = prefixHashes[i];
+    link.record = (uint32_t)header.nRecords;
+    uint32_t& bucket = buckets[link.hash & mask];
+    link.next = bucket;
+    bucket = (uint32_t)(iLink + 1);
+  }
+
+  // Commit.
+  ++header.nRecords;
+  header.nContentBytes += encodingLength;
+  uint64_t nLinks = firstLink + prefixHashes.size();
+  header.nIndexedLinks = nLinks;
+
+  if (nLinks > 2 * header.nBuckets)
+    rebuildBuckets(2 * header.nBuckets);
+}
+
+bool
+MappedContentStore::matches
+  (const Interest& interest, const Record& record, bool isExact,
+   bool hasOtherSelectors, MillisecondsSince1970 nowMilliseconds) const
+{
+  if (!isExact && !interest.getCanBePrefix())
+    return false;
+  if (interest.getMustBeFresh() && !(record.staleTime > nowMilliseconds))
+    return false;
+
+  if (hasOtherSelectors) {
+    Name name;
+    name.wireDecode
+      (getEncoding(record) + record.nameOffset,
+       record.nameHeaderLength + record.nameValueLength);
+    return interest.matchesName(name);
+  }
+
+  return true;
+}
+
+const uint8_t*
+MappedContentStore::find
+  (const Interest& interest, MillisecondsSince1970 nowMilliseconds,
+   size_t& encodingLength) const
+{
+  const Header& header = this->header();
+  const Name& name = interest.getName();
+  size_t nComponents = name.size();
+  bool hasDigest = false;
+  if (nComponents > 0 && name.get(-1).isImplicitSha256Digest()) {
+    hasDigest = true;
+    --nComponents;
+  }
+  bool hasOtherSelectors = interest.getMinSuffixComponents() >= 0 ||
+    interest.getExclude().size() > 0 ||
+    (interest.getMaxSuffixComponents() >= 0 &&
+     interest.getMaxSuffixComponents() != 1);
+  // With only one possible name, the newest match is the answer. Otherwise,
+  // the same as MemoryContentCache, compare every record under the prefix to
+  // find the leftmost child, or the rightmost with ChildSelector 1.
+  bool returnFirstMatch = hasDigest || !interest.getCanBePrefix();
+
+  const Record* records = this->records();
+  const Record* bestRecord = 0;
+  const uint8_t* bestName = 0;
+
+  // Check each candidate record from the newest.
+  const Link* links = this->links();
+  uint32_t next = 0;
+  uint64_t iRecord = header.nRecords;
+  const uint8_t* prefixValue = 0;
+  size_t prefixValueLength = 0;
+  uint64_t prefixHash = 0;
+  Blob prefixEncoding;
+  if (nComponents > 0) {
+    prefixEncoding = name.getPrefix(nComponents).wireEncode();
+    TlvDecoder decoder(prefixEncoding.buf(), prefixEncoding.size());
+    size_t endOffset = decoder.readNestedTlvsStart(ndn_Tlv_Name);
+    prefixValue = prefixEncoding.buf() + decoder.offset;
+    prefixValueLength = endOffset - decoder.offset;
+    prefixHash = updateHash(FNV_OFFSET_BASIS, prefixValue, prefixValueLength);
+    next = buckets()[prefixHash & (header.nBuckets - 1)];
+  }
+
+  while (true) {
+    const Record* record;
+    if (nComponents > 0) {
+      // Follow the hash table chain.
+      if (next == 0)
+        break;
+      const Link& link = links[next - 1];
+      next = link.next;
+      if (link.hash != prefixHash)
+        continue;
+      record = &records[link.record];
+    }
+    else {
+      // The empty name is a prefix of every record.
+      if (iRecord == 0)
+        break;
+      record = &records[--iRecord];
+    }
+
+    const uint8_t* encoding = getEncoding(*record);
+    const uint8_t* nameValue =
+      encoding + record->nameOffset + record->nameHeaderLength;
+    if (record->nameValueLength < prefixValueLength ||
+        memcmp(nameValue, prefixValue, prefixValueLength) != 0)
+      // A hash collision.
+      continue;
+
+    bool isExact = (record->nComponents == nComponents);
+    if (hasDigest) {
+      if (!isExact)
+        continue;
+      uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+      ndn_digestSha256(encoding, record->length, digest);
+      if (memcmp(digest, name.get(-1).getValue().buf(), sizeof(digest)) != 0)
+        continue;
+    }
+
+    if (!matches(interest, *record, isExact, hasOtherSelectors, nowMilliseconds))
+      continue;
+
+    if (returnFirstMatch) {
+      bestRecord = record;
+      break;
+    }
+
+    // Keep the newest of equal names by only replacing with a strict order.
+    int comparison = bestRecord ? compareNameValues
+      (nameValue, record->nameValueLength, bestName,
+       bestRecord->nameValueLength) : 0;
+    if (!bestRecord ||
+        (interest.getChildSelector() == 1 ? comparison > 0 : comparison < 0)) {
+      bestRecord = record;
+      bestName = nameValue;
+    }
+  }
+
+  if (!bestRecord)
+    return 0;
+
+  encodingLength = bestRecord->length;
+  return getEncoding(*bestRecord);
+}
+
+void
+MappedContentStore::compact(uint64_t maxContentBytes)
+{
+  flush();
+
+  // Choose the records to keep from the newest, skipping a record whose name
+  // is the same as a newer record. The key is the hash of the full name.
+  const Header& header = this->header();
+  const Record* records = this->records();
+  const Link* links = this->links();
+  map<uint64_t, vector<uint64_t> > keptForHash;
+  vector<uint64_t> kept;
+  uint64_t keptBytes = 0;
+  for (uint64_t i = header.nRecords; i > 0; --i) {
+    const Record& record = records[i - 1];
+    if (maxContentBytes > 0 && keptBytes + record.length > maxContentBytes)
+      // Drop this and all older records.
+      break;
+
+    uint64_t nameHash = record.nComponents > 0 ?
+      links[record.firstLink + record.nComponents - 1].hash : FNV_OFFSET_BASIS;
+    const uint8_t* nameValue =
+      getEncoding(record) + record.nameOffset + record.nameHeaderLength;
+    vector<uint64_t>& sameHash = keptForHash[nameHash];
+    bool isSuperseded = false;
+    for (size_t j = 0; j < sameHash.size(); ++j) {
+      const Record& newer = records[sameHash[j]];
+      if (newer.nameValueLength == record.nameValueLength &&
+          memcmp(getEncoding(newer) + newer.nameOffset + newer.nameHeaderLength,
+                 nameValue, record.nameValueLength) == 0) {
+        isSuperseded = true;
+        break;
+      }
+    }
+    if (isSuperseded)
+      continue;
+
+    sameHash.push_back(i - 1);
+    kept.push_back(i - 1);
+    keptBytes += record.length;
+  }
+  if (kept.size() == header.nRecords)
+    // Nothing to drop.
+    return;
+
+  // Write the kept records from the oldest to a new store.
+  string compactingDirectory = directory_ + COMPACTING_DIRECTORY;
+  removeCompactingDirectory(directory_);
+  if (mkdir(compactingDirectory.c_str(), 0755) != 0)
+    throw runtime_error
+      ("MappedContentStore: Cannot create " + compactingDirectory);
+  size_t nSegments;
+  {
+    MappedContentStore newStore
+      (compactingDirectory, (size_t)header.segmentSize);
+    for (size_t i = kept.size(); i > 0; --i) {
+      const Record& record = records[kept[i - 1]];
+      newStore.addEncoding
+        (getEncoding(record), record.length, record.staleTime);
+    }
+    newStore.flush();
+    nSegments = newStore.segments_.size();
+  }
+
+  // The new store is durable. Commit it by creating the COMPACTED_FILE, after
+  // which an interrupted open finishes moving the files.
+  string compactedFilePath = compactingDirectory + COMPACTED_FILE;
+  FILE* compactedFile = fopen(compactedFilePath.c_str(), "w");
+  if (!compactedFile)
+    throw runtime_error("MappedContentStore: Cannot create " + compactedFilePath);
+  fprintf(compactedFile, "%u\n", (unsigned int)nSegments);
+  fflush(compactedFile);
+  fsync(fileno(compactedFile));
+  fclose(compactedFile);
+  syncDirectory(compactingDirectory);
+
+  size_t segmentSize = (size_t)header.segmentSize;
+  close();
+  finishCompaction(directory_);
+  recoveredDropCount_ = 0;
+  recoveredRebuildCount_ = 0;
+  open(segmentSize);
+}
+
+void
+MappedContentStore::removeCompactingDirectory(const string& directory)
+{
+  string compactingDirectory = directory + COMPACTING_DIRECTORY;
+  remove((compactingDirectory + COMPACTED_FILE).c_str());
+  for (size_t i = 0; i < sizeof(INDEX_FILES) / sizeof(INDEX_FILES[0]); ++i)
+    remove((compactingDirectory + INDEX_FILES[i]).c_str());
+  for (size_t i = 0;
+       remove(getSegmentFilePath(compactingDirectory, i).c_str()) == 0; ++i) {}
+  rmdir(compactingDirectory.c_str());
+}
+
+void
+MappedContentStore::finishCompaction(const string& directory)
+{
+  string compactingDirectory = directory + COMPACTING_DIRECTORY;
+  FILE* compactedFile = fopen
+    ((compactingDirectory + COMPACTED_FILE).c_str(), "r");
+  if (!compactedFile) {
+    // No compaction, or it didn't commit. Remove a partial new store.
+    removeCompactingDirectory(directory);
+    return;
+  }
+  unsigned int nSegments = 0;
+  int nScanned = fscanf(compactedFile, "%u", &nSegments);
+  fclose(compactedFile);
+  if (nScanned != 1)
+    throw runtime_error
+      ("MappedContentStore: Invalid compaction state in " + compactingDirectory);
+
+  // Move the new files over the old ones. A file which a previous open already
+  // moved doesn't exist.
+  for (size_t i = 0; i < sizeof(INDEX_FILES) / sizeof(INDEX_FILES[0]); ++i)
+    rename((compactingDirectory + INDEX_FILES[i]).c_str(),
+           (directory + INDEX_FILES[i]).c_str());
+  for (size_t i = 0; i < nSegments; ++i)
+    rename(getSegmentFilePath(compactingDirectory, i).c_str(),
+           getSegmentFilePath(directory, i).c_str());
+  // Remove the old segments which the new store doesn't use.
+  for (size_t i = nSegments;
+       remove(getSegmentFilePath(directory, i).c_str()) == 0; ++i) {}
+  syncDirectory(directory);
+
+  removeCompactingDirectory(directory);
+}
+
+void
+MappedContentStore::flush()
+{
+  Header& header = this->header();
+  size_t firstSegment = 0;
+  if (header.nDurableRecords < header.nRecords)
+    firstSegment = records()[header.nDurableRecords].segment;
+  else if (header.nRecords > 0)
+    firstSegment = records()[header.nRecords - 1].segment;
+  for (size_t i = firstSegment; i < segments_.size(); ++i)
+    segments_[i]->sync();
+  recordsFile_.sync();
+  linksFile_.sync();
+  bucketsFile_.sync();
+
+  // Now the records are on disk, so open doesn't need to check them.
+  header.nDurableRecords = header.nRecords;
+  headerFile_.sync();
+}
+
+#else // NDN_CPP_HAVE_UNISTD_H
+
+MappedContentStore::MappedFile::~MappedFile() {}
+
+MappedContentStore::MappedContentStore
+  (const string& directory, size_t segmentSize)
+{
+  throw runtime_error
+    ("MappedContentStore: Memory-mapped files are not supported on this platform");
+}
+
+MappedContentStore::~MappedContentStore() {}
+
+void
+MappedContentStore::add(const Data& data, MillisecondsSince1970 nowMilliseconds) {}
+
+void
+MappedContentStore::compact(uint64_t maxContentBytes) {}
+
+const uint8_t*
+MappedContentStore::find
+  (const Interest& interest, MillisecondsSince1970 nowMilliseconds,
+   size_t& encodingLength) const { return 0; }
+
+void
+MappedContentStore::flush() {}
+
+#endif // NDN_CPP_HAVE_UNISTD_H
+
+size_t
+MappedContentStore::size() const
+{
+  return (size_t)header().nRecords;
+}
+
+uint64_t
+MappedContentStore::getContentBytes() const
+{
+  return header().nContentBytes;
+}
+
+}
@@ -0,0 +1,312 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_MAPPED_CONTENT_STORE_HPP
+#define NDN_MAPPED_CONTENT_STORE_HPP
+
+#include <string>
+#include <vector>
+#include <ndn-cpp/interest.hpp>
+#include <ndn-cpp/data.hpp>
+
+namespace ndn {
+
+/**
+ * A MappedContentStore is an internal class for the files of a
+ * PersistentContentCache in one directory. The signed Data encodings are
+ * appended to fixed-size segment files. The index has a record for each Data
+ * packet and a hash table with a link for each prefix of its name, so that an
+ * Interest finds the Data packets under its name by following one chain.
+ * All the files are memory-mapped, so opening the store only maps the files
+ * and find returns a pointer into the mapped segment.
+ *
+ * Crash consistency: add writes the encoding, record and links before it
+ * commits the new record count in the header, so that if the process stops in
+ * the middle of add, the next open ignores the partial record and rebuilds the
+ * hash table if needed. flush() also syncs the files to disk and marks the
+ * records as durable, and the destructor calls flush(). When the store is
+ * opened, it checks the checksum of each record added since the last flush, in
+ * case the system stopped before the pages were written, drops the records
+ * from the first bad one and rebuilds the hash table.
+ *
+ * The log only grows. compact writes the records to keep to a new store in a
+ * subdirectory, commits it by creating a marker file, then moves the new files
+ * over the old ones. If the process stops before the commit, the next open
+ * removes the new store. If it stops after, the next open finishes the move.
+ *
+ * The files use the byte order of the host, so they can't be moved to a host
+ * with a different byte order.
+ */
+class MappedContentStore {
+public:
+  /**
+   * Open the store in the directory, creating the files if needed, and
+   * recover from an interrupted add or compact.
+   * @param directory The directory for the files, which must already exist.
+   * @param segmentSize The size of each segment file of the log. This is only
+   * used when creating a new store. An existing store uses its segment size.
+   * @throws runtime_error if the files can't be opened or mapped, or are not
+   * a valid store.
+   */
+  MappedContentStore(const std::string& directory, size_t segmentSize);
+
+  /**
+   * Call flush(), then unmap and close the files.
+   */
+  ~MappedContentStore();
+
+  /**
+   * Append the Data packet to the log and add it to the index. The staleness
+   * time is now plus data.getMetaInfo().getFreshnessPeriod(), or now if there
+   * is no freshness period. If the store already has a Data packet with the
+   * same name, find returns the one added last.
+   * @param data The Data packet. This uses data.wireEncode().
+   * @param nowMilliseconds The current time from ndn_getNowMilliseconds.
+   * @throws runtime_error if a file can't be extended or mapped.
+   */
+  void
+  add(const Data& data, MillisecondsSince1970 nowMilliseconds);
+
+  /**
+   * Find the best match Data for the Interest, honoring its CanBePrefix,
+   * MustBeFresh, ChildSelector, the other selectors and an implicit digest.
+   * The same as MemoryContentCache, this returns the leftmost match, or the
+   * rightmost if the ChildSelector is 1. Of Data packets with the same name,
+   * this returns the newest.
+   * @param interest The Interest.
+   * @param nowMilliseconds The current time from ndn_getNowMilliseconds.
+   * @param encodingLength Set this to the length of the Data encoding.
+   * @return A pointer to the Data encoding in the mapped segment, or null if
+   * not found. The pointer is valid until the next call to add or compact.
+   */
+  const uint8_t*
+  find
+    (const Interest& interest, MillisecondsSince1970 nowMilliseconds,
+     size_t& encodingLength) const;
+
+  /**
+   * Rewrite the store without the Data packets which find can't return because
+   * a newer Data packet has the same name, and without the oldest Data packets
+   * beyond maxContentBytes. This frees the disk space of the dropped packets.
+   * If nothing is dropped, this only calls flush().
+   * @param maxContentBytes The maximum total bytes of the Data encodings to
+   * keep. If 0, don't limit the size.
+   * @throws runtime_error if a file can't be written.
+   */
+  void
+  compact(uint64_t maxContentBytes);
+
+  /**
+   * Sync the files to disk and mark the records as durable, so that the next
+   * open doesn't need to check them.
+   * @throws runtime_error if a sync fails.
+   */
+  void
+  flush();
+
+  /**
+   * Get the number of Data packets in the store.
+   * @return The number of Data packets.
+   */
+  size_t
+  size() const;
+
+  /**
+   * Get the total bytes of the Data encodings in the store.
+   * @return The number of bytes.
+   */
+  uint64_t
+  getContentBytes() const;
+
+  /**
+   * Get the number of records that the last open dropped because they were
+   * not completely written.
+   * @return The number of dropped records.
+   */
+  size_t
+  getRecoveredDropCount() const { return recoveredDropCount_; }
+
+  /**
+   * Get the number of times that the last open rebuilt the hash table.
+   * @return 1 if the hash table was rebuilt, otherwise 0.
+   */
+  int
+  getRecoveredRebuildCount() const { return recoveredRebuildCount_; }
+
+private:
+  struct Header;
+  struct Record;
+  struct Link;
+
+  /**
+   * A MappedFile is a file which is memory-mapped with read and write access
+   * and which can be extended.
+   */
+  class MappedFile {
+  public:
+    MappedFile()
+    : fileDescriptor_(-1), address_(0), size_(0)
+    {
+    }
+
+    ~MappedFile();
+
+    /**
+     * Open the file, creating it if needed, extend it to at least minimumSize
+     * and map it.
+     */
+    void
+    open(const std::string& filePath, size_t minimumSize);
+
+    /**
+     * Extend the file to newSize and map it again. This does nothing if the
+     * file is already at least newSize.
+     */
+    void
+    resize(size_t newSize);
+
+    /**
+     * Sync the mapped pages to disk.
+     */
+    void
+    sync();
+
+    /**
+     * Unmap and close the file. This does nothing if it is not open.
+     */
+    void
+    close();
+
+    uint8_t*
+    getAddress() const { return address_; }
+
+    size_t
+    getSize() const { return size_; }
+
+  private:
+    // Disable the copy constructor and assignment operator.
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+    void
+    map();
+
+    std::string filePath_;
+    int fileDescriptor_;
+    uint8_t* address_;
+    size_t size_;
+  };
+
+  // Disable the copy constructor and assignment operator.
+  MappedContentStore(const MappedContentStore& other);
+  MappedContentStore& operator=(const MappedContentStore& other);
+
+  Header&
+  header() const { return *(Header*)headerFile_.getAddress(); }
+
+  Record*
+  records() const { return (Record*)recordsFile_.getAddress(); }
+
+  Link*
+  links() const { return (Link*)linksFile_.getAddress(); }
+
+  uint32_t*
+  buckets() const { return (uint32_t*)bucketsFile_.getAddress(); }
+
+  const uint8_t*
+  getEncoding(const Record& record) const;
+
+  /**
+   * Open and map the files in directory_ and recover from an interrupted add.
+   * See the constructor.
+   */
+  void
+  open(size_t segmentSize);
+
+  /**
+   * Unmap and close all the files.
+   */
+  void
+  close();
+
+  /**
+   * Append the Data encoding to the log and add it to the index. See add.
+   */
+  void
+  addEncoding
+    (const uint8_t* encoding, size_t encodingLength,
+     MillisecondsSince1970 staleTime);
+
+  /**
+   * If compact committed a new store in the compacting subdirectory of the
+   * directory, move its files over the old ones. Then remove the
+   * subdirectory.
+   */
+  static void
+  finishCompaction(const std::string& directory);
+
+  /**
+   * Remove the files of the compacting subdirectory of the directory, and the
+   * subdirectory.
+   */
+  static void
+  removeCompactingDirectory(const std::string& directory);
+
+  /**
+   * Map the segment files up to and including segmentNumber.
+   */
+  void
+  mapSegments(size_t segmentNumber);
+
+  /**
+   * Check the records added since the last flush and drop them from the
+   * first one which is not completely written.
+   */
+  void
+  checkUndurableRecords();
+
+  /**
+   * Clear the hash table and add each link again.
+   */
+  void
+  rebuildBuckets(uint64_t nBuckets);
+
+  /**
+   * Check if the record matches the Interest.
+   */
+  bool
+  matches
+    (const Interest& interest, const Record& record, bool isExact,
+     bool hasOtherSelectors, MillisecondsSince1970 nowMilliseconds) const;
+
+  std::string directory_;
+  MappedFile headerFile_;
+  MappedFile recordsFile_;
+  MappedFile linksFile_;
+  MappedFile bucketsFile_;
+  std::vector<ptr_lib::shared_ptr<MappedFile> > segments_;
+  size_t recoveredDropCount_;
+  int recoveredRebuildCount_;
+};
+
+}
+
+#endif
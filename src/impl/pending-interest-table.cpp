@@ -88,33 +88,98 @@ PendingInterestTable::extractEntriesForNackInterest
 {
   SignedBlob encoding = interest.wireEncode();
 
-  // Go backwards through the list so we can erase entries.
-  for (int i = (int)table_.size() - 1; i >= 0; --i) {
-    ptr_lib::shared_ptr<Entry>& pendingInterest = table_[i];
-    if (!pendingInterest->getOnNetworkNack())
-      continue;
-
+  vector<ptr_lib::shared_ptr<Entry> > matches;
+  for (size_t i = 0; i < table_.size(); ++i) {
     // wireEncode returns the encoding cached when the interest was sent (if
     // it was the default wire encoding).
-    if (pendingInterest->getInterest()->wireEncode().equals(encoding)) {
-      entries.push_back(pendingInterest);
-      // We let the callback from callLater call _processInterestTimeout, but
-      // for efficiency, mark this as removed so that it returns right away.
-      pendingInterest->setIsRemoved();
-      table_.erase(table_.begin() + i);
+    if (table_[i]->getInterest()->wireEncode().equals(encoding))
+      matches.push_back(table_[i]);
+  }
+
+  // The entries aggregated with a match were waiting for the same Interest.
+  size_t nSentMatches = matches.size();
+  for (size_t i = 0; i < nSentMatches; ++i) {
+    const vector<ptr_lib::weak_ptr<Entry> >& aggregatedEntries =
+      matches[i]->getAggregatedEntries();
+    for (size_t j = 0; j < aggregatedEntries.size(); ++j) {
+      ptr_lib::shared_ptr<Entry> aggregatedEntry = aggregatedEntries[j].lock();
+      if (aggregatedEntry && !aggregatedEntry->getIsRemoved())
+        matches.push_back(aggregatedEntry);
     }
   }
+
+  for (size_t i = 0; i < matches.size(); ++i) {
+    if (!matches[i]->getOnNetworkNack())
+      continue;
+
+    // We let the callback from callLater call _processInterestTimeout, but
+    // for efficiency, removeEntry marks this as removed so that it returns
+    // right away.
+    if (removeEntry(matches[i]))
+      entries.push_back(matches[i]);
+  }
+}
+
+/**
+ * Check if the Interests have the same selectors. The selectors may not be in
+ * the wire encoding, but they affect which Data matches.
+ */
+static bool
+hasSameSelectors(const Interest& interest1, const Interest& interest2)
+{
+  return interest1.getMustBeFresh() == interest2.getMustBeFresh() &&
+    interest1.getMinSuffixComponents() == interest2.getMinSuffixComponents() &&
+    interest1.getMaxSuffixComponents() == interest2.getMaxSuffixComponents() &&
+    interest1.getChildSelector() == interest2.getChildSelector() &&
+    interest1.getKeyLocator().equals(interest2.getKeyLocator()) &&
+    interest1.getExclude().toUri() == interest2.getExclude().toUri();
+}
+
+ptr_lib::shared_ptr<PendingInterestTable::Entry>
+PendingInterestTable::findOutstandingEntry(const Interest& interest)
+{
+  for (size_t i = 0; i < table_.size(); ++i) {
+    const ptr_lib::shared_ptr<Entry>& entry = table_[i];
+    if (entry->getIsAggregated() ||
+        !entry->getInterest()->getName().equals(interest.getName()) ||
+        !hasSameSelectors(*entry->getInterest(), interest))
+      continue;
+
+    // Compare the other fields except the nonce.
+    Interest interestCopy(interest);
+    interestCopy.setNonce(entry->getInterest()->getNonce());
+    if (interestCopy.wireEncode().equals(entry->getInterest()->wireEncode()))
+      return entry;
+  }
+
+  return ptr_lib::shared_ptr<Entry>();
 }
 
 void
 PendingInterestTable::removePendingInterest(uint64_t pendingInterestId)
 {
-  int count = 0;
+  if (!removeExistingPendingInterest(pendingInterestId)) {
+    _LOG_DEBUG("removePendingInterest: Didn't find pendingInterestId " << pendingInterestId);
+
+    // The pendingInterestId was not found. Perhaps this has been called before
+    //   the callback in expressInterest can add to the PIT. Add this
+    //   removal request which will be checked before adding to the PIT.
+    if (::find(removeRequests_.begin(), removeRequests_.end(), pendingInterestId)
+        == removeRequests_.end())
+      // Not already requested, so add the request.
+      removeRequests_.push_back(pendingInterestId);
+  }
+}
+
+bool
+PendingInterestTable::removeExistingPendingInterest(uint64_t pendingInterestId)
+{
+  bool removed = false;
   // Go backwards through the list so we can erase entries.
   // Remove all entries even though pendingInterestId should be unique.
   for (int i = (int)table_.size() - 1; i >= 0; --i) {
     if (table_[i]->getPendingInterestId() == pendingInterestId) {
-      ++count;
+      removed = true;
       // For efficiency, mark this as removed so that processInterestTimeout
       // doesn't look for it.
       table_[i]->setIsRemoved();
@@ -122,18 +187,7 @@ PendingInterestTable::removePendingInterest(uint64_t pendingInterestId)
     }
   }
 
-  if (count == 0)
-    _LOG_DEBUG("removePendingInterest: Didn't find pendingInterestId " << pendingInterestId);
-
-  if (count == 0) {
-    // The pendingInterestId was not found. Perhaps this has been called before
-    //   the callback in expressInterest can add to the PIT. Add this
-    //   removal request which will be checked before adding to the PIT.
-    if (::find(removeRequests_.begin(), removeRequests_.end(), pendingInterestId)
-        == removeRequests_.end())
-      // Not already requested, so add the request.
-      removeRequests_.push_back(pendingInterestId);
-  }
+  return removed;
 }
 
 bool
@@ -23,6 +23,7 @@
 #define NDN_PENDING_INTEREST_TABLE_HPP
 
 #include <ndn-cpp/face.hpp>
+#include "../c/util/time.h"
 
 namespace ndn {
 
@@ -47,7 +48,9 @@ public:
        const ptr_lib::shared_ptr<const Interest>& interest, const OnData& onData,
        const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack)
     : pendingInterestId_(pendingInterestId), interest_(interest), onData_(onData),
-      onTimeout_(onTimeout), onNetworkNack_(onNetworkNack), isRemoved_(false)
+      onTimeout_(onTimeout), onNetworkNack_(onNetworkNack), isRemoved_(false),
+      sendTime_(ndn_getNowMilliseconds()), isAdaptiveLifetime_(false),
+      isAggregated_(false)
     {
     }
 
@@ -93,6 +96,61 @@ public:
     bool
     getIsRemoved() { return isRemoved_; }
 
+    /**
+     * Get the time when this entry was created, which is when the Interest was
+     * sent.
+     * @return The send time in milliseconds since 1/1/1970.
+     */
+    MillisecondsSince1970
+    getSendTime() { return sendTime_; }
+
+    /**
+     * Set the isAdaptiveLifetime flag which is returned by
+     * getIsAdaptiveLifetime().
+     * @param isAdaptiveLifetime True if the Interest lifetime was set from the
+     * RTT estimate.
+     */
+    void
+    setIsAdaptiveLifetime(bool isAdaptiveLifetime)
+    {
+      isAdaptiveLifetime_ = isAdaptiveLifetime;
+    }
+
+    /**
+     * Check if the Interest lifetime was set from the RTT estimate.
+     * @return True if the lifetime was set from the RTT estimate.
+     */
+    bool
+    getIsAdaptiveLifetime() { return isAdaptiveLifetime_; }
+
+    /**
+     * Add the entry to the list of entries which were aggregated with this
+     * entry's outstanding Interest instead of being sent, and set the other
+     * entry's isAggregated flag.
+     * @param entry The aggregated entry. This keeps a weak_ptr to it.
+     */
+    void
+    addAggregatedEntry(const ptr_lib::shared_ptr<Entry>& entry)
+    {
+      entry->isAggregated_ = true;
+      aggregatedEntries_.push_back(entry);
+    }
+
+    /**
+     * Get the list of entries given to addAggregatedEntry.
+     * @return The list of weak_ptr to the aggregated entries.
+     */
+    const std::vector<ptr_lib::weak_ptr<Entry> >&
+    getAggregatedEntries() { return aggregatedEntries_; }
+
+    /**
+     * Check if this entry was aggregated with another entry's outstanding
+     * Interest, so that its own Interest was not sent.
+     * @return True if this entry was aggregated.
+     */
+    bool
+    getIsAggregated() { return isAggregated_; }
+
     /**
      * Call onTimeout_ (if defined).  This ignores exceptions from the call to
      * onTimeout_.
@@ -107,6 +165,10 @@ public:
     const OnTimeout onTimeout_;
     const OnNetworkNack onNetworkNack_;
     bool isRemoved_;
+    MillisecondsSince1970 sendTime_;
+    bool isAdaptiveLifetime_;
+    bool isAggregated_;
+    std::vector<ptr_lib::weak_ptr<Entry> > aggregatedEntries_;
   };
 
   /**
@@ -151,7 +213,9 @@ public:
    * entry if the OnNetworkNack callback is an empty OnNetworkNack() so that
    * OnTimeout will be called later.) The interests are the same if their
    * default wire encoding is the same (which has everything including the name,
-   * nonce, link object and selectors).
+   * nonce, link object and selectors). This also extracts the entries which
+   * were aggregated with a matching entry (see addAggregatedEntry) since their
+   * Interest is the one which was Nacked.
    * @param interest The Interest to search for (typically from a Nack packet).
    * @param entries Add matching PendingInterestTable::Entry from the pending
    * interest table.  The caller should pass in a reference to an empty vector.
@@ -160,6 +224,18 @@ public:
   extractEntriesForNackInterest
     (const Interest& interest, std::vector<ptr_lib::shared_ptr<Entry> > &entries);
 
+  /**
+   * Find an entry whose Interest was sent and is the same as the interest
+   * except for the nonce, so that the interest can be aggregated with it. The
+   * interests are the same if they have the same name and selectors, and
+   * their default wire encoding is the same when the interest has the entry's
+   * nonce.
+   * @param interest The Interest to search for.
+   * @return The entry, or null if not found.
+   */
+  ptr_lib::shared_ptr<Entry>
+  findOutstandingEntry(const Interest& interest);
+
   /**
    * Remove the pending interest entry with the pendingInterestId from the
    * pending interest table and set its isRemoved flag. This does not affect
@@ -171,6 +247,18 @@ public:
   void
   removePendingInterest(uint64_t pendingInterestId);
 
+  /**
+   * Remove the pending interest entry with the pendingInterestId from the
+   * pending interest table and set its isRemoved flag. Unlike
+   * removePendingInterest, if there is no entry with the pendingInterestId then
+   * do not save a request to remove it when it is added. This is for a caller
+   * which knows that the entry was already added if it is in this table.
+   * @param pendingInterestId The ID returned from expressInterest.
+   * @return True if an entry was removed.
+   */
+  bool
+  removeExistingPendingInterest(uint64_t pendingInterestId);
+
   /**
    * Remove the specific pendingInterest entry from the table and set its
    * isRemoved flag. However, if the pendingInterest isRemoved flag is already
@@ -180,6 +268,13 @@ public:
   bool
   removeEntry(const ptr_lib::shared_ptr<Entry>& pendingInterest);
 
+  /**
+   * Check if the pending interest table has no entries.
+   * @return True if there are no entries.
+   */
+  bool
+  isEmpty() const { return table_.empty(); }
+
 private:
   std::vector<ptr_lib::shared_ptr<Entry> > table_;
   std::vector<uint64_t> removeRequests_;
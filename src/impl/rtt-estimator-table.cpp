@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+#include "rtt-estimator-table.hpp"
+
+using namespace std;
+
+namespace ndn {
+
+void
+RttEstimatorTable::addMeasurement
+  (const Name& interestName, Milliseconds rtt,
+   MillisecondsSince1970 nowMilliseconds)
+{
+  Name prefix = getPrefix(interestName);
+  Table::iterator found = table_.find(prefix);
+  if (found == table_.end()) {
+    if (table_.size() >= maxPrefixes_ && table_.size() > 0) {
+      // Remove the prefix which was updated least recently.
+      Table::iterator oldest = table_.begin();
+      for (Table::iterator i = table_.begin(); i != table_.end(); ++i) {
+        if (i->second.lastUpdateTime_ < oldest->second.lastUpdateTime_)
+          oldest = i;
+      }
+      table_.erase(oldest);
+    }
+
+    found = table_.insert(Table::value_type(prefix, Entry())).first;
+  }
+
+  found->second.estimator_.addMeasurement(rtt);
+  found->second.lastUpdateTime_ = nowMilliseconds;
+}
+
+void
+RttEstimatorTable::backoffRto(const Name& interestName)
+{
+  Table::iterator found = table_.find(getPrefix(interestName));
+  if (found != table_.end())
+    found->second.estimator_.backoffRto();
+}
+
+const RttEstimator*
+RttEstimatorTable::find(const Name& interestName) const
+{
+  if (table_.size() == 0)
+    return 0;
+
+  Name prefix = getPrefix(interestName);
+  while (true) {
+    Table::const_iterator found = table_.find(prefix);
+    if (found != table_.end())
+      return &found->second.estimator_;
+    if (prefix.size() == 0)
+      return 0;
+    prefix = prefix.getPrefix(-1);
+  }
+}
+
+void
+RttEstimatorTable::getEstimators(map<Name, RttEstimator>& estimators) const
+{
+  estimators.clear();
+  for (Table::const_iterator i = table_.begin(); i != table_.end(); ++i)
+    estimators[i->first] = i->second.estimator_;
+}
+
+}
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+#ifndef NDN_RTT_ESTIMATOR_TABLE_HPP
+#define NDN_RTT_ESTIMATOR_TABLE_HPP
+
+#include <map>
+#include <ndn-cpp/name.hpp>
+#include <ndn-cpp/util/rtt-estimator.hpp>
+
+namespace ndn {
+
+/**
+ * An RttEstimatorTable is an internal class to hold an RttEstimator for each
+ * name prefix, where the prefix of an Interest name is the name without its
+ * final component (usually the segment or sequence number). The number of
+ * prefixes is bounded, and when the table is full the prefix which was updated
+ * least recently is removed.
+ */
+class RttEstimatorTable {
+public:
+  /**
+   * Create an empty RttEstimatorTable.
+   * @param maxPrefixes The maximum number of prefixes in the table.
+   */
+  RttEstimatorTable(size_t maxPrefixes = 1000)
+  : maxPrefixes_(maxPrefixes)
+  {
+  }
+
+  /**
+   * Add the RTT sample to the estimator for the prefix of interestName,
+   * creating the estimator if needed.
+   * @param interestName The name of the satisfied Interest.
+   * @param rtt The measured round-trip time in milliseconds.
+   * @param nowMilliseconds The current time, used for eviction.
+   */
+  void
+  addMeasurement
+    (const Name& interestName, Milliseconds rtt,
+     MillisecondsSince1970 nowMilliseconds);
+
+  /**
+   * Double the retransmission timeout of the estimator for the prefix of
+   * interestName, if there is one.
+   * @param interestName The name of the Interest which timed out.
+   */
+  void
+  backoffRto(const Name& interestName);
+
+  /**
+   * Find the estimator with the longest prefix of interestName. For example,
+   * an Interest for a new version of a segmented object uses the estimator of
+   * the previous version's parent prefix.
+   * @param interestName The Interest name.
+   * @return A pointer to the RttEstimator in the table, or null if none. The
+   * pointer is invalidated by the next call to addMeasurement.
+   */
+  const RttEstimator*
+  find(const Name& interestName) const;
+
+  /**
+   * Copy all the estimators in the table into estimators.
+   * @param estimators Set this to the map of prefix to RttEstimator. This
+   * first clears the map.
+   */
+  void
+  getEstimators(std::map<Name, RttEstimator>& estimators) const;
+
+  /**
+   * Get the number of prefixes in the table.
+   * @return The number of prefixes.
+   */
+  size_t
+  size() const { return table_.size(); }
+
+  /**
+   * Get the prefix which is the key in the table for interestName.
+   * @param interestName The Interest name.
+   * @return The name without its final component, or the name itself if it
+   * has fewer than two components.
+   */
+  static Name
+  getPrefix(const Name& interestName)
+  {
+    return interestName.size() < 2 ? interestName : interestName.getPrefix(-1);
+  }
+
+private:
+  class Entry {
+  public:
+    Entry()
+    : lastUpdateTime_(0)
+    {
+    }
+
+    RttEstimator estimator_;
+    MillisecondsSince1970 lastUpdateTime_;
+  };
+
+  typedef std::map<Name, Entry> Table;
+
+  Table table_;
+  size_t maxPrefixes_;
+};
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_SUBMISSION_QUEUE_HPP
+#define NDN_SUBMISSION_QUEUE_HPP
+
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+#include <boost/atomic.hpp>
+#endif
+
+namespace ndn {
+
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+
+/**
+ * A SubmissionQueue is an internal class for a lock-free queue where many
+ * threads push entries and one consumer thread takes all the entries at once.
+ * push is a compare-and-swap on the head of a linked list, and popAll is one
+ * atomic exchange, so there is no lock and no allocation inside the queue.
+ */
+class SubmissionQueue {
+public:
+  /**
+   * An Entry is the base class for the objects in the queue. It has the link
+   * to the next entry.
+   */
+  class Entry {
+  public:
+    Entry()
+    : next_(0)
+    {
+    }
+
+    virtual
+    ~Entry() {}
+
+    /**
+     * Get the next entry in the list returned by popAll.
+     * @return The next entry, or null if this is the last.
+     */
+    Entry*
+    getNext() { return next_; }
+
+  private:
+    friend class SubmissionQueue;
+
+    Entry* next_;
+  };
+
+  SubmissionQueue()
+  : head_(0)
+  {
+  }
+
+  /**
+   * Delete the entries which are still in the queue.
+   */
+  ~SubmissionQueue()
+  {
+    Entry* entry = popAll();
+    while (entry) {
+      Entry* next = entry->next_;
+      delete entry;
+      entry = next;
+    }
+  }
+
+  /**
+   * Push the entry onto the queue. This is thread safe and lock-free.
+   * @param entry The entry to push. The queue takes ownership until popAll
+   * returns it.
+   * @return True if the queue was empty, in which case the caller should
+   * schedule the consumer to call popAll. If false, the consumer is already
+   * scheduled and will get this entry.
+   */
+  bool
+  push(Entry* entry)
+  {
+    Entry* oldHead = head_.load(boost::memory_order_relaxed);
+    do
+      entry->next_ = oldHead;
+    while (!head_.compare_exchange_weak
+           (oldHead, entry, boost::memory_order_release,
+            boost::memory_order_relaxed));
+
+    return oldHead == 0;
+  }
+
+  /**
+   * Remove all the entries from the queue and return them in the order that
+   * they were pushed. This should only be called by the consumer thread.
+   * @return The first entry, where each Entry getNext() is the next entry, or
+   * null if the queue is empty. The caller takes ownership of the entries.
+   */
+  Entry*
+  popAll()
+  {
+    Entry* entry = head_.exchange(0, boost::memory_order_acquire);
+
+    // The list is newest first, so reverse it.
+    Entry* result = 0;
+    while (entry) {
+      Entry* next = entry->next_;
+      entry->next_ = result;
+      result = entry;
+      entry = next;
+    }
+
+    return result;
+  }
+
+private:
+  // Disable the copy constructor and assignment operator.
+  SubmissionQueue(const SubmissionQueue& other);
+  SubmissionQueue& operator=(const SubmissionQueue& other);
+
+  boost::atomic<Entry*> head_;
+};
+
+#endif // NDN_CPP_HAVE_BOOST_ATOMIC
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "../c/util/time.h"
+#include <ndn-cpp/in-memory-storage/in-memory-storage-bounded.hpp>
+
+using namespace std;
+
+namespace ndn {
+
+void
+InMemoryStorageBounded::Entry::setData
+  (const ptr_lib::shared_ptr<Data>& data, size_t encodingSize,
+   MillisecondsSince1970 nowMilliseconds)
+{
+  data_ = data;
+  encodingSize_ = encodingSize;
+
+  // A Data packet without a freshness period is stale immediately.
+  Milliseconds freshnessPeriod = data->getMetaInfo().getFreshnessPeriod();
+  staleTime_ = nowMilliseconds + (freshnessPeriod >= 0 ? freshnessPeriod : 0);
+}
+
+void
+InMemoryStorageBounded::insert(const Data& data)
+{
+  // Copy before getFullName so that, like InMemoryStorageRetaining, the copy
+  // doesn't keep the over-allocated wire encoding buffer if data didn't
+  // already have one.
+  ptr_lib::shared_ptr<Data> dataCopy = ptr_lib::make_shared<Data>(data);
+  ptr_lib::shared_ptr<Name> fullName = data.getFullName();
+  size_t encodingSize = data.wireEncode().size();
+  MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
+
+  Cache::iterator existing = cache_.find(*fullName);
+  if (existing != cache_.end()) {
+    // The same full name has the same encoding, so only refresh the stale time.
+    existing->second.setData(dataCopy, encodingSize, nowMilliseconds);
+    afterAccess(&existing->second);
+    return;
+  }
+
+  Cache::iterator inserted = cache_.insert
+    (Cache::value_type(*fullName, Entry())).first;
+  Entry& entry = inserted->second;
+  entry.setData(dataCopy, encodingSize, nowMilliseconds);
+  entry.fullName_ = &inserted->first;
+  nBytes_ += entry.getEncodingSize();
+  afterInsert(&entry);
+
+  while ((limit_ > 0 && cache_.size() > limit_) ||
+         (byteLimit_ > 0 && nBytes_ > byteLimit_)) {
+    Entry* victim = selectVictim();
+    if (!victim)
+      break;
+
+    erase(cache_.find(*victim->fullName_));
+    ++evictionCount_;
+  }
+}
+
+ptr_lib::shared_ptr<Data>
+InMemoryStorageBounded::find(const Name& name)
+{
+  // The Name keys are in order.
+  Cache::iterator entry = cache_.lower_bound(name);
+  if (entry != cache_.end() && name.isPrefixOf(entry->first))
+    return access(entry->second);
+
+  return ptr_lib::shared_ptr<Data>();
+}
+
+ptr_lib::shared_ptr<Data>
+InMemoryStorageBounded::find(const Interest& interest)
+{
+  const Name& name = interest.getName();
+  MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
+
+  if (name.size() > 0 && name.get(-1).isImplicitSha256Digest()) {
+    // Only the Data with this full name can match.
+    Cache::iterator entry = cache_.find(name);
+    if (entry != cache_.end() &&
+        (!interest.getMustBeFresh() || entry->second.isFresh(nowMilliseconds)))
+      return access(entry->second);
+
+    return ptr_lib::shared_ptr<Data>();
+  }
+
+  // Only visit the keys which have the Interest name as a prefix.
+  Cache::iterator begin = cache_.lower_bound(name);
+  Cache::iterator end = (name.size() == 0 ?
+    cache_.end() : cache_.lower_bound(name.getSuccessor()));
+
+  if (interest.getChildSelector() == 1) {
+    // Search from the rightmost child.
+    for (Cache::iterator entry = end; entry != begin; ) {
+      --entry;
+      if (matches(interest, entry->second, nowMilliseconds))
+        return access(entry->second);
+    }
+  }
+  else {
+    for (Cache::iterator entry = begin; entry != end; ++entry) {
+      if (matches(interest, entry->second, nowMilliseconds))
+        return access(entry->second);
+    }
+  }
+
+  return ptr_lib::shared_ptr<Data>();
+}
+
+void
+InMemoryStorageBounded::remove(const Name& prefix)
+{
+  // The Name keys are in order.
+  Cache::iterator entry = cache_.lower_bound(prefix);
+  while (entry != cache_.end() && prefix.isPrefixOf(entry->first))
+    erase(entry++);
+}
+
+void
+InMemoryStorageBounded::erase(Cache::iterator entry)
+{
+  beforeErase(&entry->second);
+  nBytes_ -= entry->second.getEncodingSize();
+  cache_.erase(entry);
+}
+
+}
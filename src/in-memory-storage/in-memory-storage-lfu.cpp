@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include <ndn-cpp/in-memory-storage/in-memory-storage-lfu.hpp>
+
+using namespace std;
+
+namespace ndn {
+
+void
+InMemoryStorageLfu::afterInsert(Entry* entry)
+{
+  entry->useCount_ = 1;
+  if (buckets_.empty() || buckets_.front().front()->useCount_ != 1)
+    buckets_.push_front(EntryList());
+
+  entry->bucket_ = buckets_.begin();
+  entry->position_ = entry->bucket_->insert(entry->bucket_->end(), entry);
+}
+
+void
+InMemoryStorageLfu::afterAccess(Entry* entry)
+{
+  list<EntryList>::iterator bucket = entry->bucket_;
+  list<EntryList>::iterator nextBucket = bucket;
+  ++nextBucket;
+
+  ++entry->useCount_;
+  if (nextBucket == buckets_.end() ||
+      nextBucket->front()->useCount_ != entry->useCount_)
+    nextBucket = buckets_.insert(nextBucket, EntryList());
+
+  // Splice keeps entry->position_ valid.
+  nextBucket->splice(nextBucket->end(), *bucket, entry->position_);
+  entry->bucket_ = nextBucket;
+  if (bucket->empty())
+    buckets_.erase(bucket);
+}
+
+void
+InMemoryStorageLfu::beforeErase(Entry* entry)
+{
+  entry->bucket_->erase(entry->position_);
+  if (entry->bucket_->empty())
+    buckets_.erase(entry->bucket_);
+}
+
+}
@@ -42,9 +42,25 @@ Node::Node(const ptr_lib::shared_ptr<Transport>& transport, const ptr_lib::share
 : transport_(transport), connectionInfo_(connectionInfo),
   timeoutPrefix_(Name("/local/timeout")),
   lastEntryId_(0), connectStatus_(ConnectStatus_UNCONNECTED),
-  interestLoopbackEnabled_(false), registeredPrefixTable_(interestFilterTable_),
+  interestLoopbackEnabled_(false), rttEstimationEnabled_(false),
+  adaptiveInterestLifetimeEnabled_(false), interestAggregationEnabled_(false),
+  nExpressedInterests_(0), nAggregatedInterests_(0),
+  registeredPrefixTable_(interestFilterTable_),
   nonceTemplate_((const uint8_t*)"\0\0\0\0", 4)
 {
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_init(&submittedCallsMutex_, 0);
+  hasProcessEventsThread_ = false;
+  pthread_mutex_init(&rttEstimatorTableMutex_, 0);
+#endif
+}
+
+Node::~Node()
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_destroy(&submittedCallsMutex_);
+  pthread_mutex_destroy(&rttEstimatorTableMutex_);
+#endif
 }
 
 void
@@ -54,6 +70,25 @@ Node::expressInterest
    const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
    WireFormat& wireFormat, Face* face)
 {
+  if (submitIfOtherThread(bind
+      (&Node::expressInterest, this, pendingInterestId, interestCopy, onData,
+       onTimeout, onNetworkNack, func_lib::ref(wireFormat), face)))
+    return;
+
+  bool isAdaptiveLifetime = false;
+  if (adaptiveInterestLifetimeEnabled_ &&
+      interestCopy->getInterestLifetimeMilliseconds() < 0.0) {
+    const RttEstimator* estimator = rttEstimatorTable_.find
+      (interestCopy->getName());
+    if (estimator) {
+      // Set the lifetime before the nonce since changing the Interest clears
+      // the nonce.
+      const_cast<Interest*>(interestCopy.get())->setInterestLifetimeMilliseconds
+        (estimator->getRto());
+      isAdaptiveLifetime = true;
+    }
+  }
+
   if (interestCopy->getNonce().size() == 0) {
     // Set the nonce in our copy of the Interest so it is saved in the PIT.
     const_cast<Interest*>(interestCopy.get())->setNonce(nonceTemplate_);
@@ -64,17 +99,37 @@ Node::expressInterest
     // We are connected. Simply send the interest.
     expressInterestHelper
       (pendingInterestId, interestCopy, onData, onTimeout, onNetworkNack,
-       &wireFormat, face);
+       &wireFormat, face, isAdaptiveLifetime);
+    return;
+  }
+
+  callWhenConnected(bind
+    (&Node::expressInterestHelper, this, pendingInterestId, interestCopy,
+     onData, onTimeout, onNetworkNack, &wireFormat, face, isAdaptiveLifetime));
+}
+
+void
+Node::sendInterest
+  (const ptr_lib::shared_ptr<const Interest>& interestCopy,
+   WireFormat& wireFormat)
+{
+  if (connectStatus_ == ConnectStatus_CONNECT_COMPLETE) {
+    sendInterestHelper(interestCopy, &wireFormat);
     return;
   }
 
+  callWhenConnected(bind
+    (&Node::sendInterestHelper, this, interestCopy, &wireFormat));
+}
+
+void
+Node::callWhenConnected(const Face::Callback& callback)
+{
   // TODO: Properly check if we are already connected to the expected host.
   if (!transport_->isAsync()) {
-    // The simple case: Just do a blocking connect and express.
+    // The simple case: Just do a blocking connect and call.
     transport_->connect(*connectionInfo_, *this, Transport::OnConnected());
-    expressInterestHelper
-      (pendingInterestId, interestCopy, onData, onTimeout, onNetworkNack,
-       &wireFormat, face);
+    callback();
     // Make future calls to expressInterest send directly to the Transport.
     connectStatus_ = ConnectStatus_CONNECT_COMPLETE;
 
@@ -85,20 +140,15 @@ Node::expressInterest
   if (connectStatus_ == ConnectStatus_UNCONNECTED) {
     connectStatus_ = ConnectStatus_CONNECT_REQUESTED;
 
-    // expressInterestHelper will be called by onConnected.
-    onConnectedCallbacks_.push_back(bind
-      (&Node::expressInterestHelper, this, pendingInterestId, interestCopy,
-       onData, onTimeout, onNetworkNack, &wireFormat, face));
+    // The callback will be called by onConnected.
+    onConnectedCallbacks_.push_back(callback);
 
     transport_->connect
       (*connectionInfo_, *this, bind(&Node::onConnected, this));
   }
-  else if (connectStatus_ == ConnectStatus_CONNECT_REQUESTED) {
-    // Still connecting. add to the interests to express by onConnected.
-    onConnectedCallbacks_.push_back(bind
-      (&Node::expressInterestHelper, this, pendingInterestId, interestCopy,
-       onData, onTimeout, onNetworkNack, &wireFormat, face));
-  }
+  else if (connectStatus_ == ConnectStatus_CONNECT_REQUESTED)
+    // Still connecting. add to the callbacks to call by onConnected.
+    onConnectedCallbacks_.push_back(callback);
   else
     // Don't expect this to happen.
     throw runtime_error("Node: Unrecognized connectStatus_");
@@ -152,6 +202,11 @@ Node::putData(const Data& data, WireFormat* wireFormat)
       // or we can make the pending Interest table more complicated by
       // also tracking the Interests that we receive from the forwarder.
       return;
+
+    if (onReceivedData_)
+      // Also loop back to the pending interests kept outside of this Node. We
+      // don't know if they match, so still send the Data to the forwarder.
+      onReceivedData_(ptr_lib::make_shared<Data>(data));
   }
 
   Blob encoding = data.wireEncode(*wireFormat);
@@ -213,11 +268,69 @@ Node::dispatchInterest(const ptr_lib::shared_ptr<const Interest>& interest)
   }
 }
 
+void
+Node::addRttMeasurements
+  (const vector<ptr_lib::shared_ptr<PendingInterestTable::Entry> >& pitEntries)
+{
+  if (!(rttEstimationEnabled_ || adaptiveInterestLifetimeEnabled_) ||
+      pitEntries.size() == 0)
+    return;
+
+  MillisecondsSince1970 now = ndn_getNowMilliseconds();
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_lock(&rttEstimatorTableMutex_);
+#endif
+  for (size_t i = 0; i < pitEntries.size(); ++i) {
+    PendingInterestTable::Entry& entry = *pitEntries[i];
+    if (entry.getIsAggregated())
+      continue;
+    if (entry.getInterest()->getInterestLifetimeMilliseconds() >= 0.0 &&
+        !entry.getIsAdaptiveLifetime())
+      // The application set the lifetime, possibly for a long-lived Interest.
+      continue;
+
+    rttEstimatorTable_.addMeasurement
+      (entry.getInterest()->getName(), now - entry.getSendTime(), now);
+  }
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_unlock(&rttEstimatorTableMutex_);
+#endif
+}
+
+bool
+Node::getRttEstimate(const Name& interestName, RttEstimator& estimate) const
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_lock(&rttEstimatorTableMutex_);
+#endif
+  const RttEstimator* estimator = rttEstimatorTable_.find(interestName);
+  if (estimator)
+    estimate = *estimator;
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_unlock(&rttEstimatorTableMutex_);
+#endif
+
+  return estimator != 0;
+}
+
+void
+Node::getRttEstimates(map<Name, RttEstimator>& estimates) const
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_lock(&rttEstimatorTableMutex_);
+#endif
+  rttEstimatorTable_.getEstimators(estimates);
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_unlock(&rttEstimatorTableMutex_);
+#endif
+}
+
 void
 Node::satisfyPendingInterests(const ptr_lib::shared_ptr<Data>& data)
 {
   vector<ptr_lib::shared_ptr<PendingInterestTable::Entry> > pitEntries;
   pendingInterestTable_.extractEntriesForExpressedInterest(*data, pitEntries);
+  addRttMeasurements(pitEntries);
   for (size_t i = 0; i < pitEntries.size(); ++i) {
     try {
       pitEntries[i]->getOnData()(pitEntries[i]->getInterest(), data);
@@ -237,6 +350,7 @@ Node::satisfyPendingInterests(const Data& data)
 
   vector<ptr_lib::shared_ptr<PendingInterestTable::Entry> > pitEntries;
   pendingInterestTable_.extractEntriesForExpressedInterest(data, pitEntries);
+  addRttMeasurements(pitEntries);
   for (size_t i = 0; i < pitEntries.size(); ++i) {
     hasMatch = true;
     if (!dataCopy)
@@ -401,6 +515,7 @@ Node::nfdRegisterPrefix
 void
 Node::processEvents()
 {
+  callSubmitted();
   transport_->processEvents();
 
   // If Face::callLater is overridden to use a different mechanism, then
@@ -408,6 +523,84 @@ Node::processEvents()
   delayedCallTable_.callTimedOut();
 }
 
+void
+Node::processEvents(Milliseconds maxWaitMilliseconds)
+{
+  // Add submitted delayed calls before getting the next delay.
+  callSubmitted();
+
+  Milliseconds waitMilliseconds = maxWaitMilliseconds;
+  Milliseconds nextDelayMilliseconds =
+    delayedCallTable_.getNextDelayMilliseconds();
+  if (nextDelayMilliseconds >= 0 && nextDelayMilliseconds < waitMilliseconds)
+    waitMilliseconds = nextDelayMilliseconds;
+
+  // A call submitted after callSubmitted() wrote to the wake up pipe, so the
+  // wait returns immediately.
+  if (waitMilliseconds > 0)
+    transport_->waitForReceive(waitMilliseconds);
+
+  processEvents();
+}
+
+void
+Node::callLater(Milliseconds delayMilliseconds, const Face::Callback& callback)
+{
+  if (submitIfOtherThread(bind
+      (&DelayedCallTable::callLater, &delayedCallTable_, delayMilliseconds,
+       callback)))
+    return;
+
+  delayedCallTable_.callLater(delayMilliseconds, callback);
+}
+
+bool
+Node::submitIfOtherThread(const Face::Callback& callback)
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  pthread_mutex_lock(&submittedCallsMutex_);
+  if (!hasProcessEventsThread_ ||
+      pthread_equal(pthread_self(), processEventsThread_)) {
+    pthread_mutex_unlock(&submittedCallsMutex_);
+    return false;
+  }
+  submittedCalls_.push_back(callback);
+  pthread_mutex_unlock(&submittedCallsMutex_);
+
+  transport_->wakeUp();
+  return true;
+#else
+  // Without pthread, only a single thread is supported.
+  return false;
+#endif
+}
+
+void
+Node::callSubmitted()
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  std::vector<Face::Callback> calls;
+  pthread_mutex_lock(&submittedCallsMutex_);
+  hasProcessEventsThread_ = true;
+  processEventsThread_ = pthread_self();
+  calls.swap(submittedCalls_);
+  pthread_mutex_unlock(&submittedCallsMutex_);
+
+  // Call outside the lock since a callback may call submitIfOtherThread. The
+  // submitting thread can't catch an exception, so log it and continue.
+  for (size_t i = 0; i < calls.size(); ++i) {
+    try {
+      calls[i]();
+    } catch (const std::exception& ex) {
+      _LOG_ERROR("Node: Error in a call submitted from another thread: " <<
+                 ex.what());
+    } catch (...) {
+      _LOG_ERROR("Node: Error in a call submitted from another thread.");
+    }
+  }
+#endif
+}
+
 void
 Node::onReceivedElement(const uint8_t *element, size_t elementLength)
 {
@@ -476,6 +669,9 @@ Node::onReceivedElement(const uint8_t *element, size_t elementLength)
         }
       }
 
+      if (onReceivedNetworkNack_)
+        onReceivedNetworkNack_(interest, networkNack);
+
       // We have processed the network Nack packet.
       return;
     }
@@ -484,8 +680,11 @@ Node::onReceivedElement(const uint8_t *element, size_t elementLength)
   // Now process as Interest or Data.
   if (interest)
     dispatchInterest(interest);
-  else if (data)
+  else if (data) {
     satisfyPendingInterests(data);
+    if (onReceivedData_)
+      onReceivedData_(data);
+  }
 }
 
 void
@@ -499,14 +698,23 @@ Node::expressInterestHelper
   (uint64_t pendingInterestId,
    const ptr_lib::shared_ptr<const Interest>& interestCopy,
    const OnData& onData, const OnTimeout& onTimeout,
-   const OnNetworkNack& onNetworkNack, WireFormat* wireFormat, Face* face)
+   const OnNetworkNack& onNetworkNack, WireFormat* wireFormat, Face* face,
+   bool isAdaptiveLifetime)
 {
+  // Find the outstanding Interest before adding this one to the PIT.
+  ptr_lib::shared_ptr<PendingInterestTable::Entry> outstandingInterest;
+  if (interestAggregationEnabled_)
+    outstandingInterest = pendingInterestTable_.findOutstandingEntry
+      (*interestCopy);
+
   ptr_lib::shared_ptr<PendingInterestTable::Entry> pendingInterest =
     pendingInterestTable_.add
       (pendingInterestId, interestCopy, onData, onTimeout, onNetworkNack);
   if (!pendingInterest)
     // removePendingInterest was already called with the pendingInterestId.
     return;
+  pendingInterest->setIsAdaptiveLifetime(isAdaptiveLifetime);
+  ++nExpressedInterests_;
 
   if (onTimeout || interestCopy->getInterestLifetimeMilliseconds() >= 0.0) {
     // Set up the timeout.
@@ -514,12 +722,40 @@ Node::expressInterestHelper
     if (delayMilliseconds < 0.0)
       // Use a default timeout delay.
       delayMilliseconds = 4000.0;
+    if (outstandingInterest) {
+      // This Interest is not sent, so only wait for the rest of the lifetime
+      // of the outstanding Interest, which has the same lifetime. Then it times
+      // out with the outstanding Interest, even if that entry is removed.
+      delayMilliseconds -=
+        ndn_getNowMilliseconds() - outstandingInterest->getSendTime();
+      if (delayMilliseconds < 0.0)
+        delayMilliseconds = 0.0;
+    }
 
+    // Use a weak_ptr so that the pending interest (with its callbacks) is freed
+    // as soon as it is satisfied or removed, not when it would time out.
     face->callLater
       (delayMilliseconds,
-       bind(&Node::processInterestTimeout, this, pendingInterest));
+       bind(&Node::processInterestTimeout, this,
+            ptr_lib::weak_ptr<PendingInterestTable::Entry>(pendingInterest)));
   }
 
+  if (outstandingInterest) {
+    // Don't send. The Data or Nack for the outstanding Interest also satisfies
+    // this entry, and the timeout above is when the outstanding one expires.
+    outstandingInterest->addAggregatedEntry(pendingInterest);
+    ++nAggregatedInterests_;
+    return;
+  }
+
+  sendInterestHelper(interestCopy, wireFormat);
+}
+
+void
+Node::sendInterestHelper
+  (const ptr_lib::shared_ptr<const Interest>& interestCopy,
+   WireFormat* wireFormat)
+{
   // Special case: For timeoutPrefix_ we don't actually send the interest.
   if (!timeoutPrefix_.match(interestCopy->getName())) {
     Blob encoding = interestCopy->wireEncode(*wireFormat);
@@ -535,10 +771,30 @@ Node::expressInterestHelper
 
 void
 Node::processInterestTimeout
-  (ptr_lib::shared_ptr<PendingInterestTable::Entry> pendingInterest)
+  (const ptr_lib::weak_ptr<PendingInterestTable::Entry>& pendingInterestPointer)
 {
-  if (pendingInterestTable_.removeEntry(pendingInterest))
+  ptr_lib::shared_ptr<PendingInterestTable::Entry> pendingInterest =
+    pendingInterestPointer.lock();
+  if (!pendingInterest)
+    // The pending interest was already satisfied or removed.
+    return;
+
+  if (pendingInterestTable_.removeEntry(pendingInterest)) {
+    if (pendingInterest->getIsAdaptiveLifetime() &&
+        !pendingInterest->getIsAggregated()) {
+      // The lifetime was the retransmission timeout, so back off. An
+      // aggregated entry wasn't sent, so it is not another loss.
+#if NDN_CPP_HAVE_UNISTD_H
+      pthread_mutex_lock(&rttEstimatorTableMutex_);
+#endif
+      rttEstimatorTable_.backoffRto(pendingInterest->getInterest()->getName());
+#if NDN_CPP_HAVE_UNISTD_H
+      pthread_mutex_unlock(&rttEstimatorTableMutex_);
+#endif
+    }
+
     pendingInterest->callTimeout();
+  }
 }
 
 class EncodeLpContext {
@@ -27,6 +27,9 @@
 #if NDN_CPP_HAVE_BOOST_ATOMIC
 #include <boost/atomic.hpp>
 #endif
+#if NDN_CPP_HAVE_UNISTD_H
+#include <pthread.h>
+#endif
 #include <ndn-cpp/common.hpp>
 #include <ndn-cpp/interest.hpp>
 #include <ndn-cpp/data.hpp>
@@ -37,6 +40,7 @@
 #include "impl/interest-filter-table.hpp"
 #include "impl/pending-interest-table.hpp"
 #include "impl/registered-prefix-table.hpp"
+#include "impl/rtt-estimator-table.hpp"
 #include "encoding/element-listener.hpp"
 
 struct ndn_Interest;
@@ -47,6 +51,13 @@ class KeyChain;
 
 class Node : public ElementListener {
 public:
+  typedef func_lib::function<void
+    (const ptr_lib::shared_ptr<Data>& data)> OnReceivedData;
+
+  typedef func_lib::function<void
+    (const ptr_lib::shared_ptr<Interest>& interest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack)> OnReceivedNetworkNack;
+
   /**
    * Create a new Node for communication with an NDN hub with the given Transport object and connectionInfo.
    * @param transport A shared_ptr to a Transport object used for communication.
@@ -54,6 +65,8 @@ public:
    */
   Node(const ptr_lib::shared_ptr<Transport>& transport, const ptr_lib::shared_ptr<const Transport::ConnectionInfo>& connectionInfo);
 
+  ~Node();
+
   /**
    * Enable or disable Interest loopback.
    * @param interestLoopbackEnabled If True, enable Interest loopback,
@@ -65,6 +78,108 @@ public:
     interestLoopbackEnabled_ = interestLoopbackEnabled;
   }
 
+  /**
+   * Check if Interest loopback is enabled.
+   * @return True if Interest loopback is enabled.
+   */
+  bool
+  getInterestLoopbackEnabled() const { return interestLoopbackEnabled_; }
+
+  /**
+   * Enable or disable RTT estimation. See Face::setRttEstimationEnabled.
+   * @param rttEstimationEnabled If true, enable RTT estimation, otherwise
+   * disable it.
+   */
+  void
+  setRttEstimationEnabled(bool rttEstimationEnabled)
+  {
+    rttEstimationEnabled_ = rttEstimationEnabled;
+  }
+
+  /**
+   * Check if RTT estimation is enabled.
+   * @return True if RTT estimation is enabled.
+   */
+  bool
+  getRttEstimationEnabled() const { return rttEstimationEnabled_; }
+
+  /**
+   * Enable or disable the adaptive Interest lifetime. See
+   * Face::setAdaptiveInterestLifetimeEnabled.
+   * @param adaptiveInterestLifetimeEnabled If true, enable the adaptive
+   * Interest lifetime, otherwise disable it.
+   */
+  void
+  setAdaptiveInterestLifetimeEnabled(bool adaptiveInterestLifetimeEnabled)
+  {
+    adaptiveInterestLifetimeEnabled_ = adaptiveInterestLifetimeEnabled;
+  }
+
+  /**
+   * Check if the adaptive Interest lifetime is enabled.
+   * @return True if the adaptive Interest lifetime is enabled.
+   */
+  bool
+  getAdaptiveInterestLifetimeEnabled() const
+  {
+    return adaptiveInterestLifetimeEnabled_;
+  }
+
+  /**
+   * Enable or disable Interest aggregation. See
+   * Face::setInterestAggregationEnabled.
+   * @param interestAggregationEnabled If true, enable Interest aggregation,
+   * otherwise disable it.
+   */
+  void
+  setInterestAggregationEnabled(bool interestAggregationEnabled)
+  {
+    interestAggregationEnabled_ = interestAggregationEnabled;
+  }
+
+  /**
+   * Check if Interest aggregation is enabled.
+   * @return True if Interest aggregation is enabled.
+   */
+  bool
+  getInterestAggregationEnabled() const { return interestAggregationEnabled_; }
+
+  /**
+   * Get the number of Interests from expressInterest which were added to the
+   * pending interest table.
+   * @return The number of expressed Interests.
+   */
+  uint64_t
+  getExpressedInterestCount() const { return nExpressedInterests_; }
+
+  /**
+   * Get the number of Interests from expressInterest which were aggregated
+   * with an outstanding Interest instead of being sent.
+   * @return The number of aggregated Interests.
+   */
+  uint64_t
+  getAggregatedInterestCount() const { return nAggregatedInterests_; }
+
+  /**
+   * Get a copy of the RttEstimator with the longest prefix of interestName.
+   * This is safe to call from any thread since it locks the RTT estimator
+   * table which the processing thread updates.
+   * @param interestName The Interest name.
+   * @param estimate Set this to a copy of the estimator.
+   * @return True if an estimator was found, false if not.
+   */
+  bool
+  getRttEstimate(const Name& interestName, RttEstimator& estimate) const;
+
+  /**
+   * Get a copy of all the RTT estimators. This is safe to call from any thread
+   * since it locks the RTT estimator table which the processing thread
+   * updates.
+   * @param estimates Set this to the map of name prefix to RttEstimator.
+   */
+  void
+  getRttEstimates(std::map<Name, RttEstimator>& estimates) const;
+
   /**
    * Send the Interest through the transport, read the entire response and call
    * onData, onTimeout or onNetworkNack as described below.
@@ -101,6 +216,45 @@ public:
      const OnData& onData, const OnTimeout& onTimeout,
      const OnNetworkNack& onNetworkNack, WireFormat& wireFormat, Face* face);
 
+  /**
+   * Connect if needed, then encode and send the interest through the transport
+   * without adding an entry to the pending interest table. This is for a Face
+   * which keeps its own pending interests, such as ShardedThreadsafeFace. If
+   * Interest loopback is enabled, then also call dispatchInterest.
+   * @param interestCopy The Interest which is NOT copied for this internal Node
+   * method. The nonce should already be set so that it matches the Interest in
+   * the caller's pending interest table.
+   * @param wireFormat A WireFormat object used to encode the message.
+   * @throws runtime_error If the encoded interest size exceeds
+   * getMaxNdnPacketSize().
+   */
+  void
+  sendInterest
+    (const ptr_lib::shared_ptr<const Interest>& interestCopy,
+     WireFormat& wireFormat);
+
+  /**
+   * Set the callbacks for pending interests which are kept outside of this
+   * Node. After checking its own pending interest table, onReceivedElement
+   * calls onReceivedData(data) for each received Data packet and
+   * onReceivedNetworkNack(interest, networkNack) for each received network
+   * Nack. If Interest loopback is enabled, putData also calls
+   * onReceivedData. These are called on the thread which receives from the
+   * transport.
+   * @param onReceivedData The callback for a Data packet, or an empty
+   * OnReceivedData() for none.
+   * @param onReceivedNetworkNack The callback for a network Nack, or an empty
+   * OnReceivedNetworkNack() for none.
+   */
+  void
+  setOnReceivedPacket
+    (const OnReceivedData& onReceivedData,
+     const OnReceivedNetworkNack& onReceivedNetworkNack)
+  {
+    onReceivedData_ = onReceivedData;
+    onReceivedNetworkNack_ = onReceivedNetworkNack;
+  }
+
   /**
    * Remove the pending interest entry with the pendingInterestId from the pending interest table.
    * This does not affect another pending interest with a different pendingInterestId, even if it has the same interest name.
@@ -284,16 +438,29 @@ public:
    * onInterest or onTimeout. This returns immediately if there is no data to
    * receive. This blocks while calling the callbacks. You should repeatedly
    * call this from an event loop, with calls to sleep as needed so that the
-   * loop doesn’t use 100% of the CPU. Since processEvents modifies the pending
-   * interest table, your application should make sure that it calls
-   * processEvents in the same thread as expressInterest (which also modifies
-   * the pending interest table).
+   * loop doesn’t use 100% of the CPU. This first calls the callLater and
+   * expressInterest calls which were submitted from other threads (see
+   * submitIfOtherThread). Other methods which modify the pending interest
+   * table, such as removePendingInterest, must be called on the same thread as
+   * processEvents.
    * @throws This may throw an exception for reading data or in the callback for processing the data.  If you
    * call this from an main event loop, you may want to catch and log/disregard all exceptions.
    */
   void
   processEvents();
 
+  /**
+   * Wait until there is data for the transport to receive, until the earliest
+   * entry in the delayed call table is due, or until maxWaitMilliseconds has
+   * elapsed, whichever comes first. Then call processEvents(). A call to
+   * callLater or expressInterest from another thread cuts the wait short.
+   * @param maxWaitMilliseconds The maximum time to wait in milliseconds.
+   * @throws This may throw an exception for reading data or in the callback for
+   * processing the data.
+   */
+  void
+  processEvents(Milliseconds maxWaitMilliseconds);
+
   const ptr_lib::shared_ptr<Transport>&
   getTransport() { return transport_; }
 
@@ -326,15 +493,14 @@ public:
 
   /**
    * Call callback() after the given delay. This adds to delayedCallTable_ which
-   * is used by processEvents().
+   * is used by processEvents(). If this is called on a thread other than the
+   * one calling processEvents, then submit it to be added by processEvents
+   * and wake up its wait so that it waits for the new deadline.
    * @param delayMilliseconds The delay in milliseconds.
    * @param callback This calls callback() after the delay.
    */
   void
-  callLater(Milliseconds delayMilliseconds, const Face::Callback& callback)
-  {
-    delayedCallTable_.callLater(delayMilliseconds, callback);
-  }
+  callLater(Milliseconds delayMilliseconds, const Face::Callback& callback);
 
   /**
    * Get the next unique entry ID for the pending interest table, interest
@@ -423,6 +589,25 @@ private:
     Node& parent_;
   };
 
+  /**
+   * If processEvents has been called on a thread other than this one, add the
+   * callback to submittedCalls_ for processEvents to call on its thread, and
+   * wake up the transport in case processEvents is waiting.
+   * @param callback The callback to submit, which calls the method that is not
+   * thread-safe.
+   * @return True if the callback was submitted, or false if the caller should
+   * call the method directly on this thread.
+   */
+  bool
+  submitIfOtherThread(const Face::Callback& callback);
+
+  /**
+   * Call and clear the callbacks in submittedCalls_, and remember the current
+   * thread as the processEvents thread. This is called by processEvents.
+   */
+  void
+  callSubmitted();
+
   /**
    * Do the work of expressInterest once we know we are connected. Add the
    * entry to the PIT, encode and send the interest. If Interest loopback is
@@ -449,6 +634,8 @@ private:
    * @param wireFormat A WireFormat object used to encode the message.
    * @param face The face which has the callLater method, used for interest
    * timeouts. The callLater method may be overridden in a subclass of Face.
+   * @param isAdaptiveLifetime True if expressInterest set the Interest
+   * lifetime from the RTT estimate, so that a timeout backs off the estimate.
    * @throws runtime_error If the encoded interest size exceeds
    * getMaxNdnPacketSize().
    */
@@ -457,16 +644,38 @@ private:
     (uint64_t pendingInterestId,
      const ptr_lib::shared_ptr<const Interest>& interestCopy,
      const OnData& onData, const OnTimeout& onTimeout,
-     const OnNetworkNack& onNetworkNack, WireFormat* wireFormat, Face* face);
+     const OnNetworkNack& onNetworkNack, WireFormat* wireFormat, Face* face,
+     bool isAdaptiveLifetime);
+
+  /**
+   * Do the work of sendInterest once we know we are connected. This is also
+   * called by expressInterestHelper after adding the PIT entry.
+   * @param interestCopy The Interest to send.
+   * @param wireFormat A WireFormat object used to encode the message.
+   */
+  void
+  sendInterestHelper
+    (const ptr_lib::shared_ptr<const Interest>& interestCopy,
+     WireFormat* wireFormat);
+
+  /**
+   * If the transport is connected, call callback(). Otherwise connect and call
+   * callback() when connected.
+   * @param callback The callback to call when connected.
+   */
+  void
+  callWhenConnected(const Face::Callback& callback);
 
   /**
    * This is used in callLater for when the pending interest expires. If the
    * pendingInterest is still in the pendingInterestTable_, remove it and call
    * its onTimeout callback.
-   * @param pendingInterest The pending interest to check.
+   * @param pendingInterestPointer The pending interest to check. If it has
+   * expired, then it was already removed from the pendingInterestTable_.
    */
   void
-  processInterestTimeout(ptr_lib::shared_ptr<PendingInterestTable::Entry> pendingInterest);
+  processInterestTimeout
+    (const ptr_lib::weak_ptr<PendingInterestTable::Entry>& pendingInterestPointer);
 
   /**
    * Do the work of registerPrefix to register with NFD.
@@ -506,6 +715,20 @@ private:
   void
   dispatchInterest(const ptr_lib::shared_ptr<const Interest>& interest);
 
+  /**
+   * If RTT estimation is enabled, add the time since each entry's Interest was
+   * sent to the rttEstimatorTable_. This skips aggregated entries since their
+   * Interest was sent earlier. This also skips entries whose Interest has a
+   * lifetime from the application, since such an Interest (for example a
+   * long-lived sync Interest) may be answered only when the producer has new
+   * data, which would inflate the estimate.
+   * @param pitEntries The entries which were satisfied.
+   */
+  void
+  addRttMeasurements
+    (const std::vector<ptr_lib::shared_ptr<PendingInterestTable::Entry> >&
+       pitEntries);
+
   /**
    * Extract entries from the pendingInterestTable_ which match data, and call
    * each OnData callback.
@@ -535,10 +758,18 @@ private:
   InterestFilterTable interestFilterTable_;
   DelayedCallTable delayedCallTable_;
   std::vector<Face::Callback> onConnectedCallbacks_;
+  OnReceivedData onReceivedData_;
+  OnReceivedNetworkNack onReceivedNetworkNack_;
   CommandInterestGenerator commandInterestGenerator_;
   Name timeoutPrefix_;
   ConnectStatus connectStatus_;
   bool interestLoopbackEnabled_;
+  bool rttEstimationEnabled_;
+  bool adaptiveInterestLifetimeEnabled_;
+  RttEstimatorTable rttEstimatorTable_;
+  bool interestAggregationEnabled_;
+  uint64_t nExpressedInterests_;
+  uint64_t nAggregatedInterests_;
   Blob nonceTemplate_;
 #if NDN_CPP_HAVE_BOOST_ATOMIC
   // ThreadsafeFace accesses lastEntryId_ outside of a thread safe dispatch, so
@@ -548,6 +779,18 @@ private:
   // Not using Boost asio to dispatch, so we can use a normal uint64_t.
   uint64_t lastEntryId_;
 #endif
+#if NDN_CPP_HAVE_UNISTD_H
+  // submittedCallsMutex_ protects submittedCalls_ and the processEvents thread
+  // info, which are accessed by other threads in submitIfOtherThread.
+  pthread_mutex_t submittedCallsMutex_;
+  std::vector<Face::Callback> submittedCalls_;
+  bool hasProcessEventsThread_;
+  pthread_t processEventsThread_;
+  // rttEstimatorTableMutex_ protects rttEstimatorTable_ which other threads
+  // read in getRttEstimate and getRttEstimates. The processing thread locks it
+  // only to update the table.
+  mutable pthread_mutex_t rttEstimatorTableMutex_;
+#endif
 };
 
 }
@@ -0,0 +1,479 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_BOOST_ASIO.
+#include <ndn-cpp/ndn-cpp-config.h>
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+#include <stdexcept>
+#include <unistd.h>
+#include <pthread.h>
+#include <boost/bind.hpp>
+#include <boost/move/make_unique.hpp>
+#include <ndn-cpp/util/logging.hpp>
+#include <ndn-cpp/sharded-threadsafe-face.hpp>
+#include "impl/pending-interest-table.hpp"
+#include "impl/asio-delayed-call-table.hpp"
+#include "node.hpp"
+
+INIT_LOGGER("ndn.ShardedThreadsafeFace");
+
+using namespace std;
+
+namespace ndn {
+
+/**
+ * A Shard holds a pending interest table which is only accessed on the thread
+ * of its io_service.
+ */
+class ShardedThreadsafeFace::Shard {
+public:
+  /**
+   * Create a Shard with its own io_service, and start a thread to run it.
+   * @param callbackIoService The io_service to post the onData, onTimeout and
+   * onNetworkNack callbacks to, or 0 to call them on the thread of this shard.
+   * @throws runtime_error If the thread can't be created.
+   */
+  Shard(boost::asio::io_service* callbackIoService)
+  : internalIoService_(boost::movelib::make_unique<boost::asio::io_service>()),
+    ioService_(*internalIoService_),
+    work_(boost::movelib::make_unique<boost::asio::io_service::work>
+          (ioService_)),
+    hasThread_(false), callbackIoService_(callbackIoService),
+    delayedCallTable_(ioService_)
+  {
+    if (pthread_create(&thread_, 0, &Shard::run, this) != 0)
+      throw runtime_error("ShardedThreadsafeFace: Can't create the shard thread");
+    hasThread_ = true;
+  }
+
+  /**
+   * Create a Shard which uses the given io_service, which is run by the
+   * application.
+   * @param ioService The io_service for this shard.
+   */
+  Shard(boost::asio::io_service& ioService)
+  : ioService_(ioService), hasThread_(false), callbackIoService_(0),
+    delayedCallTable_(ioService_)
+  {
+  }
+
+  /**
+   * If this Shard has its own thread, stop the io_service and join the thread.
+   */
+  ~Shard()
+  {
+    if (hasThread_) {
+      work_.reset();
+      ioService_.stop();
+      pthread_join(thread_, 0);
+    }
+  }
+
+  boost::asio::io_service&
+  getIoService() { return ioService_; }
+
+  /**
+   * Add the entry to the pending interest table and set up the timeout, then
+   * dispatch to the node's io_service to send the interest. This must be
+   * called on the thread of this shard's io_service.
+   */
+  void
+  expressInterest
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interestCopy,
+     const OnData& onData, const OnTimeout& onTimeout,
+     const OnNetworkNack& onNetworkNack, WireFormat* wireFormat, Node* node,
+     boost::asio::io_service* nodeIoService);
+
+  /**
+   * Call the OnData callback of each matching pending interest, or post it to
+   * callbackIoService_. This must be called on the thread of this shard's
+   * io_service.
+   */
+  void
+  satisfyPendingInterests(const ptr_lib::shared_ptr<Data>& data);
+
+  /**
+   * Call the OnNetworkNack callback of each matching pending interest, or post
+   * it to callbackIoService_. This must be called on the thread of this shard's
+   * io_service.
+   */
+  void
+  processNetworkNack
+    (const ptr_lib::shared_ptr<Interest>& interest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack);
+
+  /**
+   * Remove the pending interest if it is in this shard. This must be called on
+   * the thread of this shard's io_service.
+   */
+  void
+  removePendingInterest(uint64_t pendingInterestId)
+  {
+    pendingInterestTable_.removeExistingPendingInterest(pendingInterestId);
+  }
+
+  /**
+   * Check if this shard has no pending interests. This must be called on the
+   * thread of this shard's io_service.
+   */
+  bool
+  isEmpty() const { return pendingInterestTable_.isEmpty(); }
+
+private:
+  static void*
+  run(void* shard);
+
+  static void
+  callOnData
+    (const ptr_lib::shared_ptr<PendingInterestTable::Entry>& pendingInterest,
+     const ptr_lib::shared_ptr<Data>& data);
+
+  static void
+  callOnNetworkNack
+    (const ptr_lib::shared_ptr<PendingInterestTable::Entry>& pendingInterest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack);
+
+  void
+  processInterestTimeout
+    (const ptr_lib::weak_ptr<PendingInterestTable::Entry>& pendingInterestPointer);
+
+  // This is only used if this Shard has its own thread.
+  boost::movelib::unique_ptr<boost::asio::io_service> internalIoService_;
+  boost::asio::io_service& ioService_;
+  boost::movelib::unique_ptr<boost::asio::io_service::work> work_;
+  pthread_t thread_;
+  bool hasThread_;
+  // The application's io_service for the callbacks, or 0 to call them here.
+  boost::asio::io_service* callbackIoService_;
+  PendingInterestTable pendingInterestTable_;
+  // The Interest timeouts, which share one timer of ioService_.
+  AsioDelayedCallTable delayedCallTable_;
+};
+
+void*
+ShardedThreadsafeFace::Shard::run(void* shard)
+{
+  try {
+    ((Shard*)shard)->ioService_.run();
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("ShardedThreadsafeFace: Error in the shard thread: " << ex.what());
+  } catch (...) {
+    _LOG_ERROR("ShardedThreadsafeFace: Error in the shard thread.");
+  }
+
+  return 0;
+}
+
+void
+ShardedThreadsafeFace::Shard::expressInterest
+  (uint64_t pendingInterestId,
+   const ptr_lib::shared_ptr<const Interest>& interestCopy,
+   const OnData& onData, const OnTimeout& onTimeout,
+   const OnNetworkNack& onNetworkNack, WireFormat* wireFormat, Node* node,
+   boost::asio::io_service* nodeIoService)
+{
+  ptr_lib::shared_ptr<PendingInterestTable::Entry> pendingInterest =
+    pendingInterestTable_.add
+      (pendingInterestId, interestCopy, onData, onTimeout, onNetworkNack);
+  if (!pendingInterest)
+    // Don't expect this since removePendingInterest doesn't save requests.
+    return;
+
+  if (onTimeout || interestCopy->getInterestLifetimeMilliseconds() >= 0.0) {
+    // Set up the timeout, the same as Node.
+    double delayMilliseconds = interestCopy->getInterestLifetimeMilliseconds();
+    if (delayMilliseconds < 0.0)
+      // Use a default timeout delay.
+      delayMilliseconds = 4000.0;
+
+    delayedCallTable_.callLater
+      (delayMilliseconds,
+       boost::bind(&Shard::processInterestTimeout, this,
+                   ptr_lib::weak_ptr<PendingInterestTable::Entry>(pendingInterest)));
+  }
+
+  // The entry is already in the table, so the node can send the interest and
+  // route the Data packet back to this shard.
+  nodeIoService->dispatch(boost::bind
+    (&Node::sendInterest, node, interestCopy, boost::ref(*wireFormat)));
+}
+
+void
+ShardedThreadsafeFace::Shard::processInterestTimeout
+  (const ptr_lib::weak_ptr<PendingInterestTable::Entry>& pendingInterestPointer)
+{
+  ptr_lib::shared_ptr<PendingInterestTable::Entry> pendingInterest =
+    pendingInterestPointer.lock();
+  if (!pendingInterest)
+    // The pending interest was already satisfied or removed.
+    return;
+
+  if (pendingInterestTable_.removeEntry(pendingInterest)) {
+    if (callbackIoService_)
+      callbackIoService_->post(boost::bind
+        (&PendingInterestTable::Entry::callTimeout, pendingInterest));
+    else
+      pendingInterest->callTimeout();
+  }
+}
+
+void
+ShardedThreadsafeFace::Shard::satisfyPendingInterests
+  (const ptr_lib::shared_ptr<Data>& data)
+{
+  vector<ptr_lib::shared_ptr<PendingInterestTable::Entry> > pitEntries;
+  pendingInterestTable_.extractEntriesForExpressedInterest(*data, pitEntries);
+  for (size_t i = 0; i < pitEntries.size(); ++i) {
+    if (callbackIoService_)
+      callbackIoService_->post(boost::bind
+        (&Shard::callOnData, pitEntries[i], data));
+    else
+      callOnData(pitEntries[i], data);
+  }
+}
+
+void
+ShardedThreadsafeFace::Shard::processNetworkNack
+  (const ptr_lib::shared_ptr<Interest>& interest,
+   const ptr_lib::shared_ptr<NetworkNack>& networkNack)
+{
+  vector<ptr_lib::shared_ptr<PendingInterestTable::Entry> > pitEntries;
+  pendingInterestTable_.extractEntriesForNackInterest(*interest, pitEntries);
+  for (size_t i = 0; i < pitEntries.size(); ++i) {
+    if (callbackIoService_)
+      callbackIoService_->post(boost::bind
+        (&Shard::callOnNetworkNack, pitEntries[i], networkNack));
+    else
+      callOnNetworkNack(pitEntries[i], networkNack);
+  }
+}
+
+void
+ShardedThreadsafeFace::Shard::callOnData
+  (const ptr_lib::shared_ptr<PendingInterestTable::Entry>& pendingInterest,
+   const ptr_lib::shared_ptr<Data>& data)
+{
+  try {
+    pendingInterest->getOnData()(pendingInterest->getInterest(), data);
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("ShardedThreadsafeFace: Error in onData: " << ex.what());
+  } catch (...) {
+    _LOG_ERROR("ShardedThreadsafeFace: Error in onData.");
+  }
+}
+
+void
+ShardedThreadsafeFace::Shard::callOnNetworkNack
+  (const ptr_lib::shared_ptr<PendingInterestTable::Entry>& pendingInterest,
+   const ptr_lib::shared_ptr<NetworkNack>& networkNack)
+{
+  try {
+    pendingInterest->getOnNetworkNack()
+      (pendingInterest->getInterest(), networkNack);
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("ShardedThreadsafeFace: Error in onNetworkNack: " << ex.what());
+  } catch (...) {
+    _LOG_ERROR("ShardedThreadsafeFace: Error in onNetworkNack.");
+  }
+}
+
+/**
+ * Get the number of components of the Interest name, not counting a final
+ * implicit digest component.
+ */
+static size_t
+getInterestNameComponentCount(const Name& name)
+{
+  if (name.size() > 0 && name.get(-1).isImplicitSha256Digest())
+    return name.size() - 1;
+  else
+    return name.size();
+}
+
+ShardedThreadsafeFace::ShardedThreadsafeFace
+  (boost::asio::io_service& ioService,
+   const ptr_lib::shared_ptr<Transport>& transport,
+   const ptr_lib::shared_ptr<const Transport::ConnectionInfo>& connectionInfo,
+   size_t nShards, size_t nShardKeyComponents, bool callOnShardThreads)
+  : ThreadsafeFace(ioService, transport, connectionInfo),
+    nShardKeyComponents_(nShardKeyComponents)
+{
+  construct(nShards, callOnShardThreads);
+}
+
+ShardedThreadsafeFace::ShardedThreadsafeFace
+  (boost::asio::io_service& ioService, size_t nShards,
+   size_t nShardKeyComponents, bool callOnShardThreads)
+  : ThreadsafeFace(ioService), nShardKeyComponents_(nShardKeyComponents)
+{
+  construct(nShards, callOnShardThreads);
+}
+
+void
+ShardedThreadsafeFace::construct(size_t nShards, bool callOnShardThreads)
+{
+  if (nShards == 0) {
+    long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    nShards = (nProcessors > 0 ? (size_t)nProcessors : 1);
+  }
+
+  boost::asio::io_service* callbackIoService =
+    (callOnShardThreads ? 0 : &getIoService());
+  for (size_t i = 0; i < nShards; ++i)
+    shards_.push_back(ptr_lib::shared_ptr<Shard>(new Shard(callbackIoService)));
+  shortNameShard_.reset(new Shard(getIoService()));
+
+  node_->setOnReceivedPacket
+    (boost::bind(&ShardedThreadsafeFace::onReceivedData, this, _1),
+     boost::bind(&ShardedThreadsafeFace::onReceivedNetworkNack, this, _1, _2));
+}
+
+ShardedThreadsafeFace::~ShardedThreadsafeFace()
+{
+  node_->setOnReceivedPacket
+    (Node::OnReceivedData(), Node::OnReceivedNetworkNack());
+  // This stops and joins each shard thread.
+  shards_.clear();
+}
+
+uint64_t
+ShardedThreadsafeFace::expressInterest
+  (const Interest& interest, const OnData& onData, const OnTimeout& onTimeout,
+   const OnNetworkNack& onNetworkNack, WireFormat& wireFormat)
+{
+  return expressInterestCopy
+    (ptr_lib::make_shared<const Interest>(interest), onData, onTimeout,
+     onNetworkNack, wireFormat);
+}
+
+uint64_t
+ShardedThreadsafeFace::expressInterest
+  (const Name& name, const Interest *interestTemplate, const OnData& onData,
+   const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+   WireFormat& wireFormat)
+{
+  return expressInterestCopy
+    (getInterestCopy(name, interestTemplate), onData, onTimeout, onNetworkNack,
+     wireFormat);
+}
+
+uint64_t
+ShardedThreadsafeFace::expressInterestCopy
+  (const ptr_lib::shared_ptr<const Interest>& interestCopy, const OnData& onData,
+   const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+   WireFormat& wireFormat)
+{
+  size_t shardIndex = getShardIndex
+    (interestCopy->getName(),
+     getInterestNameComponentCount(interestCopy->getName()));
+  // Node.lastEntryId_ uses atomic_uint64_t, so this call is thread safe. Put
+  // the shard index in the low part of the ID so that removePendingInterest
+  // can find the shard.
+  uint64_t pendingInterestId =
+    node_->getNextEntryId() * (shards_.size() + 1) + shardIndex;
+
+  if (interestCopy->getNonce().size() == 0) {
+    // Set the nonce here, the same as Node.expressInterest, so that the shard
+    // saves it in the PIT.
+    const_cast<Interest*>(interestCopy.get())->setNonce
+      (Blob((const uint8_t*)"\0\0\0\0", 4));
+    const_cast<Interest*>(interestCopy.get())->refreshNonce();
+  }
+
+  Shard& shard = getShard(shardIndex);
+  shard.getIoService().dispatch(boost::bind
+    (&Shard::expressInterest, &shard, pendingInterestId,
+     interestCopy, onData, onTimeout,
+     onNetworkNack, &wireFormat, node_, &getIoService()));
+
+  return pendingInterestId;
+}
+
+void
+ShardedThreadsafeFace::removePendingInterest(uint64_t pendingInterestId)
+{
+  // This relies on each shard's io_service being run by one thread, which
+  // calls handlers in the order they are posted. (The shortNameShard_ uses the
+  // application's ioService, which the class documentation requires to be run
+  // by one thread.) expressInterestCopy posted (or
+  // already called) the handler to add the entry before it returned the
+  // pendingInterestId. Use post, not dispatch, so that even on the shard's
+  // thread the handler to remove the entry is called after the one to add it.
+  Shard& shard = getShard(pendingInterestId % (shards_.size() + 1));
+  shard.getIoService().post(boost::bind
+    (&Shard::removePendingInterest, &shard, pendingInterestId));
+}
+
+size_t
+ShardedThreadsafeFace::getShardIndex(const Name& name, size_t nComponents)
+{
+  if (nComponents < nShardKeyComponents_)
+    return shards_.size();
+
+  size_t hashCode = 0;
+  for (size_t i = 0; i < nShardKeyComponents_; ++i)
+    hashCode = 37 * hashCode + name.get(i).hash();
+
+  return hashCode % shards_.size();
+}
+
+void
+ShardedThreadsafeFace::onReceivedData(const ptr_lib::shared_ptr<Data>& data)
+{
+  size_t nComponents = data->getName().size();
+  if (nComponents >= nShardKeyComponents_) {
+    Shard& shard = getShard(data->getName(), nComponents);
+    if (shortNameShard_->isEmpty())
+      shard.getIoService().post(boost::bind
+        (&Shard::satisfyPendingInterests, &shard, data));
+    else
+      // The short name shard may also call onData on this thread, so give the
+      // other shard its own copy.
+      shard.getIoService().post(boost::bind
+        (&Shard::satisfyPendingInterests, &shard,
+         ptr_lib::make_shared<Data>(*data)));
+  }
+
+  // A Data packet with any name may match an Interest with a short name.
+  // We are on the thread of the ioService, so call directly.
+  shortNameShard_->satisfyPendingInterests(data);
+}
+
+void
+ShardedThreadsafeFace::onReceivedNetworkNack
+  (const ptr_lib::shared_ptr<Interest>& interest,
+   const ptr_lib::shared_ptr<NetworkNack>& networkNack)
+{
+  Shard& shard = getShard
+    (interest->getName(), getInterestNameComponentCount(interest->getName()));
+  if (&shard == shortNameShard_.get())
+    // We are on the thread of the ioService, so call directly.
+    shard.processNetworkNack(interest, networkNack);
+  else
+    shard.getIoService().post(boost::bind
+      (&Shard::processNetworkNack, &shard, interest, networkNack));
+}
+
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
@@ -20,15 +20,11 @@
  * A copy of the GNU Lesser General Public License is in the file COPYING.
  */
 
-// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_PROTOBUF = 1.
-#include <ndn-cpp/ndn-cpp-config.h>
-#if NDN_CPP_HAVE_PROTOBUF
-
 #include <stdexcept>
 #include <ndn-cpp/util/logging.hpp>
-#include "sync-state.pb.h"
 #include "../c/util/time.h"
 #include "digest-tree.hpp"
+#include "sync-state-codec.hpp"
 #include <ndn-cpp/sync/chrono-sync2013.hpp>
 
 INIT_LOGGER("ndn.ChronoSync2013");
@@ -50,16 +46,16 @@ ChronoSync2013::Impl::Impl
   face_(face), keyChain_(keyChain), certificateName_(certificateName),
   syncLifetime_(syncLifetime), initialPreviousSequenceNo_(previousSequenceNumber),
   sequenceNo_(previousSequenceNumber), digestTree_(new DigestTree()),
-  contentCache_(&face), enabled_(true)
+  nPrunedLogEntries_(0), digestLogBytes_(0), maxDigestLogEntries_(0),
+  maxDigestLogBytes_(0), contentCache_(&face),
+  syncStateEncoding_(SYNC_STATE_ENCODING_PROTOBUF), enabled_(true)
 {
 }
 
 void
 ChronoSync2013::Impl::initialize(const OnRegisterFailed& onRegisterFailed)
 {
-  Sync::SyncStateMsg emptyContent;
-  digestLog_.push_back(ptr_lib::make_shared<DigestLogEntry>
-    ("00", emptyContent.ss()));
+  addLogEntry(ptr_lib::make_shared<DigestLogEntry>("00", vector<SyncState>()));
 
   // Register the prefix with the contentCache_ and use our own onInterest
   //   as the onDataNotFound fallback.
@@ -80,32 +76,74 @@ ChronoSync2013::Impl::initialize(const OnRegisterFailed& onRegisterFailed)
 int
 ChronoSync2013::Impl::logFind(const std::string& digest) const
 {
-  for (size_t i = 0; i < digestLog_.size(); ++i) {
-    if (digest == digestLog_[i]->getDigest())
-      return i;
-  }
+  unordered_map<string, size_t>::const_iterator entry =
+    digestLogIndex_.find(digest);
+  if (entry == digestLogIndex_.end())
+    return -1;
 
-  return -1;
+  return entry->second - nPrunedLogEntries_;
 };
 
+void
+ChronoSync2013::Impl::addLogEntry(const ptr_lib::shared_ptr<DigestLogEntry>& entry)
+{
+  digestLogIndex_[entry->getDigest()] = nPrunedLogEntries_ + digestLog_.size();
+  digestLog_.push_back(entry);
+  digestLogBytes_ += getLogEntryMemoryUsage(*entry);
+
+  pruneLog();
+}
+
+void
+ChronoSync2013::Impl::pruneLog()
+{
+  bool pruned = false;
+  while (digestLog_.size() > 1 &&
+         ((maxDigestLogEntries_ != 0 &&
+           digestLog_.size() > maxDigestLogEntries_) ||
+          (maxDigestLogBytes_ != 0 && digestLogBytes_ > maxDigestLogBytes_))) {
+    const DigestLogEntry& oldest = *digestLog_.front();
+    digestLogBytes_ -= getLogEntryMemoryUsage(oldest);
+    digestLogIndex_.erase(oldest.getDigest());
+    digestLog_.pop_front();
+    ++nPrunedLogEntries_;
+    pruned = true;
+  }
+
+  if (pruned) {
+    // The oldest entry is now the snapshot base. processSyncInterest only
+    // sends the sync states after the matching entry, so clear its sync states.
+    DigestLogEntry& base = *digestLog_.front();
+    digestLogBytes_ -= getLogEntryMemoryUsage(base);
+    base.clearData();
+    digestLogBytes_ += getLogEntryMemoryUsage(base);
+  }
+}
+
+size_t
+ChronoSync2013::Impl::getLogEntryMemoryUsage(const DigestLogEntry& entry)
+{
+  // Include the shared_ptr in digestLog_ and the node in digestLogIndex_.
+  return entry.getMemoryUsage() + sizeof(ptr_lib::shared_ptr<DigestLogEntry>) +
+    sizeof(pair<const string, size_t>) + 2 * sizeof(void*) +
+    entry.getDigest().capacity();
+}
+
 bool
-ChronoSync2013::Impl::update
-  (const google::protobuf::RepeatedPtrField<Sync::SyncState >& content)
+ChronoSync2013::Impl::update(const vector<SyncState>& content)
 {
   for (size_t i = 0; i < content.size(); ++i) {
-    if (content.Get(i).type() == Sync::SyncState_ActionType_UPDATE) {
-      if (digestTree_->update
-          (content.Get(i).name(), content.Get(i).seqno().session(),
-           content.Get(i).seqno().seq())) {
-        // The digest tree was updated.
-        if (applicationDataPrefixUri_ == content.Get(i).name())
-          sequenceNo_ = content.Get(i).seqno().seq();
-      }
+    if (digestTree_->update
+        (content[i].getDataPrefix(), content[i].getSessionNo(),
+         content[i].getSequenceNo())) {
+      // The digest tree was updated.
+      if (applicationDataPrefixUri_ == content[i].getDataPrefix())
+        sequenceNo_ = content[i].getSequenceNo();
     }
   }
 
   if (logFind(digestTree_->getRoot()) == -1) {
-    digestLog_.push_back(ptr_lib::make_shared<DigestLogEntry>
+    addLogEntry(ptr_lib::make_shared<DigestLogEntry>
       (digestTree_->getRoot(), content));
     return true;
   }
@@ -136,24 +174,46 @@ ChronoSync2013::Impl::getProducerSequenceNo(const std::string& dataPrefix, int s
     return digestTree_->get(index).getSequenceNo();
 }
 
+void
+ChronoSync2013::Impl::setRootDigestMode(RootDigestMode rootDigestMode)
+{
+  digestTree_->setRootDigestMode((DigestTree::RootDigestMode)rootDigestMode);
+}
+
+ChronoSync2013::RootDigestMode
+ChronoSync2013::Impl::getRootDigestMode() const
+{
+  return (RootDigestMode)digestTree_->getRootDigestMode();
+}
+
+void
+ChronoSync2013::Impl::setMaxDigestLogEntries(size_t maxDigestLogEntries)
+{
+  maxDigestLogEntries_ = maxDigestLogEntries;
+  pruneLog();
+}
+
+void
+ChronoSync2013::Impl::setMaxDigestLogBytes(size_t maxDigestLogBytes)
+{
+  maxDigestLogBytes_ = maxDigestLogBytes;
+  pruneLog();
+}
+
 void
 ChronoSync2013::Impl::publishNextSequenceNo(const Blob& applicationInfo)
 {
   ++sequenceNo_;
 
-  Sync::SyncStateMsg syncMessage;
-  Sync::SyncState* content = syncMessage.add_ss();
-  content->set_name(applicationDataPrefixUri_);
-  content->set_type(Sync::SyncState_ActionType_UPDATE);
-  content->mutable_seqno()->set_seq(sequenceNo_);
-  content->mutable_seqno()->set_session(sessionNo_);
-  if (!applicationInfo.isNull() && applicationInfo.size() > 0)
-    content->set_application_info(applicationInfo.buf(), applicationInfo.size());
-
+  vector<SyncState> syncStates;
+  syncStates.push_back(SyncState
+    (applicationDataPrefixUri_, sessionNo_, sequenceNo_,
+     (!applicationInfo.isNull() && applicationInfo.size() > 0) ?
+       applicationInfo : Blob()));
 
-  broadcastSyncState(digestTree_->getRoot(), syncMessage);
+  broadcastSyncState(digestTree_->getRoot(), syncStates);
 
-  if (!update(syncMessage.ss()))
+  if (!update(syncStates))
     // Since we incremented the sequence number, we expect there to be a
     //   new digest log entry.
     throw runtime_error
@@ -230,10 +290,16 @@ ChronoSync2013::Impl::onData
 
   _LOG_DEBUG("Sync ContentObject received in callback");
   _LOG_DEBUG("name: " + data->getName().toUri());
-  Sync::SyncStateMsg tempContent;
-  tempContent.ParseFromArray(data->getContent().buf(), data->getContent().size());
+  // The decoded content has only UPDATE sync states.
+  vector<SyncState> content;
+  try {
+    SyncStateCodec::decode
+      (data->getContent().buf(), data->getContent().size(), content);
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("ChronoSync2013::Impl::onData: Error decoding the sync state: " <<
+               ex.what());
+  }
 
-  const google::protobuf::RepeatedPtrField<Sync::SyncState >&content = tempContent.ss();
   bool isRecovery;
   if (digestTree_->getRoot() == "00") {
     isRecovery = true;
@@ -250,24 +316,8 @@ ChronoSync2013::Impl::onData
   }
 
   // Send the interests to fetch the application data.
-  vector<SyncState> syncStates;
-  for (size_t i = 0; i < content.size(); ++i) {
-    // Only report UPDATE sync states.
-    if (content.Get(i).type() == Sync::SyncState_ActionType_UPDATE) {
-      Blob applicationInfo;
-      if (content.Get(i).has_application_info() &&
-          content.Get(i).application_info().size() > 0)
-        applicationInfo = Blob
-          ((const uint8_t*)&content.Get(i).application_info()[0],
-           content.Get(i).application_info().size());
-
-      syncStates.push_back(SyncState
-        (content.Get(i).name(), content.Get(i).seqno().session(),
-         content.Get(i).seqno().seq(), applicationInfo));
-    }
-  }
   try {
-    onReceivedSyncState_(syncStates, isRecovery);
+    onReceivedSyncState_(content, isRecovery);
   } catch (const std::exception& ex) {
     _LOG_ERROR("ChronoSync2013::Impl::onData: Error in onReceivedSyncState: " << ex.what());
   } catch (...) {
@@ -290,21 +340,23 @@ ChronoSync2013::Impl::processRecoveryInterest
   (const Interest& interest, const string& syncDigest, Face& face)
 {
   _LOG_DEBUG("processRecoveryInst");
-  if (logFind(syncDigest) != -1) {
-    Sync::SyncStateMsg tempContent;
+  // The "00" entry and others may have been pruned from the digest log. In
+  // that case we can't tell an old digest from an unknown one, so send the
+  // full state.
+  if (syncDigest == "00" || logFind(syncDigest) != -1 ||
+      nPrunedLogEntries_ > 0) {
+    vector<SyncState> tempContent;
+    tempContent.reserve(digestTree_->size());
     for (size_t i = 0; i < digestTree_->size(); ++i) {
-      Sync::SyncState* content = tempContent.add_ss();
-      content->set_name(digestTree_->get(i).getDataPrefix());
-      content->set_type(Sync::SyncState_ActionType_UPDATE);
-      content->mutable_seqno()->set_seq(digestTree_->get(i).getSequenceNo());
-      content->mutable_seqno()->set_session(digestTree_->get(i).getSessionNo());
+      const DigestTree::Node& node = digestTree_->get(i);
+      tempContent.push_back(SyncState
+        (node.getDataPrefix(), node.getSessionNo(), node.getSequenceNo(),
+         Blob()));
     }
 
-    if (tempContent.ss_size() != 0) {
-      ptr_lib::shared_ptr<vector<uint8_t> > array(new vector<uint8_t>(tempContent.ByteSize()));
-      tempContent.SerializeToArray(&array->front(), array->size());
+    if (tempContent.size() != 0) {
       Data data(interest.getName());
-      data.setContent(Blob(array, false));
+      data.setContent(encodeSyncStates(tempContent));
       if (interest.getName().get(-1).toEscapedString() == "00")
         // Limit the lifetime of replies to interest for "00" since they can be different.
         data.getMetaInfo().setFreshnessPeriod(1000);
@@ -329,51 +381,41 @@ ChronoSync2013::Impl::processSyncInterest
   vector<string> nameList;
   vector<int> sequenceNoList;
   vector<int> sessionNoList;
+  // The key is the name. The value is the index in nameList.
+  unordered_map<string, size_t> nameIndex;
   for (size_t j = index + 1; j < digestLog_.size(); ++j) {
-    const google::protobuf::RepeatedPtrField<Sync::SyncState>& temp =
-      digestLog_[j]->getData();
+    const vector<SyncState>& temp = digestLog_[j]->getData();
     for (size_t i = 0; i < temp.size(); ++i) {
-      if (temp.Get(i).type() != Sync::SyncState_ActionType_UPDATE)
-        continue;
-
-      if (digestTree_->find(temp.Get(i).name(), temp.Get(i).seqno().session()) != -1) {
-        int n = -1;
-        for (size_t k = 0; k < nameList.size(); ++k) {
-          if (nameList[k] == temp.Get(i).name()) {
-            n = k;
-            break;
-          }
-        }
+      if (digestTree_->find(temp[i].getDataPrefix(), temp[i].getSessionNo()) != -1) {
+        unordered_map<string, size_t>::iterator found =
+          nameIndex.find(temp[i].getDataPrefix());
+        int n = (found == nameIndex.end() ? -1 : (int)found->second);
         if (n == -1) {
-          nameList.push_back(temp.Get(i).name());
-          sequenceNoList.push_back(temp.Get(i).seqno().seq());
-          sessionNoList.push_back(temp.Get(i).seqno().session());
+          nameIndex[temp[i].getDataPrefix()] = nameList.size();
+          nameList.push_back(temp[i].getDataPrefix());
+          sequenceNoList.push_back(temp[i].getSequenceNo());
+          sessionNoList.push_back(temp[i].getSessionNo());
         }
         else {
-          sequenceNoList[n] = temp.Get(i).seqno().seq();
-          sessionNoList[n] = temp.Get(i).seqno().session();
+          sequenceNoList[n] = temp[i].getSequenceNo();
+          sessionNoList[n] = temp[i].getSessionNo();
         }
       }
     }
   }
 
-  Sync::SyncStateMsg tempContent;
-  for (size_t i = 0; i < nameList.size(); ++i) {
-    Sync::SyncState* content = tempContent.add_ss();
-    content->set_name(nameList[i]);
-    content->set_type(Sync::SyncState_ActionType_UPDATE);
-    content->mutable_seqno()->set_seq(sequenceNoList[i]);
-    content->mutable_seqno()->set_session(sessionNoList[i]);
-  }
+  vector<SyncState> tempContent;
+  tempContent.reserve(nameList.size());
+  for (size_t i = 0; i < nameList.size(); ++i)
+    tempContent.push_back(SyncState
+      (nameList[i], sessionNoList[i], sequenceNoList[i], Blob()));
 
   bool sent = false;
-  if (tempContent.ss_size() != 0) {
+  if (tempContent.size() != 0) {
     Name name(applicationBroadcastPrefix_);
     name.append(syncDigest);
-    ptr_lib::shared_ptr<vector<uint8_t> > array(new vector<uint8_t>(tempContent.ByteSize()));
-    tempContent.SerializeToArray(&array->front(), array->size());
     Data data(name);
-    data.setContent(Blob(array, false));
+    data.setContent(encodeSyncStates(tempContent));
     keyChain_.sign(data, certificateName_);
     try {
       face.putData(data);
@@ -445,22 +487,19 @@ ChronoSync2013::Impl::syncTimeout(const ptr_lib::shared_ptr<const Interest>& int
 }
 
 void
-ChronoSync2013::Impl::initialOndata
-  (const google::protobuf::RepeatedPtrField<Sync::SyncState >& content)
+ChronoSync2013::Impl::initialOndata(const vector<SyncState>& content)
 {
   // The user is a new comer and receive data of all other people in the group.
   update(content);
   string digest = digestTree_->getRoot();
   for (size_t i = 0; i < content.size(); ++i) {
-    if (content.Get(i).name() == applicationDataPrefixUri_ && content.Get(i).seqno().session() == sessionNo_) {
+    if (content[i].getDataPrefix() == applicationDataPrefixUri_ && content[i].getSessionNo() == sessionNo_) {
       // If the user was an old comer, after add the static log he needs to increase his seqno by 1.
-      Sync::SyncStateMsg tempContent;
-      Sync::SyncState* content2 = tempContent.add_ss();
-      content2->set_name(applicationDataPrefixUri_);
-      content2->set_type(Sync::SyncState_ActionType_UPDATE);
-      content2->mutable_seqno()->set_seq(content.Get(i).seqno().seq() + 1);
-      content2->mutable_seqno()->set_session(sessionNo_);
-      if (update(tempContent.ss())) {
+      vector<SyncState> tempContent;
+      tempContent.push_back(SyncState
+        (applicationDataPrefixUri_, sessionNo_, content[i].getSequenceNo() + 1,
+         Blob()));
+      if (update(tempContent)) {
         try {
           onInitialized_();
         } catch (const std::exception& ex) {
@@ -472,22 +511,14 @@ ChronoSync2013::Impl::initialOndata
     }
   }
 
-  Sync::SyncStateMsg tempContent2;
-  if (sequenceNo_ >= 0) {
+  vector<SyncState> tempContent2;
+  if (sequenceNo_ >= 0)
     // Send the data packet with the new seqno back.
-    Sync::SyncState* content2 = tempContent2.add_ss();
-    content2->set_name(applicationDataPrefixUri_);
-    content2->set_type(Sync::SyncState_ActionType_UPDATE);
-    content2->mutable_seqno()->set_seq(sequenceNo_);
-    content2->mutable_seqno()->set_session(sessionNo_);
-  }
-  else {
-    Sync::SyncState* content2 = tempContent2.add_ss();
-    content2->set_name(applicationDataPrefixUri_);
-    content2->set_type(Sync::SyncState_ActionType_UPDATE);
-    content2->mutable_seqno()->set_seq(0);
-    content2->mutable_seqno()->set_session(sessionNo_);
-  }
+    tempContent2.push_back(SyncState
+      (applicationDataPrefixUri_, sessionNo_, sequenceNo_, Blob()));
+  else
+    tempContent2.push_back(SyncState
+      (applicationDataPrefixUri_, sessionNo_, 0, Blob()));
 
   broadcastSyncState(digest, tempContent2);
 
@@ -495,14 +526,11 @@ ChronoSync2013::Impl::initialOndata
     // the user hasn't put himself in the digest tree.
     _LOG_DEBUG("initial state");
     ++sequenceNo_;
-    Sync::SyncStateMsg tempContent;
-    Sync::SyncState* content2 = tempContent.add_ss();
-    content2->set_name(applicationDataPrefixUri_);
-    content2->set_type(Sync::SyncState_ActionType_UPDATE);
-    content2->mutable_seqno()->set_seq(sequenceNo_);
-    content2->mutable_seqno()->set_session(sessionNo_);
-
-    if (update(tempContent.ss())) {
+    vector<SyncState> tempContent;
+    tempContent.push_back(SyncState
+      (applicationDataPrefixUri_, sessionNo_, sequenceNo_, Blob()));
+
+    if (update(tempContent)) {
       try {
         onInitialized_();
       } catch (const std::exception& ex) {
@@ -532,13 +560,10 @@ ChronoSync2013::Impl::initialTimeOut(const ptr_lib::shared_ptr<const Interest>&
     return;
   }
 
-  Sync::SyncStateMsg tempContent;
-  Sync::SyncState* content = tempContent.add_ss();
-  content->set_name(applicationDataPrefixUri_);
-  content->set_type(Sync::SyncState_ActionType_UPDATE);
-  content->mutable_seqno()->set_seq(sequenceNo_);
-  content->mutable_seqno()->set_session(sessionNo_);
-  update(tempContent.ss());
+  vector<SyncState> tempContent;
+  tempContent.push_back(SyncState
+    (applicationDataPrefixUri_, sessionNo_, sequenceNo_, Blob()));
+  update(tempContent);
 
   try {
     onInitialized_();
@@ -561,23 +586,36 @@ ChronoSync2013::Impl::initialTimeOut(const ptr_lib::shared_ptr<const Interest>&
 
 void
 ChronoSync2013::Impl::broadcastSyncState
-  (const string& digest, const Sync::SyncStateMsg& syncMessage)
+  (const string& digest, const vector<SyncState>& syncStates)
 {
-  ptr_lib::shared_ptr<vector<uint8_t> > array(new vector<uint8_t>(syncMessage.ByteSize()));
-  syncMessage.SerializeToArray(&array->front(), array->size());
   Data data(applicationBroadcastPrefix_);
   data.getName().append(digest);
-  data.setContent(Blob(array, false));
+  data.setContent(encodeSyncStates(syncStates));
   keyChain_.sign(data, certificateName_);
   contentCache_.add(data);
 }
 
-ChronoSync2013::DigestLogEntry::DigestLogEntry
-  (const std::string& digest,
-   const google::protobuf::RepeatedPtrField<Sync::SyncState>& data)
-  : digest_(digest),
-   data_(new google::protobuf::RepeatedPtrField<Sync::SyncState>(data))
+size_t
+ChronoSync2013::DigestLogEntry::getMemoryUsage() const
 {
+  size_t result = sizeof(DigestLogEntry) + digest_.capacity() +
+    data_.capacity() * sizeof(SyncState);
+  for (size_t i = 0; i < data_.size(); ++i) {
+    result += data_[i].getDataPrefix().capacity();
+    if (!data_[i].getApplicationInfo().isNull())
+      result += data_[i].getApplicationInfo().size();
+  }
+
+  return result;
+}
+
+Blob
+ChronoSync2013::Impl::encodeSyncStates(const vector<SyncState>& syncStates) const
+{
+  if (syncStateEncoding_ == SYNC_STATE_ENCODING_TLV)
+    return SyncStateCodec::encodeTlv(syncStates);
+  else
+    return SyncStateCodec::encodeProtobuf(syncStates);
 }
 
 void
@@ -588,5 +626,3 @@ ChronoSync2013::Impl::dummyOnData
 }
 
 }
-
-#endif // NDN_CPP_HAVE_PROTOBUF
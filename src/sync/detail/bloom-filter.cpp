@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ * @author: From the PSync library https://github.com/named-data/PSync/blob/master/PSync/detail/bloom-filter.cpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ *
+ * This file incorporates work covered by the following copyright and
+ * permission notice:
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2000 Arash Partow
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "bloom-filter.hpp"
+
+using namespace std;
+
+namespace ndn {
+
+// The salts from the Open Bloom Filter library which are used by PSync.
+static const uint32_t PREDEFINED_SALTS[] = {
+  0xAAAAAAAA, 0x55555555, 0x33333333, 0xCCCCCCCC, 0x66666666, 0x99999999,
+  0xB5B5B5B5, 0x4B4B4B4B, 0xAA55AA55, 0x55335533, 0x33CC33CC, 0xCC66CC66,
+  0x66996699, 0x99B599B5, 0xB54BB54B, 0x4BAA4BAA, 0xAA33AA33, 0x55CC55CC,
+  0x33663366, 0xCC99CC99, 0x66B566B5, 0x994B994B, 0xB5AAB5AA, 0xAAAAAA33,
+  0x555555CC, 0x33333366, 0xCCCCCC99, 0x666666B5, 0x9999994B, 0xB5B5B5AA,
+  0xFFFFFFFF, 0xFFFF0000, 0xB823D5EB, 0xC1191CDF, 0xF623AEB3, 0xDB58499F,
+  0xC8D42E70, 0xB173F616, 0xA91A5967, 0xDA427D63, 0xB1E8A2EA, 0xF6C0D155,
+  0x4909FEA3, 0xA68CC6A7, 0xC395E782, 0xA26057EB, 0x0CD5DA28, 0x467C5492,
+  0xF15E6982, 0x61C6FAD3, 0x9615E352, 0x6E9E355A, 0x689B563E, 0x0C9831A8,
+  0x6753C18B, 0xA622689B, 0x8CA63C47, 0x42CC2884, 0x8E89919B, 0x6EDBD7D3,
+  0x15B6796C, 0x1D6FDFE4, 0x63FF9092, 0xE7401432, 0xEFFE9412, 0xAEAEDF79,
+  0x9F245A31, 0x83C136FC, 0xC3DA4A8C, 0xA5112C8C, 0x5271F491, 0x9A948DAB,
+  0xCEE59A8D, 0xB5F525AB, 0x59D13217, 0x24E7C331, 0x697C2103, 0x84B0A460,
+  0x86156DA9, 0xAEF2AC68, 0x23243DA5, 0x3F649643, 0x5FA495A8, 0x67710DF8,
+  0x9A6C499E, 0xDCFB0227, 0x46A43433, 0x1832B07A, 0xC46AFF3C, 0xB9C8FFF0,
+  0xC9500467, 0x34431BDF, 0xB652432B, 0xE367F12B, 0x427F4C1B, 0x224C006E,
+  0x2E7E5A89, 0x96F99AA5, 0x0BEB452A, 0x2FD87C39, 0x74B2E1FB, 0x222EFD24,
+  0xF357F60C, 0x440FCB1E, 0x8BBE030F, 0x6704DC29, 0x1144D12F, 0x948B1355,
+  0x6D8FD7E9, 0x1C11A014, 0xADD1592F, 0xFB3C712E, 0xFC77642F, 0xF9C4CE8C,
+  0x31312FB9, 0x08B0DD79, 0x318FA6E7, 0xC040D23D, 0xC0589AA7, 0x0CA5C075,
+  0xF874B172, 0x0CF914D5, 0x784D3280, 0x4E8CFEBC, 0xC569F575, 0xCDB2A091,
+  0x2CC016B4, 0x5C5F4421
+};
+
+static const uint64_t RANDOM_SEED = 0xA5A5A5A55A5A5A5AULL;
+
+const uint8_t BloomFilter::BIT_MASK[8] = {
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+};
+
+BloomFilter::BloomFilter
+  (size_t projectedElementCount, double falsePositiveProbability)
+{
+  initialize(projectedElementCount, falsePositiveProbability);
+}
+
+BloomFilter::BloomFilter
+  (size_t projectedElementCount, double falsePositiveProbability,
+   const Blob& bitTable)
+{
+  initialize(projectedElementCount, falsePositiveProbability);
+  if (bitTable.size() != bitTable_.size())
+    throw runtime_error("The received BloomFilter cannot be decoded");
+
+  bitTable_.assign(bitTable.buf(), bitTable.buf() + bitTable.size());
+}
+
+void
+BloomFilter::initialize
+  (size_t projectedElementCount, double falsePositiveProbability)
+{
+  projectedElementCount_ = projectedElementCount;
+  falsePositiveProbability_ = falsePositiveProbability;
+
+  // Find the number of hashes which needs the smallest table.
+  double minTableSize = numeric_limits<double>::infinity();
+  double minNHashes = 0;
+  for (double k = 1.0; k < 1000.0; k += 1.0) {
+    double tableSize = (-k * projectedElementCount) /
+      log(1.0 - pow(falsePositiveProbability, 1.0 / k));
+    if (tableSize < minTableSize) {
+      minTableSize = tableSize;
+      minNHashes = k;
+    }
+  }
+
+  size_t nHashes = (size_t)minNHashes;
+  if (nHashes < 1)
+    nHashes = 1;
+  // Round up to a whole number of bytes, with at least one byte.
+  tableSize_ = (size_t)(unsigned int)minTableSize;
+  if (tableSize_ % 8 != 0)
+    tableSize_ += 8 - (tableSize_ % 8);
+  if (tableSize_ < 8)
+    tableSize_ = 8;
+
+  generateUniqueSalts(nHashes);
+  bitTable_.assign(tableSize_ / 8, 0);
+}
+
+void
+BloomFilter::clear()
+{
+  bitTable_.assign(bitTable_.size(), 0);
+}
+
+void
+BloomFilter::insert(const string& key)
+{
+  for (size_t i = 0; i < salts_.size(); ++i) {
+    size_t bitIndex = getBitIndex
+      (CryptoLite::murmurHash3(salts_[i], key.data(), key.size()));
+    bitTable_[bitIndex / 8] |= BIT_MASK[bitIndex % 8];
+  }
+}
+
+bool
+BloomFilter::contains(const string& key) const
+{
+  for (size_t i = 0; i < salts_.size(); ++i) {
+    size_t bitIndex = getBitIndex
+      (CryptoLite::murmurHash3(salts_[i], key.data(), key.size()));
+    if ((bitTable_[bitIndex / 8] & BIT_MASK[bitIndex % 8]) == 0)
+      return false;
+  }
+
+  return true;
+}
+
+void
+BloomFilter::appendToName(Name& name) const
+{
+  name.appendNumber(projectedElementCount_);
+  name.appendNumber((int)(falsePositiveProbability_ * 1000));
+  name.append(bitTable_);
+}
+
+void
+BloomFilter::generateUniqueSalts(size_t nHashes)
+{
+  size_t nPredefinedSalts =
+    sizeof(PREDEFINED_SALTS) / sizeof(PREDEFINED_SALTS[0]);
+  uint32_t seed = (uint32_t)((RANDOM_SEED * 0xA5A5A5A5) + 1);
+
+  if (nHashes > nPredefinedSalts)
+    throw runtime_error
+      ("The BloomFilter false positive probability is too small");
+
+  salts_.assign(PREDEFINED_SALTS, PREDEFINED_SALTS + nHashes);
+  // Mix in place in the same order as PSync, so that later salts use the
+  // already mixed earlier ones.
+  for (size_t i = 0; i < salts_.size(); ++i)
+    salts_[i] = salts_[i] * salts_[(i + 3) % salts_.size()] + seed;
+}
+
+}
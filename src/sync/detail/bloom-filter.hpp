@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ * @author: From the PSync library https://github.com/named-data/PSync/blob/master/PSync/detail/bloom-filter.hpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ *
+ * This file incorporates work covered by the following copyright and
+ * permission notice:
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2000 Arash Partow
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NDN_BLOOM_FILTER_HPP
+#define NDN_BLOOM_FILTER_HPP
+
+#include <string>
+#include <vector>
+#include <ndn-cpp/name.hpp>
+
+namespace ndn {
+
+/**
+ * BloomFilter is a Bloom filter of strings, used by PartialPSync2017Consumer
+ * to tell the PartialPSync2017Producer which user prefixes it subscribes to.
+ * The parameters, hash salts and encoding are the same as the PSync library so
+ * that the encoded filter is interoperable.
+ */
+class BloomFilter {
+public:
+  /**
+   * Create an empty BloomFilter with the optimal number of hashes and table
+   * size for the parameters.
+   * @param projectedElementCount The expected number of elements.
+   * @param falsePositiveProbability The desired false positive probability,
+   * such as 0.001.
+   */
+  BloomFilter(size_t projectedElementCount, double falsePositiveProbability);
+
+  /**
+   * Create a BloomFilter with the parameters and set the bit table from the
+   * encoding.
+   * @param projectedElementCount The expected number of elements.
+   * @param falsePositiveProbability The desired false positive probability.
+   * @param bitTable The bit table from the last name component added by
+   * appendToName.
+   * @throws runtime_error if the size of bitTable is not the same as the
+   * table size for the parameters.
+   */
+  BloomFilter
+    (size_t projectedElementCount, double falsePositiveProbability,
+     const Blob& bitTable);
+
+  /**
+   * Clear all the bits in the table.
+   */
+  void
+  clear();
+
+  /**
+   * Insert the key into the bit table.
+   * @param key The key to insert, usually a Name URI.
+   */
+  void
+  insert(const std::string& key);
+
+  /**
+   * Check if the key may be in the bit table.
+   * @param key The key to check.
+   * @return False if the key is definitely not in the table, or true if it is
+   * in the table or is a false positive.
+   */
+  bool
+  contains(const std::string& key) const;
+
+  /**
+   * Append three components to the name: the projected element count as a
+   * number, the false positive probability times 1000 as a number, and the
+   * bit table. This is the encoding in the PSync sync Interest name.
+   * @param name The Name to append to.
+   */
+  void
+  appendToName(Name& name) const;
+
+  size_t
+  getProjectedElementCount() const { return projectedElementCount_; }
+
+  double
+  getFalsePositiveProbability() const { return falsePositiveProbability_; }
+
+private:
+  /**
+   * Set the parameters and compute the table size and salts. This is called by
+   * the constructors.
+   */
+  void
+  initialize(size_t projectedElementCount, double falsePositiveProbability);
+
+  /**
+   * Set salts_ to nHashes salts from the predefined list.
+   * @throws runtime_error if nHashes is more than the number of predefined
+   * salts.
+   */
+  void
+  generateUniqueSalts(size_t nHashes);
+
+  /**
+   * Get the bit index in the table for the hash of a key.
+   */
+  size_t
+  getBitIndex(uint32_t hash) const { return hash % tableSize_; }
+
+  static const uint8_t BIT_MASK[8];
+
+  size_t projectedElementCount_;
+  double falsePositiveProbability_;
+  size_t tableSize_;
+  std::vector<uint32_t> salts_;
+  std::vector<uint8_t> bitTable_;
+};
+
+}
+
+#endif
@@ -49,9 +49,9 @@
 #include <ndn-cpp/ndn-cpp-config.h>
 #if NDN_CPP_HAVE_LIBZ
 
+#include <algorithm>
 #include <stdexcept>
 #include <zlib.h>
-#include <ndn-cpp/lite/util/crypto-lite.hpp>
 #include "invertible-bloom-lookup-table.hpp"
 
 using namespace std;
@@ -68,7 +68,9 @@ InvertibleBloomLookupTable::InvertibleBloomLookupTable(size_t expectedNEntries)
   if (remainder != 0)
     nEntries += (N_HASH - remainder);
 
-  hashTable_.resize(nEntries);
+  counts_.resize(nEntries);
+  keySums_.resize(nEntries);
+  keyChecks_.resize(nEntries);
 }
 
 void
@@ -76,51 +78,170 @@ InvertibleBloomLookupTable::initialize(const Blob& encoding)
 {
   vector<uint32_t> values = decode(encoding);
 
-  if (3 * hashTable_.size() != values.size())
+  if (3 * counts_.size() != values.size())
     throw runtime_error("The received Invertible Bloom Filter cannot be decoded");
 
-  for (size_t i = 0; i < hashTable_.size(); i++) {
-    HashTableEntry& entry = hashTable_.at(i);
+  for (size_t i = 0; i < counts_.size(); i++) {
     if (values[i * 3] != 0) {
-      entry.count_ = values[i * 3];
-      entry.keySum_ = values[(i * 3) + 1];
-      entry.keyCheck_ = values[(i * 3) + 2];
+      counts_[i] = values[i * 3];
+      keySums_[i] = values[(i * 3) + 1];
+      keyChecks_[i] = values[(i * 3) + 2];
     }
   }
+  clearEncodings();
+}
+
+/**
+ * Append value to buffer as an unsigned LEB128 varint.
+ */
+static void
+writeVarint(vector<uint8_t>& buffer, uint32_t value)
+{
+  while (value >= 0x80) {
+    buffer.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back((uint8_t)value);
+}
+
+/**
+ * Append value to buffer as 4 little-endian bytes.
+ */
+static void
+writeUint32(vector<uint8_t>& buffer, uint32_t value)
+{
+  buffer.push_back(0xFF & value);
+  buffer.push_back(0xFF & (value >> 8));
+  buffer.push_back(0xFF & (value >> 16));
+  buffer.push_back(0xFF & (value >> 24));
+}
+
+/**
+ * Read an unsigned LEB128 varint from the encoding at offset.
+ * @param offset The offset in the encoding, which is advanced.
+ * @throws runtime_error if the varint goes past the end or is too long.
+ */
+static uint32_t
+readVarint(const Blob& encoding, size_t& offset)
+{
+  uint32_t value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (offset >= encoding.size())
+      throw runtime_error("The received sparse IBLT encoding is truncated");
+    uint8_t byte = encoding.buf()[offset++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      return value;
+  }
+
+  throw runtime_error("The received sparse IBLT encoding has a bad varint");
+}
+
+/**
+ * Read 4 little-endian bytes from the encoding at offset.
+ * @param offset The offset in the encoding, which is advanced.
+ * @throws runtime_error if this goes past the end.
+ */
+static uint32_t
+readUint32(const Blob& encoding, size_t& offset)
+{
+  if (offset + 4 > encoding.size())
+    throw runtime_error("The received sparse IBLT encoding is truncated");
+  const uint8_t* buf = encoding.buf() + offset;
+  offset += 4;
+  return ((uint32_t)buf[3] << 24) + ((uint32_t)buf[2] << 16) +
+    ((uint32_t)buf[1] << 8) + buf[0];
+}
+
+void
+InvertibleBloomLookupTable::initializeSparse(const Blob& encoding)
+{
+  size_t offset = 0;
+  if (readVarint(encoding, offset) != counts_.size())
+    throw runtime_error("The received Invertible Bloom Filter cannot be decoded");
+
+  size_t i = 0;
+  while (offset < encoding.size()) {
+    uint32_t gapAndFlag = readVarint(encoding, offset);
+    i += gapAndFlag >> 1;
+    if (i >= counts_.size())
+      throw runtime_error("The received sparse IBLT bucket index is out of range");
+
+    if (gapAndFlag & 1)
+      counts_[i] = 1;
+    else {
+      // Decode the zigzag count.
+      uint32_t zigzag = readVarint(encoding, offset);
+      counts_[i] = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+    }
+    keySums_[i] = readUint32(encoding, offset);
+    keyChecks_[i] = readUint32(encoding, offset);
+    ++i;
+  }
+  clearEncodings();
 }
 
 bool
 InvertibleBloomLookupTable::listEntries
-  (set<uint32_t>& positive, set<uint32_t>& negative) const
+  (vector<uint32_t>& positive, vector<uint32_t>& negative) const
 {
   positive.clear();
   negative.clear();
 
   // Make a deep copy.
   InvertibleBloomLookupTable peeled(*this);
+  size_t nBuckets = peeled.counts_.size();
+
+  // Start with all the pure buckets. After that, only a bucket changed by
+  // removing an entry can become pure.
+  vector<size_t> queue;
+  for (size_t i = 0; i < nBuckets; ++i) {
+    if (peeled.isPure(i))
+      queue.push_back(i);
+  }
 
-  size_t nErased = 0;
-  do {
-    nErased = 0;
-    for (vector<HashTableEntry>::const_iterator entry = peeled.hashTable_.begin();
-         entry != peeled.hashTable_.end(); ++entry) {
-      if (entry->isPure()) {
-        if (entry->count_ == 1)
-          positive.insert(entry->keySum_);
-        else
-          negative.insert(entry->keySum_);
-
-        peeled.update(-entry->count_, entry->keySum_);
-        ++nErased;
-      }
+  size_t buckets[N_HASH];
+  while (queue.size() > 0) {
+    size_t i = queue.back();
+    queue.pop_back();
+    // An earlier removal may have changed the bucket since it was queued.
+    if (!peeled.isPure(i))
+      continue;
+
+    int32_t count = peeled.counts_[i];
+    uint32_t key = peeled.keySums_[i];
+    // The bucket is pure, so this is the key check of the key.
+    uint32_t keyCheck = peeled.keyChecks_[i];
+    peeled.getBuckets(key, buckets);
+    // A received table can be malformed, so check that the key belongs in
+    // this bucket. Also, each peeled entry empties a bucket for good, so a
+    // table which can be peeled has no more entries than buckets.
+    if (find(buckets, buckets + N_HASH, i) == buckets + N_HASH ||
+        positive.size() + negative.size() >= nBuckets)
+      continue;
+
+    if (count == 1)
+      positive.push_back(key);
+    else
+      negative.push_back(key);
+
+    for (size_t j = 0; j < N_HASH; ++j) {
+      size_t bucket = buckets[j];
+      peeled.counts_[bucket] -= count;
+      peeled.keySums_[bucket] ^= key;
+      peeled.keyChecks_[bucket] ^= keyCheck;
+      if (peeled.isPure(bucket))
+        queue.push_back(bucket);
     }
-  } while (nErased > 0);
+  }
 
-  // If any buckets for one of the hash functions is not empty, then we didn't
-  // peel them all.
-  for (vector<HashTableEntry>::const_iterator entry = peeled.hashTable_.begin();
-       entry != peeled.hashTable_.end(); ++entry) {
-    if (!entry->isEmpty())
+  sort(positive.begin(), positive.end());
+  sort(negative.begin(), negative.end());
+
+  // If any bucket is not empty, then we didn't peel them all.
+  for (size_t i = 0; i < nBuckets; ++i) {
+    if (peeled.counts_[i] != 0 || peeled.keySums_[i] != 0 ||
+        peeled.keyChecks_[i] != 0)
       return false;
   }
 
@@ -131,18 +252,31 @@ ptr_lib::shared_ptr<InvertibleBloomLookupTable>
 InvertibleBloomLookupTable::difference
   (const InvertibleBloomLookupTable& other) const
 {
-  if (hashTable_.size() != other.hashTable_.size())
+  if (counts_.size() != other.counts_.size())
     throw runtime_error("IBLT difference: Both tables must be the same size");
 
   ptr_lib::shared_ptr<InvertibleBloomLookupTable> result =
     ptr_lib::make_shared<InvertibleBloomLookupTable>(*this);
-  for (size_t i = 0; i < hashTable_.size(); i++) {
-    HashTableEntry& e1 = result->hashTable_.at(i);
-    const HashTableEntry& e2 = other.hashTable_.at(i);
-    e1.count_ -= e2.count_;
-    e1.keySum_ ^= e2.keySum_;
-    e1.keyCheck_ ^= e2.keyCheck_;
-  }
+  result->clearEncodings();
+
+  // Use separate loops over plain arrays so that the compiler can vectorize.
+  size_t nBuckets = counts_.size();
+  if (nBuckets == 0)
+    return result;
+  int32_t* counts = &result->counts_[0];
+  const int32_t* otherCounts = &other.counts_[0];
+  for (size_t i = 0; i < nBuckets; ++i)
+    counts[i] -= otherCounts[i];
+
+  uint32_t* keySums = &result->keySums_[0];
+  const uint32_t* otherKeySums = &other.keySums_[0];
+  for (size_t i = 0; i < nBuckets; ++i)
+    keySums[i] ^= otherKeySums[i];
+
+  uint32_t* keyChecks = &result->keyChecks_[0];
+  const uint32_t* otherKeyChecks = &other.keyChecks_[0];
+  for (size_t i = 0; i < nBuckets; ++i)
+    keyChecks[i] ^= otherKeyChecks[i];
 
   return result;
 }
@@ -150,71 +284,117 @@ InvertibleBloomLookupTable::difference
 Blob
 InvertibleBloomLookupTable::encode() const
 {
-  size_t nEntries = hashTable_.size();
+  if (!encoding_.isNull())
+    return encoding_;
+
+  size_t nEntries = counts_.size();
   size_t unitSize = (32 * 3) / 8; // hard coding
   size_t tableSize = unitSize * nEntries;
 
   vector<uint8_t> table(tableSize);
 
   for (size_t i = 0; i < nEntries; i++) {
-    const HashTableEntry& entry = hashTable_[i];
+    uint32_t count = (uint32_t)counts_[i];
+    uint32_t keySum = keySums_[i];
+    uint32_t keyCheck = keyChecks_[i];
 
-    // table[i*12],   table[i*12+1], table[i*12+2], table[i*12+3] --> hashTable[i].count_
+    // table[i*12],   table[i*12+1], table[i*12+2], table[i*12+3] --> count
 
-    table[(i * unitSize)]   = 0xFF & entry.count_;
-    table[(i * unitSize) + 1] = 0xFF & (entry.count_ >> 8);
-    table[(i * unitSize) + 2] = 0xFF & (entry.count_ >> 16);
-    table[(i * unitSize) + 3] = 0xFF & (entry.count_ >> 24);
+    table[(i * unitSize)]   = 0xFF & count;
+    table[(i * unitSize) + 1] = 0xFF & (count >> 8);
+    table[(i * unitSize) + 2] = 0xFF & (count >> 16);
+    table[(i * unitSize) + 3] = 0xFF & (count >> 24);
 
-    // table[i*12+4], table[i*12+5], table[i*12+6], table[i*12+7] --> hashTable[i].keySum_
+    // table[i*12+4], table[i*12+5], table[i*12+6], table[i*12+7] --> keySum
 
-    table[(i * unitSize) + 4] = 0xFF & entry.keySum_;
-    table[(i * unitSize) + 5] = 0xFF & (entry.keySum_ >> 8);
-    table[(i * unitSize) + 6] = 0xFF & (entry.keySum_ >> 16);
-    table[(i * unitSize) + 7] = 0xFF & (entry.keySum_ >> 24);
+    table[(i * unitSize) + 4] = 0xFF & keySum;
+    table[(i * unitSize) + 5] = 0xFF & (keySum >> 8);
+    table[(i * unitSize) + 6] = 0xFF & (keySum >> 16);
+    table[(i * unitSize) + 7] = 0xFF & (keySum >> 24);
 
-    // table[i*12+8], table[i*12+9], table[i*12+10], table[i*12+11] --> hashTable[i].keyCheck_
+    // table[i*12+8], table[i*12+9], table[i*12+10], table[i*12+11] --> keyCheck
 
-    table[(i * unitSize) + 8] = 0xFF & entry.keyCheck_;
-    table[(i * unitSize) + 9] = 0xFF & (entry.keyCheck_ >> 8);
-    table[(i * unitSize) + 10] = 0xFF & (entry.keyCheck_ >> 16);
-    table[(i * unitSize) + 11] = 0xFF & (entry.keyCheck_ >> 24);
+    table[(i * unitSize) + 8] = 0xFF & keyCheck;
+    table[(i * unitSize) + 9] = 0xFF & (keyCheck >> 8);
+    table[(i * unitSize) + 10] = 0xFF & (keyCheck >> 16);
+    table[(i * unitSize) + 11] = 0xFF & (keyCheck >> 24);
   }
 
-  return zlibCompress(table.data(), table.size());
+  encoding_ = zlibCompress(table.data(), table.size());
+  return encoding_;
+}
+
+Blob
+InvertibleBloomLookupTable::encodeSparse() const
+{
+  if (!sparseEncoding_.isNull())
+    return sparseEncoding_;
+
+  ptr_lib::shared_ptr<vector<uint8_t> > buffer(new vector<uint8_t>());
+  writeVarint(*buffer, counts_.size());
+
+  size_t nextIndex = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    if (counts_[i] == 0 && keySums_[i] == 0 && keyChecks_[i] == 0)
+      continue;
+
+    // Most buckets have a count of 1, so put it in the low bit of the gap.
+    // Otherwise, follow with the zigzag encoded count so that a small negative
+    // value is short.
+    bool isCountOne = (counts_[i] == 1);
+    writeVarint
+      (*buffer, ((uint32_t)(i - nextIndex) << 1) | (isCountOne ? 1 : 0));
+    nextIndex = i + 1;
+    if (!isCountOne)
+      writeVarint
+        (*buffer, ((uint32_t)counts_[i] << 1) ^ (uint32_t)(counts_[i] >> 31));
+    writeUint32(*buffer, keySums_[i]);
+    writeUint32(*buffer, keyChecks_[i]);
+  }
+
+  sparseEncoding_ = Blob(buffer, false);
+  return sparseEncoding_;
 }
 
 bool
 InvertibleBloomLookupTable::equals(const InvertibleBloomLookupTable& other) const
 {
-  const vector<HashTableEntry>& iblt1HashTable = hashTable_;
-  const vector<HashTableEntry>& iblt2HashTable = other.hashTable_;
-  if (iblt1HashTable.size() != iblt2HashTable.size())
-    return false;
-
-  for (size_t i = 0; i < iblt1HashTable.size(); i++) {
-    if (iblt1HashTable[i].count_ != iblt2HashTable[i].count_ ||
-        iblt1HashTable[i].keySum_ != iblt2HashTable[i].keySum_ ||
-        iblt1HashTable[i].keyCheck_ != iblt2HashTable[i].keyCheck_)
-      return false;
-  }
+  return counts_ == other.counts_ && keySums_ == other.keySums_ &&
+    keyChecks_ == other.keyChecks_;
+}
 
-  return true;
+uint32_t
+InvertibleBloomLookupTable::hash() const
+{
+  return CryptoLite::murmurHash3
+    (N_HASHCHECK, (const uint8_t*)keySums_.data(),
+     keySums_.size() * sizeof(keySums_[0]));
+}
+
+void
+InvertibleBloomLookupTable::getBuckets(uint32_t key, size_t buckets[N_HASH]) const
+{
+  size_t bucketsPerHash = counts_.size() / N_HASH;
+
+  for (size_t i = 0; i < N_HASH; i++)
+    buckets[i] = i * bucketsPerHash +
+      (CryptoLite::murmurHash3(i, key) % bucketsPerHash);
 }
 
 void
 InvertibleBloomLookupTable::update(int plusOrMinus, uint32_t key)
 {
-  size_t bucketsPerHash = hashTable_.size() / N_HASH;
+  size_t buckets[N_HASH];
+  getBuckets(key, buckets);
+  uint32_t keyCheck = CryptoLite::murmurHash3(N_HASHCHECK, key);
 
   for (size_t i = 0; i < N_HASH; i++) {
-    size_t startEntry = i * bucketsPerHash;
-    uint32_t h = CryptoLite::murmurHash3(i, key);
-    HashTableEntry& entry = hashTable_.at(startEntry + (h % bucketsPerHash));
-    entry.count_ += plusOrMinus;
-    entry.keySum_ ^= key;
-    entry.keyCheck_ ^= CryptoLite::murmurHash3(N_HASHCHECK, key);
+    size_t bucket = buckets[i];
+    counts_[bucket] += plusOrMinus;
+    keySums_[bucket] ^= key;
+    keyChecks_[bucket] ^= keyCheck;
   }
+  clearEncodings();
 }
 
 vector<uint32_t>
@@ -316,17 +496,6 @@ InvertibleBloomLookupTable::zlibDecompress(const uint8_t* data, size_t dataLengt
   return Blob(result, false);
 }
 
-bool
-InvertibleBloomLookupTable::HashTableEntry::isPure() const
-{
-  if (count_ == 1 || count_ == -1) {
-    uint32_t check = CryptoLite::murmurHash3(N_HASHCHECK, keySum_);
-    return keyCheck_ == check;
-  }
-
-  return false;
-}
-
 }
 
 #endif // NDN_CPP_HAVE_LIBZ
@@ -52,14 +52,17 @@
 #include <ndn-cpp/ndn-cpp-config.h>
 #if NDN_CPP_HAVE_LIBZ
 
-#include <set>
+#include <vector>
 #include <ndn-cpp/util/blob.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
 
 namespace ndn {
 
 /**
  * InvertibleBloomLookupTable implements an Invertible Bloom Lookup Table (IBLT)
- * (Invertible Bloom Filter). This is used by FullPSync2017.
+ * (Invertible Bloom Filter). This is used by FullPSync2017. The hash table is
+ * stored as separate arrays of the counts, key sums and key checks so that
+ * difference and equals are simple loops over contiguous values.
  */
 class InvertibleBloomLookupTable {
 public:
@@ -71,13 +74,22 @@ public:
 
   /**
    * Populate the hash table using the encoded array representation of the IBLT.
-   * @param encoding The encoded representation of the IBLT.
+   * @param encoding The encoded representation of the IBLT from encode().
    * @throws runtime_error if the size of the decoded values is not compatible
    * with this IBLT.
    */
   void
   initialize(const Blob& encoding);
 
+  /**
+   * Populate the hash table using the sparse encoding of the IBLT.
+   * @param encoding The sparse encoding from encodeSparse().
+   * @throws runtime_error if the encoding is malformed or the number of buckets
+   * is not the same as this IBLT.
+   */
+  void
+  initializeSparse(const Blob& encoding);
+
   void
   insert(uint32_t key) { update(INSERT, key); }
 
@@ -89,12 +101,18 @@ public:
    * This is called on a difference of two IBLTs: ownIBLT - receivedIBLT.
    * Entries listed in positive are in ownIBLT but not in receivedIBLT.
    * Entries listed in negative are in receivedIBLT but not in ownIBLT.
-   * @param positive Add positive entries to this set. This first clears the set.
-   * @param negative Add negative entries to this set. This first clears the set.
-   * @return True if decoding is completed successfully.
+   * This peels pure buckets from a work queue, so that after the first pass
+   * it only revisits the buckets changed by removing an entry.
+   * @param positive Set this to the sorted positive entries. This first clears
+   * the vector.
+   * @param negative Set this to the sorted negative entries. This first clears
+   * the vector.
+   * @return True if decoding is completed successfully. If false, positive and
+   * negative have the entries which could be peeled.
    */
   bool
-  listEntries(std::set<uint32_t>& positive, std::set<uint32_t>& negative) const;
+  listEntries
+    (std::vector<uint32_t>& positive, std::vector<uint32_t>& negative) const;
 
   /**
    * Get a new IBLT which is the difference of the other IBLT from this IBLT.
@@ -109,12 +127,26 @@ public:
    * array to a uint8_t array. We create a uin8_t array 12 times the size of
    * the uint32_t array. We put the first count in the first 4 cells, keySum in
    * the next 4, and keyCheck in the next 4. We repeat for all the other cells
-   * of the hash table. Then we append this uint8_t array to the name.
+   * of the hash table. Then we zlib compress the array. The result is cached
+   * until the next insert or erase.
    * @return The encoded Blob.
    */
   Blob
   encode() const;
 
+  /**
+   * Encode this IBLT to a Blob with only the non-empty buckets, which is much
+   * faster than the zlib compression of encode() and no larger when most
+   * buckets are empty. The encoding is the number of buckets as a varint,
+   * then for each non-empty bucket a varint of the number of empty buckets
+   * before it shifted left by 1 with the low bit set if the count is 1, the
+   * count as a zigzag varint if it is not 1, and the 4-byte little-endian
+   * keySum and keyCheck. The result is cached until the next insert or erase.
+   * @return The encoded Blob.
+   */
+  Blob
+  encodeSparse() const;
+
   /**
    * Check if this IBLT has the same number of entries as the other IBLT and
    * that they are equal.
@@ -130,29 +162,41 @@ public:
   bool
   operator!= (const InvertibleBloomLookupTable &other) const { return !equals(other); }
 
+  /**
+   * Get a hash of the key sums, so that equal IBLTs have the same hash. This is
+   * used to find an equal IBLT without comparing every bucket.
+   * @return The hash.
+   */
+  uint32_t
+  hash() const;
+
   static const size_t N_HASH = 3;
   static const size_t N_HASHCHECK = 11;
 
 private:
-  class HashTableEntry
+  /**
+   * Check if the bucket has a count of 1 or -1 and a key check which is the
+   * hash of its key sum, so that it has exactly one entry.
+   * @param i The bucket index.
+   * @return True if the bucket is pure.
+   */
+  bool
+  isPure(size_t i) const
   {
-  public:
-    int32_t count_;
-    uint32_t keySum_;
-    uint32_t keyCheck_;
+    return (counts_[i] == 1 || counts_[i] == -1) &&
+      keyChecks_[i] == CryptoLite::murmurHash3(N_HASHCHECK, keySums_[i]);
+  }
 
-    bool
-    isPure() const;
-
-    bool
-    isEmpty() const
-    {
-      return count_ == 0 && keySum_ == 0 && keyCheck_ == 0;
-    }
-  };
+  /**
+   * Get the index of the bucket for each hash function.
+   * @param key The key.
+   * @param buckets Set buckets[i] to the bucket index for hash function i.
+   */
+  void
+  getBuckets(uint32_t key, size_t buckets[N_HASH]) const;
 
   /**
-   * Update the entries in hashTable_.
+   * Update the buckets for the key.
    * @param plusOrMinus The amount to update the count.
    * @param key The key for computing the entry.
    */
@@ -168,13 +212,27 @@ private:
   static std::vector<uint32_t>
   decode(const Blob& encoding);
 
+  /**
+   * Clear the cached encodings after the hash table changes.
+   */
+  void
+  clearEncodings()
+  {
+    encoding_ = Blob();
+    sparseEncoding_ = Blob();
+  }
+
   static Blob
   zlibCompress(const uint8_t* data, size_t dataLength);
 
   static Blob
   zlibDecompress(const uint8_t* data, size_t dataLength);
 
-  std::vector<HashTableEntry> hashTable_;
+  std::vector<int32_t> counts_;
+  std::vector<uint32_t> keySums_;
+  std::vector<uint32_t> keyChecks_;
+  mutable Blob encoding_;
+  mutable Blob sparseEncoding_;
 
   static const int INSERT = 1;
   static const int ERASE = -1;
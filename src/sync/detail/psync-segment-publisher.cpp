@@ -28,41 +28,29 @@ namespace ndn {
 
 void
 PSyncSegmentPublisher::publish
-  (const Name& interestName, const Name& dataName, Blob content,
-   Milliseconds freshnessPeriod, const SigningInfo& signingInfo)
+  (const Name& interestName, const Name& dataName,
+   const vector<Blob>& segments, Milliseconds freshnessPeriod,
+   const SigningInfo& signingInfo)
 {
   uint64_t interestSegment = 0;
   if (interestName[-1].isSegment())
     interestSegment = interestName[-1].toSegment();
 
-  const uint8_t* rawBuffer = content.buf();
-  const uint8_t* segmentBegin = rawBuffer;
-  const uint8_t* end = rawBuffer + content.size();
-
-  size_t maxPacketSize = MAX_NDN_PACKET_SIZE / 2;
-
-  uint64_t totalSegments = content.size() / maxPacketSize;
-  Name::Component finalBlockId = Name::Component::fromSegment(totalSegments);
+  Name::Component finalBlockId =
+    Name::Component::fromSegment(segments.size() - 1);
 
   Name segmentPrefix(dataName);
   segmentPrefix.appendVersion((uint64_t)ndn_getNowMilliseconds());
 
-  uint64_t segmentNo = 0;
-  do {
-    const uint8_t* segmentEnd = segmentBegin + maxPacketSize;
-    if (segmentEnd > end)
-      segmentEnd = end;
-
+  for (uint64_t segmentNo = 0; segmentNo < segments.size(); ++segmentNo) {
     Name segmentName(segmentPrefix);
     segmentName.appendSegment(segmentNo);
 
     ptr_lib::shared_ptr<Data> data = ptr_lib::make_shared<Data>(segmentName);
-    data->setContent(Blob(segmentBegin, segmentEnd - segmentBegin));
+    data->setContent(segments[segmentNo]);
     data->getMetaInfo().setFreshnessPeriod(freshnessPeriod);
     data->getMetaInfo().setFinalBlockId(finalBlockId);
 
-    segmentBegin = segmentEnd;
-
     keyChain_.sign(*data, signingInfo);
 
     // Only send the segment to the Face if it has a pending interest.
@@ -70,17 +58,29 @@ PSyncSegmentPublisher::publish
     if (interestSegment == segmentNo)
       face_.putData(*data);
 
-#if 0 // Until InMemoryStorageFifo implements an eviction policy, use InMemoryStorageRetaining.
-    storage_.insert(*data, freshnessPeriod);
-#else
     storage_.insert(*data);
-#endif
 
     face_.callLater
       (freshnessPeriod,
-       bind(&InMemoryStorageRetaining::remove, &storage_, segmentName));
+       bind(&InMemoryStorageFifo::remove, &storage_, segmentName));
+  }
+}
 
-    ++segmentNo;
+void
+PSyncSegmentPublisher::splitContent
+  (const Blob& content, vector<Blob>& segments)
+{
+  const uint8_t* segmentBegin = content.buf();
+  const uint8_t* end = segmentBegin + content.size();
+  size_t maxSegmentSize = getMaxSegmentSize();
+
+  do {
+    const uint8_t* segmentEnd = segmentBegin + maxSegmentSize;
+    if (segmentEnd > end)
+      segmentEnd = end;
+
+    segments.push_back(Blob(segmentBegin, segmentEnd - segmentBegin));
+    segmentBegin = segmentEnd;
   } while (segmentBegin < end);
 }
 
@@ -25,7 +25,7 @@
 
 #include <ndn-cpp/face.hpp>
 #include <ndn-cpp/security/key-chain.hpp>
-#include <ndn-cpp/in-memory-storage/in-memory-storage-retaining.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-fifo.hpp>
 
 namespace ndn {
 
@@ -45,10 +45,7 @@ public:
   PSyncSegmentPublisher
     (Face& face, KeyChain& keyChain, 
      size_t inMemoryStorageLimit = MAX_SEGMENTS_STORED)
-  : face_(face), keyChain_(keyChain)
-#if 0 // Until InMemoryStorageFifo implements an eviction policy, use InMemoryStorageRetaining.
-    , storage_(inMemoryStorageLimit)
-#endif
+  : face_(face), keyChain_(keyChain), storage_(inMemoryStorageLimit)
   {
   }
 
@@ -65,7 +62,46 @@ public:
   void
   publish
     (const Name& interestName, const Name& dataName, Blob content,
-     Milliseconds freshnessPeriod, const SigningInfo& signingInfo = SigningInfo());
+     Milliseconds freshnessPeriod, const SigningInfo& signingInfo = SigningInfo())
+  {
+    std::vector<Blob> segments;
+    splitContent(content, segments);
+    publish(interestName, dataName, segments, freshnessPeriod, signingInfo);
+  }
+
+  /**
+   * Put all the segments in the memory store, where the content of each
+   * segment is already made, for example by PSyncState::wireEncodeDelta.
+   * @param interestName If the Interest name ends in a segment, immediately
+   * send the Data packet for the segment to the Face.
+   * @param dataName The Data name, which has components after the Interest name.
+   * @param segments The content of each segment, which should not be empty.
+   * Each should be no larger than getMaxSegmentSize().
+   * @param freshnessPeriod The freshness period of the segments, in milliseconds.
+   * @param signingInfo (optional) The SigningInfo for signing segment Data
+   * packets. If omitted, use the default SigningInfo().
+   */
+  void
+  publish
+    (const Name& interestName, const Name& dataName,
+     const std::vector<Blob>& segments, Milliseconds freshnessPeriod,
+     const SigningInfo& signingInfo = SigningInfo());
+
+  /**
+   * Split the content into segments of getMaxSegmentSize().
+   * @param content The content to split.
+   * @param segments Append the segments to this list. If the content is empty,
+   * this appends one empty segment.
+   */
+  static void
+  splitContent(const Blob& content, std::vector<Blob>& segments);
+
+  /**
+   * Get the maximum size of the content of a segment.
+   * @return The maximum size.
+   */
+  static size_t
+  getMaxSegmentSize() { return MAX_NDN_PACKET_SIZE / 2; }
 
   /**
    * Try to reply to the Interest name from the memory store.
@@ -82,11 +118,7 @@ public:
 private:
   Face& face_;
   KeyChain& keyChain_;
-#if 0 // Until InMemoryStorageFifo implements an eviction policy, use InMemoryStorageRetaining.
   InMemoryStorageFifo storage_;
-#else
-  InMemoryStorageRetaining storage_;
-#endif
 };
 
 }
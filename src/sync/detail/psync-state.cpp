@@ -21,6 +21,7 @@
  */
 
 #include <sstream>
+#include <algorithm>
 #include "../../encoding/tlv-encoder.hpp"
 #include "../../encoding/tlv-decoder.hpp"
 #include "../../c/encoding/tlv/tlv-name.h"
@@ -63,11 +64,122 @@ PSyncState::encodeContent(const void *context, TlvEncoder &encoder)
   }
 }
 
+/**
+ * Get the TLV type code of the name component, the same as
+ * ndn_encodeTlvNameComponent.
+ */
+static unsigned int
+getComponentTypeCode(const Name::Component& component)
+{
+  if (component.getType() == ndn_NameComponentType_OTHER_CODE)
+    return (unsigned int)component.getOtherTypeCode();
+  else
+    // The enum values are the same as the TLV type codes.
+    return (unsigned int)component.getType();
+}
+
+static size_t
+getComponentTlvSize(const Name::Component& component)
+{
+  size_t valueLength = component.getValue().size();
+  return ndn_TlvEncoder_sizeOfVarNumber(getComponentTypeCode(component)) +
+    ndn_TlvEncoder_sizeOfVarNumber(valueLength) + valueLength;
+}
+
+static size_t
+getTlvSize(unsigned int type, size_t valueLength)
+{
+  return ndn_TlvEncoder_sizeOfVarNumber(type) +
+    ndn_TlvEncoder_sizeOfVarNumber(valueLength) + valueLength;
+}
+
+static bool
+nameLessThan(const Name* name1, const Name* name2)
+{
+  return *name1 < *name2;
+}
+
+void
+PSyncState::wireEncodeDelta(size_t maxBlockSize, vector<Blob>& blocks) const
+{
+  if (content_.size() == 0) {
+    TlvEncoder encoder(2);
+    encoder.writeTypeAndLength(Tlv_PSyncDeltaContent, 0);
+    blocks.push_back(encoder.finish());
+    return;
+  }
+
+  // Sort pointers so that we don't copy the Names.
+  vector<const Name*> names;
+  names.reserve(content_.size());
+  for (size_t i = 0; i < content_.size(); ++i)
+    names.push_back(&content_[i]);
+  sort(names.begin(), names.end(), nameLessThan);
+
+  // For each Name in the block, the number of shared components and the
+  // length of the Name TLV value for the remaining components.
+  vector<pair<size_t, size_t> > entries;
+  size_t blockBegin = 0;
+  while (blockBegin < names.size()) {
+    // Add Names until the block would be too large.
+    entries.clear();
+    size_t valueLength = 0;
+    size_t i = blockBegin;
+    for (; i < names.size(); ++i) {
+      const Name& name = *names[i];
+      size_t nShared = 0;
+      if (i > blockBegin) {
+        // Start each block with a full Name so that it decodes by itself.
+        const Name& previous = *names[i - 1];
+        while (nShared < name.size() && nShared < previous.size() &&
+               name.get(nShared).equals(previous.get(nShared)))
+          ++nShared;
+      }
+
+      size_t suffixLength = 0;
+      for (size_t j = nShared; j < name.size(); ++j)
+        suffixLength += getComponentTlvSize(name.get(j));
+
+      size_t newValueLength = valueLength +
+        getTlvSize(Tlv_PSyncSharedComponents,
+                   ndn_TlvEncoder_sizeOfNonNegativeInteger(nShared)) +
+        getTlvSize(ndn_Tlv_Name, suffixLength);
+      if (i > blockBegin &&
+          getTlvSize(Tlv_PSyncDeltaContent, newValueLength) > maxBlockSize)
+        break;
+
+      entries.push_back(make_pair(nShared, suffixLength));
+      valueLength = newValueLength;
+    }
+
+    TlvEncoder encoder(getTlvSize(Tlv_PSyncDeltaContent, valueLength));
+    encoder.writeTypeAndLength(Tlv_PSyncDeltaContent, valueLength);
+    for (size_t j = 0; j < entries.size(); ++j) {
+      const Name& name = *names[blockBegin + j];
+      size_t nShared = entries[j].first;
+
+      encoder.writeNonNegativeIntegerTlv(Tlv_PSyncSharedComponents, nShared);
+      encoder.writeTypeAndLength(ndn_Tlv_Name, entries[j].second);
+      for (size_t k = nShared; k < name.size(); ++k)
+        encoder.writeBlobTlv
+          (getComponentTypeCode(name.get(k)), name.get(k).getValue());
+    }
+
+    blocks.push_back(encoder.finish());
+    blockBegin = i;
+  }
+}
+
 void
 PSyncState::wireDecode(const uint8_t *input, size_t inputLength)
 {
   clear();
 
+  if (inputLength > 0 && input[0] == Tlv_PSyncDeltaContent) {
+    wireDecodeDelta(input, inputLength);
+    return;
+  }
+
   // Decode directly as TLV. We don't support the WireFormat abstraction
   // because this isn't meant to go directly on the wire.
   TlvDecoder decoder(input, inputLength);
@@ -93,6 +205,44 @@ PSyncState::wireDecode(const uint8_t *input, size_t inputLength)
   decoder.finishNestedTlvs(endOffset);
 }
 
+void
+PSyncState::wireDecodeDelta(const uint8_t *input, size_t inputLength)
+{
+  TlvDecoder decoder(input, inputLength);
+
+  while (decoder.offset < inputLength) {
+    size_t endOffset = decoder.readNestedTlvsStart(Tlv_PSyncDeltaContent);
+
+    // The first Name in each block has no shared components.
+    const Name* previous = 0;
+    while (decoder.offset < endOffset) {
+      uint64_t nShared = decoder.readNonNegativeIntegerTlv
+        (Tlv_PSyncSharedComponents);
+      if (nShared > (previous ? previous->size() : 0))
+        throw runtime_error
+          ("PSyncState: The shared components exceed the previous Name");
+
+      struct ndn_NameComponent nameComponents[100];
+      NameLite nameLite
+        (nameComponents, sizeof(nameComponents) / sizeof(nameComponents[0]));
+
+      ndn_Error error;
+      size_t dummyBeginOffset, dummyEndOffset;
+      if ((error = ndn_decodeTlvName
+           (&nameLite, &dummyBeginOffset, &dummyEndOffset, &decoder)))
+        throw runtime_error(ndn_getErrorString(error));
+
+      Name suffix;
+      suffix.set(nameLite);
+      content_.push_back
+        (nShared > 0 ? previous->getPrefix(nShared).append(suffix) : suffix);
+      previous = &content_.back();
+    }
+
+    decoder.finishNestedTlvs(endOffset);
+  }
+}
+
 string
 PSyncState::toString() const
 {
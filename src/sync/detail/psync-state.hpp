@@ -41,7 +41,8 @@ public:
   PSyncState() {}
 
   /**
-   * Create a PSyncState by decoding the input as an NDN-TLV PSyncContent.
+   * Create a PSyncState by decoding the input as an NDN-TLV PSyncContent or a
+   * sequence of PSyncDeltaContent. See wireDecode.
    * @param input A pointer to the input buffer to decode.
    * @param inputLength The number of bytes in input.
    */
@@ -51,7 +52,8 @@ public:
   }
 
   /**
-   * Create a PSyncState by decoding the input as an NDN-TLV PSyncContent.
+   * Create a PSyncState by decoding the input as an NDN-TLV PSyncContent or a
+   * sequence of PSyncDeltaContent. See wireDecode.
    * @param input The input buffer to decode.
    */
   PSyncState(const Blob& input)
@@ -87,7 +89,25 @@ public:
   wireEncode() const;
 
   /**
-   * Decode the input as an NDN-TLV PSyncContent and update this object.
+   * Encode the Names in canonical order as a sequence of NDN-TLV
+   * PSyncDeltaContent blocks. In each block, a Name is encoded as the number
+   * of leading components which it shares with the previous Name, followed by
+   * a Name with the remaining components. Each block is encoded separately,
+   * so that a block can be the content of a segment without first making
+   * the entire encoding.
+   * @param maxBlockSize The maximum encoding size of a block. (A block with a
+   * single Name may be larger.)
+   * @param blocks Append the encoded blocks to this list. If the content is
+   * empty, this appends one empty PSyncDeltaContent.
+   */
+  void
+  wireEncodeDelta(size_t maxBlockSize, std::vector<Blob>& blocks) const;
+
+  /**
+   * Decode the input and update this object. If the input begins with
+   * PSyncDeltaContent, then decode a sequence of PSyncDeltaContent blocks from
+   * wireEncodeDelta (which may be the concatenated contents of segments).
+   * Otherwise, decode an NDN-TLV PSyncContent.
    * @param input A pointer to the input buffer to decode.
    * @param inputLength The number of bytes in input.
    */
@@ -95,7 +115,8 @@ public:
   wireDecode(const uint8_t *input, size_t inputLength);
 
   /**
-   * Decode the input as an NDN-TLV PSyncContent and update this object.
+   * Decode the input and update this object. See wireDecode(const uint8_t*,
+   * size_t).
    * @param input The input buffer to decode.
    */
   void
@@ -112,7 +133,9 @@ public:
   toString() const;
 
   enum {
-    Tlv_PSyncContent = 128
+    Tlv_PSyncContent = 128,
+    Tlv_PSyncDeltaContent = 129,
+    Tlv_PSyncSharedComponents = 130
   };
 
 private:
@@ -125,6 +148,13 @@ private:
   static void
   encodeContent(const void *context, TlvEncoder &encoder);
 
+  /**
+   * Decode the sequence of PSyncDeltaContent blocks and append the Names to
+   * content_.
+   */
+  void
+  wireDecodeDelta(const uint8_t *input, size_t inputLength);
+
   std::vector<Name> content_;
 };
 
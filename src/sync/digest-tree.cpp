@@ -21,12 +21,9 @@
  */
 
 #include <algorithm>
+#include <string.h>
 #include <ndn-cpp/util/logging.hpp>
-#if NDN_CPP_HAVE_LIBCRYPTO
-#include <openssl/ssl.h>
-#else
-#include "../../contrib/openssl/sha.h"
-#endif
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
 #include "digest-tree.hpp"
 
 INIT_LOGGER("ndn.DigestTree");
@@ -36,60 +33,53 @@ using namespace std;
 namespace ndn {
 
 /**
- * Convert the hex character to an integer from 0 to 15, or -1 if not a hex character.
- * @param c
- * @return
+ * Compare the Node in the sorted digestNode_ with the data prefix and session
+ * number of the key Node, in the same order as Node::Compare.
  */
-static int
-fromHexChar(uint8_t c)
+static bool
+lessThanKey
+  (const ptr_lib::shared_ptr<DigestTree::Node>& node,
+   const pair<const string*, int>& key)
 {
-  if (c >= '0' && c <= '9')
-    return (int)c - (int)'0';
-  else if (c >= 'A' && c <= 'F')
-    return (int)c - (int)'A' + 10;
-  else if (c >= 'a' && c <= 'f')
-    return (int)c - (int)'a' + 10;
-  else
-    return -1;
-}
-
-/**
- * Convert the hex string to bytes and call SHA256_Update.
- * @param context The SHA256_CTX to update.
- * @param hex The hex string.
- * @return The result from SHA256_Update.
- */
-static int
-SHA256_UpdateHex(SHA256_CTX *context, const string& hex)
-{
-  vector<uint8_t> data(hex.size() / 2);
-  for (size_t i = 0; i < data.size(); ++i)
-    data[i] = (uint8_t)(16 * fromHexChar(hex[2 * i]) + fromHexChar(hex[2 * i + 1]));
+  int nameComparison = node->getDataPrefix().compare(*key.first);
+  if (nameComparison != 0)
+    return nameComparison < 0;
 
-  return SHA256_Update(context, &data[0], data.size());
+  return node->getSessionNo() < key.second;
 }
 
 bool
 DigestTree::update(const std::string& dataPrefix, int sessionNo, int sequenceNo)
 {
-  int index = find(dataPrefix, sessionNo);
+  vector<ptr_lib::shared_ptr<Node> >::const_iterator position =
+    lowerBound(dataPrefix, sessionNo);
+  size_t index = position - digestNode_.begin();
+  bool isFound =
+    (position != digestNode_.end() &&
+     (*position)->getDataPrefix() == dataPrefix &&
+     (*position)->getSessionNo() == sessionNo);
   _LOG_DEBUG(dataPrefix << ", " << sessionNo);
-  _LOG_DEBUG("DigestTree::update session " << sessionNo << ", index " << index);
-  if (index >= 0) {
+  _LOG_DEBUG("DigestTree::update session " << sessionNo << ", index " <<
+             (isFound ? (int)index : -1));
+  if (isFound) {
     // only update the newer status
     if (digestNode_[index]->getSequenceNo() < sequenceNo)
       digestNode_[index]->setSequenceNo(sequenceNo);
     else
       return false;
+
+    if (rootDigestMode_ == ROOT_DIGEST_MERKLE) {
+      // Only the path from this node to the root changes.
+      updateMerklePath(index);
+      return true;
+    }
   }
   else {
     _LOG_DEBUG("new comer " << dataPrefix << ", session " << sessionNo <<
                ", sequence " << sequenceNo);
     // Insert into digestnode_ sorted.
     ptr_lib::shared_ptr<Node> temp(new Node(dataPrefix, sessionNo, sequenceNo));
-    digestNode_.insert
-      (std::lower_bound(digestNode_.begin(), digestNode_.end(), temp, nodeCompare_),
-       temp);
+    digestNode_.insert(digestNode_.begin() + index, temp);
   }
 
   recomputeRoot();
@@ -97,56 +87,145 @@ DigestTree::update(const std::string& dataPrefix, int sessionNo, int sequenceNo)
 }
 
 void
-DigestTree::recomputeRoot()
+DigestTree::setRootDigestMode(RootDigestMode rootDigestMode)
 {
-  SHA256_CTX sha256;
+  rootDigestMode_ = rootDigestMode;
+  if (rootDigestMode_ != ROOT_DIGEST_MERKLE) {
+    merkleTree_.clear();
+    merkleCapacity_ = 0;
+  }
+
+  if (digestNode_.size() > 0)
+    recomputeRoot();
+}
 
-  SHA256_Init(&sha256);
-  for (size_t i = 0; i < digestNode_.size(); ++i)
-    SHA256_UpdateHex(&sha256, digestNode_[i]->getDigest());
+void
+DigestTree::recomputeRoot()
+{
   uint8_t digestRoot[ndn_SHA256_DIGEST_SIZE];
-  SHA256_Final(&digestRoot[0], &sha256);
+
+  if (rootDigestMode_ == ROOT_DIGEST_MERKLE) {
+    // Rebuild the Merkle tree since the positions of the nodes changed.
+    merkleCapacity_ = 1;
+    while (merkleCapacity_ < digestNode_.size())
+      merkleCapacity_ *= 2;
+    merkleTree_.resize(2 * merkleCapacity_ * ndn_SHA256_DIGEST_SIZE);
+
+    for (size_t i = 0; i < digestNode_.size(); ++i)
+      memcpy(getMerkleDigest(merkleCapacity_ + i), digestNode_[i]->getDigest(),
+             ndn_SHA256_DIGEST_SIZE);
+
+    size_t height = 0;
+    for (size_t levelStart = merkleCapacity_ / 2; levelStart >= 1;
+         levelStart /= 2) {
+      ++height;
+      for (size_t position = levelStart; position < 2 * levelStart; ++position) {
+        if ((position << height) - merkleCapacity_ >= digestNode_.size())
+          // This and the rest of the level have no nodes.
+          break;
+        combineMerkleChildren(position, height);
+      }
+    }
+
+    memcpy(digestRoot, getMerkleDigest(1), sizeof(digestRoot));
+  }
+  else {
+    // The root is the digest of the concatenated node digests.
+    vector<uint8_t> nodeDigests(digestNode_.size() * ndn_SHA256_DIGEST_SIZE);
+    for (size_t i = 0; i < digestNode_.size(); ++i)
+      memcpy(&nodeDigests[i * ndn_SHA256_DIGEST_SIZE],
+             digestNode_[i]->getDigest(), ndn_SHA256_DIGEST_SIZE);
+    CryptoLite::digestSha256
+      (nodeDigests.size() > 0 ? &nodeDigests[0] : 0, nodeDigests.size(),
+       digestRoot);
+  }
+
   root_ = toHex(digestRoot, sizeof(digestRoot));
   _LOG_DEBUG("update root to: " + root_);
 }
 
+void
+DigestTree::updateMerklePath(size_t index)
+{
+  size_t position = merkleCapacity_ + index;
+  memcpy(getMerkleDigest(position), digestNode_[index]->getDigest(),
+         ndn_SHA256_DIGEST_SIZE);
+
+  size_t height = 0;
+  while (position > 1) {
+    position /= 2;
+    ++height;
+    combineMerkleChildren(position, height);
+  }
+
+  root_ = toHex(getMerkleDigest(1), ndn_SHA256_DIGEST_SIZE);
+  _LOG_DEBUG("update root to: " + root_);
+}
+
+void
+DigestTree::combineMerkleChildren(size_t position, size_t height)
+{
+  size_t left = 2 * position;
+  size_t right = left + 1;
+  // The index of the first node under the right child.
+  size_t rightFirstIndex = (right << (height - 1)) - merkleCapacity_;
+
+  if (rightFirstIndex >= digestNode_.size())
+    memcpy(getMerkleDigest(position), getMerkleDigest(left),
+           ndn_SHA256_DIGEST_SIZE);
+  else
+    // The left and right digests are adjacent.
+    CryptoLite::digestSha256
+      (getMerkleDigest(left), 2 * ndn_SHA256_DIGEST_SIZE,
+       getMerkleDigest(position));
+}
+
 int
 DigestTree::find(const string& dataPrefix, int sessionNo) const
 {
-  for (size_t i = 0; i < digestNode_.size(); ++i) {
-    if (digestNode_[i]->getDataPrefix() == dataPrefix &&
-        digestNode_[i]->getSessionNo() == sessionNo)
-      return i;
-  }
+  vector<ptr_lib::shared_ptr<Node> >::const_iterator position =
+    lowerBound(dataPrefix, sessionNo);
+  if (position != digestNode_.end() &&
+      (*position)->getDataPrefix() == dataPrefix &&
+      (*position)->getSessionNo() == sessionNo)
+    return position - digestNode_.begin();
 
   return -1;
 }
 
+vector<ptr_lib::shared_ptr<DigestTree::Node> >::const_iterator
+DigestTree::lowerBound(const string& dataPrefix, int sessionNo) const
+{
+  return std::lower_bound
+    (digestNode_.begin(), digestNode_.end(),
+     pair<const string*, int>(&dataPrefix, sessionNo), lessThanKey);
+}
+
+DigestTree::Node::Node(const std::string& dataPrefix, int sessionNo, int sequenceNo)
+: dataPrefix_(dataPrefix),
+  sessionNo_(sessionNo),
+  sequenceNo_(sequenceNo)
+{
+  CryptoLite::digestSha256
+    ((const uint8_t*)dataPrefix_.data(), dataPrefix_.size(), nameDigest_);
+
+  recomputeDigest();
+}
+
 void
 DigestTree::Node::recomputeDigest()
 {
-  SHA256_CTX sha256;
-
-  SHA256_Init(&sha256);
-  uint8_t number[4];
-  int32ToLittleEndian(sessionNo_, number);
-  SHA256_Update(&sha256, number, sizeof(number));
-  int32ToLittleEndian(sequenceNo_, number);
-  SHA256_Update(&sha256, number, sizeof(number));
-  uint8_t sequenceDigest[ndn_SHA256_DIGEST_SIZE];
-  SHA256_Final(sequenceDigest, &sha256);
-
-  SHA256_Init(&sha256);
-  SHA256_Update(&sha256, &dataPrefix_[0], dataPrefix_.size());
-  uint8_t nameDigest[ndn_SHA256_DIGEST_SIZE];
-  SHA256_Final(nameDigest, &sha256);
-
-  SHA256_Init(&sha256);
-  SHA256_Update(&sha256, nameDigest, sizeof(nameDigest));
-  SHA256_Update(&sha256, sequenceDigest, sizeof(sequenceDigest));
-  uint8_t nodeDigest[ndn_SHA256_DIGEST_SIZE];
-  SHA256_Final(nodeDigest, &sha256);
-  digest_ = toHex(nodeDigest, sizeof(nodeDigest));
+  uint8_t numbers[8];
+  int32ToLittleEndian(sessionNo_, numbers);
+  int32ToLittleEndian(sequenceNo_, numbers + 4);
+  // nameAndSequenceDigest is the name digest followed by the sequence digest.
+  uint8_t nameAndSequenceDigest[2 * ndn_SHA256_DIGEST_SIZE];
+  memcpy(nameAndSequenceDigest, nameDigest_, sizeof(nameDigest_));
+  CryptoLite::digestSha256
+    (numbers, sizeof(numbers), nameAndSequenceDigest + ndn_SHA256_DIGEST_SIZE);
+
+  CryptoLite::digestSha256
+    (nameAndSequenceDigest, sizeof(nameAndSequenceDigest), digest_);
 }
 
 void
@@ -30,8 +30,23 @@ namespace ndn {
 
 class DigestTree {
 public:
+  /**
+   * A RootDigestMode specifies how the root digest is computed from the node
+   * digests, which are sorted by data prefix and session number.
+   * ROOT_DIGEST_CHRONOSYNC is the SHA-256 of the concatenated node digests,
+   * which is the original ChronoSync method. Changing one node needs a new
+   * SHA-256 over all the nodes. ROOT_DIGEST_MERKLE is the root of a binary
+   * Merkle tree over the node digests, so that changing the sequence number of
+   * one node only re-hashes the path to the root. All members of a sync group
+   * must use the same RootDigestMode.
+   */
+  enum RootDigestMode {
+    ROOT_DIGEST_CHRONOSYNC = 0,
+    ROOT_DIGEST_MERKLE = 1
+  };
+
   DigestTree()
-  : root_("00")
+  : root_("00"), rootDigestMode_(ROOT_DIGEST_CHRONOSYNC), merkleCapacity_(0)
   {}
 
   class Node {
@@ -42,13 +57,7 @@ public:
      * @param sessionNo The sequence number.
      * @param sequenceNo The session number.
      */
-    Node(const std::string& dataPrefix, int sessionNo, int sequenceNo)
-    : dataPrefix_(dataPrefix),
-      sessionNo_(sessionNo),
-      sequenceNo_(sequenceNo)
-    {
-      recomputeDigest();
-    }
+    Node(const std::string& dataPrefix, int sessionNo, int sequenceNo);
 
     const std::string&
     getDataPrefix() const { return dataPrefix_; }
@@ -61,9 +70,9 @@ public:
 
     /**
      * Get the digest.
-     * @return The digest as a hex string.
+     * @return A pointer to the ndn_SHA256_DIGEST_SIZE bytes of the digest.
      */
-    const std::string&
+    const uint8_t*
     getDigest() const { return digest_; }
 
     /**
@@ -96,8 +105,11 @@ public:
     };
 
   private:
+    friend class DigestTree;
+
     /**
-     * Digest the fields and set digest_ to the hex digest.
+     * Digest the sequence and session numbers with nameDigest_ and set
+     * digest_.
      */
     void
     recomputeDigest();
@@ -108,7 +120,9 @@ public:
     std::string dataPrefix_;
     int sessionNo_;
     int sequenceNo_;
-    std::string digest_;
+    // The name digest doesn't change, so it is computed once.
+    uint8_t nameDigest_[ndn_SHA256_DIGEST_SIZE];
+    uint8_t digest_[ndn_SHA256_DIGEST_SIZE];
   };
 
   /**
@@ -124,6 +138,13 @@ public:
   bool
   update(const std::string& dataPrefix, int sessionNo, int sequenceNo);
 
+  /**
+   * Find the node with the dataPrefix and sessionNo. The nodes are sorted, so
+   * this is a binary search.
+   * @param dataPrefix The name prefix.
+   * @param sessionNo The session number.
+   * @return The index of the node for get(), or -1 if not found.
+   */
   int
   find(const std::string& dataPrefix, int sessionNo) const;
 
@@ -140,20 +161,73 @@ public:
   const std::string&
   getRoot() const { return root_; }
 
+  /**
+   * Set the RootDigestMode and recompute the root digest.
+   * @param rootDigestMode The RootDigestMode. The default is
+   * ROOT_DIGEST_CHRONOSYNC.
+   */
+  void
+  setRootDigestMode(RootDigestMode rootDigestMode);
+
+  /**
+   * Get the RootDigestMode.
+   * @return The RootDigestMode.
+   */
+  RootDigestMode
+  getRootDigestMode() const { return rootDigestMode_; }
+
 private:
+  /**
+   * Find the position of the node in the sorted digestNode_.
+   * @return The iterator of the node, or where it would be inserted.
+   */
+  std::vector<ptr_lib::shared_ptr<DigestTree::Node> >::const_iterator
+  lowerBound(const std::string& dataPrefix, int sessionNo) const;
+
   /**
    * Set root_ to the digest of all digests in digestNode_. This sets root_
-   * to the hex value of the digest.
+   * to the hex value of the digest. In ROOT_DIGEST_MERKLE mode, this rebuilds
+   * the Merkle tree.
    */
   void
   recomputeRoot();
 
+  /**
+   * In ROOT_DIGEST_MERKLE mode, update the Merkle tree path from the node at
+   * index to the root and set root_.
+   * @param index The index in digestNode_ of the node whose digest changed.
+   */
+  void
+  updateMerklePath(size_t index);
+
+  /**
+   * Set the Merkle tree node at position from its two children. If the right
+   * child has no nodes, copy the left child.
+   * @param position The position in merkleTree_ where the root is 1.
+   * @param height The height of the position, where the leaves are 0.
+   */
+  void
+  combineMerkleChildren(size_t position, size_t height);
+
+  /**
+   * Get the pointer to the digest in merkleTree_ at the position.
+   */
+  uint8_t*
+  getMerkleDigest(size_t position)
+  {
+    return &merkleTree_[position * ndn_SHA256_DIGEST_SIZE];
+  }
+
   std::vector<ptr_lib::shared_ptr<DigestTree::Node> > digestNode_;
   std::string root_;
   Node::Compare nodeCompare_;
+  RootDigestMode rootDigestMode_;
+  // merkleTree_ is a complete binary tree of digests where position 1 is the
+  // root and the leaves start at merkleCapacity_, a power of 2.
+  std::vector<uint8_t> merkleTree_;
+  size_t merkleCapacity_;
 };
 
 }
 
 #endif
-
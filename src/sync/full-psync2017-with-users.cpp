@@ -41,7 +41,7 @@ INIT_LOGGER("ndn.FullPSync2017WithUsers");
 namespace ndn {
 
 FullPSync2017WithUsers::Impl::Impl(const OnUpdate& onUpdate)
-: onUpdate_(onUpdate), prefixes_(new PSyncUserPrefixes())
+: onUpdate_(onUpdate), prefixes_(new PSyncUserPrefixes()), nRepeatedPrefixes_(0)
 {
 }
 
@@ -100,6 +100,40 @@ FullPSync2017WithUsers::Impl::publishName(const Name& prefix, int sequenceNo)
     fullPSync_->publishName(Name(prefix).appendNumber(newSequenceNo));
 }
 
+size_t
+FullPSync2017WithUsers::Impl::publishNames(const vector<Name>& prefixes)
+{
+  // Update all the sequence numbers first so that a repeated prefix only
+  // publishes its final sequence number.
+  vector<Name> updatedPrefixes;
+  set<Name> updatedPrefixSet;
+  for (vector<Name>::const_iterator prefix = prefixes.begin();
+       prefix != prefixes.end(); ++prefix) {
+    if (!prefixes_->isUserNode(*prefix)) {
+      _LOG_ERROR("Prefix not added: " << *prefix);
+      continue;
+    }
+
+    int newSequenceNo = prefixes_->prefixes_[*prefix] + 1;
+    _LOG_INFO("Publish: " << *prefix << "/" << newSequenceNo);
+    if (!updateSequenceNo(*prefix, newSequenceNo))
+      continue;
+
+    if (updatedPrefixSet.insert(*prefix).second)
+      updatedPrefixes.push_back(*prefix);
+    else
+      ++nRepeatedPrefixes_;
+  }
+
+  vector<Name> names;
+  names.reserve(updatedPrefixes.size());
+  for (vector<Name>::iterator prefix = updatedPrefixes.begin();
+       prefix != updatedPrefixes.end(); ++prefix)
+    names.push_back(Name(*prefix).appendNumber(prefixes_->prefixes_[*prefix]));
+
+  return fullPSync_->publishNames(names);
+}
+
 bool
 FullPSync2017WithUsers::Impl::canAddReceivedName(const Name& name)
 {
@@ -157,9 +191,9 @@ FullPSync2017WithUsers::Impl::isNotFutureHash
 {
   Name prefix = name.getPrefix(-1);
 
-  string uri = Name(prefix).appendNumber(prefixes_->prefixes_[prefix] + 1).toUri();
-  uint32_t nextHash = CryptoLite::murmurHash3
-    (InvertibleBloomLookupTable::N_HASHCHECK, uri.data(), uri.size());
+  uint32_t nextHash = PSyncProducerBase::hashName
+    (Name(prefix).appendNumber(prefixes_->prefixes_[prefix] + 1),
+     fullPSync_->getNameHashMode());
 
   for (set<uint32_t>::iterator negativeHash = negative.begin();
        negativeHash != negative.end();
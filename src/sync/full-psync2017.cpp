@@ -24,8 +24,10 @@
 #include <ndn-cpp/ndn-cpp-config.h>
 #if NDN_CPP_HAVE_LIBZ
 
+#include <algorithm>
 #include <ndn-cpp/util/logging.hpp>
 #include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "../c/util/time.h"
 #include "./detail/psync-segment-publisher.hpp"
 #include "./detail/invertible-bloom-lookup-table.hpp"
 #include "./detail/psync-state.hpp"
@@ -50,7 +52,10 @@ FullPSync2017::Impl::Impl
   face_(face), keyChain_(keyChain), syncInterestLifetime_(syncInterestLifetime),
   signingInfo_(signingInfo), onNamesUpdate_(onNamesUpdate),
   canAddToSyncData_(canAddToSyncData), canAddReceivedName_(canAddReceivedName),
-  segmentPublisher_(new PSyncSegmentPublisher(face_, keyChain_))
+  segmentPublisher_(new PSyncSegmentPublisher(face_, keyChain_)),
+  ibltCodec_(IBLT_CODEC_ZLIB), stateCodec_(STATE_CODEC_NAMES),
+  publishDelay_(0), isPublishScheduled_(false), nCoalescedPublications_(0),
+  scheduledExpirationTime_(0), ibltVersion_(0), ibltChangesVersion_(0)
 {
 }
 
@@ -77,7 +82,283 @@ FullPSync2017::Impl::publishName(const Name& name)
   }
 
   _LOG_INFO("Publish: " << name);
+  insertName(name);
+  onPublished(1);
+}
+
+size_t
+FullPSync2017::Impl::publishNames(const vector<Name>& names)
+{
+  size_t nPublished = 0;
+  for (vector<Name>::const_iterator name = names.begin();
+       name != names.end(); ++name) {
+    if (nameToHash_.find(*name) != nameToHash_.end()) {
+      _LOG_DEBUG("Already published, ignoring: " << *name);
+      continue;
+    }
+
+    _LOG_INFO("Publish: " << *name);
+    insertName(*name);
+    ++nPublished;
+  }
+
+  if (nPublished > 0)
+    onPublished(nPublished);
+  return nPublished;
+}
+
+void
+FullPSync2017::Impl::removeName(const Name& name)
+{
+  unordered_map<Name, uint32_t, NameHash>::iterator hashEntry =
+    nameToHash_.find(name);
+  if (hashEntry == nameToHash_.end())
+    return;
+
+  uint32_t hash = hashEntry->second;
+  removeFromIblt(name);
+  onIbltChanged(hash, false);
+}
+
+void
+FullPSync2017::Impl::setStateCodec(StateCodec stateCodec)
+{
+  if (stateCodec == stateCodec_)
+    return;
+
+  stateCodec_ = stateCodec;
+  fullStateSegments_.clear();
+  for (unordered_multimap<uint32_t, ptr_lib::shared_ptr<PendingDifference> >::iterator
+         difference = pendingDifferences_.begin();
+       difference != pendingDifferences_.end(); ++difference) {
+    difference->second->segments_.clear();
+    difference->second->segmentsVersion_ = PendingDifference::NO_SEGMENTS_VERSION;
+  }
+}
+
+void
+FullPSync2017::Impl::setNameHashMode
+  (PSyncProducerBase::NameHashMode nameHashMode)
+{
+  if (nameHashMode == nameHashMode_)
+    return;
+
+  PSyncProducerBase::setNameHashMode(nameHashMode);
+  // All the hashes may have changed, so make updateDifference compute each
+  // difference again.
+  ++ibltVersion_;
+  ibltChanges_.clear();
+  ibltChangesVersion_ = ibltVersion_;
+}
+
+void
+FullPSync2017::Impl::insertName(const Name& name)
+{
   insertIntoIblt(name);
+  onIbltChanged(nameToHash_[name], true);
+}
+
+void
+FullPSync2017::Impl::onIbltChanged(uint32_t hash, bool isInsert)
+{
+  ++ibltVersion_;
+  if (pendingDifferences_.size() == 0 ||
+      ibltChanges_.size() >= expectedNEntries_) {
+    // There is nothing to update, or it is faster for updateDifference to
+    // compute the difference again.
+    ibltChanges_.clear();
+    ibltChangesVersion_ = ibltVersion_;
+    return;
+  }
+
+  ibltChanges_.push_back(make_pair(hash, isInsert));
+}
+
+bool
+FullPSync2017::Impl::updateDifference(PendingDifference& difference)
+{
+  if (difference.ibltVersion_ == ibltVersion_)
+    return true;
+
+  if (difference.isComplete_ && difference.ibltVersion_ >= ibltChangesVersion_) {
+    // Apply the changes to our IBLT since the difference was updated. The
+    // difference is our IBLT minus the other, so an insert cancels a negative
+    // entry or adds a positive entry, and an erase is the opposite.
+    for (size_t i = difference.ibltVersion_ - ibltChangesVersion_;
+         i < ibltChanges_.size(); ++i) {
+      uint32_t hash = ibltChanges_[i].first;
+      set<uint32_t>& same =
+        (ibltChanges_[i].second ? difference.negative_ : difference.positive_);
+      set<uint32_t>& opposite =
+        (ibltChanges_[i].second ? difference.positive_ : difference.negative_);
+      if (same.erase(hash) == 0)
+        opposite.insert(hash);
+    }
+  }
+  else {
+    vector<uint32_t> positive;
+    vector<uint32_t> negative;
+    difference.isComplete_ =
+      iblt_->difference(*difference.iblt_)->listEntries(positive, negative);
+    if (!difference.isComplete_) {
+      _LOG_TRACE("Decode failed for pending interest");
+      if (positive.size() + negative.size() >= threshold_ ||
+          (positive.size() == 0 && negative.size() == 0))
+        return false;
+    }
+
+    difference.positive_ = set<uint32_t>(positive.begin(), positive.end());
+    difference.negative_ = set<uint32_t>(negative.begin(), negative.end());
+  }
+
+  difference.ibltVersion_ = ibltVersion_;
+  return true;
+}
+
+void
+FullPSync2017::Impl::addPendingEntry
+  (const Name& interestName,
+   const ptr_lib::shared_ptr<InvertibleBloomLookupTable>& iblt, bool isComplete,
+   const vector<uint32_t>& positive, const vector<uint32_t>& negative,
+   Milliseconds interestLifetime)
+{
+  // Replace an entry for the same Interest name. The old entry is ignored when
+  // it expires. Do this first in case it has the last reference to the
+  // PendingDifference that we would find below.
+  PendingEntryMap::iterator oldEntry = pendingEntries_.find(interestName);
+  if (oldEntry != pendingEntries_.end())
+    erasePendingEntry(oldEntry);
+
+  uint32_t ibltHash = iblt->hash();
+  ptr_lib::shared_ptr<PendingDifference> difference;
+  typedef unordered_multimap<uint32_t, ptr_lib::shared_ptr<PendingDifference> >
+    DifferenceMap;
+  pair<DifferenceMap::iterator, DifferenceMap::iterator> range =
+    pendingDifferences_.equal_range(ibltHash);
+  for (DifferenceMap::iterator it = range.first; it != range.second; ++it) {
+    if (it->second->iblt_->equals(*iblt)) {
+      difference = it->second;
+      break;
+    }
+  }
+
+  if (!difference) {
+    // Use the difference which onSyncInterest already decoded.
+    difference.reset(new PendingDifference(iblt));
+    difference->positive_ = set<uint32_t>(positive.begin(), positive.end());
+    difference->negative_ = set<uint32_t>(negative.begin(), negative.end());
+    difference->isComplete_ = isComplete;
+    difference->ibltVersion_ = ibltVersion_;
+    if (pendingDifferences_.size() == 0) {
+      // onIbltChanged didn't keep changes while there were no differences.
+      ibltChanges_.clear();
+      ibltChangesVersion_ = ibltVersion_;
+    }
+    pendingDifferences_.insert(make_pair(ibltHash, difference));
+  }
+
+  ptr_lib::shared_ptr<PendingEntryInfoFull> entry(new PendingEntryInfoFull
+    (interestName, difference, ndn_getNowMilliseconds() + interestLifetime));
+  ++difference->nEntries_;
+  pendingEntries_[interestName] = entry;
+  pendingExpirations_.push(entry);
+  schedulePendingExpiration();
+}
+
+void
+FullPSync2017::Impl::erasePendingEntry(PendingEntryMap::iterator entry)
+{
+  ptr_lib::shared_ptr<PendingDifference> difference = entry->second->difference_;
+  pendingEntries_.erase(entry);
+
+  if (--difference->nEntries_ > 0)
+    return;
+  typedef unordered_multimap<uint32_t, ptr_lib::shared_ptr<PendingDifference> >
+    DifferenceMap;
+  pair<DifferenceMap::iterator, DifferenceMap::iterator> range =
+    pendingDifferences_.equal_range(difference->iblt_->hash());
+  for (DifferenceMap::iterator it = range.first; it != range.second; ++it) {
+    if (it->second == difference) {
+      pendingDifferences_.erase(it);
+      break;
+    }
+  }
+}
+
+void
+FullPSync2017::Impl::schedulePendingExpiration()
+{
+  if (pendingExpirations_.empty())
+    return;
+
+  MillisecondsSince1970 expirationTime =
+    pendingExpirations_.top()->expirationTime_;
+  if (scheduledExpirationTime_ != 0 &&
+      scheduledExpirationTime_ <= expirationTime)
+    // The timer which is already scheduled will handle it.
+    return;
+
+  scheduledExpirationTime_ = expirationTime;
+  Milliseconds delay = expirationTime - ndn_getNowMilliseconds();
+  face_.callLater
+    (delay > 0 ? delay : 0,
+     bind(&FullPSync2017::Impl::onPendingExpirationTimer,
+          static_pointer_cast<FullPSync2017::Impl>(shared_from_this()),
+          expirationTime));
+}
+
+void
+FullPSync2017::Impl::onPendingExpirationTimer
+  (MillisecondsSince1970 scheduledTime)
+{
+  if (scheduledTime != scheduledExpirationTime_)
+    // This timer was replaced by an earlier one.
+    return;
+  scheduledExpirationTime_ = 0;
+
+  MillisecondsSince1970 now = ndn_getNowMilliseconds();
+  while (!pendingExpirations_.empty() &&
+         pendingExpirations_.top()->expirationTime_ <= now) {
+    ptr_lib::shared_ptr<PendingEntryInfoFull> entry = pendingExpirations_.top();
+    pendingExpirations_.pop();
+
+    PendingEntryMap::iterator pendingEntry = pendingEntries_.find(entry->name_);
+    // Only erase if it is the same entry, not a new one with the same name.
+    if (pendingEntry != pendingEntries_.end() && pendingEntry->second == entry) {
+      _LOG_TRACE("Remove Pending Interest " << entry->name_);
+      erasePendingEntry(pendingEntry);
+    }
+  }
+
+  schedulePendingExpiration();
+}
+
+void
+FullPSync2017::Impl::onPublished(size_t nPublished)
+{
+  if (isPublishScheduled_) {
+    // onPublishDelay will answer for all of these.
+    nCoalescedPublications_ += nPublished;
+    return;
+  }
+
+  // The first Name gets the update and the rest are coalesced with it.
+  nCoalescedPublications_ += nPublished - 1;
+  if (publishDelay_ > 0) {
+    isPublishScheduled_ = true;
+    face_.callLater
+      (publishDelay_,
+       bind(&FullPSync2017::Impl::onPublishDelay,
+            static_pointer_cast<FullPSync2017::Impl>(shared_from_this())));
+  }
+  else
+    satisfyPendingInterests();
+}
+
+void
+FullPSync2017::Impl::onPublishDelay()
+{
+  isPublishScheduled_ = false;
   satisfyPendingInterests();
 }
 
@@ -93,11 +374,14 @@ FullPSync2017::Impl::sendSyncInterest()
   }
 #endif
 
-  // Sync Interest format for full sync: /<sync-prefix>/<ourLatestIBF>
+  // Sync Interest format for full sync: /<sync-prefix>/<ourLatestIBF>, or
+  // /<sync-prefix>/<sparse-marker>/<ourLatestIBF> for the sparse codec.
   Name syncInterestName(syncPrefix_);
 
   // Append our latest IBLT.
-  syncInterestName.append(iblt_->encode());
+  if (ibltCodec_ == IBLT_CODEC_SPARSE)
+    syncInterestName.append(getSparseIbltMarker());
+  syncInterestName.append(encodeIblt());
 
   outstandingInterestName_ = syncInterestName;
 
@@ -128,6 +412,34 @@ FullPSync2017::Impl::sendSyncInterest()
              ", hash: " << syncInterestName.hash());
 }
 
+Blob
+FullPSync2017::Impl::encodeIblt() const
+{
+  // The IBLT caches the encoding until it changes.
+  if (ibltCodec_ == IBLT_CODEC_SPARSE)
+    return iblt_->encodeSparse();
+  else
+    return iblt_->encode();
+}
+
+void
+FullPSync2017::Impl::encodeState
+  (const PSyncState& state, vector<Blob>& segments) const
+{
+  if (stateCodec_ == STATE_CODEC_DELTA)
+    // Each block is the content of one segment.
+    state.wireEncodeDelta(PSyncSegmentPublisher::getMaxSegmentSize(), segments);
+  else
+    PSyncSegmentPublisher::splitContent(state.wireEncode(), segments);
+}
+
+const Name::Component&
+FullPSync2017::Impl::getSparseIbltMarker()
+{
+  static Name::Component marker("sparse-iblt");
+  return marker;
+}
+
 void
 FullPSync2017::Impl::onError
   (SegmentFetcher::ErrorCode errorCode, const std::string& message)
@@ -149,10 +461,15 @@ FullPSync2017::Impl::onSyncInterest
   Name nameWithoutSyncPrefix = interest->getName().getSubName(prefixName->size());
   Name interestName;
 
-  if (nameWithoutSyncPrefix.size() == 1)
+  // A zlib encoded IBLT never equals the marker, so this is not ambiguous.
+  bool isSparse = (nameWithoutSyncPrefix.size() >= 1 &&
+                   nameWithoutSyncPrefix.get(0).equals(getSparseIbltMarker()));
+  size_t nIbltComponents = (isSparse ? 2 : 1);
+
+  if (nameWithoutSyncPrefix.size() == nIbltComponents)
     // Get /<prefix>/IBLT from /<prefix>/IBLT
     interestName = interest->getName();
-  else if (nameWithoutSyncPrefix.size() == 3)
+  else if (nameWithoutSyncPrefix.size() == nIbltComponents + 2)
     // Get /<prefix>/IBLT from /<prefix>/IBLT/<version>/<segment-no>
     interestName = interest->getName().getPrefix(-2);
   else
@@ -166,7 +483,10 @@ FullPSync2017::Impl::onSyncInterest
   ptr_lib::shared_ptr<InvertibleBloomLookupTable> iblt
     (new InvertibleBloomLookupTable(expectedNEntries_));
   try {
-    iblt->initialize(ibltName.getValue());
+    if (isSparse)
+      iblt->initializeSparse(ibltName.getValue());
+    else
+      iblt->initialize(ibltName.getValue());
   } catch (const std::exception& ex) {
     _LOG_ERROR(ex.what());
     return;
@@ -175,10 +495,11 @@ FullPSync2017::Impl::onSyncInterest
   ptr_lib::shared_ptr<InvertibleBloomLookupTable> difference =
    iblt_->difference(*iblt);
 
-  set<uint32_t> positive;
-  set<uint32_t> negative;
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
 
-  if (!difference->listEntries(positive, negative)) {
+  bool isComplete = difference->listEntries(positive, negative);
+  if (!isComplete) {
     _LOG_TRACE("Cannot decode differences, positive: " << positive.size() <<
             " negative: " << negative.size() << " threshold: " <<
             threshold_);
@@ -188,53 +509,73 @@ FullPSync2017::Impl::onSyncInterest
     // the positive as usual.
     if (positive.size() + negative.size() >= threshold_ ||
         (positive.size() == 0 && negative.size() == 0)) {
-      PSyncState state1;
-      for (map<Name, uint32_t>::iterator entry = nameToHash_.begin();
-           entry != nameToHash_.end(); ++entry)
-        state1.addContent(entry->first);
+      if (nameToHash_.size() == 0)
+        return;
+
+      // The full state only depends on our IBLT, so reuse the segments until
+      // it changes.
+      Blob ibltEncoding = encodeIblt();
+      if (fullStateSegments_.size() == 0 ||
+          !fullStateIbltEncoding_.equals(ibltEncoding)) {
+        PSyncState state1;
+        for (unordered_map<Name, uint32_t, NameHash>::iterator entry =
+               nameToHash_.begin();
+             entry != nameToHash_.end(); ++entry)
+          state1.addContent(entry->first);
+
+        fullStateSegments_.clear();
+        encodeState(state1, fullStateSegments_);
+        fullStateIbltEncoding_ = ibltEncoding;
+      }
+      else
+        _LOG_TRACE("Sending the cached full state");
 
-      if (state1.getContent().size() > 0)
-        segmentPublisher_->publish
-          (interest->getName(), interest->getName(), state1.wireEncode(),
-           syncReplyFreshnessPeriod_, signingInfo_);
+      segmentPublisher_->publish
+        (interest->getName(), interest->getName(), fullStateSegments_,
+         syncReplyFreshnessPeriod_, signingInfo_);
 
       return;
     }
   }
 
+  // CanAddToSyncData takes a set, so only make it if needed.
+  set<uint32_t> negativeSet;
+  if (canAddToSyncData_)
+    negativeSet.insert(negative.begin(), negative.end());
+
   PSyncState state;
-  for (set<uint32_t>::iterator hash = positive.begin(); hash != positive.end();
+  for (vector<uint32_t>::iterator hash = positive.begin(); hash != positive.end();
        ++hash) {
     Name name = hashToName_[*hash];
 
     if (nameToHash_.find(name) != nameToHash_.end()) {
-      if (!canAddToSyncData_ || canAddToSyncData_(name, negative))
+      if (!canAddToSyncData_ || canAddToSyncData_(name, negativeSet))
         state.addContent(name);
     }
   }
 
   if (state.getContent().size() > 0) {
     _LOG_DEBUG("Sending sync content: " << state.toString());
-    sendSyncData(interestName, state.wireEncode());
+    vector<Blob> segments;
+    encodeState(state, segments);
+    sendSyncData(interestName, segments);
     return;
   }
 
-  ptr_lib::shared_ptr<PendingEntryInfoFull> entry(new PendingEntryInfoFull(iblt));
-  pendingEntries_[interestName] = entry;
-  face_.callLater
-    (interest->getInterestLifetimeMilliseconds(),
-     bind(&FullPSync2017::Impl::delayedRemovePendingEntry,
-          static_pointer_cast<FullPSync2017::Impl>(shared_from_this()),
-          interest->getName(), entry, interest->getNonce()));
+  addPendingEntry
+    (interestName, iblt, isComplete, positive, negative,
+     interest->getInterestLifetimeMilliseconds());
 }
 
 void
-FullPSync2017::Impl::sendSyncData(const Name& name, Blob content)
+FullPSync2017::Impl::sendSyncData
+  (const Name& name, const vector<Blob>& segments)
 {
   _LOG_DEBUG("Checking if the Data will satisfy our own pending interest");
 
+  // Use the same codec as the sync Interest so that the encoding is cached.
   Name nameWithIblt;
-  nameWithIblt.append(iblt_->encode());
+  nameWithIblt.append(encodeIblt());
 
   // Append the hash of our IBLT so that the Data name should be different for
   // each node.
@@ -258,7 +599,7 @@ FullPSync2017::Impl::sendSyncData(const Name& name, Blob content)
 
     // Send Data after removing the pending sync interest on the Face.
     segmentPublisher_->publish
-      (name, dataName, content, syncReplyFreshnessPeriod_, signingInfo_);
+      (name, dataName, segments, syncReplyFreshnessPeriod_, signingInfo_);
 
     _LOG_TRACE("sendSyncData: Renewing sync interest");
     sendSyncInterest();
@@ -266,52 +607,70 @@ FullPSync2017::Impl::sendSyncData(const Name& name, Blob content)
   else {
     _LOG_DEBUG("Sending Sync Data for not our own Interest");
     segmentPublisher_->publish
-      (name, dataName, content, syncReplyFreshnessPeriod_, signingInfo_);
+      (name, dataName, segments, syncReplyFreshnessPeriod_, signingInfo_);
   }
 }
 
 void
 FullPSync2017::Impl::satisfyPendingInterests()
 {
-  _LOG_DEBUG("Satisfying full sync Interest: " << pendingEntries_.size());
+  _LOG_DEBUG("Satisfying full sync Interest: " << pendingEntries_.size() <<
+             ", distinct IBLTs: " << pendingDifferences_.size());
+
+  // Update the difference of each distinct IBLT once for all the Interests
+  // which have it.
+  vector<ptr_lib::shared_ptr<PendingDifference> > undecodable;
+  for (unordered_multimap<uint32_t, ptr_lib::shared_ptr<PendingDifference> >::iterator
+         difference = pendingDifferences_.begin();
+       difference != pendingDifferences_.end(); ++difference) {
+    if (!updateDifference(*difference->second))
+      undecodable.push_back(difference->second);
+  }
+  // All the differences are up to date.
+  ibltChanges_.clear();
+  ibltChangesVersion_ = ibltVersion_;
 
-  for (map<Name, ptr_lib::shared_ptr<PendingEntryInfoFull> >::iterator it =
-         pendingEntries_.begin();
+  for (PendingEntryMap::iterator it = pendingEntries_.begin();
        it != pendingEntries_.end();) {
-    const InvertibleBloomLookupTable& entryIblt = *it->second->iblt_;
-    ptr_lib::shared_ptr<InvertibleBloomLookupTable> difference =
-            iblt_->difference(entryIblt);
-    set<uint32_t> positive;
-    set<uint32_t> negative;
+    PendingDifference& difference = *it->second->difference_;
+    if (find(undecodable.begin(), undecodable.end(), it->second->difference_) !=
+        undecodable.end()) {
+      _LOG_TRACE
+        ("positive + negative > threshold or no difference can be found. Erase pending interest.");
+      erasePendingEntry(it++);
+      continue;
+    }
 
-    if (!difference->listEntries(positive, negative)) {
-      _LOG_TRACE("Decode failed for pending interest");
-      if (positive.size() + negative.size() >= threshold_ ||
-          (positive.size() == 0 && negative.size() == 0)) {
-        _LOG_TRACE
-          ("positive + negative > threshold or no difference can be found. Erase pending interest.");
-        // Prevent delayedRemovePendingEntry from removing a new entry with the same Name.
-        it->second->isRemoved_ = true;
-        pendingEntries_.erase(it++);
-        continue;
-      }
+    if (difference.positive_.size() == 0) {
+      ++it;
+      continue;
     }
 
-    PSyncState state;
-    for (set<uint32_t>::iterator hash = positive.begin(); hash != positive.end();
-         ++hash) {
-      Name name = hashToName_[*hash];
+    if (difference.segmentsVersion_ != ibltVersion_) {
+      // Make the reply once for all the Interests with this difference.
+      PSyncState state;
+      for (set<uint32_t>::iterator hash = difference.positive_.begin();
+           hash != difference.positive_.end(); ++hash) {
+        unordered_map<uint32_t, Name>::iterator name = hashToName_.find(*hash);
+        if (name != hashToName_.end() &&
+            nameToHash_.find(name->second) != nameToHash_.end())
+          state.addContent(name->second);
+      }
 
-      if (nameToHash_.find(name) != nameToHash_.end())
-        state.addContent(name);
+      difference.segments_.clear();
+      if (state.getContent().size() > 0) {
+        _LOG_DEBUG("Satisfying sync content: " << state.toString());
+        encodeState(state, difference.segments_);
+      }
+      difference.segmentsVersion_ = ibltVersion_;
     }
 
-    if (state.getContent().size() > 0) {
-      _LOG_DEBUG("Satisfying sync content: " << state.toString());
-      sendSyncData(it->first, state.wireEncode());
-      // Prevent delayedRemovePendingEntry from removing a new entry with the same Name.
-      it->second->isRemoved_ = true;
-      pendingEntries_.erase(it++);
+    if (difference.segments_.size() > 0) {
+      // Copy the segments since erasePendingEntry may delete the difference.
+      vector<Blob> segments(difference.segments_);
+      Name name(it->first);
+      erasePendingEntry(it++);
+      sendSyncData(name, segments);
     }
     else
       ++it;
@@ -321,15 +680,12 @@ FullPSync2017::Impl::satisfyPendingInterests()
 void
 FullPSync2017::Impl::deletePendingInterests(const Name& interestName)
 {
-  map<Name, ptr_lib::shared_ptr<PendingEntryInfoFull> >::iterator entry =
-    pendingEntries_.find(interestName);
+  PendingEntryMap::iterator entry = pendingEntries_.find(interestName);
   if (entry == pendingEntries_.end())
     return;
 
   _LOG_TRACE("Delete pending interest: " << interestName);
-  // Prevent delayedRemovePendingEntry from removing a new entry with the same Name.
-  entry->second->isRemoved_ = true;
-  pendingEntries_.erase(entry);
+  erasePendingEntry(entry);
 }
 
 void
@@ -352,7 +708,7 @@ FullPSync2017::Impl::onSyncData
       if (!canAddReceivedName_ || canAddReceivedName_(*contentName)) {
         _LOG_DEBUG("Adding name " << *contentName);
         names->push_back(*contentName);
-        insertIntoIblt(*contentName);
+        insertName(*contentName);
       }
       // We should not call satisfyPendingSyncInterests here because we just
       // got data and deleted pending interests by calling deletePendingInterests.
@@ -379,21 +735,6 @@ FullPSync2017::Impl::onSyncData
   }
 }
 
-void
-FullPSync2017::Impl::delayedRemovePendingEntry
-  (const Name& name, const ptr_lib::shared_ptr<PendingEntryInfoFull>& entry,
-   const Blob& nonce)
-{
-  if (entry->isRemoved_)
-    // A previous operation already removed this entry, so don't try again to
-    // remove the entry with the Name in case it is a new entry.
-    return;
-
-  _LOG_TRACE("Remove Pending Interest " << nonce);
-  entry->isRemoved_ = true;
-  pendingEntries_.erase(name);
-}
-
 }
 
 #endif // NDN_CPP_HAVE_LIBZ
@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ * @author: From the PSync library https://github.com/named-data/PSync/blob/master/PSync/consumer.cpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_LIBZ 1.
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_LIBZ
+
+#include <stdexcept>
+#include <ndn-cpp/util/logging.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "./detail/bloom-filter.hpp"
+#include "./detail/psync-state.hpp"
+#include <ndn-cpp/sync/partial-psync2017-producer.hpp>
+#include <ndn-cpp/sync/partial-psync2017-consumer.hpp>
+
+using namespace std;
+using namespace ndn::func_lib;
+
+INIT_LOGGER("ndn.PartialPSync2017Consumer");
+
+namespace ndn {
+
+PartialPSync2017Consumer::Impl::Impl
+  (const Name& syncPrefix, Face& face,
+   const OnReceiveHelloData& onReceiveHelloData, const OnUpdate& onUpdate,
+   size_t bloomFilterCount, double bloomFilterFalsePositiveProbability,
+   Milliseconds helloInterestLifetime, Milliseconds syncInterestLifetime)
+: syncPrefix_(syncPrefix), face_(face), onReceiveHelloData_(onReceiveHelloData),
+  onUpdate_(onUpdate), helloInterestLifetime_(helloInterestLifetime),
+  syncInterestLifetime_(syncInterestLifetime),
+  bloomFilter_(new BloomFilter
+    (bloomFilterCount, bloomFilterFalsePositiveProbability)),
+  haveIblt_(false), syncGeneration_(0)
+{
+}
+
+void
+PartialPSync2017Consumer::Impl::sendHelloInterest()
+{
+  Name helloInterestName(syncPrefix_);
+  helloInterestName.append(PartialPSync2017Producer::getHelloComponent());
+
+  Interest helloInterest(helloInterestName);
+  helloInterest.setInterestLifetimeMilliseconds(helloInterestLifetime_);
+  helloInterest.setCanBePrefix(true);
+  helloInterest.setMustBeFresh(true);
+
+  _LOG_DEBUG("Send hello Interest " << helloInterestName);
+
+  ptr_lib::shared_ptr<Name> dataName(ptr_lib::make_shared<Name>());
+  SegmentFetcher::fetch
+    (face_, helloInterest,
+     bind(&PartialPSync2017Consumer::Impl::saveDataName, _1, dataName),
+     bind(&PartialPSync2017Consumer::Impl::onHelloData, shared_from_this(),
+          _1, dataName),
+     bind(&PartialPSync2017Consumer::Impl::onHelloError, shared_from_this(),
+          _1, _2));
+}
+
+void
+PartialPSync2017Consumer::Impl::sendSyncInterest()
+{
+  if (!haveIblt_)
+    throw runtime_error
+      ("PartialPSync2017Consumer: Can't send a sync Interest before receiving the hello Data");
+
+  // Sync Interest format: /<sync-prefix>/sync/<BF>/<producers-IBLT>
+  Name syncInterestName(syncPrefix_);
+  syncInterestName.append(PartialPSync2017Producer::getSyncComponent());
+  bloomFilter_->appendToName(syncInterestName);
+  syncInterestName.append(iblt_);
+
+  Interest syncInterest(syncInterestName);
+  syncInterest.setInterestLifetimeMilliseconds(syncInterestLifetime_);
+  syncInterest.setCanBePrefix(true);
+  syncInterest.setMustBeFresh(true);
+
+  uint64_t generation = ++syncGeneration_;
+  _LOG_DEBUG("Send sync Interest, hash: " << syncInterestName.hash());
+
+  ptr_lib::shared_ptr<Name> dataName(ptr_lib::make_shared<Name>());
+  SegmentFetcher::fetch
+    (face_, syncInterest,
+     bind(&PartialPSync2017Consumer::Impl::saveDataName, _1, dataName),
+     bind(&PartialPSync2017Consumer::Impl::onSyncData, shared_from_this(),
+          _1, dataName, generation),
+     bind(&PartialPSync2017Consumer::Impl::onSyncError, shared_from_this(),
+          _1, _2, generation));
+}
+
+bool
+PartialPSync2017Consumer::Impl::addSubscription(const Name& prefix, int sequenceNo)
+{
+  if (subscriptions_.find(prefix) != subscriptions_.end())
+    return false;
+
+  _LOG_DEBUG("Subscribe to " << prefix);
+  subscriptions_[prefix] = sequenceNo;
+  bloomFilter_->insert(prefix.toUri());
+  return true;
+}
+
+bool
+PartialPSync2017Consumer::Impl::removeSubscription(const Name& prefix)
+{
+  if (subscriptions_.erase(prefix) == 0)
+    return false;
+
+  _LOG_DEBUG("Unsubscribe from " << prefix);
+  // A Bloom filter can't remove an entry, so rebuild it.
+  bloomFilter_->clear();
+  for (map<Name, int>::iterator subscription = subscriptions_.begin();
+       subscription != subscriptions_.end(); ++subscription)
+    bloomFilter_->insert(subscription->first.toUri());
+
+  return true;
+}
+
+int
+PartialPSync2017Consumer::Impl::getSequenceNo(const Name& prefix) const
+{
+  map<Name, int>::const_iterator entry = subscriptions_.find(prefix);
+  if (entry == subscriptions_.end())
+    return -1;
+
+  return entry->second;
+}
+
+bool
+PartialPSync2017Consumer::Impl::saveDataName
+  (const ptr_lib::shared_ptr<Data>& data,
+   const ptr_lib::shared_ptr<Name>& dataName)
+{
+  // Remove the version and segment.
+  if (data->getName().size() >= 2)
+    *dataName = data->getName().getPrefix(-2);
+  return true;
+}
+
+void
+PartialPSync2017Consumer::Impl::onHelloData
+  (const Blob& encodedContent, const ptr_lib::shared_ptr<Name>& dataName)
+{
+  // Hello Data name format: /<sync-prefix>/hello/<producers-IBLT>
+  if (dataName->size() != syncPrefix_.size() + 2) {
+    _LOG_ERROR("Unexpected hello Data name " << dataName->toUri());
+    return;
+  }
+
+  map<Name, int> availableSubscriptions;
+  try {
+    PSyncState state(encodedContent);
+    _LOG_DEBUG("Hello Data received: " << state.toString());
+
+    const vector<Name>& content = state.getContent();
+    for (vector<Name>::const_iterator name = content.begin();
+         name != content.end(); ++name)
+      availableSubscriptions[name->getPrefix(-1)] = (int)name->get(-1).toNumber();
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("Error decoding the hello Data: " << ex.what());
+    return;
+  }
+
+  iblt_ = dataName->get(-1);
+  haveIblt_ = true;
+
+  try {
+    onReceiveHelloData_(availableSubscriptions);
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("Error in onReceiveHelloData: " << ex.what());
+  } catch (...) {
+    _LOG_ERROR("Error in onReceiveHelloData.");
+  }
+}
+
+void
+PartialPSync2017Consumer::Impl::onSyncData
+  (const Blob& encodedContent, const ptr_lib::shared_ptr<Name>& dataName,
+   uint64_t generation)
+{
+  // Sync Data name format:
+  // /<sync-prefix>/sync/<BF>/<old-IBLT>/<producers-IBLT>
+  if (dataName->size() != syncPrefix_.size() + 6) {
+    _LOG_ERROR("Unexpected sync Data name " << dataName->toUri());
+    return;
+  }
+
+  ptr_lib::shared_ptr<vector<ptr_lib::shared_ptr<PSyncMissingDataInfo>>> updates
+    (ptr_lib::make_shared<vector<ptr_lib::shared_ptr<PSyncMissingDataInfo>>>());
+  try {
+    PSyncState state(encodedContent);
+    _LOG_DEBUG("Sync Data received: " << state.toString());
+
+    const vector<Name>& content = state.getContent();
+    for (vector<Name>::const_iterator name = content.begin();
+         name != content.end(); ++name) {
+      Name prefix = name->getPrefix(-1);
+      int sequenceNo = (int)name->get(-1).toNumber();
+
+      map<Name, int>::iterator subscription = subscriptions_.find(prefix);
+      // The Bloom filter can have a false positive, so check the prefix.
+      if (subscription == subscriptions_.end() ||
+          subscription->second >= sequenceNo)
+        continue;
+
+      updates->push_back(ptr_lib::make_shared<PSyncMissingDataInfo>
+        (prefix, subscription->second + 1, sequenceNo));
+      subscription->second = sequenceNo;
+    }
+  } catch (const std::exception& ex) {
+    _LOG_ERROR("Error decoding the sync Data: " << ex.what());
+    return;
+  }
+
+  iblt_ = dataName->get(-1);
+
+  if (updates->size() > 0) {
+    try {
+      onUpdate_(updates);
+    } catch (const std::exception& ex) {
+      _LOG_ERROR("Error in onUpdate: " << ex.what());
+    } catch (...) {
+      _LOG_ERROR("Error in onUpdate.");
+    }
+  }
+
+  sendSyncInterestIfCurrent(generation);
+}
+
+void
+PartialPSync2017Consumer::Impl::onHelloError
+  (SegmentFetcher::ErrorCode errorCode, const std::string& message)
+{
+  _LOG_TRACE("Cannot fetch hello data, error: " << errorCode <<
+             " message: " << message);
+}
+
+void
+PartialPSync2017Consumer::Impl::onSyncError
+  (SegmentFetcher::ErrorCode errorCode, const std::string& message,
+   uint64_t generation)
+{
+  _LOG_TRACE("Cannot fetch sync data, error: " << errorCode <<
+             " message: " << message);
+
+  // random1 is from 0.0 to 1.0.
+  float random1;
+  CryptoLite::generateRandomFloat(random1);
+  // Retry after a jitter of up to 100 milliseconds so that consumers which
+  // timed out together don't send together.
+  face_.callLater
+    (random1 * 100.0,
+     bind(&PartialPSync2017Consumer::Impl::sendSyncInterestIfCurrent,
+          shared_from_this(), generation));
+}
+
+void
+PartialPSync2017Consumer::Impl::sendSyncInterestIfCurrent(uint64_t generation)
+{
+  if (generation != syncGeneration_)
+    // The application or another reply already sent a newer sync Interest.
+    return;
+
+  sendSyncInterest();
+}
+
+}
+
+#endif // NDN_CPP_HAVE_LIBZ
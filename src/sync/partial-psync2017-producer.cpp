@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ * @author: From the PSync library https://github.com/named-data/PSync/blob/master/PSync/partial-producer.cpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+// Only compile if ndn-cpp-config.h defines NDN_CPP_HAVE_LIBZ 1.
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_LIBZ
+
+#include <ndn-cpp/util/logging.hpp>
+#include "./detail/psync-segment-publisher.hpp"
+#include "./detail/psync-user-prefixes.hpp"
+#include "./detail/invertible-bloom-lookup-table.hpp"
+#include "./detail/bloom-filter.hpp"
+#include "./detail/psync-state.hpp"
+#include <ndn-cpp/sync/partial-psync2017-producer.hpp>
+
+using namespace std;
+using namespace ndn::func_lib;
+
+INIT_LOGGER("ndn.PartialPSync2017Producer");
+
+namespace ndn {
+
+PartialPSync2017Producer::Impl::Impl
+  (size_t expectedNEntries, Face& face, const Name& syncPrefix,
+   KeyChain& keyChain, Milliseconds helloReplyFreshnessPeriod,
+   Milliseconds syncReplyFreshnessPeriod, const SigningInfo& signingInfo)
+: PSyncProducerBase(expectedNEntries, syncPrefix, syncReplyFreshnessPeriod),
+  face_(face), keyChain_(keyChain), signingInfo_(signingInfo),
+  helloReplyFreshnessPeriod_(helloReplyFreshnessPeriod),
+  segmentPublisher_(new PSyncSegmentPublisher(face_, keyChain_)),
+  prefixes_(new PSyncUserPrefixes())
+{
+}
+
+void
+PartialPSync2017Producer::Impl::initialize(const Name& userPrefix)
+{
+  if (userPrefix.size() > 0)
+    addUserNode(userPrefix);
+
+  registeredPrefix_ = face_.registerPrefix
+    (syncPrefix_,
+     bind(&PartialPSync2017Producer::Impl::onInterest,
+          static_pointer_cast<PartialPSync2017Producer::Impl>(shared_from_this()),
+          _1, _2, _3, _4, _5),
+     &PSyncProducerBase::onRegisterFailed);
+}
+
+int
+PartialPSync2017Producer::Impl::getSequenceNo(const Name& prefix) const
+{
+  return prefixes_->getSequenceNo(prefix);
+}
+
+bool
+PartialPSync2017Producer::Impl::addUserNode(const Name& prefix)
+{
+  return prefixes_->addUserNode(prefix);
+}
+
+void
+PartialPSync2017Producer::Impl::removeUserNode(const Name& prefix)
+{
+  if (prefixes_->isUserNode(prefix)) {
+    int sequenceNo = prefixes_->prefixes_[prefix];
+    prefixes_->removeUserNode(prefix);
+    removeFromIblt(Name(prefix).appendNumber(sequenceNo));
+  }
+}
+
+void
+PartialPSync2017Producer::Impl::publishName(const Name& prefix, int sequenceNo)
+{
+  if (!prefixes_->isUserNode(prefix)) {
+    _LOG_ERROR("Prefix not added: " << prefix);
+    return;
+  }
+
+  int newSequenceNo = sequenceNo >= 0 ? sequenceNo : prefixes_->prefixes_[prefix] + 1;
+
+  _LOG_INFO("Publish: " << prefix << "/" << newSequenceNo);
+
+  int oldSequenceNo;
+  if (!prefixes_->updateSequenceNo(prefix, newSequenceNo, oldSequenceNo))
+    return;
+
+  // Delete the old sequence number from the IBLT. If oldSequenceNo is zero, we
+  // don't need to delete it, because we don't insert a prefix with sequence
+  // number zero in the IBLT.
+  if (oldSequenceNo != 0)
+    removeFromIblt(Name(prefix).appendNumber(oldSequenceNo));
+  insertIntoIblt(Name(prefix).appendNumber(newSequenceNo));
+
+  satisfyPendingSyncInterests(prefix);
+}
+
+void
+PartialPSync2017Producer::Impl::onInterest
+  (const ptr_lib::shared_ptr<const Name>& prefixName,
+   const ptr_lib::shared_ptr<const Interest>& interest, Face& face,
+   uint64_t interestFilterId,
+   const ptr_lib::shared_ptr<const InterestFilter>& filter)
+{
+  if (segmentPublisher_->replyFromStore(interest->getName()))
+    return;
+
+  const Name& interestName = interest->getName();
+  if (interestName.size() <= prefixName->size())
+    return;
+
+  const Name::Component& command = interestName.get(prefixName->size());
+  if (command.equals(getHelloComponent()))
+    onHelloInterest(*interest, prefixName->size());
+  else if (command.equals(getSyncComponent()))
+    onSyncInterest(*interest, prefixName->size());
+}
+
+void
+PartialPSync2017Producer::Impl::onHelloInterest
+  (const Interest& interest, size_t syncPrefixSize)
+{
+  // Hello Interest format: /<sync-prefix>/hello or, for a later segment,
+  // /<sync-prefix>/hello/<IBLT>/<version>/<segment>, which replyFromStore
+  // already answered if it could.
+  if (interest.getName().size() != syncPrefixSize + 1)
+    return;
+
+  _LOG_DEBUG("Hello Interest received, nonce: " << interest.getNonce().toHex());
+
+  PSyncState state;
+  for (map<Name, int>::iterator prefix = prefixes_->prefixes_.begin();
+       prefix != prefixes_->prefixes_.end(); ++prefix)
+    state.addContent(Name(prefix->first).appendNumber(prefix->second));
+
+  // Hello Data name format: /<sync-prefix>/hello/<own-IBLT>
+  Name helloDataName(interest.getName());
+  helloDataName.append(iblt_->encode());
+
+  segmentPublisher_->publish
+    (interest.getName(), helloDataName, state.wireEncode(),
+     helloReplyFreshnessPeriod_, signingInfo_);
+}
+
+void
+PartialPSync2017Producer::Impl::onSyncInterest
+  (const Interest& interest, size_t syncPrefixSize)
+{
+  // Sync Interest format: /<sync-prefix>/sync/<BF>/<old-IBLT> where <BF> is
+  // three components. A later segment has /<version>/<segment>, which
+  // replyFromStore already answered if it could.
+  if (interest.getName().size() != syncPrefixSize + 5)
+    return;
+  const Name& interestName = interest.getName();
+
+  _LOG_DEBUG("Partial sync Interest received, nonce: " <<
+             interest.getNonce().toHex() << ", hash: " << interestName.hash());
+
+  ptr_lib::shared_ptr<BloomFilter> bloomFilter;
+  ptr_lib::shared_ptr<InvertibleBloomLookupTable> iblt
+    (new InvertibleBloomLookupTable(expectedNEntries_));
+  try {
+    size_t projectedCount = (size_t)interestName.get(-4).toNumber();
+    double falsePositiveProbability = interestName.get(-3).toNumber() / 1000.0;
+    bloomFilter.reset(new BloomFilter
+      (projectedCount, falsePositiveProbability, interestName.get(-2).getValue()));
+
+    iblt->initialize(interestName.get(-1).getValue());
+  } catch (const std::exception& ex) {
+    _LOG_ERROR(ex.what());
+    return;
+  }
+
+  ptr_lib::shared_ptr<InvertibleBloomLookupTable> difference =
+    iblt_->difference(*iblt);
+
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
+
+  if (!difference->listEntries(positive, negative)) {
+    _LOG_TRACE("Cannot decode differences, positive: " << positive.size() <<
+               " negative: " << negative.size() << " threshold: " <<
+               threshold_);
+
+    // Send all subscribed data if greater than the threshold, or if there are
+    // neither positive nor negative differences. Otherwise, continue below and
+    // send the positive as usual.
+    if (positive.size() + negative.size() >= threshold_ ||
+        (positive.size() == 0 && negative.size() == 0)) {
+      PSyncState state1;
+      for (map<Name, int>::iterator prefix = prefixes_->prefixes_.begin();
+           prefix != prefixes_->prefixes_.end(); ++prefix) {
+        // Don't sync up sequence number zero.
+        if (prefix->second != 0 && bloomFilter->contains(prefix->first.toUri()))
+          state1.addContent(Name(prefix->first).appendNumber(prefix->second));
+      }
+
+      if (state1.getContent().size() > 0)
+        sendSyncData(interestName, state1.wireEncode());
+
+      return;
+    }
+  }
+
+  PSyncState state;
+  for (vector<uint32_t>::iterator hash = positive.begin(); hash != positive.end();
+       ++hash) {
+    unordered_map<uint32_t, Name>::iterator name = hashToName_.find(*hash);
+    if (name == hashToName_.end())
+      continue;
+
+    Name prefix = name->second.getPrefix(-1);
+    if (bloomFilter->contains(prefix.toUri()))
+      state.addContent(name->second);
+  }
+
+  if (state.getContent().size() > 0) {
+    _LOG_DEBUG("Sending sync content: " << state.toString());
+    sendSyncData(interestName, state.wireEncode());
+    return;
+  }
+
+  ptr_lib::shared_ptr<PendingEntryInfo> entry
+    (new PendingEntryInfo(bloomFilter, iblt));
+  map<Name, ptr_lib::shared_ptr<PendingEntryInfo> >::iterator oldEntry =
+    pendingEntries_.find(interestName);
+  if (oldEntry != pendingEntries_.end())
+    // Prevent delayedRemovePendingEntry from removing the new entry.
+    oldEntry->second->isRemoved_ = true;
+  pendingEntries_[interestName] = entry;
+  face_.callLater
+    (interest.getInterestLifetimeMilliseconds(),
+     bind(&PartialPSync2017Producer::Impl::delayedRemovePendingEntry,
+          static_pointer_cast<PartialPSync2017Producer::Impl>(shared_from_this()),
+          interestName, entry));
+}
+
+void
+PartialPSync2017Producer::Impl::sendSyncData(const Name& interestName, Blob content)
+{
+  // Sync Data name format:
+  // /<sync-prefix>/sync/<BF>/<old-IBLT>/<own-IBLT>
+  Name syncDataName(interestName);
+  syncDataName.append(iblt_->encode());
+
+  segmentPublisher_->publish
+    (interestName, syncDataName, content, syncReplyFreshnessPeriod_,
+     signingInfo_);
+}
+
+void
+PartialPSync2017Producer::Impl::satisfyPendingSyncInterests(const Name& prefix)
+{
+  _LOG_TRACE("Pending interests: " << pendingEntries_.size());
+  string prefixUri = prefix.toUri();
+
+  for (map<Name, ptr_lib::shared_ptr<PendingEntryInfo> >::iterator it =
+         pendingEntries_.begin();
+       it != pendingEntries_.end();) {
+    const PendingEntryInfo& entry = *it->second;
+    ptr_lib::shared_ptr<InvertibleBloomLookupTable> difference =
+      iblt_->difference(*entry.iblt_);
+    vector<uint32_t> positive;
+    vector<uint32_t> negative;
+
+    if (!difference->listEntries(positive, negative)) {
+      _LOG_TRACE("Decode failed for pending interest");
+      if (positive.size() + negative.size() >= threshold_ ||
+          (positive.size() == 0 && negative.size() == 0)) {
+        _LOG_TRACE
+          ("positive + negative > threshold or no difference can be found. Erase pending interest.");
+        // Prevent delayedRemovePendingEntry from removing a new entry with the same Name.
+        it->second->isRemoved_ = true;
+        pendingEntries_.erase(it++);
+        continue;
+      }
+    }
+
+    bool isSubscribed = entry.bloomFilter_->contains(prefixUri);
+    if (isSubscribed || positive.size() + negative.size() >= threshold_) {
+      PSyncState state;
+      if (isSubscribed) {
+        state.addContent(Name(prefix).appendNumber(prefixes_->prefixes_[prefix]));
+        _LOG_DEBUG("Sending sync content: " << state.toString());
+      }
+      else
+        _LOG_DEBUG("Sending with empty content to send the latest IBLT to the consumer");
+
+      sendSyncData(it->first, state.wireEncode());
+      // Prevent delayedRemovePendingEntry from removing a new entry with the same Name.
+      it->second->isRemoved_ = true;
+      pendingEntries_.erase(it++);
+    }
+    else
+      ++it;
+  }
+}
+
+void
+PartialPSync2017Producer::Impl::delayedRemovePendingEntry
+  (const Name& name, const ptr_lib::shared_ptr<PendingEntryInfo>& entry)
+{
+  if (entry->isRemoved_)
+    // A previous operation already removed this entry, so don't try again to
+    // remove the entry with the Name in case it is a new entry.
+    return;
+
+  _LOG_TRACE("Remove Pending Interest " << name);
+  entry->isRemoved_ = true;
+  pendingEntries_.erase(name);
+}
+
+const Name::Component&
+PartialPSync2017Producer::getHelloComponent()
+{
+  static Name::Component component("hello");
+  return component;
+}
+
+const Name::Component&
+PartialPSync2017Producer::getSyncComponent()
+{
+  static Name::Component component("sync");
+  return component;
+}
+
+}
+
+#endif // NDN_CPP_HAVE_LIBZ
@@ -26,6 +26,8 @@
 
 #include <ndn-cpp/util/logging.hpp>
 #include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include <ndn-cpp/lite/encoding/tlv-0_3-wire-format-lite.hpp>
+#include <ndn-cpp/encoding/tlv-wire-format.hpp>
 #include "./detail/invertible-bloom-lookup-table.hpp"
 #include <ndn-cpp/sync/psync-producer-base.hpp>
 
@@ -42,16 +44,71 @@ PSyncProducerBase::PSyncProducerBase
   expectedNEntries_(expectedNEntries),
   threshold_(expectedNEntries / 2),
   syncPrefix_(syncPrefix),
-  syncReplyFreshnessPeriod_(syncReplyFreshnessPeriod)
+  syncReplyFreshnessPeriod_(syncReplyFreshnessPeriod),
+  nameHashMode_(NAME_HASH_URI)
 {
 }
 
+uint32_t
+PSyncProducerBase::hashName(const Name& name, NameHashMode nameHashMode)
+{
+  if (nameHashMode == NAME_HASH_TLV) {
+    // Try to encode into a buffer on the stack to avoid allocating.
+    struct ndn_NameComponent nameComponents[100];
+    NameLite nameLite
+      (nameComponents, sizeof(nameComponents) / sizeof(nameComponents[0]));
+    uint8_t buffer[1000];
+    DynamicUInt8ArrayLite output(buffer, sizeof(buffer), 0);
+    size_t dummyBeginOffset, dummyEndOffset, encodingLength;
+    if (name.size() <= sizeof(nameComponents) / sizeof(nameComponents[0])) {
+      name.get(nameLite);
+      if (!Tlv0_3WireFormatLite::encodeName
+          (nameLite, &dummyBeginOffset, &dummyEndOffset, output,
+           &encodingLength))
+        return CryptoLite::murmurHash3
+          (InvertibleBloomLookupTable::N_HASHCHECK, buffer, encodingLength);
+    }
+
+    // The Name is too long for the buffer.
+    Blob encoding = name.wireEncode(*TlvWireFormat::get());
+    return CryptoLite::murmurHash3
+      (InvertibleBloomLookupTable::N_HASHCHECK, encoding.buf(), encoding.size());
+  }
+  else {
+    string uri = name.toUri();
+    return CryptoLite::murmurHash3
+      (InvertibleBloomLookupTable::N_HASHCHECK, uri.data(), uri.size());
+  }
+}
+
+void
+PSyncProducerBase::setNameHashMode(NameHashMode nameHashMode)
+{
+  if (nameHashMode == nameHashMode_)
+    return;
+
+  nameHashMode_ = nameHashMode;
+  if (nameToHash_.size() == 0)
+    return;
+
+  // Re-insert the names with the new hash.
+  vector<Name> names;
+  for (unordered_map<Name, uint32_t, NameHash>::iterator entry =
+         nameToHash_.begin();
+       entry != nameToHash_.end(); ++entry)
+    names.push_back(entry->first);
+
+  nameToHash_.clear();
+  hashToName_.clear();
+  iblt_.reset(new InvertibleBloomLookupTable(expectedNEntries_));
+  for (size_t i = 0; i < names.size(); ++i)
+    insertIntoIblt(names[i]);
+}
+
 void
 PSyncProducerBase::insertIntoIblt(const Name& name)
 {
-  string uri = name.toUri();
-  uint32_t newHash = CryptoLite::murmurHash3
-    (InvertibleBloomLookupTable::N_HASHCHECK, uri.data(), uri.size());
+  uint32_t newHash = hashName(name, nameHashMode_);
   nameToHash_[name] = newHash;
   hashToName_[newHash] = name;
   iblt_->insert(newHash);
@@ -60,7 +117,7 @@ PSyncProducerBase::insertIntoIblt(const Name& name)
 void
 PSyncProducerBase::removeFromIblt(const Name& name)
 {
-  map<Name, uint32_t>::iterator hashEntry = nameToHash_.find(name);
+  unordered_map<Name, uint32_t, NameHash>::iterator hashEntry = nameToHash_.find(name);
   if (hashEntry != nameToHash_.end()) {
     uint32_t hash = hashEntry->second;
     nameToHash_.erase(hashEntry);
@@ -0,0 +1,346 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include <stdexcept>
+#include "../encoding/tlv-encoder.hpp"
+#include "../encoding/tlv-decoder.hpp"
+#include "sync-state-codec.hpp"
+
+using namespace std;
+
+namespace ndn {
+
+// The field numbers and wire types from sync-state.proto.
+enum {
+  PROTOBUF_WIRE_VARINT = 0,
+  PROTOBUF_WIRE_FIXED64 = 1,
+  PROTOBUF_WIRE_LENGTH_DELIMITED = 2,
+  PROTOBUF_WIRE_FIXED32 = 5,
+
+  PROTOBUF_SYNC_STATE_MSG_SS = 1,
+  PROTOBUF_SYNC_STATE_NAME = 1,
+  PROTOBUF_SYNC_STATE_TYPE = 2,
+  PROTOBUF_SYNC_STATE_SEQNO = 3,
+  PROTOBUF_SYNC_STATE_APPLICATION_INFO = 4,
+  PROTOBUF_SEQNO_SEQ = 1,
+  PROTOBUF_SEQNO_SESSION = 2,
+
+  PROTOBUF_ACTION_TYPE_UPDATE = 0
+};
+
+static size_t
+getVarintSize(uint64_t value)
+{
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+
+  return size;
+}
+
+static void
+writeVarint(uint64_t value, vector<uint8_t>& output)
+{
+  while (value >= 0x80) {
+    output.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  output.push_back((uint8_t)value);
+}
+
+static void
+writeKey(int fieldNumber, int wireType, vector<uint8_t>& output)
+{
+  writeVarint((uint64_t)((fieldNumber << 3) | wireType), output);
+}
+
+/**
+ * Read a varint at offset in input and advance offset.
+ * @throws runtime_error if the varint goes past end or is too long.
+ */
+static uint64_t
+readVarint(const uint8_t *input, size_t end, size_t& offset)
+{
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (offset >= end)
+      throw runtime_error("SyncStateCodec: Protobuf varint goes past the end");
+
+    uint8_t b = input[offset++];
+    value |= (uint64_t)(b & 0x7f) << shift;
+    if ((b & 0x80) == 0)
+      return value;
+  }
+
+  throw runtime_error("SyncStateCodec: Protobuf varint is too long");
+}
+
+/**
+ * Read the length of a length-delimited field at offset and advance offset.
+ * @return The end offset of the field value.
+ */
+static size_t
+readLengthDelimited(const uint8_t *input, size_t end, size_t& offset)
+{
+  uint64_t length = readVarint(input, end, offset);
+  if (length > end - offset)
+    throw runtime_error
+      ("SyncStateCodec: Protobuf length-delimited field goes past the end");
+
+  return offset + (size_t)length;
+}
+
+/**
+ * Skip the value of a field with the wireType which we don't use.
+ */
+static void
+skipField(int wireType, const uint8_t *input, size_t end, size_t& offset)
+{
+  size_t length;
+  if (wireType == PROTOBUF_WIRE_VARINT) {
+    readVarint(input, end, offset);
+    return;
+  }
+  else if (wireType == PROTOBUF_WIRE_LENGTH_DELIMITED) {
+    offset = readLengthDelimited(input, end, offset);
+    return;
+  }
+  else if (wireType == PROTOBUF_WIRE_FIXED64)
+    length = 8;
+  else if (wireType == PROTOBUF_WIRE_FIXED32)
+    length = 4;
+  else
+    throw runtime_error("SyncStateCodec: Unsupported Protobuf wire type");
+
+  if (length > end - offset)
+    throw runtime_error("SyncStateCodec: Protobuf field goes past the end");
+  offset += length;
+}
+
+Blob
+SyncStateCodec::encodeProtobuf
+  (const vector<ChronoSync2013::SyncState>& syncStates)
+{
+  // Write the fields in field number order the same as the Protobuf library.
+  ptr_lib::shared_ptr<vector<uint8_t> > output(new vector<uint8_t>());
+  for (size_t i = 0; i < syncStates.size(); ++i) {
+    const ChronoSync2013::SyncState& syncState = syncStates[i];
+    // Protobuf stores the int as uint64.
+    uint64_t seq = (uint64_t)(int64_t)syncState.getSequenceNo();
+    uint64_t session = (uint64_t)(int64_t)syncState.getSessionNo();
+    const string& name = syncState.getDataPrefix();
+    const Blob& applicationInfo = syncState.getApplicationInfo();
+    bool hasApplicationInfo =
+      (!applicationInfo.isNull() && applicationInfo.size() > 0);
+
+    size_t seqnoSize = 1 + getVarintSize(seq) + 1 + getVarintSize(session);
+    size_t syncStateSize =
+      1 + getVarintSize(name.size()) + name.size() +
+      1 + getVarintSize(PROTOBUF_ACTION_TYPE_UPDATE) +
+      1 + getVarintSize(seqnoSize) + seqnoSize;
+    if (hasApplicationInfo)
+      syncStateSize += 1 + getVarintSize(applicationInfo.size()) +
+        applicationInfo.size();
+
+    writeKey(PROTOBUF_SYNC_STATE_MSG_SS, PROTOBUF_WIRE_LENGTH_DELIMITED, *output);
+    writeVarint(syncStateSize, *output);
+
+    writeKey(PROTOBUF_SYNC_STATE_NAME, PROTOBUF_WIRE_LENGTH_DELIMITED, *output);
+    writeVarint(name.size(), *output);
+    output->insert(output->end(), name.begin(), name.end());
+
+    writeKey(PROTOBUF_SYNC_STATE_TYPE, PROTOBUF_WIRE_VARINT, *output);
+    writeVarint(PROTOBUF_ACTION_TYPE_UPDATE, *output);
+
+    writeKey(PROTOBUF_SYNC_STATE_SEQNO, PROTOBUF_WIRE_LENGTH_DELIMITED, *output);
+    writeVarint(seqnoSize, *output);
+    writeKey(PROTOBUF_SEQNO_SEQ, PROTOBUF_WIRE_VARINT, *output);
+    writeVarint(seq, *output);
+    writeKey(PROTOBUF_SEQNO_SESSION, PROTOBUF_WIRE_VARINT, *output);
+    writeVarint(session, *output);
+
+    if (hasApplicationInfo) {
+      writeKey
+        (PROTOBUF_SYNC_STATE_APPLICATION_INFO, PROTOBUF_WIRE_LENGTH_DELIMITED,
+         *output);
+      writeVarint(applicationInfo.size(), *output);
+      output->insert
+        (output->end(), applicationInfo.buf(),
+         applicationInfo.buf() + applicationInfo.size());
+    }
+  }
+
+  return Blob(output, false);
+}
+
+Blob
+SyncStateCodec::encodeTlv(const vector<ChronoSync2013::SyncState>& syncStates)
+{
+  // Encode directly as TLV. We don't support the WireFormat abstraction
+  // because this isn't meant to go directly on the wire.
+  TlvEncoder encoder(256);
+
+  encoder.writeNestedTlv(Tlv_SyncStateMessage, encodeSyncStates, &syncStates);
+
+  return encoder.finish();
+}
+
+void
+SyncStateCodec::encodeSyncStates(const void *context, TlvEncoder &encoder)
+{
+  const vector<ChronoSync2013::SyncState>& syncStates =
+    *(const vector<ChronoSync2013::SyncState> *)context;
+
+  for (size_t i = 0; i < syncStates.size(); ++i)
+    encoder.writeNestedTlv(Tlv_SyncState, encodeSyncState, &syncStates[i]);
+}
+
+void
+SyncStateCodec::encodeSyncState(const void *context, TlvEncoder &encoder)
+{
+  const ChronoSync2013::SyncState& syncState =
+    *(const ChronoSync2013::SyncState *)context;
+
+  encoder.writeRawStringTlv(Tlv_DataPrefix, syncState.getDataPrefix());
+  encoder.writeNonNegativeIntegerTlv
+    (Tlv_SessionNo, (uint64_t)(int64_t)syncState.getSessionNo());
+  encoder.writeNonNegativeIntegerTlv
+    (Tlv_SequenceNo, (uint64_t)(int64_t)syncState.getSequenceNo());
+  const Blob& applicationInfo = syncState.getApplicationInfo();
+  if (!applicationInfo.isNull() && applicationInfo.size() > 0)
+    encoder.writeBlobTlv(Tlv_ApplicationInfo, applicationInfo);
+}
+
+void
+SyncStateCodec::decode
+  (const uint8_t *input, size_t inputLength,
+   vector<ChronoSync2013::SyncState>& syncStates)
+{
+  if (isTlv(input, inputLength))
+    decodeTlv(input, inputLength, syncStates);
+  else
+    decodeProtobuf(input, inputLength, syncStates);
+}
+
+void
+SyncStateCodec::decodeProtobuf
+  (const uint8_t *input, size_t inputLength,
+   vector<ChronoSync2013::SyncState>& syncStates)
+{
+  size_t offset = 0;
+  while (offset < inputLength) {
+    uint64_t key = readVarint(input, inputLength, offset);
+    int wireType = (int)(key & 7);
+    if (!((key >> 3) == PROTOBUF_SYNC_STATE_MSG_SS &&
+          wireType == PROTOBUF_WIRE_LENGTH_DELIMITED)) {
+      skipField(wireType, input, inputLength, offset);
+      continue;
+    }
+
+    // Decode the SyncState.
+    size_t syncStateEnd = readLengthDelimited(input, inputLength, offset);
+    string name;
+    uint64_t type = PROTOBUF_ACTION_TYPE_UPDATE;
+    uint64_t seq = 0;
+    uint64_t session = 0;
+    Blob applicationInfo;
+    while (offset < syncStateEnd) {
+      key = readVarint(input, syncStateEnd, offset);
+      uint64_t fieldNumber = key >> 3;
+      wireType = (int)(key & 7);
+
+      if (fieldNumber == PROTOBUF_SYNC_STATE_NAME &&
+          wireType == PROTOBUF_WIRE_LENGTH_DELIMITED) {
+        size_t end = readLengthDelimited(input, syncStateEnd, offset);
+        name.assign((const char*)input + offset, end - offset);
+        offset = end;
+      }
+      else if (fieldNumber == PROTOBUF_SYNC_STATE_TYPE &&
+               wireType == PROTOBUF_WIRE_VARINT)
+        type = readVarint(input, syncStateEnd, offset);
+      else if (fieldNumber == PROTOBUF_SYNC_STATE_SEQNO &&
+               wireType == PROTOBUF_WIRE_LENGTH_DELIMITED) {
+        size_t seqnoEnd = readLengthDelimited(input, syncStateEnd, offset);
+        while (offset < seqnoEnd) {
+          key = readVarint(input, seqnoEnd, offset);
+          wireType = (int)(key & 7);
+          if ((key >> 3) == PROTOBUF_SEQNO_SEQ &&
+              wireType == PROTOBUF_WIRE_VARINT)
+            seq = readVarint(input, seqnoEnd, offset);
+          else if ((key >> 3) == PROTOBUF_SEQNO_SESSION &&
+                   wireType == PROTOBUF_WIRE_VARINT)
+            session = readVarint(input, seqnoEnd, offset);
+          else
+            skipField(wireType, input, seqnoEnd, offset);
+        }
+      }
+      else if (fieldNumber == PROTOBUF_SYNC_STATE_APPLICATION_INFO &&
+               wireType == PROTOBUF_WIRE_LENGTH_DELIMITED) {
+        size_t end = readLengthDelimited(input, syncStateEnd, offset);
+        if (end > offset)
+          applicationInfo = Blob(input + offset, end - offset);
+        offset = end;
+      }
+      else
+        skipField(wireType, input, syncStateEnd, offset);
+    }
+
+    if (type == PROTOBUF_ACTION_TYPE_UPDATE)
+      syncStates.push_back(ChronoSync2013::SyncState
+        (name, (int)session, (int)seq, applicationInfo));
+  }
+}
+
+void
+SyncStateCodec::decodeTlv
+  (const uint8_t *input, size_t inputLength,
+   vector<ChronoSync2013::SyncState>& syncStates)
+{
+  // Decode directly as TLV. We don't support the WireFormat abstraction
+  // because this isn't meant to go directly on the wire.
+  TlvDecoder decoder(input, inputLength);
+  size_t endOffset = decoder.readNestedTlvsStart(Tlv_SyncStateMessage);
+
+  while (decoder.offset < endOffset) {
+    size_t syncStateEndOffset = decoder.readNestedTlvsStart(Tlv_SyncState);
+
+    ndn_Blob dataPrefix = decoder.readBlobTlv(Tlv_DataPrefix);
+    int sessionNo = (int)decoder.readNonNegativeIntegerTlv(Tlv_SessionNo);
+    int sequenceNo = (int)decoder.readNonNegativeIntegerTlv(Tlv_SequenceNo);
+    Blob applicationInfo;
+    if (decoder.peekType(Tlv_ApplicationInfo, syncStateEndOffset)) {
+      ndn_Blob value = decoder.readBlobTlv(Tlv_ApplicationInfo);
+      if (value.length > 0)
+        applicationInfo = Blob(value.value, value.length);
+    }
+
+    decoder.finishNestedTlvs(syncStateEndOffset);
+    syncStates.push_back(ChronoSync2013::SyncState
+      (string((const char*)dataPrefix.value, dataPrefix.length), sessionNo,
+       sequenceNo, applicationInfo));
+  }
+
+  decoder.finishNestedTlvs(endOffset);
+}
+
+}
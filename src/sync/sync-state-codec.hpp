@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_SYNC_STATE_CODEC_HPP
+#define NDN_SYNC_STATE_CODEC_HPP
+
+#include <vector>
+#include <ndn-cpp/sync/chrono-sync2013.hpp>
+
+namespace ndn {
+
+class TlvEncoder;
+
+/**
+ * SyncStateCodec has static methods to encode and decode the list of sync
+ * states in a ChronoSync2013 sync Data packet. The Protobuf encoding is the
+ * SyncStateMsg from sync-state.proto which is used by other ChronoSync
+ * libraries, but is written directly so that we don't need the Protobuf
+ * library. The TLV encoding is a more compact NDN-TLV SyncStateMessage. decode
+ * detects the encoding so that a receiver accepts both.
+ */
+class SyncStateCodec {
+public:
+  /**
+   * Encode the sync states as a Protobuf SyncStateMsg where each SyncState
+   * has type UPDATE.
+   * @param syncStates The sync states to encode.
+   * @return The encoding as a Blob.
+   */
+  static Blob
+  encodeProtobuf(const std::vector<ChronoSync2013::SyncState>& syncStates);
+
+  /**
+   * Encode the sync states as an NDN-TLV SyncStateMessage.
+   * @param syncStates The sync states to encode.
+   * @return The encoding as a Blob.
+   */
+  static Blob
+  encodeTlv(const std::vector<ChronoSync2013::SyncState>& syncStates);
+
+  /**
+   * Decode the input as a Protobuf SyncStateMsg or an NDN-TLV
+   * SyncStateMessage, depending on its first byte, and append the UPDATE sync
+   * states to syncStates. A Protobuf SyncState with another type is skipped.
+   * @param input A pointer to the input buffer to decode.
+   * @param inputLength The number of bytes in input.
+   * @param syncStates Append the decoded sync states to this list.
+   * @throws runtime_error for a decoding error.
+   */
+  static void
+  decode
+    (const uint8_t *input, size_t inputLength,
+     std::vector<ChronoSync2013::SyncState>& syncStates);
+
+  /**
+   * Check if the input is an NDN-TLV SyncStateMessage. Otherwise, decode
+   * treats it as a Protobuf SyncStateMsg.
+   * @param input A pointer to the input buffer.
+   * @param inputLength The number of bytes in input.
+   * @return True if the input is TLV.
+   */
+  static bool
+  isTlv(const uint8_t *input, size_t inputLength)
+  {
+    return inputLength > 0 && input[0] == Tlv_SyncStateMessage;
+  }
+
+  enum {
+    Tlv_SyncStateMessage = 129,
+    Tlv_SyncState =        130,
+    Tlv_DataPrefix =       131,
+    Tlv_SessionNo =        132,
+    Tlv_SequenceNo =       133,
+    Tlv_ApplicationInfo =  134
+  };
+
+private:
+  static void
+  decodeProtobuf
+    (const uint8_t *input, size_t inputLength,
+     std::vector<ChronoSync2013::SyncState>& syncStates);
+
+  static void
+  decodeTlv
+    (const uint8_t *input, size_t inputLength,
+     std::vector<ChronoSync2013::SyncState>& syncStates);
+
+  /**
+   * This is called by writeNestedTlv to encode the list of SyncState.
+   * @param context A pointer to the vector of ChronoSync2013::SyncState.
+   * @param encoder The TlvEncoder.
+   */
+  static void
+  encodeSyncStates(const void *context, TlvEncoder &encoder);
+
+  /**
+   * This is called by writeNestedTlv to encode one SyncState.
+   * @param context A pointer to the ChronoSync2013::SyncState.
+   * @param encoder The TlvEncoder.
+   */
+  static void
+  encodeSyncState(const void *context, TlvEncoder &encoder);
+};
+
+}
+
+#endif
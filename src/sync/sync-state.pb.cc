@@ -0,0 +1,1018 @@
+// Generated by the protocol buffer compiler.  DO NOT EDIT!
+// source: sync-state.proto
+
+#include "sync-state.pb.h"
+
+#include <algorithm>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/extension_set.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/generated_message_reflection.h>
+#include <google/protobuf/reflection_ops.h>
+#include <google/protobuf/wire_format.h>
+// @@protoc_insertion_point(includes)
+#include <google/protobuf/port_def.inc>
+
+PROTOBUF_PRAGMA_INIT_SEG
+
+namespace _pb = ::PROTOBUF_NAMESPACE_ID;
+namespace _pbi = _pb::internal;
+
+namespace Sync {
+PROTOBUF_CONSTEXPR SyncState_SeqNo::SyncState_SeqNo(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.seq_)*/uint64_t{0u}
+  , /*decltype(_impl_.session_)*/uint64_t{0u}} {}
+struct SyncState_SeqNoDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR SyncState_SeqNoDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~SyncState_SeqNoDefaultTypeInternal() {}
+  union {
+    SyncState_SeqNo _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 SyncState_SeqNoDefaultTypeInternal _SyncState_SeqNo_default_instance_;
+PROTOBUF_CONSTEXPR SyncState::SyncState(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_._has_bits_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}
+  , /*decltype(_impl_.name_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.application_info_)*/{&::_pbi::fixed_address_empty_string, ::_pbi::ConstantInitialized{}}
+  , /*decltype(_impl_.seqno_)*/nullptr
+  , /*decltype(_impl_.type_)*/0} {}
+struct SyncStateDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR SyncStateDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~SyncStateDefaultTypeInternal() {}
+  union {
+    SyncState _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 SyncStateDefaultTypeInternal _SyncState_default_instance_;
+PROTOBUF_CONSTEXPR SyncStateMsg::SyncStateMsg(
+    ::_pbi::ConstantInitialized): _impl_{
+    /*decltype(_impl_.ss_)*/{}
+  , /*decltype(_impl_._cached_size_)*/{}} {}
+struct SyncStateMsgDefaultTypeInternal {
+  PROTOBUF_CONSTEXPR SyncStateMsgDefaultTypeInternal()
+      : _instance(::_pbi::ConstantInitialized{}) {}
+  ~SyncStateMsgDefaultTypeInternal() {}
+  union {
+    SyncStateMsg _instance;
+  };
+};
+PROTOBUF_ATTRIBUTE_NO_DESTROY PROTOBUF_CONSTINIT PROTOBUF_ATTRIBUTE_INIT_PRIORITY1 SyncStateMsgDefaultTypeInternal _SyncStateMsg_default_instance_;
+}  // namespace Sync
+static ::_pb::Metadata file_level_metadata_sync_2dstate_2eproto[3];
+static const ::_pb::EnumDescriptor* file_level_enum_descriptors_sync_2dstate_2eproto[1];
+static constexpr ::_pb::ServiceDescriptor const** file_level_service_descriptors_sync_2dstate_2eproto = nullptr;
+
+const uint32_t TableStruct_sync_2dstate_2eproto::offsets[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState_SeqNo, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState_SeqNo, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState_SeqNo, _impl_.seq_),
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState_SeqNo, _impl_.session_),
+  0,
+  1,
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState, _impl_._has_bits_),
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState, _impl_.name_),
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState, _impl_.type_),
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState, _impl_.seqno_),
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncState, _impl_.application_info_),
+  0,
+  3,
+  2,
+  1,
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncStateMsg, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  ~0u,  // no _inlined_string_donated_
+  PROTOBUF_FIELD_OFFSET(::Sync::SyncStateMsg, _impl_.ss_),
+};
+static const ::_pbi::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
+  { 0, 8, -1, sizeof(::Sync::SyncState_SeqNo)},
+  { 10, 20, -1, sizeof(::Sync::SyncState)},
+  { 24, -1, -1, sizeof(::Sync::SyncStateMsg)},
+};
+
+static const ::_pb::Message* const file_default_instances[] = {
+  &::Sync::_SyncState_SeqNo_default_instance_._instance,
+  &::Sync::_SyncState_default_instance_._instance,
+  &::Sync::_SyncStateMsg_default_instance_._instance,
+};
+
+const char descriptor_table_protodef_sync_2dstate_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
+  "\n\020sync-state.proto\022\004Sync\"\333\001\n\tSyncState\022\014"
+  "\n\004name\030\001 \002(\t\022(\n\004type\030\002 \002(\0162\032.Sync.SyncSt"
+  "ate.ActionType\022$\n\005seqno\030\003 \001(\0132\025.Sync.Syn"
+  "cState.SeqNo\022\030\n\020application_info\030\004 \001(\014\032%"
+  "\n\005SeqNo\022\013\n\003seq\030\001 \002(\004\022\017\n\007session\030\002 \002(\004\"/\n"
+  "\nActionType\022\n\n\006UPDATE\020\000\022\n\n\006DELETE\020\001\022\t\n\005O"
+  "THER\020\002\"+\n\014SyncStateMsg\022\033\n\002ss\030\001 \003(\0132\017.Syn"
+  "c.SyncState"
+  ;
+static ::_pbi::once_flag descriptor_table_sync_2dstate_2eproto_once;
+const ::_pbi::DescriptorTable descriptor_table_sync_2dstate_2eproto = {
+    false, false, 291, descriptor_table_protodef_sync_2dstate_2eproto,
+    "sync-state.proto",
+    &descriptor_table_sync_2dstate_2eproto_once, nullptr, 0, 3,
+    schemas, file_default_instances, TableStruct_sync_2dstate_2eproto::offsets,
+    file_level_metadata_sync_2dstate_2eproto, file_level_enum_descriptors_sync_2dstate_2eproto,
+    file_level_service_descriptors_sync_2dstate_2eproto,
+};
+PROTOBUF_ATTRIBUTE_WEAK const ::_pbi::DescriptorTable* descriptor_table_sync_2dstate_2eproto_getter() {
+  return &descriptor_table_sync_2dstate_2eproto;
+}
+
+// Force running AddDescriptors() at dynamic initialization time.
+PROTOBUF_ATTRIBUTE_INIT_PRIORITY2 static ::_pbi::AddDescriptorsRunner dynamic_init_dummy_sync_2dstate_2eproto(&descriptor_table_sync_2dstate_2eproto);
+namespace Sync {
+const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* SyncState_ActionType_descriptor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&descriptor_table_sync_2dstate_2eproto);
+  return file_level_enum_descriptors_sync_2dstate_2eproto[0];
+}
+bool SyncState_ActionType_IsValid(int value) {
+  switch (value) {
+    case 0:
+    case 1:
+    case 2:
+      return true;
+    default:
+      return false;
+  }
+}
+
+#if (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
+constexpr SyncState_ActionType SyncState::UPDATE;
+constexpr SyncState_ActionType SyncState::DELETE;
+constexpr SyncState_ActionType SyncState::OTHER;
+constexpr SyncState_ActionType SyncState::ActionType_MIN;
+constexpr SyncState_ActionType SyncState::ActionType_MAX;
+constexpr int SyncState::ActionType_ARRAYSIZE;
+#endif  // (__cplusplus < 201703) && (!defined(_MSC_VER) || (_MSC_VER >= 1900 && _MSC_VER < 1912))
+
+// ===================================================================
+
+class SyncState_SeqNo::_Internal {
+ public:
+  using HasBits = decltype(std::declval<SyncState_SeqNo>()._impl_._has_bits_);
+  static void set_has_seq(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_session(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static bool MissingRequiredFields(const HasBits& has_bits) {
+    return ((has_bits[0] & 0x00000003) ^ 0x00000003) != 0;
+  }
+};
+
+SyncState_SeqNo::SyncState_SeqNo(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:Sync.SyncState.SeqNo)
+}
+SyncState_SeqNo::SyncState_SeqNo(const SyncState_SeqNo& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  SyncState_SeqNo* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.seq_){}
+    , decltype(_impl_.session_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  ::memcpy(&_impl_.seq_, &from._impl_.seq_,
+    static_cast<size_t>(reinterpret_cast<char*>(&_impl_.session_) -
+    reinterpret_cast<char*>(&_impl_.seq_)) + sizeof(_impl_.session_));
+  // @@protoc_insertion_point(copy_constructor:Sync.SyncState.SeqNo)
+}
+
+inline void SyncState_SeqNo::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.seq_){uint64_t{0u}}
+    , decltype(_impl_.session_){uint64_t{0u}}
+  };
+}
+
+SyncState_SeqNo::~SyncState_SeqNo() {
+  // @@protoc_insertion_point(destructor:Sync.SyncState.SeqNo)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void SyncState_SeqNo::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+}
+
+void SyncState_SeqNo::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void SyncState_SeqNo::Clear() {
+// @@protoc_insertion_point(message_clear_start:Sync.SyncState.SeqNo)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    ::memset(&_impl_.seq_, 0, static_cast<size_t>(
+        reinterpret_cast<char*>(&_impl_.session_) -
+        reinterpret_cast<char*>(&_impl_.seq_)) + sizeof(_impl_.session_));
+  }
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* SyncState_SeqNo::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // required uint64 seq = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 8)) {
+          _Internal::set_has_seq(&has_bits);
+          _impl_.seq_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // required uint64 session = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          _Internal::set_has_session(&has_bits);
+          _impl_.session_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* SyncState_SeqNo::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:Sync.SyncState.SeqNo)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  // required uint64 seq = 1;
+  if (cached_has_bits & 0x00000001u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt64ToArray(1, this->_internal_seq(), target);
+  }
+
+  // required uint64 session = 2;
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteUInt64ToArray(2, this->_internal_session(), target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:Sync.SyncState.SeqNo)
+  return target;
+}
+
+size_t SyncState_SeqNo::RequiredFieldsByteSizeFallback() const {
+// @@protoc_insertion_point(required_fields_byte_size_fallback_start:Sync.SyncState.SeqNo)
+  size_t total_size = 0;
+
+  if (_internal_has_seq()) {
+    // required uint64 seq = 1;
+    total_size += ::_pbi::WireFormatLite::UInt64SizePlusOne(this->_internal_seq());
+  }
+
+  if (_internal_has_session()) {
+    // required uint64 session = 2;
+    total_size += ::_pbi::WireFormatLite::UInt64SizePlusOne(this->_internal_session());
+  }
+
+  return total_size;
+}
+size_t SyncState_SeqNo::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:Sync.SyncState.SeqNo)
+  size_t total_size = 0;
+
+  if (((_impl_._has_bits_[0] & 0x00000003) ^ 0x00000003) == 0) {  // All required fields are present.
+    // required uint64 seq = 1;
+    total_size += ::_pbi::WireFormatLite::UInt64SizePlusOne(this->_internal_seq());
+
+    // required uint64 session = 2;
+    total_size += ::_pbi::WireFormatLite::UInt64SizePlusOne(this->_internal_session());
+
+  } else {
+    total_size += RequiredFieldsByteSizeFallback();
+  }
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData SyncState_SeqNo::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    SyncState_SeqNo::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*SyncState_SeqNo::GetClassData() const { return &_class_data_; }
+
+
+void SyncState_SeqNo::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<SyncState_SeqNo*>(&to_msg);
+  auto& from = static_cast<const SyncState_SeqNo&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:Sync.SyncState.SeqNo)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000003u) {
+    if (cached_has_bits & 0x00000001u) {
+      _this->_impl_.seq_ = from._impl_.seq_;
+    }
+    if (cached_has_bits & 0x00000002u) {
+      _this->_impl_.session_ = from._impl_.session_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void SyncState_SeqNo::CopyFrom(const SyncState_SeqNo& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:Sync.SyncState.SeqNo)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool SyncState_SeqNo::IsInitialized() const {
+  if (_Internal::MissingRequiredFields(_impl_._has_bits_)) return false;
+  return true;
+}
+
+void SyncState_SeqNo::InternalSwap(SyncState_SeqNo* other) {
+  using std::swap;
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(SyncState_SeqNo, _impl_.session_)
+      + sizeof(SyncState_SeqNo::_impl_.session_)
+      - PROTOBUF_FIELD_OFFSET(SyncState_SeqNo, _impl_.seq_)>(
+          reinterpret_cast<char*>(&_impl_.seq_),
+          reinterpret_cast<char*>(&other->_impl_.seq_));
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata SyncState_SeqNo::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_sync_2dstate_2eproto_getter, &descriptor_table_sync_2dstate_2eproto_once,
+      file_level_metadata_sync_2dstate_2eproto[0]);
+}
+
+// ===================================================================
+
+class SyncState::_Internal {
+ public:
+  using HasBits = decltype(std::declval<SyncState>()._impl_._has_bits_);
+  static void set_has_name(HasBits* has_bits) {
+    (*has_bits)[0] |= 1u;
+  }
+  static void set_has_type(HasBits* has_bits) {
+    (*has_bits)[0] |= 8u;
+  }
+  static const ::Sync::SyncState_SeqNo& seqno(const SyncState* msg);
+  static void set_has_seqno(HasBits* has_bits) {
+    (*has_bits)[0] |= 4u;
+  }
+  static void set_has_application_info(HasBits* has_bits) {
+    (*has_bits)[0] |= 2u;
+  }
+  static bool MissingRequiredFields(const HasBits& has_bits) {
+    return ((has_bits[0] & 0x00000009) ^ 0x00000009) != 0;
+  }
+};
+
+const ::Sync::SyncState_SeqNo&
+SyncState::_Internal::seqno(const SyncState* msg) {
+  return *msg->_impl_.seqno_;
+}
+SyncState::SyncState(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:Sync.SyncState)
+}
+SyncState::SyncState(const SyncState& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  SyncState* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){from._impl_._has_bits_}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.name_){}
+    , decltype(_impl_.application_info_){}
+    , decltype(_impl_.seqno_){nullptr}
+    , decltype(_impl_.type_){}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  _impl_.name_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.name_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_name()) {
+    _this->_impl_.name_.Set(from._internal_name(), 
+      _this->GetArenaForAllocation());
+  }
+  _impl_.application_info_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.application_info_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  if (from._internal_has_application_info()) {
+    _this->_impl_.application_info_.Set(from._internal_application_info(), 
+      _this->GetArenaForAllocation());
+  }
+  if (from._internal_has_seqno()) {
+    _this->_impl_.seqno_ = new ::Sync::SyncState_SeqNo(*from._impl_.seqno_);
+  }
+  _this->_impl_.type_ = from._impl_.type_;
+  // @@protoc_insertion_point(copy_constructor:Sync.SyncState)
+}
+
+inline void SyncState::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_._has_bits_){}
+    , /*decltype(_impl_._cached_size_)*/{}
+    , decltype(_impl_.name_){}
+    , decltype(_impl_.application_info_){}
+    , decltype(_impl_.seqno_){nullptr}
+    , decltype(_impl_.type_){0}
+  };
+  _impl_.name_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.name_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+  _impl_.application_info_.InitDefault();
+  #ifdef PROTOBUF_FORCE_COPY_DEFAULT_STRING
+    _impl_.application_info_.Set("", GetArenaForAllocation());
+  #endif // PROTOBUF_FORCE_COPY_DEFAULT_STRING
+}
+
+SyncState::~SyncState() {
+  // @@protoc_insertion_point(destructor:Sync.SyncState)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void SyncState::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.name_.Destroy();
+  _impl_.application_info_.Destroy();
+  if (this != internal_default_instance()) delete _impl_.seqno_;
+}
+
+void SyncState::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void SyncState::Clear() {
+// @@protoc_insertion_point(message_clear_start:Sync.SyncState)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000007u) {
+    if (cached_has_bits & 0x00000001u) {
+      _impl_.name_.ClearNonDefaultToEmpty();
+    }
+    if (cached_has_bits & 0x00000002u) {
+      _impl_.application_info_.ClearNonDefaultToEmpty();
+    }
+    if (cached_has_bits & 0x00000004u) {
+      GOOGLE_DCHECK(_impl_.seqno_ != nullptr);
+      _impl_.seqno_->Clear();
+    }
+  }
+  _impl_.type_ = 0;
+  _impl_._has_bits_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* SyncState::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  _Internal::HasBits has_bits{};
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // required string name = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 10)) {
+          auto str = _internal_mutable_name();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+          #ifndef NDEBUG
+          ::_pbi::VerifyUTF8(str, "Sync.SyncState.name");
+          #endif  // !NDEBUG
+        } else
+          goto handle_unusual;
+        continue;
+      // required .Sync.SyncState.ActionType type = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 16)) {
+          uint64_t val = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint64(&ptr);
+          CHK_(ptr);
+          if (PROTOBUF_PREDICT_TRUE(::Sync::SyncState_ActionType_IsValid(val))) {
+            _internal_set_type(static_cast<::Sync::SyncState_ActionType>(val));
+          } else {
+            ::PROTOBUF_NAMESPACE_ID::internal::WriteVarint(2, val, mutable_unknown_fields());
+          }
+        } else
+          goto handle_unusual;
+        continue;
+      // optional .Sync.SyncState.SeqNo seqno = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 26)) {
+          ptr = ctx->ParseMessage(_internal_mutable_seqno(), ptr);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      // optional bytes application_info = 4;
+      case 4:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 34)) {
+          auto str = _internal_mutable_application_info();
+          ptr = ::_pbi::InlineGreedyStringParser(str, ptr, ctx);
+          CHK_(ptr);
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  _impl_._has_bits_.Or(has_bits);
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* SyncState::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:Sync.SyncState)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  // required string name = 1;
+  if (cached_has_bits & 0x00000001u) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::VerifyUTF8StringNamedField(
+      this->_internal_name().data(), static_cast<int>(this->_internal_name().length()),
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SERIALIZE,
+      "Sync.SyncState.name");
+    target = stream->WriteStringMaybeAliased(
+        1, this->_internal_name(), target);
+  }
+
+  // required .Sync.SyncState.ActionType type = 2;
+  if (cached_has_bits & 0x00000008u) {
+    target = stream->EnsureSpace(target);
+    target = ::_pbi::WireFormatLite::WriteEnumToArray(
+      2, this->_internal_type(), target);
+  }
+
+  // optional .Sync.SyncState.SeqNo seqno = 3;
+  if (cached_has_bits & 0x00000004u) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+      InternalWriteMessage(3, _Internal::seqno(this),
+        _Internal::seqno(this).GetCachedSize(), target, stream);
+  }
+
+  // optional bytes application_info = 4;
+  if (cached_has_bits & 0x00000002u) {
+    target = stream->WriteBytesMaybeAliased(
+        4, this->_internal_application_info(), target);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:Sync.SyncState)
+  return target;
+}
+
+size_t SyncState::RequiredFieldsByteSizeFallback() const {
+// @@protoc_insertion_point(required_fields_byte_size_fallback_start:Sync.SyncState)
+  size_t total_size = 0;
+
+  if (_internal_has_name()) {
+    // required string name = 1;
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+        this->_internal_name());
+  }
+
+  if (_internal_has_type()) {
+    // required .Sync.SyncState.ActionType type = 2;
+    total_size += 1 +
+      ::_pbi::WireFormatLite::EnumSize(this->_internal_type());
+  }
+
+  return total_size;
+}
+size_t SyncState::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:Sync.SyncState)
+  size_t total_size = 0;
+
+  if (((_impl_._has_bits_[0] & 0x00000009) ^ 0x00000009) == 0) {  // All required fields are present.
+    // required string name = 1;
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::StringSize(
+        this->_internal_name());
+
+    // required .Sync.SyncState.ActionType type = 2;
+    total_size += 1 +
+      ::_pbi::WireFormatLite::EnumSize(this->_internal_type());
+
+  } else {
+    total_size += RequiredFieldsByteSizeFallback();
+  }
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  cached_has_bits = _impl_._has_bits_[0];
+  if (cached_has_bits & 0x00000006u) {
+    // optional bytes application_info = 4;
+    if (cached_has_bits & 0x00000002u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+          this->_internal_application_info());
+    }
+
+    // optional .Sync.SyncState.SeqNo seqno = 3;
+    if (cached_has_bits & 0x00000004u) {
+      total_size += 1 +
+        ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(
+          *_impl_.seqno_);
+    }
+
+  }
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData SyncState::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    SyncState::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*SyncState::GetClassData() const { return &_class_data_; }
+
+
+void SyncState::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<SyncState*>(&to_msg);
+  auto& from = static_cast<const SyncState&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:Sync.SyncState)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  cached_has_bits = from._impl_._has_bits_[0];
+  if (cached_has_bits & 0x0000000fu) {
+    if (cached_has_bits & 0x00000001u) {
+      _this->_internal_set_name(from._internal_name());
+    }
+    if (cached_has_bits & 0x00000002u) {
+      _this->_internal_set_application_info(from._internal_application_info());
+    }
+    if (cached_has_bits & 0x00000004u) {
+      _this->_internal_mutable_seqno()->::Sync::SyncState_SeqNo::MergeFrom(
+          from._internal_seqno());
+    }
+    if (cached_has_bits & 0x00000008u) {
+      _this->_impl_.type_ = from._impl_.type_;
+    }
+    _this->_impl_._has_bits_[0] |= cached_has_bits;
+  }
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void SyncState::CopyFrom(const SyncState& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:Sync.SyncState)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool SyncState::IsInitialized() const {
+  if (_Internal::MissingRequiredFields(_impl_._has_bits_)) return false;
+  if (_internal_has_seqno()) {
+    if (!_impl_.seqno_->IsInitialized()) return false;
+  }
+  return true;
+}
+
+void SyncState::InternalSwap(SyncState* other) {
+  using std::swap;
+  auto* lhs_arena = GetArenaForAllocation();
+  auto* rhs_arena = other->GetArenaForAllocation();
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  swap(_impl_._has_bits_[0], other->_impl_._has_bits_[0]);
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.name_, lhs_arena,
+      &other->_impl_.name_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr::InternalSwap(
+      &_impl_.application_info_, lhs_arena,
+      &other->_impl_.application_info_, rhs_arena
+  );
+  ::PROTOBUF_NAMESPACE_ID::internal::memswap<
+      PROTOBUF_FIELD_OFFSET(SyncState, _impl_.type_)
+      + sizeof(SyncState::_impl_.type_)
+      - PROTOBUF_FIELD_OFFSET(SyncState, _impl_.seqno_)>(
+          reinterpret_cast<char*>(&_impl_.seqno_),
+          reinterpret_cast<char*>(&other->_impl_.seqno_));
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata SyncState::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_sync_2dstate_2eproto_getter, &descriptor_table_sync_2dstate_2eproto_once,
+      file_level_metadata_sync_2dstate_2eproto[1]);
+}
+
+// ===================================================================
+
+class SyncStateMsg::_Internal {
+ public:
+};
+
+SyncStateMsg::SyncStateMsg(::PROTOBUF_NAMESPACE_ID::Arena* arena,
+                         bool is_message_owned)
+  : ::PROTOBUF_NAMESPACE_ID::Message(arena, is_message_owned) {
+  SharedCtor(arena, is_message_owned);
+  // @@protoc_insertion_point(arena_constructor:Sync.SyncStateMsg)
+}
+SyncStateMsg::SyncStateMsg(const SyncStateMsg& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message() {
+  SyncStateMsg* const _this = this; (void)_this;
+  new (&_impl_) Impl_{
+      decltype(_impl_.ss_){from._impl_.ss_}
+    , /*decltype(_impl_._cached_size_)*/{}};
+
+  _internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+  // @@protoc_insertion_point(copy_constructor:Sync.SyncStateMsg)
+}
+
+inline void SyncStateMsg::SharedCtor(
+    ::_pb::Arena* arena, bool is_message_owned) {
+  (void)arena;
+  (void)is_message_owned;
+  new (&_impl_) Impl_{
+      decltype(_impl_.ss_){arena}
+    , /*decltype(_impl_._cached_size_)*/{}
+  };
+}
+
+SyncStateMsg::~SyncStateMsg() {
+  // @@protoc_insertion_point(destructor:Sync.SyncStateMsg)
+  if (auto *arena = _internal_metadata_.DeleteReturnArena<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>()) {
+  (void)arena;
+    return;
+  }
+  SharedDtor();
+}
+
+inline void SyncStateMsg::SharedDtor() {
+  GOOGLE_DCHECK(GetArenaForAllocation() == nullptr);
+  _impl_.ss_.~RepeatedPtrField();
+}
+
+void SyncStateMsg::SetCachedSize(int size) const {
+  _impl_._cached_size_.Set(size);
+}
+
+void SyncStateMsg::Clear() {
+// @@protoc_insertion_point(message_clear_start:Sync.SyncStateMsg)
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  _impl_.ss_.Clear();
+  _internal_metadata_.Clear<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>();
+}
+
+const char* SyncStateMsg::_InternalParse(const char* ptr, ::_pbi::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    uint32_t tag;
+    ptr = ::_pbi::ReadTag(ptr, &tag);
+    switch (tag >> 3) {
+      // repeated .Sync.SyncState ss = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<uint8_t>(tag) == 10)) {
+          ptr -= 1;
+          do {
+            ptr += 1;
+            ptr = ctx->ParseMessage(_internal_add_ss(), ptr);
+            CHK_(ptr);
+            if (!ctx->DataAvailable(ptr)) break;
+          } while (::PROTOBUF_NAMESPACE_ID::internal::ExpectTag<10>(ptr));
+        } else
+          goto handle_unusual;
+        continue;
+      default:
+        goto handle_unusual;
+    }  // switch
+  handle_unusual:
+    if ((tag == 0) || ((tag & 7) == 4)) {
+      CHK_(ptr);
+      ctx->SetLastTag(tag);
+      goto message_done;
+    }
+    ptr = UnknownFieldParse(
+        tag,
+        _internal_metadata_.mutable_unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(),
+        ptr, ctx);
+    CHK_(ptr != nullptr);
+  }  // while
+message_done:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto message_done;
+#undef CHK_
+}
+
+uint8_t* SyncStateMsg::_InternalSerialize(
+    uint8_t* target, ::PROTOBUF_NAMESPACE_ID::io::EpsCopyOutputStream* stream) const {
+  // @@protoc_insertion_point(serialize_to_array_start:Sync.SyncStateMsg)
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // repeated .Sync.SyncState ss = 1;
+  for (unsigned i = 0,
+      n = static_cast<unsigned>(this->_internal_ss_size()); i < n; i++) {
+    const auto& repfield = this->_internal_ss(i);
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+        InternalWriteMessage(1, repfield, repfield.GetCachedSize(), target, stream);
+  }
+
+  if (PROTOBUF_PREDICT_FALSE(_internal_metadata_.have_unknown_fields())) {
+    target = ::_pbi::WireFormat::InternalSerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(::PROTOBUF_NAMESPACE_ID::UnknownFieldSet::default_instance), target, stream);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:Sync.SyncStateMsg)
+  return target;
+}
+
+size_t SyncStateMsg::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:Sync.SyncStateMsg)
+  size_t total_size = 0;
+
+  uint32_t cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // repeated .Sync.SyncState ss = 1;
+  total_size += 1UL * this->_internal_ss_size();
+  for (const auto& msg : this->_impl_.ss_) {
+    total_size +=
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(msg);
+  }
+
+  return MaybeComputeUnknownFieldsSize(total_size, &_impl_._cached_size_);
+}
+
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData SyncStateMsg::_class_data_ = {
+    ::PROTOBUF_NAMESPACE_ID::Message::CopyWithSourceCheck,
+    SyncStateMsg::MergeImpl
+};
+const ::PROTOBUF_NAMESPACE_ID::Message::ClassData*SyncStateMsg::GetClassData() const { return &_class_data_; }
+
+
+void SyncStateMsg::MergeImpl(::PROTOBUF_NAMESPACE_ID::Message& to_msg, const ::PROTOBUF_NAMESPACE_ID::Message& from_msg) {
+  auto* const _this = static_cast<SyncStateMsg*>(&to_msg);
+  auto& from = static_cast<const SyncStateMsg&>(from_msg);
+  // @@protoc_insertion_point(class_specific_merge_from_start:Sync.SyncStateMsg)
+  GOOGLE_DCHECK_NE(&from, _this);
+  uint32_t cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  _this->_impl_.ss_.MergeFrom(from._impl_.ss_);
+  _this->_internal_metadata_.MergeFrom<::PROTOBUF_NAMESPACE_ID::UnknownFieldSet>(from._internal_metadata_);
+}
+
+void SyncStateMsg::CopyFrom(const SyncStateMsg& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:Sync.SyncStateMsg)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool SyncStateMsg::IsInitialized() const {
+  if (!::PROTOBUF_NAMESPACE_ID::internal::AllAreInitialized(_impl_.ss_))
+    return false;
+  return true;
+}
+
+void SyncStateMsg::InternalSwap(SyncStateMsg* other) {
+  using std::swap;
+  _internal_metadata_.InternalSwap(&other->_internal_metadata_);
+  _impl_.ss_.InternalSwap(&other->_impl_.ss_);
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata SyncStateMsg::GetMetadata() const {
+  return ::_pbi::AssignDescriptors(
+      &descriptor_table_sync_2dstate_2eproto_getter, &descriptor_table_sync_2dstate_2eproto_once,
+      file_level_metadata_sync_2dstate_2eproto[2]);
+}
+
+// @@protoc_insertion_point(namespace_scope)
+}  // namespace Sync
+PROTOBUF_NAMESPACE_OPEN
+template<> PROTOBUF_NOINLINE ::Sync::SyncState_SeqNo*
+Arena::CreateMaybeMessage< ::Sync::SyncState_SeqNo >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Sync::SyncState_SeqNo >(arena);
+}
+template<> PROTOBUF_NOINLINE ::Sync::SyncState*
+Arena::CreateMaybeMessage< ::Sync::SyncState >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Sync::SyncState >(arena);
+}
+template<> PROTOBUF_NOINLINE ::Sync::SyncStateMsg*
+Arena::CreateMaybeMessage< ::Sync::SyncStateMsg >(Arena* arena) {
+  return Arena::CreateMessageInternal< ::Sync::SyncStateMsg >(arena);
+}
+PROTOBUF_NAMESPACE_CLOSE
+
+// @@protoc_insertion_point(global_scope)
+#include <google/protobuf/port_undef.inc>
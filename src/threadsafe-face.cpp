@@ -24,17 +24,127 @@
 #ifdef NDN_CPP_HAVE_BOOST_ASIO
 
 #include <boost/bind.hpp>
+#include <boost/version.hpp>
 #include <boost/move/make_unique.hpp>
+#include <ndn-cpp/util/logging.hpp>
 #include <ndn-cpp/transport/tcp-transport.hpp>
 #include <ndn-cpp/transport/async-tcp-transport.hpp>
 #include <ndn-cpp/transport/async-unix-transport.hpp>
 #include <ndn-cpp/threadsafe-face.hpp>
+#include "impl/submission-queue.hpp"
+#include "impl/asio-delayed-call-table.hpp"
 #include "node.hpp"
 
+INIT_LOGGER("ndn.ThreadsafeFace");
+
 using namespace std;
 
 namespace ndn {
 
+/**
+ * A Submission holds the arguments of a call from an application thread which
+ * ThreadsafeFace processes on the thread of the ioService.
+ */
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+class ThreadsafeFace::Submission : public SubmissionQueue::Entry {
+#else
+class ThreadsafeFace::Submission {
+#endif
+public:
+  virtual
+  ~Submission() {}
+
+  /**
+   * Call the Node method for this submission.
+   * @param node The Node of the face.
+   * @param face The face, used for Interest timeouts, etc.
+   */
+  virtual void
+  process(Node& node, ThreadsafeFace& face) = 0;
+};
+
+class ThreadsafeFace::ExpressInterestSubmission : public Submission {
+public:
+  ExpressInterestSubmission
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interestCopy,
+     const OnData& onData, const OnTimeout& onTimeout,
+     const OnNetworkNack& onNetworkNack, WireFormat& wireFormat)
+  : pendingInterestId_(pendingInterestId), interestCopy_(interestCopy),
+    onData_(onData), onTimeout_(onTimeout), onNetworkNack_(onNetworkNack),
+    wireFormat_(wireFormat)
+  {
+  }
+
+  virtual void
+  process(Node& node, ThreadsafeFace& face)
+  {
+    node.expressInterest
+      (pendingInterestId_, interestCopy_, onData_, onTimeout_, onNetworkNack_,
+       wireFormat_, &face);
+  }
+
+private:
+  uint64_t pendingInterestId_;
+  ptr_lib::shared_ptr<const Interest> interestCopy_;
+  OnData onData_;
+  OnTimeout onTimeout_;
+  OnNetworkNack onNetworkNack_;
+  WireFormat& wireFormat_;
+};
+
+class ThreadsafeFace::CallLaterSubmission : public Submission {
+public:
+  CallLaterSubmission
+    (Milliseconds delayMilliseconds, const Callback& callback)
+  : delayMilliseconds_(delayMilliseconds), callback_(callback)
+  {
+  }
+
+  virtual void
+  process(Node& node, ThreadsafeFace& face)
+  {
+    face.delayedCallTable_->callLater(delayMilliseconds_, callback_);
+  }
+
+private:
+  Milliseconds delayMilliseconds_;
+  Callback callback_;
+};
+
+class ThreadsafeFace::SendSubmission : public Submission {
+public:
+  /**
+   * Create a SendSubmission to send the encoding.
+   * @param encoding The encoding to send.
+   * @param data (optional) If not null, call Node::putData with this copy of
+   * the Data (which has the same encoding) so that it can satisfy pending
+   * interests with Interest loopback.
+   * @param wireFormat The WireFormat for Node::putData, if data is not null.
+   */
+  SendSubmission
+    (const Blob& encoding,
+     const ptr_lib::shared_ptr<Data>& data = ptr_lib::shared_ptr<Data>(),
+     WireFormat* wireFormat = 0)
+  : encoding_(encoding), data_(data), wireFormat_(wireFormat)
+  {
+  }
+
+  virtual void
+  process(Node& node, ThreadsafeFace& face)
+  {
+    if (data_)
+      node.putData(*data_, wireFormat_);
+    else
+      node.send(encoding_.buf(), encoding_.size());
+  }
+
+private:
+  Blob encoding_;
+  ptr_lib::shared_ptr<Data> data_;
+  WireFormat* wireFormat_;
+};
+
 ptr_lib::shared_ptr<Transport>
 ThreadsafeFace::getDefaultTransport(boost::asio::io_service& ioService)
 {
@@ -61,6 +171,7 @@ ThreadsafeFace::ThreadsafeFace
    const ptr_lib::shared_ptr<const Transport::ConnectionInfo>& connectionInfo)
   : Face(transport, connectionInfo), ioService_(ioService)
 {
+  construct();
 }
 
 
@@ -70,12 +181,14 @@ ThreadsafeFace::ThreadsafeFace
          ptr_lib::make_shared<AsyncTcpTransport::ConnectionInfo>(host, port)),
     ioService_(ioService)
 {
+  construct();
 }
 
 ThreadsafeFace::ThreadsafeFace(boost::asio::io_service& ioService)
   : Face(getDefaultTransport(ioService), getDefaultConnectionInfo()),
     ioService_(ioService)
 {
+  construct();
 }
 
 ThreadsafeFace::ThreadsafeFace()
@@ -89,6 +202,21 @@ ThreadsafeFace::ThreadsafeFace()
   delete node_;
   node_ = new Node
     (getDefaultTransport(ioService_), getDefaultConnectionInfo());
+  construct();
+}
+
+void
+ThreadsafeFace::construct()
+{
+  delayedCallTable_ = boost::movelib::make_unique<AsioDelayedCallTable>
+    (ioService_);
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+  submissionQueue_ = boost::movelib::make_unique<SubmissionQueue>();
+#endif
+}
+
+ThreadsafeFace::~ThreadsafeFace()
+{
 }
 
 uint64_t
@@ -100,11 +228,9 @@ ThreadsafeFace::expressInterest
   uint64_t pendingInterestId = node_->getNextEntryId();
 
   // This copies the interest as required by Node.expressInterest.
-  ioService_.dispatch
-    (boost::bind
-     (&Node::expressInterest, node_, pendingInterestId,
-      ptr_lib::make_shared<const Interest>(interest), onData, onTimeout,
-      onNetworkNack, boost::ref(wireFormat), this));
+  submit(new ExpressInterestSubmission
+    (pendingInterestId, ptr_lib::make_shared<const Interest>(interest), onData,
+     onTimeout, onNetworkNack, wireFormat));
 
   return pendingInterestId;
 }
@@ -119,11 +245,9 @@ ThreadsafeFace::expressInterest
   uint64_t pendingInterestId = node_->getNextEntryId();
 
   // This copies the name object as required by Node.expressInterest.
-  ioService_.dispatch
-    (boost::bind
-     (&Node::expressInterest, node_, pendingInterestId,
-      getInterestCopy(name, interestTemplate), onData, onTimeout, onNetworkNack,
-      boost::ref(wireFormat), this));
+  submit(new ExpressInterestSubmission
+    (pendingInterestId, getInterestCopy(name, interestTemplate), onData,
+     onTimeout, onNetworkNack, wireFormat));
 
   return pendingInterestId;
 }
@@ -213,8 +337,12 @@ ThreadsafeFace::putData(const Data& data, WireFormat& wireFormat)
     throw runtime_error
       ("The encoded Data packet size exceeds the maximum limit getMaxNdnPacketSize()");
 
-  ioService_.dispatch
-    (boost::bind(&Node::putData, node_, data, &wireFormat));
+  if (node_->getInterestLoopbackEnabled())
+    // Node.putData needs the Data to satisfy pending interests.
+    submit(new SendSubmission
+      (encoding, ptr_lib::make_shared<Data>(data), &wireFormat));
+  else
+    submit(new SendSubmission(encoding));
 }
 
 void
@@ -227,15 +355,16 @@ ThreadsafeFace::putNack(const Interest& interest, const NetworkNack& networkNack
     throw runtime_error
       ("The encoded Nack packet size exceeds the maximum limit getMaxNdnPacketSize()");
 
-  ioService_.dispatch
-    (boost::bind(&Node::putNack, node_, interest, networkNack));
+  // This is the same encoding as Node.putNack, so just send it.
+  submit(new SendSubmission(encoding));
 }
 
 void
 ThreadsafeFace::send(const uint8_t *encoding, size_t encodingLength)
 {
-  ioService_.dispatch
-    (boost::bind(&Node::send, node_, encoding, encodingLength));
+  // Copy the encoding since the caller's buffer may not be valid when the
+  // submission is processed.
+  submit(new SendSubmission(Blob(encoding, encodingLength)));
 }
 
 void
@@ -244,35 +373,65 @@ ThreadsafeFace::shutdown()
   ioService_.dispatch(boost::bind(&Node::shutdown, node_));
 }
 
-/**
- * After the delay, async_wait calls this to call the original caller's callback.
- * @param errorCode The error code from async_wait.
- * @param callback The original caller's callback.
- * @param timer This is not used, but passed in the function object to keep
- * the timer object alive until this is called.
- */
-static void
-waitHandler
-  (const boost::system::error_code& errorCode, const Face::Callback& callback,
-   ptr_lib::shared_ptr<boost::asio::deadline_timer> timer)
+void
+ThreadsafeFace::submit(Submission* submission)
 {
-  if (errorCode != boost::system::errc::success)
-    // Don't expect this to happen.
+#if BOOST_VERSION >= 106600
+  if (ioService_.get_executor().running_in_this_thread()) {
+    // Process now, the same as dispatch would.
+    boost::movelib::unique_ptr<Submission> submissionPointer(submission);
+    submission->process(*node_, *this);
     return;
+  }
+#endif
+
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+  if (submissionQueue_->push(submission))
+    // The queue was empty, so post one handler to process the whole batch.
+    ioService_.post(boost::bind(&ThreadsafeFace::processSubmissions, this));
+#else
+  ioService_.dispatch(boost::bind
+    (&ThreadsafeFace::processSubmission, this,
+     ptr_lib::shared_ptr<Submission>(submission)));
+#endif
+}
 
-  callback();
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+void
+ThreadsafeFace::processSubmissions()
+{
+  SubmissionQueue::Entry* entry = submissionQueue_->popAll();
+  while (entry) {
+    boost::movelib::unique_ptr<Submission> submission
+      (static_cast<Submission*>(entry));
+    entry = entry->getNext();
+
+    // Don't let an error lose the rest of the batch.
+    try {
+      submission->process(*node_, *this);
+    } catch (const std::exception& ex) {
+      _LOG_ERROR("ThreadsafeFace: Error processing a submission: " << ex.what());
+    } catch (...) {
+      _LOG_ERROR("ThreadsafeFace: Error processing a submission.");
+    }
+  }
 }
+#else
+void
+ThreadsafeFace::processSubmission
+  (const ptr_lib::shared_ptr<Submission>& submission)
+{
+  submission->process(*node_, *this);
+}
+#endif
 
 void
 ThreadsafeFace::callLater
   (Milliseconds delayMilliseconds, const Callback& callback)
 {
-  ptr_lib::shared_ptr<boost::asio::deadline_timer> timer
-    (new boost::asio::deadline_timer
-     (ioService_, boost::posix_time::milliseconds((uint64_t)delayMilliseconds)));
-
-  // Pass the timer to waitHandler to keep it alive.
-  timer->async_wait(boost::bind(&waitHandler, _1, callback, timer));
+  // Node.expressInterest calls this on the thread of the ioService, so this is
+  // usually processed now. delayedCallTable_ is only used on that thread.
+  submit(new CallLaterSubmission(delayMilliseconds, callback));
 }
 
 }
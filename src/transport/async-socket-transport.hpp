@@ -200,18 +200,44 @@ private:
       isConnected_ = true;
       onConnected();
 
-      socket_->async_receive
-        (boost::asio::buffer(receiveBuffer_, sizeof(receiveBuffer_)), 0,
-         boost::bind(&AsyncSocketTransport::Impl::readHandler,
-                     this->shared_from_this(), _1, _2));
+      asyncReceive();
     }
 
     /**
-     * This is called by async_receive to call elementReader_.onReceivedData and
-     * to call itself again.
+     * Call async_receive with readHandler. If elementReader_ is in the middle
+     * of a large element, receive the rest of it directly into elementBuffer_.
+     * Otherwise, receive into receiveBuffer_.
      */
     void
-    readHandler(const boost::system::error_code& errorCode, size_t nBytesReceived)
+    asyncReceive()
+    {
+      uint8_t* elementBuffer;
+      size_t elementBufferLength;
+      ndn_ElementReader_getReceiveBuffer
+        (&elementReader_, &elementBuffer, &elementBufferLength);
+
+      if (elementBuffer)
+        socket_->async_receive
+          (boost::asio::buffer(elementBuffer, elementBufferLength), 0,
+           boost::bind(&AsyncSocketTransport::Impl::readHandler,
+                       this->shared_from_this(), _1, _2, true));
+      else
+        socket_->async_receive
+          (boost::asio::buffer(receiveBuffer_, sizeof(receiveBuffer_)), 0,
+           boost::bind(&AsyncSocketTransport::Impl::readHandler,
+                       this->shared_from_this(), _1, _2, false));
+    }
+
+    /**
+     * This is called by async_receive to call elementReader_.onReceivedData (or
+     * onReceivedInPlace) and to call asyncReceive again.
+     * @param receivedInPlace True if the bytes were received into the buffer
+     * from ndn_ElementReader_getReceiveBuffer, false if into receiveBuffer_.
+     */
+    void
+    readHandler
+      (const boost::system::error_code& errorCode, size_t nBytesReceived,
+       bool receivedInPlace)
     {
       if (errorCode != boost::system::errc::success) {
         if (errorCode == boost::system::errc::operation_canceled)
@@ -224,16 +250,18 @@ private:
       }
 
       ndn_Error error;
-      if ((error = ndn_ElementReader_onReceivedData
-           (&elementReader_, receiveBuffer_, nBytesReceived)))
+      if (receivedInPlace)
+        error = ndn_ElementReader_onReceivedInPlace
+          (&elementReader_, nBytesReceived);
+      else
+        error = ndn_ElementReader_onReceivedData
+          (&elementReader_, receiveBuffer_, nBytesReceived);
+      if (error)
         throw std::runtime_error(ndn_getErrorString(error));
 
       // Request another async receive to loop back to here.
       if (socket_->is_open())
-        socket_->async_receive
-          (boost::asio::buffer(receiveBuffer_, sizeof(receiveBuffer_)), 0,
-           boost::bind(&AsyncSocketTransport::Impl::readHandler,
-                       this->shared_from_this(), _1, _2));
+        asyncReceive();
     }
 
     boost::asio::io_service& ioService_;
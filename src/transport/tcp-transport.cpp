@@ -44,6 +44,12 @@ TcpTransport::TcpTransport()
     elementBuffer_(new DynamicUInt8Vector(1000)), connectionInfo_("", 0)
 {
   ndn_TcpTransport_initialize(transport_.get(), elementBuffer_.get());
+  ndn_TcpTransport_openWakeUp(transport_.get());
+}
+
+TcpTransport::~TcpTransport()
+{
+  ndn_TcpTransport_closeWakeUp(transport_.get());
 }
 
 bool
@@ -108,6 +114,21 @@ TcpTransport::processEvents()
     throw runtime_error(ndn_getErrorString(error));
 }
 
+void
+TcpTransport::waitForReceive(Milliseconds maxWaitMilliseconds)
+{
+  ndn_Error error;
+  if ((error = ndn_TcpTransport_waitForReceive
+       (transport_.get(), getPollTimeoutMilliseconds(maxWaitMilliseconds))))
+    throw runtime_error(ndn_getErrorString(error));
+}
+
+void
+TcpTransport::wakeUp()
+{
+  ndn_TcpTransport_wakeUp(transport_.get());
+}
+
 bool
 TcpTransport::getIsConnected()
 {
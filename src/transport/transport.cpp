@@ -20,6 +20,8 @@
  */
 
 #include <stdexcept>
+#include <climits>
+#include <math.h>
 #include <ndn-cpp/transport/transport.hpp>
 
 using namespace std;
@@ -62,6 +64,16 @@ Transport::processEvents()
   throw logic_error("unimplemented");
 }
 
+void
+Transport::waitForReceive(Milliseconds maxWaitMilliseconds)
+{
+}
+
+void
+Transport::wakeUp()
+{
+}
+
 bool
 Transport::getIsConnected()
 {
@@ -77,4 +89,15 @@ Transport::~Transport()
 {
 }
 
+int
+Transport::getPollTimeoutMilliseconds(Milliseconds maxWaitMilliseconds)
+{
+  if (!(maxWaitMilliseconds > 0))
+    return 0;
+  if (maxWaitMilliseconds >= (Milliseconds)INT_MAX)
+    return INT_MAX;
+
+  return (int)ceil(maxWaitMilliseconds);
+}
+
 }
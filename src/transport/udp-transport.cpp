@@ -44,6 +44,12 @@ UdpTransport::UdpTransport()
     elementBuffer_(new DynamicUInt8Vector(1000))
 {
   ndn_UdpTransport_initialize(transport_.get(), elementBuffer_.get());
+  ndn_UdpTransport_openWakeUp(transport_.get());
+}
+
+UdpTransport::~UdpTransport()
+{
+  ndn_UdpTransport_closeWakeUp(transport_.get());
 }
 
 bool
@@ -92,6 +98,21 @@ UdpTransport::processEvents()
     throw runtime_error(ndn_getErrorString(error));
 }
 
+void
+UdpTransport::waitForReceive(Milliseconds maxWaitMilliseconds)
+{
+  ndn_Error error;
+  if ((error = ndn_UdpTransport_waitForReceive
+       (transport_.get(), getPollTimeoutMilliseconds(maxWaitMilliseconds))))
+    throw runtime_error(ndn_getErrorString(error));
+}
+
+void
+UdpTransport::wakeUp()
+{
+  ndn_UdpTransport_wakeUp(transport_.get());
+}
+
 bool
 UdpTransport::getIsConnected()
 {
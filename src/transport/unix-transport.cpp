@@ -44,6 +44,12 @@ UnixTransport::UnixTransport()
     elementBuffer_(new DynamicUInt8Vector(1000))
 {
   ndn_UnixTransport_initialize(transport_.get(), elementBuffer_.get());
+  ndn_UnixTransport_openWakeUp(transport_.get());
+}
+
+UnixTransport::~UnixTransport()
+{
+  ndn_UnixTransport_closeWakeUp(transport_.get());
 }
 
 bool
@@ -92,6 +98,21 @@ UnixTransport::processEvents()
     throw runtime_error(ndn_getErrorString(error));
 }
 
+void
+UnixTransport::waitForReceive(Milliseconds maxWaitMilliseconds)
+{
+  ndn_Error error;
+  if ((error = ndn_UnixTransport_waitForReceive
+       (transport_.get(), getPollTimeoutMilliseconds(maxWaitMilliseconds))))
+    throw runtime_error(ndn_getErrorString(error));
+}
+
+void
+UnixTransport::wakeUp()
+{
+  ndn_UnixTransport_wakeUp(transport_.get());
+}
+
 bool
 UnixTransport::getIsConnected()
 {
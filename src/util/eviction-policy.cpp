@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include <ndn-cpp/util/eviction-policy.hpp>
+
+using namespace std;
+
+namespace ndn {
+
+void
+FifoEvictionPolicy::afterInsert(const MemoryContentCache::Content* content)
+{
+  positions_[content] = queue_.insert(queue_.end(), content);
+}
+
+void
+FifoEvictionPolicy::beforeRemove(const MemoryContentCache::Content* content)
+{
+  map<const MemoryContentCache::Content*, ContentQueue::iterator>::iterator
+    position = positions_.find(content);
+  if (position == positions_.end())
+    return;
+
+  queue_.erase(position->second);
+  positions_.erase(position);
+}
+
+const MemoryContentCache::Content*
+FifoEvictionPolicy::selectVictim()
+{
+  if (queue_.size() == 0)
+    return 0;
+  return queue_.front();
+}
+
+void
+LruEvictionPolicy::afterAccess(const MemoryContentCache::Content* content)
+{
+  map<const MemoryContentCache::Content*, ContentQueue::iterator>::iterator
+    position = positions_.find(content);
+  if (position == positions_.end())
+    return;
+
+  // Move to the back, which is the most recently used.
+  queue_.splice(queue_.end(), queue_, position->second);
+}
+
+void
+LfuEvictionPolicy::afterInsert(const MemoryContentCache::Content* content)
+{
+  positions_[content] = keys_.insert(Key(0, ++lastSequenceNo_, content)).first;
+}
+
+void
+LfuEvictionPolicy::afterAccess(const MemoryContentCache::Content* content)
+{
+  map<const MemoryContentCache::Content*, set<Key>::iterator>::iterator
+    position = positions_.find(content);
+  if (position == positions_.end())
+    return;
+
+  uint64_t useCount = position->second->useCount_ + 1;
+  keys_.erase(position->second);
+  position->second = keys_.insert(Key(useCount, ++lastSequenceNo_, content)).first;
+}
+
+void
+LfuEvictionPolicy::beforeRemove(const MemoryContentCache::Content* content)
+{
+  map<const MemoryContentCache::Content*, set<Key>::iterator>::iterator
+    position = positions_.find(content);
+  if (position == positions_.end())
+    return;
+
+  keys_.erase(position->second);
+  positions_.erase(position);
+}
+
+const MemoryContentCache::Content*
+LfuEvictionPolicy::selectVictim()
+{
+  if (keys_.size() == 0)
+    return 0;
+  return keys_.begin()->content_;
+}
+
+// The number of rows in the count-min sketch.
+static const int SKETCH_DEPTH = 4;
+// The maximum value of a 4-bit sketch counter.
+static const int SKETCH_MAX_COUNT = 15;
+// Seeds to make a different index for each row.
+static const size_t SKETCH_SEEDS[SKETCH_DEPTH] =
+  { 0x97cb3127, 0xb8e1afed, 0x7ed9bc1d, 0x3c6ef372 };
+
+WTinyLfuEvictionPolicy::WTinyLfuEvictionPolicy
+  (double windowFraction, double protectedFraction)
+: windowFraction_(windowFraction), protectedFraction_(protectedFraction),
+  sketch_(64, 0), nIncrements_(0)
+{
+  bytes_[WINDOW] = 0;
+  bytes_[PROBATION] = 0;
+  bytes_[PROTECTED] = 0;
+}
+
+void
+WTinyLfuEvictionPolicy::afterInsert(const MemoryContentCache::Content* content)
+{
+  incrementFrequency(content);
+  positions_.insert(make_pair
+    (content, Position
+     (WINDOW, queues_[WINDOW].insert(queues_[WINDOW].end(), content))));
+  bytes_[WINDOW] += content->getDataEncoding().size();
+}
+
+void
+WTinyLfuEvictionPolicy::afterAccess(const MemoryContentCache::Content* content)
+{
+  incrementFrequency(content);
+  map<const MemoryContentCache::Content*, Position>::iterator position =
+    positions_.find(content);
+  if (position == positions_.end())
+    return;
+
+  if (position->second.segment_ == PROBATION) {
+    // Used again while in probation, so protect it.
+    moveTo(position->second, PROTECTED);
+    balanceProtected();
+  }
+  else
+    // Make it the most recently used in its segment.
+    moveTo(position->second, position->second.segment_);
+}
+
+void
+WTinyLfuEvictionPolicy::beforeRemove(const MemoryContentCache::Content* content)
+{
+  map<const MemoryContentCache::Content*, Position>::iterator position =
+    positions_.find(content);
+  if (position == positions_.end())
+    return;
+
+  bytes_[position->second.segment_] -= content->getDataEncoding().size();
+  queues_[position->second.segment_].erase(position->second.iterator_);
+  positions_.erase(position);
+}
+
+const MemoryContentCache::Content*
+WTinyLfuEvictionPolicy::selectVictim()
+{
+  ContentQueue& window = queues_[WINDOW];
+  // The cache calls this when it is full, so use the current bytes for the
+  // size of the window.
+  double maxWindowBytes = windowFraction_ *
+    (bytes_[WINDOW] + bytes_[PROBATION] + bytes_[PROTECTED]);
+
+  if (queues_[PROBATION].size() == 0 && queues_[PROTECTED].size() == 0) {
+    // The first time the cache is full, all the content is in the window, so
+    // move the window overflow to probation without a contest.
+    while (window.size() > 1 && bytes_[WINDOW] > maxWindowBytes)
+      moveTo(positions_.find(window.front())->second, PROBATION);
+  }
+
+  // Prefer the probation segment for the main victim.
+  ContentQueue& main = queues_[PROBATION].size() > 0 ?
+    queues_[PROBATION] : queues_[PROTECTED];
+  if (main.size() == 0) {
+    if (window.size() > 0)
+      return window.front();
+    return 0;
+  }
+
+  const MemoryContentCache::Content* victim = main.front();
+  if (window.size() > 0 && bytes_[WINDOW] > maxWindowBytes) {
+    // The least recently used content in the window is the candidate to move
+    // to the main segments. Admit it only if its name is used more often than
+    // the main victim.
+    const MemoryContentCache::Content* candidate = window.front();
+    if (getFrequency(candidate) > getFrequency(victim)) {
+      moveTo(positions_.find(candidate)->second, PROBATION);
+      return victim;
+    }
+    else
+      return candidate;
+  }
+
+  return victim;
+}
+
+void
+WTinyLfuEvictionPolicy::moveTo(Position& position, Segment segment)
+{
+  size_t nBytes = (*position.iterator_)->getDataEncoding().size();
+  bytes_[position.segment_] -= nBytes;
+  bytes_[segment] += nBytes;
+
+  queues_[segment].splice
+    (queues_[segment].end(), queues_[position.segment_], position.iterator_);
+  position.segment_ = segment;
+}
+
+void
+WTinyLfuEvictionPolicy::balanceProtected()
+{
+  size_t mainBytes = bytes_[PROBATION] + bytes_[PROTECTED];
+  while (queues_[PROTECTED].size() > 1 &&
+         bytes_[PROTECTED] > protectedFraction_ * mainBytes)
+    moveTo(positions_.find(queues_[PROTECTED].front())->second, PROBATION);
+}
+
+void
+WTinyLfuEvictionPolicy::incrementFrequency
+  (const MemoryContentCache::Content* content)
+{
+  // Keep at least two counters for each content in the cache. Each byte has
+  // two counters. When the sketch grows, the old counts are lost.
+  if (positions_.size() > sketch_.size()) {
+    size_t newSize = sketch_.size();
+    while (newSize < positions_.size())
+      newSize *= 2;
+    sketch_.assign(newSize, 0);
+    nIncrements_ = 0;
+  }
+
+  size_t nameHash = content->getName().hash();
+  int frequency = getFrequency(content);
+  if (frequency < SKETCH_MAX_COUNT) {
+    // Conservative update: only increment the counters at the minimum.
+    for (int row = 0; row < SKETCH_DEPTH; ++row) {
+      size_t index = getCounterIndex(nameHash, row);
+      uint8_t& counterByte = sketch_[index / 2];
+      int shift = (index % 2) * 4;
+      if (((counterByte >> shift) & 0x0f) == frequency)
+        counterByte += (1 << shift);
+    }
+  }
+
+  // Age the counts so that old popularity fades.
+  if (++nIncrements_ >= sketch_.size() * 10) {
+    for (size_t i = 0; i < sketch_.size(); ++i)
+      sketch_[i] = (sketch_[i] >> 1) & 0x77;
+    nIncrements_ = 0;
+  }
+}
+
+int
+WTinyLfuEvictionPolicy::getFrequency
+  (const MemoryContentCache::Content* content) const
+{
+  size_t nameHash = content->getName().hash();
+  int frequency = SKETCH_MAX_COUNT;
+  for (int row = 0; row < SKETCH_DEPTH; ++row) {
+    size_t index = getCounterIndex(nameHash, row);
+    int count = (sketch_[index / 2] >> ((index % 2) * 4)) & 0x0f;
+    if (count < frequency)
+      frequency = count;
+  }
+
+  return frequency;
+}
+
+size_t
+WTinyLfuEvictionPolicy::getCounterIndex(size_t nameHash, int row) const
+{
+  size_t hash = (nameHash ^ SKETCH_SEEDS[row]) * 0x9e3779b1;
+  hash ^= hash >> 15;
+  // sketch_.size() is a power of 2 and each byte has two counters.
+  return hash & (sketch_.size() * 2 - 1);
+}
+
+}
@@ -23,6 +23,7 @@
 #include "../c/util/time.h"
 #include <ndn-cpp/util/logging.hpp>
 #include <ndn-cpp/util/memory-content-cache.hpp>
+#include <ndn-cpp/util/eviction-policy.hpp>
 
 using namespace std;
 using namespace ndn::func_lib;
@@ -35,7 +36,8 @@ MemoryContentCache::Impl::Impl
   (Face* face, Milliseconds cleanupIntervalMilliseconds)
 : face_(face), cleanupIntervalMilliseconds_(cleanupIntervalMilliseconds),
   nextCleanupTime_(ndn_getNowMilliseconds() + cleanupIntervalMilliseconds),
-  isDoingCleanup_(false), minimumCacheLifetime_(0)
+  isDoingCleanup_(false), minimumCacheLifetime_(0), maxCacheBytes_(0),
+  cacheBytes_(0), hitCount_(0), missCount_(0), evictionCount_(0)
 {
 }
 
@@ -108,42 +110,63 @@ MemoryContentCache::Impl::add(const Data& data)
   MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
   doCleanup(nowMilliseconds);
 
+  const Content* addedContent;
   if (data.getMetaInfo().getFreshnessPeriod() >= 0.0) {
-    // The content will go stale, so use staleTimeCache_.
+    // The content will go stale, so also use staleTimeCache_.
     ptr_lib::shared_ptr<const StaleTimeContent> content
       (new StaleTimeContent(data, nowMilliseconds, minimumCacheLifetime_));
-    // Insert into staleTimeCache_, sorted on content->cacheRemovalTimeMilliseconds_.
-    staleTimeCache_.insert
-      (std::lower_bound(staleTimeCache_.begin(), staleTimeCache_.end(), content, contentCompare_),
-       content);
+    // staleTimeCache_ is sorted on content->cacheRemovalTimeMilliseconds_.
+    staleTimeCache_.insert(content);
+    contentIndex_.insert
+      (ContentIndex::value_type(content->getName(), IndexEntry(content, content.get())));
+    addedContent = content.get();
   }
-  else
-    // The data does not go stale, so use noStaleTimeCache_.
-    noStaleTimeCache_.push_back
+  else {
+    // The data does not go stale.
+    ptr_lib::shared_ptr<const Content> content
       (ptr_lib::make_shared<const Content>(data));
+    contentIndex_.insert
+      (ContentIndex::value_type(content->getName(), IndexEntry(content, 0)));
+    addedContent = content.get();
+  }
+
+  cacheBytes_ += addedContent->getDataEncoding().size();
+  if (evictionPolicy_) {
+    evictionPolicy_->afterInsert(addedContent);
+    evict();
+  }
 
   // Remove timed-out interests and check if the data packet matches any pending
-  // interest.
-  // Go backwards through the list so we can erase entries.
-  for (int i = (int)pendingInterestTable_.size() - 1; i >= 0; --i) {
-    if (pendingInterestTable_[i]->isTimedOut(nowMilliseconds)) {
-      pendingInterestTable_.erase(pendingInterestTable_.begin() + i);
-      continue;
-    }
+  // interest. Only an interest whose name is a prefix of the data name can
+  // match, so check the interests under each prefix.
+  removeTimedOutPendingInterests(nowMilliseconds);
+  if (pendingInterestIndex_.empty())
+    return;
+
+  const Name& name = data.getName();
+  for (size_t prefixSize = 0; prefixSize <= name.size(); ++prefixSize) {
+    Name prefix = name.getPrefix(prefixSize);
+    pair<PendingInterestIndex::iterator, PendingInterestIndex::iterator> range =
+      pendingInterestIndex_.equal_range(prefix);
+    PendingInterestIndex::iterator entry = range.first;
+    while (entry != range.second) {
+      if (!entry->second->getInterest()->matchesName(name)) {
+        ++entry;
+        continue;
+      }
 
-    if (pendingInterestTable_[i]->getInterest()->matchesName(data.getName())) {
       try {
         // Send to the same transport from the original call to onInterest.
         // wireEncode returns the cached encoding if available.
-        _LOG_TRACE("MemoryContentCache:  Reply w/ add Data " << data.getName());
-        pendingInterestTable_[i]->getFace().send(*data.wireEncode());
+        _LOG_TRACE("MemoryContentCache:  Reply w/ add Data " << name);
+        entry->second->getFace().send(*data.wireEncode());
       } catch (std::exception& e) {
         _LOG_DEBUG("Error in send: " << e.what());
         return;
       }
 
       // The pending interest is satisfied, so remove it.
-      pendingInterestTable_.erase(pendingInterestTable_.begin() + i);
+      pendingInterestIndex_.erase(entry++);
     }
   }
 }
@@ -152,8 +175,34 @@ void
 MemoryContentCache::Impl::storePendingInterest
   (const ptr_lib::shared_ptr<const Interest>& interest, Face& face)
 {
-  pendingInterestTable_.push_back(ptr_lib::shared_ptr<PendingInterest>
-    (new PendingInterest(interest, face)));
+  ptr_lib::shared_ptr<const PendingInterest> pendingInterest
+    (new PendingInterest(interest, face));
+  pendingInterestIndex_.insert
+    (PendingInterestIndex::value_type(interest->getName(), pendingInterest));
+  pendingInterestTimeouts_.push(pendingInterest);
+}
+
+void
+MemoryContentCache::Impl::removeTimedOutPendingInterests
+  (MillisecondsSince1970 nowMilliseconds)
+{
+  while (!pendingInterestTimeouts_.empty() &&
+         pendingInterestTimeouts_.top()->isTimedOut(nowMilliseconds)) {
+    ptr_lib::shared_ptr<const PendingInterest> pendingInterest =
+      pendingInterestTimeouts_.top();
+    pendingInterestTimeouts_.pop();
+
+    // Remove it from the index if it was not already satisfied.
+    pair<PendingInterestIndex::iterator, PendingInterestIndex::iterator> range =
+      pendingInterestIndex_.equal_range(pendingInterest->getInterest()->getName());
+    for (PendingInterestIndex::iterator entry = range.first;
+         entry != range.second; ++entry) {
+      if (entry->second == pendingInterest) {
+        pendingInterestIndex_.erase(entry);
+        break;
+      }
+    }
+  }
 }
 
 void
@@ -162,18 +211,17 @@ MemoryContentCache::Impl::getPendingInterestsForName
    vector<ptr_lib::shared_ptr<const PendingInterest> >& pendingInterests)
 {
   pendingInterests.clear();
-
-  // Remove timed-out interests as we add results.
-  // Go backwards through the list so we can erase entries.
-  MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
-  for (int i = (int)pendingInterestTable_.size() - 1; i >= 0; --i) {
-    if (pendingInterestTable_[i]->isTimedOut(nowMilliseconds)) {
-      pendingInterestTable_.erase(pendingInterestTable_.begin() + i);
-      continue;
+  removeTimedOutPendingInterests(ndn_getNowMilliseconds());
+
+  // Only an interest whose name is a prefix of the name can match.
+  for (size_t prefixSize = 0; prefixSize <= name.size(); ++prefixSize) {
+    pair<PendingInterestIndex::iterator, PendingInterestIndex::iterator> range =
+      pendingInterestIndex_.equal_range(name.getPrefix(prefixSize));
+    for (PendingInterestIndex::iterator entry = range.first;
+         entry != range.second; ++entry) {
+      if (entry->second->getInterest()->matchesName(name))
+        pendingInterests.push_back(entry->second);
     }
-
-    if (pendingInterestTable_[i]->getInterest()->matchesName(name))
-      pendingInterests.push_back(pendingInterestTable_[i]);
   }
 }
 
@@ -183,19 +231,14 @@ MemoryContentCache::Impl::getPendingInterestsWithPrefix
    vector<ptr_lib::shared_ptr<const PendingInterest> >& pendingInterests)
 {
   pendingInterests.clear();
-
-  // Remove timed-out interests as we add results.
-  // Go backwards through the list so we can erase entries.
-  MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
-  for (int i = (int)pendingInterestTable_.size() - 1; i >= 0; --i) {
-    if (pendingInterestTable_[i]->isTimedOut(nowMilliseconds)) {
-      pendingInterestTable_.erase(pendingInterestTable_.begin() + i);
-      continue;
-    }
-
-    if (prefix.isPrefixOf(pendingInterestTable_[i]->getInterest()->getName()))
-      pendingInterests.push_back(pendingInterestTable_[i]);
-  }
+  removeTimedOutPendingInterests(ndn_getNowMilliseconds());
+
+  // The interest names with the prefix are in one range of the index.
+  for (PendingInterestIndex::iterator entry =
+         pendingInterestIndex_.lower_bound(prefix);
+       entry != pendingInterestIndex_.end() && prefix.isPrefixOf(entry->first);
+       ++entry)
+    pendingInterests.push_back(entry->second);
 }
 
 void
@@ -210,69 +253,16 @@ MemoryContentCache::Impl::onInterest
   MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
   doCleanup(nowMilliseconds);
 
-  const Name::Component* selectedComponent = 0;
-  Blob selectedEncoding;
-  // We need to iterate over both arrays.
-  size_t totalSize = staleTimeCache_.size() + noStaleTimeCache_.size();
-  for (size_t i = 0; i < totalSize; ++i) {
-    const Content* content;
-    bool isFresh = true;
-    if (i < staleTimeCache_.size()) {
-      const StaleTimeContent *staleTimeContent = staleTimeCache_[i].get();
-      content = staleTimeContent;
-      isFresh = staleTimeContent->isFresh(nowMilliseconds);
-    }
-    else
-      // We have iterated over the first array. Get from the second.
-      content = noStaleTimeCache_[i - staleTimeCache_.size()].get();
-
-    if (interest->matchesName(content->getName()) &&
-        !(interest->getMustBeFresh() && !isFresh)) {
-      if (interest->getChildSelector() < 0) {
-        // No child selector, so send the first match that we have found.
-        _LOG_TRACE("MemoryContentCache:         Reply Data " << content->getName());
-        face.send(*content->getDataEncoding());
-        return;
-      }
-      else {
-        // Update selectedEncoding based on the child selector.
-        const Name::Component* component;
-        if (content->getName().size() > interest->getName().size())
-          component = &content->getName().get(interest->getName().size());
-        else
-          component = &emptyComponent_;
-
-        bool gotBetterMatch = false;
-        if (!selectedEncoding)
-          // Save the first match.
-          gotBetterMatch = true;
-        else {
-          if (interest->getChildSelector() == 0) {
-            // Leftmost child.
-            if (*component < *selectedComponent)
-              gotBetterMatch = true;
-          }
-          else {
-            // Rightmost child.
-            if (*component > *selectedComponent)
-              gotBetterMatch = true;
-          }
-        }
-
-        if (gotBetterMatch) {
-          selectedComponent = component;
-          selectedEncoding = content->getDataEncoding();
-        }
-      }
-    }
-  }
-
-  if (selectedEncoding) {
-    // We found the leftmost or rightmost child.
-    _LOG_TRACE("MemoryContentCache: Reply Data to Interest " << interest->toUri());
-    face.send(*selectedEncoding);
+  const Content* content = findMatchingContent(*interest, nowMilliseconds);
+  if (content) {
+    ++hitCount_;
+    if (evictionPolicy_)
+      evictionPolicy_->afterAccess(content);
+    _LOG_TRACE("MemoryContentCache:         Reply Data " << content->getName());
+    face.send(*content->getDataEncoding());
   }
   else {
+    ++missCount_;
     _LOG_TRACE("MemoryContentCache: onDataNotFound for " << interest->toUri());
     // Call the onDataNotFound callback (if defined).
     map<string, OnInterestCallback>::iterator onDataNotFound =
@@ -290,6 +280,142 @@ MemoryContentCache::Impl::onInterest
   }
 }
 
+const MemoryContentCache::Content*
+MemoryContentCache::Impl::findMatchingContent
+  (const Interest& interest, MillisecondsSince1970 nowMilliseconds) const
+{
+  const Name& prefix = interest.getName();
+  // The names in contentIndex_ with the prefix are in the range from the
+  // prefix up to its successor. The successor of an empty name is not greater
+  // than every name, so use the end.
+  ContentIndex::const_iterator begin = contentIndex_.lower_bound(prefix);
+  ContentIndex::const_iterator end = prefix.size() == 0 ?
+    contentIndex_.end() : contentIndex_.lower_bound(prefix.getSuccessor());
+
+  if (interest.getChildSelector() == 1) {
+    // The names are sorted, so the first match going backwards has the
+    // rightmost child.
+    for (ContentIndex::const_iterator entry = end; entry != begin; ) {
+      --entry;
+      if (interest.matchesName(entry->first) &&
+          !(interest.getMustBeFresh() && !entry->second.isFresh(nowMilliseconds)))
+        return entry->second.getContent().get();
+    }
+  }
+  else {
+    // The first match has the leftmost child.
+    for (ContentIndex::const_iterator entry = begin; entry != end; ++entry) {
+      if (interest.matchesName(entry->first) &&
+          !(interest.getMustBeFresh() && !entry->second.isFresh(nowMilliseconds)))
+        return entry->second.getContent().get();
+    }
+  }
+
+  return 0;
+}
+
+MemoryContentCache::Impl::ContentIndex::iterator
+MemoryContentCache::Impl::findInIndex(const Content* content)
+{
+  pair<ContentIndex::iterator, ContentIndex::iterator> range =
+    contentIndex_.equal_range(content->getName());
+  for (ContentIndex::iterator entry = range.first; entry != range.second; ++entry) {
+    if (entry->second.getContent().get() == content)
+      return entry;
+  }
+
+  return contentIndex_.end();
+}
+
+void
+MemoryContentCache::Impl::removeFromIndex(ContentIndex::iterator entry)
+{
+  if (evictionPolicy_)
+    evictionPolicy_->beforeRemove(entry->second.getContent().get());
+  cacheBytes_ -= entry->second.getContent()->getDataEncoding().size();
+  contentIndex_.erase(entry);
+}
+
+void
+MemoryContentCache::Impl::evict()
+{
+  if (maxCacheBytes_ == 0 || !evictionPolicy_)
+    return;
+
+  ptr_lib::shared_ptr<ContentList> contentList;
+  while (cacheBytes_ > maxCacheBytes_) {
+    const Content* victim = evictionPolicy_->selectVictim();
+    if (!victim)
+      break;
+    ContentIndex::iterator entry = findInIndex(victim);
+    if (entry == contentIndex_.end()) {
+      // Don't expect this to happen. Tell the policy to forget it.
+      _LOG_ERROR("MemoryContentCache::evict(): The victim is not in the cache");
+      evictionPolicy_->beforeRemove(victim);
+      continue;
+    }
+
+    if (onContentRemoved_) {
+      // Make a separate list because the callback might call add.
+      if (!contentList)
+        contentList.reset(new ContentList());
+
+      contentList->push_back(entry->second.getContent());
+    }
+
+    const StaleTimeContent* staleTimeContent = entry->second.getStaleTimeContent();
+    if (staleTimeContent) {
+      // Find the matching pointer among the entries with the same removal time.
+      pair<StaleTimeCache::iterator, StaleTimeCache::iterator> range =
+        staleTimeCache_.equal_range
+          (ptr_lib::static_pointer_cast<const StaleTimeContent>
+           (entry->second.getContent()));
+      for (StaleTimeCache::iterator i = range.first; i != range.second; ++i) {
+        if (i->get() == staleTimeContent) {
+          staleTimeCache_.erase(i);
+          break;
+        }
+      }
+    }
+
+    removeFromIndex(entry);
+    ++evictionCount_;
+  }
+
+  if (onContentRemoved_ && contentList) {
+    try {
+      onContentRemoved_(contentList);
+    } catch (const std::exception& ex) {
+      _LOG_ERROR("MemoryContentCache::evict(): Error in onContentRemoved: " << ex.what());
+    } catch (...) {
+      _LOG_ERROR("MemoryContentCache::evict(): Error in onContentRemoved.");
+    }
+  }
+}
+
+void
+MemoryContentCache::Impl::setMaxCacheBytes(size_t maxCacheBytes)
+{
+  maxCacheBytes_ = maxCacheBytes;
+  if (maxCacheBytes_ > 0 && !evictionPolicy_)
+    setEvictionPolicy(ptr_lib::make_shared<LruEvictionPolicy>());
+  evict();
+}
+
+void
+MemoryContentCache::Impl::setEvictionPolicy
+  (const ptr_lib::shared_ptr<EvictionPolicy>& evictionPolicy)
+{
+  evictionPolicy_ = evictionPolicy;
+  if (evictionPolicy_) {
+    for (ContentIndex::iterator entry = contentIndex_.begin();
+         entry != contentIndex_.end(); ++entry)
+      evictionPolicy_->afterInsert(entry->second.getContent().get());
+  }
+
+  evict();
+}
+
 void
 MemoryContentCache::Impl::doCleanup(MillisecondsSince1970 nowMilliseconds)
 {
@@ -305,7 +431,7 @@ MemoryContentCache::Impl::doCleanup(MillisecondsSince1970 nowMilliseconds)
     // staleTimeCache_ is sorted on cacheRemovalTimeMilliseconds_, so we only need to
     // erase the stale entries at the front, then quit.
     while (staleTimeCache_.size() > 0 &&
-           staleTimeCache_.front()->isPastRemovalTime(nowMilliseconds)) {
+           (*staleTimeCache_.begin())->isPastRemovalTime(nowMilliseconds)) {
       if (onContentRemoved_) {
         // Add to the list of removed content for the OnContentRemoved callback.
         // We make a separate list instead of calling the callback each time
@@ -313,9 +439,12 @@ MemoryContentCache::Impl::doCleanup(MillisecondsSince1970 nowMilliseconds)
         if (!contentList)
           contentList.reset(new ContentList());
 
-        contentList->push_back(staleTimeCache_.front());
+        contentList->push_back(*staleTimeCache_.begin());
       }
 
+      ContentIndex::iterator entry = findInIndex(staleTimeCache_.begin()->get());
+      if (entry != contentIndex_.end())
+        removeFromIndex(entry);
       staleTimeCache_.erase(staleTimeCache_.begin());
     }
 
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "../c/util/time.h"
+#include "../impl/mapped-content-store.hpp"
+#include <ndn-cpp/util/logging.hpp>
+#include <ndn-cpp/util/persistent-content-cache.hpp>
+
+using namespace std;
+using namespace ndn::func_lib;
+
+INIT_LOGGER("ndn.PersistentContentCache");
+
+namespace ndn {
+
+PersistentContentCache::Impl::Impl
+  (Face* face, const string& directory, size_t segmentSize)
+: face_(face), store_(new MappedContentStore(directory, segmentSize)),
+  hitCount_(0), missCount_(0)
+{
+  if (store_->getRecoveredDropCount() > 0 ||
+      store_->getRecoveredRebuildCount() > 0)
+    _LOG_DEBUG("PersistentContentCache: Recovered " << directory <<
+               " after an interrupted write. Dropped " <<
+               store_->getRecoveredDropCount() << " records");
+}
+
+void
+PersistentContentCache::Impl::registerPrefix
+  (const Name& prefix, const OnRegisterFailed& onRegisterFailed,
+   const OnRegisterSuccess& onRegisterSuccess,
+   const OnInterestCallback& onDataNotFound,
+   const RegistrationOptions& registrationOptions, WireFormat& wireFormat)
+{
+  onDataNotFoundForPrefix_[prefix.toUri()] = onDataNotFound;
+  uint64_t registeredPrefixId = face_->registerPrefix
+    (prefix,
+     bind(&PersistentContentCache::Impl::onInterest, shared_from_this(), _1, _2, _3, _4, _5),
+     onRegisterFailed, onRegisterSuccess, registrationOptions, wireFormat);
+  // Remember the registeredPrefixId so unregisterAll can remove it.
+  registeredPrefixIdList_.push_back(registeredPrefixId);
+}
+
+void
+PersistentContentCache::Impl::setInterestFilter
+  (const InterestFilter& filter, const OnInterestCallback& onDataNotFound)
+{
+  onDataNotFoundForPrefix_[filter.getPrefix().toUri()] = onDataNotFound;
+  uint64_t interestFilterId = face_->setInterestFilter
+    (filter,
+     bind(&PersistentContentCache::Impl::onInterest, shared_from_this(), _1, _2, _3, _4, _5));
+  // Remember the interestFilterId so unregisterAll can remove it.
+  interestFilterIdList_.push_back(interestFilterId);
+}
+
+void
+PersistentContentCache::Impl::setInterestFilter
+  (const Name& prefix, const OnInterestCallback& onDataNotFound)
+{
+  onDataNotFoundForPrefix_[prefix.toUri()] = onDataNotFound;
+  uint64_t interestFilterId = face_->setInterestFilter
+    (prefix,
+     bind(&PersistentContentCache::Impl::onInterest, shared_from_this(), _1, _2, _3, _4, _5));
+  // Remember the interestFilterId so unregisterAll can remove it.
+  interestFilterIdList_.push_back(interestFilterId);
+}
+
+void
+PersistentContentCache::Impl::unregisterAll()
+{
+  for (size_t i = 0; i < interestFilterIdList_.size(); ++i)
+    face_->unsetInterestFilter(interestFilterIdList_[i]);
+  interestFilterIdList_.clear();
+
+  for (size_t i = 0; i < registeredPrefixIdList_.size(); ++i)
+    face_->removeRegisteredPrefix(registeredPrefixIdList_[i]);
+  registeredPrefixIdList_.clear();
+
+  // Also clear each onDataNotFoundForPrefix given to registerPrefix.
+  onDataNotFoundForPrefix_.clear();
+}
+
+void
+PersistentContentCache::Impl::add(const Data& data)
+{
+  store_->add(data, ndn_getNowMilliseconds());
+}
+
+void
+PersistentContentCache::Impl::flush() { store_->flush(); }
+
+void
+PersistentContentCache::Impl::compact(uint64_t maxContentBytes)
+{
+  store_->compact(maxContentBytes);
+}
+
+size_t
+PersistentContentCache::Impl::size() const { return store_->size(); }
+
+uint64_t
+PersistentContentCache::Impl::getContentBytes() const
+{
+  return store_->getContentBytes();
+}
+
+void
+PersistentContentCache::Impl::onInterest
+  (const ptr_lib::shared_ptr<const Name>& prefix,
+   const ptr_lib::shared_ptr<const Interest>& interest, Face& face,
+   uint64_t interestFilterId,
+   const ptr_lib::shared_ptr<const InterestFilter>& filter)
+{
+  _LOG_TRACE("PersistentContentCache:  Received Interest " << interest->toUri());
+
+  size_t encodingLength;
+  const uint8_t* encoding = store_->find
+    (*interest, ndn_getNowMilliseconds(), encodingLength);
+  if (encoding) {
+    ++hitCount_;
+    face.send(encoding, encodingLength);
+  }
+  else {
+    ++missCount_;
+    _LOG_TRACE("PersistentContentCache: onDataNotFound for " << interest->toUri());
+    // Call the onDataNotFound callback (if defined).
+    map<string, OnInterestCallback>::iterator onDataNotFound =
+      onDataNotFoundForPrefix_.find(prefix->toUri());
+    if (onDataNotFound != onDataNotFoundForPrefix_.end() &&
+        onDataNotFound->second) {
+      try {
+        onDataNotFound->second(prefix, interest, face, interestFilterId, filter);
+      } catch (const std::exception& ex) {
+        _LOG_ERROR("PersistentContentCache::onInterest: Error in onDataNotFound: " << ex.what());
+      } catch (...) {
+        _LOG_ERROR("PersistentContentCache::onInterest: Error in onDataNotFound.");
+      }
+    }
+  }
+}
+
+}
@@ -21,7 +21,17 @@
  */
 
 #include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
 #include "../c/util/ndn_memory.h"
+#include "../c/util/time.h"
+#include <ndn-cpp/util/rtt-estimator.hpp>
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 #include <ndn-cpp/util/logging.hpp>
 #include <ndn-cpp/util/segment-fetcher.hpp>
 
@@ -32,77 +42,209 @@ INIT_LOGGER("ndn.SegmentFetcher");
 
 namespace ndn {
 
+SegmentFetcher::SegmentFetcher
+  (Face& face, KeyChain* validatorKeyChain, const VerifySegment& verifySegment,
+   const OnComplete& onComplete, const OnError& onError,
+   const Options& options)
+: face_(face), validatorKeyChain_(validatorKeyChain), verifySegment_(verifySegment),
+  onComplete_(onComplete), onError_(onError), options_(options),
+  rttEstimator_(new RttEstimator()), isFinished_(false),
+  isSendingInterests_(false), transmissionCount_(0),
+  windowSize_(options.getInitialWindowSize()),
+  slowStartThreshold_(options.getInitialSlowStartThreshold()),
+  recoveryPoint_(0), nextSegment_(0), hasFinalSegment_(false), finalSegment_(0),
+  nextDeliverSegment_(0)
+{
+}
+
 bool
 SegmentFetcher::DontVerifySegment(const ptr_lib::shared_ptr<Data>& data)
 {
   return true;
 }
 
+SegmentFetcher::OnSegment
+SegmentFetcher::makeFileDescriptorSink(int fileDescriptor)
+{
+  return bind(&SegmentFetcher::writeToFileDescriptor, fileDescriptor, _1, _2);
+}
+
 void
 SegmentFetcher::fetch
   (Face& face, const Interest &baseInterest, const VerifySegment& verifySegment,
-   const OnComplete& onComplete, const OnError& onError)
+   const OnComplete& onComplete, const OnError& onError,
+   const Options& options)
 {
   // Make a shared_ptr because we make callbacks with bind using
   //   shared_from_this() so the object remains allocated.
   ptr_lib::shared_ptr<SegmentFetcher> segmentFetcher
-    (new SegmentFetcher(face, 0, verifySegment, onComplete, onError));
+    (new SegmentFetcher(face, 0, verifySegment, onComplete, onError, options));
   segmentFetcher->fetchFirstSegment(baseInterest);
 }
 
 void
 SegmentFetcher::fetch
   (Face& face, const Interest &baseInterest, KeyChain* validatorKeyChain,
-   const OnComplete& onComplete, const OnError& onError)
+   const OnComplete& onComplete, const OnError& onError,
+   const Options& options)
 {
   // Make a shared_ptr because we make callbacks with bind using
   //   shared_from_this() so the object remains allocated.
   ptr_lib::shared_ptr<SegmentFetcher> segmentFetcher
     (new SegmentFetcher
      (face, validatorKeyChain, SegmentFetcher::DontVerifySegment, onComplete,
-      onError));
+      onError, options));
   segmentFetcher->fetchFirstSegment(baseInterest);
 }
 
 void
 SegmentFetcher::fetchFirstSegment(const Interest& baseInterest)
 {
+  baseInterest_ = baseInterest;
   Interest interest(baseInterest);
   interest.setChildSelector(1);
   interest.setMustBeFresh(true);
 
-  face_.expressInterest
+  // The first Interest may wait for fresh data, so it has no retransmission
+  // timer and only fails when its lifetime expires.
+  uint64_t transmission = ++transmissionCount_;
+  firstInterest_.transmission_ = transmission;
+  firstInterest_.sendTime_ = ndn_getNowMilliseconds();
+  uint64_t pendingInterestId = face_.expressInterest
     (interest,
-     bind(&SegmentFetcher::onSegmentReceived, shared_from_this(), _1, _2),
-     bind(&SegmentFetcher::onTimeout, shared_from_this(), _1));
+     bind(&SegmentFetcher::onSegmentReceived, shared_from_this(), _1, _2, 0,
+          transmission),
+     bind(&SegmentFetcher::onTimeout, shared_from_this(), _1, 0, transmission),
+     bind(&SegmentFetcher::onNetworkNack, shared_from_this(), _1, _2, 0,
+          transmission));
+  // The Data may already have been received.
+  if (firstInterest_.transmission_ == transmission)
+    firstInterest_.pendingInterestId_ = pendingInterestId;
+}
+
+void
+SegmentFetcher::sendInterests()
+{
+  if (isSendingInterests_)
+    // A Data packet was received while sending. The loop below continues.
+    return;
+
+  isSendingInterests_ = true;
+  size_t windowSize = (size_t)max(1.0, windowSize_);
+  while (!isFinished_ && outstanding_.size() < windowSize) {
+    if (!retryQueue_.empty()) {
+      map<uint64_t, int>::iterator retry = retryQueue_.begin();
+      uint64_t segment = retry->first;
+      int nRetries = retry->second;
+      retryQueue_.erase(retry);
+      sendInterest(segment, nRetries);
+      continue;
+    }
+
+    if (hasFinalSegment_ && nextSegment_ > finalSegment_)
+      break;
+    if (options_.getOnSegment() && nextSegment_ > nextDeliverSegment_ &&
+        outstanding_.size() + contentParts_.size() >= windowSize)
+      // The segments waiting in the reorder buffer count toward the window.
+      // A retry or the next segment to deliver is still sent so that the
+      // buffer can drain.
+      break;
+    uint64_t segment = nextSegment_++;
+    if (segment < nextDeliverSegment_ ||
+        contentParts_.find(segment) != contentParts_.end())
+      // We already have it, for example from the first Interest.
+      continue;
+    sendInterest(segment, 0);
+  }
+  isSendingInterests_ = false;
 }
 
 void
-SegmentFetcher::fetchNextSegment
-  (const Interest& originalInterest, const Name& dataName, uint64_t segment)
+SegmentFetcher::sendInterest(uint64_t segment, int nRetries)
 {
   // Start with the original Interest to preserve any special selectors.
-  Interest interest(originalInterest);
+  Interest interest(baseInterest_);
   // Changing a field clears the nonce so that the library will generate a new one.
   interest.setChildSelector(0);
   interest.setMustBeFresh(false);
-  interest.setName(dataName.getPrefix(-1).appendSegment(segment));
+  interest.setName(Name(versionedPrefix_).appendSegment(segment));
 
-  face_.expressInterest
+  uint64_t transmission = ++transmissionCount_;
+  SegmentState& state = outstanding_[segment];
+  state.transmission_ = transmission;
+  state.nRetries_ = nRetries;
+  state.sendTime_ = ndn_getNowMilliseconds();
+
+  face_.callLater
+    (rttEstimator_->getRto(),
+     bind(&SegmentFetcher::onRetransmissionTimeout, shared_from_this(), segment,
+          transmission));
+  uint64_t pendingInterestId = face_.expressInterest
     (interest,
-     bind(&SegmentFetcher::onSegmentReceived, shared_from_this(), _1, _2),
-     bind(&SegmentFetcher::onTimeout, shared_from_this(), _1));
+     bind(&SegmentFetcher::onSegmentReceived, shared_from_this(), _1, _2,
+          segment, transmission),
+     bind(&SegmentFetcher::onTimeout, shared_from_this(), _1, segment,
+          transmission),
+     bind(&SegmentFetcher::onNetworkNack, shared_from_this(), _1, _2, segment,
+          transmission));
+
+  // The Data may already have been received.
+  map<uint64_t, SegmentState>::iterator outstanding = findOutstanding
+    (segment, transmission);
+  if (outstanding != outstanding_.end())
+    outstanding->second.pendingInterestId_ = pendingInterestId;
+}
+
+map<uint64_t, SegmentFetcher::SegmentState>::iterator
+SegmentFetcher::findOutstanding(uint64_t segment, uint64_t transmission)
+{
+  map<uint64_t, SegmentState>::iterator outstanding = outstanding_.find(segment);
+  if (outstanding != outstanding_.end() &&
+      outstanding->second.transmission_ != transmission)
+    // This is for a previous transmission.
+    return outstanding_.end();
+
+  return outstanding;
 }
 
 void
 SegmentFetcher::onSegmentReceived
-  (const ptr_lib::shared_ptr<const Interest>& originalInterest,
-   const ptr_lib::shared_ptr<Data>& data)
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<Data>& data, uint64_t segment,
+   uint64_t transmission)
 {
+  if (isFinished_)
+    return;
+
+  MillisecondsSince1970 nowMilliseconds = ndn_getNowMilliseconds();
+  if (firstInterest_.transmission_ != 0 &&
+      transmission == firstInterest_.transmission_) {
+    firstInterest_.transmission_ = 0;
+    rttEstimator_->addMeasurement(nowMilliseconds - firstInterest_.sendTime_);
+  }
+  else {
+    map<uint64_t, SegmentState>::iterator outstanding = findOutstanding
+      (segment, transmission);
+    if (outstanding == outstanding_.end())
+      // We already gave up on this transmission.
+      return;
+
+    // Following Karn's algorithm, don't measure the RTT of a retry.
+    if (outstanding->second.nRetries_ == 0)
+      rttEstimator_->addMeasurement
+        (nowMilliseconds - outstanding->second.sendTime_);
+    outstanding_.erase(outstanding);
+
+    if (data->getCongestionMark() > 0 && !options_.getIgnoreCongestionMarks())
+      decreaseWindow(segment);
+    else
+      increaseWindow();
+  }
+
   if (validatorKeyChain_)
     validatorKeyChain_->verifyData
       (data,
-       bind(&SegmentFetcher::onVerified, shared_from_this(), _1, originalInterest),
+       bind(&SegmentFetcher::onVerified, shared_from_this(), _1),
        // Cast to disambiguate from the deprecated OnVerifyFailed.
        (const OnDataValidationFailed)bind
          (&SegmentFetcher::onValidationFailed, shared_from_this(), _1, _2));
@@ -112,137 +254,340 @@ SegmentFetcher::onSegmentReceived
       return;
     }
 
-    onVerified(data, originalInterest);
+    onVerified(data);
   }
 }
 
 void
-SegmentFetcher::onVerified
-  (const ptr_lib::shared_ptr<Data>& data,
-   const ptr_lib::shared_ptr<const Interest>& originalInterest)
+SegmentFetcher::onVerified(const ptr_lib::shared_ptr<Data>& data)
 {
+  if (isFinished_)
+    return;
+
   if (!endsWithSegmentNumber(data->getName())) {
     // We don't expect a name without a segment number.  Treat it as a bad packet.
-    try {
-      onError_
-        (DATA_HAS_NO_SEGMENT,
-         string("Got an unexpected packet without a segment number: ") +
-           data->getName().toUri());
-    } catch (const std::exception& ex) {
-      _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError: " << ex.what());
-    } catch (...) {
-      _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError.");
-    }
+    finishWithError
+      (DATA_HAS_NO_SEGMENT,
+       string("Got an unexpected packet without a segment number: ") +
+         data->getName().toUri());
+    return;
   }
-  else {
-    uint64_t currentSegment;
+
+  uint64_t currentSegment;
+  try {
+    currentSegment = data->getName().get(-1).toSegment();
+  }
+  catch (runtime_error& ex) {
+    finishWithError
+      (DATA_HAS_NO_SEGMENT,
+       string("Error decoding the name segment number ") +
+       data->getName().get(-1).toEscapedString() + ": " + ex.what());
+    return;
+  }
+
+  if (versionedPrefix_.size() == 0)
+    // This is the first Data packet, which has the version.
+    versionedPrefix_ = data->getName().getPrefix(-1);
+
+  if (data->getMetaInfo().getFinalBlockId().getValue().size() > 0) {
     try {
-      currentSegment = data->getName().get(-1).toSegment();
+      finalSegment_ = data->getMetaInfo().getFinalBlockId().toSegment();
     }
     catch (runtime_error& ex) {
-      try {
-        onError_
-          (DATA_HAS_NO_SEGMENT,
-           string("Error decoding the name segment number ") +
-           data->getName().get(-1).toEscapedString() + ": " + ex.what());
-      } catch (const std::exception& ex) {
-        _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError: " << ex.what());
-      } catch (...) {
-        _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError.");
-      }
+      finishWithError
+        (DATA_HAS_NO_SEGMENT,
+         string("Error decoding the FinalBlockId segment number ") +
+         data->getMetaInfo().getFinalBlockId().toEscapedString() + ": " +
+         ex.what());
       return;
     }
+    hasFinalSegment_ = true;
 
-    uint64_t expectedSegmentNumber = contentParts_.size();
-    if (currentSegment != expectedSegmentNumber)
-      // Try again to get the expected segment.  This also includes the case
-      //   where the first segment is not segment 0.
-      fetchNextSegment(*originalInterest, data->getName(), expectedSegmentNumber);
-    else {
-      // Save the content and check if we are finished.
-      contentParts_.push_back(data->getContent());
-
-      if (data->getMetaInfo().getFinalBlockId().getValue().size() > 0) {
-        uint64_t finalSegmentNumber;
-        try {
-          finalSegmentNumber = data->getMetaInfo().getFinalBlockId().toSegment();
-        }
-        catch (runtime_error& ex) {
-          try {
-            onError_
-              (DATA_HAS_NO_SEGMENT,
-               string("Error decoding the FinalBlockId segment number ") +
-               data->getMetaInfo().getFinalBlockId().toEscapedString() + ": " +
-               ex.what());
-          } catch (const std::exception& ex) {
-            _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError: " << ex.what());
-          } catch (...) {
-            _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError.");
-          }
-          return;
-        }
-
-        if (currentSegment == finalSegmentNumber) {
-          // We are finished.
-
-          // Get the total size and concatenate to get the content.
-          int totalSize = 0;
-          for (size_t i = 0; i < contentParts_.size(); ++i)
-            totalSize += contentParts_[i].size();
-          ptr_lib::shared_ptr<vector<uint8_t> > content
-            (new std::vector<uint8_t>(totalSize));
-          size_t offset = 0;
-          for (size_t i = 0; i < contentParts_.size(); ++i) {
-            const Blob& part = contentParts_[i];
-            ndn_memcpy(&(*content)[offset], part.buf(), part.size());
-            offset += part.size();
-          }
-
-          try {
-            onComplete_(Blob(content, false));
-          } catch (const std::exception& ex) {
-            _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onComplete: " << ex.what());
-          } catch (...) {
-            _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onComplete.");
-          }
-          return;
-        }
-      }
-
-      // Fetch the next segment.
-      fetchNextSegment
-        (*originalInterest, data->getName(), expectedSegmentNumber + 1);
+    // Stop fetching the segments after the final segment.
+    map<uint64_t, SegmentState>::iterator outstanding =
+      outstanding_.upper_bound(finalSegment_);
+    while (outstanding != outstanding_.end()) {
+      face_.removePendingInterest(outstanding->second.pendingInterestId_);
+      outstanding_.erase(outstanding++);
     }
+    retryQueue_.erase(retryQueue_.upper_bound(finalSegment_), retryQueue_.end());
   }
+
+  if (!(hasFinalSegment_ && currentSegment > finalSegment_) &&
+      currentSegment >= nextDeliverSegment_)
+    // Save the content. A duplicate does not replace the first.
+    contentParts_.insert(map<uint64_t, Blob>::value_type
+      (currentSegment, data->getContent()));
+
+  if (options_.getOnSegment()) {
+    if (!deliverSegments())
+      return;
+
+    if (hasFinalSegment_ && nextDeliverSegment_ == finalSegment_ + 1) {
+      finishWithContent();
+      return;
+    }
+  }
+  else if (hasFinalSegment_ && contentParts_.size() == finalSegment_ + 1) {
+    // We are finished.
+    finishWithContent();
+    return;
+  }
+
+  sendInterests();
 }
 
 void
 SegmentFetcher::onValidationFailed
   (const ptr_lib::shared_ptr<Data>& data, const string& reason)
 {
+  finishWithError
+    (SEGMENT_VERIFICATION_FAILED,
+     "Segment verification failed for " + data->getName().toUri() +
+     " . Reason: " + reason);
+}
+
+void
+SegmentFetcher::onTimeout
+  (const ptr_lib::shared_ptr<const Interest>& interest, uint64_t segment,
+   uint64_t transmission)
+{
+  if (isFinished_)
+    return;
+
+  string message = string("Time out for interest ") + interest->getName().toUri();
+  if (firstInterest_.transmission_ != 0 &&
+      transmission == firstInterest_.transmission_) {
+    finishWithError(INTEREST_TIMEOUT, message);
+    return;
+  }
+
+  map<uint64_t, SegmentState>::iterator outstanding = findOutstanding
+    (segment, transmission);
+  if (outstanding == outstanding_.end())
+    return;
+
+  if (segment >= recoveryPoint_)
+    // Back off once per loss event, the same as decreaseWindow, which
+    // onSegmentLost calls to move the recovery point.
+    rttEstimator_->backoffRto();
+  onSegmentLost(outstanding, true, INTEREST_TIMEOUT, message);
+  sendInterests();
+}
+
+void
+SegmentFetcher::onNetworkNack
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<NetworkNack>& networkNack, uint64_t segment,
+   uint64_t transmission)
+{
+  if (isFinished_)
+    return;
+
+  ostringstream message;
+  message << "Received a Nack with reason " << networkNack->getReason() <<
+    " for interest " << interest->getName().toUri();
+  if (firstInterest_.transmission_ != 0 &&
+      transmission == firstInterest_.transmission_) {
+    finishWithError(NACK_ERROR, message.str());
+    return;
+  }
+
+  map<uint64_t, SegmentState>::iterator outstanding = findOutstanding
+    (segment, transmission);
+  if (outstanding == outstanding_.end())
+    return;
+
+  if (networkNack->getReason() == ndn_NetworkNackReason_CONGESTION)
+    onSegmentLost(outstanding, true, NACK_ERROR, message.str());
+  else if (networkNack->getReason() == ndn_NetworkNackReason_DUPLICATE)
+    // Retry with a new nonce.
+    onSegmentLost(outstanding, false, NACK_ERROR, message.str());
+  else {
+    finishWithError(NACK_ERROR, message.str());
+    return;
+  }
+
+  sendInterests();
+}
+
+void
+SegmentFetcher::onRetransmissionTimeout(uint64_t segment, uint64_t transmission)
+{
+  if (isFinished_)
+    return;
+
+  map<uint64_t, SegmentState>::iterator outstanding = findOutstanding
+    (segment, transmission);
+  if (outstanding == outstanding_.end())
+    // The Data was received or the segment was already retried.
+    return;
+
+  face_.removePendingInterest(outstanding->second.pendingInterestId_);
+  if (segment >= recoveryPoint_)
+    // Back off once per loss event, the same as decreaseWindow.
+    rttEstimator_->backoffRto();
+  ostringstream message;
+  message << "Time out for segment " << segment << " of " <<
+    versionedPrefix_.toUri();
+  onSegmentLost(outstanding, true, INTEREST_TIMEOUT, message.str());
+  sendInterests();
+}
+
+void
+SegmentFetcher::onSegmentLost
+  (map<uint64_t, SegmentState>::iterator outstanding, bool isCongestion,
+   ErrorCode errorCode, const string& message)
+{
+  uint64_t segment = outstanding->first;
+  int nRetries = outstanding->second.nRetries_;
+  outstanding_.erase(outstanding);
+
+  if (nRetries >= options_.getMaxRetries()) {
+    finishWithError(errorCode, message);
+    return;
+  }
+
+  _LOG_TRACE("SegmentFetcher: Retry segment " << segment << ": " << message);
+  if (isCongestion)
+    decreaseWindow(segment);
+  retryQueue_[segment] = nRetries + 1;
+}
+
+void
+SegmentFetcher::decreaseWindow(uint64_t segment)
+{
+  if (segment < recoveryPoint_)
+    // We already decreased the window for a loss in this window.
+    return;
+
+  slowStartThreshold_ = max
+    (2.0, windowSize_ * options_.getMultiplicativeDecreaseFactor());
+  windowSize_ = min(slowStartThreshold_, options_.getMaxWindowSize());
+  recoveryPoint_ = nextSegment_;
+}
+
+void
+SegmentFetcher::increaseWindow()
+{
+  if (windowSize_ < slowStartThreshold_)
+    // Slow start.
+    windowSize_ += options_.getAdditiveIncreaseStep();
+  else
+    // Congestion avoidance.
+    windowSize_ += options_.getAdditiveIncreaseStep() / windowSize_;
+
+  windowSize_ = min(windowSize_, options_.getMaxWindowSize());
+}
+
+void
+SegmentFetcher::finishWithError(ErrorCode errorCode, const string& message)
+{
+  isFinished_ = true;
+  if (firstInterest_.transmission_ != 0)
+    face_.removePendingInterest(firstInterest_.pendingInterestId_);
+  for (map<uint64_t, SegmentState>::iterator outstanding = outstanding_.begin();
+       outstanding != outstanding_.end(); ++outstanding)
+    face_.removePendingInterest(outstanding->second.pendingInterestId_);
+  outstanding_.clear();
+  retryQueue_.clear();
+  contentParts_.clear();
+
   try {
-    onError_
-      (SEGMENT_VERIFICATION_FAILED,
-       "Segment verification failed for " + data->getName().toUri() +
-       " . Reason: " + reason);
+    onError_(errorCode, message);
   } catch (const std::exception& ex) {
-    _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError: " << ex.what());
+    _LOG_ERROR("SegmentFetcher: Error in onError: " << ex.what());
   } catch (...) {
-    _LOG_ERROR("SegmentFetcher::onSegmentReceived: Error in onError.");
+    _LOG_ERROR("SegmentFetcher: Error in onError.");
+  }
+}
+
+bool
+SegmentFetcher::deliverSegments()
+{
+  while (true) {
+    map<uint64_t, Blob>::iterator part = contentParts_.find(nextDeliverSegment_);
+    if (part == contentParts_.end())
+      return true;
+
+    Blob content = part->second;
+    contentParts_.erase(part);
+    uint64_t segment = nextDeliverSegment_++;
+    try {
+      options_.getOnSegment()(segment, content);
+    } catch (const std::exception& ex) {
+      finishWithError(ON_SEGMENT_ERROR, string("Error in onSegment: ") + ex.what());
+      return false;
+    } catch (...) {
+      finishWithError(ON_SEGMENT_ERROR, "Error in onSegment.");
+      return false;
+    }
   }
 }
 
 void
-SegmentFetcher::onTimeout(const ptr_lib::shared_ptr<const Interest>& interest)
+SegmentFetcher::writeToFileDescriptor
+  (int fileDescriptor, uint64_t segment, const Blob& content)
 {
+#if NDN_CPP_HAVE_UNISTD_H
+  size_t offset = 0;
+  while (offset < content.size()) {
+    ssize_t nBytes = ::write
+      (fileDescriptor, content.buf() + offset, content.size() - offset);
+    if (nBytes < 0) {
+      if (errno == EINTR)
+        continue;
+      ostringstream message;
+      message << "Error writing segment " << segment <<
+        " to the file descriptor: " << strerror(errno);
+      throw runtime_error(message.str());
+    }
+
+    offset += nBytes;
+  }
+#else
+  throw runtime_error
+    ("SegmentFetcher::makeFileDescriptorSink is not supported on this platform");
+#endif
+}
+
+void
+SegmentFetcher::finishWithContent()
+{
+  isFinished_ = true;
+  if (options_.getOnSegment()) {
+    // The content was already delivered.
+    try {
+      onComplete_(Blob());
+    } catch (const std::exception& ex) {
+      _LOG_ERROR("SegmentFetcher: Error in onComplete: " << ex.what());
+    } catch (...) {
+      _LOG_ERROR("SegmentFetcher: Error in onComplete.");
+    }
+    return;
+  }
+
+  // Get the total size and concatenate to get the content.
+  size_t totalSize = 0;
+  for (map<uint64_t, Blob>::iterator part = contentParts_.begin();
+       part != contentParts_.end(); ++part)
+    totalSize += part->second.size();
+  ptr_lib::shared_ptr<vector<uint8_t> > content
+    (new std::vector<uint8_t>(totalSize));
+  size_t offset = 0;
+  for (map<uint64_t, Blob>::iterator part = contentParts_.begin();
+       part != contentParts_.end(); ++part) {
+    ndn_memcpy(&(*content)[offset], part->second.buf(), part->second.size());
+    offset += part->second.size();
+  }
+  contentParts_.clear();
+
   try {
-    onError_
-      (INTEREST_TIMEOUT,
-       string("Time out for interest ") + interest->getName().toUri());
+    onComplete_(Blob(content, false));
   } catch (const std::exception& ex) {
-    _LOG_ERROR("SegmentFetcher::onTimeout: Error in onError: " << ex.what());
+    _LOG_ERROR("SegmentFetcher: Error in onComplete: " << ex.what());
   } catch (...) {
-    _LOG_ERROR("SegmentFetcher::onTimeout: Error in onError.");
+    _LOG_ERROR("SegmentFetcher: Error in onComplete.");
   }
 }
 
@@ -0,0 +1,526 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include <stdexcept>
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include <ndn-cpp/util/logging.hpp>
+#include <ndn-cpp/util/segmenter.hpp>
+
+using namespace std;
+using namespace ndn::func_lib;
+
+INIT_LOGGER("ndn.Segmenter");
+
+namespace ndn {
+
+/**
+ * A SignTask makes and signs a range of segments on one thread. It has its own
+ * copies of the name and signature so that the threads don't share objects
+ * other than the buffer and the Tpm.
+ */
+class Segmenter::SignTask {
+public:
+  SignTask
+    (Segmenter& segmenter, const uint8_t* buffer, size_t bufferLength,
+     const Name& versionedPrefix, size_t maxSegmentSize,
+     Milliseconds freshnessPeriod, const Signature& signatureTemplate,
+     const Name& keyName, vector<ptr_lib::shared_ptr<Data> >& segments,
+     size_t firstIndex, uint64_t beginSegment, uint64_t endSegment)
+  : segmenter_(segmenter), buffer_(buffer), bufferLength_(bufferLength),
+    versionedPrefix_(versionedPrefix), maxSegmentSize_(maxSegmentSize),
+    freshnessPeriod_(freshnessPeriod),
+    signatureTemplate_(signatureTemplate.clone()), keyName_(keyName), segments_(segments), firstIndex_(firstIndex),
+    beginSegment_(beginSegment), endSegment_(endSegment), isDone_(false)
+  {
+  }
+
+  void
+  run()
+  {
+    try {
+      for (uint64_t segment = beginSegment_; segment < endSegment_; ++segment) {
+        ptr_lib::shared_ptr<Data> data = makeSegment
+          (buffer_, bufferLength_, versionedPrefix_, maxSegmentSize_,
+           freshnessPeriod_, segment);
+        segmenter_.signLikeFirstSegment(*data, *signatureTemplate_, keyName_);
+        // Each task writes a different element, which was already allocated.
+        segments_[firstIndex_ + segment] = data;
+      }
+    } catch (const std::exception& ex) {
+      error_ = ex.what();
+    } catch (...) {
+      error_ = "Unknown error";
+    }
+  }
+
+  Segmenter& segmenter_;
+  const uint8_t* buffer_;
+  size_t bufferLength_;
+  Name versionedPrefix_;
+  size_t maxSegmentSize_;
+  Milliseconds freshnessPeriod_;
+  ptr_lib::shared_ptr<Signature> signatureTemplate_;
+  Name keyName_;
+  vector<ptr_lib::shared_ptr<Data> >& segments_;
+  size_t firstIndex_;
+  uint64_t beginSegment_;
+  uint64_t endSegment_;
+  string error_;
+  // isDone_ is set by the WorkerPool after run() returns.
+  bool isDone_;
+};
+
+#if NDN_CPP_HAVE_UNISTD_H
+/**
+ * A WorkerPool has the Segmenter's worker threads, which are started once by
+ * the constructor and wait for SignTasks in a queue until the destructor.
+ */
+class Segmenter::WorkerPool {
+public:
+  WorkerPool(size_t nWorkers)
+  : isStopping_(false)
+  {
+    pthread_mutex_init(&mutex_, 0);
+    pthread_cond_init(&taskAdded_, 0);
+    pthread_cond_init(&taskDone_, 0);
+
+    for (size_t i = 0; i < nWorkers; ++i) {
+      pthread_t thread;
+      if (pthread_create(&thread, 0, &WorkerPool::runWorker, this) == 0)
+        threads_.push_back(thread);
+      else
+        // The calling thread of run() will do the remaining work.
+        _LOG_ERROR("Segmenter: Cannot create a worker thread");
+    }
+  }
+
+  ~WorkerPool()
+  {
+    pthread_mutex_lock(&mutex_);
+    isStopping_ = true;
+    pthread_cond_broadcast(&taskAdded_);
+    pthread_mutex_unlock(&mutex_);
+
+    for (size_t i = 0; i < threads_.size(); ++i)
+      pthread_join(threads_[i], 0);
+
+    pthread_cond_destroy(&taskDone_);
+    pthread_cond_destroy(&taskAdded_);
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  /**
+   * Queue tasks[1] onward for the workers, run tasks[0] on the calling thread
+   * and wait for all the tasks to be done. While waiting, the calling thread
+   * also runs queued tasks, so the tasks finish even if the workers are busy
+   * with another call or could not be created.
+   * @param tasks The tasks to run, which must remain valid until this returns.
+   */
+  void
+  run(const vector<ptr_lib::shared_ptr<SignTask> >& tasks)
+  {
+    pthread_mutex_lock(&mutex_);
+    for (size_t i = 1; i < tasks.size(); ++i)
+      queue_.push_back(tasks[i].get());
+    pthread_cond_broadcast(&taskAdded_);
+    pthread_mutex_unlock(&mutex_);
+
+    tasks[0]->run();
+
+    pthread_mutex_lock(&mutex_);
+    tasks[0]->isDone_ = true;
+    size_t iTask = 1;
+    while (true) {
+      // Skip the tasks which are done.
+      while (iTask < tasks.size() && tasks[iTask]->isDone_)
+        ++iTask;
+      if (iTask >= tasks.size())
+        break;
+
+      if (queue_.size() > 0)
+        runNextTask();
+      else
+        pthread_cond_wait(&taskDone_, &mutex_);
+    }
+    pthread_mutex_unlock(&mutex_);
+  }
+
+private:
+  static void*
+  runWorker(void* pool)
+  {
+    ((WorkerPool*)pool)->work();
+    return 0;
+  }
+
+  void
+  work()
+  {
+    pthread_mutex_lock(&mutex_);
+    while (true) {
+      while (queue_.size() == 0 && !isStopping_)
+        pthread_cond_wait(&taskAdded_, &mutex_);
+      if (queue_.size() == 0)
+        // Stopping.
+        break;
+
+      runNextTask();
+    }
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  /**
+   * Pop the next task from the queue and run it with the mutex unlocked. The
+   * mutex must be locked on entry, and is locked on return.
+   */
+  void
+  runNextTask()
+  {
+    SignTask* task = queue_.front();
+    queue_.pop_front();
+    pthread_mutex_unlock(&mutex_);
+
+    task->run();
+
+    pthread_mutex_lock(&mutex_);
+    task->isDone_ = true;
+    pthread_cond_broadcast(&taskDone_);
+  }
+
+  // mutex_ protects queue_, isStopping_ and each queued task's isDone_.
+  pthread_mutex_t mutex_;
+  pthread_cond_t taskAdded_;
+  pthread_cond_t taskDone_;
+  deque<SignTask*> queue_;
+  bool isStopping_;
+  vector<pthread_t> threads_;
+};
+#endif
+
+Segmenter::Segmenter
+  (KeyChain& keyChain, const SigningInfo& signingInfo, size_t nThreads)
+: keyChain_(keyChain), signingInfo_(signingInfo),
+  nThreads_(nThreads > 0 ? nThreads : 1)
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  if (nThreads_ > 1)
+    // The thread calling segment is also used for signing.
+    workerPool_.reset(new WorkerPool(nThreads_ - 1));
+#endif
+}
+
+Segmenter::~Segmenter()
+{
+}
+
+/**
+ * A Server is the OnInterest callback for setInterestFilter, which makes and
+ * signs the requested segment.
+ */
+class Segmenter::Server {
+public:
+  Server
+    (KeyChain& keyChain, const SigningInfo& signingInfo, const Blob& content,
+     const Name& versionedPrefix, size_t maxSegmentSize,
+     Milliseconds freshnessPeriod)
+  : keyChain_(keyChain), signingInfo_(signingInfo), content_(content),
+    versionedPrefix_(versionedPrefix), maxSegmentSize_(maxSegmentSize),
+    freshnessPeriod_(freshnessPeriod),
+    nSegments_(getSegmentCount(content.size(), maxSegmentSize))
+  {
+  }
+
+  void
+  onInterest
+    (const ptr_lib::shared_ptr<const Name>& prefix,
+     const ptr_lib::shared_ptr<const Interest>& interest, Face& face,
+     uint64_t interestFilterId,
+     const ptr_lib::shared_ptr<const InterestFilter>& filter)
+  {
+    const Name& name = interest->getName();
+    uint64_t segment;
+    if (name.size() > versionedPrefix_.size() &&
+        versionedPrefix_.isPrefixOf(name) &&
+        name.get(versionedPrefix_.size()).isSegment())
+      segment = name.get(versionedPrefix_.size()).toSegment();
+    else if (name.isPrefixOf(versionedPrefix_))
+      // This is the first Interest to discover the version.
+      segment = 0;
+    else
+      return;
+
+    if (segment >= nSegments_)
+      return;
+
+    try {
+      ptr_lib::shared_ptr<Data> data = makeSegment
+        (content_.buf(), content_.size(), versionedPrefix_, maxSegmentSize_,
+         freshnessPeriod_, segment);
+      keyChain_.sign(*data, signingInfo_);
+      if (interest->matchesData(*data))
+        face.send(*data->wireEncode());
+    } catch (const std::exception& ex) {
+      _LOG_ERROR("Segmenter: Error serving segment " << segment << " of " <<
+                 versionedPrefix_.toUri() << ": " << ex.what());
+    }
+  }
+
+private:
+  KeyChain& keyChain_;
+  SigningInfo signingInfo_;
+  Blob content_;
+  Name versionedPrefix_;
+  size_t maxSegmentSize_;
+  Milliseconds freshnessPeriod_;
+  uint64_t nSegments_;
+};
+
+void
+Segmenter::segment
+  (const Blob& content, const Name& versionedPrefix, size_t maxSegmentSize,
+   Milliseconds freshnessPeriod, vector<ptr_lib::shared_ptr<Data> >& segments)
+{
+  segment
+    (content.buf(), content.size(), versionedPrefix, maxSegmentSize,
+     freshnessPeriod, segments);
+}
+
+void
+Segmenter::segmentFile
+  (const string& filePath, const Name& versionedPrefix, size_t maxSegmentSize,
+   Milliseconds freshnessPeriod, vector<ptr_lib::shared_ptr<Data> >& segments)
+{
+#if NDN_CPP_HAVE_UNISTD_H
+  int fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+    throw runtime_error("Segmenter: Cannot open the file " + filePath);
+  struct stat fileStat;
+  if (::fstat(fileDescriptor, &fileStat) != 0) {
+    ::close(fileDescriptor);
+    throw runtime_error("Segmenter: Cannot get the size of the file " + filePath);
+  }
+
+  size_t fileSize = (size_t)fileStat.st_size;
+  void* mapped = 0;
+  if (fileSize > 0) {
+    mapped = ::mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fileDescriptor);
+      throw runtime_error("Segmenter: Cannot map the file " + filePath);
+    }
+  }
+  // The mapping remains valid after closing the file.
+  ::close(fileDescriptor);
+
+  try {
+    segment
+      ((const uint8_t*)mapped, fileSize, versionedPrefix, maxSegmentSize,
+       freshnessPeriod, segments);
+  } catch (...) {
+    if (mapped)
+      ::munmap(mapped, fileSize);
+    throw;
+  }
+  if (mapped)
+    ::munmap(mapped, fileSize);
+#else
+  ifstream file(filePath.c_str(), ios::in | ios::binary);
+  if (!file.good())
+    throw runtime_error("Segmenter: Cannot open the file " + filePath);
+  vector<uint8_t> content
+    ((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+  segment
+    (content.size() > 0 ? &content[0] : 0, content.size(), versionedPrefix,
+     maxSegmentSize, freshnessPeriod, segments);
+#endif
+}
+
+size_t
+Segmenter::addToCache
+  (const Blob& content, const Name& versionedPrefix, size_t maxSegmentSize,
+   Milliseconds freshnessPeriod, MemoryContentCache& memoryContentCache)
+{
+  vector<ptr_lib::shared_ptr<Data> > segments;
+  segment(content, versionedPrefix, maxSegmentSize, freshnessPeriod, segments);
+
+  for (size_t i = 0; i < segments.size(); ++i)
+    memoryContentCache.add(*segments[i]);
+
+  return segments.size();
+}
+
+uint64_t
+Segmenter::setInterestFilter
+  (Face& face, const Blob& content, const Name& versionedPrefix,
+   size_t maxSegmentSize, Milliseconds freshnessPeriod)
+{
+  if (maxSegmentSize == 0)
+    throw runtime_error("Segmenter: maxSegmentSize must be greater than 0");
+
+  ptr_lib::shared_ptr<Server> server(new Server
+    (keyChain_, signingInfo_, content, versionedPrefix, maxSegmentSize,
+     freshnessPeriod));
+  Name filterPrefix = versionedPrefix;
+  if (versionedPrefix.size() > 0 && versionedPrefix.get(-1).isVersion())
+    filterPrefix = versionedPrefix.getPrefix(-1);
+
+  return face.setInterestFilter
+    (filterPrefix, bind(&Server::onInterest, server, _1, _2, _3, _4, _5));
+}
+
+void
+Segmenter::segment
+  (const uint8_t* buffer, size_t bufferLength, const Name& versionedPrefix,
+   size_t maxSegmentSize, Milliseconds freshnessPeriod,
+   vector<ptr_lib::shared_ptr<Data> >& segments)
+{
+  if (maxSegmentSize == 0)
+    throw runtime_error("Segmenter: maxSegmentSize must be greater than 0");
+
+  uint64_t nSegments = getSegmentCount(bufferLength, maxSegmentSize);
+  size_t firstIndex = segments.size();
+
+  // Sign the first segment with the KeyChain, which also loads the key so
+  // that the other threads only need the Tpm.
+  ptr_lib::shared_ptr<Data> firstSegment = makeSegment
+    (buffer, bufferLength, versionedPrefix, maxSegmentSize, freshnessPeriod, 0);
+  keyChain_.sign(*firstSegment, signingInfo_);
+  segments.resize(firstIndex + nSegments);
+  segments[firstIndex] = firstSegment;
+  if (nSegments == 1)
+    return;
+
+  const Signature* signature = firstSegment->getSignature();
+  Name keyName;
+  bool canSignWithTpm = !keyChain_.getIsSecurityV1();
+  if (dynamic_cast<const DigestSha256Signature*>(signature))
+    keyName = SigningInfo::getDigestSha256Identity();
+  else if (KeyLocator::canGetFromSignature(signature) &&
+           KeyLocator::getFromSignature(signature).getType() ==
+             ndn_KeyLocatorType_KEYNAME)
+    keyName = KeyLocator::getFromSignature(signature).getKeyName();
+  else
+    canSignWithTpm = false;
+
+  if (!canSignWithTpm) {
+    // Use the KeyChain for each segment on this thread.
+    for (uint64_t segment = 1; segment < nSegments; ++segment) {
+      ptr_lib::shared_ptr<Data> data = makeSegment
+        (buffer, bufferLength, versionedPrefix, maxSegmentSize,
+         freshnessPeriod, segment);
+      keyChain_.sign(*data, signingInfo_);
+      segments[firstIndex + segment] = data;
+    }
+    return;
+  }
+
+  // Split the remaining segments evenly among the tasks.
+  size_t nTasks = (size_t)min((uint64_t)nThreads_, nSegments - 1);
+  vector<ptr_lib::shared_ptr<SignTask> > tasks;
+  for (size_t i = 0; i < nTasks; ++i)
+    tasks.push_back(ptr_lib::make_shared<SignTask>
+      (*this, buffer, bufferLength, versionedPrefix, maxSegmentSize,
+       freshnessPeriod, *signature, keyName, segments, firstIndex,
+       1 + (nSegments - 1) * i / nTasks,
+       1 + (nSegments - 1) * (i + 1) / nTasks));
+
+#if NDN_CPP_HAVE_UNISTD_H
+  if (workerPool_)
+    workerPool_->run(tasks);
+  else
+#endif
+  {
+    for (size_t i = 0; i < nTasks; ++i)
+      tasks[i]->run();
+  }
+
+  for (size_t i = 0; i < nTasks; ++i) {
+    if (!tasks[i]->error_.empty()) {
+      segments.resize(firstIndex);
+      throw runtime_error("Segmenter: Error signing: " + tasks[i]->error_);
+    }
+  }
+}
+
+ptr_lib::shared_ptr<Data>
+Segmenter::makeSegment
+  (const uint8_t* buffer, size_t bufferLength, const Name& versionedPrefix,
+   size_t maxSegmentSize, Milliseconds freshnessPeriod, uint64_t segment)
+{
+  size_t offset = (size_t)segment * maxSegmentSize;
+  size_t segmentSize = min(maxSegmentSize, bufferLength - offset);
+
+  ptr_lib::shared_ptr<Data> data(new Data
+    (Name(versionedPrefix).appendSegment(segment)));
+  // Copy the segment's content directly from the buffer.
+  if (segmentSize > 0)
+    data->setContent(Blob(buffer + offset, segmentSize));
+  data->getMetaInfo().setFinalBlockId(Name::Component::fromSegment
+    (getSegmentCount(bufferLength, maxSegmentSize) - 1));
+  if (freshnessPeriod >= 0)
+    data->getMetaInfo().setFreshnessPeriod(freshnessPeriod);
+
+  return data;
+}
+
+void
+Segmenter::signLikeFirstSegment
+  (Data& data, const Signature& signatureTemplate, const Name& keyName)
+{
+  data.setSignature(signatureTemplate);
+
+  // Encode once to get the signed portion.
+  SignedBlob encoding = data.wireEncode();
+
+  Blob signatureBytes;
+  if (keyName == SigningInfo::getDigestSha256Identity()) {
+    uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+    CryptoLite::digestSha256
+      (encoding.signedBuf(), encoding.signedSize(), digest);
+    signatureBytes = Blob(digest, sizeof(digest));
+  }
+  else {
+    signatureBytes = keyChain_.getTpm().sign
+      (encoding.signedBuf(), encoding.signedSize(), keyName,
+       signingInfo_.getDigestAlgorithm());
+    if (signatureBytes.isNull())
+      throw runtime_error("Cannot sign with key " + keyName.toUri());
+  }
+  data.getSignature()->setSignature(signatureBytes);
+
+  // Encode again to include the signature.
+  data.wireEncode();
+}
+
+}
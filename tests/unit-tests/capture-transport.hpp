@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_CAPTURE_TRANSPORT_HPP
+#define NDN_CAPTURE_TRANSPORT_HPP
+
+#include <vector>
+#include <ndn-cpp/interest.hpp>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/transport/transport.hpp>
+#include "../../src/encoding/element-listener.hpp"
+
+/**
+ * CaptureTransport is a Transport which saves each sent packet and lets the
+ * test give incoming packets to the Face.
+ */
+class CaptureTransport : public ndn::Transport {
+public:
+  CaptureTransport()
+  : elementListener_(0)
+  {
+  }
+
+  virtual bool
+  isLocal(const ndn::Transport::ConnectionInfo& connectionInfo) { return true; }
+
+  virtual bool
+  isAsync() { return false; }
+
+  virtual void
+  connect
+    (const ndn::Transport::ConnectionInfo& connectionInfo,
+     ndn::ElementListener& elementListener, const OnConnected& onConnected)
+  {
+    elementListener_ = &elementListener;
+    if (onConnected)
+      onConnected();
+  }
+
+  virtual void
+  send(const uint8_t *data, size_t dataLength)
+  {
+    sentPackets_.push_back(ndn::Blob(data, dataLength));
+  }
+
+  virtual void
+  processEvents() {}
+
+  virtual bool
+  getIsConnected() { return elementListener_ != 0; }
+
+  virtual void
+  close() {}
+
+  /**
+   * Decode the last sent packet as an Interest.
+   * @return A new Interest.
+   */
+  ndn::ptr_lib::shared_ptr<ndn::Interest>
+  getLastSentInterest()
+  {
+    ndn::ptr_lib::shared_ptr<ndn::Interest> interest(new ndn::Interest());
+    interest->wireDecode(sentPackets_.back());
+    return interest;
+  }
+
+  /**
+   * Give the packet to the Face as if it was received.
+   */
+  void
+  receive(const ndn::Blob& encoding)
+  {
+    elementListener_->onReceivedElement(encoding.buf(), encoding.size());
+  }
+
+  /**
+   * Give a Data packet with the name to the Face as if it was received.
+   */
+  void
+  receiveData(const ndn::Name& name)
+  {
+    ndn::Data data(name);
+    data.setSignature(ndn::DigestSha256Signature());
+    receive(data.wireEncode());
+  }
+
+  std::vector<ndn::Blob> sentPackets_;
+
+private:
+  ndn::ElementListener* elementListener_;
+};
+
+#endif
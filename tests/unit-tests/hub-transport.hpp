@@ -0,0 +1,167 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#ifndef NDN_HUB_TRANSPORT_HPP
+#define NDN_HUB_TRANSPORT_HPP
+
+#include <deque>
+#include <vector>
+#include <ndn-cpp/interest.hpp>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/control-response.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/transport/transport.hpp>
+#include "../../src/encoding/element-listener.hpp"
+
+class HubTransport;
+
+/**
+ * A Hub connects the transports of Faces in the same process. Each packet sent
+ * by one transport is queued and delivered to all the other transports which
+ * are online, except that a prefix registration command is answered with a
+ * success response.
+ */
+class Hub {
+public:
+  void
+  send(HubTransport* from, const ndn::Blob& packet)
+  {
+    queue_.push_back(std::make_pair(from, packet));
+  }
+
+  /**
+   * Deliver the queued packets, including packets queued while delivering.
+   * @return True if any packet was delivered.
+   */
+  bool
+  deliver();
+
+  std::vector<HubTransport*> transports_;
+
+private:
+  std::deque<std::pair<HubTransport*, ndn::Blob> > queue_;
+};
+
+/**
+ * A HubTransport is the Transport of a Face on a Hub. It counts the Data
+ * packets that it sends.
+ */
+class HubTransport : public ndn::Transport {
+public:
+  HubTransport(Hub& hub)
+  : isOnline_(true), nDataSent_(0), hub_(hub), elementListener_(0)
+  {
+    hub_.transports_.push_back(this);
+  }
+
+  virtual bool
+  isLocal(const ndn::Transport::ConnectionInfo& connectionInfo) { return true; }
+
+  virtual bool
+  isAsync() { return false; }
+
+  virtual void
+  connect
+    (const ndn::Transport::ConnectionInfo& connectionInfo,
+     ndn::ElementListener& elementListener, const OnConnected& onConnected)
+  {
+    elementListener_ = &elementListener;
+    if (onConnected)
+      onConnected();
+  }
+
+  virtual void
+  send(const uint8_t *data, size_t dataLength)
+  {
+    if (!isOnline_)
+      return;
+
+    // 6 is the TLV type of a Data packet.
+    if (dataLength > 0 && data[0] == 6)
+      ++nDataSent_;
+    hub_.send(this, ndn::Blob(data, dataLength));
+  }
+
+  virtual void
+  processEvents() {}
+
+  virtual bool
+  getIsConnected() { return elementListener_ != 0; }
+
+  virtual void
+  close() {}
+
+  /**
+   * Give the packet to the Face as if it was received.
+   */
+  void
+  receive(const ndn::Blob& encoding)
+  {
+    if (elementListener_ && isOnline_)
+      elementListener_->onReceivedElement(encoding.buf(), encoding.size());
+  }
+
+  // If false, drop the packets sent and received.
+  bool isOnline_;
+  int nDataSent_;
+
+private:
+  Hub& hub_;
+  ndn::ElementListener* elementListener_;
+};
+
+inline bool
+Hub::deliver()
+{
+  static const ndn::Name registerPrefix("/localhost/nfd/rib/register");
+  bool delivered = false;
+
+  while (!queue_.empty()) {
+    HubTransport* from = queue_.front().first;
+    ndn::Blob packet = queue_.front().second;
+    queue_.pop_front();
+    delivered = true;
+
+    // 5 is the TLV type of an Interest.
+    if (packet.size() > 0 && packet.buf()[0] == 5) {
+      ndn::Interest interest;
+      interest.wireDecode(packet);
+      if (registerPrefix.match(interest.getName())) {
+        ndn::ControlResponse response;
+        response.setStatusCode(200);
+        response.setStatusText("OK");
+        ndn::Data data(interest.getName());
+        data.setContent(response.wireEncode());
+        data.setSignature(ndn::DigestSha256Signature());
+        from->receive(data.wireEncode());
+        continue;
+      }
+    }
+
+    for (size_t i = 0; i < transports_.size(); ++i) {
+      if (transports_[i] != from)
+        transports_[i]->receive(packet);
+    }
+  }
+
+  return delivered;
+}
+
+#endif
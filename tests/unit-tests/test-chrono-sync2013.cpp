@@ -0,0 +1,199 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <ndn-cpp/security/key-chain.hpp>
+#include <ndn-cpp/sync/chrono-sync2013.hpp>
+#include "../../src/c/util/time.h"
+#include "hub-transport.hpp"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+/**
+ * A Member has a Face on the Hub and a ChronoSync2013 with the application
+ * data prefix /test/<name> and session number 1.
+ */
+class Member {
+public:
+  Member(Hub& hub, KeyChain& keyChain, const string& name)
+  : transport_(new HubTransport(hub)),
+    face_(transport_, ptr_lib::make_shared<Transport::ConnectionInfo>()),
+    isInitialized_(false)
+  {
+    face_.setCommandSigningInfo(keyChain, keyChain.getDefaultCertificateName());
+    sync_.reset(new ChronoSync2013
+      (bind(&Member::onReceivedSyncState, this, _1, _2),
+       bind(&Member::onInitialized, this), Name("/test").append(name),
+       Name("/test/broadcast"), 1, face_, keyChain,
+       keyChain.getDefaultCertificateName(), 1000, onRegisterFailed));
+  }
+
+  void
+  onInitialized() { isInitialized_ = true; }
+
+  void
+  onReceivedSyncState
+    (const vector<ChronoSync2013::SyncState>& syncStates, bool isRecovery)
+  {
+  }
+
+  static void
+  onRegisterFailed(const ptr_lib::shared_ptr<const Name>& prefix)
+  {
+    FAIL() << "Register failed for " << prefix->toUri();
+  }
+
+  ptr_lib::shared_ptr<HubTransport> transport_;
+  Face face_;
+  ptr_lib::shared_ptr<ChronoSync2013> sync_;
+  bool isInitialized_;
+};
+
+class TestChronoSync2013 : public ::testing::Test {
+public:
+  TestChronoSync2013()
+  : keyChain_("pib-memory:", "tpm-memory:")
+  {
+    keyChain_.createIdentityV2(Name("/test"), EcKeyParams());
+  }
+
+  ptr_lib::shared_ptr<Member>
+  addMember(const string& name)
+  {
+    ptr_lib::shared_ptr<Member> member(new Member(hub_, keyChain_, name));
+    members_.push_back(member);
+    return member;
+  }
+
+  /**
+   * Deliver packets and process events on all the faces until isDone returns
+   * true or until the timeout.
+   * @param isDone The function to check if finished.
+   * @param timeoutMilliseconds The maximum time to wait.
+   * @return The final value of isDone().
+   */
+  bool
+  processEventsUntil
+    (const func_lib::function<bool()>& isDone, Milliseconds timeoutMilliseconds)
+  {
+    MillisecondsSince1970 endTime =
+      ndn_getNowMilliseconds() + timeoutMilliseconds;
+    while (!isDone()) {
+      if (ndn_getNowMilliseconds() >= endTime)
+        return false;
+
+      hub_.deliver();
+      for (size_t i = 0; i < members_.size(); ++i)
+        members_[i]->face_.processEvents();
+      hub_.deliver();
+      // Sleep for a millisecond so we don't use 100% of the CPU.
+      usleep(1000);
+    }
+
+    return true;
+  }
+
+  static bool
+  isInitialized(const Member* member) { return member->isInitialized_; }
+
+  /**
+   * Check if the member has the sequence number for /test/<name>.
+   */
+  static bool
+  hasSequenceNo(const Member* member, const string& name, int sequenceNo)
+  {
+    return member->sync_->getProducerSequenceNo
+      (Name("/test").append(name).toUri(), 1) == sequenceNo;
+  }
+
+  Hub hub_;
+  KeyChain keyChain_;
+  vector<ptr_lib::shared_ptr<Member> > members_;
+};
+
+TEST_F(TestChronoSync2013, BoundedDigestLog)
+{
+  ptr_lib::shared_ptr<Member> a = addMember("a");
+  ASSERT_TRUE(processEventsUntil(bind(&isInitialized, a.get()), 5000));
+
+  for (int i = 0; i < 100; ++i)
+    a->sync_->publishNextSequenceNo();
+  ASSERT_EQ(102, a->sync_->getDigestLogSize()) <<
+    "The digest log should have \"00\", the initial state and each publish";
+  size_t unlimitedBytes = a->sync_->getDigestLogMemoryUsage();
+
+  a->sync_->setMaxDigestLogEntries(10);
+  ASSERT_EQ(10, a->sync_->getDigestLogSize());
+  size_t tenEntriesBytes = a->sync_->getDigestLogMemoryUsage();
+  ASSERT_TRUE(tenEntriesBytes < unlimitedBytes / 5);
+
+  for (int i = 0; i < 100; ++i)
+    a->sync_->publishNextSequenceNo();
+  ASSERT_EQ(10, a->sync_->getDigestLogSize());
+  ASSERT_EQ(tenEntriesBytes, a->sync_->getDigestLogMemoryUsage()) <<
+    "The memory usage should not grow with a fixed number of entries";
+
+  a->sync_->setMaxDigestLogBytes(tenEntriesBytes / 2);
+  ASSERT_TRUE(a->sync_->getDigestLogSize() < 10);
+  ASSERT_TRUE(a->sync_->getDigestLogMemoryUsage() <= tenEntriesBytes / 2);
+
+  a->sync_->setMaxDigestLogBytes(1);
+  ASSERT_EQ(1, a->sync_->getDigestLogSize()) <<
+    "The digest log should keep the newest entry";
+  ASSERT_EQ(200, a->sync_->getSequenceNo());
+}
+
+TEST_F(TestChronoSync2013, RecoveryAfterPruning)
+{
+  ptr_lib::shared_ptr<Member> a = addMember("a");
+  a->sync_->setMaxDigestLogEntries(5);
+  ASSERT_TRUE(processEventsUntil(bind(&isInitialized, a.get()), 5000));
+  for (int i = 0; i < 50; ++i)
+    a->sync_->publishNextSequenceNo();
+  ASSERT_EQ(5, a->sync_->getDigestLogSize());
+
+  // The "00" entry is pruned, but a newcomer should still get the full state.
+  ptr_lib::shared_ptr<Member> b = addMember("b");
+  ASSERT_TRUE(processEventsUntil(bind(&hasSequenceNo, b.get(), "a", 50), 5000));
+  ASSERT_TRUE(processEventsUntil(bind(&hasSequenceNo, a.get(), "b", 0), 5000));
+
+  // While b is offline, a publishes more than its digest log holds, so it
+  // prunes the digest of the last state which b has.
+  b->transport_->isOnline_ = false;
+  for (int i = 0; i < 20; ++i)
+    a->sync_->publishNextSequenceNo();
+  b->transport_->isOnline_ = true;
+
+  ASSERT_TRUE(processEventsUntil(bind(&hasSequenceNo, b.get(), "a", 70), 10000));
+  ASSERT_TRUE(a->sync_->getDigestLogSize() <= 5);
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
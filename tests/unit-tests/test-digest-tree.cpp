@@ -0,0 +1,193 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <string.h>
+#include <sstream>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "../../src/sync/digest-tree.hpp"
+
+using namespace std;
+using namespace ndn;
+
+static const size_t DIGEST_SIZE = ndn_SHA256_DIGEST_SIZE;
+
+/**
+ * Compute the node digest the same as the original ChronoSync code.
+ */
+static vector<uint8_t>
+getNodeDigest(const string& dataPrefix, int sessionNo, int sequenceNo)
+{
+  uint8_t numbers[8];
+  for (size_t i = 0; i < 4; ++i) {
+    numbers[i] = (uint8_t)(((uint32_t)sessionNo >> (8 * i)) & 0xff);
+    numbers[4 + i] = (uint8_t)(((uint32_t)sequenceNo >> (8 * i)) & 0xff);
+  }
+
+  uint8_t nameAndSequence[2 * DIGEST_SIZE];
+  CryptoLite::digestSha256
+    ((const uint8_t*)dataPrefix.data(), dataPrefix.size(), nameAndSequence);
+  CryptoLite::digestSha256(numbers, sizeof(numbers), nameAndSequence + DIGEST_SIZE);
+
+  vector<uint8_t> result(DIGEST_SIZE);
+  CryptoLite::digestSha256(nameAndSequence, sizeof(nameAndSequence), &result[0]);
+  return result;
+}
+
+static vector<uint8_t>
+sha256(const vector<uint8_t>& data)
+{
+  vector<uint8_t> result(DIGEST_SIZE);
+  CryptoLite::digestSha256(&data[0], data.size(), &result[0]);
+  return result;
+}
+
+static vector<uint8_t>
+concatenate(const vector<uint8_t>& data1, const vector<uint8_t>& data2)
+{
+  vector<uint8_t> result(data1);
+  result.insert(result.end(), data2.begin(), data2.end());
+  return result;
+}
+
+static string
+getDataPrefix(int i)
+{
+  ostringstream dataPrefix;
+  dataPrefix << "/ndn/ucla/chat/user" << i;
+  return dataPrefix.str();
+}
+
+class TestDigestTree : public ::testing::Test {
+};
+
+TEST_F(TestDigestTree, ChronoSyncRoot)
+{
+  DigestTree digestTree;
+  ASSERT_EQ("00", digestTree.getRoot());
+
+  // Add in reverse order to check the sorting.
+  ASSERT_TRUE(digestTree.update("/b", 1, 5));
+  ASSERT_TRUE(digestTree.update("/a", 2, 3));
+  ASSERT_TRUE(digestTree.update("/a", 1, 7));
+  ASSERT_EQ(3, digestTree.size());
+  ASSERT_EQ("/a", digestTree.get(0).getDataPrefix());
+  ASSERT_EQ(1, digestTree.get(0).getSessionNo());
+  ASSERT_EQ(2, digestTree.get(1).getSessionNo());
+  ASSERT_EQ("/b", digestTree.get(2).getDataPrefix());
+
+  vector<uint8_t> expected = getNodeDigest("/a", 1, 7);
+  expected = concatenate(expected, getNodeDigest("/a", 2, 3));
+  expected = concatenate(expected, getNodeDigest("/b", 1, 5));
+  expected = sha256(expected);
+  ASSERT_EQ(toHex(expected), digestTree.getRoot()) <<
+    "The root should be the SHA-256 of the node digests";
+
+  ASSERT_FALSE(digestTree.update("/a", 2, 3)) <<
+    "An update with an old sequence number should not change the tree";
+  ASSERT_TRUE(digestTree.update("/a", 2, 4));
+  ASSERT_EQ(4, digestTree.get(1).getSequenceNo());
+  ASSERT_TRUE(memcmp
+    (getNodeDigest("/a", 2, 4).data(), digestTree.get(1).getDigest(),
+     DIGEST_SIZE) == 0);
+}
+
+TEST_F(TestDigestTree, Find)
+{
+  DigestTree digestTree;
+  ASSERT_EQ(-1, digestTree.find("/a", 1));
+
+  for (int i = 0; i < 100; ++i)
+    digestTree.update(getDataPrefix(i), i % 3, 0);
+
+  for (int i = 0; i < 100; ++i) {
+    int index = digestTree.find(getDataPrefix(i), i % 3);
+    ASSERT_TRUE(index >= 0);
+    ASSERT_EQ(getDataPrefix(i), digestTree.get(index).getDataPrefix());
+    ASSERT_EQ(i % 3, digestTree.get(index).getSessionNo());
+  }
+
+  ASSERT_EQ(-1, digestTree.find(getDataPrefix(1), 2)) <<
+    "A different session number should not be found";
+  ASSERT_EQ(-1, digestTree.find(getDataPrefix(100), 1));
+}
+
+TEST_F(TestDigestTree, MerkleRoot)
+{
+  DigestTree digestTree;
+  digestTree.setRootDigestMode(DigestTree::ROOT_DIGEST_MERKLE);
+  ASSERT_EQ("00", digestTree.getRoot());
+
+  digestTree.update("/a", 1, 1);
+  ASSERT_EQ(toHex(getNodeDigest("/a", 1, 1)), digestTree.getRoot()) <<
+    "The Merkle root of one node should be the node digest";
+
+  digestTree.update("/b", 1, 1);
+  digestTree.update("/c", 1, 1);
+  // With three nodes, the right subtree only has /c.
+  vector<uint8_t> expected = sha256(concatenate
+    (sha256(concatenate(getNodeDigest("/a", 1, 1), getNodeDigest("/b", 1, 1))),
+     getNodeDigest("/c", 1, 1)));
+  ASSERT_EQ(toHex(expected), digestTree.getRoot());
+
+  digestTree.update("/c", 1, 2);
+  expected = sha256(concatenate
+    (sha256(concatenate(getNodeDigest("/a", 1, 1), getNodeDigest("/b", 1, 1))),
+     getNodeDigest("/c", 1, 2)));
+  ASSERT_EQ(toHex(expected), digestTree.getRoot()) <<
+    "Updating the path should give the same root as rebuilding";
+}
+
+TEST_F(TestDigestTree, MerkleIncremental)
+{
+  DigestTree digestTree;
+  digestTree.setRootDigestMode(DigestTree::ROOT_DIGEST_MERKLE);
+
+  int nParticipants = 37;
+  for (int i = 0; i < nParticipants; ++i)
+    digestTree.update(getDataPrefix(i), 1, 0);
+  for (int j = 1; j <= 5; ++j) {
+    for (int i = 0; i < nParticipants; i += j)
+      digestTree.update(getDataPrefix(i), 1, j);
+  }
+
+  // Build a tree with the final state in a different order.
+  DigestTree expectedTree;
+  expectedTree.setRootDigestMode(DigestTree::ROOT_DIGEST_MERKLE);
+  for (int i = nParticipants - 1; i >= 0; --i)
+    expectedTree.update
+      (getDataPrefix(i), 1, digestTree.get(digestTree.find(getDataPrefix(i), 1))
+       .getSequenceNo());
+  ASSERT_EQ(expectedTree.getRoot(), digestTree.getRoot());
+
+  // Changing the mode recomputes the root.
+  string merkleRoot = digestTree.getRoot();
+  digestTree.setRootDigestMode(DigestTree::ROOT_DIGEST_CHRONOSYNC);
+  ASSERT_NE(merkleRoot, digestTree.getRoot());
+  digestTree.setRootDigestMode(DigestTree::ROOT_DIGEST_MERKLE);
+  ASSERT_EQ(merkleRoot, digestTree.getRoot());
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
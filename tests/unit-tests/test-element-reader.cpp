@@ -0,0 +1,169 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <ndn-cpp/data.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include "../../src/c/encoding/element-reader.h"
+#include "../../src/encoding/element-listener.hpp"
+#include "../../src/util/dynamic-uint8-vector.hpp"
+
+using namespace std;
+using namespace ndn;
+
+/**
+ * A SavingListener saves a copy of each received element.
+ */
+class SavingListener : public ElementListener {
+public:
+  virtual void
+  onReceivedElement(const uint8_t *element, size_t elementLength)
+  {
+    elements_.push_back(Blob(element, elementLength));
+  }
+
+  vector<Blob> elements_;
+};
+
+class TestElementReader : public ::testing::Test {
+public:
+  TestElementReader()
+  : buffer_(10)
+  {
+    ndn_ElementReader_initialize(&elementReader_, &listener_, &buffer_);
+  }
+
+  /**
+   * Make the encoding of a Data packet with the given content size.
+   */
+  static Blob
+  makeElement(size_t contentSize, uint8_t fill)
+  {
+    Data data(Name("/test/element-reader"));
+    data.setContent(Blob(vector<uint8_t>(contentSize, fill)));
+    data.setSignature(DigestSha256Signature());
+    return data.wireEncode();
+  }
+
+  SavingListener listener_;
+  DynamicUInt8Vector buffer_;
+  struct ndn_ElementReader elementReader_;
+};
+
+TEST_F(TestElementReader, ReceiveInPlace)
+{
+  Blob element = makeElement(8000, 0x55);
+  // Receive enough to read the TLV header, as from a first recv.
+  const size_t firstLength = 20;
+  ASSERT_EQ(NDN_ERROR_success, ndn_ElementReader_onReceivedData
+    (&elementReader_, element.buf(), firstLength));
+  ASSERT_EQ(0, listener_.elements_.size());
+
+  // Receive the rest in small pieces directly into the ElementReader.
+  size_t offset = firstLength;
+  int nReceives = 0;
+  while (listener_.elements_.size() == 0) {
+    uint8_t* receiveBuffer;
+    size_t receiveBufferLength;
+    ndn_ElementReader_getReceiveBuffer
+      (&elementReader_, &receiveBuffer, &receiveBufferLength);
+    ASSERT_TRUE(receiveBuffer != 0);
+    ASSERT_EQ(element.size() - offset, receiveBufferLength) <<
+      "The receive buffer should be exactly the rest of the element";
+
+    size_t nBytes = min((size_t)500, receiveBufferLength);
+    memcpy(receiveBuffer, element.buf() + offset, nBytes);
+    offset += nBytes;
+    ASSERT_EQ(NDN_ERROR_success, ndn_ElementReader_onReceivedInPlace
+      (&elementReader_, nBytes));
+    ++nReceives;
+  }
+
+  ASSERT_TRUE(nReceives > 10);
+  ASSERT_EQ(element.size(), offset);
+  ASSERT_EQ(1, listener_.elements_.size());
+  ASSERT_TRUE(listener_.elements_[0].equals(element));
+
+  // Between elements, the caller should use its own buffer.
+  uint8_t* receiveBuffer;
+  size_t receiveBufferLength;
+  ndn_ElementReader_getReceiveBuffer
+    (&elementReader_, &receiveBuffer, &receiveBufferLength);
+  ASSERT_TRUE(receiveBuffer == 0);
+  ASSERT_EQ(0, receiveBufferLength);
+}
+
+TEST_F(TestElementReader, SplitHeader)
+{
+  Blob element = makeElement(8000, 0x55);
+  Blob smallElement = makeElement(10, 0xaa);
+  // The length of a large element is 0xfd followed by two bytes.
+  ASSERT_EQ(0xfd, element.buf()[1]);
+
+  // Split between the 0xfd and the rest of the length.
+  ASSERT_EQ(NDN_ERROR_success, ndn_ElementReader_onReceivedData
+    (&elementReader_, element.buf(), 2));
+  uint8_t* receiveBuffer;
+  size_t receiveBufferLength;
+  ndn_ElementReader_getReceiveBuffer
+    (&elementReader_, &receiveBuffer, &receiveBufferLength);
+  ASSERT_TRUE(receiveBuffer == 0) <<
+    "The value length is not known until the header is complete";
+
+  // Receive the rest of the element followed by another element.
+  vector<uint8_t> rest(element.buf() + 2, element.buf() + element.size());
+  rest.insert(rest.end(), smallElement.buf(),
+              smallElement.buf() + smallElement.size());
+  ASSERT_EQ(NDN_ERROR_success, ndn_ElementReader_onReceivedData
+    (&elementReader_, &rest[0], rest.size()));
+
+  ASSERT_EQ(2, listener_.elements_.size());
+  ASSERT_TRUE(listener_.elements_[0].equals(element));
+  ASSERT_TRUE(listener_.elements_[1].equals(smallElement));
+}
+
+TEST_F(TestElementReader, RejectOversizeLength)
+{
+  // A Data header with a 4-byte length of MAX_NDN_PACKET_SIZE + 1.
+  uint32_t length = MAX_NDN_PACKET_SIZE + 1;
+  uint8_t header[] = {
+    6, 0xfe, (uint8_t)(length >> 24), (uint8_t)(length >> 16),
+    (uint8_t)(length >> 8), (uint8_t)length };
+  ASSERT_EQ
+    (NDN_ERROR_ElementReader_The_incoming_packet_exceeds_the_maximum_limit_getMaxNdnPacketSize,
+     ndn_ElementReader_onReceivedData(&elementReader_, header, sizeof(header))) <<
+    "The length should be rejected before receiving the value";
+  ASSERT_EQ(0, listener_.elements_.size());
+
+  // The ElementReader is reset and can receive the next element.
+  Blob smallElement = makeElement(10, 0xaa);
+  ASSERT_EQ(NDN_ERROR_success, ndn_ElementReader_onReceivedData
+    (&elementReader_, smallElement.buf(), smallElement.size()));
+  ASSERT_EQ(1, listener_.elements_.size());
+  ASSERT_TRUE(listener_.elements_[0].equals(smallElement));
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,328 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <ndn-cpp/face.hpp>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/transport/unix-transport.hpp>
+#include "../../src/c/util/time.h"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+/**
+ * A ServerAction is run in a thread to act on the stand-in forwarder's side
+ * of the socket after a delay.
+ */
+class ServerAction {
+public:
+  ServerAction
+    (int socketDescriptor, const ptr_lib::shared_ptr<Transport>& transport,
+     Milliseconds delayMilliseconds)
+  : socketDescriptor_(socketDescriptor), transport_(transport),
+    delayMilliseconds_(delayMilliseconds)
+  {
+  }
+
+  int socketDescriptor_;
+  ptr_lib::shared_ptr<Transport> transport_;
+  Milliseconds delayMilliseconds_;
+};
+
+/**
+ * After the delay, send a Data packet named /test/data to the Face.
+ */
+static void*
+runSendData(void* actionPointer)
+{
+  ServerAction* action = (ServerAction*)actionPointer;
+  usleep(action->delayMilliseconds_ * 1000);
+
+  Data data(Name("/test/data"));
+  data.setContent(Blob((const uint8_t*)"Hello", 5));
+  data.setSignature(DigestSha256Signature());
+  Blob encoding = data.wireEncode();
+  if (send(action->socketDescriptor_, encoding.buf(), encoding.size(), 0) < 0)
+    perror("send");
+  return 0;
+}
+
+/**
+ * After the delay, call wakeUp on the Face's transport.
+ */
+static void*
+runWakeUp(void* actionPointer)
+{
+  ServerAction* action = (ServerAction*)actionPointer;
+  usleep(action->delayMilliseconds_ * 1000);
+  action->transport_->wakeUp();
+  return 0;
+}
+
+static void
+setTrue(bool* flag) { *flag = true; }
+
+/**
+ * A FaceAction is run in a thread to call a Face method after a delay, as an
+ * application thread other than the processEvents thread would.
+ */
+class FaceAction {
+public:
+  FaceAction(Face* face, Milliseconds delayMilliseconds, bool* called)
+  : face_(face), delayMilliseconds_(delayMilliseconds), called_(called)
+  {
+  }
+
+  Face* face_;
+  Milliseconds delayMilliseconds_;
+  bool* called_;
+};
+
+/**
+ * After the delay, call face.callLater to set called after another 100
+ * milliseconds.
+ */
+static void*
+runCallLater(void* actionPointer)
+{
+  FaceAction* action = (FaceAction*)actionPointer;
+  usleep(action->delayMilliseconds_ * 1000);
+  action->face_->callLater(100, bind(&setTrue, action->called_));
+  return 0;
+}
+
+static void
+onData
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<Data>& data, bool* gotData)
+{
+  *gotData = true;
+}
+
+static void
+onTimeout(const ptr_lib::shared_ptr<const Interest>& interest) {}
+
+/**
+ * After the delay, call face.expressInterest for /test/other-thread.
+ */
+static void*
+runExpressInterest(void* actionPointer)
+{
+  FaceAction* action = (FaceAction*)actionPointer;
+  usleep(action->delayMilliseconds_ * 1000);
+  Interest interest(Name("/test/other-thread"));
+  interest.setCanBePrefix(false);
+  interest.setInterestLifetimeMilliseconds(10000);
+  action->face_->expressInterest
+    (interest, bind(&onData, _1, _2, action->called_), &onTimeout);
+  return 0;
+}
+
+class TestFaceProcessEvents : public ::testing::Test {
+public:
+  TestFaceProcessEvents()
+  : listenSocket_(-1), serverSocket_(-1)
+  {
+    sprintf(socketFilePath_, "/tmp/test-face-process-events-%d.sock",
+            (int)getpid());
+    unlink(socketFilePath_);
+
+    listenSocket_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socketFilePath_);
+    if (listenSocket_ >= 0 &&
+        (bind(listenSocket_, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+         listen(listenSocket_, 1) != 0)) {
+      close(listenSocket_);
+      listenSocket_ = -1;
+    }
+
+    transport_.reset(new UnixTransport());
+    face_.reset(new Face
+      (transport_,
+       ptr_lib::make_shared<UnixTransport::ConnectionInfo>(socketFilePath_)));
+  }
+
+  virtual
+  ~TestFaceProcessEvents()
+  {
+    face_->shutdown();
+    if (serverSocket_ >= 0)
+      close(serverSocket_);
+    if (listenSocket_ >= 0)
+      close(listenSocket_);
+    unlink(socketFilePath_);
+  }
+
+  /**
+   * Express an Interest with the name and a long lifetime, which makes the
+   * Face connect to the stand-in forwarder the first time.
+   */
+  void
+  expressInterest(const Name& name, bool* gotData)
+  {
+    Interest interest(name);
+    interest.setCanBePrefix(false);
+    interest.setInterestLifetimeMilliseconds(10000);
+    face_->expressInterest
+      (interest, bind(&onData, _1, _2, gotData), &onTimeout);
+
+    if (serverSocket_ < 0)
+      serverSocket_ = accept(listenSocket_, 0, 0);
+  }
+
+  char socketFilePath_[100];
+  int listenSocket_;
+  int serverSocket_;
+  ptr_lib::shared_ptr<Transport> transport_;
+  ptr_lib::shared_ptr<Face> face_;
+};
+
+TEST_F(TestFaceProcessEvents, ReturnAtCallLaterDeadline)
+{
+  ASSERT_TRUE(listenSocket_ >= 0);
+  bool gotData = false;
+  expressInterest(Name("/test/connect"), &gotData);
+  ASSERT_TRUE(serverSocket_ >= 0);
+
+  bool called = false;
+  face_->callLater(100, bind(&setTrue, &called));
+  MillisecondsSince1970 start = ndn_getNowMilliseconds();
+  face_->processEvents(5000);
+  Milliseconds elapsed = ndn_getNowMilliseconds() - start;
+
+  ASSERT_TRUE(called) << "processEvents should call the callLater callback";
+  ASSERT_TRUE(elapsed >= 90) << "processEvents should wait for the deadline";
+  ASSERT_TRUE(elapsed < 2000) <<
+    "processEvents should return at the deadline, not the maximum wait";
+}
+
+TEST_F(TestFaceProcessEvents, ReturnWhenDataArrives)
+{
+  ASSERT_TRUE(listenSocket_ >= 0);
+  bool gotData = false;
+  expressInterest(Name("/test/data"), &gotData);
+  ASSERT_TRUE(serverSocket_ >= 0);
+
+  ServerAction action(serverSocket_, transport_, 50);
+  pthread_t thread;
+  pthread_create(&thread, 0, &runSendData, &action);
+  MillisecondsSince1970 start = ndn_getNowMilliseconds();
+  face_->processEvents(5000);
+  Milliseconds elapsed = ndn_getNowMilliseconds() - start;
+  pthread_join(thread, 0);
+
+  ASSERT_TRUE(gotData) << "processEvents should process the received Data";
+  ASSERT_TRUE(elapsed >= 40) << "processEvents should wait for the Data";
+  ASSERT_TRUE(elapsed < 2000) << "processEvents should return when Data arrives";
+}
+
+TEST_F(TestFaceProcessEvents, WakeUpInterruptsWait)
+{
+  ASSERT_TRUE(listenSocket_ >= 0);
+  bool gotData = false;
+  expressInterest(Name("/test/connect"), &gotData);
+  ASSERT_TRUE(serverSocket_ >= 0);
+
+  ServerAction action(serverSocket_, transport_, 50);
+  pthread_t thread;
+  pthread_create(&thread, 0, &runWakeUp, &action);
+  MillisecondsSince1970 start = ndn_getNowMilliseconds();
+  face_->processEvents(5000);
+  Milliseconds elapsed = ndn_getNowMilliseconds() - start;
+  pthread_join(thread, 0);
+
+  ASSERT_FALSE(gotData);
+  ASSERT_TRUE(elapsed >= 40) << "processEvents should wait for the wakeUp";
+  ASSERT_TRUE(elapsed < 2000) << "wakeUp should interrupt the wait";
+}
+
+TEST_F(TestFaceProcessEvents, CallLaterFromOtherThread)
+{
+  ASSERT_TRUE(listenSocket_ >= 0);
+  bool gotData = false;
+  expressInterest(Name("/test/connect"), &gotData);
+  ASSERT_TRUE(serverSocket_ >= 0);
+  // Make this the processEvents thread.
+  face_->processEvents();
+
+  bool called = false;
+  FaceAction action(face_.get(), 50, &called);
+  pthread_t thread;
+  pthread_create(&thread, 0, &runCallLater, &action);
+  MillisecondsSince1970 start = ndn_getNowMilliseconds();
+  face_->processEvents(5000);
+  Milliseconds wakeUpElapsed = ndn_getNowMilliseconds() - start;
+  while (!called && ndn_getNowMilliseconds() - start < 5000)
+    face_->processEvents(5000);
+  Milliseconds elapsed = ndn_getNowMilliseconds() - start;
+  pthread_join(thread, 0);
+
+  ASSERT_TRUE(wakeUpElapsed < 2000) << "callLater should interrupt the wait";
+  ASSERT_TRUE(called) << "processEvents should call the callLater callback";
+  ASSERT_TRUE(elapsed >= 140) << "processEvents should wait for the new deadline";
+  ASSERT_TRUE(elapsed < 2000) <<
+    "processEvents should return at the new deadline, not the maximum wait";
+}
+
+TEST_F(TestFaceProcessEvents, ExpressInterestFromOtherThread)
+{
+  ASSERT_TRUE(listenSocket_ >= 0);
+  bool gotData = false;
+  expressInterest(Name("/test/connect"), &gotData);
+  ASSERT_TRUE(serverSocket_ >= 0);
+  // Make this the processEvents thread and read the first Interest.
+  face_->processEvents();
+  uint8_t buffer[1000];
+  ASSERT_TRUE(recv(serverSocket_, buffer, sizeof(buffer), 0) > 0);
+
+  bool gotOtherData = false;
+  FaceAction action(face_.get(), 50, &gotOtherData);
+  pthread_t thread;
+  pthread_create(&thread, 0, &runExpressInterest, &action);
+  MillisecondsSince1970 start = ndn_getNowMilliseconds();
+  face_->processEvents(5000);
+  Milliseconds elapsed = ndn_getNowMilliseconds() - start;
+  pthread_join(thread, 0);
+
+  ASSERT_TRUE(elapsed < 2000) << "expressInterest should interrupt the wait";
+  Interest interest;
+  ssize_t nBytes = recv(serverSocket_, buffer, sizeof(buffer), MSG_DONTWAIT);
+  ASSERT_TRUE(nBytes > 0) <<
+    "processEvents should send the Interest from the other thread";
+  interest.wireDecode(buffer, nBytes);
+  ASSERT_EQ(Name("/test/other-thread"), interest.getName());
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,336 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <ndn-cpp/security/key-chain.hpp>
+#include <ndn-cpp/sync/full-psync2017-with-users.hpp>
+#include "../../src/c/util/time.h"
+#include "hub-transport.hpp"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+// FullPSync2017 is only compiled if ndn-cpp-config.h defines NDN_CPP_HAVE_LIBZ.
+#if NDN_CPP_HAVE_LIBZ
+
+/**
+ * A Peer has a FullPSync2017WithUsers on its own Face and saves the updates.
+ */
+class Peer {
+public:
+  Peer(Hub& hub, KeyChain& keyChain, const Name& syncPrefix)
+  : transport_(new HubTransport(hub)),
+    face_(transport_, ptr_lib::make_shared<Transport::ConnectionInfo>()),
+    nUpdatedPrefixes_(0)
+  {
+    face_.setCommandSigningInfo(keyChain, keyChain.getDefaultCertificateName());
+    sync_.reset(new FullPSync2017WithUsers
+      (80, face_, syncPrefix, Name(), bind(&Peer::onUpdate, this, _1),
+       keyChain));
+  }
+
+  void
+  onUpdate
+    (const ptr_lib::shared_ptr<vector<ptr_lib::shared_ptr<PSyncMissingDataInfo>>>& updates)
+  {
+    for (size_t i = 0; i < updates->size(); ++i) {
+      const PSyncMissingDataInfo& update = *(*updates)[i];
+      if (highSequenceNos_.find(update.prefix_) == highSequenceNos_.end())
+        ++nUpdatedPrefixes_;
+      highSequenceNos_[update.prefix_] = update.highSequenceNo_;
+    }
+  }
+
+  ptr_lib::shared_ptr<HubTransport> transport_;
+  Face face_;
+  ptr_lib::shared_ptr<FullPSync2017WithUsers> sync_;
+  map<Name, int> highSequenceNos_;
+  size_t nUpdatedPrefixes_;
+};
+
+class TestFullPSync2017 : public ::testing::Test {
+public:
+  TestFullPSync2017()
+  : keyChain_("pib-memory:", "tpm-memory:"),
+    syncPrefix_("/test/full-psync")
+  {
+    keyChain_.createIdentityV2(Name("/test"), EcKeyParams());
+  }
+
+  /**
+   * Deliver packets and process events on all the faces until isDone returns
+   * true or until the timeout.
+   * @param isDone The function to check if finished.
+   * @param timeoutMilliseconds The maximum time to wait.
+   * @return The final value of isDone().
+   */
+  bool
+  processEventsUntil
+    (const func_lib::function<bool()>& isDone, Milliseconds timeoutMilliseconds)
+  {
+    MillisecondsSince1970 endTime =
+      ndn_getNowMilliseconds() + timeoutMilliseconds;
+    while (!isDone()) {
+      if (ndn_getNowMilliseconds() >= endTime)
+        return false;
+
+      hub_.deliver();
+      for (size_t i = 0; i < peers_.size(); ++i)
+        peers_[i]->face_.processEvents();
+      hub_.deliver();
+      // Sleep for a millisecond so we don't use 100% of the CPU.
+      usleep(1000);
+    }
+
+    return true;
+  }
+
+  static bool
+  isFalse() { return false; }
+
+  static bool
+  hasNUpdatedPrefixes(const Peer* peer, size_t nUpdatedPrefixes)
+  {
+    return peer->nUpdatedPrefixes_ >= nUpdatedPrefixes;
+  }
+
+  static bool
+  hasSequenceNo(Peer* peer, const Name& prefix, int sequenceNo)
+  {
+    return peer->highSequenceNos_[prefix] >= sequenceNo;
+  }
+
+  /**
+   * Create the publisher and the receiver, and wait for the receiver's sync
+   * Interest to be pending at the publisher.
+   */
+  void
+  createPeers()
+  {
+    peers_.push_back(ptr_lib::make_shared<Peer>(hub_, keyChain_, syncPrefix_));
+    peers_.push_back(ptr_lib::make_shared<Peer>(hub_, keyChain_, syncPrefix_));
+    processEventsUntil(&TestFullPSync2017::isFalse, 50);
+  }
+
+  Hub hub_;
+  KeyChain keyChain_;
+  Name syncPrefix_;
+  vector<ptr_lib::shared_ptr<Peer> > peers_;
+};
+
+TEST_F(TestFullPSync2017, PublishNames)
+{
+  const int nUserPrefixes = 40;
+
+  createPeers();
+  Peer& publisher = *peers_[0];
+  Peer& receiver = *peers_[1];
+
+  vector<Name> userPrefixes;
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    userPrefixes.push_back(Name("/test/user").appendNumber(i));
+    ASSERT_TRUE(publisher.sync_->addUserNode(userPrefixes[i]));
+  }
+  // Repeat a prefix so that it is published with sequence number 2.
+  userPrefixes.push_back(userPrefixes[0]);
+  // An unknown prefix is skipped.
+  userPrefixes.push_back(Name("/test/unknown"));
+
+  int nDataSentBefore = publisher.transport_->nDataSent_;
+  ASSERT_EQ(nUserPrefixes, publisher.sync_->publishNames(userPrefixes));
+  ASSERT_EQ(2, publisher.sync_->getSequenceNo(userPrefixes[0]));
+  ASSERT_EQ(1, publisher.sync_->getSequenceNo(userPrefixes[1]));
+  ASSERT_EQ(nUserPrefixes, publisher.sync_->getNCoalescedPublications()) <<
+    "All but one publication, plus the repeated prefix, should be coalesced";
+  ASSERT_EQ(1, publisher.transport_->nDataSent_ - nDataSentBefore) <<
+    "publishNames should send one reply to the pending sync Interest";
+
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestFullPSync2017::hasNUpdatedPrefixes, &receiver, nUserPrefixes),
+     3000));
+  ASSERT_EQ(2, receiver.highSequenceNos_[userPrefixes[0]]);
+  ASSERT_EQ(1, publisher.transport_->nDataSent_ - nDataSentBefore) <<
+    "The one reply should have all the published names";
+  ASSERT_EQ(1, receiver.highSequenceNos_[userPrefixes[nUserPrefixes - 1]]);
+}
+
+TEST_F(TestFullPSync2017, PublishDelay)
+{
+  const int nUserPrefixes = 20;
+
+  createPeers();
+  Peer& publisher = *peers_[0];
+  Peer& receiver = *peers_[1];
+  publisher.sync_->setPublishDelay(50);
+  ASSERT_EQ(50, publisher.sync_->getPublishDelay());
+
+  vector<Name> userPrefixes;
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    userPrefixes.push_back(Name("/test/user").appendNumber(i));
+    ASSERT_TRUE(publisher.sync_->addUserNode(userPrefixes[i]));
+  }
+
+  int nDataSentBefore = publisher.transport_->nDataSent_;
+  for (int i = 0; i < nUserPrefixes; ++i)
+    publisher.sync_->publishName(userPrefixes[i]);
+  ASSERT_EQ(nUserPrefixes - 1, publisher.sync_->getNCoalescedPublications());
+  ASSERT_EQ(0, publisher.transport_->nDataSent_ - nDataSentBefore) <<
+    "The reply should wait for the publish delay";
+
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestFullPSync2017::hasNUpdatedPrefixes, &receiver, nUserPrefixes),
+     3000));
+  ASSERT_EQ(1, receiver.highSequenceNos_[userPrefixes[0]]);
+  ASSERT_EQ(1, publisher.transport_->nDataSent_ - nDataSentBefore) <<
+    "The publications should be coalesced into one reply";
+}
+
+TEST_F(TestFullPSync2017, ManyPeers)
+{
+  const int nReceivers = 6;
+  const int nUserPrefixes = 10;
+
+  peers_.push_back(ptr_lib::make_shared<Peer>(hub_, keyChain_, syncPrefix_));
+  for (int k = 0; k < nReceivers; ++k) {
+    peers_.push_back(ptr_lib::make_shared<Peer>(hub_, keyChain_, syncPrefix_));
+    if (k % 2 == 1)
+      // The pending sync Interests have the same IBLT in both codecs.
+      peers_.back()->sync_->setIbltCodec(FullPSync2017::IBLT_CODEC_SPARSE);
+  }
+  Peer& publisher = *peers_[0];
+  processEventsUntil(&TestFullPSync2017::isFalse, 50);
+
+  vector<Name> userPrefixes;
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    userPrefixes.push_back(Name("/test/user").appendNumber(i));
+    ASSERT_TRUE(publisher.sync_->addUserNode(userPrefixes[i]));
+  }
+
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    publisher.sync_->publishName(userPrefixes[i]);
+    for (int k = 1; k <= nReceivers; ++k)
+      ASSERT_TRUE(processEventsUntil
+        (bind(&TestFullPSync2017::hasNUpdatedPrefixes, peers_[k].get(), i + 1),
+         3000)) << "Receiver " << k << " should get " << userPrefixes[i];
+  }
+
+  // Let the pending sync Interests expire and be renewed.
+  processEventsUntil(&TestFullPSync2017::isFalse, 1200);
+
+  // A new sequence number erases the old one from the IBLT.
+  for (int i = 0; i < nUserPrefixes; ++i)
+    publisher.sync_->publishName(userPrefixes[i]);
+  for (int k = 1; k <= nReceivers; ++k) {
+    Peer& receiver = *peers_[k];
+    for (int i = 0; i < nUserPrefixes; ++i) {
+      ASSERT_TRUE(processEventsUntil
+        (bind(&TestFullPSync2017::hasSequenceNo, &receiver, userPrefixes[i], 2),
+         3000)) << "Receiver " << k << " should get " << userPrefixes[i] <<
+        " sequence number 2";
+    }
+  }
+}
+
+TEST_F(TestFullPSync2017, NameHashTlv)
+{
+  const int nUserPrefixes = 10;
+
+  Name name("/test/user/1");
+  ASSERT_TRUE(PSyncProducerBase::hashName(name, PSyncProducerBase::NAME_HASH_URI) !=
+              PSyncProducerBase::hashName(name, PSyncProducerBase::NAME_HASH_TLV));
+
+  createPeers();
+  Peer& publisher = *peers_[0];
+  Peer& receiver = *peers_[1];
+  publisher.sync_->setNameHashMode(PSyncProducerBase::NAME_HASH_TLV);
+  receiver.sync_->setNameHashMode(PSyncProducerBase::NAME_HASH_TLV);
+
+  vector<Name> userPrefixes;
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    userPrefixes.push_back(Name("/test/user").appendNumber(i));
+    ASSERT_TRUE(publisher.sync_->addUserNode(userPrefixes[i]));
+  }
+
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    publisher.sync_->publishName(userPrefixes[i]);
+    ASSERT_TRUE(processEventsUntil
+      (bind(&TestFullPSync2017::hasNUpdatedPrefixes, &receiver, i + 1), 3000)) <<
+      "With NAME_HASH_TLV, the receiver should get " << userPrefixes[i];
+  }
+
+  // A new sequence number erases the old hash from the IBLT.
+  publisher.sync_->publishName(userPrefixes[0]);
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestFullPSync2017::hasSequenceNo, &receiver, userPrefixes[0], 2),
+     3000));
+}
+
+TEST_F(TestFullPSync2017, ChangeNameHashMode)
+{
+  const int nUserPrefixes = 10;
+
+  createPeers();
+  Peer& publisher = *peers_[0];
+  Peer& receiver = *peers_[1];
+
+  vector<Name> userPrefixes;
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    userPrefixes.push_back(Name("/test/user").appendNumber(i));
+    ASSERT_TRUE(publisher.sync_->addUserNode(userPrefixes[i]));
+  }
+  publisher.sync_->publishNames(userPrefixes);
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestFullPSync2017::hasNUpdatedPrefixes, &receiver, nUserPrefixes),
+     3000));
+
+  // Both peers re-hash the names which they already have.
+  publisher.sync_->setNameHashMode(PSyncProducerBase::NAME_HASH_TLV);
+  receiver.sync_->setNameHashMode(PSyncProducerBase::NAME_HASH_TLV);
+  // Let the pending sync Interests, which have the old hashes, expire and be
+  // renewed with the rebuilt IBLT.
+  processEventsUntil(&TestFullPSync2017::isFalse, 1200);
+
+  int nDataSentBefore = publisher.transport_->nDataSent_;
+  publisher.sync_->publishName(userPrefixes[3]);
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestFullPSync2017::hasSequenceNo, &receiver, userPrefixes[3], 2),
+     3000));
+  ASSERT_EQ(1, receiver.highSequenceNos_[userPrefixes[4]]);
+
+  // If the rebuilt IBLTs differed, the publisher would keep answering the
+  // receiver's sync Interests.
+  processEventsUntil(&TestFullPSync2017::isFalse, 200);
+  ASSERT_EQ(1, publisher.transport_->nDataSent_ - nDataSentBefore) <<
+    "After re-hashing, only the new publication should be sent";
+}
+
+#endif // NDN_CPP_HAVE_LIBZ
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,194 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-retaining.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-fifo.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-lru.hpp>
+#include <ndn-cpp/in-memory-storage/in-memory-storage-lfu.hpp>
+
+using namespace std;
+using namespace ndn;
+
+static Data
+makeData(const Name& name, Milliseconds freshnessPeriod = 10000)
+{
+  Data data(name);
+  data.setContent(Blob(vector<uint8_t>(100, 0)));
+  data.getMetaInfo().setFreshnessPeriod(freshnessPeriod);
+  data.setSignature(DigestSha256Signature());
+  return data;
+}
+
+static Interest
+makeInterest(const Name& name, bool canBePrefix, bool mustBeFresh = false)
+{
+  Interest interest(name);
+  interest.setCanBePrefix(canBePrefix);
+  interest.setMustBeFresh(mustBeFresh);
+  return interest;
+}
+
+class TestInMemoryStorage : public ::testing::Test {
+};
+
+TEST_F(TestInMemoryStorage, FifoEviction)
+{
+  InMemoryStorageFifo storage(3);
+  storage.insert(makeData("/A/1"));
+  storage.insert(makeData("/A/2"));
+  storage.insert(makeData("/A/3"));
+  // Access does not protect from FIFO eviction.
+  ASSERT_TRUE(!!storage.find(Name("/A/1")));
+  storage.insert(makeData("/A/4"));
+
+  ASSERT_EQ(3, storage.size());
+  ASSERT_EQ(1, storage.getEvictionCount());
+  ASSERT_FALSE(storage.find(Name("/A/1"))) << "/A/1 should be evicted first";
+  ASSERT_TRUE(!!storage.find(Name("/A/2")));
+  ASSERT_TRUE(!!storage.find(Name("/A/4")));
+}
+
+TEST_F(TestInMemoryStorage, LruEviction)
+{
+  InMemoryStorageLru storage(3);
+  storage.insert(makeData("/A/1"));
+  storage.insert(makeData("/A/2"));
+  storage.insert(makeData("/A/3"));
+  ASSERT_TRUE(!!storage.find(makeInterest("/A/1", false)));
+  storage.insert(makeData("/A/4"));
+
+  ASSERT_EQ(3, storage.size());
+  ASSERT_TRUE(!!storage.find(Name("/A/1"))) << "/A/1 was recently used";
+  ASSERT_FALSE(storage.find(Name("/A/2"))) <<
+    "/A/2 should be evicted as the least recently used";
+}
+
+TEST_F(TestInMemoryStorage, LfuEviction)
+{
+  InMemoryStorageLfu storage(3);
+  storage.insert(makeData("/A/1"));
+  storage.insert(makeData("/A/2"));
+  storage.insert(makeData("/A/3"));
+  storage.find(Name("/A/1"));
+  storage.find(Name("/A/1"));
+  storage.find(Name("/A/2"));
+  storage.insert(makeData("/A/4"));
+
+  ASSERT_EQ(3, storage.size());
+  ASSERT_FALSE(storage.find(Name("/A/3"))) <<
+    "/A/3 should be evicted as the least frequently used";
+
+  // /A/4 has the lowest count (1), so it is evicted next.
+  storage.insert(makeData("/A/5"));
+  ASSERT_FALSE(storage.find(Name("/A/4")));
+  ASSERT_TRUE(!!storage.find(Name("/A/1")));
+  ASSERT_TRUE(!!storage.find(Name("/A/2")));
+  ASSERT_TRUE(!!storage.find(Name("/A/5")));
+}
+
+TEST_F(TestInMemoryStorage, ByteLimit)
+{
+  size_t encodingSize = makeData("/A/1").wireEncode().size();
+  InMemoryStorageLru storage(0, 3 * encodingSize);
+  for (int i = 1; i <= 5; ++i)
+    storage.insert(makeData(Name("/A").append(Name::Component(to_string(i)))));
+
+  ASSERT_EQ(3, storage.size());
+  ASSERT_EQ(3 * encodingSize, storage.getByteCount());
+  ASSERT_EQ(2, storage.getEvictionCount());
+  ASSERT_FALSE(storage.find(Name("/A/2")));
+  ASSERT_TRUE(!!storage.find(Name("/A/3")));
+
+  storage.remove(Name("/A"));
+  ASSERT_EQ(0, storage.size());
+  ASSERT_EQ(0, storage.getByteCount());
+}
+
+TEST_F(TestInMemoryStorage, InterestLookup)
+{
+  InMemoryStorageFifo storage(0);
+  storage.insert(makeData("/A/B"));
+  storage.insert(makeData("/A/B/1"));
+  storage.insert(makeData("/A/B/2", 0));
+  storage.insert(makeData("/A/C"));
+  Data data3 = makeData("/A/B/3");
+  storage.insert(data3);
+
+  ptr_lib::shared_ptr<Data> result = storage.find(makeInterest("/A/B", false));
+  ASSERT_TRUE(!!result);
+  ASSERT_EQ(Name("/A/B"), result->getName()) <<
+    "Without CanBePrefix, only the exact name should match";
+  ASSERT_FALSE(storage.find(makeInterest("/A", false)));
+
+  result = storage.find(makeInterest("/A", true));
+  ASSERT_TRUE(!!result);
+  ASSERT_EQ(Name("/A/B"), result->getName());
+
+  Interest rightmost = makeInterest("/A/B", true);
+  rightmost.setChildSelector(1);
+  result = storage.find(rightmost);
+  ASSERT_TRUE(!!result);
+  ASSERT_EQ(Name("/A/B/3"), result->getName());
+
+  // /A/B/2 has a freshness period of 0, so it is stale.
+  ASSERT_TRUE(!!storage.find(makeInterest("/A/B/2", false)));
+  ASSERT_FALSE(storage.find(makeInterest("/A/B/2", false, true)));
+  ASSERT_TRUE(!!storage.find(makeInterest("/A/B/1", false, true)));
+
+  result = storage.find(makeInterest(*data3.getFullName(), false));
+  ASSERT_TRUE(!!result);
+  ASSERT_EQ(Name("/A/B/3"), result->getName());
+  Name wrongDigest(*makeData("/A/B/3", 5000).getFullName());
+  ASSERT_FALSE(storage.find(makeInterest(wrongDigest, false))) <<
+    "The implicit digest should match the exact packet";
+
+  storage.remove(Name("/A/B"));
+  ASSERT_EQ(1, storage.size());
+  ASSERT_FALSE(storage.find(makeInterest("/A/B/1", true)));
+}
+
+TEST_F(TestInMemoryStorage, SharedInterface)
+{
+  vector<ptr_lib::shared_ptr<InMemoryStorage> > storages;
+  storages.push_back(ptr_lib::make_shared<InMemoryStorageRetaining>());
+  storages.push_back(ptr_lib::make_shared<InMemoryStorageFifo>(10));
+  storages.push_back(ptr_lib::make_shared<InMemoryStorageLru>(10));
+  storages.push_back(ptr_lib::make_shared<InMemoryStorageLfu>(10));
+
+  for (size_t i = 0; i < storages.size(); ++i) {
+    InMemoryStorage& storage = *storages[i];
+    storage.insert(makeData("/A/1"));
+    storage.insert(makeData("/A/1"));
+    storage.insert(makeData("/A/2"));
+    ASSERT_EQ(2, storage.size()) << "Inserting the same packet should replace it";
+    ASSERT_TRUE(!!storage.find(makeInterest("/A/2", true)));
+    storage.remove(Name("/A/1"));
+    ASSERT_EQ(1, storage.size());
+  }
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <ndn-cpp/face.hpp>
+#include "../../src/c/util/time.h"
+#include "capture-transport.hpp"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+class Counts {
+public:
+  Counts()
+  : nData_(0), nTimeouts_(0), nNacks_(0)
+  {
+  }
+
+  void
+  onData
+    (const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<Data>& data)
+  {
+    ++nData_;
+  }
+
+  void
+  onTimeout(const ptr_lib::shared_ptr<const Interest>& interest)
+  {
+    ++nTimeouts_;
+  }
+
+  void
+  onNetworkNack
+    (const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack)
+  {
+    ++nNacks_;
+  }
+
+  int nData_;
+  int nTimeouts_;
+  int nNacks_;
+};
+
+class TestInterestAggregation : public ::testing::Test {
+public:
+  TestInterestAggregation()
+  : transport_(new CaptureTransport()),
+    face_(transport_, ptr_lib::make_shared<Transport::ConnectionInfo>())
+  {
+  }
+
+  uint64_t
+  expressInterest(const Interest& interest, Counts& counts)
+  {
+    return face_.expressInterest
+      (interest, bind(&Counts::onData, &counts, _1, _2),
+       bind(&Counts::onTimeout, &counts, _1),
+       bind(&Counts::onNetworkNack, &counts, _1, _2));
+  }
+
+  static Interest
+  makeInterest(const Name& name)
+  {
+    Interest interest(name);
+    interest.setCanBePrefix(false);
+    interest.setInterestLifetimeMilliseconds(4000);
+    return interest;
+  }
+
+  ptr_lib::shared_ptr<CaptureTransport> transport_;
+  Face face_;
+};
+
+TEST_F(TestInterestAggregation, DisabledByDefault)
+{
+  Counts counts;
+  expressInterest(makeInterest(Name("/test/data")), counts);
+  expressInterest(makeInterest(Name("/test/data")), counts);
+
+  ASSERT_EQ(2, transport_->sentPackets_.size()) <<
+    "Without aggregation, each Interest should be sent";
+  ASSERT_EQ(2, face_.getExpressedInterestCount());
+  ASSERT_EQ(0, face_.getAggregatedInterestCount());
+
+  transport_->receiveData(Name("/test/data"));
+  ASSERT_EQ(2, counts.nData_);
+}
+
+TEST_F(TestInterestAggregation, Data)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts1, counts2, counts3;
+  expressInterest(makeInterest(Name("/test/data")), counts1);
+  expressInterest(makeInterest(Name("/test/data")), counts2);
+  expressInterest(makeInterest(Name("/test/data")), counts3);
+  ASSERT_EQ(1, transport_->sentPackets_.size()) <<
+    "An identical Interest should not be sent again";
+  ASSERT_EQ(3, face_.getExpressedInterestCount());
+  ASSERT_EQ(2, face_.getAggregatedInterestCount());
+
+  transport_->receiveData(Name("/test/data"));
+  ASSERT_EQ(1, counts1.nData_);
+  ASSERT_EQ(1, counts2.nData_) << "The Data should go to every callback";
+  ASSERT_EQ(1, counts3.nData_);
+
+  // The Interest is no longer outstanding, so send it.
+  Counts counts4;
+  expressInterest(makeInterest(Name("/test/data")), counts4);
+  ASSERT_EQ(2, transport_->sentPackets_.size());
+}
+
+TEST_F(TestInterestAggregation, DifferentInterests)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts;
+  expressInterest(makeInterest(Name("/test/data")), counts);
+  expressInterest(makeInterest(Name("/test/other")), counts);
+  Interest mustBeFresh = makeInterest(Name("/test/data"));
+  mustBeFresh.setMustBeFresh(true);
+  expressInterest(mustBeFresh, counts);
+  Interest canBePrefix = makeInterest(Name("/test/data"));
+  canBePrefix.setCanBePrefix(true);
+  expressInterest(canBePrefix, counts);
+  Interest otherLifetime = makeInterest(Name("/test/data"));
+  otherLifetime.setInterestLifetimeMilliseconds(1000);
+  expressInterest(otherLifetime, counts);
+
+  ASSERT_EQ(5, transport_->sentPackets_.size()) <<
+    "Interests with a different name or selectors should be sent";
+  ASSERT_EQ(0, face_.getAggregatedInterestCount());
+}
+
+TEST_F(TestInterestAggregation, RemovePendingInterest)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts1, counts2;
+  uint64_t pendingInterestId = expressInterest
+    (makeInterest(Name("/test/data")), counts1);
+  expressInterest(makeInterest(Name("/test/data")), counts2);
+  ASSERT_EQ(1, transport_->sentPackets_.size());
+
+  face_.removePendingInterest(pendingInterestId);
+  transport_->receiveData(Name("/test/data"));
+  ASSERT_EQ(0, counts1.nData_);
+  ASSERT_EQ(1, counts2.nData_) <<
+    "Removing the sent Interest should not affect the aggregated one";
+}
+
+TEST_F(TestInterestAggregation, Nack)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts1, counts2;
+  expressInterest(makeInterest(Name("/test/data")), counts1);
+  expressInterest(makeInterest(Name("/test/data")), counts2);
+  ASSERT_EQ(1, transport_->sentPackets_.size());
+
+  Interest sentInterest;
+  sentInterest.wireDecode(transport_->sentPackets_[0]);
+  NetworkNack networkNack;
+  networkNack.setReason(ndn_NetworkNackReason_NO_ROUTE);
+  face_.putNack(sentInterest, networkNack);
+  transport_->receive(transport_->sentPackets_.back());
+
+  ASSERT_EQ(1, counts1.nNacks_);
+  ASSERT_EQ(1, counts2.nNacks_) << "The Nack should go to every callback";
+}
+
+#if NDN_CPP_HAVE_UNISTD_H
+
+TEST_F(TestInterestAggregation, Timeout)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts1, counts2;
+  Interest interest = makeInterest(Name("/test/data"));
+  interest.setInterestLifetimeMilliseconds(50);
+  expressInterest(interest, counts1);
+  expressInterest(interest, counts2);
+  ASSERT_EQ(1, transport_->sentPackets_.size());
+
+  for (int i = 0; i < 100 && counts2.nTimeouts_ == 0; ++i) {
+    face_.processEvents();
+    usleep(10000);
+  }
+  ASSERT_EQ(1, counts1.nTimeouts_);
+  ASSERT_EQ(1, counts2.nTimeouts_) << "Every callback should time out";
+}
+
+TEST_F(TestInterestAggregation, TimeoutWithSentInterest)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts1, counts2;
+  Interest interest = makeInterest(Name("/test/data"));
+  interest.setInterestLifetimeMilliseconds(200);
+  expressInterest(interest, counts1);
+  usleep(150000);
+  expressInterest(interest, counts2);
+  ASSERT_EQ(1, transport_->sentPackets_.size());
+
+  for (int i = 0; i < 200 && counts1.nTimeouts_ == 0; ++i) {
+    face_.processEvents();
+    usleep(5000);
+  }
+  ASSERT_EQ(1, counts1.nTimeouts_);
+  ASSERT_EQ(1, counts2.nTimeouts_) <<
+    "The aggregated entry should time out with the sent Interest, not a full "
+    "lifetime after it was expressed";
+}
+
+TEST_F(TestInterestAggregation, TimeoutAfterRemovingSentInterest)
+{
+  face_.setInterestAggregationEnabled(true);
+
+  Counts counts1, counts2;
+  Interest interest = makeInterest(Name("/test/data"));
+  interest.setInterestLifetimeMilliseconds(200);
+  MillisecondsSince1970 start = ndn_getNowMilliseconds();
+  uint64_t pendingInterestId = expressInterest(interest, counts1);
+  usleep(150000);
+  expressInterest(interest, counts2);
+  face_.removePendingInterest(pendingInterestId);
+
+  for (int i = 0; i < 200 && counts2.nTimeouts_ == 0; ++i) {
+    face_.processEvents();
+    usleep(5000);
+  }
+  Milliseconds elapsed = ndn_getNowMilliseconds() - start;
+  ASSERT_EQ(0, counts1.nTimeouts_);
+  ASSERT_EQ(1, counts2.nTimeouts_);
+  ASSERT_TRUE(elapsed < 300) <<
+    "The aggregated entry should time out when the sent Interest's lifetime ends";
+}
+
+#endif // NDN_CPP_HAVE_UNISTD_H
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
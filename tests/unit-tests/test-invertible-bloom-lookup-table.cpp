@@ -21,6 +21,7 @@
  */
 
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <ndn-cpp/name.hpp>
 #include <ndn-cpp/lite/util/crypto-lite.hpp>
 #include "../../src/sync/detail/invertible-bloom-lookup-table.hpp"
@@ -82,6 +83,73 @@ TEST_F(TestInvertibleBloomLookupTable, NameAppendAndExtract)
                runtime_error);
 }
 
+TEST_F(TestInvertibleBloomLookupTable, SparseEncoding)
+{
+  size_t size = 1000;
+
+  InvertibleBloomLookupTable iblt(size);
+  for (int i = 0; i < 10; ++i) {
+    string prefix = Name("/test/memphis").appendNumber(i).toUri();
+    iblt.insert(CryptoLite::murmurHash3(11, prefix.data(), prefix.size()));
+  }
+  // Make a negative count.
+  string prefix = Name("/test/memphis").appendNumber(100).toUri();
+  iblt.erase(CryptoLite::murmurHash3(11, prefix.data(), prefix.size()));
+
+  Blob encodedIblt = iblt.encodeSparse();
+  ASSERT_TRUE(encodedIblt.size() <= iblt.encode().size()) <<
+    "The sparse encoding of a sparse IBLT should not be larger than zlib";
+
+  InvertibleBloomLookupTable received(size);
+  received.initializeSparse(encodedIblt);
+  ASSERT_TRUE(iblt.equals(received));
+
+  InvertibleBloomLookupTable empty(size);
+  InvertibleBloomLookupTable receivedEmpty(size);
+  receivedEmpty.initializeSparse(empty.encodeSparse());
+  ASSERT_TRUE(empty.equals(receivedEmpty));
+
+  InvertibleBloomLookupTable receivedDifferentSize(2000);
+  ASSERT_THROW(receivedDifferentSize.initializeSparse(encodedIblt),
+               runtime_error);
+  InvertibleBloomLookupTable receivedTruncated(size);
+  ASSERT_THROW(receivedTruncated.initializeSparse
+               (Blob(encodedIblt.buf(), encodedIblt.size() - 1)),
+               runtime_error);
+}
+
+TEST_F(TestInvertibleBloomLookupTable, CachedEncoding)
+{
+  size_t size = 10;
+
+  InvertibleBloomLookupTable iblt(size);
+  string prefix = Name("/test/memphis").appendNumber(1).toUri();
+  uint32_t hash1 = CryptoLite::murmurHash3(11, prefix.data(), prefix.size());
+  iblt.insert(hash1);
+
+  Blob encoding1 = iblt.encode();
+  Blob sparseEncoding1 = iblt.encodeSparse();
+  ASSERT_EQ(encoding1.buf(), iblt.encode().buf()) <<
+    "encode should return the cached encoding if the IBLT is unchanged";
+  ASSERT_EQ(sparseEncoding1.buf(), iblt.encodeSparse().buf());
+
+  prefix = Name("/test/memphis").appendNumber(2).toUri();
+  uint32_t hash2 = CryptoLite::murmurHash3(11, prefix.data(), prefix.size());
+  iblt.insert(hash2);
+  ASSERT_FALSE(encoding1.equals(iblt.encode())) <<
+    "insert should clear the cached encoding";
+  ASSERT_FALSE(sparseEncoding1.equals(iblt.encodeSparse()));
+
+  iblt.erase(hash2);
+  ASSERT_TRUE(encoding1.equals(iblt.encode())) <<
+    "erase should clear the cached encoding";
+  ASSERT_TRUE(sparseEncoding1.equals(iblt.encodeSparse()));
+
+  InvertibleBloomLookupTable empty(size);
+  ASSERT_TRUE(empty.encode().equals(iblt.difference(iblt)->encode())) <<
+    "difference should not return the cached encoding of this IBLT";
+}
+
 TEST_F(TestInvertibleBloomLookupTable, CopyInsertErase)
 {
   size_t size = 10;
@@ -128,8 +196,8 @@ TEST_F(TestInvertibleBloomLookupTable, HigherSequence)
 
   ptr_lib::shared_ptr<InvertibleBloomLookupTable> diff =
     ownIblt.difference(receivedIblt);
-  set<uint32_t> positive;
-  set<uint32_t> negative;
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
 
   ASSERT_TRUE(diff->listEntries(positive, negative));
   ASSERT_EQ(1, positive.size());
@@ -151,8 +219,8 @@ TEST_F(TestInvertibleBloomLookupTable, Difference)
     ownIblt.difference(receivedIblt);
 
   // Non-empty positive means we have some elements that the other doesn't.
-  set<uint32_t> positive;
-  set<uint32_t> negative;
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
 
   ASSERT_TRUE(diff->listEntries(positive, negative));
   ASSERT_EQ(0, positive.size());
@@ -201,8 +269,8 @@ TEST_F(TestInvertibleBloomLookupTable, DifferenceBwOversizedIblts)
   ptr_lib::shared_ptr<InvertibleBloomLookupTable> diff =
     ownIblt.difference(receivedIblt);
 
-  set<uint32_t> positive;
-  set<uint32_t> negative;
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
   ASSERT_TRUE(diff->listEntries(positive, negative));
   ASSERT_EQ(1, positive.size());
   ASSERT_EQ(newHash, *positive.begin());
@@ -212,6 +280,41 @@ TEST_F(TestInvertibleBloomLookupTable, DifferenceBwOversizedIblts)
   ASSERT_TRUE(!receivedIblt.listEntries(positive, negative));
 }
 
+TEST_F(TestInvertibleBloomLookupTable, ListManyEntries)
+{
+  size_t size = 1000;
+
+  InvertibleBloomLookupTable ownIblt(size);
+  InvertibleBloomLookupTable receivedIblt(size);
+  vector<uint32_t> ownHashes;
+  vector<uint32_t> receivedHashes;
+  for (int i = 0; i < 400; ++i) {
+    string prefix = Name("/test/own").appendNumber(i).toUri();
+    uint32_t hash = CryptoLite::murmurHash3(11, prefix.data(), prefix.size());
+    ownIblt.insert(hash);
+    ownHashes.push_back(hash);
+
+    prefix = Name("/test/received").appendNumber(i).toUri();
+    hash = CryptoLite::murmurHash3(11, prefix.data(), prefix.size());
+    receivedIblt.insert(hash);
+    receivedHashes.push_back(hash);
+
+    prefix = Name("/test/both").appendNumber(i).toUri();
+    hash = CryptoLite::murmurHash3(11, prefix.data(), prefix.size());
+    ownIblt.insert(hash);
+    receivedIblt.insert(hash);
+  }
+  sort(ownHashes.begin(), ownHashes.end());
+  sort(receivedHashes.begin(), receivedHashes.end());
+
+  vector<uint32_t> positive;
+  vector<uint32_t> negative;
+  ASSERT_TRUE(ownIblt.difference(receivedIblt)->listEntries(positive, negative));
+  ASSERT_TRUE(positive == ownHashes) <<
+    "listEntries should return all the positive entries, sorted";
+  ASSERT_TRUE(negative == receivedHashes);
+}
+
 int
 main(int argc, char **argv)
 {
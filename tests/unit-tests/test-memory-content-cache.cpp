@@ -0,0 +1,347 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/util/memory-content-cache.hpp>
+#include <ndn-cpp/util/eviction-policy.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+/**
+ * CaptureFace extends Face to capture the onInterest callback from
+ * setInterestFilter and to decode each packet sent instead of sending it.
+ */
+class CaptureFace : public Face {
+public:
+  CaptureFace()
+  : Face("localhost")
+  {
+  }
+
+  virtual uint64_t
+  setInterestFilter(const Name& prefix, const OnInterestCallback& onInterest)
+  {
+    prefix_ = ptr_lib::make_shared<Name>(prefix);
+    onInterest_ = onInterest;
+    return 0;
+  }
+
+  virtual void
+  send(const uint8_t *encoding, size_t encodingLength)
+  {
+    ptr_lib::shared_ptr<Data> data(new Data());
+    data->wireDecode(encoding, encodingLength);
+    sentData_.push_back(data);
+  }
+
+  /**
+   * Call the captured onInterest callback as if the Interest was received.
+   * @param interest The received Interest.
+   * @return The name of the Data packet sent in reply, or an empty Name if no
+   * reply.
+   */
+  Name
+  receive(const Interest& interest)
+  {
+    sentData_.clear();
+    onInterest_
+      (prefix_, ptr_lib::make_shared<Interest>(interest), *this, 0,
+       ptr_lib::shared_ptr<const InterestFilter>());
+
+    if (sentData_.size() == 0)
+      return Name();
+    else
+      return sentData_[0]->getName();
+  }
+
+  vector<ptr_lib::shared_ptr<Data> > sentData_;
+
+private:
+  ptr_lib::shared_ptr<const Name> prefix_;
+  OnInterestCallback onInterest_;
+};
+
+static Data
+makeData(const Name& name, Milliseconds freshnessPeriod = -1)
+{
+  Data data(name);
+  if (freshnessPeriod >= 0)
+    data.getMetaInfo().setFreshnessPeriod(freshnessPeriod);
+  data.setSignature(DigestSha256Signature());
+  return data;
+}
+
+class TestMemoryContentCache : public ::testing::Test {
+public:
+  TestMemoryContentCache()
+  : cache_(&face_)
+  {
+    Interest::setDefaultCanBePrefix(true);
+    cache_.setInterestFilter(Name("/A"));
+  }
+
+  CaptureFace face_;
+  MemoryContentCache cache_;
+};
+
+TEST_F(TestMemoryContentCache, ExactAndPrefix)
+{
+  cache_.add(makeData(Name("/A/B/2")));
+  cache_.add(makeData(Name("/A/B/1"), 10000));
+  cache_.add(makeData(Name("/A/C/1")));
+  cache_.add(makeData(Name("/A/BB/1")));
+
+  ASSERT_EQ(Name("/A/B/2"), face_.receive(Interest(Name("/A/B/2"))));
+  ASSERT_EQ(Name("/A/C/1"), face_.receive(Interest(Name("/A/C"))));
+  ASSERT_EQ(Name(), face_.receive(Interest(Name("/A/D")))) <<
+    "Should not match a name without the prefix";
+  ASSERT_EQ(Name(), face_.receive(Interest(Name("/A/B/3"))));
+
+  // /A/BB/1 does not have the prefix /A/B .
+  Name name = face_.receive(Interest(Name("/A/B")));
+  ASSERT_TRUE(name == Name("/A/B/1") || name == Name("/A/B/2"));
+}
+
+TEST_F(TestMemoryContentCache, ChildSelector)
+{
+  cache_.add(makeData(Name("/A/B/2")));
+  cache_.add(makeData(Name("/A/B/3"), 10000));
+  cache_.add(makeData(Name("/A/B/1")));
+  cache_.add(makeData(Name("/A/B/3/x")));
+  cache_.add(makeData(Name("/A/C/9")));
+
+  Interest interest(Name("/A/B"));
+  interest.setChildSelector(0);
+  ASSERT_EQ(Name("/A/B/1"), face_.receive(interest));
+  interest.setChildSelector(1);
+  // /A/B/3 and /A/B/3/x have the same child component.
+  ASSERT_EQ(Name::Component("3"), face_.receive(interest).get(2));
+
+  interest.setMaxSuffixComponents(2);
+  ASSERT_EQ(Name("/A/B/3"), face_.receive(interest));
+
+  interest.setMaxSuffixComponents(-1);
+  interest.getExclude().appendComponent(Name::Component("3"));
+  ASSERT_EQ(Name("/A/B/2"), face_.receive(interest));
+}
+
+TEST_F(TestMemoryContentCache, MustBeFresh)
+{
+  cache_.add(makeData(Name("/A/B/1"), 0));
+  cache_.add(makeData(Name("/A/B/2"), 10000));
+  cache_.add(makeData(Name("/A/B/3")));
+  cache_.setMinimumCacheLifetime(100000);
+  cache_.add(makeData(Name("/A/B/4"), 0));
+
+  Interest interest(Name("/A/B"));
+  interest.setMustBeFresh(true);
+  interest.setChildSelector(0);
+  ASSERT_EQ(Name("/A/B/2"), face_.receive(interest)) <<
+    "Should skip content with a zero freshness period";
+  interest.setChildSelector(1);
+  ASSERT_EQ(Name("/A/B/3"), face_.receive(interest)) <<
+    "Content without a freshness period should stay fresh";
+
+  interest.setMustBeFresh(false);
+  ASSERT_EQ(Name("/A/B/4"), face_.receive(interest)) <<
+    "Stale content should match until it is removed";
+}
+
+TEST_F(TestMemoryContentCache, Cleanup)
+{
+  // Use a zero cleanup interval so that add and onInterest remove stale content.
+  MemoryContentCache cache(&face_, 0);
+  cache.setInterestFilter(Name("/A"));
+  cache.add(makeData(Name("/A/B/1"), 0));
+  cache.add(makeData(Name("/A/B/2")));
+
+  Interest interest(Name("/A/B"));
+  interest.setChildSelector(0);
+  ASSERT_EQ(Name("/A/B/2"), face_.receive(interest)) <<
+    "Cleanup should remove the stale content from the index";
+}
+
+static void
+onContentRemoved
+  (const ptr_lib::shared_ptr<MemoryContentCache::ContentList>& contentList,
+   vector<Name>* removedNames)
+{
+  for (size_t i = 0; i < contentList->size(); ++i)
+    removedNames->push_back((*contentList)[i]->getName());
+}
+
+/**
+ * Add /A/1 to /A/nPackets and set the byte limit to hold maxPackets of them.
+ * All the packets have the same size.
+ */
+static void
+addPackets
+  (MemoryContentCache& cache, int nPackets, int maxPackets)
+{
+  size_t packetSize = makeData(Name("/A/1")).wireEncode().size();
+  cache.setMaxCacheBytes(maxPackets * packetSize);
+  for (int i = 1; i <= nPackets; ++i)
+    cache.add(makeData(Name("/A").append(Name::Component(to_string(i)))));
+}
+
+TEST_F(TestMemoryContentCache, LruEviction)
+{
+  vector<Name> removedNames;
+  cache_.setOnContentRemoved(bind(&onContentRemoved, _1, &removedNames));
+  addPackets(cache_, 3, 3);
+  ASSERT_EQ(0, removedNames.size());
+
+  // Use /A/1 so that /A/2 is the least recently used.
+  ASSERT_EQ(Name("/A/1"), face_.receive(Interest(Name("/A/1"))));
+  cache_.add(makeData(Name("/A/4")));
+  ASSERT_EQ(1, removedNames.size());
+  ASSERT_EQ(Name("/A/2"), removedNames[0]) <<
+    "onContentRemoved should get the evicted content";
+  ASSERT_EQ(Name(), face_.receive(Interest(Name("/A/2"))));
+  ASSERT_EQ(Name("/A/1"), face_.receive(Interest(Name("/A/1"))));
+
+  ASSERT_EQ(1, cache_.getEvictionCount());
+  ASSERT_EQ(2, cache_.getHitCount());
+  ASSERT_EQ(1, cache_.getMissCount());
+  ASSERT_TRUE(cache_.getCacheBytes() <= cache_.getMaxCacheBytes());
+}
+
+TEST_F(TestMemoryContentCache, FifoEviction)
+{
+  cache_.setEvictionPolicy(ptr_lib::make_shared<FifoEvictionPolicy>());
+  addPackets(cache_, 3, 3);
+
+  ASSERT_EQ(Name("/A/1"), face_.receive(Interest(Name("/A/1"))));
+  cache_.add(makeData(Name("/A/4")));
+  ASSERT_EQ(Name(), face_.receive(Interest(Name("/A/1")))) <<
+    "FIFO should evict the first content even if it was used";
+}
+
+TEST_F(TestMemoryContentCache, LfuEviction)
+{
+  cache_.setEvictionPolicy(ptr_lib::make_shared<LfuEvictionPolicy>());
+  addPackets(cache_, 3, 3);
+
+  face_.receive(Interest(Name("/A/1")));
+  face_.receive(Interest(Name("/A/1")));
+  face_.receive(Interest(Name("/A/3")));
+  cache_.add(makeData(Name("/A/4")));
+  ASSERT_EQ(Name(), face_.receive(Interest(Name("/A/2"))));
+
+  // /A/4 is now the least frequently used.
+  cache_.add(makeData(Name("/A/5")));
+  ASSERT_EQ(Name(), face_.receive(Interest(Name("/A/4"))));
+  ASSERT_EQ(Name("/A/1"), face_.receive(Interest(Name("/A/1"))));
+  ASSERT_EQ(Name("/A/3"), face_.receive(Interest(Name("/A/3"))));
+}
+
+TEST_F(TestMemoryContentCache, WTinyLfuEviction)
+{
+  cache_.setEvictionPolicy(ptr_lib::make_shared<WTinyLfuEvictionPolicy>());
+  addPackets(cache_, 10, 10);
+  // Make /A/1 to /A/5 popular.
+  for (int n = 0; n < 3; ++n) {
+    for (int i = 1; i <= 5; ++i)
+      face_.receive(Interest(Name("/A").append(Name::Component(to_string(i)))));
+  }
+
+  // Scan many new names which are each used once.
+  for (int i = 100; i < 200; ++i)
+    cache_.add(makeData(Name("/A").append(Name::Component(to_string(i)))));
+
+  for (int i = 1; i <= 5; ++i) {
+    Name name("/A");
+    name.append(Name::Component(to_string(i)));
+    ASSERT_EQ(name, face_.receive(Interest(name))) <<
+      "A scan should not evict the popular content";
+  }
+  ASSERT_TRUE(cache_.getCacheBytes() <= cache_.getMaxCacheBytes());
+}
+
+TEST_F(TestMemoryContentCache, StaleContentLeavesPolicy)
+{
+  // Use a zero cleanup interval so that add removes stale content.
+  MemoryContentCache cache(&face_, 0);
+  cache.setInterestFilter(Name("/A"));
+  cache.setMaxCacheBytes(1000000);
+  cache.add(makeData(Name("/A/1"), 0));
+  cache.add(makeData(Name("/A/2")));
+  ASSERT_EQ(makeData(Name("/A/2")).wireEncode().size(), cache.getCacheBytes()) <<
+    "Cleanup should subtract the bytes of stale content";
+
+  // Evict everything. The policy should not return the removed /A/1 .
+  cache.setMaxCacheBytes(1);
+  ASSERT_EQ(0, cache.getCacheBytes());
+  ASSERT_EQ(1, cache.getEvictionCount());
+}
+
+TEST_F(TestMemoryContentCache, PendingInterests)
+{
+  ptr_lib::shared_ptr<Interest> exactInterest(new Interest(Name("/A/B/1")));
+  exactInterest->setCanBePrefix(false);
+  cache_.storePendingInterest
+    (ptr_lib::make_shared<Interest>(Name("/A/B")), face_);
+  cache_.storePendingInterest(exactInterest, face_);
+  cache_.storePendingInterest
+    (ptr_lib::make_shared<Interest>(Name("/A/C")), face_);
+  cache_.storePendingInterest
+    (ptr_lib::make_shared<Interest>(Name("/A/BB")), face_);
+  ptr_lib::shared_ptr<Interest> timedOutInterest(new Interest(Name("/A/B")));
+  timedOutInterest->setInterestLifetimeMilliseconds(0);
+  cache_.storePendingInterest(timedOutInterest, face_);
+
+  vector<ptr_lib::shared_ptr<const MemoryContentCache::PendingInterest> >
+    pendingInterests;
+  cache_.getPendingInterestsForName(Name("/A/B/1"), pendingInterests);
+  ASSERT_EQ(2, pendingInterests.size()) <<
+    "Should match /A/B and /A/B/1 but not the timed-out interest";
+  cache_.getPendingInterestsForName(Name("/A/B/2"), pendingInterests);
+  ASSERT_EQ(1, pendingInterests.size());
+  ASSERT_EQ(Name("/A/B"), pendingInterests[0]->getInterest()->getName());
+  cache_.getPendingInterestsWithPrefix(Name("/A/B"), pendingInterests);
+  ASSERT_EQ(2, pendingInterests.size()) << "/A/BB does not have the prefix /A/B";
+  cache_.getPendingInterestsWithPrefix(Name("/A"), pendingInterests);
+  ASSERT_EQ(4, pendingInterests.size());
+
+  face_.sentData_.clear();
+  cache_.add(makeData(Name("/A/B/1")));
+  ASSERT_EQ(2, face_.sentData_.size()) <<
+    "Adding the Data should satisfy /A/B and /A/B/1";
+  cache_.getPendingInterestsWithPrefix(Name("/A"), pendingInterests);
+  ASSERT_EQ(2, pendingInterests.size());
+  // In the canonical order, the shorter component C is first.
+  ASSERT_EQ(Name("/A/C"), pendingInterests[0]->getInterest()->getName());
+  ASSERT_EQ(Name("/A/BB"), pendingInterests[1]->getInterest()->getName());
+
+  face_.sentData_.clear();
+  cache_.add(makeData(Name("/A/B/2")));
+  ASSERT_EQ(0, face_.sentData_.size()) <<
+    "A satisfied interest should not be satisfied again";
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,332 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <set>
+#include <ndn-cpp/security/key-chain.hpp>
+#include <ndn-cpp/sync/partial-psync2017-producer.hpp>
+#include <ndn-cpp/sync/partial-psync2017-consumer.hpp>
+#include <ndn-cpp/lite/util/crypto-lite.hpp>
+#include "../../src/sync/detail/bloom-filter.hpp"
+#include "hub-transport.hpp"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+class TestBloomFilter : public ::testing::Test {
+};
+
+TEST_F(TestBloomFilter, InsertAndContains)
+{
+  BloomFilter bloomFilter(100, 0.001);
+  for (int i = 0; i < 100; ++i)
+    bloomFilter.insert(Name("/test/memphis").appendNumber(i).toUri());
+
+  for (int i = 0; i < 100; ++i)
+    ASSERT_TRUE(bloomFilter.contains
+                (Name("/test/memphis").appendNumber(i).toUri()));
+
+  int nFalsePositives = 0;
+  for (int i = 100; i < 1100; ++i) {
+    if (bloomFilter.contains(Name("/test/memphis").appendNumber(i).toUri()))
+      ++nFalsePositives;
+  }
+  // The expected number of false positives is 1.
+  ASSERT_TRUE(nFalsePositives < 10) << "Too many false positives";
+
+  bloomFilter.clear();
+  ASSERT_FALSE(bloomFilter.contains(Name("/test/memphis").appendNumber(0).toUri()));
+}
+
+TEST_F(TestBloomFilter, AppendToName)
+{
+  BloomFilter bloomFilter(100, 0.001);
+  bloomFilter.insert("/test/memphis");
+
+  Name name("/sync");
+  bloomFilter.appendToName(name);
+  ASSERT_EQ(4, name.size());
+  ASSERT_EQ(100, name.get(1).toNumber());
+  ASSERT_EQ(1, name.get(2).toNumber());
+
+  BloomFilter decoded
+    (name.get(1).toNumber(), name.get(2).toNumber() / 1000.0,
+     name.get(3).getValue());
+  ASSERT_TRUE(decoded.contains("/test/memphis"));
+  ASSERT_FALSE(decoded.contains("/test/nashville"));
+
+  ASSERT_THROW
+    (BloomFilter(200, 0.001, name.get(3).getValue()), runtime_error) <<
+    "A bit table with the wrong size should throw an exception";
+}
+
+#if NDN_CPP_HAVE_LIBZ
+
+/**
+ * A Subscriber has a PartialPSync2017Consumer which subscribes to some of the
+ * prefixes from the hello Data, and saves the updates.
+ */
+class Subscriber {
+public:
+  Subscriber
+    (Hub& hub, const Name& syncPrefix, const set<Name>& wantedPrefixes)
+  : transport_(new HubTransport(hub)),
+    face_(transport_, ptr_lib::make_shared<Transport::ConnectionInfo>()),
+    wantedPrefixes_(wantedPrefixes),
+    consumer_
+      (syncPrefix, face_, bind(&Subscriber::onReceiveHelloData, this, _1),
+       bind(&Subscriber::onUpdate, this, _1), 80, 0.001),
+    receivedHello_(false)
+  {
+  }
+
+  void
+  onReceiveHelloData(const map<Name, int>& availableSubscriptions)
+  {
+    receivedHello_ = true;
+    availableSubscriptions_ = availableSubscriptions;
+    for (set<Name>::const_iterator prefix = wantedPrefixes_.begin();
+         prefix != wantedPrefixes_.end(); ++prefix) {
+      map<Name, int>::const_iterator available =
+        availableSubscriptions.find(*prefix);
+      if (available != availableSubscriptions.end())
+        consumer_.addSubscription(*prefix, available->second);
+    }
+
+    consumer_.sendSyncInterest();
+  }
+
+  void
+  onUpdate
+    (const ptr_lib::shared_ptr<vector<ptr_lib::shared_ptr<PSyncMissingDataInfo>>>& updates)
+  {
+    for (size_t i = 0; i < updates->size(); ++i)
+      updates_.push_back(*(*updates)[i]);
+  }
+
+  ptr_lib::shared_ptr<HubTransport> transport_;
+  Face face_;
+  set<Name> wantedPrefixes_;
+  PartialPSync2017Consumer consumer_;
+  bool receivedHello_;
+  map<Name, int> availableSubscriptions_;
+  vector<PSyncMissingDataInfo> updates_;
+};
+
+class TestPartialPSync2017 : public ::testing::Test {
+public:
+  TestPartialPSync2017()
+  : keyChain_("pib-memory:", "tpm-memory:"),
+    syncPrefix_("/test/partial-psync"),
+    producerFace_
+      (ptr_lib::make_shared<HubTransport>(hub_),
+       ptr_lib::make_shared<Transport::ConnectionInfo>())
+  {
+    keyChain_.createIdentityV2(Name("/test"), EcKeyParams());
+    producerFace_.setCommandSigningInfo
+      (keyChain_, keyChain_.getDefaultCertificateName());
+  }
+
+  /**
+   * Deliver packets and process events on all the faces until isDone returns
+   * true or until the timeout.
+   * @param isDone The function to check if finished.
+   * @param timeoutMilliseconds The maximum time to wait.
+   * @return The final value of isDone().
+   */
+  bool
+  processEventsUntil
+    (const func_lib::function<bool()>& isDone, Milliseconds timeoutMilliseconds)
+  {
+    MillisecondsSince1970 endTime =
+      ndn_getNowMilliseconds() + timeoutMilliseconds;
+    while (!isDone()) {
+      if (ndn_getNowMilliseconds() >= endTime)
+        return false;
+
+      hub_.deliver();
+      producerFace_.processEvents();
+      for (size_t i = 0; i < subscribers_.size(); ++i)
+        subscribers_[i]->face_.processEvents();
+      hub_.deliver();
+      // Sleep for a millisecond so we don't use 100% of the CPU.
+      usleep(1000);
+    }
+
+    return true;
+  }
+
+  static bool
+  isFalse() { return false; }
+
+  bool
+  allReceivedHello()
+  {
+    for (size_t i = 0; i < subscribers_.size(); ++i) {
+      if (!subscribers_[i]->receivedHello_)
+        return false;
+    }
+    return true;
+  }
+
+  static bool
+  hasNUpdates(const Subscriber* subscriber, size_t nUpdates)
+  {
+    return subscriber->updates_.size() >= nUpdates;
+  }
+
+  Hub hub_;
+  KeyChain keyChain_;
+  Name syncPrefix_;
+  Face producerFace_;
+  vector<ptr_lib::shared_ptr<Subscriber> > subscribers_;
+};
+
+TEST_F(TestPartialPSync2017, ManyProducersFewSubscribers)
+{
+  const int nUserPrefixes = 200;
+  const int nSubscribers = 3;
+  const int nSubscribed = 10;
+
+  // Each user prefix is a separate producer of application data which shares
+  // the PartialPSync2017Producer.
+  PartialPSync2017Producer producer
+    (40, producerFace_, syncPrefix_, Name(), keyChain_);
+  vector<Name> userPrefixes;
+  for (int i = 0; i < nUserPrefixes; ++i) {
+    userPrefixes.push_back(Name("/test/user").appendNumber(i));
+    ASSERT_TRUE(producer.addUserNode(userPrefixes[i]));
+    producer.publishName(userPrefixes[i]);
+  }
+  ASSERT_FALSE(producer.addUserNode(userPrefixes[0]));
+  // Wait for the prefix registration.
+  processEventsUntil(&TestPartialPSync2017::isFalse, 50);
+
+  // Subscriber k subscribes to user prefixes k, k + nSubscribers, ...
+  for (int k = 0; k < nSubscribers; ++k) {
+    set<Name> wantedPrefixes;
+    for (int i = 0; i < nSubscribed; ++i)
+      wantedPrefixes.insert(userPrefixes[k + i * nSubscribers]);
+    subscribers_.push_back(ptr_lib::make_shared<Subscriber>
+      (hub_, syncPrefix_, wantedPrefixes));
+  }
+
+  for (int k = 0; k < nSubscribers; ++k)
+    subscribers_[k]->consumer_.sendHelloInterest();
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestPartialPSync2017::allReceivedHello, this), 2000)) <<
+    "Each subscriber should receive the hello Data";
+
+  for (int k = 0; k < nSubscribers; ++k) {
+    Subscriber& subscriber = *subscribers_[k];
+    ASSERT_EQ(nUserPrefixes, subscriber.availableSubscriptions_.size()) <<
+      "The hello Data should have all the user prefixes";
+    ASSERT_EQ(1, subscriber.availableSubscriptions_[userPrefixes[0]]);
+    ASSERT_EQ(1, subscriber.consumer_.getSequenceNo(userPrefixes[k]));
+    ASSERT_FALSE(subscriber.consumer_.isSubscribed(userPrefixes[k + 1]));
+  }
+  // Let the sync Interests reach the producer.
+  processEventsUntil(&TestPartialPSync2017::isFalse, 50);
+
+  // Publish a new sequence number for each subscribed prefix, and for some
+  // prefixes which nobody subscribes to.
+  for (int i = 0; i < nSubscribed * nSubscribers; ++i) {
+    producer.publishName(userPrefixes[i]);
+    producer.publishName(userPrefixes[nUserPrefixes - 1 - i]);
+
+    Subscriber* subscriber = subscribers_[i % nSubscribers].get();
+    ASSERT_TRUE(processEventsUntil
+      (bind(&TestPartialPSync2017::hasNUpdates, subscriber,
+            i / nSubscribers + 1),
+       3000)) << "The subscriber should receive the update for " <<
+      userPrefixes[i];
+    // Let the subscriber send its next sync Interest.
+    processEventsUntil(&TestPartialPSync2017::isFalse, 20);
+  }
+
+  for (int k = 0; k < nSubscribers; ++k) {
+    Subscriber& subscriber = *subscribers_[k];
+    ASSERT_EQ(nSubscribed, subscriber.updates_.size()) <<
+      "Each subscriber should only receive updates for its subscriptions";
+
+    for (size_t j = 0; j < subscriber.updates_.size(); ++j) {
+      const PSyncMissingDataInfo& update = subscriber.updates_[j];
+      ASSERT_TRUE(subscriber.wantedPrefixes_.count(update.prefix_) > 0);
+      ASSERT_EQ(2, update.lowSequenceNo_);
+      ASSERT_EQ(2, update.highSequenceNo_);
+      ASSERT_EQ(2, subscriber.consumer_.getSequenceNo(update.prefix_));
+    }
+  }
+}
+
+TEST_F(TestPartialPSync2017, RemoveSubscription)
+{
+  PartialPSync2017Producer producer
+    (40, producerFace_, syncPrefix_, Name("/test/user/a"), keyChain_);
+  ASSERT_TRUE(producer.addUserNode(Name("/test/user/b")));
+  processEventsUntil(&TestPartialPSync2017::isFalse, 50);
+
+  set<Name> wantedPrefixes;
+  wantedPrefixes.insert(Name("/test/user/a"));
+  wantedPrefixes.insert(Name("/test/user/b"));
+  subscribers_.push_back(ptr_lib::make_shared<Subscriber>
+    (hub_, syncPrefix_, wantedPrefixes));
+  Subscriber& subscriber = *subscribers_[0];
+
+  ASSERT_THROW(subscriber.consumer_.sendSyncInterest(), runtime_error) <<
+    "sendSyncInterest before the hello Data should throw an exception";
+
+  subscriber.consumer_.sendHelloInterest();
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestPartialPSync2017::allReceivedHello, this), 2000));
+  ASSERT_EQ(0, subscriber.consumer_.getSequenceNo(Name("/test/user/a")));
+
+  ASSERT_TRUE(subscriber.consumer_.removeSubscription(Name("/test/user/a")));
+  ASSERT_FALSE(subscriber.consumer_.removeSubscription(Name("/test/user/a")));
+  ASSERT_FALSE(subscriber.consumer_.isSubscribed(Name("/test/user/a")));
+  ASSERT_EQ(-1, subscriber.consumer_.getSequenceNo(Name("/test/user/a")));
+  // The current sync Interest still has the old Bloom filter, so wait for it
+  // to time out and be sent again with the new Bloom filter.
+  processEventsUntil(&TestPartialPSync2017::isFalse, 1500);
+
+  producer.publishName(Name("/test/user/a"));
+  producer.publishName(Name("/test/user/b"));
+  ASSERT_TRUE(processEventsUntil
+    (bind(&TestPartialPSync2017::hasNUpdates, &subscriber, 1), 3000));
+  processEventsUntil(&TestPartialPSync2017::isFalse, 50);
+
+  ASSERT_EQ(1, subscriber.updates_.size());
+  ASSERT_EQ(Name("/test/user/b"), subscriber.updates_[0].prefix_);
+  ASSERT_EQ(1, subscriber.updates_[0].highSequenceNo_);
+}
+
+#endif // NDN_CPP_HAVE_LIBZ
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,520 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <ndn-cpp/digest-sha256-signature.hpp>
+#include <ndn-cpp/util/persistent-content-cache.hpp>
+#include "../../src/impl/mapped-content-store.hpp"
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+#if NDN_CPP_HAVE_UNISTD_H
+
+/**
+ * CaptureFace extends Face to capture the onInterest callback from
+ * setInterestFilter and to decode each packet sent instead of sending it.
+ */
+class CaptureFace : public Face {
+public:
+  CaptureFace()
+  : Face("localhost")
+  {
+  }
+
+  virtual uint64_t
+  setInterestFilter(const Name& prefix, const OnInterestCallback& onInterest)
+  {
+    prefix_ = ptr_lib::make_shared<Name>(prefix);
+    onInterest_ = onInterest;
+    return 0;
+  }
+
+  virtual void
+  send(const uint8_t *encoding, size_t encodingLength)
+  {
+    ptr_lib::shared_ptr<Data> data(new Data());
+    data->wireDecode(encoding, encodingLength);
+    sentData_.push_back(data);
+  }
+
+  /**
+   * Call the captured onInterest callback as if the Interest was received.
+   * @param interest The received Interest.
+   * @return The name of the Data packet sent in reply, or an empty Name if no
+   * reply.
+   */
+  Name
+  receive(const Interest& interest)
+  {
+    sentData_.clear();
+    onInterest_
+      (prefix_, ptr_lib::make_shared<Interest>(interest), *this, 0,
+       ptr_lib::shared_ptr<const InterestFilter>());
+
+    if (sentData_.size() == 0)
+      return Name();
+    else
+      return sentData_[0]->getName();
+  }
+
+  vector<ptr_lib::shared_ptr<Data> > sentData_;
+
+private:
+  ptr_lib::shared_ptr<const Name> prefix_;
+  OnInterestCallback onInterest_;
+};
+
+static Data
+makeData
+  (const Name& name, Milliseconds freshnessPeriod = -1,
+   const string& content = "")
+{
+  Data data(name);
+  if (freshnessPeriod >= 0)
+    data.getMetaInfo().setFreshnessPeriod(freshnessPeriod);
+  data.setContent((const uint8_t*)content.c_str(), content.size());
+  data.setSignature(DigestSha256Signature());
+  return data;
+}
+
+static string
+makeContent(int i)
+{
+  char content[32];
+  sprintf(content, "packet-%06d", i);
+  return content;
+}
+
+/**
+ * Search the file for the string and flip the bits of its first byte.
+ * @return True if found.
+ */
+static bool
+corruptFile(const string& filePath, const string& target)
+{
+  fstream file(filePath.c_str(), ios::in | ios::out | ios::binary);
+  string contents
+    ((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+  size_t position = contents.find(target);
+  if (position == string::npos)
+    return false;
+
+  file.clear();
+  file.seekp(position);
+  char value = ~contents[position];
+  file.write(&value, 1);
+  return true;
+}
+
+class TestPersistentContentCache : public ::testing::Test {
+public:
+  TestPersistentContentCache()
+  {
+    Interest::setDefaultCanBePrefix(true);
+    char directory[] = "/tmp/test-persistent-content-cache-XXXXXX";
+    if (mkdtemp(directory))
+      directory_ = directory;
+  }
+
+  ~TestPersistentContentCache()
+  {
+    // Remove the files and the directory.
+    DIR* directory = opendir(directory_.c_str());
+    if (directory) {
+      struct dirent* entry;
+      while ((entry = readdir(directory)) != 0) {
+        string fileName = entry->d_name;
+        if (fileName != "." && fileName != "..")
+          remove((directory_ + "/" + fileName).c_str());
+      }
+      closedir(directory);
+    }
+    rmdir(directory_.c_str());
+  }
+
+  string directory_;
+};
+
+TEST_F(TestPersistentContentCache, ExactAndPrefix)
+{
+  CaptureFace face;
+  PersistentContentCache cache(&face, directory_);
+  cache.setInterestFilter(Name("/A"));
+
+  cache.add(makeData(Name("/A/B/2")));
+  cache.add(makeData(Name("/A/B/1"), 10000));
+  cache.add(makeData(Name("/A/C/1")));
+  cache.add(makeData(Name("/A/BB/1")));
+  ASSERT_EQ(4, cache.size());
+
+  ASSERT_EQ(Name("/A/B/2"), face.receive(Interest(Name("/A/B/2"))));
+  ASSERT_EQ(Name("/A/C/1"), face.receive(Interest(Name("/A/C"))));
+  ASSERT_EQ(Name(), face.receive(Interest(Name("/A/D"))));
+  ASSERT_EQ(Name(), face.receive(Interest(Name("/A/B/3"))));
+
+  // /A/BB/1 does not have the prefix /A/B .
+  ASSERT_EQ(Name("/A/B/1"), face.receive(Interest(Name("/A/B")))) <<
+    "Without a ChildSelector, should return the leftmost match";
+  ASSERT_EQ(Name("/A/B/2"),
+            face.receive(Interest(Name("/A/B")).setChildSelector(1)));
+  ASSERT_EQ(Name("/A/B/1"),
+            face.receive(Interest(Name("/A/B")).setMustBeFresh(true))) <<
+    "Only /A/B/1 has a FreshnessPeriod";
+
+  Interest exact(Name("/A/B"));
+  exact.setCanBePrefix(false);
+  ASSERT_EQ(Name(), face.receive(exact)) <<
+    "Without CanBePrefix, should not match a longer name";
+
+  ASSERT_EQ(5, cache.getHitCount());
+  ASSERT_EQ(3, cache.getMissCount());
+}
+
+TEST_F(TestPersistentContentCache, ChildSelector)
+{
+  CaptureFace face;
+  PersistentContentCache cache(&face, directory_);
+  cache.setInterestFilter(Name("/A"));
+
+  cache.add(makeData(Name("/A/B/2")));
+  cache.add(makeData(Name("/A/B/1")));
+  cache.add(makeData(Name("/A/B/3")));
+  cache.add(makeData(Name("/A/C/1")));
+
+  ASSERT_EQ(Name("/A/B/1"), face.receive(Interest(Name("/A/B")))) <<
+    "Without a ChildSelector, should return the leftmost match";
+  ASSERT_EQ(Name("/A/B/1"), face.receive(Interest(Name()))) <<
+    "Without a ChildSelector, should return the leftmost match";
+  ASSERT_EQ(Name("/A/C/1"),
+            face.receive(Interest(Name()).setChildSelector(1)));
+  ASSERT_EQ(Name("/A/B/1"),
+            face.receive(Interest(Name("/A/B")).setChildSelector(0)));
+  ASSERT_EQ(Name("/A/B/3"),
+            face.receive(Interest(Name("/A/B")).setChildSelector(1)));
+}
+
+TEST_F(TestPersistentContentCache, ImplicitDigest)
+{
+  CaptureFace face;
+  PersistentContentCache cache(&face, directory_);
+  cache.setInterestFilter(Name("/A"));
+
+  Data data1 = makeData(Name("/A/B"), -1, "one");
+  Data data2 = makeData(Name("/A/B"), -1, "two");
+  cache.add(data1);
+  cache.add(data2);
+
+  ASSERT_EQ(Name("/A/B"), face.receive(Interest(*data1.getFullName())));
+  ASSERT_EQ("one", face.sentData_[0]->getContent().toRawStr());
+  ASSERT_EQ(Name("/A/B"), face.receive(Interest(*data2.getFullName())));
+  ASSERT_EQ(*data2.getFullName(), *face.sentData_[0]->getFullName());
+
+  Name wrongDigest(data1.getName());
+  uint8_t digest[ndn_SHA256_DIGEST_SIZE];
+  memset(digest, 0, sizeof(digest));
+  wrongDigest.appendImplicitSha256Digest(digest, sizeof(digest));
+  ASSERT_EQ(Name(), face.receive(Interest(wrongDigest)));
+
+  ASSERT_EQ(Name("/A/B"), face.receive(Interest(Name("/A/B"))));
+  ASSERT_EQ(*data2.getFullName(), *face.sentData_[0]->getFullName()) <<
+    "Should reply with the Data packet added last";
+}
+
+TEST_F(TestPersistentContentCache, Reopen)
+{
+  int nPackets = 5000;
+  {
+    // Use a small segment size to use more than one segment file.
+    CaptureFace face;
+    PersistentContentCache cache(&face, directory_, 64 * 1024);
+    for (int i = 0; i < nPackets; ++i)
+      cache.add(makeData(Name("/A").appendSequenceNumber(i), -1, makeContent(i)));
+  }
+
+  CaptureFace face;
+  PersistentContentCache cache(&face, directory_);
+  cache.setInterestFilter(Name("/A"));
+  ASSERT_EQ(nPackets, cache.size());
+  for (int i = 0; i < nPackets; ++i) {
+    Name name = Name("/A").appendSequenceNumber(i);
+    ASSERT_EQ(name, face.receive(Interest(name)));
+    ASSERT_EQ(makeContent(i), face.sentData_[0]->getContent().toRawStr());
+  }
+
+  // Add more after opening again.
+  cache.add(makeData(Name("/A/B")));
+  ASSERT_EQ(Name("/A/B"), face.receive(Interest(Name("/A/B"))));
+  ASSERT_EQ(nPackets + 1, cache.size());
+}
+
+TEST_F(TestPersistentContentCache, ProcessCrash)
+{
+  pid_t child = fork();
+  ASSERT_TRUE(child >= 0);
+  if (child == 0) {
+    // In the child, add packets until the parent kills the process.
+    MappedContentStore store(directory_, 64 * 1024);
+    for (int i = 0; ; ++i)
+      store.add
+        (makeData(Name("/A").appendSequenceNumber(i), -1, makeContent(i)), 0);
+  }
+
+  usleep(200000);
+  kill(child, SIGKILL);
+  waitpid(child, 0, 0);
+
+  // Every committed record should be complete.
+  MappedContentStore store(directory_, 64 * 1024);
+  ASSERT_TRUE(store.size() > 0);
+  for (size_t i = 0; i < store.size(); ++i) {
+    Name name = Name("/A").appendSequenceNumber(i);
+    size_t encodingLength;
+    const uint8_t* encoding = store.find(Interest(name), 0, encodingLength);
+    ASSERT_TRUE(encoding != 0);
+    Data data;
+    data.wireDecode(encoding, encodingLength);
+    ASSERT_EQ(name, data.getName());
+    ASSERT_EQ(makeContent(i), data.getContent().toRawStr());
+  }
+
+  // The store can still add.
+  store.add(makeData(Name("/B")), 0);
+  size_t encodingLength;
+  ASSERT_TRUE(store.find(Interest(Name("/B")), 0, encodingLength) != 0);
+}
+
+TEST_F(TestPersistentContentCache, LostWrite)
+{
+  pid_t child = fork();
+  ASSERT_TRUE(child >= 0);
+  if (child == 0) {
+    // In the child, flush 10 packets then add 10 more and exit without the
+    // destructor, so that the last 10 are not durable.
+    MappedContentStore* store = new MappedContentStore(directory_, 64 * 1024);
+    for (int i = 0; i < 20; ++i) {
+      if (i == 10)
+        store->flush();
+      store->add
+        (makeData(Name("/A").appendSequenceNumber(i), -1, makeContent(i)), 0);
+    }
+    _exit(0);
+  }
+  waitpid(child, 0, 0);
+
+  // Simulate a page of packet 15 which was not written before a system crash.
+  ASSERT_TRUE(corruptFile(directory_ + "/log-000000", makeContent(15)));
+
+  MappedContentStore store(directory_, 64 * 1024);
+  ASSERT_EQ(15, store.size()) <<
+    "Should drop the records from the first bad one";
+  ASSERT_EQ(5, store.getRecoveredDropCount());
+  ASSERT_EQ(1, store.getRecoveredRebuildCount());
+  size_t encodingLength;
+  ASSERT_TRUE(store.find
+    (Interest(Name("/A").appendSequenceNumber(14)), 0, encodingLength) != 0);
+  ASSERT_TRUE(store.find
+    (Interest(Name("/A").appendSequenceNumber(15)), 0, encodingLength) == 0);
+
+  // The next add should overwrite the dropped records.
+  store.add(makeData(Name("/A").appendSequenceNumber(15), -1, "new"), 0);
+  ASSERT_EQ(16, store.size());
+  ASSERT_TRUE(store.find
+    (Interest(Name("/A").appendSequenceNumber(15)), 0, encodingLength) != 0);
+}
+
+TEST_F(TestPersistentContentCache, BadUndurableSegment)
+{
+  pid_t child = fork();
+  ASSERT_TRUE(child >= 0);
+  if (child == 0) {
+    // In the child, flush 10 packets then add 10 more and exit without the
+    // destructor, so that the last 10 are not durable.
+    MappedContentStore* store = new MappedContentStore(directory_, 64 * 1024);
+    for (int i = 0; i < 20; ++i) {
+      if (i == 10)
+        store->flush();
+      store->add
+        (makeData(Name("/A").appendSequenceNumber(i), -1, makeContent(i)), 0);
+    }
+    _exit(0);
+  }
+  waitpid(child, 0, 0);
+
+  // Simulate a record which was not written before a system crash, with a
+  // garbage segment number. Each record starts with the 32-bit segment number.
+  {
+    fstream file((directory_ + "/index-records").c_str(),
+                 ios::in | ios::out | ios::binary);
+    string contents
+      ((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    // The record size is the file size divided by its initial capacity of
+    // 1024 records.
+    size_t recordSize = contents.size() / 1024;
+    uint32_t badSegment = 1000;
+    file.clear();
+    file.seekp(19 * recordSize);
+    file.write((const char*)&badSegment, sizeof(badSegment));
+  }
+
+  MappedContentStore store(directory_, 64 * 1024);
+  ASSERT_EQ(19, store.size()) << "Should drop the bad record";
+  ASSERT_EQ(1, store.getRecoveredDropCount());
+  ifstream badSegmentFile((directory_ + "/log-001000").c_str());
+  ASSERT_FALSE(badSegmentFile.good()) <<
+    "Should not map the segment of a record before validating it";
+}
+
+/**
+ * Count the segment files of the log in the directory.
+ */
+static int
+countSegmentFiles(const string& directoryPath)
+{
+  int count = 0;
+  DIR* directory = opendir(directoryPath.c_str());
+  struct dirent* entry;
+  while ((entry = readdir(directory)) != 0) {
+    if (string(entry->d_name).find("log-") == 0)
+      ++count;
+  }
+  closedir(directory);
+  return count;
+}
+
+TEST_F(TestPersistentContentCache, Compact)
+{
+  int nPackets = 2000;
+  {
+    // Use a small segment size to use more than one segment file. Add each
+    // name twice so that compact drops the first.
+    CaptureFace face;
+    PersistentContentCache cache(&face, directory_, 64 * 1024);
+    for (int i = 0; i < nPackets; ++i)
+      cache.add(makeData
+        (Name("/A").appendSequenceNumber(i), -1, string(100, 'x')));
+    for (int i = 0; i < nPackets; ++i)
+      cache.add(makeData(Name("/A").appendSequenceNumber(i), -1, makeContent(i)));
+    ASSERT_EQ(2 * nPackets, cache.size());
+    int nSegmentFiles = countSegmentFiles(directory_);
+
+    uint64_t contentBytes = cache.getContentBytes();
+    cache.compact();
+    ASSERT_EQ(nPackets, cache.size());
+    ASSERT_TRUE(cache.getContentBytes() < contentBytes);
+    ASSERT_TRUE(countSegmentFiles(directory_) < nSegmentFiles) <<
+      "compact should remove the unused segment files";
+  }
+
+  CaptureFace face;
+  PersistentContentCache cache(&face, directory_);
+  cache.setInterestFilter(Name("/A"));
+  ASSERT_EQ(nPackets, cache.size());
+  for (int i = 0; i < nPackets; ++i) {
+    Name name = Name("/A").appendSequenceNumber(i);
+    ASSERT_EQ(name, face.receive(Interest(name)));
+    ASSERT_EQ(makeContent(i), face.sentData_[0]->getContent().toRawStr());
+  }
+
+  // Limit the size to keep only the newest 10 packets.
+  uint64_t newestBytes = 0;
+  for (int i = nPackets - 10; i < nPackets; ++i)
+    newestBytes += makeData
+      (Name("/A").appendSequenceNumber(i), -1, makeContent(i)).wireEncode().size();
+  cache.compact(newestBytes);
+  ASSERT_EQ(10, cache.size());
+  ASSERT_EQ(Name(), face.receive(Interest(Name("/A").appendSequenceNumber(0))));
+  Name newest = Name("/A").appendSequenceNumber(nPackets - 1);
+  ASSERT_EQ(newest, face.receive(Interest(newest)));
+
+  // The cache can still add.
+  cache.add(makeData(Name("/A/B")));
+  ASSERT_EQ(Name("/A/B"), face.receive(Interest(Name("/A/B"))));
+}
+
+TEST_F(TestPersistentContentCache, InterruptedCompact)
+{
+  {
+    MappedContentStore store(directory_, 64 * 1024);
+    store.add(makeData(Name("/A/1"), -1, "old"), 0);
+    store.add(makeData(Name("/A/1"), -1, "new"), 0);
+  }
+
+  // Simulate a compaction which stopped before it committed.
+  string compactingDirectory = directory_ + "/compacting";
+  ASSERT_EQ(0, mkdir(compactingDirectory.c_str(), 0755));
+  {
+    MappedContentStore newStore(compactingDirectory, 64 * 1024);
+    newStore.add(makeData(Name("/B/1")), 0);
+  }
+
+  {
+    MappedContentStore store(directory_, 64 * 1024);
+    ASSERT_EQ(2, store.size()) << "Should keep the old store";
+    ASSERT_NE(0, access(compactingDirectory.c_str(), F_OK)) <<
+      "Should remove the uncommitted new store";
+  }
+
+  // Simulate a compaction which stopped after it committed and moved one file.
+  ASSERT_EQ(0, mkdir(compactingDirectory.c_str(), 0755));
+  {
+    MappedContentStore newStore(compactingDirectory, 64 * 1024);
+    newStore.add(makeData(Name("/A/1"), -1, "new"), 0);
+  }
+  FILE* compactedFile = fopen((compactingDirectory + "/compacted").c_str(), "w");
+  ASSERT_TRUE(compactedFile != 0);
+  fprintf(compactedFile, "1\n");
+  fclose(compactedFile);
+  ASSERT_EQ(0, rename((compactingDirectory + "/index-header").c_str(),
+                      (directory_ + "/index-header").c_str()));
+
+  MappedContentStore store(directory_, 64 * 1024);
+  ASSERT_EQ(1, store.size()) << "Should finish moving the new store";
+  ASSERT_NE(0, access(compactingDirectory.c_str(), F_OK));
+  size_t encodingLength;
+  const uint8_t* encoding = store.find
+    (Interest(Name("/A/1")), 0, encodingLength);
+  ASSERT_TRUE(encoding != 0);
+  Data data;
+  data.wireDecode(encoding, encodingLength);
+  ASSERT_EQ("new", data.getContent().toRawStr());
+}
+
+#endif // NDN_CPP_HAVE_UNISTD_H
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -21,6 +21,7 @@
  */
 
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <ndn-cpp/data.hpp>
 #include "../../src/sync/detail/psync-state.hpp"
 
@@ -65,6 +66,73 @@ TEST_F(TestPSyncState, EmptyContent)
   ASSERT_EQ(0, state2.getContent().size());
 }
 
+TEST_F(TestPSyncState, DeltaEncodeDecode)
+{
+  PSyncState state;
+  state.addContent(Name("/a/c"));
+  state.addContent(Name("/a/b"));
+
+  vector<Blob> blocks;
+  state.wireEncodeDelta(1000, blocks);
+  ASSERT_EQ(1, blocks.size());
+  uint8_t expectedEncoding[] = {
+    0x81, 0x13, // PSyncDeltaContent
+      0x82, 0x01, 0x00, // PSyncSharedComponents = 0
+      0x07, 0x06, 0x08, 0x01, 0x61, 0x08, 0x01, 0x62, // Name = "/a/b"
+      0x82, 0x01, 0x01, // PSyncSharedComponents = 1
+      0x07, 0x03, 0x08, 0x01, 0x63 // Name = "/c"
+  };
+  ASSERT_TRUE(blocks[0].equals(Blob(expectedEncoding, sizeof(expectedEncoding))));
+
+  PSyncState receivedState(blocks[0]);
+  ASSERT_EQ(2, receivedState.getContent().size());
+  ASSERT_EQ(Name("/a/b"), receivedState.getContent()[0]) <<
+    "The delta encoding should be in canonical order";
+  ASSERT_EQ(Name("/a/c"), receivedState.getContent()[1]);
+}
+
+TEST_F(TestPSyncState, DeltaEncodeBlocks)
+{
+  PSyncState state;
+  for (int i = 0; i < 1000; ++i)
+    state.addContent(Name("/ndn/test/user").append("session").appendSequenceNumber(i));
+
+  const size_t maxBlockSize = 200;
+  vector<Blob> blocks;
+  state.wireEncodeDelta(maxBlockSize, blocks);
+  ASSERT_TRUE(blocks.size() > 1);
+
+  // Simulate the SegmentFetcher which concatenates the segments.
+  vector<uint8_t> content;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    ASSERT_TRUE(blocks[i].size() <= maxBlockSize);
+    content.insert(content.end(), blocks[i].buf(), blocks[i].buf() + blocks[i].size());
+  }
+  ASSERT_TRUE(content.size() < state.wireEncode().size() / 2) <<
+    "The delta encoding should be smaller than the full Names";
+
+  PSyncState receivedState(&content[0], content.size());
+  vector<Name> expected(state.getContent());
+  sort(expected.begin(), expected.end());
+  ASSERT_TRUE(expected == receivedState.getContent());
+
+  PSyncState emptyState;
+  blocks.clear();
+  emptyState.wireEncodeDelta(maxBlockSize, blocks);
+  ASSERT_EQ(1, blocks.size());
+  ASSERT_EQ(0, PSyncState(blocks[0]).getContent().size());
+}
+
+TEST_F(TestPSyncState, DeltaDecodeError)
+{
+  uint8_t encoding[] = {
+    0x81, 0x08, // PSyncDeltaContent
+      0x82, 0x01, 0x01, // PSyncSharedComponents = 1 with no previous Name
+      0x07, 0x03, 0x08, 0x01, 0x63 // Name = "/c"
+  };
+  ASSERT_THROW(PSyncState(encoding, sizeof(encoding)), runtime_error);
+}
+
 int
 main(int argc, char **argv)
 {
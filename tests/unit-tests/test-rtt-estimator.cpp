@@ -0,0 +1,238 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <ndn-cpp/face.hpp>
+#include "capture-transport.hpp"
+#include "../../src/impl/rtt-estimator-table.hpp"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+static void
+onData
+  (const ptr_lib::shared_ptr<const Interest>& interest,
+   const ptr_lib::shared_ptr<Data>& data, int* nData)
+{
+  ++(*nData);
+}
+
+static void
+onTimeout(const ptr_lib::shared_ptr<const Interest>& interest, int* nTimeouts)
+{
+  ++(*nTimeouts);
+}
+
+class TestRttEstimator : public ::testing::Test {
+public:
+  TestRttEstimator()
+  : transport_(new CaptureTransport()),
+    face_(transport_, ptr_lib::make_shared<Transport::ConnectionInfo>()),
+    nData_(0), nTimeouts_(0)
+  {
+  }
+
+  void
+  expressInterest(const Name& name)
+  {
+    Interest interest(name);
+    interest.setCanBePrefix(false);
+    face_.expressInterest
+      (interest, bind(&onData, _1, _2, &nData_),
+       bind(&onTimeout, _1, &nTimeouts_));
+  }
+
+  ptr_lib::shared_ptr<CaptureTransport> transport_;
+  Face face_;
+  int nData_;
+  int nTimeouts_;
+};
+
+TEST_F(TestRttEstimator, Estimator)
+{
+  RttEstimator estimator(1000.0, 200.0, 60000.0);
+  ASSERT_EQ(1000.0, estimator.getRto());
+  ASSERT_EQ(-1.0, estimator.getSmoothedRtt());
+  ASSERT_EQ(0, estimator.getSampleCount());
+
+  estimator.addMeasurement(100.0);
+  ASSERT_EQ(100.0, estimator.getSmoothedRtt());
+  ASSERT_EQ(50.0, estimator.getRttVariation());
+  ASSERT_EQ(300.0, estimator.getRto()) << "The RTO should be SRTT + 4 * RTTVAR";
+
+  estimator.addMeasurement(100.0);
+  ASSERT_EQ(100.0, estimator.getSmoothedRtt());
+  ASSERT_EQ(37.5, estimator.getRttVariation());
+  ASSERT_EQ(250.0, estimator.getRto());
+
+  estimator.backoffRto();
+  ASSERT_EQ(500.0, estimator.getRto());
+
+  RttEstimator fastEstimator(1000.0, 200.0, 60000.0);
+  fastEstimator.addMeasurement(10.0);
+  ASSERT_EQ(200.0, fastEstimator.getRto()) << "The RTO should be at least minRto";
+}
+
+TEST_F(TestRttEstimator, Table)
+{
+  RttEstimatorTable table(2);
+  ASSERT_TRUE(table.find(Name("/a/b/0")) == 0);
+
+  table.addMeasurement(Name("/a/b/0"), 100.0, 1000);
+  ASSERT_EQ(1, table.size());
+  const RttEstimator* estimator = table.find(Name("/a/b/1"));
+  ASSERT_TRUE(estimator != 0) << "Should find the prefix without the final component";
+  ASSERT_EQ(100.0, estimator->getSmoothedRtt());
+  ASSERT_TRUE(table.find(Name("/a/b/c/0")) == estimator) <<
+    "Should find the longest matching prefix";
+  ASSERT_TRUE(table.find(Name("/a/0")) == 0);
+
+  table.backoffRto(Name("/a/b/2"));
+  ASSERT_EQ(600.0, table.find(Name("/a/b/0"))->getRto());
+
+  table.addMeasurement(Name("/c/0"), 50.0, 2000);
+  table.addMeasurement(Name("/a/b/3"), 100.0, 3000);
+  table.addMeasurement(Name("/d/0"), 50.0, 4000);
+  ASSERT_EQ(2, table.size()) << "The table should not exceed maxPrefixes";
+  ASSERT_TRUE(table.find(Name("/c/0")) == 0) <<
+    "Should remove the least recently updated prefix";
+  ASSERT_TRUE(table.find(Name("/a/b/0")) != 0);
+  ASSERT_TRUE(table.find(Name("/d/0")) != 0);
+
+  map<Name, RttEstimator> estimators;
+  table.getEstimators(estimators);
+  ASSERT_EQ(2, estimators.size());
+  ASSERT_EQ(2, estimators[Name("/a/b")].getSampleCount());
+}
+
+#if NDN_CPP_HAVE_UNISTD_H
+
+TEST_F(TestRttEstimator, Disabled)
+{
+  expressInterest(Name("/test/rtt/0"));
+  transport_->receiveData(Name("/test/rtt/0"));
+  ASSERT_EQ(1, nData_);
+
+  map<Name, RttEstimator> estimates;
+  face_.getRttEstimates(estimates);
+  ASSERT_EQ(0, estimates.size()) << "RTT estimation should be disabled by default";
+}
+
+TEST_F(TestRttEstimator, Estimation)
+{
+  face_.setRttEstimationEnabled(true);
+
+  for (int i = 0; i < 3; ++i) {
+    expressInterest(Name("/test/rtt").appendSegment(i));
+    usleep(20000);
+    transport_->receiveData(Name("/test/rtt").appendSegment(i));
+  }
+  ASSERT_EQ(3, nData_);
+
+  RttEstimator estimate;
+  ASSERT_TRUE(face_.getRttEstimate
+    (Name("/test/rtt").appendSegment(10), estimate));
+  ASSERT_EQ(3, estimate.getSampleCount());
+  ASSERT_GE(estimate.getSmoothedRtt(), 20.0);
+  ASSERT_LT(estimate.getSmoothedRtt(), 1000.0);
+  ASSERT_FALSE(face_.getRttEstimate(Name("/other/0"), estimate));
+
+  map<Name, RttEstimator> estimates;
+  face_.getRttEstimates(estimates);
+  ASSERT_EQ(1, estimates.size());
+  ASSERT_TRUE(estimates.find(Name("/test/rtt")) != estimates.end());
+
+  // Without the adaptive lifetime, the Interest lifetime is not changed.
+  expressInterest(Name("/test/rtt").appendSegment(3));
+  ASSERT_TRUE(transport_->getLastSentInterest()->getInterestLifetimeMilliseconds() < 0);
+}
+
+TEST_F(TestRttEstimator, ExplicitLifetimeNotSampled)
+{
+  face_.setRttEstimationEnabled(true);
+
+  // A long-lived Interest, such as a sync Interest, with a lifetime from the
+  // application.
+  Interest interest(Name("/test/sync").appendSegment(0));
+  interest.setCanBePrefix(false);
+  interest.setInterestLifetimeMilliseconds(60000);
+  face_.expressInterest(interest, bind(&onData, _1, _2, &nData_));
+  usleep(20000);
+  transport_->receiveData(Name("/test/sync").appendSegment(0));
+  ASSERT_EQ(1, nData_);
+
+  RttEstimator estimate;
+  ASSERT_FALSE(face_.getRttEstimate(Name("/test/sync/x"), estimate)) <<
+    "An Interest with a lifetime from the application should not be sampled";
+}
+
+TEST_F(TestRttEstimator, AdaptiveLifetime)
+{
+  face_.setAdaptiveInterestLifetimeEnabled(true);
+
+  expressInterest(Name("/test/rtt").appendSegment(0));
+  ASSERT_TRUE(transport_->getLastSentInterest()->getInterestLifetimeMilliseconds() < 0) <<
+    "Without an estimate, the Interest should use the default lifetime";
+  usleep(20000);
+  transport_->receiveData(Name("/test/rtt").appendSegment(0));
+
+  RttEstimator estimate;
+  ASSERT_TRUE(face_.getRttEstimate(Name("/test/rtt/x"), estimate)) <<
+    "The adaptive lifetime should enable RTT estimation";
+  Milliseconds rto = estimate.getRto();
+
+  expressInterest(Name("/test/rtt").appendSegment(1));
+  ptr_lib::shared_ptr<Interest> sentInterest = transport_->getLastSentInterest();
+  ASSERT_EQ(rto, sentInterest->getInterestLifetimeMilliseconds()) <<
+    "The Interest lifetime should be the RTO";
+  ASSERT_TRUE(sentInterest->getNonce().size() > 0);
+
+  Interest fixedLifetime(Name("/test/rtt").appendSegment(2));
+  fixedLifetime.setCanBePrefix(false);
+  fixedLifetime.setInterestLifetimeMilliseconds(3000);
+  face_.expressInterest(fixedLifetime, bind(&onData, _1, _2, &nData_));
+  ASSERT_EQ(3000, transport_->getLastSentInterest()->getInterestLifetimeMilliseconds()) <<
+    "An Interest with a lifetime should not be changed";
+
+  // Wait for segment 1 to time out.
+  for (int i = 0; i < 100 && nTimeouts_ == 0; ++i) {
+    face_.processEvents();
+    usleep(10000);
+  }
+  ASSERT_EQ(1, nTimeouts_);
+  ASSERT_TRUE(face_.getRttEstimate(Name("/test/rtt/x"), estimate));
+  ASSERT_EQ(2 * rto, estimate.getRto()) <<
+    "A timeout should back off the RTO";
+}
+
+#endif // NDN_CPP_HAVE_UNISTD_H
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,475 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#include <map>
+#include <set>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#if NDN_CPP_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include "../../src/c/util/time.h"
+#include "../../src/c/lp/lp-packet.h"
+#include "../../src/lp/lp-packet.hpp"
+#include "../../src/impl/delayed-call-table.hpp"
+#include <ndn-cpp/util/segment-fetcher.hpp>
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+#if NDN_CPP_HAVE_UNISTD_H
+
+/**
+ * DelayFace extends Face to reply to each Interest for a segment of the test
+ * content after a delay, using its own DelayedCallTable. It can drop, Nack or
+ * congestion mark the first Interest for chosen segments, and counts the
+ * maximum number of Interests in flight.
+ */
+class DelayFace : public Face
+{
+public:
+  DelayFace(const Name& versionedPrefix, int nSegments, Milliseconds delay)
+  : Face("localhost"), delay_(delay), dropFirstInterest_(false),
+    maxInFlight_(0), nInterests_(0), nDelivered_(0), maxAheadOfDelivered_(0),
+    lastPendingInterestId_(0), nInFlight_(0)
+  {
+    for (int i = 0; i < nSegments; ++i) {
+      ptr_lib::shared_ptr<Data> data(new Data
+        (Name(versionedPrefix).appendSegment(i)));
+      ostringstream content;
+      content << "segment " << i << ", ";
+      data->setContent(Blob::fromRawStr(content.str()));
+      data->getMetaInfo().setFinalBlockId
+        (Name::Component::fromSegment(nSegments - 1));
+      segments_.push_back(data);
+      expectedContent_ += content.str();
+    }
+  }
+
+  virtual uint64_t
+  expressInterest
+    (const Interest& interest, const OnData& onData,
+     const OnTimeout& onTimeout, const OnNetworkNack& onNetworkNack,
+     WireFormat& wireFormat = *WireFormat::getDefaultWireFormat())
+  {
+    uint64_t pendingInterestId = ++lastPendingInterestId_;
+    ptr_lib::shared_ptr<const Interest> interestCopy(new Interest(interest));
+    ++nInterests_;
+    ++nInFlight_;
+    maxInFlight_ = max(maxInFlight_, nInFlight_);
+
+    if (dropFirstInterest_ && nInterests_ == 1) {
+      delayedCallTable_.callLater
+        (interest.getInterestLifetimeMilliseconds(),
+         bind(&DelayFace::timeOut, this, pendingInterestId, interestCopy,
+              onTimeout));
+      return pendingInterestId;
+    }
+
+    uint64_t segment = 0;
+    if (interest.getChildSelector() != 1)
+      segment = interest.getName().get(-1).toSegment();
+    maxAheadOfDelivered_ = max(maxAheadOfDelivered_, (int)segment - nDelivered_);
+    bool isFirstForSegment = (requestedSegments_.count(segment) == 0);
+    requestedSegments_.insert(segment);
+
+    if (isFirstForSegment && dropSegments_.count(segment) > 0)
+      // Drop the Interest without a reply.
+      return pendingInterestId;
+    // Use a different delay for each segment so that they arrive out of order.
+    Milliseconds delay = delay_ + (segment * 7) % (int)(delay_ / 2 + 1);
+
+    if (isFirstForSegment && nackSegments_.count(segment) > 0) {
+      ptr_lib::shared_ptr<NetworkNack> networkNack(new NetworkNack());
+      networkNack->setReason(nackSegments_[segment]);
+      delayedCallTable_.callLater
+        (delay, bind(&DelayFace::nack, this, pendingInterestId, interestCopy,
+                     networkNack, onNetworkNack));
+      return pendingInterestId;
+    }
+
+    ptr_lib::shared_ptr<Data> data(new Data(*segments_[segment]));
+    if (isFirstForSegment && markSegments_.count(segment) > 0)
+      setCongestionMark(*data);
+    delayedCallTable_.callLater
+      (delay, bind(&DelayFace::reply, this, pendingInterestId, interestCopy,
+                   data, onData));
+    return pendingInterestId;
+  }
+
+  virtual void
+  removePendingInterest(uint64_t pendingInterestId)
+  {
+    if (pendingInterestId != 0 && finished_.count(pendingInterestId) == 0) {
+      finished_.insert(pendingInterestId);
+      --nInFlight_;
+    }
+  }
+
+  virtual void
+  callLater(Milliseconds delayMilliseconds, const Face::Callback& callback)
+  {
+    delayedCallTable_.callLater(delayMilliseconds, callback);
+  }
+
+  virtual void
+  processEvents()
+  {
+    delayedCallTable_.callTimedOut();
+  }
+
+  vector<ptr_lib::shared_ptr<Data> > segments_;
+  string expectedContent_;
+  Milliseconds delay_;
+  set<uint64_t> dropSegments_;
+  map<uint64_t, ndn_NetworkNackReason> nackSegments_;
+  set<uint64_t> markSegments_;
+  bool dropFirstInterest_;
+  int maxInFlight_;
+  int nInterests_;
+  // The test updates nDelivered_ when streaming.
+  int nDelivered_;
+  int maxAheadOfDelivered_;
+
+private:
+  static void
+  setCongestionMark(Data& data)
+  {
+    struct ndn_LpPacketHeaderField headerFields[1];
+    struct ndn_LpPacket lpPacketStruct;
+    ndn_LpPacket_initialize(&lpPacketStruct, headerFields, 1);
+    struct ndn_LpPacketHeaderField* headerField;
+    ndn_LpPacket_addEmptyHeaderField(&lpPacketStruct, &headerField);
+    headerField->type = ndn_LpPacketHeaderFieldType_CONGESTION_MARK;
+    headerField->congestionMark.congestionMark = 1;
+
+    ptr_lib::shared_ptr<LpPacket> lpPacket(new LpPacket());
+    lpPacket->set(LpPacketLite::downCast(lpPacketStruct));
+    data.setLpPacket(lpPacket);
+  }
+
+  void
+  reply
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<Data>& data, const OnData& onData)
+  {
+    if (finished_.count(pendingInterestId) > 0)
+      return;
+    removePendingInterest(pendingInterestId);
+    onData(interest, data);
+  }
+
+  void
+  nack
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<NetworkNack>& networkNack,
+     const OnNetworkNack& onNetworkNack)
+  {
+    if (finished_.count(pendingInterestId) > 0)
+      return;
+    removePendingInterest(pendingInterestId);
+    onNetworkNack(interest, networkNack);
+  }
+
+  void
+  timeOut
+    (uint64_t pendingInterestId,
+     const ptr_lib::shared_ptr<const Interest>& interest,
+     const OnTimeout& onTimeout)
+  {
+    if (finished_.count(pendingInterestId) > 0)
+      return;
+    removePendingInterest(pendingInterestId);
+    onTimeout(interest);
+  }
+
+  DelayedCallTable delayedCallTable_;
+  uint64_t lastPendingInterestId_;
+  int nInFlight_;
+  set<uint64_t> requestedSegments_;
+  set<uint64_t> finished_;
+};
+
+class FetchResult {
+public:
+  FetchResult()
+  : isFinished_(false), errorCode_((SegmentFetcher::ErrorCode)0)
+  {
+  }
+
+  void
+  onComplete(const Blob& content)
+  {
+    isFinished_ = true;
+    content_ = content;
+  }
+
+  void
+  onError(SegmentFetcher::ErrorCode errorCode, const string& message)
+  {
+    isFinished_ = true;
+    errorCode_ = errorCode;
+    message_ = message;
+  }
+
+  bool isFinished_;
+  Blob content_;
+  SegmentFetcher::ErrorCode errorCode_;
+  string message_;
+};
+
+class StreamResult {
+public:
+  StreamResult(DelayFace& face)
+  : face_(face)
+  {
+  }
+
+  void
+  onSegment(uint64_t segment, const Blob& content)
+  {
+    segments_.push_back(segment);
+    content_ += content.toRawStr();
+    ++face_.nDelivered_;
+  }
+
+  DelayFace& face_;
+  vector<uint64_t> segments_;
+  string content_;
+};
+
+static void
+throwError(uint64_t segment, const Blob& content)
+{
+  throw runtime_error("Test error");
+}
+
+class TestSegmentFetcher : public ::testing::Test {
+public:
+  TestSegmentFetcher()
+  : versionedPrefix_(Name("/test/content").appendVersion(1))
+  {
+  }
+
+  /**
+   * Fetch /test/content from the face and process events until finished.
+   */
+  void
+  fetch
+    (DelayFace& face, FetchResult& result,
+     const SegmentFetcher::Options& options = SegmentFetcher::Options(),
+     Milliseconds interestLifetime = 4000)
+  {
+    Interest interest(Name("/test/content"));
+    interest.setCanBePrefix(true);
+    interest.setInterestLifetimeMilliseconds(interestLifetime);
+
+    MillisecondsSince1970 startTime = ndn_getNowMilliseconds();
+    SegmentFetcher::fetch
+      (face, interest, SegmentFetcher::DontVerifySegment,
+       bind(&FetchResult::onComplete, &result, _1),
+       bind(&FetchResult::onError, &result, _1, _2), options);
+    while (!result.isFinished_ &&
+           ndn_getNowMilliseconds() - startTime < 10000) {
+      face.processEvents();
+      usleep(1000);
+    }
+  }
+
+  Name versionedPrefix_;
+};
+
+TEST_F(TestSegmentFetcher, Pipelined)
+{
+  const int nSegments = 60;
+  const Milliseconds delay = 20;
+
+  DelayFace face(versionedPrefix_, nSegments, delay);
+  FetchResult result;
+  fetch(face, result);
+
+  ASSERT_TRUE(result.isFinished_);
+  ASSERT_EQ("", result.message_);
+  ASSERT_EQ(face.expectedContent_, result.content_.toRawStr()) <<
+    "The segments should be assembled in order";
+  ASSERT_EQ(nSegments, face.nInterests_) <<
+    "Each segment should be requested once";
+  // In slow start, the window grows by one for each received segment, so about
+  // half of the segments are in flight at once.
+  ASSERT_TRUE(face.maxInFlight_ >= nSegments / 4) <<
+    "The Interests should be pipelined, but the most in flight was " <<
+    face.maxInFlight_;
+}
+
+TEST_F(TestSegmentFetcher, ConstantWindow)
+{
+  const int nSegments = 10;
+
+  DelayFace face(versionedPrefix_, nSegments, 5);
+  FetchResult result;
+  fetch(face, result, SegmentFetcher::Options()
+        .setInitialWindowSize(1).setMaxWindowSize(1));
+
+  ASSERT_EQ(face.expectedContent_, result.content_.toRawStr());
+  ASSERT_EQ(1, face.maxInFlight_) <<
+    "A window of 1 should send one Interest at a time";
+}
+
+TEST_F(TestSegmentFetcher, RetransmitLostInterest)
+{
+  const int nSegments = 30;
+
+  DelayFace face(versionedPrefix_, nSegments, 10);
+  face.dropSegments_.insert(5);
+  face.dropSegments_.insert(20);
+  FetchResult result;
+  fetch(face, result);
+
+  ASSERT_EQ("", result.message_);
+  ASSERT_EQ(face.expectedContent_, result.content_.toRawStr());
+  ASSERT_EQ(nSegments + 2, face.nInterests_) <<
+    "Each dropped segment should be retransmitted once";
+}
+
+TEST_F(TestSegmentFetcher, RetransmitAfterNack)
+{
+  const int nSegments = 30;
+
+  DelayFace face(versionedPrefix_, nSegments, 10);
+  face.nackSegments_[3] = ndn_NetworkNackReason_DUPLICATE;
+  face.nackSegments_[12] = ndn_NetworkNackReason_CONGESTION;
+  FetchResult result;
+  fetch(face, result);
+
+  ASSERT_EQ("", result.message_);
+  ASSERT_EQ(face.expectedContent_, result.content_.toRawStr());
+  ASSERT_EQ(nSegments + 2, face.nInterests_);
+}
+
+TEST_F(TestSegmentFetcher, NoRouteNack)
+{
+  DelayFace face(versionedPrefix_, 30, 10);
+  face.nackSegments_[7] = ndn_NetworkNackReason_NO_ROUTE;
+  FetchResult result;
+  fetch(face, result);
+
+  ASSERT_TRUE(result.isFinished_);
+  ASSERT_EQ(SegmentFetcher::NACK_ERROR, result.errorCode_);
+}
+
+TEST_F(TestSegmentFetcher, CongestionMark)
+{
+  const int nSegments = 60;
+
+  DelayFace face(versionedPrefix_, nSegments, 10);
+  for (uint64_t segment = 10; segment < 20; ++segment)
+    face.markSegments_.insert(segment);
+  FetchResult result;
+  fetch(face, result);
+
+  ASSERT_EQ("", result.message_);
+  ASSERT_EQ(face.expectedContent_, result.content_.toRawStr());
+  ASSERT_EQ(nSegments, face.nInterests_) <<
+    "A congestion mark should not cause a retransmission";
+}
+
+TEST_F(TestSegmentFetcher, FirstInterestTimeout)
+{
+  DelayFace face(versionedPrefix_, 10, 10);
+  face.dropFirstInterest_ = true;
+  FetchResult result;
+  fetch(face, result, SegmentFetcher::Options(), 50);
+
+  ASSERT_TRUE(result.isFinished_);
+  ASSERT_EQ(SegmentFetcher::INTEREST_TIMEOUT, result.errorCode_);
+  ASSERT_EQ(1, face.nInterests_) <<
+    "The first Interest should not be retransmitted";
+}
+
+TEST_F(TestSegmentFetcher, Streaming)
+{
+  const int nSegments = 60;
+  const int maxWindowSize = 8;
+
+  DelayFace face(versionedPrefix_, nSegments, 10);
+  face.dropSegments_.insert(5);
+  face.dropSegments_.insert(30);
+  StreamResult stream(face);
+  FetchResult result;
+  fetch(face, result, SegmentFetcher::Options()
+        .setMaxWindowSize(maxWindowSize)
+        .setOnSegment(bind(&StreamResult::onSegment, &stream, _1, _2)));
+
+  ASSERT_EQ("", result.message_);
+  ASSERT_TRUE(result.content_.isNull()) <<
+    "onComplete should not get the content when streaming";
+  ASSERT_EQ(nSegments, (int)stream.segments_.size());
+  for (int i = 0; i < nSegments; ++i)
+    ASSERT_EQ(i, (int)stream.segments_[i]) <<
+      "The segments should be delivered in order";
+  ASSERT_EQ(face.expectedContent_, stream.content_);
+  ASSERT_TRUE(face.maxAheadOfDelivered_ < maxWindowSize) <<
+    "The reorder buffer should be bounded by the window";
+}
+
+TEST_F(TestSegmentFetcher, FileDescriptorSink)
+{
+  char filePath[] = "/tmp/test-segment-fetcher-XXXXXX";
+  int fileDescriptor = mkstemp(filePath);
+  ASSERT_TRUE(fileDescriptor >= 0);
+
+  DelayFace face(versionedPrefix_, 20, 5);
+  FetchResult result;
+  fetch(face, result, SegmentFetcher::Options().setOnSegment
+        (SegmentFetcher::makeFileDescriptorSink(fileDescriptor)));
+  close(fileDescriptor);
+
+  ASSERT_EQ("", result.message_);
+  ifstream file(filePath);
+  stringstream fileContent;
+  fileContent << file.rdbuf();
+  unlink(filePath);
+  ASSERT_EQ(face.expectedContent_, fileContent.str());
+}
+
+TEST_F(TestSegmentFetcher, OnSegmentError)
+{
+  DelayFace face(versionedPrefix_, 20, 5);
+  FetchResult result;
+  fetch(face, result, SegmentFetcher::Options().setOnSegment(&throwError));
+
+  ASSERT_TRUE(result.isFinished_);
+  ASSERT_EQ(SegmentFetcher::ON_SEGMENT_ERROR, result.errorCode_);
+}
+
+#endif // NDN_CPP_HAVE_UNISTD_H
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,251 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <ndn-cpp/security/verification-helpers.hpp>
+#include <ndn-cpp/security/key-params.hpp>
+#include <ndn-cpp/util/segmenter.hpp>
+
+using namespace std;
+using namespace ndn;
+
+/**
+ * CaptureFace extends Face to capture the onInterest callback from
+ * setInterestFilter and to decode each packet sent instead of sending it.
+ */
+class CaptureFace : public Face {
+public:
+  CaptureFace()
+  : Face("localhost")
+  {
+  }
+
+  virtual uint64_t
+  setInterestFilter(const Name& prefix, const OnInterestCallback& onInterest)
+  {
+    prefix_ = ptr_lib::make_shared<Name>(prefix);
+    onInterest_ = onInterest;
+    return 0;
+  }
+
+  virtual void
+  send(const uint8_t *encoding, size_t encodingLength)
+  {
+    ptr_lib::shared_ptr<Data> data(new Data());
+    data->wireDecode(encoding, encodingLength);
+    sentData_.push_back(data);
+  }
+
+  /**
+   * Call the captured onInterest callback as if the Interest was received.
+   * @param interest The received Interest.
+   * @return The Data packet sent in reply, or null if no reply.
+   */
+  ptr_lib::shared_ptr<Data>
+  receive(const Interest& interest)
+  {
+    sentData_.clear();
+    onInterest_
+      (prefix_, ptr_lib::make_shared<Interest>(interest), *this, 0,
+       ptr_lib::shared_ptr<const InterestFilter>());
+
+    if (sentData_.size() == 0)
+      return ptr_lib::shared_ptr<Data>();
+    else
+      return sentData_[0];
+  }
+
+  ptr_lib::shared_ptr<const Name> prefix_;
+  vector<ptr_lib::shared_ptr<Data> > sentData_;
+
+private:
+  OnInterestCallback onInterest_;
+};
+
+static Blob
+makeContent(size_t size)
+{
+  ptr_lib::shared_ptr<vector<uint8_t> > content(new vector<uint8_t>(size));
+  for (size_t i = 0; i < size; ++i)
+    (*content)[i] = (uint8_t)(i * 7 + i / 256);
+  return Blob(content, false);
+}
+
+class TestSegmenter : public ::testing::Test {
+public:
+  TestSegmenter()
+  : keyChain_("pib-memory:", "tpm-memory:"),
+    versionedPrefix_(Name("/test/content").appendVersion(1))
+  {
+    Interest::setDefaultCanBePrefix(true);
+    identity_ = keyChain_.createIdentityV2(Name("/test"), EcKeyParams());
+  }
+
+  /**
+   * Check the names, FinalBlockId, content and signature of the segments.
+   */
+  void
+  checkSegments
+    (const vector<ptr_lib::shared_ptr<Data> >& segments, const Blob& content,
+     size_t maxSegmentSize)
+  {
+    size_t nSegments = content.size() == 0 ?
+      1 : (content.size() + maxSegmentSize - 1) / maxSegmentSize;
+    ASSERT_EQ(nSegments, segments.size());
+
+    string allContent;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const Data& data = *segments[i];
+      ASSERT_TRUE(data.getName().equals
+                  (Name(versionedPrefix_).appendSegment(i)));
+      ASSERT_EQ(nSegments - 1,
+                data.getMetaInfo().getFinalBlockId().toSegment());
+      ASSERT_TRUE(data.getContent().size() <= maxSegmentSize);
+      allContent += data.getContent().toRawStr();
+      ASSERT_TRUE(VerificationHelpers::verifyDataSignature
+        (data, *identity_->getDefaultKey()->getDefaultCertificate())) <<
+        "Segment " << i << " should have a valid signature";
+    }
+    ASSERT_EQ(content.toRawStr(), allContent);
+  }
+
+  KeyChain keyChain_;
+  Name versionedPrefix_;
+  ptr_lib::shared_ptr<PibIdentity> identity_;
+};
+
+TEST_F(TestSegmenter, Segment)
+{
+  Blob content = makeContent(10500);
+  for (size_t nThreads = 1; nThreads <= 4; nThreads *= 2) {
+    Segmenter segmenter(keyChain_, SigningInfo(identity_), nThreads);
+    vector<ptr_lib::shared_ptr<Data> > segments;
+    segmenter.segment(content, versionedPrefix_, 1000, 4000, segments);
+
+    checkSegments(segments, content, 1000);
+    ASSERT_EQ(4000, segments[5]->getMetaInfo().getFreshnessPeriod());
+  }
+}
+
+TEST_F(TestSegmenter, ReuseWorkerThreads)
+{
+  Segmenter segmenter(keyChain_, SigningInfo(identity_), 4);
+  for (size_t i = 0; i < 3; ++i) {
+    Blob content = makeContent(5000 + 1000 * i);
+    vector<ptr_lib::shared_ptr<Data> > segments;
+    segmenter.segment(content, versionedPrefix_, 1000, -1, segments);
+
+    checkSegments(segments, content, 1000);
+  }
+}
+
+TEST_F(TestSegmenter, EmptyContent)
+{
+  Segmenter segmenter(keyChain_, SigningInfo(identity_), 4);
+  vector<ptr_lib::shared_ptr<Data> > segments;
+  segmenter.segment(Blob(), versionedPrefix_, 1000, -1, segments);
+
+  checkSegments(segments, Blob(), 1000);
+  ASSERT_THROW
+    (segmenter.segment(makeContent(10), versionedPrefix_, 0, -1, segments),
+     runtime_error);
+}
+
+TEST_F(TestSegmenter, DigestSha256)
+{
+  Segmenter segmenter
+    (keyChain_, SigningInfo(SigningInfo::SIGNER_TYPE_SHA256), 4);
+  vector<ptr_lib::shared_ptr<Data> > segments;
+  segmenter.segment(makeContent(8000), versionedPrefix_, 1000, -1, segments);
+
+  ASSERT_EQ(8, segments.size());
+  for (size_t i = 0; i < segments.size(); ++i)
+    ASSERT_TRUE(VerificationHelpers::verifyDataDigest
+                (*segments[i], DIGEST_ALGORITHM_SHA256));
+}
+
+TEST_F(TestSegmenter, SegmentFile)
+{
+  Blob content = makeContent(5500);
+  char filePath[] = "/tmp/test-segmenter-XXXXXX";
+  int fileDescriptor = mkstemp(filePath);
+  ASSERT_TRUE(fileDescriptor >= 0);
+  FILE* file = fdopen(fileDescriptor, "wb");
+  fwrite(content.buf(), 1, content.size(), file);
+  fclose(file);
+
+  Segmenter segmenter(keyChain_, SigningInfo(identity_), 2);
+  vector<ptr_lib::shared_ptr<Data> > segments;
+  segmenter.segmentFile(filePath, versionedPrefix_, 1000, -1, segments);
+  remove(filePath);
+
+  checkSegments(segments, content, 1000);
+}
+
+TEST_F(TestSegmenter, AddToCache)
+{
+  Blob content = makeContent(3000);
+  CaptureFace face;
+  MemoryContentCache cache(&face);
+  cache.setInterestFilter(Name("/test/content"));
+
+  Segmenter segmenter(keyChain_, SigningInfo(identity_), 2);
+  ASSERT_EQ(3, segmenter.addToCache(content, versionedPrefix_, 1000, -1, cache));
+
+  ptr_lib::shared_ptr<Data> data = face.receive
+    (Interest(Name(versionedPrefix_).appendSegment(2)));
+  ASSERT_TRUE(!!data);
+  ASSERT_TRUE(data->getName().equals(Name(versionedPrefix_).appendSegment(2)));
+}
+
+TEST_F(TestSegmenter, ServeLazily)
+{
+  Blob content = makeContent(3500);
+  CaptureFace face;
+  Segmenter segmenter(keyChain_, SigningInfo(identity_));
+  segmenter.setInterestFilter(face, content, versionedPrefix_, 1000, 1000);
+  ASSERT_TRUE(face.prefix_->equals(Name("/test/content"))) <<
+    "The Interest filter should be for the name without the version";
+
+  // The first Interest from SegmentFetcher gets segment 0.
+  ptr_lib::shared_ptr<Data> data = face.receive(Interest(Name("/test/content")));
+  ASSERT_TRUE(!!data);
+  ASSERT_TRUE(data->getName().equals(Name(versionedPrefix_).appendSegment(0)));
+
+  vector<ptr_lib::shared_ptr<Data> > segments;
+  for (uint64_t segment = 0; segment < 4; ++segment) {
+    data = face.receive(Interest(Name(versionedPrefix_).appendSegment(segment)));
+    ASSERT_TRUE(!!data);
+    segments.push_back(data);
+  }
+  checkSegments(segments, content, 1000);
+
+  ASSERT_FALSE(face.receive(Interest(Name(versionedPrefix_).appendSegment(4)))) <<
+    "There should be no reply for a segment past the end";
+  ASSERT_FALSE(face.receive(Interest(Name("/test/other"))));
+}
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,245 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#include <set>
+#include <unistd.h>
+#include <pthread.h>
+#include <ndn-cpp/sharded-threadsafe-face.hpp>
+#include "capture-transport.hpp"
+
+using namespace std;
+using namespace ndn;
+using namespace ndn::func_lib;
+
+#ifdef NDN_CPP_HAVE_BOOST_ASIO
+
+/**
+ * ReceivedNames saves the name of each Interest whose onData is called, and the
+ * thread which called it. The callbacks may be called on the shard threads, so
+ * this is thread safe.
+ */
+class ReceivedNames {
+public:
+  ReceivedNames()
+  {
+    pthread_mutex_init(&mutex_, 0);
+  }
+
+  ~ReceivedNames()
+  {
+    pthread_mutex_destroy(&mutex_);
+  }
+
+  void
+  onData
+    (const ptr_lib::shared_ptr<const Interest>& interest,
+     const ptr_lib::shared_ptr<Data>& data)
+  {
+    pthread_mutex_lock(&mutex_);
+    names_.push_back(interest->getName());
+    threads_.push_back(pthread_self());
+    pthread_mutex_unlock(&mutex_);
+  }
+
+  vector<Name>
+  getNames()
+  {
+    pthread_mutex_lock(&mutex_);
+    vector<Name> result = names_;
+    pthread_mutex_unlock(&mutex_);
+    return result;
+  }
+
+  /**
+   * Get the number of onData calls which were on the given thread.
+   */
+  size_t
+  countCallsOnThread(pthread_t thread)
+  {
+    pthread_mutex_lock(&mutex_);
+    size_t count = 0;
+    for (size_t i = 0; i < threads_.size(); ++i) {
+      if (pthread_equal(threads_[i], thread))
+        ++count;
+    }
+    pthread_mutex_unlock(&mutex_);
+    return count;
+  }
+
+private:
+  vector<Name> names_;
+  vector<pthread_t> threads_;
+  pthread_mutex_t mutex_;
+};
+
+class TestShardedThreadsafeFace : public ::testing::Test {
+public:
+  TestShardedThreadsafeFace()
+  : transport_(new CaptureTransport()),
+    face_(ioService_, transport_,
+          ptr_lib::make_shared<Transport::ConnectionInfo>(), 4)
+  {
+  }
+
+  uint64_t
+  expressInterest(const Name& name)
+  {
+    Interest interest(name);
+    interest.setCanBePrefix(false);
+    interest.setInterestLifetimeMilliseconds(10000);
+    return face_.expressInterest
+      (interest, bind(&ReceivedNames::onData, &receivedNames_, _1, _2),
+       OnTimeout(), OnNetworkNack());
+  }
+
+  /**
+   * Run the handlers of ioService_ until the transport has sent nPackets, or
+   * until two seconds have passed.
+   */
+  void
+  pollUntilSent(size_t nPackets)
+  {
+    for (int i = 0; i < 2000 && transport_->sentPackets_.size() < nPackets; ++i) {
+      ioService_.poll();
+      ioService_.reset();
+      usleep(1000);
+    }
+  }
+
+  /**
+   * Run the handlers of ioService_ until onData has been called nNames times,
+   * or until two seconds have passed.
+   */
+  void
+  pollUntilNames(size_t nNames)
+  {
+    for (int i = 0; i < 2000 && receivedNames_.getNames().size() < nNames; ++i) {
+      ioService_.poll();
+      ioService_.reset();
+      usleep(1000);
+    }
+  }
+
+  boost::asio::io_service ioService_;
+  ptr_lib::shared_ptr<CaptureTransport> transport_;
+  ShardedThreadsafeFace face_;
+  ReceivedNames receivedNames_;
+};
+
+TEST_F(TestShardedThreadsafeFace, ExpressAndCancel)
+{
+  // Names with two components go to the shard threads and the short name is
+  // kept by ioService_.
+  vector<Name> names;
+  for (int i = 0; i < 20; ++i)
+    names.push_back(Name("/test").appendSequenceNumber(i));
+  names.push_back(Name("/short"));
+
+  vector<uint64_t> pendingInterestIds;
+  set<uint64_t> shardIndexes;
+  for (size_t i = 0; i < names.size(); ++i) {
+    pendingInterestIds.push_back(expressInterest(names[i]));
+    shardIndexes.insert
+      (pendingInterestIds.back() % (face_.getShardCount() + 1));
+  }
+  ASSERT_EQ(names.size(),
+            set<uint64_t>(pendingInterestIds.begin(), pendingInterestIds.end()).size())
+    << "Each pendingInterestId should be unique";
+  ASSERT_TRUE(shardIndexes.size() > 2) << "The Interests should use several shards";
+
+  // Cancel every other Interest from this thread, including the short name.
+  // Each shard may not have added the entry yet.
+  for (size_t i = 0; i < names.size(); i += 2)
+    face_.removePendingInterest(pendingInterestIds[i]);
+
+  // The face still sends each Interest. Then reply to all of them.
+  pollUntilSent(names.size());
+  ASSERT_EQ(names.size(), transport_->sentPackets_.size());
+  for (size_t i = 0; i < names.size(); ++i)
+    transport_->receiveData(names[i]);
+
+  size_t nExpected = names.size() / 2;
+  pollUntilNames(nExpected);
+  // Give a shard time to call onData for a removed Interest, which it shouldn't.
+  usleep(50000);
+  ioService_.poll();
+  ioService_.reset();
+
+  vector<Name> receivedNames = receivedNames_.getNames();
+  ASSERT_EQ(nExpected, receivedNames.size());
+  ASSERT_EQ(nExpected, receivedNames_.countCallsOnThread(pthread_self())) <<
+    "onData should be called on the thread which runs the ioService";
+  set<Name> receivedSet(receivedNames.begin(), receivedNames.end());
+  for (size_t i = 1; i < names.size(); i += 2)
+    ASSERT_TRUE(receivedSet.count(names[i]) > 0) <<
+      "Didn't get the Data for " << names[i].toUri();
+
+  face_.shutdown();
+}
+
+TEST_F(TestShardedThreadsafeFace, CallOnShardThreads)
+{
+  ptr_lib::shared_ptr<CaptureTransport> transport(new CaptureTransport());
+  ShardedThreadsafeFace face
+    (ioService_, transport, ptr_lib::make_shared<Transport::ConnectionInfo>(),
+     4, 2, true);
+
+  vector<Name> names;
+  for (int i = 0; i < 20; ++i)
+    names.push_back(Name("/test").appendSequenceNumber(i));
+  for (size_t i = 0; i < names.size(); ++i) {
+    Interest interest(names[i]);
+    interest.setCanBePrefix(false);
+    interest.setInterestLifetimeMilliseconds(10000);
+    face.expressInterest
+      (interest, bind(&ReceivedNames::onData, &receivedNames_, _1, _2),
+       OnTimeout(), OnNetworkNack());
+  }
+
+  for (int i = 0; i < 2000 && transport->sentPackets_.size() < names.size(); ++i) {
+    ioService_.poll();
+    ioService_.reset();
+    usleep(1000);
+  }
+  ASSERT_EQ(names.size(), transport->sentPackets_.size());
+  for (size_t i = 0; i < names.size(); ++i)
+    transport->receiveData(names[i]);
+
+  // Don't run ioService_. The shard threads should call onData.
+  for (int i = 0; i < 2000 && receivedNames_.getNames().size() < names.size(); ++i)
+    usleep(1000);
+
+  ASSERT_EQ(names.size(), receivedNames_.getNames().size());
+  ASSERT_EQ((size_t)0, receivedNames_.countCallsOnThread(pthread_self())) <<
+    "onData should be called on the shard threads";
+
+  face.shutdown();
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ASIO
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <vector>
+#include <pthread.h>
+#include "../../src/impl/submission-queue.hpp"
+
+using namespace std;
+using namespace ndn;
+
+#if NDN_CPP_HAVE_BOOST_ATOMIC
+
+class TestEntry : public SubmissionQueue::Entry {
+public:
+  TestEntry(int producer, int value)
+  : producer_(producer), value_(value)
+  {
+  }
+
+  int producer_;
+  int value_;
+};
+
+class ProducerInfo {
+public:
+  ProducerInfo(SubmissionQueue& queue, int producer, int nEntries)
+  : queue_(queue), producer_(producer), nEntries_(nEntries)
+  {
+  }
+
+  SubmissionQueue& queue_;
+  int producer_;
+  int nEntries_;
+};
+
+static void*
+runProducer(void* infoPointer)
+{
+  ProducerInfo* info = (ProducerInfo*)infoPointer;
+  for (int i = 0; i < info->nEntries_; ++i)
+    info->queue_.push(new TestEntry(info->producer_, i));
+
+  return 0;
+}
+
+class TestSubmissionQueue : public ::testing::Test {
+};
+
+TEST_F(TestSubmissionQueue, Order)
+{
+  SubmissionQueue queue;
+  ASSERT_TRUE(queue.popAll() == 0);
+
+  ASSERT_TRUE(queue.push(new TestEntry(0, 1))) <<
+    "Pushing on an empty queue should return true";
+  ASSERT_FALSE(queue.push(new TestEntry(0, 2))) <<
+    "Pushing on a non-empty queue should return false";
+  ASSERT_FALSE(queue.push(new TestEntry(0, 3)));
+
+  SubmissionQueue::Entry* entry = queue.popAll();
+  for (int expected = 1; expected <= 3; ++expected) {
+    ASSERT_TRUE(entry != 0);
+    ASSERT_EQ(expected, static_cast<TestEntry*>(entry)->value_) <<
+      "popAll should return the entries in the order pushed";
+    SubmissionQueue::Entry* next = entry->getNext();
+    delete entry;
+    entry = next;
+  }
+  ASSERT_TRUE(entry == 0);
+
+  ASSERT_TRUE(queue.popAll() == 0);
+  ASSERT_TRUE(queue.push(new TestEntry(0, 4))) <<
+    "Pushing after popAll should return true";
+  // The queue destructor deletes the remaining entry.
+}
+
+TEST_F(TestSubmissionQueue, MultipleProducers)
+{
+  SubmissionQueue queue;
+  const int nProducers = 8;
+  const int nEntries = 10000;
+
+  vector<ProducerInfo> infos;
+  for (int i = 0; i < nProducers; ++i)
+    infos.push_back(ProducerInfo(queue, i, nEntries));
+  vector<pthread_t> threads(nProducers);
+  for (int i = 0; i < nProducers; ++i)
+    pthread_create(&threads[i], 0, &runProducer, &infos[i]);
+
+  // Consume while the producers are pushing.
+  vector<int> nextValue(nProducers, 0);
+  int nReceived = 0;
+  while (nReceived < nProducers * nEntries) {
+    SubmissionQueue::Entry* entry = queue.popAll();
+    while (entry) {
+      TestEntry* testEntry = static_cast<TestEntry*>(entry);
+      ASSERT_EQ(nextValue[testEntry->producer_], testEntry->value_) <<
+        "The entries from one producer should be in order";
+      ++nextValue[testEntry->producer_];
+      ++nReceived;
+
+      entry = entry->getNext();
+      delete testEntry;
+    }
+  }
+
+  for (int i = 0; i < nProducers; ++i)
+    pthread_join(threads[i], 0);
+  ASSERT_TRUE(queue.popAll() == 0);
+}
+
+#endif // NDN_CPP_HAVE_BOOST_ATOMIC
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
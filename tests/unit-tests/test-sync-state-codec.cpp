@@ -0,0 +1,201 @@
+/**
+ * Copyright (C) 2020 Regents of the University of California.
+ * @author: Jeff Thompson <jefft0@remap.ucla.edu>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version, with the additional exemption that
+ * compiling, linking, and/or using OpenSSL is allowed.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * A copy of the GNU Lesser General Public License is in the file COPYING.
+ */
+
+#include "gtest/gtest.h"
+#include <ndn-cpp/ndn-cpp-config.h>
+#include "../../src/sync/sync-state-codec.hpp"
+#if NDN_CPP_HAVE_PROTOBUF
+#include "../../src/sync/sync-state.pb.h"
+#endif
+
+using namespace std;
+using namespace ndn;
+
+static bool
+syncStatesEqual
+  (const vector<ChronoSync2013::SyncState>& syncStates1,
+   const vector<ChronoSync2013::SyncState>& syncStates2)
+{
+  if (syncStates1.size() != syncStates2.size())
+    return false;
+
+  for (size_t i = 0; i < syncStates1.size(); ++i) {
+    if (syncStates1[i].getDataPrefix() != syncStates2[i].getDataPrefix() ||
+        syncStates1[i].getSessionNo() != syncStates2[i].getSessionNo() ||
+        syncStates1[i].getSequenceNo() != syncStates2[i].getSequenceNo() ||
+        syncStates1[i].getApplicationInfo().isNull() !=
+          syncStates2[i].getApplicationInfo().isNull() ||
+        !syncStates1[i].getApplicationInfo().equals
+          (syncStates2[i].getApplicationInfo()))
+      return false;
+  }
+
+  return true;
+}
+
+class TestSyncStateCodec : public ::testing::Test {
+public:
+  TestSyncStateCodec()
+  {
+    const uint8_t applicationInfo[] = { 0x01, 0x02 };
+
+    syncStates_.push_back(ChronoSync2013::SyncState("/a", 5, 3, Blob()));
+    syncStates_.push_back(ChronoSync2013::SyncState
+      ("/ndn/user/b", 1593640000, 200,
+       Blob(applicationInfo, sizeof(applicationInfo))));
+  }
+
+  vector<ChronoSync2013::SyncState> syncStates_;
+};
+
+TEST_F(TestSyncStateCodec, EncodeProtobuf)
+{
+  vector<ChronoSync2013::SyncState> syncStates(syncStates_.begin(), syncStates_.begin() + 1);
+  uint8_t expectedEncoding[] = {
+    0x0A, 0x0C, // ss
+      0x0A, 0x02, 0x2F, 0x61, // name = "/a"
+      0x10, 0x00, // type = UPDATE
+      0x1A, 0x04, // seqno
+        0x08, 0x03, // seq = 3
+        0x10, 0x05  // session = 5
+  };
+  ASSERT_TRUE(SyncStateCodec::encodeProtobuf(syncStates).equals
+              (Blob(expectedEncoding, sizeof(expectedEncoding))));
+
+  vector<ChronoSync2013::SyncState> decoded;
+  SyncStateCodec::decode(expectedEncoding, sizeof(expectedEncoding), decoded);
+  ASSERT_TRUE(syncStatesEqual(syncStates, decoded));
+}
+
+TEST_F(TestSyncStateCodec, EncodeTlv)
+{
+  vector<ChronoSync2013::SyncState> syncStates(syncStates_.begin(), syncStates_.begin() + 1);
+  uint8_t expectedEncoding[] = {
+    0x81, 0x0C, // SyncStateMessage
+      0x82, 0x0A, // SyncState
+        0x83, 0x02, 0x2F, 0x61, // DataPrefix = "/a"
+        0x84, 0x01, 0x05, // SessionNo = 5
+        0x85, 0x01, 0x03  // SequenceNo = 3
+  };
+  Blob encoding = SyncStateCodec::encodeTlv(syncStates);
+  ASSERT_TRUE(encoding.equals
+              (Blob(expectedEncoding, sizeof(expectedEncoding))));
+  ASSERT_TRUE(SyncStateCodec::isTlv(encoding.buf(), encoding.size()));
+
+  vector<ChronoSync2013::SyncState> decoded;
+  SyncStateCodec::decode(encoding.buf(), encoding.size(), decoded);
+  ASSERT_TRUE(syncStatesEqual(syncStates, decoded));
+}
+
+TEST_F(TestSyncStateCodec, RoundTrip)
+{
+  Blob protobufEncoding = SyncStateCodec::encodeProtobuf(syncStates_);
+  Blob tlvEncoding = SyncStateCodec::encodeTlv(syncStates_);
+  ASSERT_FALSE(SyncStateCodec::isTlv
+               (protobufEncoding.buf(), protobufEncoding.size()));
+  ASSERT_TRUE(tlvEncoding.size() < protobufEncoding.size()) <<
+    "The TLV encoding should be more compact";
+
+  vector<ChronoSync2013::SyncState> decoded;
+  SyncStateCodec::decode
+    (protobufEncoding.buf(), protobufEncoding.size(), decoded);
+  ASSERT_TRUE(syncStatesEqual(syncStates_, decoded));
+
+  decoded.clear();
+  SyncStateCodec::decode(tlvEncoding.buf(), tlvEncoding.size(), decoded);
+  ASSERT_TRUE(syncStatesEqual(syncStates_, decoded));
+
+  decoded.clear();
+  SyncStateCodec::decode(0, 0, decoded);
+  ASSERT_EQ(0, decoded.size());
+}
+
+TEST_F(TestSyncStateCodec, SkipProtobufFields)
+{
+  uint8_t encoding[] = {
+    0x0A, 0x0C, // ss
+      0x10, 0x01, // type = DELETE
+      0x0A, 0x02, 0x2F, 0x61, // name = "/a"
+      0x1A, 0x04, // seqno
+        0x08, 0x03, // seq = 3
+        0x10, 0x05, // session = 5
+    0x0A, 0x11, // ss
+      0x28, 0x07, // unknown varint field 5
+      0x0A, 0x02, 0x2F, 0x62, // name = "/b"
+      0x1A, 0x09, // seqno
+        0x10, 0x06, // session = 6
+        0x1D, 0x00, 0x00, 0x00, 0x00, // unknown fixed32 field 3
+        0x08, 0x04  // seq = 4
+  };
+
+  vector<ChronoSync2013::SyncState> decoded;
+  SyncStateCodec::decode(encoding, sizeof(encoding), decoded);
+  ASSERT_EQ(1, decoded.size()) << "decode should skip a non-UPDATE SyncState";
+  ASSERT_EQ("/b", decoded[0].getDataPrefix());
+  ASSERT_EQ(6, decoded[0].getSessionNo());
+  ASSERT_EQ(4, decoded[0].getSequenceNo());
+  ASSERT_TRUE(decoded[0].getApplicationInfo().isNull());
+
+  // Truncate the second SyncState.
+  decoded.clear();
+  ASSERT_THROW(SyncStateCodec::decode(encoding, sizeof(encoding) - 1, decoded),
+               runtime_error);
+}
+
+#if NDN_CPP_HAVE_PROTOBUF
+
+TEST_F(TestSyncStateCodec, ProtobufLibraryCompatibility)
+{
+  Sync::SyncStateMsg syncMessage;
+  for (size_t i = 0; i < syncStates_.size(); ++i) {
+    Sync::SyncState* content = syncMessage.add_ss();
+    content->set_name(syncStates_[i].getDataPrefix());
+    content->set_type(Sync::SyncState_ActionType_UPDATE);
+    content->mutable_seqno()->set_seq(syncStates_[i].getSequenceNo());
+    content->mutable_seqno()->set_session(syncStates_[i].getSessionNo());
+    const Blob& applicationInfo = syncStates_[i].getApplicationInfo();
+    if (!applicationInfo.isNull())
+      content->set_application_info
+        (applicationInfo.buf(), applicationInfo.size());
+  }
+  string expectedEncoding;
+  syncMessage.SerializeToString(&expectedEncoding);
+
+  ASSERT_TRUE(SyncStateCodec::encodeProtobuf(syncStates_).equals
+              (Blob((const uint8_t*)expectedEncoding.data(),
+                    expectedEncoding.size())));
+
+  Sync::SyncStateMsg decodedMessage;
+  Blob encoding = SyncStateCodec::encodeProtobuf(syncStates_);
+  ASSERT_TRUE(decodedMessage.ParseFromArray(encoding.buf(), encoding.size()));
+  ASSERT_EQ(syncStates_.size(), decodedMessage.ss_size());
+  ASSERT_EQ(syncStates_[1].getDataPrefix(), decodedMessage.ss(1).name());
+  ASSERT_EQ(syncStates_[1].getSessionNo(), decodedMessage.ss(1).seqno().session());
+  ASSERT_EQ(syncStates_[1].getSequenceNo(), decodedMessage.ss(1).seqno().seq());
+}
+
+#endif // NDN_CPP_HAVE_PROTOBUF
+
+int
+main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}